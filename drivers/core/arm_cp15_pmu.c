@@ -60,12 +60,13 @@ static void cp15_pmu_control(uint8_t ResetCounterType, uint8_t EnableCounter)
  * \brief Select Cycle Count divider
  * \param Divider  0 for increment of counter at every single cycle or 1 for at every 64th cycle
  */
-static void cp15_cycle_count_divider(uint8_t Divider)
+void cp15_cycle_count_divider(uint8_t Divider)
 {
 	uint32_t PMU_Value = 0;
 	assert((Divider > 1 ? 0 : 1));
 	asm("mrc     p15, 0, %0, c9, c12, 0":"=r"(PMU_Value));
-	PMU_Value |= (Divider << 3);
+	PMU_Value &= ~(1u << CP15_PMCR_DIVIDER);
+	PMU_Value |= (Divider << CP15_PMCR_DIVIDER);
 	asm("mcr     p15, 0, %0, c9, c12, 0": :"r"(PMU_Value));
 }
 
@@ -149,8 +150,9 @@ void cp15_soft_incr(uint8_t IncrCounter)
 static void cp15_select_event(PerfEventType EventType, uint8_t Counter)
 {
 	uint32_t CounterSelect = 0;
-	assert((Counter == 1) || (Counter == 2));
-	CounterSelect = (Counter & 0x1F);
+	assert((Counter == CP15_Counter0) || (Counter == CP15_Counter1));
+	/* PMSELR takes the index of the counter, not its enable bit */
+	CounterSelect = (Counter >> 1);
 	asm("mcr     p15, 0, %0, c9, c12, 5": :"r"(CounterSelect));
 	CounterSelect = (EventType & 0xFF);
 	asm("mcr     p15, 0, %0, c9, c13, 1": :"r"(CounterSelect));
@@ -230,7 +232,9 @@ void cp15_init_perf_counter(PerfEventType Event, uint8_t Counter)
 uint32_t cp15_count_evt(uint8_t Counter)
 {
 	uint32_t value;
-	asm("mcr     p15, 0, %0, c9, c12, 5": :"r"(Counter));
+	uint32_t CounterSelect = (Counter >> 1);
+	assert((Counter == CP15_Counter0) || (Counter == CP15_Counter1));
+	asm("mcr     p15, 0, %0, c9, c12, 5": :"r"(CounterSelect));
 	asm("mrc     p15, 0, %0, c9, c13, 2":"=r"(value));
 	// PMXEVTYPER
 	return (value);
@@ -53,37 +53,38 @@
 #define CP15_Counter1           2
 #define CP15_BothCounter        3
 
+/** Event numbers of the Cortex-A5 PMU (PMXEVTYPER.evtCount) */
 typedef enum {
-	L1_IC_FILL,		// Level 1 instruction cache refill
-	L1_ITLB_FILL,		// Level 1 instruction TLB refill
-	L1_DC_FILL,		// Level 1 data cache refill
-	L1_DC_ACC,		// Level 1 data cache access
-	L1_DTLB_FILL,		// Level 1 data TLB refill
-	LOAD,			// Load
-	STORE,			// Store
-	InstArchExec,		// Instruction architecturally executed
-	ExcepetionTaken,	// Exception taken
-	ExcepetionRet,		// Exception return
-	WrCONTEXTIDR,		// Write to CONTEXTIDR
-	SoftPCChange,		// Software change of the PC
-	ImmBr,			// Immediate branch
-	ProcRet,		// Procedure return
-	UnalingedLdStr,		// Unaligned load or store
-	MispredictedBranchExec,	// Mispredicted or not predicted branch speculatively executed
-	PredictedBranchExec,	// Predictable branch speculatively executed
-	DataMemAcc,		// Data memory access.
-	ICAcc,			// Instruction Cache access.
-	DCEviction,		// Data cache eviction.
-	IRQException,		// IRQ exception taken.
-	FIQException,		// FIQ exception taken.
-	ExtMemReq,		// External memory request.
-	NCExtMemReq,		// Non-cacheable external memory request
-	PrefetchLineFill,	// Linefill because of prefetch.
-	PrefetchLineDrop,	// Prefetch linefill dropped.
-	EnteringRAmode,		// Entering read allocate mode.
-	RAmode,			// Read allocate mode.
-	reserved,		// Reserved, do not use
-	DWstallSBFfull		// Data Write operation that stalls the pipeline because the store buffer is full.
+	L1_IC_FILL = 0x01,		// Level 1 instruction cache refill
+	L1_ITLB_FILL = 0x02,		// Level 1 instruction TLB refill
+	L1_DC_FILL = 0x03,		// Level 1 data cache refill
+	L1_DC_ACC = 0x04,		// Level 1 data cache access
+	L1_DTLB_FILL = 0x05,		// Level 1 data TLB refill
+	LOAD = 0x06,			// Load
+	STORE = 0x07,			// Store
+	InstArchExec = 0x08,		// Instruction architecturally executed
+	ExcepetionTaken = 0x09,		// Exception taken
+	ExcepetionRet = 0x0A,		// Exception return
+	WrCONTEXTIDR = 0x0B,		// Write to CONTEXTIDR
+	SoftPCChange = 0x0C,		// Software change of the PC
+	ImmBr = 0x0D,			// Immediate branch
+	ProcRet = 0x0E,			// Procedure return
+	UnalingedLdStr = 0x0F,		// Unaligned load or store
+	MispredictedBranchExec = 0x10,	// Mispredicted or not predicted branch speculatively executed
+	PredictedBranchExec = 0x12,	// Predictable branch speculatively executed
+	DataMemAcc = 0x13,		// Data memory access.
+	ICAcc = 0x14,			// Instruction Cache access.
+	DCEviction = 0x15,		// Data cache eviction.
+	IRQException = 0x86,		// IRQ exception taken.
+	FIQException = 0x87,		// FIQ exception taken.
+	ExtMemReq = 0xC0,		// External memory request.
+	NCExtMemReq = 0xC1,		// Non-cacheable external memory request
+	PrefetchLineFill = 0xC2,	// Linefill because of prefetch.
+	PrefetchLineDrop = 0xC3,	// Prefetch linefill dropped.
+	EnteringRAmode = 0xC4,		// Entering read allocate mode.
+	RAmode = 0xC5,			// Read allocate mode.
+	reserved = 0xC6,		// Reserved, do not use
+	DWstallSBFfull = 0xC9		// Data Write operation that stalls the pipeline because the store buffer is full.
 } PerfEventType;
 
 /*----------------------------------------------------------------------------
@@ -92,6 +93,7 @@ typedef enum {
 
 extern uint32_t cp15_init_cycle_counter(void);
 extern uint32_t cp15_get_cycle_counter(void);
+extern void cp15_cycle_count_divider(uint8_t Divider);
 
 extern uint32_t cp15_read_overflow_status(uint8_t EventCounter);
 extern void cp15_overflow_status(uint8_t Enable, uint8_t ClearCounterFlag);
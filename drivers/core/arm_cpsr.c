@@ -40,6 +40,13 @@
  *        Global functions
  *----------------------------------------------------------------------------*/
 
+uint32_t cpsr_get(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	return cpsr;
+}
+
 void cpsr_clear_bits(uint32_t mask)
 {
 	uint32_t cpsr;
@@ -36,6 +36,8 @@
 #define CPSR_MASK_IRQ 0x00000080
 #define CPSR_MASK_FIQ 0x00000040
 
+extern uint32_t cpsr_get(void);
+
 extern void cpsr_clear_bits(uint32_t mask);
 
 extern void cpsr_set_bits(uint32_t mask);
@@ -36,6 +36,7 @@
 #include "compiler.h"
 #include "intmath.h"
 #include "memories/at25.h"
+#include "memories/sfdp.h"
 #include "peripherals/aic.h"
 #include "peripherals/pio.h"
 #include "peripherals/pmc.h"
@@ -292,6 +293,39 @@ static uint32_t _at25_read_jedec_id(struct _at25* at25)
 	return (_jedec_id[2] << 16) | (_jedec_id[1] << 8) | _jedec_id[0];
 }
 
+static bool _at25_read_sfdp(void* arg, uint32_t addr, void* data,
+			    uint32_t length)
+{
+	struct _at25* at25 = (struct _at25*)arg;
+	assert(at25);
+	uint8_t cmd[5];
+	struct _buffer buf[2] = {
+		{
+			.data = cmd,
+			.size = sizeof(cmd),
+			.attr = SPID_BUF_ATTR_WRITE,
+		},
+		{
+			.data = data,
+			.size = length,
+			.attr = SPID_BUF_ATTR_READ | SPID_BUF_ATTR_RELEASE_CS,
+		},
+	};
+
+	/* Always 3-byte address followed by one dummy byte */
+	cmd[0] = SFDP_CMD_READ;
+	cmd[1] = (addr & 0x00FF0000) >> 16;
+	cmd[2] = (addr & 0x0000FF00) >> 8;
+	cmd[3] = (addr & 0x000000FF);
+	cmd[4] = 0;
+
+	if (spi_bus_transfer(at25->dev.bus, at25->dev.chip_select, buf, 2, NULL, NULL))
+		return false;
+	spi_bus_wait_transfer(at25->dev.bus);
+
+	return true;
+}
+
 /*----------------------------------------------------------------------------
  *        Public Functions
  *----------------------------------------------------------------------------*/
@@ -330,8 +364,16 @@ uint32_t at25_configure(struct _at25* at25)
 	trace_debug("at25: read JEDEC ID 0x%08x.\r\n", (unsigned)jedec_id);
 	at25->desc = spi_nor_find(jedec_id);
 	if (!at25->desc) {
-		spi_bus_stop_transaction(at25->dev.bus);
-		return AT25_DEVICE_NOT_SUPPORTED;
+		/* Unknown device, try to describe it from its SFDP tables */
+		struct _sfdp sfdp;
+		if (!sfdp_parse(&sfdp, _at25_read_sfdp, at25)) {
+			spi_bus_stop_transaction(at25->dev.bus);
+			return AT25_DEVICE_NOT_SUPPORTED;
+		}
+		trace_debug("at25: using SFDP parameters (JESD216 rev %u.%u).\r\n",
+			    sfdp.major, sfdp.minor);
+		sfdp_get_spi_nor_desc(&sfdp, jedec_id, &at25->sfdp_desc);
+		at25->desc = &at25->sfdp_desc;
 	}
 
 	_at25_set_addressing(at25);
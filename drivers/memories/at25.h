@@ -104,6 +104,9 @@ struct _at25 {
 
 	const struct _spi_nor_desc* desc;
 	uint32_t addressing;
+
+	/** Descriptor built from the SFDP tables of unknown devices */
+	struct _spi_nor_desc sfdp_desc;
 };
 
 #ifdef __cplusplus
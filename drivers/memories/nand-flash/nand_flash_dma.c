@@ -53,6 +53,12 @@ static struct dma_channel *nand_dma_tx_channel;
 /** DMA transfer completion notifier */
 static volatile bool transfer_complete = false;
 
+/** Destination of the pending RX transfer, invalidated on completion */
+static uint32_t rx_dest_address;
+
+/** Size of the pending RX transfer */
+static uint32_t rx_size;
+
 /*-------------------------------------------------------------------------
  *        Local functions
  *------------------------------------------------------------------------*/
@@ -129,14 +135,16 @@ uint8_t nand_dma_write(uint32_t src_address, uint32_t dest_address,
 }
 
 /**
- * \brief Configure the DMA Channels for RX.
+ * \brief Configure the DMA Channels for RX and start the transfer, without
+ * waiting for its completion. nand_dma_wait_read() must be called before the
+ * destination buffer is accessed.
  * \param src_address Source address to be transferred.
  * \param dest_address Destination address to be transferred.
  * \param size Transfer size in byte.
- * \returns 0 if the DMA channel configuration and transfer successfully;
- * otherwise returns NandCommon_ERROR_XXX.
+ * \returns 0 if the DMA channel configuration successfully; otherwise returns
+ * NandCommon_ERROR_XXX.
  */
-uint8_t nand_dma_read(uint32_t src_address, uint32_t dest_address,
+uint8_t nand_dma_start_read(uint32_t src_address, uint32_t dest_address,
 		uint32_t size)
 {
 	struct dma_xfer_cfg cfg;
@@ -151,19 +159,52 @@ uint8_t nand_dma_read(uint32_t src_address, uint32_t dest_address,
 	cfg.len = size;
 	dma_configure_transfer(nand_dma_rx_channel, &cfg);
 
+	rx_dest_address = dest_address;
+	rx_size = size;
+
 	/* Start transfer */
 	transfer_complete = false;
 	dma_start_transfer(nand_dma_rx_channel);
+	return 0;
+}
+
+/**
+ * \brief Wait for the completion of a transfer started by
+ * nand_dma_start_read(), and invalidate the destination buffer.
+ * \returns 0 if the transfer is complete; otherwise returns
+ * NandCommon_ERROR_XXX.
+ */
+uint8_t nand_dma_wait_read(void)
+{
 	/* Wait for completion */
 	while (!transfer_complete) {
 		/* always call dma_poll, it will do nothing if polling mode
 		 * is disabled */
 		dma_poll();
 	}
-	cache_invalidate_region((uint32_t *)dest_address, size);
+	cache_invalidate_region((uint32_t *)rx_dest_address, rx_size);
 	return 0;
 }
 
+/**
+ * \brief Configure the DMA Channels for RX.
+ * \param src_address Source address to be transferred.
+ * \param dest_address Destination address to be transferred.
+ * \param size Transfer size in byte.
+ * \returns 0 if the DMA channel configuration and transfer successfully;
+ * otherwise returns NandCommon_ERROR_XXX.
+ */
+uint8_t nand_dma_read(uint32_t src_address, uint32_t dest_address,
+		uint32_t size)
+{
+	uint8_t error;
+
+	error = nand_dma_start_read(src_address, dest_address, size);
+	if (error)
+		return error;
+	return nand_dma_wait_read();
+}
+
 /**
  * \brief Free the NAND DMA RX and TX channel.
  */
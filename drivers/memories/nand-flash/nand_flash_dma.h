@@ -48,6 +48,11 @@ extern uint8_t nand_dma_write(uint32_t src_address,
 extern uint8_t nand_dma_read(uint32_t src_address,
 		uint32_t dest_address, uint32_t size);
 
+extern uint8_t nand_dma_start_read(uint32_t src_address,
+		uint32_t dest_address, uint32_t size);
+
+extern uint8_t nand_dma_wait_read(void);
+
 extern void nand_dma_free(void);
 
 #endif /* NAND_FLASH_DMA_H */
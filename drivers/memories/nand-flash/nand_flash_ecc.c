@@ -57,6 +57,24 @@
 
 CACHE_ALIGNED static uint8_t spare_buf[NAND_MAX_PAGE_SPARE_SIZE];
 
+/** PMECC results of the last page transferred by nand_ecc_read_pages() */
+static struct {
+	/** Block of the pages being read, for traces */
+	uint16_t block;
+
+	/** First page being read, for traces */
+	uint16_t page;
+
+	/** PMECC error status, one bit per sector */
+	uint32_t status;
+
+	/** Remainders of the sectors in error */
+	int16_t remainders[PMECC_MAX_SECTORS][PMECC_BCH_MAX_ERRORS];
+} pmecc_latch;
+
+/** BCH decoder context used by nand_ecc_read_pages() */
+static struct _pmecc_bch pmecc_bch;
+
 /*---------------------------------------------------------------------- */
 /*         Local functions                                               */
 /*---------------------------------------------------------------------- */
@@ -163,6 +181,105 @@ static uint8_t ecc_read_page_with_pmecc(const struct _nand_flash *nand,
 	return 0;
 }
 
+/**
+ * \brief nand_raw_read_pages() hook, latches the PMECC status and the
+ * remainders of the sectors in error before the PMECC is reset for the next
+ * page.
+ * \param nand  Pointer to an EccNandFlash instance.
+ * \param index  Index of the page in the pages being read.
+ * \param data  Page data, followed by the ECC bytes.
+ * \param arg  Unused.
+ * \return 0.
+ */
+static uint8_t ecc_latch_pmecc(const struct _nand_flash *nand,
+		uint16_t index, uint8_t *data, void *arg)
+{
+	uint16_t page_data_size = nand_model_get_page_data_size(&nand->model);
+	uint32_t ecc_end = pmecc_get_ecc_end_address();
+	uint32_t sector, status;
+	uint32_t i;
+
+	status = pmecc_error_status();
+	if (status) {
+		/* Check if the page was erased, the spare area is read up to
+		 * the end of the ECC bytes */
+		for (i = 0; i < ecc_end; i++) {
+			if (data[page_data_size + i] != 0xff)
+				break;
+		}
+		if (i == ecc_end)
+			status = 0;
+	}
+
+	pmecc_latch.status = status;
+	for (sector = 0; status; sector++, status >>= 1) {
+		if (status & 1)
+			pmecc_get_remainders(sector,
+					pmecc_latch.remainders[sector]);
+	}
+	return 0;
+}
+
+/**
+ * \brief nand_raw_read_pages() hook, corrects a page from the results latched
+ * by ecc_latch_pmecc(). Runs while the next page is transferred.
+ * \param nand  Pointer to an EccNandFlash instance.
+ * \param index  Index of the page in the pages being read.
+ * \param data  Page data.
+ * \param arg  Unused.
+ * \return 0 if the page is valid, NAND_ERROR_CORRUPTEDDATA otherwise.
+ */
+static uint8_t ecc_correct_pmecc(const struct _nand_flash *nand,
+		uint16_t index, uint8_t *data, void *arg)
+{
+	uint32_t sector_size = pmecc_get_sector_size();
+	uint32_t status = pmecc_latch.status;
+	uint32_t sector;
+
+	for (sector = 0; status; sector++, status >>= 1) {
+		if (!(status & 1))
+			continue;
+		pmecc_init_bch(&pmecc_bch);
+		pmecc_bch_set_remainders(&pmecc_bch,
+				pmecc_latch.remainders[sector]);
+		if (pmecc_bch_decode(&pmecc_bch, data + sector * sector_size,
+					sector_size) < 0) {
+			trace_error("ecc_correct_pmecc: at B%d.P%d Unrecoverable data\r\n",
+					pmecc_latch.block, pmecc_latch.page + index);
+			return NAND_ERROR_CORRUPTEDDATA;
+		}
+	}
+	return 0;
+}
+
+/**
+ * \brief Reads and verifies consecutive pages with the PMECC. The sectors in
+ * error are corrected in software while the next page is transferred.
+ * \param nand  Pointer to an EccNandFlash instance.
+ * \param block  Number of block to read from.
+ * \param page  Number of the first page to read inside given block.
+ * \param count  Number of pages to read.
+ * \param data  Data area buffer.
+ * \return 0 if the data has been read and is valid; otherwise returns either
+ * NAND_ERROR_CORRUPTEDDATA or ...
+ */
+static uint8_t ecc_read_pages_with_pmecc(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data)
+{
+	const struct _nand_raw_read_hooks hooks = {
+		.transferred = ecc_latch_pmecc,
+		.process = ecc_correct_pmecc,
+		.arg = NULL,
+	};
+	uint8_t error;
+
+	pmecc_latch.block = block;
+	pmecc_latch.page = page;
+	error = nand_raw_read_pages(nand, block, page, count, data, &hooks);
+	pmecc_disable();
+	return error;
+}
+
 /**
  * \brief Writes the data and/or spare area of a NANDFLASH page, after calculating an
  * ECC for the data area and storing it in the spare. If no data buffer is
@@ -272,6 +389,44 @@ uint8_t nand_ecc_read_page(const struct _nand_flash *nand,
 	return NAND_ERROR_ECC_NOT_COMPATIBLE;
 }
 
+/**
+ * \brief Reads the data area of consecutive pages of a block, and verify that
+ * the data is valid. With the PMECC, the correction of a page overlaps with
+ * the transfer of the next one. The buffer must be large enough for \a count
+ * pages plus one spare area.
+ * \param nand  Pointer to an EccNandFlash instance.
+ * \param block  Number of block to read from.
+ * \param page  Number of the first page to read inside given block.
+ * \param count  Number of pages to read.
+ * \param data  Data area buffer.
+ * \return 0 if the data has been read and is valid; otherwise returns either
+ * NAND_ERROR_CORRUPTEDDATA or ...
+ */
+uint8_t nand_ecc_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data)
+{
+	uint16_t page_data_size = nand_model_get_page_data_size(&nand->model);
+	uint8_t error;
+	uint16_t i;
+
+	NAND_TRACE("nand_ecc_read_pages(B#%d:P#%d, %d)\r\n", block, page, count);
+	assert(data);
+
+	if (nand_is_using_pmecc())
+		return ecc_read_pages_with_pmecc(nand, block, page, count, data);
+
+	if (nand_is_using_no_ecc())
+		return nand_raw_read_pages(nand, block, page, count, data, NULL);
+
+	for (i = 0; i < count; i++) {
+		error = nand_ecc_read_page(nand, block, page + i,
+				(uint8_t*)data + i * page_data_size, NULL);
+		if (error)
+			return error;
+	}
+	return 0;
+}
+
 /**
  * \brief Writes the data and/or spare area of a NANDFLASH page, after calculating an
  * ECC for the data area and storing it in the spare. If no data buffer is
@@ -42,6 +42,27 @@
 #include <string.h>
 #include <assert.h>
 
+/*-----------------------------------------------------------------------*/
+/*                 Local functions                                       */
+/*-----------------------------------------------------------------------*/
+
+/**
+ * \brief Returns the base 2 logarithm of a power of two.
+ * \param value  Value to convert.
+ * \param shift  Stores the logarithm.
+ * \return true if value is a power of two, false otherwise.
+ */
+static bool _log2(uint32_t value, uint8_t *shift)
+{
+	uint8_t i;
+
+	if (value == 0 || (value & (value - 1)))
+		return false;
+	for (i = 0; (1u << i) != value; i++);
+	*shift = i;
+	return true;
+}
+
 /*-----------------------------------------------------------------------*/
 /*                 Exported functions                                    */
 /*-----------------------------------------------------------------------*/
@@ -49,7 +70,8 @@
 /**
  * \brief Looks for a _nand_flash_model corresponding to the given ID inside a list of
  * model. If found, the model variable is filled with the correct values.
- * \param model_list  List of _nand_flash_model instances.
+ * \param model_list  List of _nand_flash_model instances, sorted by device ID.
+ * When several models share a device ID, the first one is used.
  * \param size  Number of models in list.
  * \param chip_id  Identifier returned by the NANDFLASH(id1|(id2<<8)|(id3<<16)|(id4<<24)).
  * \param model  _nand_flash_model instance to update with the model parameters.
@@ -59,85 +81,94 @@
 uint8_t nand_model_find(const struct _nand_flash_model *list, uint32_t list_size,
 	uint32_t chip_id, struct _nand_flash_model *model)
 {
-	bool found = false;
+	uint32_t low = 0, high = list_size;
 	uint8_t id2, id4;
-	int i;
 
 	id2 = (chip_id >> 8) & 0xff;
 	id4 = (chip_id >> 24) & 0xff;
 
 	trace_info_wp("Nandflash ID is 0x%08X\r\n", (unsigned int)chip_id);
 
-	for (i = 0; i < list_size; i++) {
-		if (list[i].device_id == id2) {
-			found = true;
-			if (model) {
-				memcpy(model, &list[i], sizeof(*model));
-				if (model->block_size_in_kbytes == 0 ||
-					model->page_size_in_bytes == 0) {
-					NAND_TRACE("Fetch from ID4(0x%.2x):\r\n", id4);
-
-					/*
-					 * Fetch from the extended ID4
-					 * ID4 D5  D4 BlockSize || D1  D0  PageSize
-					 *     0   0   64K      || 0   0   1K
-					 *     0   1   128K     || 0   1   2K
-					 *     1   0   256K     || 1   0   4K
-					 *     1   1   512K     || 1   1   8k
-					 */
-
-					switch(id4 & 0x03) {
-					case 0x00:
-						model->page_size_in_bytes = 1024;
-						break;
-					case 0x01:
-						model->page_size_in_bytes = 2048;
-						break;
-					case 0x02:
-						model->page_size_in_bytes = 4096;
-						break;
-					case 0x03:
-						model->page_size_in_bytes = 8192;
-						break;
-					}
-
-					switch(id4 & 0x30) {
-					case 0x00:
-						model->block_size_in_kbytes = 64;
-						break;
-					case 0x10:
-						model->block_size_in_kbytes = 128;
-						break;
-					case 0x20:
-						model->block_size_in_kbytes = 256;
-						break;
-					case 0x30:
-						model->block_size_in_kbytes = 512;
-						break;
-					}
-				}
-			}
-
-			NAND_TRACE("NAND Model found:\r\n");
-			NAND_TRACE(" * deviceId = 0x%02X\r\n",
-					model->device_id);
-			NAND_TRACE(" * deviceSizeInMegaBytes = %d\r\n",
-					model->device_size_in_mega_bytes);
-			NAND_TRACE(" * blockSizeInkBytes = %d\r\n",
-					model->block_size_in_kbytes);
-			NAND_TRACE(" * pageSizeInBytes = %d\r\n",
-					model->page_size_in_bytes);
-			NAND_TRACE(" * options = 0x%02X\r\n",
-					model->options);
-			break;
-		}
+	/* Find the first model with the device ID */
+	while (low < high) {
+		uint32_t mid = (low + high) / 2;
+		if (list[mid].device_id < id2)
+			low = mid + 1;
+		else
+			high = mid;
 	}
+	if (low == list_size || list[low].device_id != id2)
+		return NAND_ERROR_UNKNOWNMODEL;
 
-	// check if chip has been detected
-	if (found)
+	if (!model)
 		return 0;
-	else
+
+	memcpy(model, &list[low], sizeof(*model));
+	if (model->block_size_in_kbytes == 0 ||
+		model->page_size_in_bytes == 0) {
+		NAND_TRACE("Fetch from ID4(0x%.2x):\r\n", id4);
+
+		/*
+		 * Fetch from the extended ID4
+		 * ID4 D5  D4 BlockSize || D1  D0  PageSize
+		 *     0   0   64K      || 0   0   1K
+		 *     0   1   128K     || 0   1   2K
+		 *     1   0   256K     || 1   0   4K
+		 *     1   1   512K     || 1   1   8k
+		 */
+		model->page_size_in_bytes = 1024 << (id4 & 0x03);
+		model->block_size_in_kbytes = 64 << ((id4 & 0x30) >> 4);
+	}
+
+	NAND_TRACE("NAND Model found:\r\n");
+	NAND_TRACE(" * deviceId = 0x%02X\r\n",
+			model->device_id);
+	NAND_TRACE(" * deviceSizeInMegaBytes = %d\r\n",
+			model->device_size_in_mega_bytes);
+	NAND_TRACE(" * blockSizeInkBytes = %d\r\n",
+			model->block_size_in_kbytes);
+	NAND_TRACE(" * pageSizeInBytes = %d\r\n",
+			model->page_size_in_bytes);
+	NAND_TRACE(" * options = 0x%02X\r\n",
+			model->options);
+
+	return nand_model_compute_geometry(model);
+}
+
+/**
+ * \brief Computes the geometry of a model from its page, block and device
+ * sizes. It must be called whenever these fields are modified, the
+ * accessors only relying on the geometry.
+ * \param model  Pointer to a _nand_flash_model instance.
+ * \return 0 if successful; otherwise returns NAND_ERROR_UNKNOWNMODEL if the
+ * page or block size is not a power of two.
+ */
+uint8_t nand_model_compute_geometry(struct _nand_flash_model *model)
+{
+	uint32_t block_size = model->block_size_in_kbytes * 1024;
+	uint32_t max_column, max_row;
+
+	if (!_log2(model->page_size_in_bytes, &model->page_shift) ||
+	    !_log2(block_size, &model->block_shift) ||
+	    model->block_shift < model->page_shift) {
+		trace_error("nand: unsupported page or block size\r\n");
 		return NAND_ERROR_UNKNOWNMODEL;
+	}
+
+	model->block_count = (1024 * model->device_size_in_mega_bytes)
+		/ model->block_size_in_kbytes;
+
+	/* Number of address cycles, one column cycle for small block devices
+	 * and two for large block devices */
+	max_column = model->page_size_in_bytes +
+		nand_model_get_page_spare_size(model) - 1;
+	for (model->col_cycles = 0; max_column > 2; max_column >>= 8)
+		model->col_cycles++;
+	max_row = nand_model_get_device_size_in_pages(model) - 1;
+	for (model->row_cycles = 0; max_row > 0; max_row >>= 8)
+		model->row_cycles++;
+
+	return 0;
 }
 
 /**
@@ -157,30 +188,22 @@ uint8_t nand_model_translate_access(const struct _nand_flash_model *model,
 	uint32_t address, uint32_t size,
 	uint16_t *block, uint16_t *page, uint16_t *offset)
 {
-	/* Get Nand info */
-	uint32_t block_size = nand_model_get_block_size_in_bytes(model);
-	uint32_t page_size = nand_model_get_page_data_size(model);
-
-	/* Translate address */
-	uint16_t tmp_block = address / block_size;
-	address -= tmp_block * block_size;
-	uint16_t tmp_page = address / page_size;
-	address -= tmp_page * page_size;
-	uint16_t tmp_offset = address;
+	uint8_t block_pages_shift = model->block_shift - model->page_shift;
 
 	 /* Check that access is not too big */
-	if ((address + size) > nand_model_get_device_size_in_bytes(model)) {
+	if (((uint64_t)address + size) > nand_model_get_device_size_in_bytes(model)) {
 		NAND_TRACE("nand_model_translate_access: out-of-bounds access.\r\n");
 		return NAND_ERROR_OUTOFBOUNDS;
 	}
 
 	// Save results
 	if (block)
-		*block = tmp_block;
+		*block = address >> model->block_shift;
 	if (page)
-		*page = tmp_page;
+		*page = (address >> model->page_shift) &
+			((1u << block_pages_shift) - 1);
 	if (offset)
-		*offset = tmp_offset;
+		*offset = address & ((1u << model->page_shift) - 1);
 
 	return 0;
 }
@@ -212,8 +235,7 @@ uint8_t nand_model_get_device_id(const struct _nand_flash_model *model)
 uint16_t nand_model_get_device_size_in_blocks(
 		const struct _nand_flash_model *model)
 {
-	return (1024 * model->device_size_in_mega_bytes)
-		/ model->block_size_in_kbytes;
+	return model->block_count;
 }
 
 /**
@@ -223,8 +245,8 @@ uint16_t nand_model_get_device_size_in_blocks(
 uint32_t nand_model_get_device_size_in_pages(
 		const struct _nand_flash_model *model)
 {
-	return (uint32_t)nand_model_get_device_size_in_blocks(model)
-		* nand_model_get_block_size_in_pages(model);
+	return (uint32_t)model->block_count
+		<< (model->block_shift - model->page_shift);
 }
 
 /**
@@ -256,7 +278,7 @@ uint32_t nand_model_get_device_size_in_mbytes(
 uint16_t nand_model_get_block_size_in_pages(
 		const struct _nand_flash_model *model)
 {
-	return model->block_size_in_kbytes * 1024 / model->page_size_in_bytes;
+	return 1u << (model->block_shift - model->page_shift);
 }
 
 /**
@@ -267,7 +289,7 @@ uint16_t nand_model_get_block_size_in_pages(
 uint32_t nand_model_get_block_size_in_bytes(
 		const struct _nand_flash_model *model)
 {
-	return model->block_size_in_kbytes * 1024;
+	return 1u << model->block_shift;
 }
 
 /**
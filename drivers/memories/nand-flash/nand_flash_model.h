@@ -36,7 +36,8 @@
  * !Usage
  *
  * -# Find the model of a NandFlash using its device ID with the
- *    nand_model_find function.
+ *    nand_model_find function, or fill a model from the ONFI parameters and
+ *    call nand_model_compute_geometry.
  *
  * -# Retrieve parameters of a NandFlash model using the following functions:
  *    - nand_model_get_device_id
@@ -123,6 +124,14 @@ struct _nand_flash_model {
 
 	/** Spare area placement scheme */
 	const struct _nand_spare_scheme *scheme;
+
+	/** Geometry derived from the fields above by
+	 * nand_model_compute_geometry(), used by the accessors */
+	uint8_t page_shift;          /**< log2 of the page data size */
+	uint8_t block_shift;         /**< log2 of the block size in bytes */
+	uint8_t col_cycles;          /**< Column address cycles */
+	uint8_t row_cycles;          /**< Row address cycles */
+	uint16_t block_count;        /**< Number of blocks of the device */
 };
 
 /*---------------------------------------------------------------------- */
@@ -135,6 +144,9 @@ extern uint8_t nand_model_find(
 		uint32_t id,
 		struct _nand_flash_model *model);
 
+extern uint8_t nand_model_compute_geometry(
+		struct _nand_flash_model *model);
+
 extern uint8_t nand_model_translate_access(
 		const struct _nand_flash_model *model,
 		uint32_t address,
@@ -45,83 +45,74 @@
  *        Exported variables
  *----------------------------------------------------------------------------*/
 
-/** List of NandFlash models which can be recognized by the software. */
-const struct _nand_flash_model nand_flash_model_list[] = {
-/*	|  ID  | Options   | Page  |spare  | Mo  | Block   |BlkPg   |DevBlk */
-	{0x6e, NANDFLASHMODEL_DATABUS8, 256, 0, 1, 4, &nand_spare_scheme256},
-	{0x64, NANDFLASHMODEL_DATABUS8, 256, 0, 2, 4, &nand_spare_scheme256},
-	{0x68, NANDFLASHMODEL_DATABUS8, 4096, 0, 224, 1024, &nand_spare_scheme4096},
-	{0x6b, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
-	{0xe8, NANDFLASHMODEL_DATABUS8, 256, 0, 1, 4, &nand_spare_scheme256},
-	{0xec, NANDFLASHMODEL_DATABUS8, 256, 0, 1, 4, &nand_spare_scheme256},
-	{0xea, NANDFLASHMODEL_DATABUS8, 256, 0, 2, 4, &nand_spare_scheme256},
-	{0xd5, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
-	{0xe3, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
-	{0xe5, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
-	{0xd6, NANDFLASHMODEL_DATABUS8, 512, 0, 8, 8, &nand_spare_scheme512},
+/** Large block devices, page and block sizes are fetched from the ID4 */
+#define OPTIONS     NANDFLASHMODEL_COPYBACK
 
+/** List of NandFlash models which can be recognized by the software, sorted
+ * by device ID for nand_model_find(). When several models share a device ID,
+ * the first one is used. */
+const struct _nand_flash_model nand_flash_model_list[] = {
+/*	|  ID  | Options   | Page  |spare  | Mo  | Block   | Scheme */
+	{0x33, NANDFLASHMODEL_DATABUS8, 512, 0, 16, 16, &nand_spare_scheme512},
+	{0x35, NANDFLASHMODEL_DATABUS8, 512, 0, 32, 16, &nand_spare_scheme512},
+	{0x36, NANDFLASHMODEL_DATABUS8, 512, 0, 64, 16, &nand_spare_scheme512},
+	{0x38, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme4096},
 	{0x39, NANDFLASHMODEL_DATABUS8, 512, 0, 8, 8, &nand_spare_scheme512},
-	{0xe6, NANDFLASHMODEL_DATABUS8, 512, 0, 8, 8, &nand_spare_scheme512},
+	{0x39, NANDFLASHMODEL_DATABUS8, 512, 0, 128, 16, &nand_spare_scheme512},
+	{0x43, NANDFLASHMODEL_DATABUS16, 512, 0, 16, 16, &nand_spare_scheme512},
+	{0x45, NANDFLASHMODEL_DATABUS16, 512, 0, 32, 16, &nand_spare_scheme512},
+	{0x46, NANDFLASHMODEL_DATABUS16, 512, 0, 64, 16, &nand_spare_scheme512},
 	{0x49, NANDFLASHMODEL_DATABUS16, 512, 0, 8, 8, &nand_spare_scheme512},
+	{0x49, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
+	{0x53, NANDFLASHMODEL_DATABUS16, 512, 0, 16, 16, &nand_spare_scheme512},
+	{0x55, NANDFLASHMODEL_DATABUS16, 512, 0, 32, 16, &nand_spare_scheme512},
+	{0x56, NANDFLASHMODEL_DATABUS16, 512, 0, 64, 16, &nand_spare_scheme512},
 	{0x59, NANDFLASHMODEL_DATABUS16, 512, 0, 8, 8, &nand_spare_scheme512},
-
-	{0x33, NANDFLASHMODEL_DATABUS8, 512, 0, 16, 16, &nand_spare_scheme512},
+	{0x59, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
+	{0x64, NANDFLASHMODEL_DATABUS8, 256, 0, 2, 4, &nand_spare_scheme256},
+	{0x68, NANDFLASHMODEL_DATABUS8, 4096, 0, 224, 1024, &nand_spare_scheme4096},
+	{0x6b, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
+	{0x6e, NANDFLASHMODEL_DATABUS8, 256, 0, 1, 4, &nand_spare_scheme256},
+	{0x71, NANDFLASHMODEL_DATABUS8, 512, 0, 256, 16, &nand_spare_scheme512},
+	{0x72, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
 	{0x73, NANDFLASHMODEL_DATABUS8, 512, 0, 16, 16, &nand_spare_scheme512},
-	{0x43, NANDFLASHMODEL_DATABUS16, 512, 0, 16, 16, &nand_spare_scheme512},
-	{0x53, NANDFLASHMODEL_DATABUS16, 512, 0, 16, 16, &nand_spare_scheme512},
-
-	{0x35, NANDFLASHMODEL_DATABUS8, 512, 0, 32, 16, &nand_spare_scheme512},
+	{0x74, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
 	{0x75, NANDFLASHMODEL_DATABUS8, 512, 0, 32, 16, &nand_spare_scheme512},
-	{0x45, NANDFLASHMODEL_DATABUS16, 512, 0, 32, 16, &nand_spare_scheme512},
-	{0x55, NANDFLASHMODEL_DATABUS16, 512, 0, 32, 16, &nand_spare_scheme512},
-
-	{0x36, NANDFLASHMODEL_DATABUS8, 512, 0, 64, 16, &nand_spare_scheme512},
 	{0x76, NANDFLASHMODEL_DATABUS8, 512, 0, 64, 16, &nand_spare_scheme512},
-	{0x46, NANDFLASHMODEL_DATABUS16, 512, 0, 64, 16, &nand_spare_scheme512},
-	{0x56, NANDFLASHMODEL_DATABUS16, 512, 0, 64, 16, &nand_spare_scheme512},
-
 	{0x78, NANDFLASHMODEL_DATABUS8, 512, 0, 128, 16, &nand_spare_scheme512},
-	{0x39, NANDFLASHMODEL_DATABUS8, 512, 0, 128, 16, &nand_spare_scheme512},
 	{0x79, NANDFLASHMODEL_DATABUS8, 512, 0, 128, 16, &nand_spare_scheme512},
-	{0x72, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
-	{0x49, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
-	{0x74, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
-	{0x59, NANDFLASHMODEL_DATABUS16, 512, 0, 128, 16, &nand_spare_scheme512},
-
-	{0x71, NANDFLASHMODEL_DATABUS8, 512, 0, 256, 16, &nand_spare_scheme512},
-
-/* Large blocks devices. Parameters must be fetched from the extended I */
-#define OPTIONS     NANDFLASHMODEL_COPYBACK
-
-	{0xA2, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
-	{0xF2, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
-	{0xB2, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
-	{0xC2, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
-
-	{0xA1, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
-	{0xF1, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
-	{0xB1, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
-	{0xC1, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
-
-	{0xAA, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
-	{0xDA, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
-	{0xBA, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
-	{0xCA, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
-
-	{0xAC, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
-	{0xDC, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
-	{0xBC, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
-	{0xCC, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
-
-	{0xA3, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
-	{0xD3, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
-	{0xB3, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
-	{0xC3, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
-	{0xA5, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
-	{0xD5, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
-	{0xB5, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
-	{0xC5, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
-	{0x38, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme4096},
+	{0xa1, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
+	{0xa2, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
+	{0xa3, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
+	{0xa5, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
+	{0xaa, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
+	{0xac, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
+	{0xb1, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
+	{0xb2, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
+	{0xb3, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
+	{0xb5, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
+	{0xba, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
+	{0xbc, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
+	{0xc1, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
+	{0xc2, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
+	{0xc3, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
+	{0xc5, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
+	{0xca, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
+	{0xcc, NANDFLASHMODEL_DATABUS16 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
+	{0xd3, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 1024, 0, &nand_spare_scheme2048},
+	{0xd5, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
+	{0xd5, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 2048, 0, &nand_spare_scheme2048},
+	{0xd6, NANDFLASHMODEL_DATABUS8, 512, 0, 8, 8, &nand_spare_scheme512},
+	{0xda, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 256, 0, &nand_spare_scheme2048},
+	{0xdc, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 512, 0, &nand_spare_scheme2048},
+	{0xe3, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
+	{0xe5, NANDFLASHMODEL_DATABUS8, 512, 0, 4, 8, &nand_spare_scheme512},
+	{0xe6, NANDFLASHMODEL_DATABUS8, 512, 0, 8, 8, &nand_spare_scheme512},
+	{0xe8, NANDFLASHMODEL_DATABUS8, 256, 0, 1, 4, &nand_spare_scheme256},
+	{0xea, NANDFLASHMODEL_DATABUS8, 256, 0, 2, 4, &nand_spare_scheme256},
+	{0xec, NANDFLASHMODEL_DATABUS8, 256, 0, 1, 4, &nand_spare_scheme256},
+	{0xf1, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 128, 0, &nand_spare_scheme2048},
+	{0xf2, NANDFLASHMODEL_DATABUS8 | OPTIONS, 0, 0, 64, 0, &nand_spare_scheme2048},
 };
 
 const int nand_flash_model_list_size = ARRAY_SIZE(nand_flash_model_list);
@@ -31,7 +31,8 @@
  * \unit
  * !Purpose
  *
- * Static array of the various NandFlashModels which are supported.
+ * Static array of the various NandFlashModels which are supported, sorted by
+ * device ID.
  *
  * !Usage
  *
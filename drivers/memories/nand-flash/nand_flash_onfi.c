@@ -48,8 +48,17 @@
 
 #define MAX_READ_STATUS_COUNT 1000
 
-/** Not all 256 bytes are useful */
-#define ONFI_PARAM_TABLE_SIZE 116
+/** Size of the parameter page */
+#define ONFI_PARAM_TABLE_SIZE 256
+
+/** Number of copies of the parameter page checked */
+#define ONFI_PARAM_TABLE_COPIES 3
+
+/** Bytes of the parameter page covered by its CRC */
+#define ONFI_PARAM_CRC_LENGTH 254
+
+/** Initial value of the parameter page CRC */
+#define ONFI_PARAM_CRC_INIT   0x4f4e
 
 #define NAND_MFR_MICRON    0x2c
 
@@ -94,6 +103,24 @@ static uint32_t onfi_read_status(const struct _nand_flash *nand)
 	return NAND_IO_RC_TIMEOUT;
 }
 
+/**
+ * \brief Computes the CRC of an ONFI parameter page (CRC-16, polynomial
+ * 0x8005, initial value 0x4F4E).
+ */
+static uint16_t onfi_compute_crc(const uint8_t *data, uint32_t length)
+{
+	uint16_t crc = ONFI_PARAM_CRC_INIT;
+	uint32_t i;
+	int bit;
+
+	for (i = 0; i < length; i++) {
+		crc ^= data[i] << 8;
+		for (bit = 0; bit < 8; bit++)
+			crc = crc & 0x8000 ? (crc << 1) ^ 0x8005 : crc << 1;
+	}
+	return crc;
+}
+
 /**
  * \brief This function retrieves the data structure that describes the target's
  * organization, features, timings and other behavioural parameters.
@@ -102,14 +129,13 @@ static uint32_t onfi_read_status(const struct _nand_flash *nand)
 */
 static bool nand_onfi_retrieve_param(const struct _nand_flash *nand)
 {
-	uint8_t i;
+	uint32_t i, copy;
+	uint16_t crc;
 	uint8_t onfi_param_table[ONFI_PARAM_TABLE_SIZE];
 
 	if (nand_onfi_check_compatibility(nand)) {
 		onfi_parameter.onfi_compatible = true;
-		for (i = 0; i < ONFI_PARAM_TABLE_SIZE; i++) {
-			onfi_param_table[i] = 0xFF;
-		}
+
 		/* Perform Read Parameter Page command */
 		nand_write_command(nand, NAND_CMD_READ_PARAM_PAGE);
 		nand_write_address(nand, 0x0);
@@ -120,21 +146,28 @@ static bool nand_onfi_retrieve_param(const struct _nand_flash *nand)
 		/* Re-enable data output mode required after Read Status command */
 		nand_write_command(nand, NAND_CMD_READ_1);
 
-		/* Read the parameter table */
-		for (i = 0; i < ONFI_PARAM_TABLE_SIZE; i++) {
-			onfi_param_table[i] = nand_read_data(nand);
-		}
-		for (i = 0; i < ONFI_PARAM_TABLE_SIZE; i++) {
-			if (onfi_param_table[i] != 0xFF)
+		/* Read the parameter table, falling back to its redundant copies
+		 * if its CRC is wrong */
+		for (copy = 0; copy < ONFI_PARAM_TABLE_COPIES; copy++) {
+			for (i = 0; i < ONFI_PARAM_TABLE_SIZE; i++)
+				onfi_param_table[i] = nand_read_data(nand);
+			crc = onfi_param_table[ONFI_PARAM_CRC_LENGTH] |
+				(onfi_param_table[ONFI_PARAM_CRC_LENGTH + 1] << 8);
+			if (onfi_compute_crc(onfi_param_table,
+					ONFI_PARAM_CRC_LENGTH) == crc)
 				break;
+			trace_warning("ONFI parameter page %u: bad CRC\r\n",
+					(unsigned)copy);
 		}
-		if (i == ONFI_PARAM_TABLE_SIZE) {
+		if (copy == ONFI_PARAM_TABLE_COPIES) {
 			onfi_parameter.onfi_compatible = false;
 			return false;
 		}
 
 		/* Bus width */
 		onfi_parameter.onfi_bus_width = (*(uint8_t*)(onfi_param_table + 6)) & 0x01;
+		/* Optional commands supported (bytes 8-9 in the param table) */
+		onfi_parameter.onfi_optional_commands = *(uint16_t*)(onfi_param_table + 8);
 		/* Device model */
 		onfi_parameter.onfi_device_model= *(uint8_t*)(onfi_param_table + 49);
 		/* JEDEC manufacturer ID */
@@ -149,6 +182,8 @@ static bool nand_onfi_retrieve_param(const struct _nand_flash *nand)
 		onfi_parameter.onfi_blocks_per_lun = *(uint32_t*)(onfi_param_table + 96);
 		/* Number of logical units. */
 		onfi_parameter.onfi_logical_units = *(uint8_t*)(onfi_param_table + 100);
+		/* Number of partial programs per page */
+		onfi_parameter.onfi_programs_per_page = *(uint8_t*)(onfi_param_table + 110);
 		/* Number of bits of ECC correction */
 		onfi_parameter.onfi_ecc_correctability = *(uint8_t*)(onfi_param_table + 112);
 
@@ -179,7 +214,7 @@ static bool nand_onfi_retrieve_param(const struct _nand_flash *nand)
 */
 bool nand_onfi_check_compatibility(const struct _nand_flash *nand)
 {
-	uint8_t onfi_param_table[ONFI_PARAM_TABLE_SIZE];
+	uint8_t onfi_param_table[4];
 
 	nand_write_command(nand, NAND_CMD_READID);
 	nand_write_address(nand, 0x20);
@@ -232,6 +267,23 @@ uint8_t nand_onfi_get_ecc_correctability(void)
 	return onfi_parameter.onfi_ecc_correctability;
 }
 
+uint8_t nand_onfi_get_programs_per_page(void)
+{
+	return onfi_parameter.onfi_programs_per_page;
+}
+
+/**
+ * \brief Check if the NANDFLASH supports the READ CACHE SEQUENTIAL and READ
+ * CACHE END commands.
+ * \return false if ONFI not compliant or cache read not supported, true
+ * otherwise.
+ */
+bool nand_onfi_has_cache_read(void)
+{
+	return onfi_parameter.onfi_compatible &&
+		(onfi_parameter.onfi_optional_commands & ONFI_OPT_CMD_READ_CACHE);
+}
+
 /**
  * \brief This function check if the NANDFLASH has an embedded ECC controller.
  * \return false if ONFI not compliant or internal ECC not supported, true if Internal ECC enabled.
@@ -46,6 +46,9 @@
 #define NAND_IO_RC_FAIL    1
 #define NAND_IO_RC_TIMEOUT 2
 
+/** Optional commands supported, READ CACHE SEQUENTIAL and READ CACHE END */
+#define ONFI_OPT_CMD_READ_CACHE (1 << 1)
+
 /** Describes memory organization block information in ONFI parameter page */
 struct _onfi_page_param {
 	/** ONFI compatible */
@@ -57,6 +60,9 @@ struct _onfi_page_param {
 	/** Bus width */
 	uint8_t onfi_bus_width;
 
+	/** Optional commands supported */
+	uint16_t onfi_optional_commands;
+
 	/** Number of data bytes per page. */
 	uint32_t onfi_page_size;
 
@@ -72,6 +78,9 @@ struct _onfi_page_param {
 	/** Number of logical units. */
 	uint8_t onfi_logical_units;
 
+	/** Number of partial programs allowed per page (NOP) */
+	uint8_t onfi_programs_per_page;
+
 	/** Number of bits of ECC correction */
 	uint8_t onfi_ecc_correctability;
 
@@ -107,4 +116,8 @@ extern uint16_t nand_onfi_get_blocks_per_lun(void);
 
 extern uint8_t nand_onfi_get_ecc_correctability(void);
 
+extern uint8_t nand_onfi_get_programs_per_page(void);
+
+extern bool nand_onfi_has_cache_read(void);
+
 #endif /* NAND_FLASH_ONFI_H */
@@ -48,6 +48,7 @@
 #include "nand_flash_dma.h"
 #include "nand_flash_model_list.h"
 #include "nand_flash_commands.h"
+#include "nand_flash_onfi.h"
 
 #include <assert.h>
 #include <string.h>
@@ -141,12 +142,8 @@ static uint32_t _nfc_translate_address(const struct _nand_flash *nand,
 		uint16_t col_address, uint32_t row_address,
 		uint8_t *cycle_bytes, uint8_t row_only, uint8_t col_only)
 {
-	uint16_t max_data_size =
-		nand_model_get_page_data_size(&nand->model) +
-		nand_model_get_page_spare_size(&nand->model) - 1;
-	uint32_t max_page_num  =
-		nand_model_get_device_size_in_pages(&nand->model) - 1;
 	uint8_t num_cycles = 0;
+	uint8_t i;
 
 	/* Check the data bus width of the NandFlash */
 	if (nand_model_get_data_bus(&nand->model) == 16) {
@@ -158,18 +155,16 @@ static uint32_t _nfc_translate_address(const struct _nand_flash *nand,
 	if (!row_only) {
 		/* Send single column address byte for small block devices,
 		   or two column address bytes for large block devices */
-		while (max_data_size > 2) {
+		for (i = 0; i < nand->model.col_cycles; i++) {
 			cycle_bytes[num_cycles++] = col_address & 0xFF;
-			max_data_size >>= 8;
 			col_address >>= 8;
 		}
 	}
 
 	/* Convert row address */
 	if (!col_only) {
-		while (max_page_num > 0) {
+		for (i = 0; i < nand->model.row_cycles; i++) {
 			cycle_bytes[num_cycles++] = row_address & 0xFF;
-			max_page_num >>= 8;
 			row_address >>= 8;
 		}
 	}
@@ -555,6 +550,123 @@ static uint8_t _read_page_with_pmecc(const struct _nand_flash *nand,
 	return 0;
 }
 
+/**
+ * \brief Start the transfer of a page from the NAND data register, through the
+ * EBI. When DMA is enabled the transfer is only started, and completes in
+ * _read_pages_wait(). The PMECC, if used, starts a new data phase.
+ * \param nand  Pointer to a struct _nand_flash instance.
+ * \param data  Buffer where the page will be stored.
+ * \param size  Number of bytes to transfer.
+ */
+static void _read_pages_start(const struct _nand_flash *nand,
+		uint8_t *data, uint32_t size)
+{
+	if (nand_is_using_pmecc()) {
+		pmecc_reset();
+		pmecc_start_data_phase();
+	}
+
+	if (nand_is_dma_enabled())
+		nand_dma_start_read(nand->data_addr, (uint32_t)data, size);
+	else
+		_data_array_in(nand, false, data, size);
+}
+
+/**
+ * \brief Wait for the end of a transfer started by _read_pages_start().
+ */
+static void _read_pages_wait(void)
+{
+	if (nand_is_dma_enabled())
+		nand_dma_wait_read();
+
+	if (nand_is_using_pmecc())
+		pmecc_wait_ready();
+}
+
+/**
+ * \brief Reads consecutive pages using READ CACHE SEQUENTIAL. While a page is
+ * transferred from the cache register, the device loads the next one from the
+ * array, and the process hook handles the previous one.
+ * \param nand  Pointer to a struct _nand_flash instance.
+ * \param block  Number of the block where the pages to read reside.
+ * \param page  Number of the first page to read inside the given block.
+ * \param count  Number of pages to read, at least 2.
+ * \param data  Buffer where the pages will be stored.
+ * \param hooks  Hooks called for each page, can be 0.
+ * \return 0 if the operation has been successful; otherwise returns the error
+ * reported by a hook.
+ */
+static uint8_t _read_pages_cached(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, uint8_t *data,
+		const struct _nand_raw_read_hooks *hooks)
+{
+	uint32_t data_size = nand_model_get_page_data_size(&nand->model);
+	uint32_t size = data_size;
+	uint32_t row_address;
+	uint8_t *page_data;
+	uint8_t error = 0;
+	uint16_t i;
+
+	NAND_TRACE("_read_pages_cached(B#%d:P#%d, %d)\r\n", block, page, count);
+
+	if (nand_is_using_pmecc()) {
+		/* ECC bytes are transferred after the data */
+		size += pmecc_get_ecc_end_address();
+		pmecc_reset();
+		pmecc_enable_read();
+		if (!pmecc_auto_spare_en())
+			pmecc_auto_enable();
+	}
+
+	/* Load the first page in the data register */
+	row_address = block * nand_model_get_block_size_in_pages(&nand->model) + page;
+	_send_cle_ale(nand, ALE_COL_EN | ALE_ROW_EN | CLE_VCMD2_EN,
+	              NAND_CMD_READ_1, NAND_CMD_READ_2, 0, row_address);
+	_nand_wait_ready(nand);
+
+	for (i = 0; i < count; i++) {
+		page_data = data + i * data_size;
+
+		/* Move the page to the cache register, the device loads the
+		 * next one, if any, in the background */
+		_send_cle_ale(nand, 0, i + 1 < count ?
+		              NAND_CMD_READ_CACHE_SEQ : NAND_CMD_READ_CACHE_END,
+		              0, 0, 0);
+		_nand_wait_ready(nand);
+		_send_cle_ale(nand, 0, NAND_CMD_READ_1, 0, 0, 0);
+
+		_read_pages_start(nand, page_data, size);
+
+		/* Handle the previous page while this one is transferred */
+		if (i > 0 && hooks && hooks->process)
+			error = hooks->process(nand, i - 1,
+					page_data - data_size, hooks->arg);
+
+		_read_pages_wait();
+
+		if (!error && hooks && hooks->transferred)
+			error = hooks->transferred(nand, i, page_data, hooks->arg);
+		if (error)
+			break;
+	}
+
+	if (nand_is_using_pmecc())
+		pmecc_auto_disable();
+
+	if (error) {
+		/* Leave the cache read mode */
+		if (i + 1 < count)
+			nand_raw_reset(nand);
+		return error;
+	}
+
+	if (hooks && hooks->process)
+		error = hooks->process(nand, count - 1,
+				data + (count - 1) * data_size, hooks->arg);
+	return error;
+}
+
 /**
  * \brief Writes the data and/or the spare area of a page on a NandFlash chip. If one
  * of the buffer pointer is 0, the corresponding area is not written.
@@ -754,9 +866,12 @@ uint8_t nand_raw_initialize(struct _nand_flash *nand,
 			trace_error("nand_raw_initialize: Could not autodetect chip.\r\n");
 			return NAND_ERROR_UNKNOWNMODEL;
 		}
-	} else
+	} else {
 		/* Copy provided model */
 		nand->model = *model;
+		if (nand_model_compute_geometry(&nand->model))
+			return NAND_ERROR_UNKNOWNMODEL;
+	}
 
 	return 0;
 }
@@ -853,6 +968,62 @@ uint8_t nand_raw_read_page(const struct _nand_flash *nand,
 	return NAND_ERROR_ECC_NOT_COMPATIBLE;
 }
 
+/**
+ * \brief Reads the data area of consecutive pages of a block. When the device
+ * supports cache read and the pages are read through the EBI, the transfer of
+ * a page overlaps with the array read of the next page and with the process
+ * hook of the previous page. Otherwise pages are read one after the other.
+ *
+ * When the PMECC is used, the ECC bytes of a page are stored after its data,
+ * so \a data must be large enough for \a count pages plus one spare area.
+ * \param nand  Pointer to a struct _nand_flash instance.
+ * \param block  Number of the block where the pages to read reside.
+ * \param page  Number of the first page to read inside the given block.
+ * \param count  Number of pages to read.
+ * \param data  Buffer where the pages will be stored.
+ * \param hooks  Hooks called for each page, can be 0.
+ * \return 0 if the operation has been successful; otherwise returns an error
+ * code.
+ */
+uint8_t nand_raw_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data,
+		const struct _nand_raw_read_hooks *hooks)
+{
+	uint32_t data_size = nand_model_get_page_data_size(&nand->model);
+	bool cached = count > 1 && nand_onfi_has_cache_read();
+	uint8_t *page_data;
+	uint8_t error;
+	uint16_t i;
+
+	NAND_TRACE("nand_raw_read_pages(B#%d:P#%d, %d)\r\n", block, page, count);
+
+	assert(data);
+	assert(page + count <= nand_model_get_block_size_in_pages(&nand->model));
+
+#ifdef CONFIG_HAVE_NFC
+	/* The NFC issues its own command sequences */
+	if (nand_is_nfc_enabled())
+		cached = false;
+#endif
+
+	if (cached)
+		return _read_pages_cached(nand, block, page, count, data, hooks);
+
+	for (i = 0; i < count; i++) {
+		page_data = (uint8_t*)data + i * data_size;
+
+		error = nand_raw_read_page(nand, block, page + i, page_data, NULL);
+		if (!error && hooks && hooks->transferred)
+			error = hooks->transferred(nand, i, page_data, hooks->arg);
+		if (!error && hooks && hooks->process)
+			error = hooks->process(nand, i, page_data, hooks->arg);
+		if (error)
+			return error;
+	}
+
+	return 0;
+}
+
 /**
  * \brief Writes the data and/or the spare area of a page on a NandFlash chip. If one
  * of the buffer pointer is 0, the corresponding area is not written. Retries
@@ -44,6 +44,8 @@
  * -# nand_raw_read_id() is used to read a NANDFLASH's id.
  * -# nand_raw_erase_block() is used to erase a certain NANDFLASH device's block.
  * -# nand_raw_read_page() and nand_raw_write_page is used to do read/write operation.
+ * -# nand_raw_read_pages() reads consecutive pages of a block, using the cache
+ *      read commands when the device supports them.
  * -# nand_raw_copy_page() is used to issue copy-page command to NANDFLASH device.
  * -# nand_raw_copy_block() calls nand_raw_copy_page to do a NANDFLASH block copy.
 */
@@ -62,6 +64,28 @@
 
 #include "nand_flash.h"
 
+/*------------------------------------------------------------------------------ */
+/*         Types                                                                 */
+/*------------------------------------------------------------------------------ */
+
+/** Page hook of nand_raw_read_pages(), returns 0 to continue reading */
+typedef uint8_t (*nand_raw_page_hook_t)(const struct _nand_flash *nand,
+		uint16_t index, uint8_t *data, void *arg);
+
+/** Hooks called by nand_raw_read_pages() for each page read */
+struct _nand_raw_read_hooks {
+	/** Called once a page has been transferred, before the transfer of the
+	 * next page is started. May be NULL. */
+	nand_raw_page_hook_t transferred;
+
+	/** Called for a transferred page while the next page is being
+	 * transferred. May be NULL. */
+	nand_raw_page_hook_t process;
+
+	/** Argument passed to the hooks */
+	void *arg;
+};
+
 /*------------------------------------------------------------------------------ */
 /*         Exported functions                                                    */
 /*------------------------------------------------------------------------------ */
@@ -80,6 +104,10 @@ extern uint8_t nand_raw_read_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
 
+extern uint8_t nand_raw_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count, void *data,
+		const struct _nand_raw_read_hooks *hooks);
+
 extern uint8_t nand_raw_write_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
@@ -161,44 +161,75 @@ uint8_t nand_skipblock_read_page(const struct _nand_flash *nand,
 	return nand_ecc_read_page(nand, block, page, data, spare);
 }
 
+/**
+ * \brief Reads the data of consecutive pages of a block on a SkipBlock
+ * nandflash. The buffer must be large enough for \a count pages plus one
+ * spare area.
+ * \param nand  Pointer to a _raw_nand_flash instance.
+ * \param block  Number of block to read pages from.
+ * \param page  Number of the first page to read inside the given block.
+ * \param count  Number of pages to read.
+ * \param data  Data area buffer.
+ * \return NAND_ERROR_BADBLOCK if the block is BAD; Otherwise, returns
+ * nand_ecc_read_pages().
+*/
+
+uint8_t nand_skipblock_read_pages(const struct _nand_flash *nand,
+	uint16_t block, uint16_t page, uint16_t count, void *data)
+{
+	uint8_t error;
+
+	/* Check that the block is not BAD if data is requested */
+	if (nand_skipblock_check_block(nand, block) != GOODBLOCK) {
+		trace_error("nand_skipblock_read_pages: Block is BAD.\r\n");
+		return NAND_ERROR_BADBLOCK;
+	}
+
+	/* Read data with ECC verification */
+	error = nand_ecc_read_pages(nand, block, page, count, data);
+	if (error)
+		trace_error("nand_skipblock_read_pages: Cannot read pages %d-%d of block %d.\r\n",
+				page, page + count - 1, block);
+	return error;
+}
+
 /**
  * \brief Reads the data of a whole block on a SkipBlock nandflash.
+ * The buffer only needs to hold the data of the block: all pages but the last
+ * one are read with nand_skipblock_read_pages(), whose ECC bytes spill over
+ * the next page, and the last page is read on its own.
  * \param nand  Pointer to a _raw_nand_flash instance.
  * \param block  Number of block to read page from.
- * \param data  Data area buffer, can be 0.
+ * \param data  Data area buffer.
  * \return NAND_ERROR_BADBLOCK if the block is BAD; Otherwise, returns
- * nand_ecc_read_page().
+ * nand_ecc_read_pages() or nand_ecc_read_page().
 */
 
 uint8_t nand_skipblock_read_block(const struct _nand_flash *nand,
 	uint16_t block, void *data)
 {
 	uint32_t num_pages_per_block, page_size;
-	uint16_t i;
-	uint8_t error = 0;
+	uint16_t last;
+	uint8_t error;
 
 	/* Retrieve model information */
 	page_size = nand_model_get_page_data_size(&nand->model);
 	num_pages_per_block = nand_model_get_block_size_in_pages(&nand->model);
+	last = num_pages_per_block - 1;
 
-	/* Check that the block is not BAD if data is requested */
-	if (nand_skipblock_check_block(nand, block) != GOODBLOCK) {
-
-		trace_error("nand_skipblock_read_block: Block is BAD.\r\n");
-		return NAND_ERROR_BADBLOCK;
-	}
-
-	/* Read all the pages of the block */
-	for (i = 0; i < num_pages_per_block; i++) {
-		error = nand_ecc_read_page(nand, block, i, data, 0);
-		if (error) {
-			trace_error("nand_skipblock_read_block: Cannot read page %d of block %d.\r\n", i, block);
-			return error;
-		}
-		data = (void*)((uint8_t*)data + page_size);
-	}
+	/* Read all the pages of the block but the last one */
+	error = nand_skipblock_read_pages(nand, block, 0, last, data);
+	if (error)
+		return error;
 
-	return 0;
+	/* The block was checked above, read the last page without spilling
+	 * past the end of the buffer */
+	error = nand_ecc_read_page(nand, block, last,
+			(uint8_t*)data + last * page_size, NULL);
+	if (error)
+		trace_error("nand_skipblock_read_block: Cannot read page %d of block %d.\r\n",
+				last, block);
+	return error;
 }
 
 /**
@@ -44,10 +44,11 @@
  * -# User can use nand_skipblock_write_block() to write a certain block and nand_skipblock_write_page()
  *      to write a certain page. The functions will check the block status before write, if the block
  *      is not a good block, the write command will not be issued.
- * -# User can use nand_skipblock_read_block() to read a certain block and nand_skipblock_read_page()
- *      to read a certain page. The functions will check the block status before read, if the block
- *      is not a good block, the read command will not be issued. ECC is also checked after read
- *      operation is finished, an error will be reported if ecc check got errors.
+ * -# User can use nand_skipblock_read_block() to read a certain block, nand_skipblock_read_pages()
+ *      to read consecutive pages and nand_skipblock_read_page() to read a certain page. The
+ *      functions will check the block status before read, if the block is not a good block, the
+ *      read command will not be issued. ECC is also checked after read operation is finished, an
+ *      error will be reported if ecc check got errors.
 */
 
 #ifndef NAND_FLASH_SKIP_BLOCK_H
@@ -94,6 +95,10 @@ extern uint8_t nand_skipblock_read_page(const struct _nand_flash *nand,
 		uint16_t block, uint16_t page,
 		void *data, void *spare);
 
+extern uint8_t nand_skipblock_read_pages(const struct _nand_flash *nand,
+		uint16_t block, uint16_t page, uint16_t count,
+		void *data);
+
 uint8_t nand_skipblock_read_block(const struct _nand_flash *nand,
 		uint16_t block, void *data);
 
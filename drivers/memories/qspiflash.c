@@ -37,7 +37,12 @@
 #include "timer.h"
 #include "trace.h"
 #include "memories/qspiflash.h"
+#include "memories/sfdp.h"
+#include "misc/cache.h"
 #include "peripherals/qspi.h"
+#ifdef CONFIG_HAVE_QSPI_DMA
+#include "peripherals/dma.h"
+#endif
 #include <stdio.h>
 #include <string.h>
 
@@ -51,6 +56,13 @@
 #define TIMEOUT_ERASE        3000 /* 3s */
 #define TIMEOUT_ERASE_CHIP 500000 /* 500s */
 
+/* Minimum run time of a program or erase operation after it was started or
+ * resumed, before it may be suspended again (in timer ticks). Each resume
+ * costs the memory its resume-to-suspend latency (tRS, about 100us) before
+ * it makes progress again: without it, back-to-back reads could starve the
+ * operation. Two ticks guarantee at least one full tick. */
+#define MIN_RUN_AFTER_RESUME    2
+
 /** QSPI Commands */
 #define CMD_WRITE_STATUS     0x01 /* Write Status Register */
 #define CMD_PAGE_PROGRAM     0x02 /* Page Program */
@@ -72,6 +84,11 @@
 #define CMD_BLOCK_ERASE      0xd8 /* 64/256KB Block Erase */
 #define CMD_FAST_READ_1_4_4  0xeb /* Fast Read (1-4-4) */
 #define CMD_ENTER_ADDR4_MODE 0xb7 /* Enter 4-byte address mode */
+#define CMD_SUSPEND          0x75 /* Program/Erase Suspend */
+#define CMD_RESUME           0x7a /* Program/Erase Resume */
+#define CMD_WRITE_STATUS_2   0x31 /* Write Status Register 2 */
+#define CMD_WRITE_STATUS_3E  0x3e /* Write Status Register 2 (QER 3) */
+#define CMD_READ_STATUS_3F   0x3f /* Read Status Register 2 (QER 3) */
 
 #define CMD_QUAD_PAGE_PROGRAM 0x32
 
@@ -88,6 +105,8 @@
 #define CMD_MACRONIX_READ_CONFIG 0x15 /* Read Configuration Register */
 #define CMD_QUAD_PAGE_PROGRAM_MX 0x38
 #define CMD_QUAD_PAGE_PROGRAM_MX_4B 0x3e
+#define CMD_MACRONIX_SUSPEND     0xb0 /* Program/Erase Suspend */
+#define CMD_MACRONIX_RESUME      0x30 /* Program/Erase Resume */
 
 /* QSPI Commands (Spansion) */
 #define CMD_SPANSION_QPP 0x32 /* Quad Page Programming */
@@ -102,6 +121,10 @@
 #define SR_SPANSION_BP1     (1 << 3) /* Block Protect */
 #define SR_SPANSION_BP2     (1 << 4) /* Block Protect */
 
+/** QSPI Status Register 2 bits (SFDP Quad Enable requirements) */
+#define SR2_QUAD_EN_BIT1    (1 << 1) /* Quad Enable */
+#define SR2_QUAD_EN_BIT7    (1 << 7) /* Quad Enable */
+
 /* QSPI Configuration Register bits */
 #define CR_SPANSION_QUAD (1 << 1) /* Puts the device into Quad I/O mode */
 #define CR_SPANSION_BPNV (1 << 3) /* Configures BP2-0 bits in the Status Register */
@@ -127,6 +150,13 @@
 #define CMD_BLOCK_ERASE_32K_4B      0x5c
 #define CMD_BLOCK_ERASE_4B          0xdc
 
+/** Asynchronous job states */
+enum {
+	JOB_STATE_XFER,   /* page being sent to the memory */
+	JOB_STATE_BUSY,   /* memory programming or erasing */
+	JOB_STATE_ERROR,
+};
+
 /*----------------------------------------------------------------------------
  *        Local Types
  *----------------------------------------------------------------------------*/
@@ -165,6 +195,17 @@ static const struct _read_id_config configs[] = {
 	{ QSPI_IFR_WIDTH_QUAD_CMD, CMD_READ_ID },
 };
 
+/** QSPI protocol of each SFDP read protocol */
+static const uint32_t sfdp_widths[SFDP_PROTO_COUNT] = {
+	[SFDP_PROTO_1_1_1] = QSPI_IFR_WIDTH_SINGLE_BIT_SPI,
+	[SFDP_PROTO_1_1_2] = QSPI_IFR_WIDTH_DUAL_OUTPUT,
+	[SFDP_PROTO_1_2_2] = QSPI_IFR_WIDTH_DUAL_IO,
+	[SFDP_PROTO_2_2_2] = QSPI_IFR_WIDTH_DUAL_CMD,
+	[SFDP_PROTO_1_1_4] = QSPI_IFR_WIDTH_QUAD_OUTPUT,
+	[SFDP_PROTO_1_4_4] = QSPI_IFR_WIDTH_QUAD_IO,
+	[SFDP_PROTO_4_4_4] = QSPI_IFR_WIDTH_QUAD_CMD,
+};
+
 static const struct _flash_init flash_inits[] = {
 	{ SPINOR_MANUF_MICRON, _qspiflash_init_micron },
 	{ SPINOR_MANUF_MACRONIX, _qspiflash_init_macronix },
@@ -172,6 +213,17 @@ static const struct _flash_init flash_inits[] = {
 	{ SPINOR_MANUF_SST, _qspiflash_init_sst },
 };
 
+/*----------------------------------------------------------------------------
+ *        Local Variables
+ *----------------------------------------------------------------------------*/
+
+/** Page buffers of the asynchronous write jobs, one being sent while the
+ * other is prepared */
+static uint8_t job_buffers[2][QSPIFLASH_JOB_PAGE_SIZE] CACHE_ALIGNED;
+
+/** Job using the page buffers */
+static struct _qspiflash_job *job_owner;
+
 /*----------------------------------------------------------------------------
  *        Local Functions
  *----------------------------------------------------------------------------*/
@@ -234,6 +286,19 @@ static bool qspiflash_read_flag_status(const struct _qspiflash *flash, uint8_t *
 	}
 }
 
+static bool _qspiflash_is_ready(const struct _qspiflash *flash, bool *ready)
+{
+	uint8_t status, flag_status;
+
+	if (!qspiflash_read_flag_status(flash, &flag_status))
+		return false;
+	if (!qspiflash_read_status(flash, &status))
+		return false;
+
+	*ready = ((status & SR_WIP) == 0) && ((flag_status & FSR_NBUSY) != 0);
+	return true;
+}
+
 /*----------------------------------------------------------------------------
  *        Local Functions (convert opcode to its 4-byte address version)
  *----------------------------------------------------------------------------*/
@@ -560,6 +625,9 @@ updated:
 
 static bool _qspiflash_init_macronix(struct _qspiflash *flash)
 {
+	flash->opcode_suspend = CMD_MACRONIX_SUSPEND;
+	flash->opcode_resume = CMD_MACRONIX_RESUME;
+
 	if (flash->desc.flags & SPINOR_FLAG_QUAD) {
 		/*
 		 * In QPI mode, only the Fast Read 1-4-4 (0xeb) op code is supported.
@@ -699,9 +767,426 @@ static bool _qspiflash_init_spansion(struct _qspiflash *flash)
 
 static bool _qspiflash_init_sst(struct _qspiflash *flash)
 {
+	/* Same suspend/resume opcodes as Macronix */
+	flash->opcode_suspend = CMD_MACRONIX_SUSPEND;
+	flash->opcode_resume = CMD_MACRONIX_RESUME;
+
 	return _qspiflash_write_reg(flash, CMD_SST_ULBPR, NULL, 0);
 }
 
+/*----------------------------------------------------------------------------
+ *        Local Functions (SFDP support)
+ *----------------------------------------------------------------------------*/
+
+static bool _qspiflash_read_sfdp(void *arg, uint32_t addr, void *data,
+		uint32_t length)
+{
+	const struct _qspiflash *flash = (const struct _qspiflash *)arg;
+	struct _qspi_cmd cmd;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.ifr_type = QSPI_IFR_TFRTYP_TRSFR_READ_MEMORY;
+	cmd.ifr_width = flash->ifr_width_reg;
+	cmd.enable.instruction = 1;
+	cmd.enable.address = 3;
+	cmd.enable.dummy = 1;
+	cmd.enable.data = 1;
+	cmd.instruction = SFDP_CMD_READ;
+	cmd.num_dummy_cycles = SFDP_READ_DUMMY_CYCLES;
+	cmd.address = addr;
+	cmd.rx_buffer = data;
+	cmd.buffer_len = length;
+	cmd.timeout = TIMEOUT_DEFAULT;
+	return qspi_perform_command(flash->qspi, &cmd);
+}
+
+static bool _sfdp_quad_enable(struct _qspiflash *flash, uint8_t qer)
+{
+	uint8_t sr[2];
+	uint8_t cr;
+
+	switch (qer) {
+	case SFDP_QER_NONE:
+		return true;
+
+	case SFDP_QER_SR1_BIT6:
+		/* Same Quad Enable bit as Macronix */
+		return _macronix_quad_enable(flash);
+
+	case SFDP_QER_SR2_BIT7:
+		if (!_qspiflash_read_reg(flash, CMD_READ_STATUS_3F, &cr, 1))
+			return false;
+		if (cr & SR2_QUAD_EN_BIT7)
+			return true;
+		if (!_qspiflash_write_enable(flash))
+			return false;
+		cr |= SR2_QUAD_EN_BIT7;
+		if (!_qspiflash_write_reg(flash, CMD_WRITE_STATUS_3E, &cr, 1))
+			return false;
+		if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
+			return false;
+		if (!_qspiflash_read_reg(flash, CMD_READ_STATUS_3F, &cr, 1))
+			return false;
+		return (cr & SR2_QUAD_EN_BIT7) != 0;
+
+	case SFDP_QER_SR2_BIT1_NO_RD:
+	case SFDP_QER_SR2_BIT1_NO_CLR:
+		/* Status Register 2 cannot be read back, write both registers */
+		if (!qspiflash_read_status(flash, &sr[0]))
+			return false;
+		if (!_qspiflash_write_enable(flash))
+			return false;
+		sr[1] = SR2_QUAD_EN_BIT1;
+		if (!_qspiflash_write_reg(flash, CMD_WRITE_STATUS, sr, 2))
+			return false;
+		return qspiflash_wait_ready(flash, TIMEOUT_DEFAULT);
+
+	case SFDP_QER_SR2_BIT1:
+	case SFDP_QER_SR2_BIT1_31H:
+		if (!qspiflash_read_status(flash, &sr[0]))
+			return false;
+		if (!_qspiflash_read_reg(flash, CMD_READ_CONFIG, &sr[1], 1))
+			return false;
+		if (sr[1] & SR2_QUAD_EN_BIT1)
+			return true;
+		if (!_qspiflash_write_enable(flash))
+			return false;
+		sr[1] |= SR2_QUAD_EN_BIT1;
+		if (qer == SFDP_QER_SR2_BIT1_31H) {
+			if (!_qspiflash_write_reg(flash, CMD_WRITE_STATUS_2, &sr[1], 1))
+				return false;
+		} else {
+			if (!_qspiflash_write_reg(flash, CMD_WRITE_STATUS, sr, 2))
+				return false;
+		}
+		if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
+			return false;
+		if (!_qspiflash_read_reg(flash, CMD_READ_CONFIG, &sr[1], 1))
+			return false;
+		return (sr[1] & SR2_QUAD_EN_BIT1) != 0;
+
+	default:
+		return false;
+	}
+}
+
+/**
+ * \brief Generic initialization for memories without vendor-specific code:
+ * select the fastest read protocol, the erase instructions, the 4-byte
+ * address instructions and the suspend/resume instructions from the SFDP
+ * tables.
+ */
+static bool _qspiflash_init_sfdp(struct _qspiflash *flash,
+		const struct _sfdp *sfdp)
+{
+	const uint32_t quad = (1u << SFDP_PROTO_1_1_4) | (1u << SFDP_PROTO_1_4_4);
+	bool instr_4b = false;
+	bool erase_64k = false;
+	uint32_t allowed;
+	unsigned proto, i;
+
+	/* The memory is not switched to/from QPI or DPI mode, only use the
+	 * protocols available in the mode it was found in */
+	switch (flash->ifr_width_reg) {
+	case QSPI_IFR_WIDTH_QUAD_CMD:
+		allowed = 1u << SFDP_PROTO_4_4_4;
+		break;
+	case QSPI_IFR_WIDTH_DUAL_CMD:
+		allowed = 1u << SFDP_PROTO_2_2_2;
+		break;
+	default:
+		allowed = ~((1u << SFDP_PROTO_2_2_2) | (1u << SFDP_PROTO_4_4_4));
+		break;
+	}
+
+	proto = sfdp_select_read(sfdp, allowed);
+	if (((1u << proto) & quad) && !_sfdp_quad_enable(flash, sfdp->quad_enable)) {
+		trace_warning("QSPI Flash: could not enable Quad mode\r\n");
+		proto = sfdp_select_read(sfdp, allowed & ~quad);
+	}
+
+	if (proto < SFDP_PROTO_COUNT) {
+		const struct _sfdp_read *read = &sfdp->read[proto];
+
+		flash->opcode_read = read->opcode;
+		flash->ifr_width_read = sfdp_widths[proto];
+		flash->num_mode_cycles = read->mode_cycles;
+		flash->num_dummy_cycles = read->dummy_cycles;
+
+		/* mode bits: FFh never enters continuous read mode, A5h
+		 * enters 0-4-4 mode when supported */
+		flash->normal_read_mode = 0xff;
+		if (sfdp->continuous_read && proto >= SFDP_PROTO_1_4_4)
+			flash->continuous_read_mode = 0xa5;
+		else
+			flash->continuous_read_mode = 0xff;
+
+		trace_debug("QSPI Flash: SFDP read opcode 0x%02x, %u mode and %u dummy cycles\r\n",
+				read->opcode, read->mode_cycles, read->dummy_cycles);
+	}
+
+	if (sfdp->dtr)
+		trace_debug("QSPI Flash: DTR reads not supported by the controller\r\n");
+
+	/* Quad page program, the 4BAIT is the only table listing it */
+	if (((1u << proto) & quad) && (sfdp->instr_4b & SFDP_4BAIT_PP_1_1_4)) {
+		flash->opcode_page_program = CMD_QUAD_PAGE_PROGRAM;
+		flash->ifr_width_program = QSPI_IFR_WIDTH_QUAD_OUTPUT;
+	}
+
+	/* 4-byte addresses, using B7h is left to the generic code */
+	if (flash->desc.size > 16 * 1024 * 1024) {
+		if (sfdp->addr_bytes == SFDP_ADDR_4 ||
+		    (sfdp->enter_4b & SFDP_4B_ALWAYS)) {
+			flash->mode_addr4 = true;
+		} else if (sfdp->instr_4b || (sfdp->enter_4b & SFDP_4B_INSTR)) {
+			flash->mode_addr4 = true;
+			instr_4b = true;
+			flash->opcode_read = qspi_flash_3to4_opcode(flash->opcode_read);
+			flash->opcode_page_program = qspi_flash_3to4_opcode(flash->opcode_page_program);
+		}
+	}
+
+	/* Erase instructions, smallest types first */
+	for (i = 0; i < SFDP_ERASE_TYPES; i++) {
+		const struct _sfdp_erase *erase = &sfdp->erase[i];
+		uint8_t opcode = erase->opcode;
+
+		if (instr_4b)
+			opcode = erase->opcode_4b ? erase->opcode_4b :
+				qspi_flash_3to4_opcode(opcode);
+
+		switch (erase->size) {
+		case 4 * 1024:
+			flash->opcode_sector_erase = opcode;
+			break;
+		case 32 * 1024:
+			flash->opcode_block_erase_32k = opcode;
+			break;
+		case 64 * 1024:
+			flash->opcode_block_erase = opcode;
+			erase_64k = true;
+			break;
+		case 256 * 1024:
+			if (!erase_64k)
+				flash->opcode_block_erase = opcode;
+			break;
+		}
+	}
+
+	if (sfdp->suspend) {
+		flash->opcode_suspend = sfdp->opcode_erase_suspend;
+		flash->opcode_resume = sfdp->opcode_erase_resume;
+	}
+
+	return true;
+}
+
+
+/*----------------------------------------------------------------------------
+ *        Local Functions (asynchronous jobs)
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Find the largest erase block that fits at addr.
+ * \return the block size, 0 if none
+ */
+static uint32_t _qspiflash_erase_size(const struct _qspiflash *flash,
+		uint32_t addr, uint32_t length, uint8_t *instr)
+{
+	static const struct {
+		uint32_t size;
+		uint32_t flag;
+	} sizes[] = {
+		{ 256 * 1024, SPINOR_FLAG_ERASE_256K },
+		{ 64 * 1024, SPINOR_FLAG_ERASE_64K },
+		{ 32 * 1024, SPINOR_FLAG_ERASE_32K },
+		{ 4 * 1024, SPINOR_FLAG_ERASE_4K },
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		if (!(flash->desc.flags & sizes[i].flag))
+			continue;
+		if (sizes[i].size > length || (addr % sizes[i].size) != 0)
+			continue;
+		if (sizes[i].size == 32 * 1024)
+			*instr = flash->opcode_block_erase_32k;
+		else if (sizes[i].size == 4 * 1024)
+			*instr = flash->opcode_sector_erase;
+		else
+			*instr = flash->opcode_block_erase;
+		return sizes[i].size;
+	}
+
+	return 0;
+}
+
+/**
+ * \brief Copy the next chunk of data to the free page buffer.
+ *
+ * Unless AESB is used, the chunk is padded with 0xff up to cache line
+ * boundaries, so that it can be sent by DMA: programming 0xff leaves the
+ * memory unchanged.
+ */
+static void _qspiflash_job_prepare(const struct _qspiflash *flash,
+		struct _qspiflash_job *job)
+{
+	uint32_t unit = min_u32(flash->desc.page_size, QSPIFLASH_JOB_PAGE_SIZE);
+	uint32_t addr, len, pad, size;
+	uint8_t *buf;
+
+	if (job->next_len || job->queued >= job->length)
+		return;
+
+	addr = job->addr + job->queued;
+	len = min_u32(job->length - job->queued, unit - (addr % unit));
+	pad = 0;
+	size = len;
+#ifdef CONFIG_HAVE_AESB
+	if (!flash->use_aesb)
+#endif
+	{
+		pad = addr % L1_CACHE_BYTES;
+		size = ROUND_UP_MULT(pad + len, L1_CACHE_BYTES);
+	}
+
+	buf = job_buffers[job->next_buf];
+	memset(buf, 0xff, pad);
+	memcpy(buf + pad, job->data + job->queued, len);
+	memset(buf + pad + len, 0xff, size - pad - len);
+
+	job->next_addr = addr - pad;
+	job->next_len = len;
+	job->next_size = size;
+	job->queued += len;
+}
+
+static void _qspiflash_job_xfer_done(void *arg, bool success)
+{
+	struct _qspiflash_job *job = (struct _qspiflash_job *)arg;
+
+	if (success) {
+		timer_start_timeout(&job->timeout, TIMEOUT_WRITE);
+		job->state = JOB_STATE_BUSY;
+	} else {
+		job->state = JOB_STATE_ERROR;
+	}
+}
+
+/**
+ * \brief Start programming the prepared page buffer, then prepare the next
+ * one while the page is sent and programmed.
+ */
+static bool _qspiflash_job_program(const struct _qspiflash *flash,
+		struct _qspiflash_job *job)
+{
+	struct _qspi_cmd cmd;
+
+	_qspiflash_job_prepare(flash, job);
+
+	if (!_qspiflash_write_enable(flash))
+		return false;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.ifr_type = QSPI_IFR_TFRTYP_TRSFR_WRITE_MEMORY;
+	cmd.ifr_width = flash->ifr_width_program;
+	cmd.enable.instruction = 1;
+	cmd.enable.address = flash->mode_addr4 ? 4 : 3;
+#ifdef CONFIG_HAVE_AESB
+	cmd.use_aesb = flash->use_aesb;
+#endif
+	cmd.enable.data = 1;
+	cmd.instruction = flash->opcode_page_program;
+	cmd.address = job->next_addr;
+	cmd.tx_buffer = job_buffers[job->next_buf];
+	cmd.buffer_len = job->next_size;
+	cmd.timeout = TIMEOUT_DEFAULT;
+
+	job->count = job->next_len;
+	job->next_len = 0;
+	job->next_buf ^= 1;
+	job->state = JOB_STATE_XFER;
+	if (!qspi_perform_command_async(flash->qspi, &cmd,
+				_qspiflash_job_xfer_done, job))
+		return false;
+
+	_qspiflash_job_prepare(flash, job);
+	return true;
+}
+
+static bool _qspiflash_job_erase(const struct _qspiflash *flash,
+		struct _qspiflash_job *job)
+{
+	struct _qspi_cmd cmd;
+	uint32_t addr = job->addr + job->done;
+	uint8_t instr;
+
+	job->count = _qspiflash_erase_size(flash, addr, job->length - job->done,
+			&instr);
+	if (!job->count)
+		return false;
+
+	if (!_qspiflash_write_enable(flash))
+		return false;
+
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.ifr_type = QSPI_IFR_TFRTYP_TRSFR_WRITE;
+	cmd.ifr_width = flash->ifr_width_erase;
+	cmd.enable.instruction = 1;
+#ifdef CONFIG_HAVE_AESB
+	cmd.use_aesb = flash->use_aesb;
+#endif
+	cmd.enable.address = flash->mode_addr4 ? 4 : 3;
+	cmd.instruction = instr;
+	cmd.address = addr;
+	cmd.timeout = TIMEOUT_DEFAULT;
+	if (!qspi_perform_command(flash->qspi, &cmd))
+		return false;
+
+	timer_start_timeout(&job->timeout, TIMEOUT_ERASE);
+	job->state = JOB_STATE_BUSY;
+	return true;
+}
+
+static bool _qspiflash_job_next(const struct _qspiflash *flash,
+		struct _qspiflash_job *job)
+{
+	if (job->op == QSPIFLASH_JOB_ERASE)
+		return _qspiflash_job_erase(flash, job);
+	else
+		return _qspiflash_job_program(flash, job);
+}
+
+static void _qspiflash_job_end(struct _qspiflash *flash, bool success)
+{
+	struct _qspiflash_job *job = flash->job;
+
+	if (job_owner == job)
+		job_owner = NULL;
+	flash->job = NULL;
+	if (!success)
+		trace_debug("qspiflash: job failed at 0x%08x\r\n",
+				(unsigned)(job->addr + job->done));
+	if (job->callback)
+		job->callback(flash, success, job->arg);
+}
+
+static bool _qspiflash_job_start(struct _qspiflash *flash,
+		struct _qspiflash_job *job)
+{
+	if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
+		return false;
+
+	flash->job = job;
+	if (!_qspiflash_job_next(flash, job)) {
+		if (job_owner == job)
+			job_owner = NULL;
+		flash->job = NULL;
+		return false;
+	}
+	return true;
+}
 
 /*----------------------------------------------------------------------------
  *        Public Functions
@@ -710,6 +1195,9 @@ static bool _qspiflash_init_sst(struct _qspiflash *flash)
 bool qspiflash_configure(struct _qspiflash *flash, Qspi *qspi)
 {
 	int i;
+	struct _sfdp sfdp;
+	bool has_sfdp = false;
+	bool initialized = false;
 
 	memset(flash, 0, sizeof(*flash));
 	flash->qspi = qspi;
@@ -736,11 +1224,18 @@ bool qspiflash_configure(struct _qspiflash *flash, Qspi *qspi)
 			trace_debug("Found memory with JEDEC ID 0x%08x.\r\n",
 					(unsigned)jedec_id);
 
-			/* Look for a supported flash */
+			/* Read the SFDP tables if any */
+			has_sfdp = sfdp_parse(&sfdp, _qspiflash_read_sfdp, flash);
+
+			/* Look for a supported flash, or describe it from its
+			 * SFDP tables */
 			const struct _spi_nor_desc *desc = spi_nor_find(jedec_id);
 			if (desc) {
 				memcpy(&flash->desc, desc, sizeof(*desc));
 				found = true;
+			} else if (has_sfdp) {
+				sfdp_get_spi_nor_desc(&sfdp, jedec_id, &flash->desc);
+				found = true;
 			} else {
 				trace_warning("Memory with JEDEC ID 0x%08x is not supported\r\n",
 						(unsigned)jedec_id);
@@ -763,6 +1258,8 @@ bool qspiflash_configure(struct _qspiflash *flash, Qspi *qspi)
 	flash->opcode_sector_erase = CMD_SECTOR_ERASE;
 	flash->opcode_block_erase = CMD_BLOCK_ERASE;
 	flash->opcode_block_erase_32k = CMD_BLOCK_ERASE_32K;
+	flash->opcode_suspend = CMD_SUSPEND;
+	flash->opcode_resume = CMD_RESUME;
 	flash->mode_addr4 = false;
 #ifdef CONFIG_HAVE_AESB
 	flash->use_aesb = false;
@@ -777,11 +1274,20 @@ bool qspiflash_configure(struct _qspiflash *flash, Qspi *qspi)
 				trace_warning("Could not initialize QSPI memory\r\n");
 				return false;
 			}
+			initialized = true;
+		}
+	}
+
+	/* No vendor-specific code, use the SFDP tables */
+	if (!initialized && has_sfdp) {
+		if (!_qspiflash_init_sfdp(flash, &sfdp)) {
+			trace_warning("Could not initialize QSPI memory\r\n");
+			return false;
 		}
 	}
 
 	/* Convert opcodes to their 4byte address version for >16MB memories */
-	if (flash->desc.size > 16 * 1024 * 1024) {
+	if (flash->desc.size > 16 * 1024 * 1024 && !flash->mode_addr4) {
 		if (flash->desc.flags & SPINOR_FLAG_ENTER_4B_MODE) {
 			if (!_qspiflash_enter_addr4_mode(flash)) {
 				trace_warning("Could not switch QSPI memory to 4-byte address mode\r\n");
@@ -817,14 +1323,11 @@ bool qspiflash_wait_ready(const struct _qspiflash *flash, uint32_t timeout)
 	struct _timeout to;
 	timer_start_timeout(&to, timeout);
 	do {
-		uint8_t status, flag_status;
+		bool ready;
 
-                if (!qspiflash_read_flag_status(flash, &flag_status))
+		if (!_qspiflash_is_ready(flash, &ready))
 			return false;
-		if (!qspiflash_read_status(flash, &status))
-			return false;
-
-		if (((status & SR_WIP) == 0) && ((flag_status & FSR_NBUSY) != 0))
+		if (ready)
 			return true;
 	} while (!timer_timeout_reached(&to));
 
@@ -851,6 +1354,16 @@ bool qspiflash_read(const struct _qspiflash *flash, uint32_t addr, void *data,
 {
 	uint8_t mode = data ? flash->normal_read_mode : flash->continuous_read_mode;
 	struct _qspi_cmd cmd;
+	bool resume = false;
+	bool rc;
+
+	/* Suspend the job in progress, it stays suspended in continuous read
+	 * mode */
+	if (flash->job && !flash->job->suspended) {
+		if (!qspiflash_suspend(flash))
+			return false;
+		resume = (data != NULL);
+	}
 
 	if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
 		return false;
@@ -874,11 +1387,19 @@ bool qspiflash_read(const struct _qspiflash *flash, uint32_t addr, void *data,
 	cmd.rx_buffer = data;
 	cmd.buffer_len = length;
 	cmd.timeout = TIMEOUT_DEFAULT;
-	return qspi_perform_command(flash->qspi, &cmd);
+	rc = qspi_perform_command(flash->qspi, &cmd);
+
+	if (resume && !qspiflash_resume(flash))
+		return false;
+
+	return rc;
 }
 
 bool qspiflash_erase_chip(const struct _qspiflash *flash)
 {
+	if (flash->job)
+		return false;
+
 	if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
 		return false;
 
@@ -940,6 +1461,9 @@ bool qspiflash_erase_block(const struct _qspiflash *flash,
 		return false;
 	}
 
+	if (flash->job)
+		return false;
+
 	if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
 		return false;
 
@@ -973,6 +1497,9 @@ bool qspiflash_write(const struct _qspiflash *flash, uint32_t addr,
 	uint32_t written = 0;
 	const uint8_t *ptr = data;
 
+	if (flash->job)
+		return false;
+
 	if (!qspiflash_wait_ready(flash, TIMEOUT_DEFAULT))
 		return false;
 
@@ -1014,3 +1541,151 @@ bool qspiflash_write(const struct _qspiflash *flash, uint32_t addr,
 
 	return true;
 }
+
+bool qspiflash_erase_async(struct _qspiflash *flash,
+		struct _qspiflash_job *job, uint32_t addr, uint32_t length,
+		qspiflash_callback_t callback, void *arg)
+{
+	uint32_t offset, size;
+	uint8_t instr;
+
+	if (flash->job)
+		return false;
+
+	/* Check that the whole range can be erased */
+	for (offset = 0; offset < length; offset += size) {
+		size = _qspiflash_erase_size(flash, addr + offset,
+				length - offset, &instr);
+		if (!size) {
+			trace_error("qspiflash: cannot erase 0x%08x\r\n",
+					(unsigned)(addr + offset));
+			return false;
+		}
+	}
+
+	memset(job, 0, sizeof(*job));
+	job->op = QSPIFLASH_JOB_ERASE;
+	job->addr = addr;
+	job->length = length;
+	job->callback = callback;
+	job->arg = arg;
+	return _qspiflash_job_start(flash, job);
+}
+
+bool qspiflash_write_async(struct _qspiflash *flash,
+		struct _qspiflash_job *job, uint32_t addr, const void *data,
+		uint32_t length, qspiflash_callback_t callback, void *arg)
+{
+	if (flash->job || job_owner || !length)
+		return false;
+
+	memset(job, 0, sizeof(*job));
+	job->op = QSPIFLASH_JOB_WRITE;
+	job->addr = addr;
+	job->data = data;
+	job->length = length;
+	job->callback = callback;
+	job->arg = arg;
+	job_owner = job;
+	return _qspiflash_job_start(flash, job);
+}
+
+void qspiflash_poll(struct _qspiflash *flash)
+{
+	struct _qspiflash_job *job = flash->job;
+	bool ready;
+
+	if (!job || job->suspended)
+		return;
+
+#ifdef CONFIG_HAVE_QSPI_DMA
+	dma_poll();
+#endif
+
+	switch (job->state) {
+	case JOB_STATE_XFER:
+		return;
+
+	case JOB_STATE_BUSY:
+		if (!_qspiflash_is_ready(flash, &ready))
+			break;
+		if (!ready) {
+			if (!timer_timeout_reached(&job->timeout))
+				return;
+			trace_debug("qspiflash_poll timeout reached\r\n");
+			break;
+		}
+
+		job->done += job->count;
+		if (job->done >= job->length) {
+			_qspiflash_job_end(flash, true);
+			return;
+		}
+		if (_qspiflash_job_next(flash, job))
+			return;
+		break;
+
+	default:
+		break;
+	}
+
+	_qspiflash_job_end(flash, false);
+}
+
+bool qspiflash_is_busy(const struct _qspiflash *flash)
+{
+	return flash->job != NULL;
+}
+
+bool qspiflash_suspend(const struct _qspiflash *flash)
+{
+	struct _qspiflash_job *job = flash->job;
+	bool ready;
+
+	if (!job || job->suspended)
+		return true;
+
+	/* Let the page transfer end */
+	while (job->state == JOB_STATE_XFER) {
+#ifdef CONFIG_HAVE_QSPI_DMA
+		dma_poll();
+#endif
+	}
+	if (job->state != JOB_STATE_BUSY)
+		return true;
+
+	/* Let the operation run for a while since it was started or resumed,
+	 * which is when job->timeout was (re)started. No need to suspend it
+	 * if it completes meanwhile. */
+	while (timer_get_interval(job->timeout.start, timer_get_tick())
+			< MIN_RUN_AFTER_RESUME) {
+		if (!_qspiflash_is_ready(flash, &ready))
+			return false;
+		if (ready)
+			return true;
+	}
+
+	if (!_qspiflash_write_reg(flash, flash->opcode_suspend, NULL, 0))
+		return false;
+	job->suspended = true;
+
+	/* Wait for the suspend latency */
+	return qspiflash_wait_ready(flash, TIMEOUT_DEFAULT);
+}
+
+bool qspiflash_resume(const struct _qspiflash *flash)
+{
+	struct _qspiflash_job *job = flash->job;
+
+	if (!job || !job->suspended)
+		return true;
+
+	if (!_qspiflash_write_reg(flash, flash->opcode_resume, NULL, 0))
+		return false;
+	job->suspended = false;
+
+	/* The operation restarts, so does its timeout */
+	timer_start_timeout(&job->timeout, job->op == QSPIFLASH_JOB_ERASE ?
+			TIMEOUT_ERASE : TIMEOUT_WRITE);
+	return true;
+}
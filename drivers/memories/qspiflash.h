@@ -36,6 +36,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "timer.h"
 #include "memories/spi-nor.h"
 #include "peripherals/qspi.h"
 
@@ -43,8 +44,42 @@
  *        Local definitions
  *----------------------------------------------------------------------------*/
 
+/** Largest chunk programmed at once by asynchronous jobs */
+#define QSPIFLASH_JOB_PAGE_SIZE 256
+
+/** Asynchronous job operations */
+enum _qspiflash_job_op {
+	QSPIFLASH_JOB_ERASE,
+	QSPIFLASH_JOB_WRITE,
+};
+
 struct _qspiflash;
 
+/** Completion callback of an asynchronous job */
+typedef void (*qspiflash_callback_t)(struct _qspiflash *flash, bool success,
+		void *arg);
+
+/** Asynchronous erase or write job. Allocated by the caller, the fields are
+ * private to the driver. */
+struct _qspiflash_job {
+	uint8_t op;
+	volatile uint8_t state;
+	bool suspended;
+	uint32_t addr;
+	const uint8_t *data;
+	uint32_t length;
+	uint32_t done;           /*< bytes erased or programmed */
+	uint32_t count;          /*< bytes of the operation in progress */
+	uint32_t queued;         /*< bytes copied to the page buffers */
+	uint32_t next_addr;      /*< address of the prepared page buffer */
+	uint32_t next_len;       /*< data bytes in the prepared page buffer */
+	uint32_t next_size;      /*< size of the prepared page buffer */
+	uint8_t next_buf;        /*< index of the prepared page buffer */
+	struct _timeout timeout;
+	qspiflash_callback_t callback;
+	void *arg;
+};
+
 struct _qspiflash {
 	Qspi *qspi;
 	struct _spi_nor_desc desc;
@@ -57,6 +92,8 @@ struct _qspiflash {
 	uint8_t opcode_sector_erase;
 	uint8_t opcode_block_erase;
 	uint8_t opcode_block_erase_32k;
+	uint8_t opcode_suspend;
+	uint8_t opcode_resume;
 	bool mode_addr4;
 #ifdef CONFIG_HAVE_AESB
 	bool use_aesb;
@@ -65,6 +102,7 @@ struct _qspiflash {
 	uint8_t continuous_read_mode;
 	uint8_t num_mode_cycles;
 	uint8_t num_dummy_cycles;
+	struct _qspiflash_job *job;
 };
 
 /*----------------------------------------------------------------------------
@@ -87,6 +125,54 @@ extern bool qspiflash_erase_chip(const struct _qspiflash *flash);
 extern bool qspiflash_erase_block(const struct _qspiflash *flash, uint32_t addr, uint32_t length);
 extern bool qspiflash_write(const struct _qspiflash *flash, uint32_t addr, const void *data, uint32_t length);
 
+/**
+ * \brief Start erasing a range of the flash without waiting for completion.
+ *
+ * The range is erased with the largest blocks supported by the memory that
+ * fit its alignment. Progress is made by qspiflash_poll(), the callback is
+ * invoked from it at the end of the job.
+ */
+extern bool qspiflash_erase_async(struct _qspiflash *flash,
+		struct _qspiflash_job *job, uint32_t addr, uint32_t length,
+		qspiflash_callback_t callback, void *arg);
+
+/**
+ * \brief Start programming the flash without waiting for completion.
+ *
+ * Pages are copied to cache-aligned buffers and sent by DMA when available;
+ * the next page is prepared while the memory programs the current one. The
+ * data must stay valid until the callback is invoked.
+ */
+extern bool qspiflash_write_async(struct _qspiflash *flash,
+		struct _qspiflash_job *job, uint32_t addr, const void *data,
+		uint32_t length, qspiflash_callback_t callback, void *arg);
+
+/**
+ * \brief Make progress on the asynchronous job, to be called periodically.
+ */
+extern void qspiflash_poll(struct _qspiflash *flash);
+
+/**
+ * \brief Check whether an asynchronous job is in progress.
+ */
+extern bool qspiflash_is_busy(const struct _qspiflash *flash);
+
+/**
+ * \brief Suspend the program or erase operation in progress, so that the
+ * memory can be read. qspiflash_read() does it automatically.
+ *
+ * An operation is not suspended before it has run for a couple of timer
+ * ticks since it was started or resumed, so that frequent reads cannot
+ * starve it; the call waits for that time, or for the operation to complete.
+ */
+extern bool qspiflash_suspend(const struct _qspiflash *flash);
+
+/**
+ * \brief Resume a suspended program or erase operation. Continuous read
+ * mode (XIP) must have been left before.
+ */
+extern bool qspiflash_resume(const struct _qspiflash *flash);
+
 #ifdef __cplusplus
 }
 #endif
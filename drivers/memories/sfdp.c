@@ -0,0 +1,310 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "memories/sfdp.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local Definitions
+ *----------------------------------------------------------------------------*/
+
+/** "SFDP" signature, little-endian */
+#define SFDP_SIGNATURE     0x50444653u
+
+/** Parameter table IDs */
+#define SFDP_ID_BFPT       0xff00
+#define SFDP_ID_4BAIT      0xff84
+
+/** Largest number of parameter headers looked at */
+#define SFDP_MAX_HEADERS   16
+
+/** DWORDs of the BFPT decoded by the parser (JESD216B) */
+#define BFPT_DWORDS        16
+
+/** Standard instructions not described by the BFPT */
+#define CMD_FAST_READ      0x0b
+
+/** Extract bits [hi:lo] of a DWORD */
+#define BITS(dw, hi, lo)   (((dw) >> (lo)) & ((1u << ((hi) - (lo) + 1)) - 1))
+
+/*----------------------------------------------------------------------------
+ *        Local Functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _sfdp_get_dword(const uint8_t *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) |
+		((uint32_t)data[3] << 24);
+}
+
+/**
+ * \brief Read a parameter table into an array of DWORDs, the DWORDs not
+ * provided by the table are cleared.
+ */
+static bool _sfdp_read_table(sfdp_read_t read, void *arg, uint32_t addr,
+		uint32_t length, uint32_t *dwords, uint32_t count)
+{
+	uint8_t data[4 * BFPT_DWORDS];
+	unsigned i;
+
+	if (length > count)
+		length = count;
+
+	memset(dwords, 0, count * sizeof(*dwords));
+	if (!read(arg, addr, data, 4 * length))
+		return false;
+	for (i = 0; i < length; i++)
+		dwords[i] = _sfdp_get_dword(&data[4 * i]);
+
+	return true;
+}
+
+/**
+ * \brief Decode the fast read settings in one half of a BFPT DWORD.
+ */
+static void _sfdp_set_read(struct _sfdp *sfdp, enum _sfdp_proto proto,
+		uint32_t half)
+{
+	sfdp->protocols |= 1u << proto;
+	sfdp->read[proto].dummy_cycles = BITS(half, 4, 0);
+	sfdp->read[proto].mode_cycles = BITS(half, 7, 5);
+	sfdp->read[proto].opcode = BITS(half, 15, 8);
+}
+
+static bool _sfdp_parse_bfpt(struct _sfdp *sfdp, const uint32_t *bfpt,
+		uint32_t length)
+{
+	unsigned i;
+
+	/* JESD216 tables have at least 9 DWORDs */
+	if (length < 9)
+		return false;
+
+	/* DWORD 2: density */
+	if (bfpt[1] & (1u << 31)) {
+		uint32_t n = bfpt[1] & 0x7fffffff;
+		if (n < 3 || n > 34)
+			return false;
+		sfdp->size = 1u << (n - 3);
+	} else {
+		sfdp->size = (bfpt[1] >> 3) + 1;
+	}
+
+	/* DWORD 1: address bytes, DTR and supported fast reads */
+	sfdp->addr_bytes = BITS(bfpt[0], 18, 17);
+	sfdp->dtr = (bfpt[0] & (1u << 19)) != 0;
+
+	/* Fast Read 1-1-1 is mandatory, its settings are not described */
+	sfdp->protocols = 1u << SFDP_PROTO_1_1_1;
+	sfdp->read[SFDP_PROTO_1_1_1].opcode = CMD_FAST_READ;
+	sfdp->read[SFDP_PROTO_1_1_1].dummy_cycles = 8;
+
+	if (bfpt[0] & (1u << 21))
+		_sfdp_set_read(sfdp, SFDP_PROTO_1_4_4, bfpt[2]);
+	if (bfpt[0] & (1u << 22))
+		_sfdp_set_read(sfdp, SFDP_PROTO_1_1_4, bfpt[2] >> 16);
+	if (bfpt[0] & (1u << 16))
+		_sfdp_set_read(sfdp, SFDP_PROTO_1_1_2, bfpt[3]);
+	if (bfpt[0] & (1u << 20))
+		_sfdp_set_read(sfdp, SFDP_PROTO_1_2_2, bfpt[3] >> 16);
+	if (bfpt[4] & (1u << 0))
+		_sfdp_set_read(sfdp, SFDP_PROTO_2_2_2, bfpt[5] >> 16);
+	if (bfpt[4] & (1u << 4))
+		_sfdp_set_read(sfdp, SFDP_PROTO_4_4_4, bfpt[6] >> 16);
+
+	/* DWORDs 8-9: erase types */
+	for (i = 0; i < SFDP_ERASE_TYPES; i++) {
+		uint32_t type = bfpt[7 + i / 2] >> (16 * (i & 1));
+		uint32_t n = BITS(type, 7, 0);
+		if (n == 0 || n > 31)
+			continue;
+		sfdp->erase[i].size = 1u << n;
+		sfdp->erase[i].opcode = BITS(type, 15, 8);
+	}
+
+	/* The remaining DWORDs were added by JESD216A/B */
+	sfdp->page_size = 256;
+	if (length < 11)
+		return true;
+
+	/* DWORD 11: page size */
+	sfdp->page_size = 1u << BITS(bfpt[10], 7, 4);
+
+	/* DWORDs 12-13: suspend/resume */
+	if ((bfpt[11] & (1u << 31)) == 0 && bfpt[12] != 0) {
+		sfdp->suspend = true;
+		sfdp->opcode_program_resume = BITS(bfpt[12], 7, 0);
+		sfdp->opcode_program_suspend = BITS(bfpt[12], 15, 8);
+		sfdp->opcode_erase_resume = BITS(bfpt[12], 23, 16);
+		sfdp->opcode_erase_suspend = BITS(bfpt[12], 31, 24);
+	}
+
+	if (length < 15)
+		return true;
+
+	/* DWORD 15: quad enable and 0-4-4 mode entry */
+	sfdp->quad_enable = BITS(bfpt[14], 22, 20);
+	sfdp->continuous_read = (bfpt[14] & (1u << 9)) &&
+		(bfpt[14] & (1u << 16));
+
+	if (length < 16)
+		return true;
+
+	/* DWORD 16: 4-byte address mode entry */
+	sfdp->enter_4b = BITS(bfpt[15], 31, 24);
+
+	return true;
+}
+
+static void _sfdp_parse_4bait(struct _sfdp *sfdp, const uint32_t *table)
+{
+	unsigned i;
+
+	sfdp->instr_4b = table[0];
+	for (i = 0; i < SFDP_ERASE_TYPES; i++) {
+		if (sfdp->erase[i].size && (table[0] & SFDP_4BAIT_ERASE(i)))
+			sfdp->erase[i].opcode_4b = BITS(table[1], 8 * i + 7, 8 * i);
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+bool sfdp_parse(struct _sfdp *sfdp, sfdp_read_t read, void *arg)
+{
+	uint8_t header[8];
+	uint32_t bfpt_addr = 0, bfpt_len = 0;
+	uint32_t bait_addr = 0, bait_len = 0;
+	uint32_t table[BFPT_DWORDS];
+	unsigned i, nph;
+
+	memset(sfdp, 0, sizeof(*sfdp));
+
+	/* SFDP header: signature, revision, number of parameter headers */
+	if (!read(arg, 0, header, sizeof(header)))
+		return false;
+	if (_sfdp_get_dword(header) != SFDP_SIGNATURE || header[5] != 1)
+		return false;
+	nph = header[6] + 1;
+	if (nph > SFDP_MAX_HEADERS)
+		nph = SFDP_MAX_HEADERS;
+
+	/* Parameter headers: the last BFPT of major revision 1 is the most
+	 * recent one */
+	for (i = 0; i < nph; i++) {
+		uint16_t id;
+		uint32_t ptp;
+
+		if (!read(arg, 8 + 8 * i, header, sizeof(header)))
+			return false;
+		id = header[0] | (header[7] << 8);
+		ptp = header[4] | (header[5] << 8) | (header[6] << 16);
+
+		if (id == SFDP_ID_BFPT && header[2] == 1 && header[3]) {
+			bfpt_addr = ptp;
+			bfpt_len = header[3];
+			sfdp->major = header[2];
+			sfdp->minor = header[1];
+		} else if (id == SFDP_ID_4BAIT && header[3] >= 2) {
+			bait_addr = ptp;
+			bait_len = header[3];
+		}
+	}
+
+	if (bfpt_len == 0)
+		return false;
+
+	if (!_sfdp_read_table(read, arg, bfpt_addr, bfpt_len, table,
+				BFPT_DWORDS))
+		return false;
+	if (!_sfdp_parse_bfpt(sfdp, table, bfpt_len))
+		return false;
+
+	if (bait_len) {
+		if (!_sfdp_read_table(read, arg, bait_addr, bait_len, table, 2))
+			return false;
+		_sfdp_parse_4bait(sfdp, table);
+	}
+
+	return true;
+}
+
+enum _sfdp_proto sfdp_select_read(const struct _sfdp *sfdp, uint32_t allowed)
+{
+	int proto;
+
+	for (proto = SFDP_PROTO_COUNT - 1; proto >= 0; proto--) {
+		if (sfdp->protocols & allowed & (1u << proto))
+			return (enum _sfdp_proto)proto;
+	}
+
+	return SFDP_PROTO_COUNT;
+}
+
+void sfdp_get_spi_nor_desc(const struct _sfdp *sfdp, uint32_t jedec_id,
+		struct _spi_nor_desc *desc)
+{
+	unsigned i;
+
+	memset(desc, 0, sizeof(*desc));
+	desc->name = "SFDP";
+	desc->jedec_id = jedec_id;
+	desc->page_size = sfdp->page_size;
+	desc->size = sfdp->size;
+
+	for (i = 0; i < SFDP_ERASE_TYPES; i++) {
+		switch (sfdp->erase[i].size) {
+		case 4 * 1024:
+			desc->flags |= SPINOR_FLAG_ERASE_4K;
+			break;
+		case 32 * 1024:
+			desc->flags |= SPINOR_FLAG_ERASE_32K;
+			break;
+		case 64 * 1024:
+			desc->flags |= SPINOR_FLAG_ERASE_64K;
+			break;
+		case 256 * 1024:
+			desc->flags |= SPINOR_FLAG_ERASE_256K;
+			break;
+		}
+	}
+
+	if (sfdp->protocols & ((1u << SFDP_PROTO_1_1_4) | (1u << SFDP_PROTO_1_4_4)))
+		desc->flags |= SPINOR_FLAG_QUAD;
+
+	if (sfdp->size > (1u << 24) && !(sfdp->enter_4b & SFDP_4B_INSTR) &&
+	    !sfdp->instr_4b && (sfdp->enter_4b & (SFDP_4B_B7 | SFDP_4B_WREN_B7)))
+		desc->flags |= SPINOR_FLAG_ENTER_4B_MODE;
+}
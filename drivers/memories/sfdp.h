@@ -0,0 +1,186 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * JESD216 Serial Flash Discoverable Parameters (SFDP) parser.
+ *
+ * The parser only depends on a read callback and can be built on the host
+ * to decode captured SFDP dumps.
+ */
+
+#ifndef _SFDP_H
+#define _SFDP_H
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "memories/spi-nor.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Read SFDP instruction, 3-byte address followed by 8 dummy cycles */
+#define SFDP_CMD_READ            0x5a
+#define SFDP_READ_DUMMY_CYCLES   8
+
+/** Address bytes (BFPT DWORD 1 bits 18:17) */
+#define SFDP_ADDR_3              0 /* 3-byte only */
+#define SFDP_ADDR_3_OR_4         1 /* 3-byte by default, 4-byte on demand */
+#define SFDP_ADDR_4              2 /* 4-byte only */
+
+/** Quad Enable requirements (BFPT DWORD 15 bits 22:20) */
+#define SFDP_QER_NONE            0 /* no QE bit */
+#define SFDP_QER_SR2_BIT1_NO_RD  1 /* SR2 bit 1, written with 01h (2 bytes),
+                                      cleared by 1-byte 01h writes */
+#define SFDP_QER_SR1_BIT6        2 /* SR1 bit 6, written with 01h (1 byte) */
+#define SFDP_QER_SR2_BIT7        3 /* SR2 bit 7, read with 3Fh, written with 3Eh */
+#define SFDP_QER_SR2_BIT1_NO_CLR 4 /* SR2 bit 1, written with 01h (2 bytes) */
+#define SFDP_QER_SR2_BIT1        5 /* SR2 bit 1, read with 35h, written with 01h */
+#define SFDP_QER_SR2_BIT1_31H    6 /* SR2 bit 1, read with 35h, written with 31h */
+
+/** Methods to enter 4-byte address mode (BFPT DWORD 16 bits 31:24) */
+#define SFDP_4B_B7               (1u << 0) /* issue B7h */
+#define SFDP_4B_WREN_B7          (1u << 1) /* issue 06h then B7h */
+#define SFDP_4B_EAR              (1u << 2) /* extended address register */
+#define SFDP_4B_BANK             (1u << 3) /* bank register */
+#define SFDP_4B_NVCR             (1u << 4) /* non-volatile configuration */
+#define SFDP_4B_INSTR            (1u << 5) /* dedicated 4-byte instructions */
+#define SFDP_4B_ALWAYS           (1u << 6) /* always in 4-byte mode */
+
+/** Instructions of the 4-byte Address Instruction Table (DWORD 1) */
+#define SFDP_4BAIT_READ          (1u << 0)  /* 13h */
+#define SFDP_4BAIT_FAST_READ     (1u << 1)  /* 0Ch */
+#define SFDP_4BAIT_READ_1_1_2    (1u << 2)  /* 3Ch */
+#define SFDP_4BAIT_READ_1_2_2    (1u << 3)  /* BCh */
+#define SFDP_4BAIT_READ_1_1_4    (1u << 4)  /* 6Ch */
+#define SFDP_4BAIT_READ_1_4_4    (1u << 5)  /* ECh */
+#define SFDP_4BAIT_PP            (1u << 6)  /* 12h */
+#define SFDP_4BAIT_PP_1_1_4      (1u << 7)  /* 34h */
+#define SFDP_4BAIT_PP_1_4_4      (1u << 8)  /* 3Eh */
+#define SFDP_4BAIT_ERASE(n)      (1u << (9 + (n)))
+
+/** Number of erase types described by the BFPT */
+#define SFDP_ERASE_TYPES         4
+
+/** Read protocols (instruction-address-data widths), slowest first */
+enum _sfdp_proto {
+	SFDP_PROTO_1_1_1,
+	SFDP_PROTO_1_1_2,
+	SFDP_PROTO_1_2_2,
+	SFDP_PROTO_2_2_2,
+	SFDP_PROTO_1_1_4,
+	SFDP_PROTO_1_4_4,
+	SFDP_PROTO_4_4_4,
+	SFDP_PROTO_COUNT,
+};
+
+/** Read callback: read length bytes of the SFDP space from addr */
+typedef bool (*sfdp_read_t)(void *arg, uint32_t addr, void *data,
+		uint32_t length);
+
+/** Fast read instruction settings of a protocol */
+struct _sfdp_read {
+	uint8_t opcode;
+	uint8_t mode_cycles;
+	uint8_t dummy_cycles;
+};
+
+/** Erase type, size is 0 if the type is not used */
+struct _sfdp_erase {
+	uint32_t size;
+	uint8_t opcode;
+	uint8_t opcode_4b;       /*< 0 if not listed in the 4BAIT */
+};
+
+/** Parameters decoded from the SFDP tables */
+struct _sfdp {
+	uint8_t major;           /*< BFPT revision */
+	uint8_t minor;
+	uint32_t size;           /*< memory size in bytes */
+	uint32_t page_size;      /*< program page size in bytes */
+	uint8_t addr_bytes;      /*< SFDP_ADDR_xxx */
+	uint32_t protocols;      /*< mask of (1 << SFDP_PROTO_xxx) */
+	struct _sfdp_read read[SFDP_PROTO_COUNT];
+	struct _sfdp_erase erase[SFDP_ERASE_TYPES];
+	bool dtr;                /*< Double Transfer Rate clocking supported */
+	bool continuous_read;    /*< 0-4-4 mode entered with mode bits A5h */
+	uint8_t quad_enable;     /*< SFDP_QER_xxx */
+	uint8_t enter_4b;        /*< mask of SFDP_4B_xxx */
+	uint32_t instr_4b;       /*< mask of SFDP_4BAIT_xxx, 0 if no 4BAIT */
+	bool suspend;            /*< program/erase suspend supported */
+	uint8_t opcode_program_suspend;
+	uint8_t opcode_program_resume;
+	uint8_t opcode_erase_suspend;
+	uint8_t opcode_erase_resume;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Read and decode the SFDP header, the Basic Flash Parameter Table
+ * and the 4-byte Address Instruction Table if present.
+ * \param sfdp structure filled with the decoded parameters
+ * \param read function used to read the SFDP space
+ * \param arg argument of the read function
+ * \return true if a valid BFPT was found
+ */
+extern bool sfdp_parse(struct _sfdp *sfdp, sfdp_read_t read, void *arg);
+
+/**
+ * \brief Select the fastest read protocol among the allowed ones.
+ * \param allowed mask of (1 << SFDP_PROTO_xxx) usable by the controller
+ * \return the protocol, SFDP_PROTO_COUNT if none is supported
+ */
+extern enum _sfdp_proto sfdp_select_read(const struct _sfdp *sfdp,
+		uint32_t allowed);
+
+/**
+ * \brief Fill a SPI NOR descriptor (sizes, erase and quad flags) from the
+ * decoded parameters.
+ */
+extern void sfdp_get_spi_nor_desc(const struct _sfdp *sfdp, uint32_t jedec_id,
+		struct _spi_nor_desc *desc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SFDP_H */
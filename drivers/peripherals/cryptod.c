@@ -0,0 +1,1131 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Session-based front-end of the AES, TDES and SHA engines.
+ *
+ * A session reserves an engine from cryptod_init() to the completion of
+ * cryptod_final(). Data is fed by DMA from scatter-gather lists, each update
+ * being turned into a linked list of descriptors. Each engine owns two banks
+ * of descriptors: the second update is prepared while the first one is
+ * processed and is started from the DMA completion of the first one, so that
+ * back-to-back updates keep the engine busy.
+ *
+ * AES-GCM records use the same banks: the AAD is sent to the engine without
+ * output, followed by the text. The tag is generated by the engine (GTAGEN),
+ * the key and the hash subkey stay loaded across the records of a session, so
+ * that only the IV and the lengths are written between two records.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "compiler.h"
+#include "intmath.h"
+#include "mutex.h"
+
+#ifdef CONFIG_HAVE_AES
+#include "peripherals/aes.h"
+#endif
+#include "peripherals/cryptod.h"
+#include "peripherals/dma.h"
+#include "peripherals/pmc.h"
+#ifdef CONFIG_HAVE_SHA
+#include "peripherals/sha.h"
+#endif
+#ifdef CONFIG_HAVE_TDES
+#include "peripherals/tdes.h"
+#endif
+#include "misc/cache.h"
+
+#include "trace.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+/** Descriptors and completion of one update */
+struct _cryptod_bank {
+	struct dma_xfer_item tx[CRYPTOD_DESC_COUNT];
+	struct dma_xfer_item rx[CRYPTOD_DESC_COUNT];
+	/* parameters of the first descriptors */
+	struct dma_xfer_item_tmpl tx_tmpl;
+	struct dma_xfer_item_tmpl rx_tmpl;
+	/* regions written by the DMA, invalidated on completion */
+	struct {
+		void    *addr;
+		uint32_t len;
+	} out[CRYPTOD_DESC_COUNT];
+	uint8_t tx_count;
+	uint8_t rx_count;
+	bool last;
+	cryptod_callback_t callback;
+	void *cb_args;
+#ifdef CONFIG_HAVE_AES
+	/* AES-GCM record, NULL for other updates */
+	struct _cryptod_gcm_record *gcm;
+	uint32_t gcm_iv[4];  /* inc32(J0) */
+	uint32_t gcm_aad_len;
+	uint32_t gcm_text_len;
+	/* output bytes of the bounced blocks, copied back on completion */
+	struct {
+		const uint8_t *from;
+		uint8_t       *to;
+		uint32_t       len;
+	} scatter[2 * CRYPTOD_GCM_SPLIT_COUNT];
+	uint8_t scatter_count;
+#endif
+};
+
+struct _cryptod_engine {
+	/* bounce buffers for the last blocks of a session, placed first so
+	 * that they are aligned on cache lines. tail_out receives the blocks
+	 * of a cipher output past its last whole cache line. */
+	uint8_t tail_in[2 * CRYPTOD_MAX_BLOCK_SIZE];
+	uint8_t tail_out[CRYPTOD_MAX_BLOCK_SIZE];
+
+	struct _cryptod_bank bank[2];
+	volatile uint8_t head;    /* bank being processed */
+	volatile uint8_t queued;  /* banks started or waiting */
+
+	mutex_t mutex;
+	struct _cryptod_session *session;
+	struct dma_channel *tx_channel;
+	struct dma_channel *rx_channel;  /* NULL for hashes */
+	void *idata;
+	void *odata;
+	uint8_t chunk_size;
+
+	void *tail_dst;
+	uint32_t tail_len;
+
+	bool encrypt;
+	bool gcm;
+};
+
+#ifdef CONFIG_HAVE_AES
+/** Bounce buffers of the AES-GCM blocks straddling scatter-gather entries,
+ * one set per bank */
+struct _cryptod_gcm_buffers {
+	uint8_t in[2][CRYPTOD_GCM_SPLIT_COUNT][16];
+	uint8_t out[2][CRYPTOD_GCM_SPLIT_COUNT][16];
+};
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+static const uint8_t _block_size[] = {
+	[CRYPTOD_ALGO_AES] = 16,
+	[CRYPTOD_ALGO_TDES] = 8,
+	[CRYPTOD_ALGO_SHA1] = 64,
+	[CRYPTOD_ALGO_SHA224] = 64,
+	[CRYPTOD_ALGO_SHA256] = 64,
+	[CRYPTOD_ALGO_SHA384] = 128,
+	[CRYPTOD_ALGO_SHA512] = 128,
+};
+
+static const uint8_t _digest_size[] = {
+	[CRYPTOD_ALGO_AES] = 0,
+	[CRYPTOD_ALGO_TDES] = 0,
+	[CRYPTOD_ALGO_SHA1] = 20,
+	[CRYPTOD_ALGO_SHA224] = 28,
+	[CRYPTOD_ALGO_SHA256] = 32,
+	[CRYPTOD_ALGO_SHA384] = 48,
+	[CRYPTOD_ALGO_SHA512] = 64,
+};
+
+#ifdef CONFIG_HAVE_SHA
+static const uint8_t _sha_mode[] = {
+	[CRYPTOD_ALGO_SHA1] = SHA_1,
+	[CRYPTOD_ALGO_SHA224] = SHA_224,
+	[CRYPTOD_ALGO_SHA256] = SHA_256,
+	[CRYPTOD_ALGO_SHA384] = SHA_384,
+	[CRYPTOD_ALGO_SHA512] = SHA_512,
+};
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_HAVE_AES
+CACHE_ALIGNED static struct _cryptod_engine _aes_engine;
+CACHE_ALIGNED static struct _cryptod_gcm_buffers _gcm_buffers;
+
+/** GCM hash subkey of the current AES session */
+static uint8_t _gcm_h[16];
+#endif
+
+#ifdef CONFIG_HAVE_TDES
+CACHE_ALIGNED static struct _cryptod_engine _tdes_engine;
+#endif
+
+#ifdef CONFIG_HAVE_SHA
+CACHE_ALIGNED static struct _cryptod_engine _sha_engine;
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static bool _is_hash(enum _cryptod_algo algo)
+{
+	return algo >= CRYPTOD_ALGO_SHA1;
+}
+
+static struct _cryptod_engine *_get_engine(enum _cryptod_algo algo)
+{
+	switch (algo) {
+#ifdef CONFIG_HAVE_AES
+	case CRYPTOD_ALGO_AES:
+		return &_aes_engine;
+#endif
+#ifdef CONFIG_HAVE_TDES
+	case CRYPTOD_ALGO_TDES:
+		return &_tdes_engine;
+#endif
+#ifdef CONFIG_HAVE_SHA
+	case CRYPTOD_ALGO_SHA1:
+	case CRYPTOD_ALGO_SHA224:
+	case CRYPTOD_ALGO_SHA256:
+	case CRYPTOD_ALGO_SHA384:
+	case CRYPTOD_ALGO_SHA512:
+		return &_sha_engine;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static uint32_t _irq_save(void)
+{
+	uint32_t masked = cpsr_get() & CPSR_MASK_IRQ;
+
+	cpsr_set_bits(CPSR_MASK_IRQ);
+	return masked;
+}
+
+static void _irq_restore(uint32_t masked)
+{
+	if (!masked)
+		cpsr_clear_bits(CPSR_MASK_IRQ);
+}
+
+/**
+ * \brief Pad the last data of a message as per FIPS 180-4.
+ * \param block  Bounce buffer holding the rem last bytes of the message, with
+ * room for two blocks.
+ * \param rem  Number of message bytes in the bounce buffer.
+ * \param length  Size of the whole message, in bytes.
+ * \param block_size  Block size of the algorithm, in bytes.
+ * \return Size of the padded data, one or two blocks.
+ */
+static uint32_t _pad_message(uint8_t *block, uint32_t rem, uint32_t length,
+		uint32_t block_size)
+{
+	/* The length field is 64-bit for 512-bit blocks, 128-bit for
+	 * 1024-bit blocks, only its low 64 bits can be non-zero */
+	const uint32_t size = rem + 1 + block_size / 8 <= block_size ?
+		block_size : 2 * block_size;
+	const uint32_t bits_hi = length >> 29;
+	const uint32_t bits_lo = length << 3;
+	uint8_t i;
+
+	block[rem] = 0x80;
+	memset(block + rem + 1, 0, size - rem - 1);
+	for (i = 0; i < 4; i++) {
+		block[size - 1 - i] = (bits_lo >> (8 * i)) & 0xff;
+		block[size - 5 - i] = (bits_hi >> (8 * i)) & 0xff;
+	}
+	return size;
+}
+
+static void _bank_reset(struct _cryptod_bank *bank)
+{
+	bank->tx_count = 0;
+	bank->rx_count = 0;
+	bank->last = false;
+	bank->callback = NULL;
+	bank->cb_args = NULL;
+#ifdef CONFIG_HAVE_AES
+	bank->gcm = NULL;
+	bank->scatter_count = 0;
+#endif
+}
+
+/**
+ * \brief Append the descriptors transferring a buffer to/from the engine. The
+ * engine output is only read back if dst is not NULL.
+ * \return false if the bank has no room left.
+ */
+static bool _bank_add(struct _cryptod_engine *engine,
+		struct _cryptod_bank *bank, uint32_t block_size,
+		const uint8_t *src, uint8_t *dst, uint32_t len)
+{
+	const uint32_t block_words = block_size / 4;
+	const uint32_t max_words = DMA_MAX_BT_SIZE - DMA_MAX_BT_SIZE % block_words;
+	const bool output = engine->rx_channel && dst;
+	struct dma_xfer_item_tmpl tmpl;
+	uint32_t words = len / 4;
+	uint32_t chunk;
+	uint8_t i;
+
+	while (words) {
+		if (bank->tx_count >= CRYPTOD_DESC_COUNT ||
+		    (output && bank->rx_count >= CRYPTOD_DESC_COUNT))
+			return false;
+		i = bank->tx_count++;
+		chunk = min_u32(words, max_words);
+
+		/* Memory to engine */
+		memset(&tmpl, 0, sizeof(tmpl));
+		tmpl.sa = src;
+		tmpl.da = engine->idata;
+		tmpl.upd_sa_per_data = 1;
+		tmpl.upd_da_per_data = 0;
+		tmpl.upd_sa_per_blk = 1;
+		tmpl.upd_da_per_blk = 0;
+		tmpl.data_width = DMA_DATA_WIDTH_WORD;
+		tmpl.chunk_size = engine->chunk_size;
+		tmpl.blk_size = chunk;
+		dma_prepare_item(engine->tx_channel, &tmpl, &bank->tx[i]);
+		if (i == 0)
+			bank->tx_tmpl = tmpl;
+		cache_clean_region(src, chunk * 4);
+
+		/* Engine to memory */
+		if (output) {
+			i = bank->rx_count++;
+			tmpl.sa = engine->odata;
+			tmpl.da = dst;
+			tmpl.upd_sa_per_data = 0;
+			tmpl.upd_da_per_data = 1;
+			tmpl.upd_sa_per_blk = 0;
+			tmpl.upd_da_per_blk = 1;
+			dma_prepare_item(engine->rx_channel, &tmpl, &bank->rx[i]);
+			if (i == 0)
+				bank->rx_tmpl = tmpl;
+			/* Drop dirty lines that could be evicted over the
+			 * DMA output, after the source has been cleaned in
+			 * case of in-place processing */
+			cache_invalidate_region(dst, chunk * 4);
+			bank->out[i].addr = dst;
+			bank->out[i].len = chunk * 4;
+			dst += chunk * 4;
+		}
+
+		src += chunk * 4;
+		words -= chunk;
+	}
+	return true;
+}
+
+static void _cryptod_dma_callback(struct dma_channel *channel, void *arg);
+
+static void _bank_start(struct _cryptod_engine *engine,
+		struct _cryptod_bank *bank)
+{
+	const bool output = bank->rx_count != 0;
+	uint32_t rc = DMA_OK;
+
+#ifdef CONFIG_HAVE_AES
+	if (bank->gcm) {
+		aes_set_vector(bank->gcm_iv);
+		aes_set_aad_len(bank->gcm_aad_len);
+		aes_set_data_len(bank->gcm_text_len);
+	}
+#endif
+
+	/* Completion is reported by the channel finishing last: the output
+	 * one, unless the bank only feeds the engine (hashes, GCM AAD) */
+	if (engine->rx_channel) {
+		dma_set_callback(engine->tx_channel,
+				output ? NULL : _cryptod_dma_callback, engine);
+		dma_set_callback(engine->rx_channel,
+				output ? _cryptod_dma_callback : NULL, engine);
+	}
+
+	if (output) {
+		dma_configure_sg_transfer(engine->rx_channel, &bank->rx_tmpl,
+				bank->rx);
+		rc = dma_start_transfer(engine->rx_channel);
+	}
+	if (rc == DMA_OK) {
+		dma_configure_sg_transfer(engine->tx_channel, &bank->tx_tmpl,
+				bank->tx);
+		rc = dma_start_transfer(engine->tx_channel);
+	}
+	if (rc != DMA_OK)
+		trace_error("cryptod: couldn't start DMA transfer\r\n");
+}
+
+/**
+ * \brief Link the descriptors of a bank and start it, or leave it pending if
+ * the other bank is being processed.
+ */
+static void _bank_queue(struct _cryptod_engine *engine,
+		struct _cryptod_bank *bank)
+{
+	uint32_t masked;
+	uint8_t i;
+
+	for (i = 0; i < bank->tx_count; i++)
+		dma_link_item(engine->tx_channel, &bank->tx[i],
+			i + 1 < bank->tx_count ? &bank->tx[i + 1] : NULL);
+	for (i = 0; i < bank->rx_count; i++)
+		dma_link_item(engine->rx_channel, &bank->rx[i],
+			i + 1 < bank->rx_count ? &bank->rx[i + 1] : NULL);
+	/* CPU access to the descriptors is write-only, DMA access is
+	 * read-only, hence there is no need to invalidate */
+	cache_clean_region(bank->tx, bank->tx_count * sizeof(bank->tx[0]));
+	if (bank->rx_count)
+		cache_clean_region(bank->rx,
+				bank->rx_count * sizeof(bank->rx[0]));
+
+	masked = _irq_save();
+	engine->queued++;
+	if (engine->queued == 1)
+		_bank_start(engine, bank);
+	_irq_restore(masked);
+}
+
+/**
+ * \brief Read back the result of a session and release its engine.
+ */
+static void _finish_session(struct _cryptod_engine *engine)
+{
+	struct _cryptod_session *session = engine->session;
+
+#ifdef CONFIG_HAVE_SHA
+	if (_is_hash(session->algo)) {
+		uint32_t digest[CRYPTOD_MAX_DIGEST_SIZE / 4];
+
+		/* The DMA completes once the last block is written, wait
+		 * for its processing */
+		while (!(sha_get_status() & SHA_ISR_DATRDY));
+		sha_get_output(digest);
+		memcpy(engine->tail_dst, digest, _digest_size[session->algo]);
+	} else
+#endif
+	if (engine->tail_len)
+		memcpy(engine->tail_dst, engine->tail_out, engine->tail_len);
+
+	session->active = false;
+	mutex_unlock(&engine->mutex);
+}
+
+#ifdef CONFIG_HAVE_AES
+/**
+ * \brief Multiply x by h in GF(2^128), as per NIST SP 800-38D.
+ */
+static void _gf128_mul(uint8_t *x, const uint8_t *h)
+{
+	uint8_t z[16], v[16];
+	uint8_t i, j, lsb;
+
+	memset(z, 0, sizeof(z));
+	memcpy(v, h, sizeof(v));
+	for (i = 0; i < 128; i++) {
+		if (x[i >> 3] & (0x80 >> (i & 7)))
+			for (j = 0; j < 16; j++)
+				z[j] ^= v[j];
+		/* v = v * x, reduced by R = 11100001 || 0^120 */
+		lsb = v[15] & 1;
+		for (j = 15; j > 0; j--)
+			v[j] = (v[j] >> 1) | (v[j - 1] << 7);
+		v[0] >>= 1;
+		if (lsb)
+			v[0] ^= 0xe1;
+	}
+	memcpy(x, z, sizeof(z));
+}
+
+/**
+ * \brief Compute inc32(J0), the first counter block of a GCM record. 96-bit
+ * IVs are used as is, other lengths are hashed in software with the session
+ * hash subkey, once per record.
+ */
+static void _gcm_get_counter(const uint8_t *iv, uint32_t iv_len, uint32_t *ctr)
+{
+	const uint32_t bits_hi = iv_len >> 29;
+	const uint32_t bits_lo = iv_len << 3;
+	uint8_t j0[16];
+	uint32_t n, count;
+	uint8_t i;
+
+	if (iv_len == 12) {
+		memcpy(j0, iv, 12);
+		j0[12] = j0[13] = j0[14] = 0;
+		j0[15] = 1;
+	} else {
+		/* J0 = GHASH(IV || 0^s || 0^64 || [len(IV)]64) */
+		memset(j0, 0, sizeof(j0));
+		while (iv_len) {
+			n = min_u32(iv_len, 16);
+			for (i = 0; i < n; i++)
+				j0[i] ^= iv[i];
+			_gf128_mul(j0, _gcm_h);
+			iv += n;
+			iv_len -= n;
+		}
+		for (i = 0; i < 4; i++) {
+			j0[15 - i] ^= (bits_lo >> (8 * i)) & 0xff;
+			j0[11 - i] ^= (bits_hi >> (8 * i)) & 0xff;
+		}
+		_gf128_mul(j0, _gcm_h);
+	}
+
+	/* inc32() on the big-endian low word */
+	count = ((uint32_t)j0[12] << 24) | ((uint32_t)j0[13] << 16) |
+		((uint32_t)j0[14] << 8) | j0[15];
+	count++;
+	for (i = 0; i < 4; i++)
+		j0[15 - i] = (count >> (8 * i)) & 0xff;
+	memcpy(ctr, j0, sizeof(j0));
+}
+
+/**
+ * \brief Size of the run of whole blocks of an output entry that can be
+ * written in place from dst + pos. The cache lines of the run are
+ * invalidated, they shall not hold bytes outside the entry, whose blocks in
+ * these lines are bounced and copied back after the invalidation.
+ * \return the size of the run, 0 if the block at pos is to be bounced.
+ */
+static uint32_t _gcm_run_len(const uint8_t *dst, uint32_t pos, uint32_t len)
+{
+	const uint32_t mask = L1_CACHE_BYTES - 1;
+	const uint32_t first = (uint32_t)dst;
+	const uint32_t start = first + pos;
+	uint32_t end = start + ((len - pos) & ~15u);
+
+	if ((start & ~mask) < first)
+		return 0;
+	/* Stop before the last line if it extends past the entry */
+	if (((end + mask) & ~mask) > first + len) {
+		if ((end & ~mask) <= start)
+			return 0;
+		end = start + (((end & ~mask) - start) & ~15u);
+	}
+	return end - start;
+}
+
+/**
+ * \brief Append the descriptors of a GCM list to a bank. Word-aligned runs of
+ * whole blocks are transferred in place, the blocks straddling entries,
+ * unaligned or sharing a cache line with data outside an output entry are
+ * gathered in bounce buffers, and the list ends with a zero-padded block.
+ * \param output  true for the text, whose output is read back.
+ * \param slot  Next free bounce buffer of the bank.
+ * \return false if the bank runs out of descriptors or bounce buffers.
+ */
+static bool _gcm_add_list(struct _cryptod_engine *engine,
+		struct _cryptod_bank *bank, const struct _cryptod_sg *sg,
+		uint32_t sg_count, bool output, uint8_t *slot)
+{
+	const uint8_t index = bank == &engine->bank[0] ? 0 : 1;
+	uint8_t *in = NULL;
+	uint8_t *out = NULL;
+	uint32_t i, pos, n, carry = 0;
+
+	for (i = 0; i < sg_count; i++) {
+		const uint8_t *src = (const uint8_t*)sg[i].src;
+		uint8_t *dst = output ? (uint8_t*)sg[i].dst : NULL;
+		const uint32_t len = sg[i].len;
+
+		if (len && (!src || (output && !dst)))
+			return false;
+		for (pos = 0; pos < len; pos += n) {
+			n = 0;
+			if (!carry && len - pos >= 16 &&
+			    !((uint32_t)(src + pos) & 3) &&
+			    (!output || !((uint32_t)(dst + pos) & 3)))
+				n = output ? _gcm_run_len(dst, pos, len) :
+					(len - pos) & ~15u;
+			if (n) {
+				if (!_bank_add(engine, bank, 16, src + pos,
+						output ? dst + pos : NULL, n))
+					return false;
+				continue;
+			}
+
+			if (!carry) {
+				if (*slot >= CRYPTOD_GCM_SPLIT_COUNT)
+					return false;
+				in = _gcm_buffers.in[index][*slot];
+				out = _gcm_buffers.out[index][*slot];
+				(*slot)++;
+			}
+			n = min_u32(16 - carry, len - pos);
+			memcpy(in + carry, src + pos, n);
+			if (output) {
+				uint8_t k = bank->scatter_count;
+				if (k >= ARRAY_SIZE(bank->scatter))
+					return false;
+				bank->scatter[k].from = out + carry;
+				bank->scatter[k].to = dst + pos;
+				bank->scatter[k].len = n;
+				bank->scatter_count++;
+			}
+			carry += n;
+			if (carry == 16) {
+				if (!_bank_add(engine, bank, 16, in,
+						output ? out : NULL, 16))
+					return false;
+				carry = 0;
+			}
+		}
+	}
+
+	if (carry) {
+		memset(in + carry, 0, 16 - carry);
+		if (!_bank_add(engine, bank, 16, in, output ? out : NULL, 16))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * \brief Read back the tag of a completed GCM record, check it on decryption
+ * and copy the bounced output to the user buffers.
+ */
+static void _gcm_complete(struct _cryptod_engine *engine,
+		struct _cryptod_bank *bank)
+{
+	struct _cryptod_gcm_record *record = bank->gcm;
+	uint32_t tag[4];
+	uint8_t i, diff = 0;
+
+	for (i = 0; i < bank->scatter_count; i++)
+		memcpy(bank->scatter[i].to, bank->scatter[i].from,
+				bank->scatter[i].len);
+
+	/* The DMA completes once the last block is written (AAD only) or
+	 * read, wait for the tag */
+	while (!(aes_get_status() & AES_ISR_TAGRDY));
+	aes_get_gcm_tag(tag);
+
+	if (engine->encrypt) {
+		memcpy(record->tag, tag, record->tag_len);
+		record->status = CRYPTOD_SUCCESS;
+	} else {
+		/* Constant-time comparison */
+		for (i = 0; i < record->tag_len; i++)
+			diff |= ((uint8_t*)tag)[i] ^ record->tag[i];
+		record->status = diff ? CRYPTOD_ERROR_AUTH : CRYPTOD_SUCCESS;
+	}
+}
+#endif /* CONFIG_HAVE_AES */
+
+static void _cryptod_dma_callback(struct dma_channel *channel, void *arg)
+{
+	struct _cryptod_engine *engine = (struct _cryptod_engine*)arg;
+	struct _cryptod_bank *bank = &engine->bank[engine->head];
+	cryptod_callback_t callback = bank->callback;
+	void *cb_args = bank->cb_args;
+	uint8_t i;
+
+	(void)channel;
+
+	dma_stop_transfer(engine->tx_channel);
+	if (engine->rx_channel)
+		dma_stop_transfer(engine->rx_channel);
+	for (i = 0; i < bank->rx_count; i++)
+		cache_invalidate_region(bank->out[i].addr, bank->out[i].len);
+
+#ifdef CONFIG_HAVE_AES
+	if (bank->gcm)
+		_gcm_complete(engine, bank);
+#endif
+
+	if (bank->last)
+		_finish_session(engine);
+
+	/* Start the pending update before notifying this one */
+	engine->head ^= 1;
+	engine->queued--;
+	if (engine->queued)
+		_bank_start(engine, &engine->bank[engine->head]);
+
+	if (callback)
+		callback(cb_args);
+}
+
+/**
+ * \brief Allocate the DMA channels of an engine on first use.
+ */
+static bool _setup_dma(struct _cryptod_engine *engine, uint32_t id,
+		bool output)
+{
+	if (!engine->tx_channel) {
+		engine->tx_channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
+		if (!engine->tx_channel)
+			return false;
+	}
+	if (output && !engine->rx_channel) {
+		engine->rx_channel = dma_allocate_channel(id, DMA_PERIPH_MEMORY);
+		if (!engine->rx_channel)
+			return false;
+	}
+	/* Engines with an output have their callbacks set per bank */
+	if (!output)
+		dma_set_callback(engine->tx_channel, _cryptod_dma_callback,
+				engine);
+	return true;
+}
+
+#ifdef CONFIG_HAVE_AES
+static uint32_t _aes_start(struct _cryptod_engine *engine,
+		const struct _cryptod_cfg *cfg)
+{
+	static const uint32_t opmod[] = {
+		[CRYPTOD_MODE_ECB] = AES_MR_OPMOD_ECB,
+		[CRYPTOD_MODE_CBC] = AES_MR_OPMOD_CBC,
+		[CRYPTOD_MODE_OFB] = AES_MR_OPMOD_OFB,
+		[CRYPTOD_MODE_CFB] = AES_MR_OPMOD_CFB,
+		[CRYPTOD_MODE_CTR] = AES_MR_OPMOD_CTR,
+		[CRYPTOD_MODE_GCM] = AES_MR_OPMOD_GCM | AES_MR_GTAGEN,
+	};
+	uint32_t words[8];
+
+	if (cfg->key_len != 16 && cfg->key_len != 24 && cfg->key_len != 32)
+		return CRYPTOD_INVALID_PARAM;
+	if (cfg->mode > CRYPTOD_MODE_GCM)
+		return CRYPTOD_INVALID_PARAM;
+	if (!_setup_dma(engine, ID_AES, true))
+		return CRYPTOD_ERROR_TRANSFER;
+
+	engine->idata = (void*)&AES->AES_IDATAR[0];
+	engine->odata = (void*)&AES->AES_ODATAR[0];
+	engine->chunk_size = DMA_CHUNK_SIZE_4;
+
+	pmc_enable_peripheral(ID_AES);
+	aes_soft_reset();
+	aes_configure((cfg->encrypt ? AES_MR_CIPHER_ENCRYPT :
+				AES_MR_CIPHER_DECRYPT)
+			| AES_MR_SMOD_IDATAR0_START
+			| ((cfg->key_len / 8 - 2) << AES_MR_KEYSIZE_Pos)
+			| opmod[cfg->mode]
+			| AES_MR_CKEY_PASSWD);
+	memcpy(words, cfg->key, cfg->key_len);
+	aes_write_key(words, cfg->key_len);
+	if (cfg->mode == CRYPTOD_MODE_GCM) {
+		/* The engine computes H = E(K, 0^128) once the key is
+		 * written, it is kept for the IVs that are not 96-bit */
+		while (!(aes_get_status() & AES_ISR_DATRDY));
+		aes_get_gcm_hash_subkey(words);
+		memcpy(_gcm_h, words, 16);
+	} else if (cfg->mode != CRYPTOD_MODE_ECB) {
+		memcpy(words, cfg->iv, 16);
+		aes_set_vector(words);
+	}
+	return CRYPTOD_SUCCESS;
+}
+#endif /* CONFIG_HAVE_AES */
+
+#ifdef CONFIG_HAVE_TDES
+static uint32_t _tdes_start(struct _cryptod_engine *engine,
+		const struct _cryptod_cfg *cfg)
+{
+	static const uint32_t opmod[] = {
+		[CRYPTOD_MODE_ECB] = TDES_MR_OPMOD_ECB,
+		[CRYPTOD_MODE_CBC] = TDES_MR_OPMOD_CBC,
+		[CRYPTOD_MODE_OFB] = TDES_MR_OPMOD_OFB,
+		[CRYPTOD_MODE_CFB] = TDES_MR_OPMOD_CFB,
+	};
+	uint32_t words[6];
+	uint32_t algo;
+
+	if (cfg->key_len == 8)
+		algo = TDES_MR_TDESMOD(MODE_SINGLE_DES);
+	else if (cfg->key_len == 16)
+		algo = TDES_MR_TDESMOD(MODE_TRIPLE_DES) | TDES_MR_KEYMOD;
+	else if (cfg->key_len == 24)
+		algo = TDES_MR_TDESMOD(MODE_TRIPLE_DES);
+	else
+		return CRYPTOD_INVALID_PARAM;
+	if (cfg->mode > CRYPTOD_MODE_CFB)
+		return CRYPTOD_INVALID_PARAM;
+	if (!_setup_dma(engine, ID_TDES, true))
+		return CRYPTOD_ERROR_TRANSFER;
+
+	engine->idata = (void*)&TDES->TDES_IDATAR[0];
+	engine->odata = (void*)&TDES->TDES_ODATAR[0];
+	engine->chunk_size = DMA_CHUNK_SIZE_1;
+
+	pmc_enable_peripheral(ID_TDES);
+	tdes_soft_reset();
+	tdes_configure((cfg->encrypt ? TDES_MR_CIPHER_ENCRYPT :
+				TDES_MR_CIPHER_DECRYPT)
+			| TDES_MR_SMOD_IDATAR0_START
+			| algo
+			| opmod[cfg->mode]);
+	memcpy(words, cfg->key, cfg->key_len);
+	tdes_write_key1(words[0], words[1]);
+	if (cfg->key_len >= 16)
+		tdes_write_key2(words[2], words[3]);
+	if (cfg->key_len == 24)
+		tdes_write_key3(words[4], words[5]);
+	if (cfg->mode != CRYPTOD_MODE_ECB) {
+		memcpy(words, cfg->iv, 8);
+		tdes_set_vector(words[0], words[1]);
+	}
+	return CRYPTOD_SUCCESS;
+}
+#endif /* CONFIG_HAVE_TDES */
+
+#ifdef CONFIG_HAVE_SHA
+static uint32_t _sha_start(struct _cryptod_engine *engine,
+		const struct _cryptod_cfg *cfg)
+{
+	const uint8_t mode = _sha_mode[cfg->algo];
+
+	if (!_setup_dma(engine, ID_SHA, false))
+		return CRYPTOD_ERROR_TRANSFER;
+
+	engine->idata = (void*)&SHA->SHA_IDATAR[0];
+	engine->odata = NULL;
+	engine->chunk_size = sha_get_dma_chunk_size(mode);
+
+	pmc_enable_peripheral(ID_SHA);
+	sha_soft_reset();
+	/* The dual input buffer lets the DMA load the next block while the
+	 * current one is processed */
+	sha_configure(SHA_MR_SMOD_IDATAR0_START
+			| SHA_MR_PROCDLY_SHORTEST
+			| SHA_MR_DUALBUFF_ACTIVE
+			| (mode << SHA_MR_ALGO_Pos));
+	sha_first_block();
+	return CRYPTOD_SUCCESS;
+}
+#endif /* CONFIG_HAVE_SHA */
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint32_t cryptod_init(struct _cryptod_session *session,
+		const struct _cryptod_cfg *cfg)
+{
+	struct _cryptod_engine *engine;
+	uint32_t rc = CRYPTOD_INVALID_PARAM;
+
+	assert(session);
+	assert(cfg);
+
+	engine = _get_engine(cfg->algo);
+	if (!engine)
+		return CRYPTOD_INVALID_PARAM;
+	if (!_is_hash(cfg->algo)) {
+		if (!cfg->key)
+			return CRYPTOD_INVALID_PARAM;
+		if (cfg->mode != CRYPTOD_MODE_ECB &&
+		    cfg->mode != CRYPTOD_MODE_GCM && !cfg->iv)
+			return CRYPTOD_INVALID_PARAM;
+	}
+
+	if (!mutex_try_lock(&engine->mutex))
+		return CRYPTOD_ERROR_LOCK;
+
+	switch (cfg->algo) {
+#ifdef CONFIG_HAVE_AES
+	case CRYPTOD_ALGO_AES:
+		rc = _aes_start(engine, cfg);
+		break;
+#endif
+#ifdef CONFIG_HAVE_TDES
+	case CRYPTOD_ALGO_TDES:
+		rc = _tdes_start(engine, cfg);
+		break;
+#endif
+#ifdef CONFIG_HAVE_SHA
+	case CRYPTOD_ALGO_SHA1:
+	case CRYPTOD_ALGO_SHA224:
+	case CRYPTOD_ALGO_SHA256:
+	case CRYPTOD_ALGO_SHA384:
+	case CRYPTOD_ALGO_SHA512:
+		rc = _sha_start(engine, cfg);
+		break;
+#endif
+	default:
+		break;
+	}
+	if (rc != CRYPTOD_SUCCESS) {
+		mutex_unlock(&engine->mutex);
+		return rc;
+	}
+
+	session->algo = cfg->algo;
+	session->engine = engine;
+	session->length = 0;
+	session->block_size = _block_size[cfg->algo];
+	session->stream = !_is_hash(cfg->algo) &&
+		cfg->mode != CRYPTOD_MODE_ECB && cfg->mode != CRYPTOD_MODE_CBC &&
+		cfg->mode != CRYPTOD_MODE_GCM;
+	session->active = true;
+
+	engine->session = session;
+	engine->encrypt = cfg->encrypt;
+	engine->gcm = !_is_hash(cfg->algo) && cfg->mode == CRYPTOD_MODE_GCM;
+	engine->head = 0;
+	engine->queued = 0;
+	engine->tail_dst = NULL;
+	engine->tail_len = 0;
+	return CRYPTOD_SUCCESS;
+}
+
+uint32_t cryptod_update(struct _cryptod_session *session,
+		const struct _cryptod_sg *sg, uint32_t sg_count,
+		cryptod_callback_t cb, void *user_args)
+{
+	struct _cryptod_engine *engine;
+	struct _cryptod_bank *bank;
+	uint32_t i, length = 0;
+
+	assert(session);
+
+	if (!session->active || !sg || !sg_count)
+		return CRYPTOD_INVALID_PARAM;
+	engine = session->engine;
+	if (engine->gcm)
+		return CRYPTOD_INVALID_PARAM;
+	if (engine->queued >= 2)
+		return CRYPTOD_ERROR_BUSY;
+
+	/* Only the thread queues updates, so the free bank cannot change
+	 * under our feet: if the other bank completes meanwhile, this one
+	 * simply becomes the head */
+	bank = &engine->bank[(engine->head + engine->queued) & 1];
+	_bank_reset(bank);
+	for (i = 0; i < sg_count; i++) {
+		/* The output lines are invalidated, they shall not hold
+		 * other data */
+		if ((sg[i].len % session->block_size) ||
+		    ((uint32_t)sg[i].src & 3) ||
+		    (engine->rx_channel &&
+		     (((uint32_t)sg[i].dst | sg[i].len) &
+		      (L1_CACHE_BYTES - 1))))
+			return CRYPTOD_INVALID_PARAM;
+		if (!_bank_add(engine, bank, session->block_size,
+				(const uint8_t*)sg[i].src, (uint8_t*)sg[i].dst,
+				sg[i].len))
+			return CRYPTOD_INVALID_PARAM;
+		length += sg[i].len;
+	}
+	if (!bank->tx_count)
+		return CRYPTOD_INVALID_PARAM;
+
+	bank->callback = cb;
+	bank->cb_args = user_args;
+	session->length += length;
+	_bank_queue(engine, bank);
+	return CRYPTOD_SUCCESS;
+}
+
+uint32_t cryptod_final(struct _cryptod_session *session,
+		const void *src, void *out, uint32_t len,
+		cryptod_callback_t cb, void *user_args)
+{
+	struct _cryptod_engine *engine;
+	struct _cryptod_bank *bank;
+	const uint8_t *data = (const uint8_t*)src;
+	uint32_t block_size, whole, rem, direct;
+
+	assert(session);
+
+	if (!session->active || (len && !src) || ((uint32_t)src & 3))
+		return CRYPTOD_INVALID_PARAM;
+	engine = session->engine;
+	if (engine->gcm && len)
+		return CRYPTOD_INVALID_PARAM;
+	block_size = session->block_size;
+	whole = len - len % block_size;
+	rem = len - whole;
+	if (rem && !_is_hash(session->algo) && !session->stream)
+		return CRYPTOD_INVALID_PARAM;
+	if ((len || _is_hash(session->algo)) && !out)
+		return CRYPTOD_INVALID_PARAM;
+	/* Ciphers write the whole cache lines of the output directly, the
+	 * blocks of the last partial line go through the bounce buffers */
+	direct = engine->rx_channel ? whole & ~(L1_CACHE_BYTES - 1) : whole;
+	if (direct && engine->rx_channel &&
+	    ((uint32_t)out & (L1_CACHE_BYTES - 1)))
+		return CRYPTOD_INVALID_PARAM;
+	if (engine->queued >= 2)
+		return CRYPTOD_ERROR_BUSY;
+
+	bank = &engine->bank[(engine->head + engine->queued) & 1];
+	_bank_reset(bank);
+
+	if (direct && !_bank_add(engine, bank, block_size, data,
+				(uint8_t*)out, direct))
+		return CRYPTOD_INVALID_PARAM;
+
+	if (_is_hash(session->algo)) {
+		/* Pad the remaining bytes in the bounce buffer */
+		const uint32_t length = session->length + len;
+		uint32_t size;
+
+		memcpy(engine->tail_in, data + whole, rem);
+		size = _pad_message(engine->tail_in, rem, length, block_size);
+		if (!_bank_add(engine, bank, block_size, engine->tail_in,
+				NULL, size))
+			return CRYPTOD_INVALID_PARAM;
+		engine->tail_dst = out;
+		engine->tail_len = 0;
+	} else if (len > direct) {
+		/* Process the last blocks through the bounce buffers, the
+		 * stream modes only use the first bytes of a partial block */
+		const uint32_t tail = len - direct;
+		const uint32_t size = tail + (rem ? block_size - rem : 0);
+
+		memset(engine->tail_in, 0, size);
+		memcpy(engine->tail_in, data + direct, tail);
+		if (!_bank_add(engine, bank, block_size, engine->tail_in,
+				engine->tail_out, size))
+			return CRYPTOD_INVALID_PARAM;
+		engine->tail_dst = (uint8_t*)out + direct;
+		engine->tail_len = tail;
+	} else {
+		engine->tail_len = 0;
+	}
+	session->length += len;
+
+	if (!bank->tx_count) {
+		/* Cipher session ended without data: complete it once the
+		 * pending updates are over */
+		cryptod_wait(session);
+		_finish_session(engine);
+		if (cb)
+			cb(user_args);
+		return CRYPTOD_SUCCESS;
+	}
+
+	bank->last = true;
+	bank->callback = cb;
+	bank->cb_args = user_args;
+	_bank_queue(engine, bank);
+	return CRYPTOD_SUCCESS;
+}
+
+uint32_t cryptod_gcm_queue(struct _cryptod_session *session,
+		struct _cryptod_gcm_record *record,
+		cryptod_callback_t cb, void *user_args)
+{
+#ifdef CONFIG_HAVE_AES
+	struct _cryptod_engine *engine;
+	struct _cryptod_bank *bank;
+	uint32_t i, aad_len = 0, text_len = 0;
+	uint8_t slot = 0;
+
+	assert(session);
+	assert(record);
+
+	if (!session->active || !session->engine->gcm)
+		return CRYPTOD_INVALID_PARAM;
+	if (!record->iv || !record->iv_len || !record->tag ||
+	    record->tag_len < 4 || record->tag_len > 16)
+		return CRYPTOD_INVALID_PARAM;
+	if ((record->aad_count && !record->aad) ||
+	    (record->text_count && !record->text))
+		return CRYPTOD_INVALID_PARAM;
+	for (i = 0; i < record->aad_count; i++)
+		aad_len += record->aad[i].len;
+	for (i = 0; i < record->text_count; i++)
+		text_len += record->text[i].len;
+	if (!aad_len && !text_len)
+		return CRYPTOD_INVALID_PARAM;
+	engine = session->engine;
+	if (engine->queued >= 2)
+		return CRYPTOD_ERROR_BUSY;
+
+	bank = &engine->bank[(engine->head + engine->queued) & 1];
+	_bank_reset(bank);
+	if (!_gcm_add_list(engine, bank, record->aad, record->aad_count,
+			false, &slot))
+		return CRYPTOD_INVALID_PARAM;
+	if (!_gcm_add_list(engine, bank, record->text, record->text_count,
+			true, &slot))
+		return CRYPTOD_INVALID_PARAM;
+
+	_gcm_get_counter(record->iv, record->iv_len, bank->gcm_iv);
+	bank->gcm_aad_len = aad_len;
+	bank->gcm_text_len = text_len;
+	bank->gcm = record;
+	bank->callback = cb;
+	bank->cb_args = user_args;
+	record->status = CRYPTOD_ERROR_BUSY;
+	session->length += text_len;
+	_bank_queue(engine, bank);
+	return CRYPTOD_SUCCESS;
+#else
+	(void)session;
+	(void)record;
+	(void)cb;
+	(void)user_args;
+	return CRYPTOD_INVALID_PARAM;
+#endif
+}
+
+bool cryptod_is_busy(struct _cryptod_session *session)
+{
+	assert(session);
+
+	if (!session->engine || session->engine->session != session)
+		return false;
+	return session->engine->queued != 0;
+}
+
+void cryptod_wait(struct _cryptod_session *session)
+{
+	while (cryptod_is_busy(session))
+		dma_poll();
+}
+
+uint32_t cryptod_get_block_size(enum _cryptod_algo algo)
+{
+	if ((uint32_t)algo >= ARRAY_SIZE(_block_size))
+		return 0;
+	return _block_size[algo];
+}
+
+uint32_t cryptod_get_digest_size(enum _cryptod_algo algo)
+{
+	if ((uint32_t)algo >= ARRAY_SIZE(_digest_size))
+		return 0;
+	return _digest_size[algo];
+}
@@ -0,0 +1,236 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef CRYPTOD_HEADER__
+#define CRYPTOD_HEADER__
+
+/*------------------------------------------------------------------------------
+ *        Header
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+#define CRYPTOD_SUCCESS         (0)
+#define CRYPTOD_INVALID_PARAM   (1)
+#define CRYPTOD_ERROR_LOCK      (2)
+#define CRYPTOD_ERROR_BUSY      (3)
+#define CRYPTOD_ERROR_TRANSFER  (4)
+#define CRYPTOD_ERROR_AUTH      (5)
+
+/** Maximum number of DMA descriptors for one update, each scatter-gather
+ * entry using one descriptor per DMA_MAX_BT_SIZE words */
+#define CRYPTOD_DESC_COUNT      8
+
+/** Maximum number of AES-GCM blocks straddling scatter-gather entries in
+ * one record, gathered in bounce buffers */
+#define CRYPTOD_GCM_SPLIT_COUNT 8
+
+/** Largest block size of the supported algorithms, in bytes */
+#define CRYPTOD_MAX_BLOCK_SIZE  128
+
+/** Largest digest size of the supported algorithms, in bytes */
+#define CRYPTOD_MAX_DIGEST_SIZE 64
+
+typedef void (*cryptod_callback_t)(void* args);
+
+enum _cryptod_algo {
+	CRYPTOD_ALGO_AES,
+	CRYPTOD_ALGO_TDES,
+	CRYPTOD_ALGO_SHA1,
+	CRYPTOD_ALGO_SHA224,
+	CRYPTOD_ALGO_SHA256,
+	CRYPTOD_ALGO_SHA384,
+	CRYPTOD_ALGO_SHA512,
+};
+
+enum _cryptod_mode {
+	CRYPTOD_MODE_ECB,
+	CRYPTOD_MODE_CBC,
+	CRYPTOD_MODE_OFB,
+	CRYPTOD_MODE_CFB,
+	CRYPTOD_MODE_CTR, /* AES only, 16-bit internal counter */
+	CRYPTOD_MODE_GCM, /* AES only, see cryptod_gcm_queue() */
+};
+
+/** Session parameters */
+struct _cryptod_cfg {
+	enum _cryptod_algo algo;
+	/* following fields are used by ciphers only */
+	enum _cryptod_mode mode;
+	bool encrypt;
+	const uint8_t *key;  /* AES: 16/24/32 bytes, TDES: 8 (DES) or 16/24 */
+	uint8_t key_len;
+	const uint8_t *iv;   /* AES: 16 bytes, TDES: 8 bytes, unused for ECB and
+	                      * GCM */
+};
+
+/** Scatter-gather entry. The source shall be word-aligned. The destination
+ * is invalidated from the cache: it shall start on a cache line and its
+ * length shall be a multiple of L1_CACHE_BYTES. The length shall be a
+ * multiple of the block size of the algorithm. */
+struct _cryptod_sg {
+	const void *src;
+	void       *dst;  /* ignored by hashes */
+	uint32_t    len;  /* in bytes */
+};
+
+/** AES-GCM record: authenticated encryption or decryption of one message
+ * with its own IV. Entries of the aad and text lists may have any length and
+ * alignment: word-aligned runs of blocks are transferred in place, blocks
+ * straddling entries or unaligned go through the CRYPTOD_GCM_SPLIT_COUNT
+ * bounce buffers of the record. So do the output blocks in a cache line
+ * that extends past their text entry, the lines written in place being
+ * invalidated. */
+struct _cryptod_gcm_record {
+	const uint8_t *iv;
+	uint32_t iv_len;                 /* in bytes, 12 is the fast path */
+	const struct _cryptod_sg *aad;   /* dst ignored */
+	uint32_t aad_count;
+	const struct _cryptod_sg *text;  /* plaintext/ciphertext */
+	uint32_t text_count;
+	uint8_t *tag;     /* encryption: receives the tag, decryption: the
+	                   * expected tag */
+	uint8_t tag_len;  /* 4 to 16 bytes */
+	/* following field is set by the driver */
+	volatile uint32_t status;  /* CRYPTOD_ERROR_BUSY while pending, then
+	                            * CRYPTOD_SUCCESS or CRYPTOD_ERROR_AUTH */
+};
+
+struct _cryptod_engine;
+
+struct _cryptod_session {
+	enum _cryptod_algo algo;
+	/* following fields are used internally */
+	struct _cryptod_engine *engine;
+	uint32_t length;      /* bytes queued since the session started */
+	uint8_t  block_size;  /* in bytes */
+	bool     stream;      /* partial last block allowed */
+	volatile bool active;
+};
+
+/*------------------------------------------------------------------------------
+ *        Functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Start a session: reserve the engine of the requested algorithm and
+ * load its key, IV and mode. The engine stays reserved until the completion of
+ * cryptod_final().
+ * \param session  Session to initialize.
+ * \param cfg  Session parameters.
+ * \return CRYPTOD_SUCCESS, CRYPTOD_INVALID_PARAM, CRYPTOD_ERROR_LOCK if
+ * another session uses the engine or CRYPTOD_ERROR_TRANSFER if no DMA channel
+ * is available.
+ */
+extern uint32_t cryptod_init(struct _cryptod_session *session,
+		const struct _cryptod_cfg *cfg);
+
+/**
+ * \brief Queue a list of buffers for processing. Two updates may be pending:
+ * the descriptors of the second one are prepared while the first one is
+ * processed, and it starts from the completion of the first one.
+ * The sg array may be released on return, the buffers it points to shall stay
+ * valid until the callback is invoked.
+ * \param session  Active session.
+ * \param sg  Buffers to process.
+ * \param sg_count  Number of entries in sg.
+ * \param cb  Callback invoked once the buffers are processed, may be NULL.
+ * \param user_args  Argument of the callback.
+ * \return CRYPTOD_SUCCESS, CRYPTOD_INVALID_PARAM or CRYPTOD_ERROR_BUSY if two
+ * updates are already pending.
+ */
+extern uint32_t cryptod_update(struct _cryptod_session *session,
+		const struct _cryptod_sg *sg, uint32_t sg_count,
+		cryptod_callback_t cb, void *user_args);
+
+/**
+ * \brief Queue the last data of a session and end it. For ciphers, a partial
+ * last block is only allowed in OFB, CFB and CTR modes and out receives the
+ * processed data. For hashes, the message is padded and out receives the
+ * digest. GCM sessions are ended with a len of 0. The engine is released
+ * before the callback is invoked.
+ * \param session  Active session.
+ * \param src  Last data, word-aligned, may be NULL if len is 0.
+ * \param out  Output buffer, len bytes for ciphers, digest size for hashes.
+ * For ciphers, it shall start on a cache line if len is at least
+ * L1_CACHE_BYTES; the blocks past its last whole cache line go through a
+ * bounce buffer.
+ * \param len  Size of the last data, in bytes.
+ * \param cb  Callback invoked once the session is over, may be NULL.
+ * \param user_args  Argument of the callback.
+ * \return CRYPTOD_SUCCESS, CRYPTOD_INVALID_PARAM or CRYPTOD_ERROR_BUSY.
+ */
+extern uint32_t cryptod_final(struct _cryptod_session *session,
+		const void *src, void *out, uint32_t len,
+		cryptod_callback_t cb, void *user_args);
+
+/**
+ * \brief Queue an AES-GCM record on a session started in CRYPTOD_MODE_GCM.
+ * The key and hash subkey stay loaded across records, so that records queued
+ * back-to-back only cost the programming of their IV and lengths. As for
+ * updates, two records may be pending.
+ * The lists may be released on return, the buffers, the tag and the record
+ * shall stay valid until the callback is invoked. On decryption, the output
+ * shall be discarded if record->status is CRYPTOD_ERROR_AUTH.
+ * \param session  Active GCM session.
+ * \param record  Record to process, with some AAD or text.
+ * \param cb  Callback invoked once the record is processed, may be NULL.
+ * \param user_args  Argument of the callback.
+ * \return CRYPTOD_SUCCESS, CRYPTOD_INVALID_PARAM or CRYPTOD_ERROR_BUSY.
+ */
+extern uint32_t cryptod_gcm_queue(struct _cryptod_session *session,
+		struct _cryptod_gcm_record *record,
+		cryptod_callback_t cb, void *user_args);
+
+/**
+ * \brief Check whether updates of the session are pending.
+ */
+extern bool cryptod_is_busy(struct _cryptod_session *session);
+
+/**
+ * \brief Wait for all pending updates of the session to complete.
+ */
+extern void cryptod_wait(struct _cryptod_session *session);
+
+/**
+ * \brief Get the block size of an algorithm, in bytes.
+ */
+extern uint32_t cryptod_get_block_size(enum _cryptod_algo algo);
+
+/**
+ * \brief Get the digest size of a hash algorithm, in bytes, 0 for ciphers.
+ */
+extern uint32_t cryptod_get_digest_size(enum _cryptod_algo algo);
+
+#endif /* CRYPTOD_HEADER__ */
@@ -126,7 +126,8 @@ static void _emacd_reset_tx(struct _ethd* emacd)
 		q->tx_desc[i].addr = addr;
 		dsb();
 		q->tx_desc[i].status = ETH_TX_STATUS_USED;
-		addr += ETH_TX_UNITSIZE;
+		if (q->tx_buffer)
+			addr += ETH_TX_UNITSIZE;
 	}
 	q->tx_desc[q->tx_size - 1].status |= ETH_TX_STATUS_WRAP;
 
@@ -150,10 +151,16 @@ static void _emacd_reset_rx(struct _ethd* emacd)
 	/* Setup the RX descriptors */
 	q->rx_head = 0;
 	for (i = 0; i < q->rx_size; i++) {
-		q->rx_desc[i].addr = addr & ETH_RX_ADDR_MASK;
+		if (q->rx_buffer) {
+			q->rx_desc[i].addr = addr & ETH_RX_ADDR_MASK;
+			addr += q->rx_unit_size;
+		} else {
+			/* No buffer yet, keep descriptor owned by software
+			 * until ethd_set_rx_buffer() is called */
+			q->rx_desc[i].addr = ETH_RX_ADDR_OWN;
+		}
 		dsb();
 		q->rx_desc[i].status = 0;
-		addr += ETH_RX_UNITSIZE;
 	}
 	q->rx_desc[q->rx_size - 1].addr |= ETH_RX_ADDR_WRAP;
 
@@ -395,12 +402,15 @@ void emacd_configure(struct _ethd * emacd,
  * \param emacd Pointer to EMAC Driver instance.
  * \param rx_buffer Pointer to allocated buffer for RX. The address should
  *                  be 8-byte aligned and the size should be
- *                  ETH_RX_UNITSIZE * wRxSize.
+ *                  ETH_RX_UNITSIZE * wRxSize. If NULL, the RX buffers
+ *                  are provided later with ethd_set_rx_buffer().
  * \param rx_desc      Pointer to allocated RX descriptor list.
  * \param wRxSize   RX size, in number of registered units (RX descriptors).
  * \param tx_buffer Pointer to allocated buffer for TX. The address should
  *                  be 8-byte aligned and the size should be
- *                  ETH_TX_UNITSIZE * wTxSize.
+ *                  ETH_TX_UNITSIZE * wTxSize. If NULL, frames are
+ *                  transmitted directly from the buffers given to
+ *                  ethd_send_sg() (zero-copy).
  * \param tx_desc      Pointer to allocated TX descriptor list.
  * \param pTxCb     Pointer to allocated TX callback list.
  * \param wTxSize   TX size, in number of registered units (TX descriptors).
@@ -428,6 +438,7 @@ uint8_t emacd_setup_queue(struct _ethd* emacd, uint8_t queue,
 	q->rx_buffer = (uint8_t*)((uint32_t)rx_buffer & 0xFFFFFFF8);
 	q->rx_desc = (struct _eth_desc *)((uint32_t)rx_desc & 0xFFFFFFF8);
 	q->rx_size = rx_size;
+	q->rx_unit_size = ETH_RX_UNITSIZE;
 	q->rx_callback = NULL;
 
 	/* Assign TX buffers */
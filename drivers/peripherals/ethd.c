@@ -57,6 +57,13 @@
  *        Local functions
  *----------------------------------------------------------------------------*/
 
+static uint8_t _ethd_get_desc_csum(struct _ethd* ethd, struct _eth_desc* desc)
+{
+	if (!(ethd->offload & ETH_OFFLOAD_RX_CSUM))
+		return ETH_RX_CSUM_NONE;
+	return (desc->status & ETH_RX_STATUS_CSUM_MASK) >> ETH_RX_STATUS_CSUM_Pos;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -70,6 +77,7 @@ bool ethd_configure(struct _ethd * ethd, enum _eth_type eth_type, void * addr, u
 {
 	ethd->addr = addr;
 	ethd->op = NULL;
+	ethd->offload = 0;
 
 #ifdef CONFIG_HAVE_EMAC
 	if (ETH_TYPE_EMAC == eth_type)
@@ -140,7 +148,7 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 		const struct _eth_sg *sg = &sgl->entries[i];
 		uint32_t status;
 
-		if (sg->size > ETH_TX_UNITSIZE) {
+		if (q->tx_buffer && sg->size > ETH_TX_UNITSIZE) {
 			trace_error("ethd_send_sg: buffer size is too big.\r\n");
 			return ETH_PARAM;
 		}
@@ -153,10 +161,18 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 
 		desc = &q->tx_desc[idx];
 
-		/* Copy data into transmittion buffer */
-		if (sg->buffer && sg->size) {
-			memcpy((void*)desc->addr, sg->buffer, sg->size);
-			cache_clean_region((void*)desc->addr, sg->size);
+		if (q->tx_buffer) {
+			/* Copy data into transmittion buffer */
+			if (sg->buffer && sg->size) {
+				memcpy((void*)desc->addr, sg->buffer, sg->size);
+				cache_clean_region((void*)desc->addr, sg->size);
+			}
+		} else {
+			/* No transmission buffer: send from caller's buffer,
+			 * which must stay valid until the TX callback */
+			desc->addr = (uint32_t)sg->buffer;
+			if (sg->buffer && sg->size)
+				cache_clean_region(sg->buffer, sg->size);
 		}
 
 		/* Compute buffer descriptor status word */
@@ -260,7 +276,7 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 			}
 
 			/* Copy the buffer into the application frame */
-			uint32_t length = ETH_RX_UNITSIZE;
+			uint32_t length = q->rx_unit_size;
 			if ((cur_frame_size + length) > buffer_size) {
 				length = buffer_size - cur_frame_size;
 			}
@@ -275,6 +291,7 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 			if (desc->status & ETH_RX_STATUS_EOF) {
 				/* Frame size from the ETH */
 				*recv_size = desc->status & ETH_RX_STATUS_LENGTH_MASK;
+				q->rx_csum = _ethd_get_desc_csum(ethd, desc);
 
 				/* Application frame buffer is too small all
 				 * data have not been copied */
@@ -306,6 +323,115 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 	return ETH_RX_NULL;
 }
 
+uint8_t ethd_poll_frame(struct _ethd* ethd, uint8_t queue, uint16_t* first, uint16_t* count, uint32_t* recv_size)
+{
+	struct _ethd_queue* q = &ethd->queues[queue];
+	struct _eth_desc *desc;
+	uint16_t idx;
+	bool sof = false;
+
+	/* Set the default return value */
+	*recv_size = 0;
+
+	/* Process RX descriptors */
+	idx = q->rx_head;
+	desc = &q->rx_desc[idx];
+	while (desc->addr & ETH_RX_ADDR_OWN) {
+		/* A start of frame has been received, discard previous fragments */
+		if (desc->status & ETH_RX_STATUS_SOF) {
+			while (idx != q->rx_head) {
+				desc = &q->rx_desc[q->rx_head];
+				desc->addr &= ~ETH_RX_ADDR_OWN;
+				RING_INC(q->rx_head, q->rx_size);
+			}
+			desc = &q->rx_desc[idx];
+			sof = true;
+		}
+
+		/* Increment the index */
+		RING_INC(idx, q->rx_size);
+
+		if (sof) {
+			if (idx == q->rx_head) {
+				trace_info("no EOF (buffers probably too small)\r\n");
+
+				do {
+					desc = &q->rx_desc[q->rx_head];
+					desc->addr &= ~ETH_RX_ADDR_OWN;
+					RING_INC(q->rx_head, q->rx_size);
+				} while (idx != q->rx_head);
+				return ETH_RX_NULL;
+			}
+
+			/* An end of frame has been received, hand over the
+			 * descriptors without releasing them */
+			if (desc->status & ETH_RX_STATUS_EOF) {
+				*recv_size = desc->status & ETH_RX_STATUS_LENGTH_MASK;
+				q->rx_csum = _ethd_get_desc_csum(ethd, desc);
+				*first = q->rx_head;
+				*count = RING_CNT(idx, q->rx_head, q->rx_size);
+
+				while (q->rx_head != idx) {
+					desc = &q->rx_desc[q->rx_head];
+					cache_invalidate_region(
+						(void*)(desc->addr & ETH_RX_ADDR_MASK),
+						q->rx_unit_size);
+					RING_INC(q->rx_head, q->rx_size);
+				}
+
+				return ETH_OK;
+			}
+		}
+
+		/* SOF has not been detected, skip the fragment */
+		else {
+			desc->addr &= ~ETH_RX_ADDR_OWN;
+			q->rx_head = idx;
+		}
+
+		/* Process the next buffer */
+		desc = &q->rx_desc[idx];
+	}
+	return ETH_RX_NULL;
+}
+
+void* ethd_get_rx_buffer(struct _ethd* ethd, uint8_t queue, uint16_t idx)
+{
+	struct _ethd_queue* q = &ethd->queues[queue];
+	return (void*)(q->rx_desc[idx].addr & ETH_RX_ADDR_MASK);
+}
+
+void ethd_set_rx_buffer(struct _ethd* ethd, uint8_t queue, uint16_t idx, void* buffer)
+{
+	struct _ethd_queue* q = &ethd->queues[queue];
+	struct _eth_desc *desc = &q->rx_desc[idx];
+	uint32_t addr = (uint32_t)buffer & ETH_RX_ADDR_MASK;
+
+	/* Make sure no dirty line will be written back over received data */
+	cache_invalidate_region(buffer, q->rx_unit_size);
+
+	if (idx == (q->rx_size - 1))
+		addr |= ETH_RX_ADDR_WRAP;
+	desc->status = 0;
+	dsb();
+
+	/* Update buffer descriptor address word: clear OWN bit */
+	desc->addr = addr;
+	dsb();
+}
+
+uint8_t ethd_set_rx_unit_size(struct _ethd* ethd, uint8_t queue, uint16_t size)
+{
+	if (!ethd->op->set_rx_unit_size)
+		return size == ETH_RX_UNITSIZE ? ETH_OK : ETH_NOT_SUPPORTED;
+	return ethd->op->set_rx_unit_size(ethd, queue, size);
+}
+
+uint16_t ethd_get_rx_unit_size(struct _ethd* ethd, uint8_t queue)
+{
+	return ethd->queues[queue].rx_unit_size;
+}
+
 void ethd_set_rx_callback(struct _ethd *ethd, uint8_t queue, ethd_callback_t callback)
 {
 	ethd->op->set_rx_callback(ethd, queue, callback);
@@ -327,3 +453,26 @@ uint8_t ethd_set_tx_wakeup_callback(struct _ethd* ethd, uint8_t queue, ethd_wake
 
 	return ETH_OK;
 }
+
+uint8_t ethd_set_offload(struct _ethd* ethd, uint32_t offload)
+{
+	uint8_t rc;
+
+	if (!ethd->op->set_offload)
+		return offload ? ETH_NOT_SUPPORTED : ETH_OK;
+
+	rc = ethd->op->set_offload(ethd, offload);
+	if (rc == ETH_OK)
+		ethd->offload = offload;
+	return rc;
+}
+
+uint32_t ethd_get_offload(struct _ethd* ethd)
+{
+	return ethd->offload;
+}
+
+enum _eth_rx_csum ethd_get_rx_csum(struct _ethd* ethd, uint8_t queue)
+{
+	return (enum _eth_rx_csum)ethd->queues[queue].rx_csum;
+}
@@ -89,6 +89,9 @@ enum _eth_speed {
 #define ETH_RX_STATUS_LENGTH_MASK 0x3fffu
 #define ETH_RX_STATUS_SOF         (1u << 14)
 #define ETH_RX_STATUS_EOF         (1u << 15)
+/* Checksum status, only meaningful with ETH_OFFLOAD_RX_CSUM enabled */
+#define ETH_RX_STATUS_CSUM_Pos    22
+#define ETH_RX_STATUS_CSUM_MASK   (0x3u << ETH_RX_STATUS_CSUM_Pos)
 
 /* Bits contained in struct _eth_desc status when used for TX */
 #define ETH_TX_STATUS_LASTBUF (1u << 15)
@@ -99,7 +102,8 @@ enum _eth_speed {
 
 /** \addtogroup eth_buf_size ETH(EMACD/GMACD) Default Buffer Size
         @{*/
-#define ETH_RX_UNITSIZE            128  /**< RX buffer size, must be 128 */
+#define ETH_RX_UNITSIZE            128  /**< Default RX buffer size, the
+					   only one supported by the EMAC */
 #define ETH_TX_UNITSIZE            1536 /**< TX buffer size, must be multiple
 					   of 32 (cache line) */
 /**     @}*/
@@ -115,6 +119,8 @@ enum _eth_speed {
 #define ETH_PARAM             3
 /** Transter is not initialized */
 #define ETH_NOT_INITIALIZED   4
+/** Feature not supported by the controller */
+#define ETH_NOT_SUPPORTED     5
 
 enum _eth_type {
 	ETH_TYPE_EMAC,
@@ -123,6 +129,23 @@ enum _eth_type {
 
 /**     @}*/
 
+/** \addtogroup eth_offload ETH(EMACD/GMACD) Offload Features
+        @{*/
+/** IPv4 header, TCP and UDP checksums checked by hardware on RX, frames
+ * with a bad checksum are discarded */
+#define ETH_OFFLOAD_RX_CSUM   (1u << 0)
+/** IPv4 header, TCP and UDP checksums generated by hardware on TX */
+#define ETH_OFFLOAD_TX_CSUM   (1u << 1)
+
+/** Checksums verified by hardware on a received frame */
+enum _eth_rx_csum {
+	ETH_RX_CSUM_NONE   = 0, /**< Nothing checked */
+	ETH_RX_CSUM_IP     = 1, /**< IPv4 header checksum OK */
+	ETH_RX_CSUM_IP_TCP = 2, /**< IPv4 header and TCP checksums OK */
+	ETH_RX_CSUM_IP_UDP = 3, /**< IPv4 header and UDP checksums OK */
+};
+/**     @}*/
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -191,6 +214,10 @@ typedef void (*_ethd_set_rx_callback)(void *ethd, uint8_t queue, ethd_callback_t
 
 typedef uint8_t (*_ethd_set_tx_wakeup_callback)(void *ethd, uint8_t queue, ethd_wakeup_cb_t wakeup_callback, uint16_t threshold);
 
+typedef uint8_t (*_ethd_set_offload)(void *ethd, uint32_t offload);
+
+typedef uint8_t (*_ethd_set_rx_unit_size)(void *ethd, uint8_t queue, uint16_t size);
+
 /** @}*/
 
 /** \addtogroup ethd_structs
@@ -210,6 +237,8 @@ struct _ethd_op {
 	_ethd_poll poll;
 	_ethd_set_rx_callback set_rx_callback;
 	_ethd_set_tx_wakeup_callback set_tx_wakeup_callback;
+	_ethd_set_offload set_offload;
+	_ethd_set_rx_unit_size set_rx_unit_size;
 };
 
 struct _ethd_queue {
@@ -217,7 +246,9 @@ struct _ethd_queue {
 	struct _eth_desc *rx_desc;
 	uint16_t          rx_size;
 	uint16_t          rx_head;
+	uint16_t          rx_unit_size;  /**< Size of each RX buffer, in bytes */
 	ethd_callback_t   rx_callback;
+	uint8_t           rx_csum;
 
 	uint8_t          *tx_buffer;
 	struct _eth_desc *tx_desc;
@@ -245,6 +276,7 @@ struct _ethd {
 	};
 	struct _ethd_queue queues[ETH_NUM_QUEUES];
 	const struct _ethd_op *op;
+	uint32_t offload;          /**< Enabled ETH_OFFLOAD_* features */
 };
 
 /** @}*/
@@ -305,6 +337,51 @@ extern uint32_t ethd_get_tx_load(struct _ethd* ethd, uint8_t queue);
  */
 extern uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t buffer_size, uint32_t* recv_size);
 
+/**
+ * \brief Look for a received frame without copying it.
+ * The descriptors holding the frame are left owned by software and the
+ * caller must give them back, in any order, with ethd_set_rx_buffer().
+ * Cache is invalidated for all the buffers of the frame.
+ *  \param ethd Pointer to ETH Driver instance.
+ *  \param first            Index of the first RX descriptor of the frame
+ *  \param count            Number of RX descriptors used by the frame
+ *  \param recv_size        Received size
+ *  \return                 OK or no data
+ */
+extern uint8_t ethd_poll_frame(struct _ethd* ethd, uint8_t queue, uint16_t* first, uint16_t* count, uint32_t* recv_size);
+
+/**
+ * \brief Return the buffer currently attached to an RX descriptor.
+ */
+extern void* ethd_get_rx_buffer(struct _ethd* ethd, uint8_t queue, uint16_t idx);
+
+/**
+ * \brief Attach a buffer to an RX descriptor and give it to the hardware.
+ * Used when the queue has been set up without RX buffers (zero-copy).
+ *  \param ethd Pointer to ETH Driver instance.
+ *  \param idx     Index of the RX descriptor
+ *  \param buffer  Buffer of ethd_get_rx_unit_size() bytes, cache line
+ *                 aligned
+ */
+extern void ethd_set_rx_buffer(struct _ethd* ethd, uint8_t queue, uint16_t idx, void* buffer);
+
+/**
+ * \brief Set the size of the RX buffers of a queue set up without RX
+ * buffers. Larger buffers let a frame fit in fewer descriptors, down to one
+ * with 1536 bytes. To be called before the buffers are given with
+ * ethd_set_rx_buffer() and before ethd_start().
+ *  \param ethd Pointer to ETH Driver instance.
+ *  \param size Buffer size in bytes, a multiple of 64.
+ *  \return ETH_OK, ETH_PARAM, or ETH_NOT_SUPPORTED if the controller only
+ *  supports ETH_RX_UNITSIZE (EMAC).
+ */
+extern uint8_t ethd_set_rx_unit_size(struct _ethd* ethd, uint8_t queue, uint16_t size);
+
+/**
+ * \brief Get the size of the RX buffers of a queue, in bytes.
+ */
+extern uint16_t ethd_get_rx_unit_size(struct _ethd* ethd, uint8_t queue);
+
 extern void ethd_set_rx_callback(struct _ethd *ethd, uint8_t queue, ethd_callback_t callback);
 
 /**
@@ -327,6 +404,27 @@ extern void ethd_set_rx_callback(struct _ethd *ethd, uint8_t queue, ethd_callbac
  */
 extern uint8_t ethd_set_tx_wakeup_callback(struct _ethd* ethd, uint8_t queue, ethd_wakeup_cb_t callback, uint16_t threshold);
 
+/**
+ * \brief Enable hardware offload features.
+ * Features not set in the mask are disabled.
+ *  \param ethd    Pointer to ETH Driver instance.
+ *  \param offload Mask of ETH_OFFLOAD_* features.
+ *  \return ETH_OK, or ETH_NOT_SUPPORTED if the controller lacks a feature.
+ */
+extern uint8_t ethd_set_offload(struct _ethd* ethd, uint32_t offload);
+
+/**
+ * \brief Return the enabled ETH_OFFLOAD_* features.
+ */
+extern uint32_t ethd_get_offload(struct _ethd* ethd);
+
+/**
+ * \brief Return the checksums verified by hardware on the last frame
+ * returned by ethd_poll() or ethd_poll_frame() for this queue.
+ * Always ETH_RX_CSUM_NONE when ETH_OFFLOAD_RX_CSUM is not enabled.
+ */
+extern enum _eth_rx_csum ethd_get_rx_csum(struct _ethd* ethd, uint8_t queue);
+
 /** @}*/
 
 #ifdef __cplusplus
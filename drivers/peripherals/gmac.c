@@ -53,6 +53,11 @@
 #define GMAC_TSR_UND 0
 #endif
 
+/* some component headers don't describe this flag, it is always bit 11 */
+#ifndef GMAC_DCFGR_TXCOEN
+#define GMAC_DCFGR_TXCOEN (0x1u << 11)
+#endif
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -516,3 +521,97 @@ void gmac_halt_transmission(Gmac * gmac)
 {
 	gmac->GMAC_NCR |= GMAC_NCR_THALT;
 }
+
+void gmac_enable_rx_checksum_offload(Gmac* gmac, bool enable)
+{
+	if (enable)
+		gmac->GMAC_NCFGR |= GMAC_NCFGR_RXCOEN;
+	else
+		gmac->GMAC_NCFGR &= ~GMAC_NCFGR_RXCOEN;
+}
+
+void gmac_enable_tx_checksum_offload(Gmac* gmac, bool enable)
+{
+	if (enable)
+		gmac->GMAC_DCFGR |= GMAC_DCFGR_TXCOEN;
+	else
+		gmac->GMAC_DCFGR &= ~GMAC_DCFGR_TXCOEN;
+}
+
+bool gmac_set_rx_buffer_size(Gmac* gmac, uint8_t queue, uint32_t size)
+{
+	/* size is programmed in units of 64 bytes */
+	if (size == 0 || (size & 63) || (size >> 6) > 0xff)
+		return false;
+
+	if (queue == 0) {
+		gmac->GMAC_DCFGR = (gmac->GMAC_DCFGR & ~GMAC_DCFGR_DRBS_Msk)
+			| GMAC_DCFGR_DRBS(size >> 6);
+		return true;
+	}
+#ifdef CONFIG_HAVE_GMAC_QUEUES
+	if (queue - 1 < ARRAY_SIZE(gmac->GMAC_RBSRPQ)) {
+		gmac->GMAC_RBSRPQ[queue - 1] = GMAC_RBSRPQ_RBS(size >> 6);
+		return true;
+	}
+#endif
+	return false;
+}
+
+#ifdef CONFIG_HAVE_GMAC_QUEUES
+
+bool gmac_set_screener_type1(Gmac* gmac, uint8_t index,
+		const struct _gmac_screener_type1* rule)
+{
+	uint32_t value;
+
+	if (index >= ARRAY_SIZE(gmac->GMAC_ST1RPQ))
+		return false;
+	if (rule->queue >= GMAC_NUM_QUEUES)
+		return false;
+
+	value = GMAC_ST1RPQ_QNB(rule->queue);
+	if (rule->dstc_enable)
+		value |= GMAC_ST1RPQ_DSTCE | GMAC_ST1RPQ_DSTCM(rule->dstc);
+	if (rule->udp_enable)
+		value |= GMAC_ST1RPQ_UDPE | GMAC_ST1RPQ_UDPM(rule->udp_port);
+	gmac->GMAC_ST1RPQ[index] = value;
+	return true;
+}
+
+void gmac_clear_screener_type1(Gmac* gmac, uint8_t index)
+{
+	if (index < ARRAY_SIZE(gmac->GMAC_ST1RPQ))
+		gmac->GMAC_ST1RPQ[index] = 0;
+}
+
+bool gmac_set_screener_type2(Gmac* gmac, uint8_t index,
+		const struct _gmac_screener_type2* rule)
+{
+	uint32_t value;
+
+	if (index >= ARRAY_SIZE(gmac->GMAC_ST2RPQ))
+		return false;
+	if (rule->queue >= GMAC_NUM_QUEUES)
+		return false;
+
+	value = GMAC_ST2RPQ_QNB(rule->queue);
+	if (rule->vlan_enable)
+		value |= GMAC_ST2RPQ_VLANE | GMAC_ST2RPQ_VLANP(rule->vlan_priority);
+	if (rule->eth_enable) {
+		if (index >= ARRAY_SIZE(gmac->GMAC_ST2ER))
+			return false;
+		gmac->GMAC_ST2ER[index] = GMAC_ST2ER_COMPVAL(rule->ethertype);
+		value |= GMAC_ST2RPQ_ETHE | GMAC_ST2RPQ_I2ETH(index);
+	}
+	gmac->GMAC_ST2RPQ[index] = value;
+	return true;
+}
+
+void gmac_clear_screener_type2(Gmac* gmac, uint8_t index)
+{
+	if (index < ARRAY_SIZE(gmac->GMAC_ST2RPQ))
+		gmac->GMAC_ST2RPQ[index] = 0;
+}
+
+#endif /* CONFIG_HAVE_GMAC_QUEUES */
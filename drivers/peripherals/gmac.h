@@ -106,6 +106,28 @@
 /** \addtogroup gmac_structs
 	@{*/
 
+#ifdef CONFIG_HAVE_GMAC_QUEUES
+/** Screening type 1 rule: steer IP frames on their DS/TC field and/or
+ * their UDP destination port */
+struct _gmac_screener_type1 {
+	uint8_t  queue;         /**< Destination RX queue */
+	bool     dstc_enable;   /**< Match on the DS/TC field */
+	uint8_t  dstc;          /**< IPv4 DS field or IPv6 traffic class */
+	bool     udp_enable;    /**< Match on the UDP destination port */
+	uint16_t udp_port;      /**< UDP destination port */
+};
+
+/** Screening type 2 rule: steer frames on their VLAN priority and/or
+ * their EtherType */
+struct _gmac_screener_type2 {
+	uint8_t  queue;         /**< Destination RX queue */
+	bool     vlan_enable;   /**< Match on the VLAN priority */
+	uint8_t  vlan_priority; /**< VLAN priority (0-7) */
+	bool     eth_enable;    /**< Match on the EtherType */
+	uint16_t ethertype;     /**< EtherType, e.g. 0x88f7 for PTP */
+};
+#endif /* CONFIG_HAVE_GMAC_QUEUES */
+
 /**     @}*/
 
 /*----------------------------------------------------------------------------
@@ -313,6 +335,53 @@ extern void gmac_start_transmission(Gmac* gmac);
  */
 extern void gmac_halt_transmission(Gmac* gmac);
 
+/**
+ *  \brief Enable/Disable receive checksum offload.
+ */
+extern void gmac_enable_rx_checksum_offload(Gmac* gmac, bool enable);
+
+/**
+ *  \brief Enable/Disable transmit checksum generation offload.
+ */
+extern void gmac_enable_tx_checksum_offload(Gmac* gmac, bool enable);
+
+/**
+ *  \brief Set the size of the RX buffers of a queue, in bytes.
+ *  \return false if the size is not a multiple of 64 between 64 and 16320
+ *  or the queue does not exist.
+ */
+extern bool gmac_set_rx_buffer_size(Gmac* gmac, uint8_t queue, uint32_t size);
+
+#ifdef CONFIG_HAVE_GMAC_QUEUES
+
+/**
+ *  \brief Program a screening type 1 register.
+ *  \return false if the index or the rule is invalid.
+ */
+extern bool gmac_set_screener_type1(Gmac* gmac, uint8_t index,
+		const struct _gmac_screener_type1* rule);
+
+/**
+ *  \brief Disable a screening type 1 register.
+ */
+extern void gmac_clear_screener_type1(Gmac* gmac, uint8_t index);
+
+/**
+ *  \brief Program a screening type 2 register.
+ *  An EtherType match uses the EtherType compare register of the same
+ *  index, so it is only available on the first registers.
+ *  \return false if the index or the rule is invalid.
+ */
+extern bool gmac_set_screener_type2(Gmac* gmac, uint8_t index,
+		const struct _gmac_screener_type2* rule);
+
+/**
+ *  \brief Disable a screening type 2 register.
+ */
+extern void gmac_clear_screener_type2(Gmac* gmac, uint8_t index);
+
+#endif /* CONFIG_HAVE_GMAC_QUEUES */
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +34,7 @@
 #include "chip.h"
 #include "trace.h"
 #include "ring.h"
+#include "prof.h"
 
 #include "peripherals/aic.h"
 #include "peripherals/gmacd.h"
@@ -177,7 +178,8 @@ static void _gmacd_reset_tx(struct _ethd* gmacd, uint8_t queue)
 		q->tx_desc[i].addr = addr;
 		dsb();
 		q->tx_desc[i].status = ETH_TX_STATUS_USED;
-		addr += ETH_TX_UNITSIZE;
+		if (q->tx_buffer)
+			addr += ETH_TX_UNITSIZE;
 	}
 	q->tx_desc[q->tx_size - 1].status |= ETH_TX_STATUS_WRAP;
 
@@ -201,10 +203,16 @@ static void _gmacd_reset_rx(struct _ethd* gmacd, uint8_t queue)
 	/* Setup the RX descriptors */
 	q->rx_head = 0;
 	for (i = 0; i < q->rx_size; i++) {
-		q->rx_desc[i].addr = addr & ETH_RX_ADDR_MASK;
+		if (q->rx_buffer) {
+			q->rx_desc[i].addr = addr & ETH_RX_ADDR_MASK;
+			addr += q->rx_unit_size;
+		} else {
+			/* No buffer yet, keep descriptor owned by software
+			 * until ethd_set_rx_buffer() is called */
+			q->rx_desc[i].addr = ETH_RX_ADDR_OWN;
+		}
 		dsb();
 		q->rx_desc[i].status = 0;
-		addr += ETH_RX_UNITSIZE;
 	}
 	q->rx_desc[q->rx_size - 1].addr |= ETH_RX_ADDR_WRAP;
 
@@ -362,6 +370,8 @@ static void _gmacd_handler(struct _ethd * gmacd, uint8_t queue)
 	uint32_t isr;
 	uint32_t rsr;
 
+	PROF_BEGIN(gmacd_irq);
+
 	/* Interrupt Status Register is cleared on read */
 	while ((isr = gmac_get_it_status(gmac, queue)) != 0) {
 		/* RX packet */
@@ -391,6 +401,8 @@ static void _gmacd_handler(struct _ethd * gmacd, uint8_t queue)
 			trace_error("HRESP not OK\n\r");
 		}
 	}
+
+	PROF_END(gmacd_irq);
 }
 
 /**
@@ -447,12 +459,15 @@ void gmacd_configure(struct _ethd * gmacd,
  * \param gmacd Pointer to GMAC Driver instance.
  * \param rx_buffer Pointer to allocated buffer for RX. The address should
  *                  be 8-byte aligned and the size should be
- *                  ETH_RX_UNITSIZE * wRxSize.
+ *                  ETH_RX_UNITSIZE * wRxSize. If NULL, the RX buffers
+ *                  are provided later with ethd_set_rx_buffer().
  * \param rx_desc      Pointer to allocated RX descriptor list.
  * \param wRxSize   RX size, in number of registered units (RX descriptors).
  * \param tx_buffer Pointer to allocated buffer for TX. The address should
  *                  be 8-byte aligned and the size should be
- *                  ETH_TX_UNITSIZE * wTxSize.
+ *                  ETH_TX_UNITSIZE * wTxSize. If NULL, frames are
+ *                  transmitted directly from the buffers given to
+ *                  ethd_send_sg() (zero-copy).
  * \param tx_desc      Pointer to allocated TX descriptor list.
  * \param pTxCb     Pointer to allocated TX callback list.
  * \param wTxSize   TX size, in number of registered units (TX descriptors).
@@ -480,7 +495,10 @@ uint8_t gmacd_setup_queue(struct _ethd* gmacd, uint8_t queue,
 	q->rx_buffer = (uint8_t*)((uint32_t)rx_buffer & 0xFFFFFFF8);
 	q->rx_desc = (struct _eth_desc *)((uint32_t)rx_desc & 0xFFFFFFF8);
 	q->rx_size = rx_size;
+	q->rx_unit_size = ETH_RX_UNITSIZE;
+	gmac_set_rx_buffer_size(gmac, queue, q->rx_unit_size);
 	q->rx_callback = NULL;
+	q->rx_csum = ETH_RX_CSUM_NONE;
 
 	/* Assign TX buffers */
 	if (((uint32_t)tx_buffer & 0x7)
@@ -550,6 +568,86 @@ void gmacd_set_rx_callback(struct _ethd* gmacd, uint8_t queue, ethd_callback_t c
 	}
 }
 
+/**
+ * \brief Enable hardware offload features.
+ *  \param gmacd   Pointer to GMAC Driver instance.
+ *  \param offload Mask of ETH_OFFLOAD_* features, others are disabled.
+ *  \return ETH_OK or ETH_PARAM for unknown features.
+ */
+uint8_t gmacd_set_offload(struct _ethd* gmacd, uint32_t offload)
+{
+	if (offload & ~(ETH_OFFLOAD_RX_CSUM | ETH_OFFLOAD_TX_CSUM))
+		return ETH_PARAM;
+
+	gmac_enable_rx_checksum_offload(gmacd->gmac,
+			(offload & ETH_OFFLOAD_RX_CSUM) != 0);
+	gmac_enable_tx_checksum_offload(gmacd->gmac,
+			(offload & ETH_OFFLOAD_TX_CSUM) != 0);
+	return ETH_OK;
+}
+
+/**
+ * \brief Change the size of the RX buffers of a queue set up without RX
+ * buffers, before they are given with ethd_set_rx_buffer().
+ *  \param gmacd Pointer to GMAC Driver instance.
+ *  \param size  Buffer size, a multiple of 64 bytes.
+ *  \return ETH_OK or ETH_PARAM.
+ */
+uint8_t gmacd_set_rx_unit_size(struct _ethd* gmacd, uint8_t queue,
+		uint16_t size)
+{
+	struct _ethd_queue* q = &gmacd->queues[queue];
+
+	if (queue >= GMAC_NUM_QUEUES || q->rx_buffer)
+		return ETH_PARAM;
+	if (!gmac_set_rx_buffer_size(gmacd->gmac, queue, size))
+		return ETH_PARAM;
+	q->rx_unit_size = size;
+	return ETH_OK;
+}
+
+#ifdef CONFIG_HAVE_GMAC_QUEUES
+
+/**
+ * \brief Steer received frames matching a screening type 1 rule (IP DS/TC
+ * field, UDP port) to a queue. The queue must have been set up.
+ *  \param gmacd Pointer to GMAC Driver instance.
+ *  \param index Index of the screening register.
+ *  \param rule  Rule to program.
+ *  \return ETH_OK, ETH_PARAM or ETH_NOT_INITIALIZED.
+ */
+uint8_t gmacd_set_screener_type1(struct _ethd* gmacd, uint8_t index,
+		const struct _gmac_screener_type1* rule)
+{
+	if (rule->queue < GMAC_NUM_QUEUES &&
+	    gmacd->queues[rule->queue].rx_desc == dummy_rx_desc)
+		return ETH_NOT_INITIALIZED;
+	if (!gmac_set_screener_type1(gmacd->gmac, index, rule))
+		return ETH_PARAM;
+	return ETH_OK;
+}
+
+/**
+ * \brief Steer received frames matching a screening type 2 rule (VLAN
+ * priority, EtherType) to a queue. The queue must have been set up.
+ *  \param gmacd Pointer to GMAC Driver instance.
+ *  \param index Index of the screening register.
+ *  \param rule  Rule to program.
+ *  \return ETH_OK, ETH_PARAM or ETH_NOT_INITIALIZED.
+ */
+uint8_t gmacd_set_screener_type2(struct _ethd* gmacd, uint8_t index,
+		const struct _gmac_screener_type2* rule)
+{
+	if (rule->queue < GMAC_NUM_QUEUES &&
+	    gmacd->queues[rule->queue].rx_desc == dummy_rx_desc)
+		return ETH_NOT_INITIALIZED;
+	if (!gmac_set_screener_type2(gmacd->gmac, index, rule))
+		return ETH_PARAM;
+	return ETH_OK;
+}
+
+#endif /* CONFIG_HAVE_GMAC_QUEUES */
+
 const struct _ethd_op _gmac_op = {
 	.configure = (_ethd_configure)gmacd_configure,
 	.setup_queue = (_ethd_setup_queue)gmacd_setup_queue,
@@ -564,4 +662,6 @@ const struct _ethd_op _gmac_op = {
 	.poll = (_ethd_poll)ethd_poll,
 	.set_rx_callback = (_ethd_set_rx_callback)gmacd_set_rx_callback,
 	.set_tx_wakeup_callback = (_ethd_set_tx_wakeup_callback)ethd_set_tx_wakeup_callback,
+	.set_offload = (_ethd_set_offload)gmacd_set_offload,
+	.set_rx_unit_size = (_ethd_set_rx_unit_size)gmacd_set_rx_unit_size,
 };
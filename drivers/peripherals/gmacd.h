@@ -41,6 +41,9 @@
  * -# Send ethernet packets using ethd_send(), ethd_get_tx_load() is used
  *    to get the free space in TX queue.
  * -# Check and obtain received ethernet packets via ethd_poll().
+ * -# Optionally let the GMAC check and generate IP/TCP/UDP checksums with
+ *    ethd_set_offload(), and steer received traffic to queues 1 and 2
+ *    with gmacd_set_screener_type1() and gmacd_set_screener_type2().
  *
  * \sa \ref gmacb_module, \ref gmac_module
  *
@@ -122,6 +125,19 @@ extern uint8_t gmacd_poll(struct _ethd* gmacd, uint8_t queue,
 extern void gmacd_set_rx_callback(struct _ethd *gmacd, uint8_t queue,
 		ethd_callback_t callback);
 
+extern uint8_t gmacd_set_offload(struct _ethd* gmacd, uint32_t offload);
+
+extern uint8_t gmacd_set_rx_unit_size(struct _ethd* gmacd, uint8_t queue,
+		uint16_t size);
+
+#ifdef CONFIG_HAVE_GMAC_QUEUES
+extern uint8_t gmacd_set_screener_type1(struct _ethd* gmacd, uint8_t index,
+		const struct _gmac_screener_type1* rule);
+
+extern uint8_t gmacd_set_screener_type2(struct _ethd* gmacd, uint8_t index,
+		const struct _gmac_screener_type2* rule);
+#endif
+
 /** @}*/
 
 #ifdef __cplusplus
@@ -64,32 +64,9 @@ struct _pmecc_desc {
 	/** Real size in bytes of ECC in spare */
 	uint32_t ecc_size;
 
-	/** defines the error correcting capability selected at encoding/decoding time */
-	int32_t tt;
-
-	/** degree of the remainders, GF(2**mm) */
-	int32_t mm;
-
-	/** length of codeword =  nn=2**mm -1 */
-	int32_t nn;
-
-	/** Galois field table */
-	const int16_t *alpha_to;
-
-	/** Index of Galois field table */
-	const int16_t *index_of;
-
-	/** */
-	int16_t partial_syn[2 * PMECC_NB_ERROR_MAX];
-
-	/** Holds the current syndrome value, an element of that table belongs to the field.*/
-	int16_t si[2 * PMECC_NB_ERROR_MAX];
-
-	/** sigma table */
-	int16_t smu[PMECC_NB_ERROR_MAX + 2][2 * PMECC_NB_ERROR_MAX + 1];
-
-	/** polynom order */
-	int16_t lmu[PMECC_NB_ERROR_MAX + 1];
+	/** BCH decoder, holding the error correcting capability and the
+	 * Galois field in use */
+	struct _pmecc_bch bch;
 };
 
 /*--------------------------------------------------------------------------- */
@@ -103,212 +80,6 @@ static struct _pmecc_desc pmecc_desc;
  *        Local functions
  *----------------------------------------------------------------------------*/
 
- /**
- * \brief Build the pseudo syndromes table
- * \param sector Targetted sector.
- */
-static void gen_partial_syndromes(uint32_t sector)
-{
-	uint32_t i;
-	volatile int16_t *remainder;
-
-	remainder = (volatile int16_t*)&PMECC->PMECC_REM[sector];
-
-	/* Fill odd syndromes */
-	for (i = 0; i < pmecc_desc.tt; i++)
-		pmecc_desc.partial_syn[1 + (2 * i)] = remainder[i];
-}
-
-/**
- * \brief The substitute function evaluates the polynomial remainder,
- * with different values of the field primitive elements.
- */
-static uint32_t substitute(void)
-{
-	int32_t i, j;
-	int16_t *si;
-	int16_t *partial_syn = pmecc_desc.partial_syn;
-	const int16_t *alpha_to = pmecc_desc.alpha_to;
-	const int16_t *index_of = pmecc_desc.index_of;
-
-	/* si[] is a table that holds the current syndrome value, an element of that table belongs to the field.*/
-	memset(pmecc_desc.si, 0, sizeof(pmecc_desc.si));
-	si = pmecc_desc.si;
-
-	/* Computation 2t syndromes based on S(x) */
-	/* Odd syndromes */
-	for (i = 1; i <= 2 * pmecc_desc.tt - 1; i = i + 2) {
-		si[i] = 0;
-		for (j = 0; j < pmecc_desc.mm; j++) {
-			if (partial_syn[i] & ((uint16_t)0x1 << j))
-				si[i] = alpha_to[(i * j)] ^ si[i];
-		}
-	}
-	/* Even syndrome = (Odd syndrome) ** 2 */
-	for (i = 2; i <= 2 * pmecc_desc.tt; i = i + 2) {
-		j = i / 2;
-		if (si[j] == 0) {
-			si[i] = 0;
-		} else {
-			si[i] = alpha_to[(2 * index_of[si[j]]) % pmecc_desc.nn];
-		}
-	}
-	return 0;
-}
-
-/**
- * \brief The substitute function finding the value of the error
- * location polynomial.
- */
-static uint32_t get_sigma(void)
-{
-	uint32_t dmu_0_count;
-	int32_t i, j, k;
-	int16_t *lmu = pmecc_desc.lmu;
-	int16_t *si = pmecc_desc.si;
-	int16_t tt = pmecc_desc.tt;
-
-	int32_t mu[PMECC_NB_ERROR_MAX + 1]; /* mu */
-	int32_t dmu[PMECC_NB_ERROR_MAX + 1]; /* discrepancy */
-	int32_t delta[PMECC_NB_ERROR_MAX + 1]; /* delta order */
-	int32_t ro; /* index of largest delta */
-	int32_t largest;
-	int32_t diff;
-
-	dmu_0_count = 0;
-
-	/* -- First Row -- */
-
-	/* Mu */
-	mu[0]  = -1;
-	/* Actually -1/2 */
-	/* Sigma(x) set to 1 */
-
-	for (i = 0; i < (2 * PMECC_NB_ERROR_MAX + 1); i++)
-		pmecc_desc.smu[0][i] = 0;
-	pmecc_desc.smu[0][0] = 1;
-
-	/* discrepancy set to 1 */
-	dmu[0] = 1;
-
-	/* polynom order set to 0 */
-	lmu[0] = 0;
-
-	/* delta set to -1 */
-	delta[0]  = (mu[0] * 2 - lmu[0]) >> 1;
-
-	/* -- Second Row -- */
-
-	/* Mu */
-	mu[1] = 0;
-
-	/* Sigma(x) set to 1 */
-	for (i = 0; i < (2 * PMECC_NB_ERROR_MAX + 1); i++)
-		pmecc_desc.smu[1][i] = 0;
-	pmecc_desc.smu[1][0] = 1;
-
-	/* discrepancy set to S1 */
-	dmu[1] = si[1];
-
-	/* polynom order set to 0 */
-	lmu[1] = 0;
-
-	/* delta set to 0 */
-	delta[1]  = (mu[1] * 2 - lmu[1]) >> 1;
-
-	/* Init the Sigma(x) last row */
-	for (i = 0; i < (2 * PMECC_NB_ERROR_MAX + 1); i++)
-		pmecc_desc.smu[tt + 1][i] = 0;
-
-	for (i = 1; i <= tt; i++) {
-		mu[i+1] = i << 1;
-
-		/* Compute Sigma (Mu+1) */
-		/* And L(mu) */
-		/* check if discrepancy is set to 0 */
-		if ( dmu[i] == 0) {
-			dmu_0_count++;
-			if ((tt - (lmu[i] >> 1) - 1) & 0x1) {
-				if (dmu_0_count == (uint32_t)((tt - (lmu[i] >> 1) - 1) / 2) + 2) {
-					for (j = 0; j <= (lmu[i] >> 1) + 1; j++)
-						pmecc_desc.smu[tt+1][j] = pmecc_desc.smu[i][j];
-					lmu[tt + 1] = lmu[i];
-					return 0;
-				}
-			} else {
-				if (dmu_0_count == (uint32_t)((tt - (lmu[i] >> 1) - 1) / 2) + 1) {
-					for (j = 0; j <= (lmu[i] >> 1) + 1; j++)
-						pmecc_desc.smu[tt + 1][j] = pmecc_desc.smu[i][j];
-					lmu[tt + 1] = lmu[i];
-					return 0;
-				}
-			}
-
-			/* copy polynom */
-			for (j = 0; j <= (lmu[i] >> 1); j++)
-				pmecc_desc.smu[i + 1][j] = pmecc_desc.smu[i][j];
-
-			/* copy previous polynom order to the next */
-			lmu[i + 1] = lmu[i];
-		} else {
-			/* find largest delta with dmu != 0 */
-			ro = 0;
-			largest = -1;
-			for (j = 0; j < i; j++) {
-				if (dmu[j]) {
-					if (delta[j] > largest) {
-						largest = delta[j];
-						ro = j;
-					}
-				}
-			}
-
-			/* compute difference */
-			diff = (mu[i] - mu[ro]);
-
-			/* Compute degree of the new smu polynomial */
-			if ((lmu[i] >> 1) > ((lmu[ro] >> 1) + diff))
-				lmu[i + 1] = lmu[i];
-			else
-				lmu[i + 1] = ((lmu[ro] >> 1) + diff) * 2;
-
-			/* Init smu[i+1] with 0 */
-			for (k = 0; k < (2 * PMECC_NB_ERROR_MAX + 1); k++)
-				pmecc_desc.smu[i+1][k] = 0;
-
-			/* Compute smu[i+1] */
-			for (k = 0; k <= (lmu[ro] >> 1); k++) {
-				if (pmecc_desc.smu[ro][k] && dmu[i])
-					pmecc_desc.smu[i + 1][k + diff] = pmecc_desc.alpha_to[(pmecc_desc.index_of[dmu[i]] +
-							(pmecc_desc.nn - pmecc_desc.index_of[dmu[ro]]) +
-							pmecc_desc.index_of[pmecc_desc.smu[ro][k]]) % pmecc_desc.nn];
-			}
-			for (k = 0; k <= (lmu[i] >> 1); k++)
-				pmecc_desc.smu[i+1][k] ^= pmecc_desc.smu[i][k];
-		}
-
-		/*************************************************/
-		/*      End Compute Sigma (Mu+1)                 */
-		/*      And L(mu)                                */
-		/*************************************************/
-		/* In either case compute delta */
-		delta[i + 1] = (mu[i + 1] * 2 - lmu[i + 1]) >> 1;
-
-		/* Do not compute discrepancy for the last iteration */
-		if (i < tt) {
-			for (k = 0 ; k <= (lmu[i + 1] >> 1); k++) {
-				if (k == 0)
-					dmu[i + 1] = si[2 * (i - 1) + 3];
-				/* check if one operand of the multiplier is null, its index is -1 */
-				else if (pmecc_desc.smu[i+1][k] && si[2 * (i - 1) + 3 - k])
-					dmu[i + 1] = pmecc_desc.alpha_to[(pmecc_desc.index_of[pmecc_desc.smu[i + 1][k]] +
-							pmecc_desc.index_of[si[2 * (i - 1) + 3 - k]]) % pmecc_desc.nn] ^ dmu[i + 1];
-			}
-		}
-	}
-	return 0;
-}
-
 /**
  * \brief Init the PMECC Error Location peripheral and start the error
  *        location processing
@@ -320,13 +91,15 @@ static int32_t error_location(uint32_t sector_size_in_bits)
 	uint32_t i;
 	uint32_t error_number;
 	uint32_t nbr_of_roots;
+	const int16_t *sigma;
 
 	/* Disable PMECC Error Location IP */
 	PMERRLOC->PMERRLOC_DIS = ~0u;
 
-	error_number = pmecc_desc.lmu[pmecc_desc.tt + 1] >> 1;
+	error_number = pmecc_bch_compute_sigma(&pmecc_desc.bch);
+	sigma = pmecc_bch_get_sigma(&pmecc_desc.bch);
 	for (i = 0; i <= error_number; i++)
-		PMERRLOC->PMERRLOC_SIGMA[i] = pmecc_desc.smu[pmecc_desc.tt + 1][i];
+		PMERRLOC->PMERRLOC_SIGMA[i] = sigma[i];
 
 	/* Configure and enable error location process */
 	PMERRLOC->PMERRLOC_CFG = (PMERRLOC->PMERRLOC_CFG & ~PMERRLOC_CFG_ERRNUM_Msk) |
@@ -337,7 +110,7 @@ static int32_t error_location(uint32_t sector_size_in_bits)
 
 	nbr_of_roots = (PMERRLOC->PMERRLOC_ISR & PMERRLOC_ISR_ERR_CNT_Msk) >> PMERRLOC_ISR_ERR_CNT_Pos;
 	/* Number of roots == degree of smu hence <= tt */
-	if (nbr_of_roots == (uint32_t)(pmecc_desc.lmu[pmecc_desc.tt + 1] >> 1))
+	if (nbr_of_roots == error_number)
 		return error_number;
 
 	/* Number of roots not match the degree of smu ==> unable to correct error */
@@ -529,6 +302,9 @@ uint8_t pmecc_initialize(uint8_t sector_size, uint8_t ecc_errors_per_sector,
 		uint16_t ecc_offset_in_spare, uint8_t spare_protected)
 {
 	uint8_t nb_sectors_per_page = 0;
+	uint32_t mm = 0;
+	const int16_t *alpha_to = NULL;
+	const int16_t *index_of = NULL;
 
 	memset(&pmecc_desc, 0, sizeof(pmecc_desc));
 
@@ -544,23 +320,21 @@ uint8_t pmecc_initialize(uint8_t sector_size, uint8_t ecc_errors_per_sector,
 	/* 512 bytes per sector */
 	case 0:
 		nb_sectors_per_page = page_data_size / 512;
-		pmecc_desc.mm = 13;
-		pmecc_get_gf_512_tables(&pmecc_desc.alpha_to, &pmecc_desc.index_of);
+		mm = 13;
+		pmecc_get_gf_512_tables(&alpha_to, &index_of);
 		break;
 
 	/* 1024 bytes per sector */
 	case 1:
 		pmecc_desc.cfg |= PMECC_CFG_SECTORSZ;
 		nb_sectors_per_page = page_data_size / 1024;
-		pmecc_desc.mm = 14;
-		pmecc_get_gf_1024_tables(&pmecc_desc.alpha_to, &pmecc_desc.index_of);
+		mm = 14;
+		pmecc_get_gf_1024_tables(&alpha_to, &index_of);
 		break;
 	default:
 		assert(false);
 	}
 
-	pmecc_desc.nn = (1 << pmecc_desc.mm) - 1;
-
 	switch (nb_sectors_per_page) {
 	case 1:
 		pmecc_desc.cfg |= PMECC_CFG_PAGESIZE_PAGESIZE_1SEC;
@@ -605,8 +379,9 @@ uint8_t pmecc_initialize(uint8_t sector_size, uint8_t ecc_errors_per_sector,
 	}
 
 	/* Real value of ECC bit number correction (2, 4, 8, 12, 24, 32) */
-	pmecc_desc.tt = ecc_errors_per_sector;
-	pmecc_desc.ecc_size = ROUND_INT_DIV(pmecc_desc.mm * ecc_errors_per_sector, 8) * nb_sectors_per_page;
+	pmecc_bch_init(&pmecc_desc.bch, mm, ecc_errors_per_sector,
+			alpha_to, index_of);
+	pmecc_desc.ecc_size = ROUND_INT_DIV(mm * ecc_errors_per_sector, 8) * nb_sectors_per_page;
 
 	if (ecc_offset_in_spare < 2) {
 		pmecc_desc.ecc_start = PMECC_ECC_DEFAULT_START_ADDR;
@@ -766,10 +541,9 @@ uint32_t pmecc_correction(uint32_t pmecc_status, uint32_t page_buffer)
 	for (sector = 0; sector < sector_count; sector++) {
 		if (pmecc_status & 1) {
 			sector_base_address = page_buffer + sector * sector_size;
-			gen_partial_syndromes(sector);
-			substitute();
-			get_sigma();
-			error_nbr = error_location(sector_size * 8 + pmecc_desc.tt * pmecc_desc.mm); /* number of bits of the sector + ecc */
+			pmecc_bch_set_remainders(&pmecc_desc.bch,
+					(volatile int16_t*)&PMECC->PMECC_REM[sector]);
+			error_nbr = error_location(sector_size * 8 + pmecc_desc.bch.tt * pmecc_desc.bch.mm); /* number of bits of the sector + ecc */
 			if (error_nbr == -1)
 				return 1;
 			else
@@ -780,3 +554,46 @@ uint32_t pmecc_correction(uint32_t pmecc_status, uint32_t page_buffer)
 
 	return 0;
 }
+
+/**
+ * \brief Initialize a BCH decoder context with the current PMECC
+ * configuration. The remainders are loaded separately, e.g. from a copy made
+ * with pmecc_get_remainders().
+ * \param bch Pointer to the decoder context to initialize.
+ */
+void pmecc_init_bch(struct _pmecc_bch *bch)
+{
+	const struct _pmecc_bch *cfg = &pmecc_desc.bch;
+
+	pmecc_bch_init(bch, cfg->mm, cfg->tt, cfg->alpha_to, cfg->index_of);
+}
+
+/**
+ * \brief Copy the remainders computed for a sector of the page last read.
+ * \param sector Index of the sector in the page.
+ * \param remainders Buffer receiving the remainders, PMECC_BCH_MAX_ERRORS
+ * entries at most.
+ */
+void pmecc_get_remainders(uint32_t sector, int16_t *remainders)
+{
+	const volatile int16_t *rem =
+		(volatile int16_t*)&PMECC->PMECC_REM[sector];
+	int32_t i;
+
+	for (i = 0; i < pmecc_desc.bch.tt; i++)
+		remainders[i] = rem[i];
+}
+
+/**
+ * \brief Prepare a BCH decoder context for a sector of the page last read,
+ * so that the sector can be corrected with pmecc_bch_decode() while the PMECC
+ * processes another page.
+ * \param sector Index of the sector in the page.
+ * \param bch Pointer to the decoder context to initialize.
+ */
+void pmecc_get_sector_bch(uint32_t sector, struct _pmecc_bch *bch)
+{
+	pmecc_init_bch(bch);
+	pmecc_bch_set_remainders(bch,
+			(volatile int16_t*)&PMECC->PMECC_REM[sector]);
+}
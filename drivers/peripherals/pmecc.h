@@ -39,6 +39,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "peripherals/pmecc_bch.h"
+
 /*----------------------------------------------------------------------- */
 /*         Definitions                                                    */
 /*----------------------------------------------------------------------- */
@@ -46,6 +48,9 @@
 /** Start address of ECC cvalue in spare zone, this must not be 0 since Bad block tag are at 0. */
 #define PMECC_ECC_DEFAULT_START_ADDR   0x02
 
+/** Maximum number of sectors per page */
+#define PMECC_MAX_SECTORS 8
+
 /*------------------------------------------------------------------------------ */
 /*         Exported functions                                                    */
 /*------------------------------------------------------------------------------ */
@@ -93,6 +98,12 @@ extern uint32_t pmecc_get_ecc_end_address(void);
 
 extern uint32_t pmecc_correction(uint32_t pmecc_status, uint32_t page_buffer);
 
+extern void pmecc_init_bch(struct _pmecc_bch *bch);
+
+extern void pmecc_get_remainders(uint32_t sector, int16_t *remainders);
+
+extern void pmecc_get_sector_bch(uint32_t sector, struct _pmecc_bch *bch);
+
 extern void pmecc_build_gf(uint32_t mm, int32_t *index_of, int32_t *alpha_to);
 
 #endif /* CONFIG_HAVE_PMECC */
@@ -0,0 +1,419 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "compiler.h"
+
+#include "peripherals/pmecc_bch.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------------- */
+/*         Local definitions                                                  */
+/*--------------------------------------------------------------------------- */
+
+/** Number of codeword positions evaluated per Chien search iteration */
+#define CHIEN_LANES 4
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief The substitute function evaluates the polynomial remainder,
+ * with different values of the field primitive elements.
+ * Only the bits set in the remainders are visited.
+ */
+static void substitute(struct _pmecc_bch *bch)
+{
+	int32_t i, j;
+	uint32_t rem, syn;
+	int16_t *si = bch->si;
+	const int16_t *partial_syn = bch->partial_syn;
+	const int16_t *alpha_to = bch->alpha_to;
+	const int16_t *index_of = bch->index_of;
+
+	memset(si, 0, sizeof(bch->si));
+
+	/* Computation 2t syndromes based on S(x) */
+	/* Odd syndromes */
+	for (i = 1; i <= 2 * bch->tt - 1; i = i + 2) {
+		rem = (uint16_t)partial_syn[i] & ((1u << bch->mm) - 1);
+		syn = 0;
+		while (rem) {
+			j = 31 - CLZ(rem);
+			syn ^= alpha_to[i * j];
+			rem ^= 1u << j;
+		}
+		si[i] = syn;
+	}
+	/* Even syndrome = (Odd syndrome) ** 2 */
+	for (i = 2; i <= 2 * bch->tt; i = i + 2) {
+		j = i / 2;
+		if (si[j] == 0)
+			si[i] = 0;
+		else
+			si[i] = alpha_to[(2 * index_of[si[j]]) % bch->nn];
+	}
+}
+
+/**
+ * \brief Find the error location polynomial, using the Berlekamp-Massey
+ * algorithm.
+ */
+static void get_sigma(struct _pmecc_bch *bch)
+{
+	uint32_t dmu_0_count;
+	int32_t i, j, k;
+	int16_t *lmu = bch->lmu;
+	int16_t *si = bch->si;
+	int16_t (*smu)[2 * PMECC_BCH_MAX_ERRORS + 1] = bch->smu;
+	const int16_t *alpha_to = bch->alpha_to;
+	const int16_t *index_of = bch->index_of;
+	int32_t tt = bch->tt;
+	int32_t nn = bch->nn;
+
+	int32_t mu[PMECC_BCH_MAX_ERRORS + 2]; /* mu */
+	int32_t dmu[PMECC_BCH_MAX_ERRORS + 2]; /* discrepancy */
+	int32_t delta[PMECC_BCH_MAX_ERRORS + 2]; /* delta order */
+	int32_t ro; /* index of largest delta */
+	int32_t largest;
+	int32_t diff;
+
+	dmu_0_count = 0;
+
+	/* -- First Row -- */
+
+	/* Mu */
+	mu[0]  = -1;
+	/* Actually -1/2 */
+	/* Sigma(x) set to 1 */
+	memset(smu[0], 0, sizeof(smu[0]));
+	smu[0][0] = 1;
+
+	/* discrepancy set to 1 */
+	dmu[0] = 1;
+
+	/* polynom order set to 0 */
+	lmu[0] = 0;
+
+	/* delta set to -1 */
+	delta[0]  = (mu[0] * 2 - lmu[0]) >> 1;
+
+	/* -- Second Row -- */
+
+	/* Mu */
+	mu[1] = 0;
+
+	/* Sigma(x) set to 1 */
+	memset(smu[1], 0, sizeof(smu[1]));
+	smu[1][0] = 1;
+
+	/* discrepancy set to S1 */
+	dmu[1] = si[1];
+
+	/* polynom order set to 0 */
+	lmu[1] = 0;
+
+	/* delta set to 0 */
+	delta[1]  = (mu[1] * 2 - lmu[1]) >> 1;
+
+	/* Init the Sigma(x) last row */
+	memset(smu[tt + 1], 0, sizeof(smu[tt + 1]));
+
+	for (i = 1; i <= tt; i++) {
+		mu[i+1] = i << 1;
+
+		/* Compute Sigma (Mu+1) */
+		/* And L(mu) */
+		/* check if discrepancy is set to 0 */
+		if (dmu[i] == 0) {
+			dmu_0_count++;
+			if ((tt - (lmu[i] >> 1) - 1) & 0x1) {
+				if (dmu_0_count == (uint32_t)((tt - (lmu[i] >> 1) - 1) / 2) + 2) {
+					for (j = 0; j <= (lmu[i] >> 1) + 1; j++)
+						smu[tt + 1][j] = smu[i][j];
+					lmu[tt + 1] = lmu[i];
+					return;
+				}
+			} else {
+				if (dmu_0_count == (uint32_t)((tt - (lmu[i] >> 1) - 1) / 2) + 1) {
+					for (j = 0; j <= (lmu[i] >> 1) + 1; j++)
+						smu[tt + 1][j] = smu[i][j];
+					lmu[tt + 1] = lmu[i];
+					return;
+				}
+			}
+
+			/* copy polynom */
+			for (j = 0; j <= (lmu[i] >> 1); j++)
+				smu[i + 1][j] = smu[i][j];
+
+			/* copy previous polynom order to the next */
+			lmu[i + 1] = lmu[i];
+		} else {
+			/* find largest delta with dmu != 0 */
+			ro = 0;
+			largest = -1;
+			for (j = 0; j < i; j++) {
+				if (dmu[j]) {
+					if (delta[j] > largest) {
+						largest = delta[j];
+						ro = j;
+					}
+				}
+			}
+
+			/* compute difference */
+			diff = (mu[i] - mu[ro]);
+
+			/* Compute degree of the new smu polynomial */
+			if ((lmu[i] >> 1) > ((lmu[ro] >> 1) + diff))
+				lmu[i + 1] = lmu[i];
+			else
+				lmu[i + 1] = ((lmu[ro] >> 1) + diff) * 2;
+
+			/* Init smu[i+1] with 0 */
+			memset(smu[i + 1], 0, sizeof(smu[i + 1]));
+
+			/* Compute smu[i+1] */
+			for (k = 0; k <= (lmu[ro] >> 1); k++) {
+				if (smu[ro][k] && dmu[i])
+					smu[i + 1][k + diff] = alpha_to[(index_of[dmu[i]] +
+							(nn - index_of[dmu[ro]]) +
+							index_of[smu[ro][k]]) % nn];
+			}
+			for (k = 0; k <= (lmu[i] >> 1); k++)
+				smu[i + 1][k] ^= smu[i][k];
+		}
+
+		/*************************************************/
+		/*      End Compute Sigma (Mu+1)                 */
+		/*      And L(mu)                                */
+		/*************************************************/
+		/* In either case compute delta */
+		delta[i + 1] = (mu[i + 1] * 2 - lmu[i + 1]) >> 1;
+
+		/* Do not compute discrepancy for the last iteration */
+		if (i < tt) {
+			for (k = 0 ; k <= (lmu[i + 1] >> 1); k++) {
+				if (k == 0)
+					dmu[i + 1] = si[2 * (i - 1) + 3];
+				/* check if one operand of the multiplier is null, its index is -1 */
+				else if (smu[i + 1][k] && si[2 * (i - 1) + 3 - k])
+					dmu[i + 1] = alpha_to[(index_of[smu[i + 1][k]] +
+							index_of[si[2 * (i - 1) + 3 - k]]) % nn] ^ dmu[i + 1];
+			}
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a BCH decoder context.
+ * \param bch Pointer to the context.
+ * \param mm Degree of the remainders: 13 for 512-byte sectors, 14 for
+ * 1024-byte sectors.
+ * \param tt Error correcting capability, up to PMECC_BCH_MAX_ERRORS.
+ * \param alpha_to Galois field table, of 2**mm entries.
+ * \param index_of Index of Galois field table, of 2**mm entries.
+ */
+void pmecc_bch_init(struct _pmecc_bch *bch, uint32_t mm, uint32_t tt,
+		const int16_t *alpha_to, const int16_t *index_of)
+{
+	assert(tt > 0 && tt <= PMECC_BCH_MAX_ERRORS);
+	assert(mm < 16);
+
+	bch->tt = tt;
+	bch->mm = mm;
+	bch->nn = (1 << mm) - 1;
+	bch->alpha_to = alpha_to;
+	bch->index_of = index_of;
+	memset(bch->partial_syn, 0, sizeof(bch->partial_syn));
+}
+
+/**
+ * \brief Load the remainders computed by the PMECC for one sector.
+ * \param bch Pointer to the context.
+ * \param remainders tt remainders, as laid out in the PMECC_REM registers.
+ */
+void pmecc_bch_set_remainders(struct _pmecc_bch *bch,
+		const volatile int16_t *remainders)
+{
+	int32_t i;
+
+	/* Fill odd syndromes */
+	for (i = 0; i < bch->tt; i++)
+		bch->partial_syn[1 + (2 * i)] = remainders[i];
+}
+
+/**
+ * \brief Compute the syndromes and the error locator polynomial.
+ * \param bch Pointer to the context, with remainders loaded.
+ * \return Degree of the error locator polynomial, i.e. the number of errors
+ * to be located.
+ */
+uint32_t pmecc_bch_compute_sigma(struct _pmecc_bch *bch)
+{
+	substitute(bch);
+	get_sigma(bch);
+	return bch->lmu[bch->tt + 1] >> 1;
+}
+
+/**
+ * \brief Return the coefficients of the error locator polynomial, as
+ * computed by pmecc_bch_compute_sigma().
+ */
+const int16_t *pmecc_bch_get_sigma(const struct _pmecc_bch *bch)
+{
+	return bch->smu[bch->tt + 1];
+}
+
+/**
+ * \brief Locate the errors by searching the roots of the error locator
+ * polynomial (Chien search). CHIEN_LANES consecutive codeword positions are
+ * evaluated per iteration, sharing the table lookups of the polynomial terms.
+ * \param bch Pointer to the context, once pmecc_bch_compute_sigma() called.
+ * \param nb_bits Number of bits of the codeword, i.e. of the sector plus its
+ * ECC.
+ * \param positions Buffer for the error positions, of tt entries. Positions
+ * are numbered from 1, as the PMERRLOC does: position p designates bit
+ * (p - 1) % 8 of byte (p - 1) / 8.
+ * \return Number of errors located, or -1 if the number of roots does not
+ * match the degree of the polynomial, i.e. the errors cannot be corrected.
+ */
+int32_t pmecc_bch_find_errors(const struct _pmecc_bch *bch,
+		uint32_t nb_bits, uint32_t *positions)
+{
+	const int16_t *sigma = pmecc_bch_get_sigma(bch);
+	const int16_t *alpha_to = bch->alpha_to;
+	const int16_t *index_of = bch->index_of;
+	const int32_t nn = bch->nn;
+	const uint32_t degree = bch->lmu[bch->tt + 1] >> 1;
+	/* Non-null terms of sigma: order, and current log of the term value */
+	int32_t order[PMECC_BCH_MAX_ERRORS];
+	int32_t term[PMECC_BCH_MAX_ERRORS];
+	uint32_t val[CHIEN_LANES];
+	uint32_t nb_terms = 0, found = 0;
+	uint32_t pos, i, lane;
+	int32_t t, j;
+
+	if (degree == 0)
+		return 0;
+
+	for (i = 1; i <= degree; i++) {
+		if (sigma[i] == 0)
+			continue;
+		order[nb_terms] = i;
+		term[nb_terms] = index_of[sigma[i]];
+		nb_terms++;
+	}
+
+	/* Evaluate sigma(alpha ** -pos) at each codeword position; the term of
+	 * order j gets multiplied by alpha ** -j from a position to the next */
+	for (pos = 0; pos < nb_bits; pos += CHIEN_LANES) {
+		for (lane = 0; lane < CHIEN_LANES; lane++)
+			val[lane] = sigma[0];
+		for (i = 0; i < nb_terms; i++) {
+			j = order[i];
+			t = term[i];
+			for (lane = 0; lane < CHIEN_LANES; lane++) {
+				val[lane] ^= alpha_to[t];
+				t -= j;
+				if (t < 0)
+					t += nn;
+			}
+			term[i] = t;
+		}
+		for (lane = 0; lane < CHIEN_LANES; lane++)
+			if (val[lane] == 0 && pos + lane < nb_bits
+			    && found < degree)
+				positions[found++] = pos + lane + 1;
+		/* A polynomial has no more roots than its degree */
+		if (found == degree)
+			break;
+	}
+
+	/* Number of roots not match the degree of smu ==> unable to correct error */
+	return found == degree ? (int32_t)found : -1;
+}
+
+/**
+ * \brief Flip the erroneous bits of a sector. Errors located in the ECC are
+ * ignored.
+ * \param sector Pointer to the sector data.
+ * \param sector_size Size of the sector in bytes.
+ * \param positions Error positions, as returned by pmecc_bch_find_errors().
+ * \param count Number of errors.
+ */
+void pmecc_bch_correct(uint8_t *sector, uint32_t sector_size,
+		const uint32_t *positions, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		uint32_t byte_pos = (positions[i] - 1) >> 3;
+		uint32_t bit_pos = (positions[i] - 1) & 7;
+
+		/* If error is located in the data area (not in ECC) */
+		if (byte_pos < sector_size)
+			sector[byte_pos] ^= 1 << bit_pos;
+	}
+}
+
+/**
+ * \brief Correct a sector in software, from its remainders.
+ * \param bch Pointer to the context, with remainders loaded.
+ * \param sector Pointer to the sector data.
+ * \param sector_size Size of the sector in bytes.
+ * \return Number of errors corrected, or -1 if errors cannot be corrected.
+ */
+int32_t pmecc_bch_decode(struct _pmecc_bch *bch, uint8_t *sector,
+		uint32_t sector_size)
+{
+	uint32_t positions[PMECC_BCH_MAX_ERRORS];
+	int32_t count;
+
+	if (pmecc_bch_compute_sigma(bch) == 0)
+		return 0;
+	count = pmecc_bch_find_errors(bch, sector_size * 8 + bch->tt * bch->mm,
+			positions);
+	if (count > 0)
+		pmecc_bch_correct(sector, sector_size, positions, count);
+	return count;
+}
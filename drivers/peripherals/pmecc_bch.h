@@ -0,0 +1,117 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * BCH decoder for the PMECC.
+ *
+ * This module holds the arithmetic part of the PMECC error correction:
+ * syndrome expansion, Berlekamp-Massey computation of the error locator
+ * polynomial and software Chien search. It does not access any register,
+ * keeps its whole state in a caller-provided context and may therefore decode
+ * several sectors concurrently, e.g. correct a sector while the PMECC
+ * processes the next page. It only depends on the C library, and builds for
+ * the host as well.
+ */
+
+#ifndef PMECC_BCH_H
+#define PMECC_BCH_H
+
+/*----------------------------------------------------------------------- */
+/*         Headers                                                        */
+/*----------------------------------------------------------------------- */
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------- */
+/*         Definitions                                                    */
+/*----------------------------------------------------------------------- */
+
+/** Maximum error correcting capability supported by the decoder */
+#define PMECC_BCH_MAX_ERRORS 32
+
+/*----------------------------------------------------------------------- */
+/*         Types                                                          */
+/*----------------------------------------------------------------------- */
+
+/** BCH decoder context */
+struct _pmecc_bch {
+	/** Error correcting capability */
+	int32_t tt;
+
+	/** Degree of the remainders, GF(2**mm) */
+	int32_t mm;
+
+	/** Length of codeword, nn = 2**mm - 1 */
+	int32_t nn;
+
+	/** Galois field table */
+	const int16_t *alpha_to;
+
+	/** Index of Galois field table */
+	const int16_t *index_of;
+
+	/** Remainders, i.e. odd partial syndromes */
+	int16_t partial_syn[2 * PMECC_BCH_MAX_ERRORS + 1];
+
+	/** Syndromes */
+	int16_t si[2 * PMECC_BCH_MAX_ERRORS + 1];
+
+	/** Sigma table, row tt + 1 holds the error locator polynomial */
+	int16_t smu[PMECC_BCH_MAX_ERRORS + 2][2 * PMECC_BCH_MAX_ERRORS + 1];
+
+	/** Polynom order, times 2 */
+	int16_t lmu[PMECC_BCH_MAX_ERRORS + 2];
+};
+
+/*----------------------------------------------------------------------- */
+/*         Exported functions                                             */
+/*----------------------------------------------------------------------- */
+
+extern void pmecc_bch_init(struct _pmecc_bch *bch, uint32_t mm, uint32_t tt,
+		const int16_t *alpha_to, const int16_t *index_of);
+
+extern void pmecc_bch_set_remainders(struct _pmecc_bch *bch,
+		const volatile int16_t *remainders);
+
+extern uint32_t pmecc_bch_compute_sigma(struct _pmecc_bch *bch);
+
+extern const int16_t *pmecc_bch_get_sigma(const struct _pmecc_bch *bch);
+
+extern int32_t pmecc_bch_find_errors(const struct _pmecc_bch *bch,
+		uint32_t nb_bits, uint32_t *positions);
+
+extern void pmecc_bch_correct(uint8_t *sector, uint32_t sector_size,
+		const uint32_t *positions, uint32_t count);
+
+extern int32_t pmecc_bch_decode(struct _pmecc_bch *bch, uint8_t *sector,
+		uint32_t sector_size);
+
+#endif /* PMECC_BCH_H */
@@ -53,6 +53,14 @@ static struct dma_xfer_cfg dma_cfg = {
 	.chunk_size = DMA_CHUNK_SIZE_1,
 	.blk_size = 0,
 };
+
+/** Asynchronous command in progress */
+static struct {
+	Qspi *qspi;
+	uint32_t timeout;
+	qspi_callback_t callback;
+	void *arg;
+} async_cmd;
 #endif
 
 /*----------------------------------------------------------------------------
@@ -71,6 +79,7 @@ static void qspi_memcpy(uint8_t *dst, const uint8_t *src, int count, bool use_dm
 		dma_cfg.sa = (void *)src;
 		dma_cfg.len = count;
 		dma_configure_transfer(dma_ch, &dma_cfg);
+		dma_set_callback(dma_ch, NULL, NULL);
 		rc = dma_start_transfer(dma_ch);
 		if (rc != DMA_OK)
 			trace_fatal("Couldn't start xDMA transfer\n\r");
@@ -88,56 +97,14 @@ static void qspi_memcpy(uint8_t *dst, const uint8_t *src, int count, bool use_dm
 	}
 }
 
-/*----------------------------------------------------------------------------
- *        Public functions
- *----------------------------------------------------------------------------*/
-
-void qspi_initialize(Qspi *qspi)
-{
-	pmc_enable_peripheral(get_qspi_id_from_addr(qspi));
-
-	/* Disable write protection */
-	qspi->QSPI_WPMR = QSPI_WPMR_WPKEY_PASSWD;
-
-	/* Reset */
-	qspi->QSPI_CR = QSPI_CR_SWRST;
-
-	/* Configure */
-	qspi->QSPI_MR = QSPI_MR_SMM_MEMORY;
-	qspi->QSPI_SCR = 0;
-
-	/* Enable */
-	qspi->QSPI_CR = QSPI_CR_QSPIEN;
-}
-
-uint32_t qspi_set_baudrate(Qspi *qspi, uint32_t baudrate)
-{
-	uint32_t mck, scr, scbr;
-
-	if (!baudrate)
-		return 0;
-
-	/* Serial Clock Baudrate */
-	mck = pmc_get_peripheral_clock(get_qspi_id_from_addr(qspi));
-	scbr = (mck + baudrate - 1) / baudrate;
-	if (scbr > 0)
-		scbr--;
-
-	/* Update the Serial Clock Register */
-	scr = qspi->QSPI_SCR;
-	scr &= ~QSPI_SCR_SCBR_Msk;
-	scr |= QSPI_SCR_SCBR(scbr);
-	qspi->QSPI_SCR = scr;
-
-	return mck / (scbr + 1);
-}
-
-bool qspi_perform_command(Qspi *qspi, const struct _qspi_cmd *cmd)
+/**
+ * \brief Write the instruction frame registers for a command.
+ * \param offset returns the offset of the data in the QSPI memory space
+ */
+static bool _qspi_setup_command(Qspi *qspi, const struct _qspi_cmd *cmd,
+		uint32_t *offset)
 {
 	uint32_t iar, icr, ifr;
-	uint32_t offset;
-	uint8_t *ptr;
-	bool use_dma = false;
 
 	iar = 0;
 	icr = 0;
@@ -151,10 +118,10 @@ bool qspi_perform_command(Qspi *qspi, const struct _qspi_cmd *cmd)
 	case 3:
 		iar = (cmd->enable.data) ? 0 : QSPI_IAR_ADDR(cmd->address);
 		ifr |= QSPI_IFR_ADDREN;
-		offset = cmd->address;
+		*offset = cmd->address;
 		break;
 	case 0:
-		offset = 0;
+		*offset = 0;
 		break;
 	default:
 		return false;
@@ -234,21 +201,129 @@ bool qspi_perform_command(Qspi *qspi, const struct _qspi_cmd *cmd)
 	qspi->QSPI_ICR = icr;
 	qspi->QSPI_IFR = ifr;
 
-	/* Skip to the final steps if there is no data */
-	if (!cmd->enable.data)
-		goto no_data;
-
 	/* Dummy read of QSPI_IFR to synchronize APB and AHB accesses */
-	(void)qspi->QSPI_IFR;
+	if (cmd->enable.data)
+		(void)qspi->QSPI_IFR;
+
+	return true;
+}
+
+/**
+ * \brief Release the chip-select and wait for the end of the instruction.
+ */
+static bool _qspi_end_command(Qspi *qspi, uint32_t timeout)
+{
+	struct _timeout to;
+
+	/* Release the chip-select */
+	qspi->QSPI_CR = QSPI_CR_LASTXFER;
+
+	/* Wait for INSTRuction End */
+	timer_start_timeout(&to, timeout);
+	while (!(qspi->QSPI_SR & QSPI_SR_INSTRE)) {
+		if (timer_timeout_reached(&to)) {
+			trace_debug("qspi_perform_command timeout reached\r\n");
+			return false;
+		}
+	}
+
+	return true;
+}
 
 #ifdef CONFIG_HAVE_QSPI_DMA
-	if (((QSPI_IFR_TFRTYP_TRSFR_WRITE_MEMORY == cmd->ifr_type) &&
+static bool _qspi_can_use_dma(const struct _qspi_cmd *cmd)
+{
+	return ((QSPI_IFR_TFRTYP_TRSFR_WRITE_MEMORY == cmd->ifr_type) &&
 		 IS_CACHE_ALIGNED(cmd->tx_buffer) &&
 		 IS_CACHE_ALIGNED(cmd->buffer_len)) ||
 		((QSPI_IFR_TFRTYP_TRSFR_READ_MEMORY == cmd->ifr_type) &&
 		 IS_CACHE_ALIGNED(cmd->rx_buffer) &&
-		 IS_CACHE_ALIGNED(cmd->buffer_len)))
-		use_dma = true;
+		 IS_CACHE_ALIGNED(cmd->buffer_len));
+}
+
+static void _qspi_dma_callback(struct dma_channel *channel, void *arg)
+{
+	bool rc;
+
+	(void)arg;
+
+	dma_stop_transfer(channel);
+	dma_free_channel(channel);
+	dma_ch = NULL;
+	dsb();
+
+	rc = _qspi_end_command(async_cmd.qspi, async_cmd.timeout);
+	async_cmd.qspi = NULL;
+	if (async_cmd.callback)
+		async_cmd.callback(async_cmd.arg, rc);
+}
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Public functions
+ *----------------------------------------------------------------------------*/
+
+void qspi_initialize(Qspi *qspi)
+{
+	pmc_enable_peripheral(get_qspi_id_from_addr(qspi));
+
+	/* Disable write protection */
+	qspi->QSPI_WPMR = QSPI_WPMR_WPKEY_PASSWD;
+
+	/* Reset */
+	qspi->QSPI_CR = QSPI_CR_SWRST;
+
+	/* Configure */
+	qspi->QSPI_MR = QSPI_MR_SMM_MEMORY;
+	qspi->QSPI_SCR = 0;
+
+	/* Enable */
+	qspi->QSPI_CR = QSPI_CR_QSPIEN;
+}
+
+uint32_t qspi_set_baudrate(Qspi *qspi, uint32_t baudrate)
+{
+	uint32_t mck, scr, scbr;
+
+	if (!baudrate)
+		return 0;
+
+	/* Serial Clock Baudrate */
+	mck = pmc_get_peripheral_clock(get_qspi_id_from_addr(qspi));
+	scbr = (mck + baudrate - 1) / baudrate;
+	if (scbr > 0)
+		scbr--;
+
+	/* Update the Serial Clock Register */
+	scr = qspi->QSPI_SCR;
+	scr &= ~QSPI_SCR_SCBR_Msk;
+	scr |= QSPI_SCR_SCBR(scbr);
+	qspi->QSPI_SCR = scr;
+
+	return mck / (scbr + 1);
+}
+
+bool qspi_perform_command(Qspi *qspi, const struct _qspi_cmd *cmd)
+{
+	uint32_t offset;
+	uint8_t *ptr;
+	bool use_dma = false;
+
+#ifdef CONFIG_HAVE_QSPI_DMA
+	/* An asynchronous command is still in progress */
+	if (async_cmd.qspi)
+		return false;
+#endif
+
+	if (!_qspi_setup_command(qspi, cmd, &offset))
+		return false;
+
+	/* Skip to the final steps if there is no data */
+	if (!cmd->enable.data)
+		goto no_data;
+
+#ifdef CONFIG_HAVE_QSPI_DMA
+	use_dma = _qspi_can_use_dma(cmd);
 #endif
 
 	/* Send/Receive data */
@@ -286,18 +361,63 @@ bool qspi_perform_command(Qspi *qspi, const struct _qspi_cmd *cmd)
 	}
 
 no_data:
-	/* Release the chip-select */
-	qspi->QSPI_CR = QSPI_CR_LASTXFER;
+	return _qspi_end_command(qspi, cmd->timeout);
+}
 
-	/* Wait for INSTRuction End */
-	struct _timeout timeout;
-	timer_start_timeout(&timeout, cmd->timeout);
-	while (!(qspi->QSPI_SR & QSPI_SR_INSTRE)) {
-		if (timer_timeout_reached(&timeout)) {
-			trace_debug("qspi_perform_command timeout reached\r\n");
+bool qspi_perform_command_async(Qspi *qspi, const struct _qspi_cmd *cmd,
+		qspi_callback_t callback, void *arg)
+{
+#ifdef CONFIG_HAVE_QSPI_DMA
+	uint32_t offset;
+	uint8_t *ptr;
+
+	if (cmd->enable.data && cmd->tx_buffer && _qspi_can_use_dma(cmd)) {
+		if (async_cmd.qspi)
+			return false;
+
+		dma_ch = dma_allocate_channel(DMA_PERIPH_MEMORY, DMA_PERIPH_MEMORY);
+		if (!dma_ch)
+			return false;
+
+		if (!_qspi_setup_command(qspi, cmd, &offset)) {
+			dma_free_channel(dma_ch);
+			dma_ch = NULL;
+			return false;
+		}
+
+#ifdef CONFIG_HAVE_AESB
+		if (cmd->use_aesb)
+			ptr = (uint8_t*)get_qspi_aesb_mem_from_addr(qspi);
+		else
+#endif
+			ptr = (uint8_t*)get_qspi_mem_from_addr(qspi);
+
+		async_cmd.qspi = qspi;
+		async_cmd.timeout = cmd->timeout;
+		async_cmd.callback = callback;
+		async_cmd.arg = arg;
+
+		cache_clean_region(cmd->tx_buffer, cmd->buffer_len);
+		dma_cfg.da = (void *)(ptr + offset);
+		dma_cfg.sa = (void *)cmd->tx_buffer;
+		dma_cfg.len = cmd->buffer_len;
+		dma_configure_transfer(dma_ch, &dma_cfg);
+		dma_set_callback(dma_ch, _qspi_dma_callback, NULL);
+		if (dma_start_transfer(dma_ch) != DMA_OK) {
+			dma_free_channel(dma_ch);
+			dma_ch = NULL;
+			async_cmd.qspi = NULL;
+			qspi->QSPI_CR = QSPI_CR_LASTXFER;
 			return false;
 		}
+		return true;
 	}
+#endif
 
+	/* No DMA: perform the command now */
+	if (!qspi_perform_command(qspi, cmd))
+		return false;
+	if (callback)
+		callback(arg, true);
 	return true;
 }
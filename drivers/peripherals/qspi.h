@@ -42,6 +42,9 @@
  *        Types
  *----------------------------------------------------------------------------*/
 
+/** Completion callback of an asynchronous QSPI command */
+typedef void (*qspi_callback_t)(void *arg, bool success);
+
 /** QSPI Command structure */
 struct _qspi_cmd {
 	/** Data Transfer Type (QSPI_IFR_TFRTYP_TRSFR_xxx) */
@@ -141,6 +144,27 @@ uint32_t qspi_set_baudrate(Qspi *qspi, uint32_t baudrate);
  */
 bool qspi_perform_command(Qspi *qspi, const struct _qspi_cmd *cmd);
 
+/**
+ * \brief Start a QSPI command without waiting for its data transfer.
+ *
+ * Memory writes from a cache-aligned buffer of a cache-aligned size are
+ * transferred by DMA and the function returns as soon as the transfer is
+ * started; the callback is then invoked from the DMA completion callback,
+ * once the chip-select is released. Other commands are performed
+ * synchronously and the callback is invoked before the function returns.
+ *
+ * Only one asynchronous command can be in progress, qspi_perform_command
+ * fails until it completes.
+ *
+ * \param qspi the QSPI instance
+ * \param cmd the QSPI command to perform
+ * \param callback function invoked at the end of the command (may be NULL)
+ * \param arg argument of the callback
+ * \return true if the command was succesfully started, false otherwise
+ */
+bool qspi_perform_command_async(Qspi *qspi, const struct _qspi_cmd *cmd,
+		qspi_callback_t callback, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -67,6 +67,7 @@
 #include "trace.h"
 #include "chip.h"
 #include "intmath.h"
+#include "prof.h"
 #include "timer.h"
 #include "peripherals/pmc.h"
 #include "peripherals/tc.h"
@@ -1054,12 +1055,16 @@ End:
 
 static void sdmmc0_handler(void)
 {
+	PROF_BEGIN(sdmmc0_irq);
 	sdmmc_poll(sdmmc0_set);
+	PROF_END(sdmmc0_irq);
 }
 
 static void sdmmc1_handler(void)
 {
+	PROF_BEGIN(sdmmc1_irq);
 	sdmmc_poll(sdmmc1_set);
+	PROF_END(sdmmc1_irq);
 }
 
 /**
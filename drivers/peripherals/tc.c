@@ -240,6 +240,13 @@ void tc_get_ra_rb_rc(Tc *tc, uint32_t channel,
 		*rc = ch->TC_RC;
 }
 
+uint32_t tc_get_cv(Tc *tc, uint32_t channel)
+{
+	assert(channel < ARRAY_SIZE(tc->TC_CHANNEL));
+
+	return tc->TC_CHANNEL[channel].TC_CV;
+}
+
 #ifdef CONFIG_HAVE_TC_FAULT_MODE
 
 void tc_set_fault_mode(Tc *tc, uint32_t mode)
@@ -166,6 +166,14 @@ extern void tc_set_ra_rb_rc(Tc* tc, uint32_t channel,
 extern void tc_get_ra_rb_rc(Tc* tc, uint32_t channel,
 	uint32_t *ra, uint32_t *rb, uint32_t *rc);
 
+/**
+ * \brief Get the current counter value of a Timer Counter
+ * \param tc Pointer to Tc instance
+ * \param channel channel number of the Timer Counter
+ * \return Counter value
+ */
+extern uint32_t tc_get_cv(Tc* tc, uint32_t channel);
+
 #ifdef CONFIG_HAVE_TC_FAULT_MODE
 
 /**
@@ -63,6 +63,7 @@
 
 #include <assert.h>
 #include "compiler.h"
+#include "prof.h"
 
 /*----------------------------------------------------------------------------
  *        Local definitions
@@ -125,6 +126,8 @@ static void xdmacd_handler(void)
 {
 	uint32_t cont;
 
+	PROF_BEGIN(xdmacd_irq);
+
 	for (cont= 0; cont< XDMAC_CONTROLLERS; cont++) {
 		uint32_t chan, gis, gcs;
 
@@ -173,6 +176,8 @@ static void xdmacd_handler(void)
 			}
 		}
 	}
+
+	PROF_END(xdmacd_irq);
 }
 
 
@@ -45,6 +45,7 @@
 
 #include "chip.h"
 #include "trace.h"
+#include "prof.h"
 
 #include "peripherals/aic.h"
 #include "misc/cache.h"
@@ -88,6 +89,14 @@
 /** Buffer list is null */
 #define MBL_NULL        2
 
+/** Number of DMA descriptors of a multi-buffer-list endpoint, at most
+ *  MBL_DMA_DESC_COUNT - 1 buffers are loaded in the DMA at a time */
+#define MBL_DMA_DESC_COUNT    8
+
+/** Only one buffer every MBL_DMA_IRQ_INTERVAL (and the last loaded one)
+ *  raises a DMA interrupt */
+#define MBL_DMA_IRQ_INTERVAL  (MBL_DMA_DESC_COUNT / 2)
+
 /*---------------------------------------------------------------------------
  *      Types
  *---------------------------------------------------------------------------*/
@@ -164,6 +173,15 @@ struct _multi_xfer {
 
 	/**  Current buffer for input (run time) */
 	uint16_t in;
+
+	/**  First DMA descriptor in use (run time) */
+	uint8_t desc_out;
+
+	/**  Number of DMA descriptors in use (run time) */
+	uint8_t desc_busy;
+
+	/**  DMA channel is walking the descriptors (run time) */
+	bool dma_running;
 };
 
 /**
@@ -240,6 +258,10 @@ static bool force_full_speed = false;
 /** DMA link list */
 CACHE_ALIGNED static struct _udphs_dma_desc dma_desc[4];
 
+/** DMA descriptor rings for multi-buffer-list transfers */
+CACHE_ALIGNED static struct _udphs_dma_desc
+	mbl_dma_desc[UDPHSDMA_NUMBER][MBL_DMA_DESC_COUNT];
+
 /*---------------------------------------------------------------------------
  *      Internal Functions
  *---------------------------------------------------------------------------*/
@@ -351,10 +373,16 @@ static void udphs_end_of_transfer(uint8_t ep, uint8_t status)
 					endpoint->state == UDPHS_ENDPOINT_RECEIVINGM ? "R" : "S",
 					(unsigned)ep);
 
+			/* Stop walking the descriptors */
+			UDPHS->UDPHS_DMA[ep].UDPHS_DMACONTROL = 0;
+
 			endpoint->state = UDPHS_ENDPOINT_IDLE;
 			xfer->list_state = 0;
 			xfer->out = 0;
 			xfer->in = 0;
+			xfer->desc_out = 0;
+			xfer->desc_busy = 0;
+			xfer->dma_running = false;
 
 			/* Invoke callback */
 			if (endpoint->transfer.callback) {
@@ -371,80 +399,6 @@ static void udphs_end_of_transfer(uint8_t ep, uint8_t status)
 	}
 }
 
-/**
- * Update multi-buffer-transfer descriptors.
- * \param pTransfer Pointer to instance MblTransfer.
- * \param size      Size of bytes that processed.
- * \param forceEnd  Force the buffer END.
- * \return 1 if current buffer ended.
- */
-static uint8_t udphs_multi_update(struct _multi_xfer *xfer,
-		struct _usbd_transfer_buffer *buffer, uint16_t size, uint8_t force_end)
-{
-	/* Update transfer descriptor */
-	buffer->remaining -= size;
-
-	/* Check if list NULL */
-	if (xfer->list_state == MBL_NULL)
-		return 1;
-
-	/* Check if current buffer ended */
-	if (buffer->remaining == 0 || force_end || size == 0) {
-		/* Process to next buffer */
-		xfer->out++;
-		if (xfer->out == xfer->list_size)
-			xfer->out = 0;
-
-		/* Check buffer NULL case */
-		if (xfer->out == xfer->in) {
-			xfer->list_state = MBL_NULL;
-		} else {
-			/* Continue transfer, prepare for next operation */
-			xfer->list_state = 0;
-			buffer = &xfer->buffers[xfer->out];
-			buffer->buffered = 0;
-			buffer->transferred = 0;
-			buffer->remaining = buffer->size;
-		}
-		return 1;
-	}
-
-	return 0;
-}
-
-/**
- * Transfers a data payload from the current tranfer buffer to the endpoint
- * FIFO
- * \param ep Number of the endpoint which is sending data.
- */
-static void udphs_write_fifo_multi(uint8_t ep)
-{
-	struct _endpoint *endpoint = &endpoints[ep];
-	struct _multi_xfer *xfer = &endpoint->transfer.multi;
-	volatile uint8_t *fifo;
-	uint32_t size;
-	struct _usbd_transfer_buffer *buffer = &xfer->buffers[xfer->out];
-
-	volatile uint8_t *pBytes;
-
-	/* Get the number of bytes to send */
-	size = endpoint->size;
-	if (size > buffer->remaining)
-		size = buffer->remaining;
-
-	USB_HAL_TRACE("w%d.%d ", xfer->out, (unsigned)size);
-
-	pBytes = &buffer->buffer[buffer->transferred + buffer->buffered];
-	buffer->buffered += size;
-	udphs_multi_update(xfer, buffer, size, 0);
-
-	/* Write packet in the FIFO buffer */
-	fifo = ((uint8_t*)UDPHS_RAM_ADDR) + EPT_VIRTUAL_SIZE * ep;
-	for (; size; size--)
-		*(fifo++) = *(pBytes++);
-	dmb();
-}
-
 /**
  * Transfers a data payload from the current tranfer buffer to the endpoint
  * FIFO
@@ -537,11 +491,8 @@ static void udphs_endpoint_handler(uint8_t ep)
 			!(status & UDPHS_EPTSTA_TXRDY)) {
 		USB_HAL_TRACE("Wr ");
 
-		/* Multi-buffer-list transfer state */
-		if (endpoint->state == UDPHS_ENDPOINT_SENDINGM) {
-		}
 		/* Sending state */
-		else if (endpoint->state == UDPHS_ENDPOINT_SENDING) {
+		if (endpoint->state == UDPHS_ENDPOINT_SENDING) {
 			if (xfer->buffered) {
 				xfer->transferred += xfer->buffered;
 				xfer->buffered = 0;
@@ -711,6 +662,178 @@ static void udphs_dma_single(uint8_t ep, struct _single_xfer *xfer, uint32_t cfg
 		UDPHS_DMACONTROL_BUFF_LENGTH(xfer->buffered);
 }
 
+/**
+ * Number of buffers queued in a multi-buffer-list.
+ * \param xfer Pointer to the multi-buffer transfer
+ */
+static uint16_t udphs_multi_queued(const struct _multi_xfer *xfer)
+{
+	if (xfer->list_state == MBL_FULL)
+		return xfer->list_size;
+	return (xfer->in + xfer->list_size - xfer->out) % xfer->list_size;
+}
+
+/**
+ * Load the queued buffers of a multi-buffer-list in the free DMA descriptors
+ * and chain them after the descriptors already in use.
+ * Must be called with the interrupts disabled.
+ * \param ep EP number
+ */
+static void udphs_dma_multi_load(uint8_t ep)
+{
+	struct _endpoint *endpoint = &endpoints[ep];
+	struct _multi_xfer *xfer = &endpoint->transfer.multi;
+	struct _udphs_dma_desc *ring = mbl_dma_desc[ep];
+	struct _udphs_dma_desc *desc, *prev;
+	struct _usbd_transfer_buffer *buffer;
+	uint32_t ctrl;
+	uint8_t idx;
+
+	/* The buffers from 'out' are loaded in the descriptors in use */
+	while (xfer->desc_busy < MBL_DMA_DESC_COUNT - 1 &&
+			xfer->desc_busy < udphs_multi_queued(xfer)) {
+		buffer = &xfer->buffers[(xfer->out + xfer->desc_busy) %
+			xfer->list_size];
+		buffer->buffered = buffer->size;
+
+		/* The new descriptor is the last of the chain: it does not load
+		 * its successor and always raises an interrupt */
+		idx = (xfer->desc_out + xfer->desc_busy) % MBL_DMA_DESC_COUNT;
+		desc = &ring[idx];
+		ctrl = UDPHS_DMACONTROL_CHANN_ENB |
+			UDPHS_DMACONTROL_BUFF_LENGTH(buffer->size) |
+			UDPHS_DMACONTROL_END_BUFFIT;
+		if (endpoint->state == UDPHS_ENDPOINT_SENDINGM)
+			ctrl |= UDPHS_DMACONTROL_END_B_EN;
+		desc->next = &ring[(idx + 1) % MBL_DMA_DESC_COUNT];
+		desc->addr = buffer->buffer;
+		desc->ctrl = ctrl;
+		desc->reserved = 0;
+		cache_clean_region(desc, sizeof(*desc));
+
+		/* Chain it to the previous one. If the DMA loaded the previous
+		 * descriptor already, the channel stops at its end and the DMA
+		 * handler restarts it. */
+		if (xfer->desc_busy) {
+			prev = &ring[(idx + MBL_DMA_DESC_COUNT - 1) %
+				MBL_DMA_DESC_COUNT];
+			ctrl = prev->ctrl | UDPHS_DMACONTROL_LDNXT_DSC;
+			if ((prev - ring) % MBL_DMA_IRQ_INTERVAL !=
+					MBL_DMA_IRQ_INTERVAL - 1)
+				ctrl &= ~UDPHS_DMACONTROL_END_BUFFIT;
+			dmb();
+			prev->ctrl = ctrl;
+			cache_clean_region(prev, sizeof(*prev));
+		}
+
+		xfer->desc_busy++;
+	}
+}
+
+/**
+ * Start the DMA channel of a multi-buffer-list endpoint on the first
+ * descriptor in use.
+ * \param ep EP number
+ */
+static void udphs_dma_multi_start(uint8_t ep)
+{
+	struct _multi_xfer *xfer = &endpoints[ep].transfer.multi;
+
+	if (!xfer->desc_busy)
+		return;
+
+	USB_HAL_TRACE("DmaM%d@%d ", ep, xfer->desc_out);
+
+	xfer->dma_running = true;
+	UDPHS->UDPHS_IEN |= UDPHS_IEN_DMA_1 << (ep - 1);
+	UDPHS->UDPHS_DMA[ep].UDPHS_DMANXTDSC =
+		(uint32_t)&mbl_dma_desc[ep][xfer->desc_out];
+	UDPHS->UDPHS_DMA[ep].UDPHS_DMACONTROL = 0;
+	UDPHS->UDPHS_DMA[ep].UDPHS_DMACONTROL = UDPHS_DMACONTROL_LDNXT_DSC;
+}
+
+/**
+ * DMA interrupt handler of a multi-buffer-list endpoint.
+ * Releases the buffers of all descriptors the DMA channel is done with,
+ * invoking the transfer callback once per buffer, then loads the buffers
+ * queued meanwhile and restarts the channel if it stopped.
+ * \param ep EP number
+ */
+static void udphs_dma_multi_handler(uint8_t ep)
+{
+	struct _endpoint *endpoint = &endpoints[ep];
+	struct _multi_xfer *xfer = &endpoint->transfer.multi;
+	struct _usbd_transfer_buffer *buffer;
+	uint32_t dma_status, next;
+	uint8_t done;
+
+	dma_status = UDPHS->UDPHS_DMA[ep].UDPHS_DMASTATUS;
+	next = UDPHS->UDPHS_DMA[ep].UDPHS_DMANXTDSC;
+
+	if (!xfer->dma_running)
+		return;
+
+	/* The descriptor before 'next' is the last one loaded. It is still in
+	 * progress unless the channel stopped. */
+	next = (next - (uint32_t)mbl_dma_desc[ep]) /
+		sizeof(struct _udphs_dma_desc);
+	done = (next + MBL_DMA_DESC_COUNT - 1 - xfer->desc_out) %
+		MBL_DMA_DESC_COUNT;
+	if (!(dma_status & UDPHS_DMASTATUS_CHANN_ENB)) {
+		xfer->dma_running = false;
+		done++;
+	}
+	if (done > xfer->desc_busy)
+		done = xfer->desc_busy;
+
+	USB_HAL_TRACE("iDmaM%d,%x:%d ", ep, (unsigned)dma_status, done);
+
+	for (; done; done--) {
+		buffer = &xfer->buffers[xfer->out];
+		buffer->transferred = buffer->buffered;
+		buffer->buffered = 0;
+		buffer->remaining = 0;
+		if (endpoint->state == UDPHS_ENDPOINT_RECEIVINGM &&
+				buffer->transferred)
+			cache_invalidate_region(buffer->buffer,
+					buffer->transferred);
+
+		/* Release the buffer before the callback, which may queue
+		 * a new one */
+		xfer->desc_out = (xfer->desc_out + 1) % MBL_DMA_DESC_COUNT;
+		xfer->desc_busy--;
+		xfer->out++;
+		if (xfer->out == xfer->list_size)
+			xfer->out = 0;
+		xfer->list_state = xfer->out == xfer->in ? MBL_NULL : 0;
+
+		if (endpoint->transfer.callback)
+			endpoint->transfer.callback(
+					endpoint->transfer.callback_arg,
+					USBD_STATUS_SUCCESS,
+					buffer->transferred,
+					udphs_multi_queued(xfer));
+
+		/* Transfer aborted by the callback */
+		if (endpoint->state != UDPHS_ENDPOINT_SENDINGM &&
+				endpoint->state != UDPHS_ENDPOINT_RECEIVINGM)
+			return;
+	}
+
+	udphs_dma_multi_load(ep);
+
+	if (!xfer->dma_running) {
+		if (xfer->desc_busy) {
+			/* Chain stopped before the buffers queued meanwhile */
+			udphs_dma_multi_start(ep);
+		} else {
+			/* List empty, restart from udphs_add_buffer() */
+			USB_HAL_TRACE("MblNull ");
+			endpoint->state = UDPHS_ENDPOINT_IDLE;
+		}
+	}
+}
+
 /**
  * Endpoint DMA interrupt handler.
  * This function handles DMA interrupts.
@@ -723,16 +846,15 @@ static void udphs_dma_handler(uint8_t ep)
 	uint32_t dma_status, remaining, transferred;
 	uint8_t rc = USBD_STATUS_SUCCESS;
 
-	dma_status = UDPHS->UDPHS_DMA[ep].UDPHS_DMASTATUS;
-	USB_HAL_TRACE("iDma%d,%x ", ep, (unsigned)dma_status);
-
 	/* Multi transfer */
-	if (endpoint->state == UDPHS_ENDPOINT_SENDINGM ||
-		endpoint->state == UDPHS_ENDPOINT_RECEIVINGM) {
-		/* Not implemented */
+	if (endpoint->transfer.use_multi) {
+		udphs_dma_multi_handler(ep);
 		return;
 	}
 
+	dma_status = UDPHS->UDPHS_DMA[ep].UDPHS_DMASTATUS;
+	USB_HAL_TRACE("iDma%d,%x ", ep, (unsigned)dma_status);
+
 	/* Disable DMA interrupt to avoid receiving 2 (B_EN and TR_EN) */
 	UDPHS->UDPHS_DMA[ep].UDPHS_DMACONTROL &=
 		~(UDPHS_DMACONTROL_END_TR_EN | UDPHS_DMACONTROL_END_B_EN);
@@ -862,21 +984,19 @@ static uint8_t udphs_write(uint8_t ep,
 }
 
 /**
- * Sends data through a USB endpoint. Sets up the transfer descriptor list,
- * writes one or two data payloads (depending on the number of FIFO bank
- * for the endpoint) and then starts the actual transfer. The operation is
- * complete when all the transfer buffer in the list has been sent.
+ * Queues a buffer to send or receive through a USB endpoint in
+ * multi-buffer-list mode. The buffer is loaded in a DMA descriptor chained
+ * to the previous ones, so the controller walks the list without CPU
+ * intervention. The transfer starts once start_offset buffers are queued
+ * (see usbd_hal_setup_multi_transfer()) and stops when the list runs empty.
  *
- * *If the size of the buffer is greater than the size of the endpoint
- *  (or twice the size if the endpoint has two FIFO banks), then the buffer
- *  must be kept allocated until the transfer is finished*. This means that
- *  it is not possible to declare it on the stack (i.e. as a local variable
- *  of a function which returns after starting a transfer).
+ * *The buffer must be kept allocated until the transfer callback reports
+ *  its completion.*
  *
- * \param endpoint Pointer to Endpoint struct.
- * \param data Pointer to a buffer with the data to send.
- * \param data_len Size of the data buffer.
- * \return USBD_STATUS_SUCCESS if the transfer has been started;
+ * \param ep Endpoint number.
+ * \param data Pointer to the buffer.
+ * \param data_len Size of the buffer.
+ * \return USBD_STATUS_SUCCESS if the buffer has been queued;
  *         otherwise, the corresponding error status code.
  */
 static uint8_t udphs_add_buffer(uint8_t ep,
@@ -886,22 +1006,28 @@ static uint8_t udphs_add_buffer(uint8_t ep,
 	struct _endpoint *endpoint = &endpoints[ep];
 	struct _multi_xfer *xfer = &endpoint->transfer.multi;
 	struct _usbd_transfer_buffer *tx;
+	uint32_t cpsr;
 
 	/* Check parameter */
 	if (data_len >= 0x10000)
 		return USBD_STATUS_INVALID_PARAMETER;
 
+	cpsr = cpsr_get();
+	cpsr_set_bits(CPSR_MASK_IRQ);
+
 	/* Data in process */
 	if (endpoint->state > UDPHS_ENDPOINT_IDLE) {
 		/* MBL transfer */
 		if (!endpoint->transfer.use_multi ||
 				xfer->list_state == MBL_FULL) {
+			if (!(cpsr & CPSR_MASK_IRQ))
+				cpsr_clear_bits(CPSR_MASK_IRQ);
 			trace_warning("udphs_add_buffer: EP%d not idle\n\r", ep);
 			return USBD_STATUS_LOCKED;
 		}
 	}
 
-	USB_HAL_TRACE("AddW%d(%d) ", ep, (unsigned)data_len);
+	USB_HAL_TRACE("AddM%d(%d) ", ep, (unsigned)data_len);
 
 	/* Add buffer to buffer list and update index */
 	tx = &xfer->buffers[xfer->in];
@@ -920,28 +1046,26 @@ static uint8_t udphs_add_buffer(uint8_t ep,
 	else
 		xfer->list_state = 0;
 
-	/* Start sending when offset achieved */
-	if (MBL_NbBuffer(xfer->in, xfer->out, xfer->list_size) >= xfer->offset &&
-			endpoint->state == UDPHS_ENDPOINT_IDLE) {
-		uint8_t nb_banks = CHIP_USB_ENDPOINT_BANKS(ep);
-
-		/* Change state */
-		endpoint->state = UDPHS_ENDPOINT_SENDINGM;
-
-		USB_HAL_TRACE("StartM ");
+	if (endpoint->state == UDPHS_ENDPOINT_IDLE) {
+		/* Start when offset achieved */
+		if (udphs_multi_queued(xfer) >= xfer->offset) {
+			USB_HAL_TRACE("StartM ");
 
-		/* Fill data into FIFO */
-		for (; nb_banks && xfer->buffers[xfer->in].remaining; nb_banks--) {
-			udphs_write_fifo_multi(ep);
-			ept->UDPHS_EPTSETSTA = UDPHS_EPTSETSTA_TXRDY;
+			if (ept->UDPHS_EPTCFG & UDPHS_EPTCFG_EPT_DIR)
+				endpoint->state = UDPHS_ENDPOINT_SENDINGM;
+			else
+				endpoint->state = UDPHS_ENDPOINT_RECEIVINGM;
+			udphs_dma_multi_load(ep);
+			udphs_dma_multi_start(ep);
 		}
-
-		/* Enable interrupt */
-		UDPHS->UDPHS_IEN |= UDPHS_IEN_EPT_0 << ep;
-		ept->UDPHS_EPTCTLENB = UDPHS_EPTCTLENB_TXRDY;
-
+	} else {
+		/* Chain to the running list */
+		udphs_dma_multi_load(ep);
 	}
 
+	if (!(cpsr & CPSR_MASK_IRQ))
+		cpsr_clear_bits(CPSR_MASK_IRQ);
+
 	return USBD_STATUS_SUCCESS;
 }
 
@@ -1018,6 +1142,8 @@ static void udphs_irq_handler(void)
 {
 	uint32_t status;
 
+	PROF_BEGIN(udphs_irq);
+
 	status = UDPHS->UDPHS_INTSTA;
 	status &= UDPHS->UDPHS_IEN;
 
@@ -1106,6 +1232,8 @@ static void udphs_irq_handler(void)
 			USB_HAL_TRACE(" - ");
 		}
 	}
+
+	PROF_END(udphs_irq);
 }
 
 /*---------------------------------------------------------------------------
@@ -1337,8 +1465,12 @@ uint8_t usbd_hal_set_transfer_callback(uint8_t ep,
 
 /**
  * Configure an endpoint to use multi-buffer-list transfer mode.
- * The buffers can be added by _Read/_Write function.
- * \param ep Endpoint number.
+ * The buffers can be added by _Read/_Write function. They are transferred
+ * by the endpoint DMA channel through a ring of chained descriptors, and the
+ * transfer callback is invoked once per completed buffer with the number of
+ * bytes of the buffer and the number of buffers still queued.
+ * OUT buffers complete when full: short packets do not close them.
+ * \param ep Endpoint number, must have a DMA channel.
  * \param list  Pointer to a multi-buffer list used, NULL to disable MBL.
  * \param list_size  Multi-buffer list size (number of buffers can be queued)
  * \param start_offset When number of buffer achieve this offset transfer start
@@ -1359,8 +1491,12 @@ uint8_t usbd_hal_setup_multi_transfer(uint8_t ep,
 
 	/* Enable Multi-Buffer Transfer List */
 	if (list) {
+		if (!CHIP_USB_ENDPOINT_HAS_DMA(ep) ||
+				ep >= UDPHSDMA_NUMBER || !list_size)
+			return USBD_STATUS_HW_NOT_SUPPORTED;
+
 		/* Reset list items */
-		for (i = 0; i < list_size; i--) {
+		for (i = 0; i < list_size; i++) {
 			list[i].buffer = NULL;
 			list[i].size = 0;
 			list[i].transferred = 0;
@@ -1376,6 +1512,9 @@ uint8_t usbd_hal_setup_multi_transfer(uint8_t ep,
 		xfer->out = 0;
 		xfer->in = 0;
 		xfer->offset = start_offset;
+		xfer->desc_out = 0;
+		xfer->desc_busy = 0;
+		xfer->dma_running = false;
 	}
 	/* Disable Multi-Buffer Transfer */
 	else {
@@ -1616,6 +1755,9 @@ uint16_t usbd_hal_get_data_size(uint8_t ep)
  * finishes either when the buffer is full, or a short packet (inferior to
  * endpoint maximum  size) is received.
  *
+ * In multi-buffer-list mode, the buffer is queued to the list instead (see
+ * usbd_hal_setup_multi_transfer()).
+ *
  * *The buffer must be kept allocated until the transfer is finished*.
  * \param ep Endpoint number.
  * \param data Pointer to a data buffer.
@@ -1625,12 +1767,10 @@ uint16_t usbd_hal_get_data_size(uint8_t ep)
  */
 uint8_t usbd_hal_read(uint8_t ep, void *data, uint32_t data_len)
 {
-	if (endpoints[ep].transfer.use_multi) {
-		trace_warning("usbd_hal_read does not support 'multi' transfers\r\n");
-		return USBD_STATUS_SW_NOT_SUPPORTED;
-	} else {
+	if (endpoints[ep].transfer.use_multi)
+		return udphs_add_buffer(ep, data, data_len);
+	else
 		return udphs_read(ep, data, data_len);
-	}
 }
 
 /**
@@ -0,0 +1,567 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/* iperf 2 compatible throughput test, TCP and UDP, server and client. */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include "liblwip.h"
+#include "lwip/opt.h"
+#include "lwip/tcp.h"
+#include "lwip/udp.h"
+#include "lwip/inet.h"
+
+#include "iperf.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !LWIP_UDP
+#error The iperf example requires LWIP_UDP (CONFIG_LIB_LWIP_THROUGHPUT)
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the UDP datagrams (iperf default) */
+#define IPERF_UDP_LEN 1470
+
+/** Maximum number of datagrams sent by one call to iperf_poll() */
+#define IPERF_UDP_BURST 8
+
+/** Number of attempts to get the server report at the end of a UDP test */
+#define IPERF_FIN_RETRIES 10
+
+/** Delay between two attempts, in ms */
+#define IPERF_FIN_INTERVAL 250
+
+/** Version flag of the iperf headers */
+#define IPERF_HEADER_VERSION1 0x80000000
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Header of the UDP datagrams */
+struct _iperf_udp_hdr {
+	int32_t id;
+	uint32_t sec;
+	uint32_t usec;
+};
+
+/** Header sent by the client at the start of a test. All zero: no
+ * bidirectional test */
+struct _iperf_client_hdr {
+	int32_t flags;
+	int32_t threads;
+	int32_t port;
+	int32_t buffer_len;
+	int32_t bandwidth;
+	int32_t amount;
+};
+
+/** Report sent back by the UDP server */
+struct _iperf_server_hdr {
+	int32_t flags;
+	int32_t total_len1;
+	int32_t total_len2;
+	int32_t stop_sec;
+	int32_t stop_usec;
+	int32_t error_cnt;
+	int32_t outorder_cnt;
+	int32_t datagrams;
+	int32_t jitter1;
+	int32_t jitter2;
+};
+
+struct _iperf_udp_report {
+	struct _iperf_udp_hdr udp;
+	struct _iperf_server_hdr server;
+};
+
+/*----------------------------------------------------------------------------
+ *        Variables
+ *----------------------------------------------------------------------------*/
+
+/** Payload of the TCP segments and UDP datagrams, sent without copy */
+static uint8_t iperf_pattern[IPERF_UDP_LEN];
+
+static const struct _iperf_client_hdr iperf_client_hdr;
+
+static struct {
+	struct tcp_pcb *pcb;
+	uint32_t start;
+	uint32_t bytes;
+} tcp_server;
+
+static struct {
+	struct tcp_pcb *pcb;
+	uint32_t start;
+	uint32_t duration;
+	uint32_t bytes;
+} tcp_client;
+
+static struct {
+	bool active;
+	uint32_t start;
+	uint32_t duration;
+	uint32_t bytes;
+	int32_t last_id;
+	uint32_t lost;
+	uint32_t outorder;
+} udp_server;
+
+static struct {
+	struct udp_pcb *pcb;
+	struct ip_addr server;
+	bool active;
+	uint32_t start;
+	uint32_t duration;
+	uint32_t rate;
+	uint32_t bytes;
+	int32_t id;
+	uint32_t fin_count;
+	uint32_t fin_time;
+} udp_client;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _iperf_report(const char *name, uint32_t bytes, uint32_t duration)
+{
+	uint32_t rate = 0;
+
+	/* bits per ms are kbit/s */
+	if (duration)
+		rate = (uint32_t)(((uint64_t)bytes * 8) / duration);
+	printf("%s: %u bytes in %u ms, %u kbit/s\r\n", name,
+			(unsigned)bytes, (unsigned)duration, (unsigned)rate);
+}
+
+static err_t _tcp_server_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+		err_t err)
+{
+	(void)arg;
+	(void)err;
+
+	if (p == NULL) {
+		/* the client closed the connection */
+		_iperf_report("TCP server", tcp_server.bytes,
+				sys_get_ms() - tcp_server.start);
+		tcp_err(pcb, NULL);
+		tcp_recv(pcb, NULL);
+		tcp_close(pcb);
+		tcp_server.pcb = NULL;
+		return ERR_OK;
+	}
+
+	tcp_server.bytes += p->tot_len;
+	tcp_recved(pcb, p->tot_len);
+	pbuf_free(p);
+	return ERR_OK;
+}
+
+static void _tcp_server_err(void *arg, err_t err)
+{
+	(void)arg;
+
+	printf("TCP server: connection lost (%d)\r\n", err);
+	tcp_server.pcb = NULL;
+}
+
+static err_t _tcp_server_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+	(void)arg;
+
+	if (err != ERR_OK)
+		return err;
+
+	/* one test at a time, the connection is aborted */
+	if (tcp_server.pcb)
+		return ERR_MEM;
+
+	tcp_server.pcb = pcb;
+	tcp_server.start = sys_get_ms();
+	tcp_server.bytes = 0;
+	tcp_recv(pcb, _tcp_server_recv);
+	tcp_err(pcb, _tcp_server_err);
+	return ERR_OK;
+}
+
+static void _tcp_client_close(void)
+{
+	struct tcp_pcb *pcb = tcp_client.pcb;
+
+	_iperf_report("TCP client", tcp_client.bytes,
+			sys_get_ms() - tcp_client.start);
+	tcp_err(pcb, NULL);
+	tcp_sent(pcb, NULL);
+	tcp_recv(pcb, NULL);
+	tcp_close(pcb);
+	tcp_client.pcb = NULL;
+}
+
+static void _tcp_client_send(struct tcp_pcb *pcb)
+{
+	u16_t len;
+
+	/* queue full-sized segments as long as the send buffer allows */
+	for (;;) {
+		len = tcp_sndbuf(pcb);
+		if (len > TCP_MSS)
+			len = TCP_MSS;
+		if (len > sizeof(iperf_pattern))
+			len = sizeof(iperf_pattern);
+		if (len < TCP_MSS)
+			break;
+		if (tcp_write(pcb, iperf_pattern, len, 0) != ERR_OK)
+			break;
+	}
+	tcp_output(pcb);
+}
+
+static err_t _tcp_client_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+	(void)arg;
+
+	tcp_client.bytes += len;
+	if ((sys_get_ms() - tcp_client.start) >= tcp_client.duration)
+		_tcp_client_close();
+	else
+		_tcp_client_send(pcb);
+	return ERR_OK;
+}
+
+static err_t _tcp_client_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+		err_t err)
+{
+	(void)arg;
+	(void)err;
+
+	if (p == NULL) {
+		_tcp_client_close();
+		return ERR_OK;
+	}
+	tcp_recved(pcb, p->tot_len);
+	pbuf_free(p);
+	return ERR_OK;
+}
+
+static void _tcp_client_err(void *arg, err_t err)
+{
+	(void)arg;
+
+	printf("TCP client: connection lost (%d)\r\n", err);
+	tcp_client.pcb = NULL;
+}
+
+static err_t _tcp_client_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+	(void)arg;
+
+	if (err != ERR_OK)
+		return err;
+
+	tcp_client.start = sys_get_ms();
+	tcp_client.bytes = 0;
+	tcp_write(pcb, &iperf_client_hdr, sizeof(iperf_client_hdr), 0);
+	_tcp_client_send(pcb);
+	return ERR_OK;
+}
+
+static void _udp_server_ack(struct udp_pcb *pcb, const struct _iperf_udp_hdr *hdr,
+		struct ip_addr *addr, u16_t port)
+{
+	struct _iperf_udp_report report;
+	struct pbuf *p;
+
+	memset(&report, 0, sizeof(report));
+	report.udp = *hdr;
+	report.server.flags = htonl(IPERF_HEADER_VERSION1);
+	report.server.total_len2 = htonl(udp_server.bytes);
+	report.server.stop_sec = htonl(udp_server.duration / 1000);
+	report.server.stop_usec = htonl((udp_server.duration % 1000) * 1000);
+	report.server.error_cnt = htonl(udp_server.lost);
+	report.server.outorder_cnt = htonl(udp_server.outorder);
+	report.server.datagrams = htonl(udp_server.last_id + 1);
+
+	p = pbuf_alloc(PBUF_TRANSPORT, sizeof(report), PBUF_RAM);
+	if (p == NULL)
+		return;
+	memcpy(p->payload, &report, sizeof(report));
+	udp_sendto(pcb, p, addr, port);
+	pbuf_free(p);
+}
+
+static void _udp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+		struct ip_addr *addr, u16_t port)
+{
+	struct _iperf_udp_hdr hdr;
+	int32_t id;
+
+	(void)arg;
+
+	if (pbuf_copy_partial(p, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+		pbuf_free(p);
+		return;
+	}
+	id = (int32_t)ntohl(hdr.id);
+
+	if (id >= 0) {
+		if (!udp_server.active) {
+			memset(&udp_server, 0, sizeof(udp_server));
+			udp_server.active = true;
+			udp_server.start = sys_get_ms();
+			udp_server.last_id = -1;
+		}
+		udp_server.bytes += p->tot_len;
+		if (id > udp_server.last_id + 1) {
+			udp_server.lost += id - udp_server.last_id - 1;
+		} else if (id <= udp_server.last_id) {
+			udp_server.outorder++;
+			if (udp_server.lost)
+				udp_server.lost--;
+		}
+		if (id > udp_server.last_id)
+			udp_server.last_id = id;
+	} else {
+		/* end of test, the client repeats it until it gets a report */
+		if (udp_server.active) {
+			udp_server.active = false;
+			udp_server.duration = sys_get_ms() - udp_server.start;
+			_iperf_report("UDP server", udp_server.bytes,
+					udp_server.duration);
+			printf("UDP server: %u lost, %u out of order\r\n",
+					(unsigned)udp_server.lost,
+					(unsigned)udp_server.outorder);
+		}
+		_udp_server_ack(pcb, &hdr, addr, port);
+	}
+	pbuf_free(p);
+}
+
+static err_t _udp_client_send(int32_t id)
+{
+	const uint16_t hdr_len = sizeof(struct _iperf_udp_hdr) +
+		sizeof(struct _iperf_client_hdr);
+	struct _iperf_udp_hdr *hdr;
+	struct pbuf *p, *data;
+	uint32_t now = sys_get_ms();
+	err_t err;
+
+	/* headers are built in a small pbuf, the pattern is referenced */
+	p = pbuf_alloc(PBUF_TRANSPORT, hdr_len, PBUF_RAM);
+	if (p == NULL)
+		return ERR_MEM;
+	data = pbuf_alloc(PBUF_RAW, IPERF_UDP_LEN - hdr_len, PBUF_REF);
+	if (data == NULL) {
+		pbuf_free(p);
+		return ERR_MEM;
+	}
+	data->payload = iperf_pattern;
+
+	memset(p->payload, 0, hdr_len);
+	hdr = (struct _iperf_udp_hdr *)p->payload;
+	hdr->id = htonl(id);
+	hdr->sec = htonl(now / 1000);
+	hdr->usec = htonl((now % 1000) * 1000);
+	pbuf_cat(p, data);
+
+	err = udp_sendto(udp_client.pcb, p, &udp_client.server, IPERF_PORT);
+	pbuf_free(p);
+	return err;
+}
+
+static void _udp_client_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+		struct ip_addr *addr, u16_t port)
+{
+	struct _iperf_udp_report report;
+	uint32_t duration;
+
+	(void)arg;
+	(void)pcb;
+	(void)addr;
+	(void)port;
+
+	if (udp_client.active && udp_client.fin_count &&
+	    pbuf_copy_partial(p, &report, sizeof(report), 0) == sizeof(report)) {
+		udp_client.active = false;
+		duration = ntohl(report.server.stop_sec) * 1000 +
+			ntohl(report.server.stop_usec) / 1000;
+		_iperf_report("UDP client, server side",
+				ntohl(report.server.total_len2), duration);
+		printf("UDP client: %u/%u lost, %u out of order\r\n",
+				(unsigned)ntohl(report.server.error_cnt),
+				(unsigned)ntohl(report.server.datagrams),
+				(unsigned)ntohl(report.server.outorder_cnt));
+	}
+	pbuf_free(p);
+}
+
+static void _udp_client_poll(void)
+{
+	uint32_t now = sys_get_ms();
+	uint32_t elapsed = now - udp_client.start;
+	uint32_t budget;
+	int i;
+
+	if (elapsed < udp_client.duration) {
+		/* kbit/s times ms gives bits */
+		budget = (uint32_t)(((uint64_t)udp_client.rate * elapsed) / 8);
+		for (i = 0; i < IPERF_UDP_BURST && udp_client.bytes < budget; i++) {
+			if (_udp_client_send(udp_client.id) != ERR_OK)
+				break;
+			udp_client.id++;
+			udp_client.bytes += IPERF_UDP_LEN;
+		}
+		return;
+	}
+
+	if (udp_client.fin_count == 0)
+		_iperf_report("UDP client", udp_client.bytes, udp_client.duration);
+	else if ((now - udp_client.fin_time) < IPERF_FIN_INTERVAL)
+		return;
+
+	if (udp_client.fin_count++ < IPERF_FIN_RETRIES) {
+		_udp_client_send(udp_client.id ? -udp_client.id : -1);
+		udp_client.fin_time = now;
+	} else {
+		printf("UDP client: no report from the server\r\n");
+		udp_client.active = false;
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+err_t iperf_server_init(void)
+{
+	struct tcp_pcb *pcb;
+	struct udp_pcb *upcb;
+	err_t err;
+	unsigned i;
+
+	for (i = 0; i < sizeof(iperf_pattern); i++)
+		iperf_pattern[i] = '0' + (i % 10);
+
+	pcb = tcp_new();
+	if (pcb == NULL)
+		return ERR_MEM;
+	err = tcp_bind(pcb, NULL, IPERF_PORT);
+	if (err != ERR_OK) {
+		tcp_close(pcb);
+		return err;
+	}
+	pcb = tcp_listen(pcb);
+	if (pcb == NULL)
+		return ERR_MEM;
+	tcp_accept(pcb, _tcp_server_accept);
+
+	upcb = udp_new();
+	if (upcb == NULL)
+		return ERR_MEM;
+	err = udp_bind(upcb, IP_ADDR_ANY, IPERF_PORT);
+	if (err != ERR_OK) {
+		udp_remove(upcb);
+		return err;
+	}
+	udp_recv(upcb, _udp_server_recv, NULL);
+
+	return ERR_OK;
+}
+
+err_t iperf_tcp_client_start(struct ip_addr *server, uint32_t duration)
+{
+	struct tcp_pcb *pcb;
+	err_t err;
+
+	if (tcp_client.pcb)
+		return ERR_INPROGRESS;
+
+	pcb = tcp_new();
+	if (pcb == NULL)
+		return ERR_MEM;
+	tcp_err(pcb, _tcp_client_err);
+	tcp_sent(pcb, _tcp_client_sent);
+	tcp_recv(pcb, _tcp_client_recv);
+
+	tcp_client.pcb = pcb;
+	tcp_client.duration = duration;
+	tcp_client.start = sys_get_ms();
+	tcp_client.bytes = 0;
+
+	err = tcp_connect(pcb, server, IPERF_PORT, _tcp_client_connected);
+	if (err != ERR_OK) {
+		tcp_close(pcb);
+		tcp_client.pcb = NULL;
+	}
+	return err;
+}
+
+err_t iperf_udp_client_start(struct ip_addr *server, uint32_t duration,
+		uint32_t rate)
+{
+	if (udp_client.active)
+		return ERR_INPROGRESS;
+
+	if (udp_client.pcb == NULL) {
+		udp_client.pcb = udp_new();
+		if (udp_client.pcb == NULL)
+			return ERR_MEM;
+		udp_recv(udp_client.pcb, _udp_client_recv, NULL);
+	}
+
+	ip_addr_set(&udp_client.server, server);
+	udp_client.duration = duration;
+	udp_client.rate = rate;
+	udp_client.bytes = 0;
+	udp_client.id = 0;
+	udp_client.fin_count = 0;
+	udp_client.start = sys_get_ms();
+	udp_client.active = true;
+	return ERR_OK;
+}
+
+void iperf_poll(void)
+{
+	/* stop a TCP test even if the peer stopped acknowledging */
+	if (tcp_client.pcb && tcp_client.pcb->state == ESTABLISHED &&
+	    (sys_get_ms() - tcp_client.start) >= tcp_client.duration)
+		_tcp_client_close();
+
+	if (udp_client.active)
+		_udp_client_poll();
+}
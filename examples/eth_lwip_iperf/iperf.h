@@ -0,0 +1,82 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/* iperf 2 compatible throughput test, TCP and UDP, server and client. */
+
+#ifndef _IPERF_H
+#define _IPERF_H
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Default iperf port, for both TCP and UDP */
+#define IPERF_PORT 5001
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Start the TCP and UDP servers (iperf -c <board> [-u]).
+ */
+extern err_t iperf_server_init(void);
+
+/**
+ * \brief Send TCP data to an iperf server (iperf -s).
+ * \param server  address of the iperf server
+ * \param duration  test duration, in ms
+ */
+extern err_t iperf_tcp_client_start(struct ip_addr *server, uint32_t duration);
+
+/**
+ * \brief Send UDP datagrams to an iperf server (iperf -s -u).
+ * \param server  address of the iperf server
+ * \param duration  test duration, in ms
+ * \param rate  target bandwidth, in kbit/s
+ */
+extern err_t iperf_udp_client_start(struct ip_addr *server, uint32_t duration,
+		uint32_t rate);
+
+/**
+ * \brief Pace the UDP client and end the client tests. Call it from the main
+ * loop.
+ */
+extern void iperf_poll(void);
+
+#endif /* _IPERF_H */
@@ -0,0 +1,260 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \page eth_lwip_iperf ETH lwIP iperf Example
+ *
+ *  \section Purpose
+ *
+ *  This example measures the TCP and UDP throughput of the lwIP stack with
+ *  iperf 2. It is built with the high-throughput lwIP profile
+ *  (CONFIG_LIB_LWIP_THROUGHPUT).
+ *
+ *  \section Requirements
+ *
+ * - On-board ethernet interface.
+ * - A computer running iperf 2 (not iperf 3, the protocols differ).
+ *
+ *  \section Description
+ *
+ *  The board runs TCP and UDP servers on port 5001, measured with
+ *  "iperf -c <board>" and "iperf -c <board> -u -b <rate>". It can also send
+ *  data to an iperf server running on the computer at 192.168.1.2, started
+ *  with "iperf -s" or "iperf -s -u". The client tests are started from the
+ *  console.
+ *
+ *  \section Usage
+ *
+ *  -# Build the program and download it inside the evaluation board.
+ *  -# On the computer, open and configure a terminal application
+ *     (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *    - 115200 bauds
+ *    - 8 bits of data
+ *    - No parity
+ *    - 1 stop bit
+ *    - No flow control
+ *  -# Connect an Ethernet cable between the evaluation board and the computer
+ *     configured with the IP address 192.168.1.2.
+ *  -# Start the application. It will display the following message on the terminal:
+ *    \code
+ *    -- ETH lwIP iperf Example xxx --
+ *    -- xxxxxx-xx
+ *    -- Compiled: xxx xx xxxx xx:xx:xx --
+ *      MAC 3a:1f:34:08:54:54
+ *    - Host IP  192.168.1.3
+ *    - Peer IP  192.168.1.2
+ *    \endcode
+ *  -# Run the iperf tests from the computer, or press 't' or 'u' on the
+ *     console to start a client test.
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the eth_lwip_iperf example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "board.h"
+
+#include "memories/at24.h"
+#include "misc/console.h"
+
+#include "liblwip.h"
+#include "iperf.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Duration of the client tests, in ms */
+#define IPERF_DURATION 10000
+
+/** Bandwidth of the UDP client test, in kbit/s */
+#define IPERF_UDP_RATE 50000
+
+/*---------------------------------------------------------------------------
+ *         Variables
+ *---------------------------------------------------------------------------*/
+
+/* The MAC address used for demo */
+static uint8_t gMacAddress[6] = {0x3a, 0x1f, 0x34, 0x08, 0x54, 0x54};
+
+/* The IP address used for demo */
+static uint8_t gIpAddress[4] = {192, 168, 1, 3};
+
+/* Set the default router's IP address. */
+static const uint8_t gGateWay[4] = {192, 168, 1, 2};
+
+/* The NetMask address */
+static const uint8_t gNetMask[4] = {255, 255, 255, 0};
+
+/* The IP address of the computer running the iperf server */
+static const uint8_t gPeerIp[4] = {192, 168, 1, 2};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void configure_mac_address(void)
+{
+	bool default_addr = true;
+
+#ifdef BOARD_AT24_MODEL
+	struct _at24 at24;
+	struct _at24_config config = {
+		.bus = BOARD_AT24_TWI_BUS,
+		.addr = BOARD_AT24_ADDR,
+		.model = BOARD_AT24_MODEL,
+	};
+	if (at24_configure(&at24, &config)) {
+		if (at24_has_eui48(&at24)) {
+			if (at24_read_eui48(&at24, gMacAddress)) {
+				printf("MAC address initialized using AT24 EEPROM\r\n");
+				default_addr = false;
+			} else {
+				printf("Failed reading MAC address from AT24 EEPROM\r\n");
+			}
+		} else {
+			printf("AT24 EEPROM does not support EUI48 feature\r\n");
+		}
+	} else {
+		printf("Could not configure AT24 EEPROM\r\n");
+	}
+#endif
+	if (default_addr)
+		printf("Using default MAC address\r\n");
+}
+
+static void print_menu(void)
+{
+	printf("\r\nServers listening on port %d\r\n", IPERF_PORT);
+	printf(" t: TCP client test (iperf -s on %d.%d.%d.%d)\r\n",
+			gPeerIp[0], gPeerIp[1], gPeerIp[2], gPeerIp[3]);
+	printf(" u: UDP client test at %u kbit/s (iperf -s -u on %d.%d.%d.%d)\r\n",
+			IPERF_UDP_RATE, gPeerIp[0], gPeerIp[1], gPeerIp[2], gPeerIp[3]);
+	printf(" h: display this menu\r\n");
+}
+
+static void handle_key(uint8_t key)
+{
+	struct ip_addr peer;
+	err_t err = ERR_OK;
+
+	IP4_ADDR(&peer, gPeerIp[0], gPeerIp[1], gPeerIp[2], gPeerIp[3]);
+
+	switch (key) {
+	case 't':
+		printf("Starting TCP client test\r\n");
+		err = iperf_tcp_client_start(&peer, IPERF_DURATION);
+		break;
+	case 'u':
+		printf("Starting UDP client test\r\n");
+		err = iperf_udp_client_start(&peer, IPERF_DURATION, IPERF_UDP_RATE);
+		break;
+	case 'h':
+		print_menu();
+		break;
+	default:
+		break;
+	}
+	if (err != ERR_OK)
+		printf("Could not start test (%d)\r\n", err);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief eth_lwip_iperf example entry point.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	struct ip_addr ipaddr, netmask, gw;
+	struct netif NetIf, *netif;
+
+	/* Output example information */
+	console_example_info("ETH lwIP iperf Example");
+
+	/* Retrieve MAC address from EEPROM if possible */
+	configure_mac_address();
+
+	/* Display MAC & IP settings */
+	printf(" - MAC %02x:%02x:%02x:%02x:%02x:%02x\n\r",
+			gMacAddress[0], gMacAddress[1], gMacAddress[2],
+			gMacAddress[3], gMacAddress[4], gMacAddress[5]);
+	printf(" - Host IP  %d.%d.%d.%d\n\r",
+			gIpAddress[0], gIpAddress[1],
+			gIpAddress[2], gIpAddress[3]);
+	printf(" - Peer IP  %d.%d.%d.%d\n\r",
+			gPeerIp[0], gPeerIp[1], gPeerIp[2], gPeerIp[3]);
+
+	/* Start the tick of lwIP timers */
+	sys_init_timing();
+
+	/* Initialize lwIP modules */
+	lwip_init();
+
+	/* Initialize net interface for lwIP */
+	ethif_setmac((u8_t*)gMacAddress);
+
+	IP4_ADDR(&gw, gGateWay[0], gGateWay[1], gGateWay[2], gGateWay[3]);
+	IP4_ADDR(&ipaddr, gIpAddress[0], gIpAddress[1], gIpAddress[2], gIpAddress[3]);
+	IP4_ADDR(&netmask, gNetMask[0], gNetMask[1], gNetMask[2], gNetMask[3]);
+	netif = netif_add(&NetIf, &ipaddr, &netmask, &gw, NULL, ethif_init, ip_input);
+	netif_set_default(netif);
+	netif_set_up(netif);
+
+	if (iperf_server_init() != ERR_OK) {
+		printf("iperf_server_init failed\n\r");
+		return -1;
+	}
+	print_menu();
+
+	while (1) {
+		/* Run periodic tasks */
+		sys_timers_update();
+
+		/* Run polling tasks */
+		ethif_poll(netif);
+		iperf_poll();
+
+		if (console_is_rx_ready())
+			handle_key(console_get_char());
+	}
+}
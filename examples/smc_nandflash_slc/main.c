@@ -48,6 +48,8 @@
  * enabled </li>
  * <li> Measure throughtput for write/read with or without DMA enabled
  * using PMECC </li>
+ * <li> Compare the read throughput of page by page and multi-page reads,
+ * the latter using cache read when the device supports it </li>
  * </ul>
  * \section Usage
  *
@@ -121,6 +123,9 @@
 #include "misc/cache.h"
 #include "misc/led.h"
 
+#include "intmath.h"
+#include "timer.h"
+
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
@@ -131,6 +136,12 @@
 
 #define PATTERN_SIZE        32
 
+/** Number of consecutive pages read by the benchmark */
+#define BENCH_PAGES         16
+
+/** Number of times the pages are read by the benchmark */
+#define BENCH_LOOPS         32
+
 enum {
 	CONF_DMA,
 #ifdef CONFIG_HAVE_NFC
@@ -180,6 +191,9 @@ CACHE_ALIGNED_DDR static uint8_t page_buffer[NAND_MAX_PAGE_DATA_SIZE + NAND_MAX_
 /** spare buffer */
 CACHE_ALIGNED_DDR static uint8_t spare_buffer[NAND_MAX_PAGE_SPARE_SIZE];
 
+/** benchmark buffer, the last page is followed by its spare area */
+CACHE_ALIGNED_DDR static uint8_t bench_buffer[BENCH_PAGES * NAND_MAX_PAGE_DATA_SIZE + NAND_MAX_PAGE_SPARE_SIZE];
+
 /** pattern buffer */
 const uint8_t pattern[PATTERN_SIZE] = {
 	0x01, 0x2c, 0x00, 0xed, 0xfc, 0xdb, 0x00, 0x43,
@@ -312,6 +326,87 @@ static void _page_access(void)
 	}
 }
 
+/**
+ * \brief Print the read throughput of a benchmark run.
+ * \param name Name of the read method.
+ * \param pages Number of pages read.
+ * \param elapsed Elapsed time in ms.
+ */
+static void _print_throughput(const char *name, uint32_t pages,
+		uint32_t elapsed)
+{
+	if (elapsed == 0)
+		elapsed = 1;
+	printf("-I- %s: %u pages in %ums, %u pages/s, %uKB/s\n\r", name,
+			(unsigned)pages, (unsigned)elapsed,
+			(unsigned)(pages * 1000 / elapsed),
+			(unsigned)(pages * (page_size / 1024) * 1000 / elapsed));
+}
+
+/**
+ * \brief Measure the read throughput of consecutive pages, page by page and
+ * with the multi-page read.
+ */
+static void _bench_read(void)
+{
+	uint32_t pages, i, loop, start;
+	uint8_t error = 0;
+
+	if (ecc_type == ECC_PMECC) {
+		pmecc_initialize(sector_idx, correctability,
+				page_size, spare_size, 0, 0);
+	}
+
+	pages = min_u32(BENCH_PAGES,
+			nand_model_get_block_size_in_pages(&nand.model));
+
+	printf("-I- Erase block\n\r");
+	nand_skipblock_erase_block(&nand, block, SCRUB_ERASE);
+
+	printf("-I- Write %u pages\n\r", (unsigned)pages);
+	for (i = 0; i < pages; i++) {
+		memcpy(page_buffer, pattern_buffer, page_size);
+		nand_skipblock_write_page(&nand, block, i, page_buffer, 0);
+	}
+
+	if (nand_onfi_has_cache_read())
+		printf("-I- Device supports cache read\n\r");
+	else
+		printf("-I- Device does not support cache read\n\r");
+
+	start = timer_get_tick();
+	for (loop = 0; loop < BENCH_LOOPS && !error; loop++) {
+		for (i = 0; i < pages && !error; i++)
+			error = nand_skipblock_read_page(&nand, block, i,
+					bench_buffer + i * page_size, 0);
+	}
+	_print_throughput("Page read", pages * BENCH_LOOPS,
+			timer_get_interval(start, timer_get_tick()));
+
+	memset(bench_buffer, 0, pages * page_size);
+	start = timer_get_tick();
+	for (loop = 0; loop < BENCH_LOOPS && !error; loop++)
+		error = nand_skipblock_read_pages(&nand, block, 0, pages,
+				bench_buffer);
+	_print_throughput("Multi-page read", pages * BENCH_LOOPS,
+			timer_get_interval(start, timer_get_tick()));
+
+	if (error) {
+		printf("-E- Read error %u, test failed\n\r", error);
+		return;
+	}
+
+	/* Test if the read contains expected data */
+	for (i = 0; i < pages; i++) {
+		if (memcmp(pattern_buffer, bench_buffer + i * page_size,
+					page_size)) {
+			printf("-I- Read data is different from buffer, test failed\n\r");
+			return;
+		}
+	}
+	printf("-I- Read data matches buffer.\n\r");
+}
+
 /**
  * \brief Generate some error bit for error correction.
  */
@@ -552,6 +647,7 @@ static void _display_menu(uint8_t menu_idx)
 	
 
 	printf(" p: Erase/Write/Read\n\r");
+	printf(" t: Read throughput benchmark\n\r");
 
 	if (menu_idx == 2) {
 		printf(" w: Write page with simulated error bit(s)\n\r");
@@ -620,6 +716,11 @@ static void _loop_pmecc(void)
 			_page_access();
 			printf("\n\r");
 			break;
+		case 't':
+		case 'T':
+			_bench_read();
+			printf("\n\r");
+			break;
 		case 'w':
 		case 'W':
 			_write_page_with_simulated_error_bits();
@@ -683,6 +784,10 @@ static void _loop_raw(void)
 		case 'P':
 			_page_access();
 			break;
+		case 't':
+		case 'T':
+			_bench_read();
+			break;
 		case 'c':
 		case 'C':
 			_dump_smc_configuration();
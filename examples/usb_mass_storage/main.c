@@ -100,6 +100,7 @@
 
 #include "board.h"
 #include "trace.h"
+#include "prof.h"
 #include "misc/console.h"
 #include "misc/cache.h"
 #include "peripherals/pmc.h"
@@ -228,6 +229,9 @@ static uint32_t msd_write_total = 0;
 static uint8_t msd_refresh = 0;
 
 static uint8_t current_lun_num = 0;
+
+/** Last key received on the console, 0 if none */
+static volatile uint8_t console_key = 0;
 /*-----------------------------------------------------------------------------
  *         Callback re-implementation
  *-----------------------------------------------------------------------------*/
@@ -275,6 +279,48 @@ static void msd_callbacks_data(uint8_t flow_direction, uint32_t data_length,
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * Console RX handler, the key is processed by the main loop.
+ */
+static void console_handler(uint8_t key)
+{
+	console_key = key;
+}
+
+/**
+ * Process the key received on the console:
+ * 's' prints and clears the throughput of each LUN,
+ * '1' to '4' set the number of chunks of the LUN buffers,
+ * 'p' prints the interrupt handler latencies (CONFIG_PROF only).
+ */
+static void process_console_key(void)
+{
+	uint8_t key = console_key;
+	int i;
+
+	if (!key)
+		return;
+	console_key = 0;
+
+	if (key == 's') {
+		for (i = 0; i < current_lun_num; i++) {
+			printf("-I- LUN %d, %u chunk(s)\r\n", i,
+			       (unsigned)luns[i].ioFifo.depth);
+			msd_io_fifo_print_stats(&luns[i].ioFifo);
+			msd_io_fifo_reset_stats(&luns[i].ioFifo);
+		}
+	} else if (key >= '1' && key <= '4') {
+		for (i = 0; i < current_lun_num; i++)
+			msd_io_fifo_set_depth(&luns[i].ioFifo, key - '0');
+		printf("-I- LUN buffers split in %c chunk(s)\r\n", key);
+	}
+#ifdef CONFIG_PROF
+	else if (key == 'p') {
+		prof_dump();
+	}
+#endif
+}
+
 /**
  * Initialize SD card peripherals driver
  */
@@ -453,6 +499,14 @@ int main(void)
 {
 	console_example_info("USB Device Mass Storage Example");
 
+#ifdef CONFIG_PROF
+	prof_init();
+#endif
+
+	/* Keys are processed by the main loop */
+	console_set_rx_handler(console_handler);
+	console_enable_rx_interrupt();
+
 	/* Initialize all USB power (off) */
 	usb_power_configure();
 
@@ -480,6 +534,7 @@ int main(void)
 				msd_write_total = 0;
 			}
 		}
+		process_console_key();
 	}
 }
 /** \endcond */
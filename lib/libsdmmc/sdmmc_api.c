@@ -51,6 +51,8 @@
 #include "chip.h"
 #include "compiler.h"
 #include "intmath.h"
+#include "mutex.h"
+#include "ring.h"
 #include "timer.h"
 #include "libsdmmc.h"
 
@@ -190,6 +192,20 @@ struct stringEntry_s
 #define DATA_SDIO_R5(response)  ((response) & 0xffu)
 /**     @}*/
 
+/** \addtogroup sdmmc_req_step Asynchronous request processing steps
+ *      @{*/
+#define REQ_STEP_IDLE           0	/**< No command in progress */
+#define REQ_STEP_SET_BLK_CNT    1	/**< SET_BLOCK_COUNT sent */
+#define REQ_STEP_DATA           2	/**< READ/WRITE_MULTIPLE_BLOCK sent */
+#define REQ_STEP_STOP           3	/**< STOP_TRANSMISSION sent */
+#define REQ_STEP_ABORT          4	/**< STOP_TRANSMISSION sent on error */
+#define REQ_STEP_STATUS         5	/**< SEND_STATUS sent */
+/**     @}*/
+
+/** Maximum count of SEND_STATUS commands issued while waiting for the device
+ * to return to the Transfer State, further to an asynchronous transfer */
+#define REQ_STATUS_RETRIES      1000
+
 /*----------------------------------------------------------------------------
  *         Macros
  *----------------------------------------------------------------------------*/
@@ -348,6 +364,13 @@ _SdParamReset(sSdCard * pSd)
 
 	memset(&pSd->sdCmd, 0, sizeof(pSd->sdCmd));
 
+	/* Drop any pending asynchronous request */
+	RING_CLEAR(pSd->wReqHead, pSd->wReqTail);
+	mutex_unlock(&pSd->reqLock);
+	pSd->bReqStep = REQ_STEP_IDLE;
+	pSd->bReqError = SDMMC_OK;
+	pSd->sdReq.bStatus = SDMMC_OK;
+
 	/* Clear our device register cache */
 	memset(pSd->CID, 0, 16);
 	memset(pSd->CSD, 0, 16);
@@ -1047,9 +1070,13 @@ Cmd11(sSdCard * pSd, uint32_t * pStatus)
  * Forces the card to stop transmission
  * \param pSd      Pointer to a SD card driver instance.
  * \param pStatus  Pointer to a status variable.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to sSdCard instance.
  */
 static uint8_t
-Cmd12(sSdCard * pSd, uint32_t * pStatus)
+Cmd12(sSdCard * pSd, uint32_t * pStatus, fSdmmcCallback callback)
 {
 	sSdmmcCommand *pCmd = &pSd->sdCmd;
 	uint8_t bRc;
@@ -1062,7 +1089,7 @@ Cmd12(sSdCard * pSd, uint32_t * pStatus)
 	pCmd->pResp = pStatus;
 
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	return bRc;
 }
 
@@ -1071,9 +1098,13 @@ Cmd12(sSdCard * pSd, uint32_t * pStatus)
  * Returns the command transfer result (see SendMciCommand).
  * \param pSd       Pointer to a SD card driver instance.
  * \param pStatus   Pointer to a status variable.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to sSdCard instance.
  */
 static uint8_t
-Cmd13(sSdCard * pSd, uint32_t * pStatus)
+Cmd13(sSdCard * pSd, uint32_t * pStatus, fSdmmcCallback callback)
 {
 	sSdmmcCommand *pCmd = &pSd->sdCmd;
 	uint8_t bRc;
@@ -1087,7 +1118,7 @@ Cmd13(sSdCard * pSd, uint32_t * pStatus)
 	pCmd->pResp = pStatus;
 
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	return bRc;
 }
 
@@ -1154,10 +1185,9 @@ Cmd17(sSdCard * pSd,
 	pCmd->wBlockSize = BLOCK_SIZE(pSd);
 	pCmd->wNbBlocks = 1;
 	pCmd->pData = pData;
-	pCmd->fCallback = callback;
 
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	return bRc;
 }
 
@@ -1254,9 +1284,8 @@ Cmd18(sSdCard * pSd,
 	pCmd->wBlockSize = BLOCK_SIZE(pSd);
 	pCmd->wNbBlocks = *nbBlock;
 	pCmd->pData = pData;
-	pCmd->fCallback = callback;
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	if (bRc == SDMMC_CHANGED)
 		*nbBlock = pCmd->wNbBlocks;
 	return bRc;
@@ -1270,9 +1299,14 @@ Cmd18(sSdCard * pSd,
  * \param pSd       Pointer to a SD card driver instance.
  * \param write     Write Request parameter.
  * \param blocks    number of blocks.
+ * \param fCallback Pointer to optional callback invoked on command end.
+ *                  NULL:    Function return until command finished.
+ *                  Pointer: Return immediately and invoke callback at end.
+ *                  Callback argument is fixed to a pointer to sSdCard instance.
  */
 static uint8_t
-Cmd23(sSdCard * pSd, uint8_t write, uint32_t blocks, uint32_t * pStatus)
+Cmd23(sSdCard * pSd, uint8_t write, uint32_t blocks, uint32_t * pStatus,
+      fSdmmcCallback callback)
 {
 	sSdmmcCommand *pCmd = &pSd->sdCmd;
 	uint8_t bRc;
@@ -1287,7 +1321,7 @@ Cmd23(sSdCard * pSd, uint8_t write, uint32_t blocks, uint32_t * pStatus)
 	pCmd->pResp = pStatus;
 
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	return bRc;
 }
 
@@ -1322,9 +1356,8 @@ Cmd24(sSdCard * pSd,
 	pCmd->wBlockSize = BLOCK_SIZE(pSd);
 	pCmd->wNbBlocks = 1;
 	pCmd->pData = pData;
-	pCmd->fCallback = callback;
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	return bRc;
 }
 
@@ -1361,9 +1394,8 @@ Cmd25(sSdCard * pSd,
 	pCmd->wBlockSize = BLOCK_SIZE(pSd);
 	pCmd->wNbBlocks = *nbBlock;
 	pCmd->pData = pData;
-	pCmd->fCallback = callback;
 	/* Send command */
-	bRc = _SendCmd(pSd, NULL, NULL);
+	bRc = _SendCmd(pSd, callback, pSd);
 	if (bRc == SDMMC_CHANGED)
 		*nbBlock = pCmd->wNbBlocks;
 	return bRc;
@@ -1776,17 +1808,19 @@ _StopCmd(sSdCard * pSd)
 	uint8_t err, count;
 	/* When stopping a write operation, allow retrying several times */
 	for (i = 0; i < 9 && state == STATUS_RCV; i++) {
-		err = Cmd12(pSd, &status);
+		err = Cmd12(pSd, &status, NULL);
 		if (err)
 			return err;
 		/* TODO handle any exception, raised in status; report that
 		 * the data transfer has failed. */
 
-		/* Wait until ready. Allow 30 ms. */
-		for (count = 0; count < 6; count++) {
-			/* Wait for about 5 ms - which equals 5 system ticks */
-			timer_sleep(5);
-			err = Cmd13(pSd, &status);
+		/* Wait until ready. Allow 30 ms. Poll frequently, since the
+		 * device is usually ready within a fraction of this delay. */
+		for (count = 0; count < 30; count++) {
+			/* Wait for about 1 ms - which equals 1 system tick */
+			if (count)
+				timer_sleep(1);
+			err = Cmd13(pSd, &status, NULL);
 			if (err)
 				return err;
 			state = status & STATUS_STATE;
@@ -1810,9 +1844,11 @@ static uint8_t
 _WaitUntilReady(sSdCard * pSd, uint32_t last_dev_status)
 {
 	uint32_t state, status = last_dev_status;
-	uint8_t err, count;
+	uint16_t count;
+	uint8_t err;
 
-	for (count = 0; count < 51; count++) {
+	/* Allow about 500 ms */
+	for (count = 0; count < 501; count++) {
 		state = status & STATUS_STATE;
 		if (state == STATUS_TRAN && status & STATUS_READY_FOR_DATA)
 			return SDMMC_SUCCESS;
@@ -1822,9 +1858,9 @@ _WaitUntilReady(sSdCard * pSd, uint32_t last_dev_status)
 		if (state != STATUS_TRAN && state != STATUS_PRG
 		    && state != STATUS_DATA && state != STATUS_RCV)
 			return SDMMC_ERROR_NOT_INITIALIZED;
-		/* Wait for about 10 ms - which equals 10 system ticks */
-		timer_sleep(10);
-		err = Cmd13(pSd, &status);
+		/* Wait for about 1 ms - which equals 1 system tick */
+		timer_sleep(1);
+		err = Cmd13(pSd, &status, NULL);
 		if (err)
 			return err;
 	}
@@ -1872,7 +1908,7 @@ PerformSingleTransfer(sSdCard * pSd,
 		trace_error("Cmd%u(0x%lx) %s\n\r", isRead ? 17 : 24,
 		    sdmmc_address, SD_StringifyRetCode(error));
 		result = error;
-		error = Cmd13(pSd, &status);
+		error = Cmd13(pSd, &status, NULL);
 		if (error) {
 			pSd->bStatus = error;
 			return result;
@@ -1918,7 +1954,7 @@ MoveToTransferState(sSdCard * pSd,
 	else
 		return SDMMC_PARAM;
 	if (pSd->bSetBlkCnt) {
-		error = Cmd23(pSd, 0, *nbBlocks, &status);
+		error = Cmd23(pSd, 0, *nbBlocks, &status, NULL);
 		if (error)
 			return error;
 	}
@@ -1954,14 +1990,14 @@ MoveToTransferState(sSdCard * pSd,
 		trace_error("Cmd%u(0x%lx, %u) %s\n\r", isRead ? 18 : 25,
 		    sdmmc_address, *nbBlocks, SD_StringifyRetCode(error));
 		result = error;
-		error = Cmd13(pSd, &status);
+		error = Cmd13(pSd, &status, NULL);
 		if (error) {
 			pSd->bStatus = error;
 			return result;
 		}
 		state = status & STATUS_STATE;
 		if (state == STATUS_DATA || state == STATUS_RCV) {
-			error = Cmd12(pSd, &status);
+			error = Cmd12(pSd, &status, NULL);
 			if (error == SDMMC_OK) {
 				trace_debug("st %lx\n\r", status);
 				if (status & (STATUS_ERASE_SEQ_ERROR
@@ -1983,7 +2019,7 @@ MoveToTransferState(sSdCard * pSd,
 					result = SDMMC_ERR;
 			}
 			else if (error == SDMMC_ERROR_NORESPONSE)
-				error = Cmd13(pSd, &status);
+				error = Cmd13(pSd, &status, NULL);
 			if (error) {
 				pSd->bStatus = error;
 				return result;
@@ -1998,6 +2034,220 @@ MoveToTransferState(sSdCard * pSd,
 	return result;
 }
 
+static void _SdReqEvent(uint32_t status, void *pArg);
+static void _SdReqRun(sSdCard * pSd);
+
+/**
+ * Tell whether an asynchronous command has been issued, in which case
+ * _SdReqEvent() will be invoked upon its completion.
+ */
+static inline bool
+_SdReqIssued(uint8_t bRc)
+{
+	return bRc == SDMMC_OK || bRc == SDMMC_CHANGED;
+}
+
+/**
+ * Issue READ_MULTIPLE_BLOCK or WRITE_MULTIPLE_BLOCK for the current chunk of
+ * the request at the tail of the queue.
+ * \param pSd  Pointer to a SD card driver instance.
+ */
+static uint8_t
+_SdReqIssueData(sSdCard * pSd)
+{
+	sSdmmcRequest *pReq = pSd->pReqQueue[pSd->wReqTail];
+	uint32_t address = pReq->dwAddr + pReq->dwDone;
+	uint8_t *pData = pReq->pData + pReq->dwDone * BLOCK_SIZE(pSd);
+
+	/* Convert block address into device-expected unit. The range has been
+	 * checked by SD_SubmitRequest(). */
+	if (!(pSd->bCardType & CARD_TYPE_bmHC))
+		address *= pSd->wCurrBlockLen;
+	pSd->bReqStep = REQ_STEP_DATA;
+	if (pReq->bWrite)
+		return Cmd25(pSd, &pSd->wReqChunk, pData, address,
+		    &pSd->dwReqResp, _SdReqEvent);
+	return Cmd18(pSd, &pSd->wReqChunk, pData, address, &pSd->dwReqResp,
+	    _SdReqEvent);
+}
+
+/**
+ * Start transferring the next chunk of the request at the tail of the queue.
+ * When the device or the driver requires it, first predefine the count of
+ * blocks with SET_BLOCK_COUNT.
+ * \param pSd  Pointer to a SD card driver instance.
+ */
+static uint8_t
+_SdReqIssue(sSdCard * pSd)
+{
+	sSdmmcRequest *pReq = pSd->pReqQueue[pSd->wReqTail];
+
+	pSd->wReqChunk = (uint16_t)min_u32(pReq->dwNbBlocks - pReq->dwDone,
+	    65535);
+	if (pSd->bSetBlkCnt) {
+		pSd->bReqStep = REQ_STEP_SET_BLK_CNT;
+		return Cmd23(pSd, 0, pSd->wReqChunk, &pSd->dwReqResp,
+		    _SdReqEvent);
+	}
+	return _SdReqIssueData(pSd);
+}
+
+/**
+ * Query the device status, waiting for the device to return to the Transfer
+ * State.
+ * \param pSd     Pointer to a SD card driver instance.
+ * \param bFirst  1 to start a new series of SEND_STATUS commands.
+ */
+static uint8_t
+_SdReqIssueStatus(sSdCard * pSd, uint8_t bFirst)
+{
+	pSd->wReqRetries = bFirst ? 0 : pSd->wReqRetries + 1;
+	pSd->bReqStep = REQ_STEP_STATUS;
+	return Cmd13(pSd, &pSd->dwReqResp, _SdReqEvent);
+}
+
+/**
+ * Complete the request at the tail of the queue, and notify the requester.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \param bRc  Request result, a \ref sdmmc_rc "result code".
+ */
+static void
+_SdReqFinish(sSdCard * pSd, uint8_t bRc)
+{
+	sSdmmcRequest *pReq = pSd->pReqQueue[pSd->wReqTail];
+
+	trace_debug("SDreq%c(%lu,%lu) %s\n\r", pReq->bWrite ? 'W' : 'R',
+	    pReq->dwAddr, pReq->dwDone, SD_StringifyRetCode(bRc));
+	pSd->bReqStep = REQ_STEP_IDLE;
+	pReq->bStatus = bRc;
+	RING_INC(pSd->wReqTail, SDMMC_REQ_QUEUE_SIZE);
+	if (pReq->fCallback)
+		pReq->fCallback(bRc, pReq->pArg);
+}
+
+/**
+ * End-of-command callback of the asynchronous request engine. Invoked by the
+ * low-level driver, usually from its interrupt handler. Either issue the next
+ * command of the current request, or complete the request and start the next
+ * one.
+ * \param status  Command result, a \ref sdmmc_rc "result code".
+ * \param pArg    Pointer to the SD card driver instance.
+ */
+static void
+_SdReqEvent(uint32_t status, void *pArg)
+{
+	sSdCard *pSd = (sSdCard *) pArg;
+	sSdmmcRequest *pReq = pSd->pReqQueue[pSd->wReqTail];
+	uint32_t resp = pSd->dwReqResp, state;
+	uint8_t rc = (uint8_t)status;
+
+	if (rc == SDMMC_CHANGED) {
+		/* The driver has shortened the data transfer */
+		if (pSd->bReqStep == REQ_STEP_DATA)
+			pSd->wReqChunk = pSd->sdCmd.wNbBlocks;
+		rc = SDMMC_OK;
+	}
+	switch (pSd->bReqStep) {
+	case REQ_STEP_SET_BLK_CNT:
+		if (rc != SDMMC_OK)
+			break;
+		rc = _SdReqIssueData(pSd);
+		if (_SdReqIssued(rc))
+			return;
+		break;
+	case REQ_STEP_DATA:
+		if (rc == SDMMC_OK && resp & (pReq->bWrite ? STATUS_WRITE
+		    : STATUS_READ) & ~STATUS_READY_FOR_DATA & ~STATUS_STATE) {
+			trace_error("st %lx\n\r", resp);
+			rc = SDMMC_ERROR;
+		}
+		if (rc != SDMMC_OK) {
+			/* Leave the Sending-data or Receive-data state */
+			pSd->bReqError = rc;
+			pSd->bReqStep = REQ_STEP_ABORT;
+			if (_SdReqIssued(Cmd12(pSd, &pSd->dwReqResp,
+			    _SdReqEvent)))
+				return;
+			break;
+		}
+		pReq->dwDone += pSd->wReqChunk;
+		if (pSd->bStopMultXfer) {
+			pSd->bReqStep = REQ_STEP_STOP;
+			rc = Cmd12(pSd, &pSd->dwReqResp, _SdReqEvent);
+		}
+		else
+			rc = _SdReqIssueStatus(pSd, 1);
+		if (_SdReqIssued(rc))
+			return;
+		break;
+	case REQ_STEP_STOP:
+	case REQ_STEP_ABORT:
+		if (rc != SDMMC_OK)
+			break;
+		rc = _SdReqIssueStatus(pSd, 1);
+		if (_SdReqIssued(rc))
+			return;
+		break;
+	case REQ_STEP_STATUS:
+		if (rc != SDMMC_OK)
+			break;
+		state = resp & STATUS_STATE;
+		if (state == STATUS_TRAN && resp & STATUS_READY_FOR_DATA) {
+			if (pSd->bReqError != SDMMC_OK
+			    || pReq->dwDone >= pReq->dwNbBlocks)
+				break;
+			/* Proceed with the next chunk */
+			rc = _SdReqIssue(pSd);
+			if (_SdReqIssued(rc))
+				return;
+			break;
+		}
+		if (state != STATUS_TRAN && state != STATUS_PRG
+		    && state != STATUS_DATA && state != STATUS_RCV)
+			rc = SDMMC_ERROR_NOT_INITIALIZED;
+		else if (pSd->wReqRetries >= REQ_STATUS_RETRIES)
+			rc = SDMMC_ERROR_BUSY;
+		else {
+			rc = _SdReqIssueStatus(pSd, 0);
+			if (_SdReqIssued(rc))
+				return;
+		}
+		break;
+	default:
+		return;
+	}
+	if (pSd->bReqError != SDMMC_OK)
+		rc = pSd->bReqError;
+	_SdReqFinish(pSd, rc);
+	_SdReqRun(pSd);
+}
+
+/**
+ * Process the queued requests, until one of them is waiting for the device.
+ * The caller shall have acquired pSd->reqLock, which is released once the
+ * queue has been emptied.
+ * \param pSd  Pointer to a SD card driver instance.
+ */
+static void
+_SdReqRun(sSdCard * pSd)
+{
+	uint8_t rc;
+
+	do {
+		while (!RING_EMPTY(pSd->wReqHead, pSd->wReqTail)) {
+			pSd->bReqError = SDMMC_OK;
+			rc = _SdReqIssue(pSd);
+			if (_SdReqIssued(rc))
+				return;
+			_SdReqFinish(pSd, rc);
+		}
+		mutex_unlock(&pSd->reqLock);
+		/* A request may have been queued after the queue was last
+		 * checked, and before the lock was released */
+	} while (!RING_EMPTY(pSd->wReqHead, pSd->wReqTail)
+	    && mutex_try_lock(&pSd->reqLock));
+}
+
 /**
  * Switch card state between STBY and TRAN (or CMD and TRAN)
  * \param pSd       Pointer to a SD card driver instance.
@@ -2015,7 +2265,7 @@ SdMmcSelect(sSdCard * pSd, uint16_t address, uint8_t statCheck)
 	/* At this stage the Initialization and identification process is achieved
 	 * The SD card is supposed to be in Stand-by State */
 	while (statCheck) {
-		error = Cmd13(pSd, &status);
+		error = Cmd13(pSd, &status, NULL);
 		if (error)
 			return error;
 		if (status & STATUS_READY_FOR_DATA) {
@@ -2743,7 +2993,7 @@ MmcInit(sSdCard * pSd)
 		if (error == SDMMC_OK)
 			error = _HwSetHsMode(pSd, SDMMC_TIM_MMC_HS_SDR);
 		if (error == SDMMC_OK)
-			error = Cmd13(pSd, &status);
+			error = Cmd13(pSd, &status, NULL);
 		if (error == SDMMC_OK && (status & ~STATUS_STATE
 		    & ~STATUS_READY_FOR_DATA
 		    || (status & STATUS_STATE) != STATUS_TRAN))
@@ -2776,7 +3026,7 @@ MmcInit(sSdCard * pSd)
 				/* Switch to High Speed DDR timing mode */
 				error = _HwSetHsMode(pSd, tim_mode);
 			if (error == SDMMC_OK)
-				error = Cmd13(pSd, &status);
+				error = Cmd13(pSd, &status, NULL);
 			if (error == SDMMC_OK && (status & ~STATUS_STATE
 			    & ~STATUS_READY_FOR_DATA
 			    || (status & STATUS_STATE) != STATUS_TRAN))
@@ -2806,7 +3056,7 @@ MmcInit(sSdCard * pSd)
 		if (error == SDMMC_OK)
 			error = _HwSetHsMode(pSd, tim_mode);
 		if (error == SDMMC_OK) {
-			error = Cmd13(pSd, &status);
+			error = Cmd13(pSd, &status, NULL);
 			if (error == SDMMC_OK && (status & ~STATUS_STATE
 			    & ~STATUS_READY_FOR_DATA
 			    || (status & STATUS_STATE) != STATUS_TRAN))
@@ -2876,7 +3126,7 @@ MmcInit(sSdCard * pSd)
 	/* Check device status and eat past exceptions, which would otherwise
 	 * prevent upcoming data transaction routines from reliably checking
 	 * fresh exceptions. */
-	error = Cmd13(pSd, &status);
+	error = Cmd13(pSd, &status, NULL);
 	if (error)
 		return error;
 	status = status & ~STATUS_STATE & ~STATUS_READY_FOR_DATA
@@ -3057,7 +3307,7 @@ SdInit(sSdCard * pSd, bool * retry)
 	/* Check device status and eat past exceptions, which would otherwise
 	 * prevent upcoming data transaction routines from reliably checking
 	 * fresh exceptions. */
-	error = Cmd13(pSd, &status);
+	error = Cmd13(pSd, &status, NULL);
 	if (error)
 		return error;
 	status = status & ~STATUS_STATE & ~STATUS_READY_FOR_DATA
@@ -3183,6 +3433,93 @@ SD_GetField(const uint8_t *reg, uint16_t reg_len, uint16_t field_start,
 	return val;
 }
 
+/**
+ * Queue an asynchronous block I/O request. Requests are processed in order.
+ * Each of them is split into multiple-block transfers, which are issued
+ * from the end-of-command callback of the low-level driver, without involving
+ * the caller. Upon completion, pReq->bStatus is updated and, if provided,
+ * pReq->fCallback is invoked with pReq->pArg, usually from interrupt context.
+ * \param pSd   Pointer to a SD card driver instance.
+ * \param pReq  Pointer to the request. The request and its data buffer shall
+ * remain valid until the request completes.
+ * \return SDMMC_OK if the request has been queued, SDMMC_BUSY if the queue is
+ * full, or another \ref sdmmc_rc "error code" if the request is invalid.
+ */
+uint8_t
+SD_SubmitRequest(sSdCard * pSd, sSdmmcRequest * pReq)
+{
+	assert(pSd != NULL);
+	assert(pReq != NULL);
+
+	if (pReq->pData == NULL || pReq->dwNbBlocks == 0
+	    || pReq->dwAddr + pReq->dwNbBlocks < pReq->dwAddr)
+		return SDMMC_PARAM;
+	if (pSd->wCurrBlockLen == 0)
+		return SDMMC_NOT_INITIALIZED;
+	if (!(pSd->bCardType & CARD_TYPE_bmHC) && pReq->dwAddr
+	    + pReq->dwNbBlocks - 1 > 0xfffffffful / pSd->wCurrBlockLen)
+		return SDMMC_PARAM;
+	if (RING_SPACE(pSd->wReqHead, pSd->wReqTail, SDMMC_REQ_QUEUE_SIZE)
+	    == 0)
+		return SDMMC_BUSY;
+
+	pReq->dwDone = 0;
+	pReq->bStatus = SDMMC_BUSY;
+	pSd->pReqQueue[pSd->wReqHead] = pReq;
+	/* Publish the request before moving the head */
+	dmb();
+	RING_INC(pSd->wReqHead, SDMMC_REQ_QUEUE_SIZE);
+
+	/* Start processing, unless requests are being processed already */
+	if (mutex_try_lock(&pSd->reqLock))
+		_SdReqRun(pSd);
+	return SDMMC_OK;
+}
+
+/**
+ * Check whether all asynchronous requests have completed.
+ * With low-level drivers that are configured for polling, this function also
+ * lets the current command progress, hence shall be called periodically.
+ * \param pSd  Pointer to a SD card driver instance.
+ * \return true if no request is pending.
+ */
+bool
+SD_IsRequestQueueIdle(const sSdCard * pSd)
+{
+	uint32_t drv_is_busy = 1;
+
+	assert(pSd != NULL);
+
+	if (RING_EMPTY(pSd->wReqHead, pSd->wReqTail)
+	    && !mutex_is_locked(&pSd->reqLock))
+		return true;
+	pSd->pHalf->fIOCtrl(pSd->pDrv, SDMMC_IOCTL_BUSY_CHECK,
+	    (uint32_t)&drv_is_busy);
+	return false;
+}
+
+/**
+ * Queue an asynchronous transfer using the request embedded in the SD card
+ * driver instance.
+ */
+static uint8_t
+_SdSubmitXfer(sSdCard * pSd, uint32_t address, uint8_t * pData,
+	      uint32_t length, uint8_t isWrite,
+	      fSdmmcCallback pCallback, void *pArgs)
+{
+	sSdmmcRequest *pReq = &pSd->sdReq;
+
+	if (pReq->bStatus == SDMMC_BUSY)
+		return SDMMC_BUSY;
+	pReq->dwAddr = address;
+	pReq->dwNbBlocks = length;
+	pReq->pData = pData;
+	pReq->bWrite = isWrite;
+	pReq->fCallback = pCallback;
+	pReq->pArg = pArgs;
+	return SD_SubmitRequest(pSd, pReq);
+}
+
 /**
  * Read Blocks of data in a buffer pointed by pData. The buffer size must be at
  * least 512 byte long. This function checks the SD card status register and
@@ -3195,6 +3532,9 @@ SD_GetField(const uint8_t *reg, uint16_t reg_len, uint16_t field_start,
  * \param length   Number of blocks to be read.
  * \param pCallback Pointer to callback function that invoked when read done.
  *                  0 to start a blocked read.
+ *                  Otherwise the read is queued, see SD_SubmitRequest(), and
+ *                  this function returns immediately. Only one such read or
+ *                  write may be pending at a time.
  * \param pArgs     Pointer to callback function arguments.
  */
 uint8_t
@@ -3210,6 +3550,12 @@ SD_Read(sSdCard * pSd,
 	assert(pSd != NULL);
 	assert(pData != NULL);
 
+	if (pCallback)
+		return _SdSubmitXfer(pSd, address, (uint8_t *)pData, length, 0,
+		    pCallback, pArgs);
+	if (!SD_IsRequestQueueIdle(pSd))
+		return SDMMC_BUSY;
+
 	for (blk_no = address, remaining = length, out = (uint8_t *)pData;
 	    remaining != 0 && error == SDMMC_OK;
 	    blk_no += limited, remaining -= limited,
@@ -3234,6 +3580,9 @@ SD_Read(sSdCard * pSd,
  * \param length   Number of blocks to be write.
  * \param pCallback Pointer to callback function that invoked when write done.
  *                  0 to start a blocked write.
+ *                  Otherwise the write is queued, see SD_SubmitRequest(), and
+ *                  this function returns immediately. Only one such read or
+ *                  write may be pending at a time.
  * \param pArgs     Pointer to callback function arguments.
  */
 uint8_t
@@ -3250,6 +3599,12 @@ SD_Write(sSdCard * pSd,
 	assert(pSd != NULL);
 	assert(pData != NULL);
 
+	if (pCallback)
+		return _SdSubmitXfer(pSd, address, (uint8_t *)pData, length, 1,
+		    pCallback, pArgs);
+	if (!SD_IsRequestQueueIdle(pSd))
+		return SDMMC_BUSY;
+
 	for (blk_no = address, remaining = length, in = (uint8_t *)pData;
 	    remaining != 0 && error == SDMMC_OK;
 	    blk_no += limited, remaining -= limited,
@@ -100,6 +100,7 @@
  *  @{
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "sdmmc_hal.h"
 #include "sdio.h"
@@ -659,6 +660,9 @@ extern uint8_t SD_Write(sSdCard * pSd,
 			uint32_t dwNbBlocks,
 			fSdmmcCallback fCallback, void *pArg);
 
+extern uint8_t SD_SubmitRequest(sSdCard * pSd, sSdmmcRequest * pReq);
+extern bool SD_IsRequestQueueIdle(const sSdCard * pSd);
+
 extern uint8_t SDIO_ReadDirect(sSdCard * pSd,
 			       uint8_t bFunctionNum,
 			       uint32_t dwAddress,
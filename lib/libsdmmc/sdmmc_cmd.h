@@ -63,6 +63,7 @@
 
 #include <stdint.h>
 #include "chip.h"
+#include "mutex.h"
 
 /*------------------------------------------------------------------------------
  *      Definitions
@@ -401,6 +402,31 @@ typedef struct _SdHalFunctions {
 	fSdmmcIOCtrl fIOCtrl;	    /**< Pointer to IO control function */
 } sSdHalFunctions;
 
+/** Maximum number of asynchronous block I/O requests queued per device */
+#ifndef SDMMC_REQ_QUEUE_SIZE
+#define SDMMC_REQ_QUEUE_SIZE     8
+#endif
+
+/**
+ * \brief Asynchronous block I/O request, see SD_SubmitRequest().
+ * The request and its data buffer shall remain valid until the completion
+ * callback has been invoked.
+ */
+typedef struct _SdmmcRequest {
+	uint32_t dwAddr;	    /**< Address of the first block */
+	uint32_t dwNbBlocks;	    /**< Number of blocks to transfer */
+	uint8_t *pData;		    /**< Data buffer. It shall follow the
+				     * peripheral and DMA alignment
+				     * requirements. */
+	fSdmmcCallback fCallback;   /**< Optional callback invoked on
+				     * completion, with the request status */
+	void *pArg;		    /**< Optional argument to the callback */
+	uint32_t dwDone;	    /**< Blocks transferred so far */
+	uint8_t bWrite;		    /**< 1 to write to the device, 0 to read */
+	uint8_t bStatus;	    /**< SDMMC_BUSY while the request is
+				     * pending, then \ref sdmmc_rc result */
+} sSdmmcRequest;
+
 /**
  * \brief SD/MMC card driver structure.
  * It holds the current command being processed and the SD/MMC card address.
@@ -458,6 +484,19 @@ typedef struct _SdCard {
 	uint8_t bStatus;	/**< Unrecovered error */
 	uint8_t bSetBlkCnt;	/**< Explicit SET_BLOCK_COUNT command used */
 	uint8_t bStopMultXfer;	/**< Explicit STOP_TRANSMISSION command used */
+
+	sSdmmcRequest *pReqQueue[SDMMC_REQ_QUEUE_SIZE];
+				/**< Pending asynchronous requests */
+	sSdmmcRequest sdReq;	/**< Request used by SD_Read() and SD_Write()
+				 * when invoked with a callback */
+	mutex_t reqLock;	/**< Held while requests are being processed */
+	uint32_t dwReqResp;	/**< Response to the asynchronous commands */
+	volatile uint16_t wReqHead;	/**< Request queue write index */
+	volatile uint16_t wReqTail;	/**< Request queue read index */
+	uint16_t wReqChunk;	/**< Blocks of the data command in progress */
+	uint16_t wReqRetries;	/**< SEND_STATUS commands sent so far */
+	uint8_t bReqStep;	/**< Current step of the request in progress */
+	uint8_t bReqError;	/**< Error met by the request in progress */
 } sSdCard;
 
 /** \addtogroup sdmmc_struct_cmdarg SD/MMC command arguments
@@ -0,0 +1,541 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "media.h"
+#include "media_cache.h"
+#include "media_private.h"
+
+#include "trace.h"
+#include "intmath.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Return the bitmap of count blocks, starting at block first of a line.
+ */
+static uint32_t _block_mask(uint32_t first, uint32_t count)
+{
+	uint32_t mask = count >= 32 ? 0xffffffff : (1u << count) - 1;
+
+	return mask << first;
+}
+
+/**
+ * \brief Return the number of blocks in a bitmap.
+ */
+static uint32_t _block_count(uint32_t mask)
+{
+	uint32_t count = 0;
+
+	while (mask) {
+		mask &= mask - 1;
+		count++;
+	}
+	return count;
+}
+
+/**
+ * \brief Return a pointer to the data of a block held in a cache line.
+ */
+static uint8_t* _line_data(struct _media_cache *cache,
+		struct _media_cache_line *line, uint32_t offset)
+{
+	uint32_t index = line - cache->lines;
+	uint32_t block = index * cache->line_blocks + offset;
+
+	return cache->buffer + block * cache->backend->block_size;
+}
+
+/**
+ * \brief Look up the cache line holding the specified line tag.
+ * \return Pointer to the cache line, or NULL if the line is not cached.
+ */
+static struct _media_cache_line* _line_lookup(struct _media_cache *cache,
+		uint32_t tag)
+{
+	struct _media_cache_line *line;
+
+	for (line = cache->lines; line < cache->lines + cache->num_lines;
+	     line++) {
+		if (line->valid && line->tag == tag) {
+			line->stamp = ++cache->clock;
+			return line;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * \brief Write back the dirty blocks of a cache line. Each run of adjacent
+ * dirty blocks is written with a single multi-block write.
+ * \return Operation result code
+ */
+static uint8_t _line_write_back(struct _media_cache *cache,
+		struct _media_cache_line *line)
+{
+	uint32_t first, count;
+	uint8_t status;
+
+	first = 0;
+	while (first < cache->line_blocks) {
+		if (!(line->dirty & (1u << first))) {
+			first++;
+			continue;
+		}
+		for (count = 1; first + count < cache->line_blocks; count++)
+			if (!(line->dirty & (1u << (first + count))))
+				break;
+		status = media_write(cache->backend, line->tag + first,
+				_line_data(cache, line, first), count,
+				NULL, NULL);
+		if (status != MEDIA_STATUS_SUCCESS) {
+			trace_warning("media_cache: write back of %u blocks at "
+					"%u failed\r\n", (unsigned)count,
+					(unsigned)(line->tag + first));
+			return status;
+		}
+		line->dirty &= ~_block_mask(first, count);
+		cache->stats.write_backs++;
+		cache->stats.merged += count - 1;
+		first += count;
+	}
+	return MEDIA_STATUS_SUCCESS;
+}
+
+/**
+ * \brief Allocate a cache line for the specified line tag, evicting the least
+ * recently used line if needed.
+ * \return Pointer to the cache line, or NULL if the evicted line could not be
+ * written back.
+ */
+static struct _media_cache_line* _line_alloc(struct _media_cache *cache,
+		uint32_t tag)
+{
+	struct _media_cache_line *line, *victim = cache->lines;
+
+	for (line = cache->lines; line < cache->lines + cache->num_lines;
+	     line++) {
+		if (!line->valid) {
+			victim = line;
+			break;
+		}
+		if (line->stamp < victim->stamp)
+			victim = line;
+	}
+	if (victim->dirty &&
+	    _line_write_back(cache, victim) != MEDIA_STATUS_SUCCESS)
+		return NULL;
+	victim->tag = tag;
+	victim->valid = 0;
+	victim->stamp = ++cache->clock;
+	return victim;
+}
+
+/**
+ * \brief Read the missing blocks in range [first, last] of a cache line.
+ * Blocks already present, dirty or not, are preserved.
+ * \return Operation result code
+ */
+static uint8_t _line_fill(struct _media_cache *cache,
+		struct _media_cache_line *line, uint32_t first, uint32_t last)
+{
+	uint32_t count;
+	uint8_t status;
+
+	while (first <= last) {
+		if (line->valid & (1u << first)) {
+			first++;
+			continue;
+		}
+		for (count = 1; first + count <= last; count++)
+			if (line->valid & (1u << (first + count)))
+				break;
+		status = media_read(cache->backend, line->tag + first,
+				_line_data(cache, line, first), count,
+				NULL, NULL);
+		if (status != MEDIA_STATUS_SUCCESS)
+			return status;
+		line->valid |= _block_mask(first, count);
+		first += count;
+	}
+	return MEDIA_STATUS_SUCCESS;
+}
+
+/**
+ * \brief Fetch the line holding the specified block in advance, unless it is
+ * cached already or lies beyond the end of the media.
+ */
+static void _read_ahead(struct _media_cache *cache, uint32_t block)
+{
+	struct _media_cache_line *line;
+	uint32_t tag = block - block % cache->line_blocks;
+	uint32_t last;
+
+	if (block >= cache->backend->size || _line_lookup(cache, tag))
+		return;
+	last = min_u32(cache->line_blocks, cache->backend->size - tag) - 1;
+	line = _line_alloc(cache, tag);
+	if (!line)
+		return;
+	if (_line_fill(cache, line, 0, last) == MEDIA_STATUS_SUCCESS)
+		cache->stats.read_ahead += last + 1;
+}
+
+/**
+ * \brief Count the blocks, starting at the specified block, which span whole
+ * lines that are not cached.
+ */
+static uint32_t _uncached_lines(struct _media_cache *cache,
+		uint32_t block, uint32_t length)
+{
+	uint32_t count = 0;
+
+	if (block % cache->line_blocks)
+		return 0;
+	while (length - count >= cache->line_blocks) {
+		/* Do not update the LRU stamp of the lines found */
+		struct _media_cache_line *line;
+		for (line = cache->lines;
+		     line < cache->lines + cache->num_lines; line++)
+			if (line->valid && line->tag == block + count)
+				return count;
+		count += cache->line_blocks;
+	}
+	return count;
+}
+
+/**
+ * \brief Reads a specified amount of data through the cache
+ * \param media Pointer to a Media instance
+ * \param address Address of the first block to read
+ * \param data Pointer to the buffer in which to store the retrieved data
+ * \param length Number of blocks to read
+ * \param callback Optional pointer to a callback function to invoke when
+ *                 the operation is finished
+ * \param callback_arg Optional pointer to an argument for the callback
+ * \return Operation result code
+ */
+static uint8_t media_cache_read(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+	struct _media_cache_line *line;
+	uint32_t block_size = media->block_size;
+	uint32_t block = address, end = address + length;
+	uint32_t offset, count, mask;
+	uint8_t *out = (uint8_t *)data;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+	bool sequential;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if (end > media->size || end < address)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+	sequential = address == cache->next_block;
+
+	while (block < end) {
+		/* Read whole lines that are not cached directly */
+		count = _uncached_lines(cache, block, end - block);
+		if (count) {
+			status = media_read(cache->backend, block, out, count,
+					NULL, NULL);
+			if (status != MEDIA_STATUS_SUCCESS)
+				break;
+			cache->stats.bypassed += count;
+			block += count;
+			out += count * block_size;
+			continue;
+		}
+
+		offset = block % cache->line_blocks;
+		count = min_u32(cache->line_blocks - offset, end - block);
+		mask = _block_mask(offset, count);
+		line = _line_lookup(cache, block - offset);
+		if (!line) {
+			line = _line_alloc(cache, block - offset);
+			if (!line) {
+				status = MEDIA_STATUS_ERROR;
+				break;
+			}
+		}
+		if ((line->valid & mask) != mask) {
+			/* Complete the line up to its end, so as to serve the
+			 * next sequential blocks */
+			uint32_t last = min_u32(cache->line_blocks,
+					media->size - line->tag) - 1;
+			uint32_t missing = ~line->valid & mask;
+			uint32_t ahead = ~line->valid
+				& _block_mask(offset, last + 1 - offset)
+				& ~mask;
+			status = _line_fill(cache, line, offset, last);
+			if (status != MEDIA_STATUS_SUCCESS)
+				break;
+			cache->stats.misses += _block_count(missing);
+			cache->stats.read_ahead += _block_count(ahead);
+			cache->stats.hits += count - _block_count(missing);
+		} else {
+			cache->stats.hits += count;
+		}
+		memcpy(out, _line_data(cache, line, offset),
+		       count * block_size);
+		block += count;
+		out += count * block_size;
+	}
+
+	if (status == MEDIA_STATUS_SUCCESS) {
+		cache->next_block = end;
+		if (cache->read_ahead && sequential)
+			_read_ahead(cache, end);
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ * \brief Writes data through the cache. Data is written back to the backend
+ * when its cache line is evicted, or upon media_flush().
+ * \param media Pointer to a Media instance
+ * \param address Address of the first block to write
+ * \param data Pointer to the data to write
+ * \param length Number of blocks to write
+ * \param callback Optional pointer to a callback function to invoke when
+ *                 the write operation terminates
+ * \param callback_arg Optional argument for the callback function
+ * \return Operation result code
+ */
+static uint8_t media_cache_write(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+	struct _media_cache_line *line;
+	uint32_t block_size = media->block_size;
+	uint32_t block = address, end = address + length;
+	uint32_t offset, count, mask;
+	uint8_t *in = (uint8_t *)data;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if (end > media->size || end < address)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	while (block < end) {
+		/* Write whole lines that are not cached directly */
+		count = _uncached_lines(cache, block, end - block);
+		if (count) {
+			status = media_write(cache->backend, block, in, count,
+					NULL, NULL);
+			if (status != MEDIA_STATUS_SUCCESS)
+				break;
+			cache->stats.bypassed += count;
+			block += count;
+			in += count * block_size;
+			continue;
+		}
+
+		offset = block % cache->line_blocks;
+		count = min_u32(cache->line_blocks - offset, end - block);
+		mask = _block_mask(offset, count);
+		line = _line_lookup(cache, block - offset);
+		if (!line) {
+			line = _line_alloc(cache, block - offset);
+			if (!line) {
+				status = MEDIA_STATUS_ERROR;
+				break;
+			}
+		}
+		memcpy(_line_data(cache, line, offset), in,
+		       count * block_size);
+		line->valid |= mask;
+		line->dirty |= mask;
+		cache->stats.hits += count;
+		block += count;
+		in += count * block_size;
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ * \brief Write back all dirty blocks, then flush the backend.
+ * \param media Pointer to a Media instance
+ * \return Operation result code
+ */
+static uint8_t media_cache_flush(struct _media *media)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+	struct _media_cache_line *line;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	for (line = cache->lines; line < cache->lines + cache->num_lines;
+	     line++) {
+		if (!line->dirty)
+			continue;
+		status = _line_write_back(cache, line);
+		if (status != MEDIA_STATUS_SUCCESS)
+			return status;
+	}
+	return media_flush(cache->backend);
+}
+
+/**
+ * \brief Forward the interrupt to the backend
+ * \param media Pointer to a Media instance
+ */
+static void media_cache_handler(struct _media *media)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+
+	media_handler(cache->backend);
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ *  \brief Initializes a cache media on top of another media.
+ *  \param media Pointer to the Media instance to initialize
+ *  \param cache Pointer to the cache instance to use
+ *  \param backend Pointer to the initialized Media instance to be cached
+ *  \param lines Array of num_lines cache line descriptors
+ *  \param num_lines Number of cache lines
+ *  \param line_blocks Number of blocks per cache line, up to 32
+ *  \param buffer Cache data buffer, of num_lines * line_blocks blocks. It shall
+ *  follow the DMA alignment requirements of the backend, usually be aligned on
+ *  entire cache lines.
+ *  \return 1 if success.
+ */
+uint8_t media_cache_init(struct _media *media,
+		struct _media_cache *cache, struct _media *backend,
+		struct _media_cache_line *lines, uint16_t num_lines,
+		uint8_t line_blocks, void *buffer)
+{
+	assert(line_blocks > 0 && line_blocks <= 32);
+	assert(num_lines > 0);
+
+	if (!media_is_initialized(backend))
+		return 0;
+
+	memset(cache, 0, sizeof(*cache));
+	memset(lines, 0, num_lines * sizeof(*lines));
+	cache->backend = backend;
+	cache->lines = lines;
+	cache->num_lines = num_lines;
+	cache->line_blocks = line_blocks;
+	cache->buffer = (uint8_t *)buffer;
+	cache->read_ahead = true;
+
+	memset(media, 0, sizeof(*media));
+
+	media->write = media_cache_write;
+	media->read = media_cache_read;
+	media->flush = media_cache_flush;
+	media->handler = media_cache_handler;
+
+	media->block_size = backend->block_size;
+	media->size = backend->size;
+	media->interface = cache;
+
+	media->write_protected = backend->write_protected;
+	media->removable = backend->removable;
+	media->state = MEDIA_STATE_READY;
+
+	trace_info("media_cache: %u lines of %u blocks\r\n",
+			(unsigned)num_lines, (unsigned)line_blocks);
+	return 1;
+}
+
+/**
+ *  \brief Enable or disable reading ahead on sequential access.
+ *  \param media Pointer to a cache Media instance
+ *  \param enable true to enable reading ahead (default)
+ */
+void media_cache_set_read_ahead(struct _media *media, bool enable)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+
+	cache->read_ahead = enable;
+}
+
+/**
+ *  \brief Retrieve the cache statistics.
+ *  \param media Pointer to a cache Media instance
+ *  \param stats Pointer to the structure to fill
+ */
+void media_cache_get_stats(struct _media *media,
+		struct _media_cache_stats *stats)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+
+	*stats = cache->stats;
+}
+
+/**
+ *  \brief Clear the cache statistics.
+ *  \param media Pointer to a cache Media instance
+ */
+void media_cache_reset_stats(struct _media *media)
+{
+	struct _media_cache *cache = (struct _media_cache *)media->interface;
+
+	memset(&cache->stats, 0, sizeof(cache->stats));
+}
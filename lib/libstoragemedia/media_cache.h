@@ -0,0 +1,108 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+  *  \file
+  *
+  *  Include Defines & macros for the media layer interface for the sector
+  *  cache.
+  *
+  *  The cache media wraps another media, typically a SD card, and keeps its
+  *  most recently used blocks in RAM. The cached area is divided in lines of
+  *  consecutive blocks, replaced in LRU order. Writes are held in the cache
+  *  until their line is evicted or media_flush() is called, then the adjacent
+  *  dirty blocks of each line are written back with a single multi-block
+  *  write. When sequential reads are detected, the line following the last
+  *  block read is fetched in advance.
+  *
+  *  Transfers spanning whole lines that are not cached bypass the cache.
+  */
+
+#ifndef _MEDIA_CACHE_H
+#define _MEDIA_CACHE_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "media.h"
+
+/*------------------------------------------------------------------------------
+ *      Types
+ *------------------------------------------------------------------------------*/
+
+/** Cache line, describing a group of consecutive blocks */
+struct _media_cache_line {
+	uint32_t tag;            /**< First block of the line */
+	uint32_t stamp;          /**< Time of last access, for LRU replacement */
+	uint32_t valid;          /**< Bitmap of the blocks holding data */
+	uint32_t dirty;          /**< Bitmap of the blocks to write back */
+};
+
+/** Cache statistics, in number of blocks unless otherwise specified */
+struct _media_cache_stats {
+	uint32_t hits;           /**< Blocks read from or written to the cache */
+	uint32_t misses;         /**< Blocks read from the backend on demand */
+	uint32_t read_ahead;     /**< Blocks read from the backend in advance */
+	uint32_t bypassed;       /**< Blocks transferred without caching */
+	uint32_t write_backs;    /**< Write operations issued to the backend */
+	uint32_t merged;         /**< Blocks written back along with the
+	                          * previous one, in the same operation */
+};
+
+/** Cache instance */
+struct _media_cache {
+	struct _media *backend;  /**< Media being cached */
+	struct _media_cache_line *lines; /**< Line descriptors */
+	uint8_t *buffer;         /**< Line data */
+	uint16_t num_lines;      /**< Number of lines */
+	uint8_t line_blocks;     /**< Number of blocks per line */
+	bool read_ahead;         /**< Read ahead on sequential access */
+	uint32_t clock;          /**< Access counter */
+	uint32_t next_block;     /**< Block following the last read */
+	struct _media_cache_stats stats;
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern uint8_t media_cache_init(struct _media *media,
+		struct _media_cache *cache, struct _media *backend,
+		struct _media_cache_line *lines, uint16_t num_lines,
+		uint8_t line_blocks, void *buffer);
+
+extern void media_cache_set_read_ahead(struct _media *media, bool enable);
+
+extern void media_cache_get_stats(struct _media *media,
+		struct _media_cache_stats *stats);
+
+extern void media_cache_reset_stats(struct _media *media);
+
+#endif /* _MEDIA_CACHE_H */
@@ -0,0 +1,528 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "media.h"
+#include "media_nandflash.h"
+#include "media_private.h"
+
+#include "trace.h"
+
+#include "misc/cache.h"
+#include "peripherals/pmecc.h"
+
+#include "memories/nand-flash/nand_flash_ecc.h"
+#include "memories/nand-flash/nand_flash_onfi.h"
+#include "memories/nand-flash/nand_flash_raw.h"
+#include "memories/nand-flash/nand_flash_skip_block.h"
+#include "memories/nand-flash/nand_flash_spare_scheme.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*---------------------------------------------------------------------------
+ *         Local variables
+ *---------------------------------------------------------------------------*/
+
+/** Spare area buffer */
+CACHE_ALIGNED static uint8_t spare_buf[NAND_MAX_PAGE_SPARE_SIZE];
+
+/*---------------------------------------------------------------------------
+ *      Flash access methods of the translation layer
+ *---------------------------------------------------------------------------*/
+
+static uint8_t _nand_read_data(void *dev, uint32_t block, uint32_t page,
+		void *data)
+{
+	struct _media_nandflash *nf = (struct _media_nandflash *)dev;
+
+	return nand_ecc_read_page(nf->nand, nf->first_block + block, page,
+			data, NULL);
+}
+
+static uint8_t _nand_read_tag(void *dev, uint32_t block, uint32_t page,
+		uint8_t *tag)
+{
+	struct _media_nandflash *nf = (struct _media_nandflash *)dev;
+	uint8_t status;
+
+	status = nand_raw_read_page(nf->nand, nf->first_block + block, page,
+			NULL, spare_buf);
+	if (status)
+		return status;
+	memcpy(tag, &spare_buf[nf->tag_offset], NAND_FTL_TAG_SIZE);
+	return 0;
+}
+
+static uint8_t _nand_write(void *dev, uint32_t block, uint32_t page,
+		const void *data, const uint8_t *tag)
+{
+	struct _media_nandflash *nf = (struct _media_nandflash *)dev;
+	uint16_t spare_size = nand_model_get_page_spare_size(&nf->nand->model);
+	uint8_t status;
+
+	block += nf->first_block;
+	memset(spare_buf, 0xff, spare_size);
+	memcpy(&spare_buf[nf->tag_offset], tag, NAND_FTL_TAG_SIZE);
+
+	if (!nand_is_using_pmecc())
+		return nand_ecc_write_page(nf->nand, block, page,
+				(void *)data, spare_buf);
+
+	/* The PMECC does not allow spare data along with the page data: the
+	 * tag is programmed afterwards, a page left without tag being ignored
+	 * by the translation layer. This second program of the page requires
+	 * a device allowing partial page programs, see media_nandflash_init. */
+	status = nand_ecc_write_page(nf->nand, block, page, (void *)data, NULL);
+	if (status)
+		return status;
+	return nand_raw_write_page(nf->nand, block, page, NULL, spare_buf);
+}
+
+static uint8_t _nand_erase(void *dev, uint32_t block)
+{
+	struct _media_nandflash *nf = (struct _media_nandflash *)dev;
+
+	return nand_raw_erase_block(nf->nand, nf->first_block + block);
+}
+
+static bool _nand_is_bad(void *dev, uint32_t block)
+{
+	struct _media_nandflash *nf = (struct _media_nandflash *)dev;
+
+	return nand_skipblock_check_block(nf->nand,
+			nf->first_block + block) == BADBLOCK;
+}
+
+static void _nand_mark_bad(void *dev, uint32_t block)
+{
+	struct _media_nandflash *nf = (struct _media_nandflash *)dev;
+	uint16_t spare_size = nand_model_get_page_spare_size(&nf->nand->model);
+
+	trace_warning("media_nandflash: marking block %u as bad\r\n",
+			(unsigned)(nf->first_block + block));
+	memset(spare_buf, 0xff, spare_size);
+	nand_spare_scheme_write_bad_block_marker(
+			nand_model_get_scheme(&nf->nand->model),
+			spare_buf, NANDBLOCK_STATUS_BAD);
+	nand_raw_write_page(nf->nand, nf->first_block + block, 0, NULL,
+			spare_buf);
+}
+
+static const struct _nand_ftl_ops _nand_ftl_ops = {
+	.read_data = _nand_read_data,
+	.read_tag = _nand_read_tag,
+	.write = _nand_write,
+	.erase = _nand_erase,
+	.is_bad = _nand_is_bad,
+	.mark_bad = _nand_mark_bad,
+};
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Check whether a spare byte is free for the tags, i.e. it neither
+ * holds the bad block marker nor ECC bytes.
+ */
+static bool _is_spare_byte_free(const struct _nand_flash *nand,
+		uint32_t position)
+{
+	const struct _nand_spare_scheme *scheme =
+		nand_model_get_scheme(&nand->model);
+	uint32_t i;
+
+	/* Large page devices use the two first bytes for the marker */
+	if (position < 2 || position == scheme->bad_block_marker_position)
+		return false;
+
+	if (nand_is_using_pmecc())
+		return position < pmecc_get_ecc_start_address() ||
+			position > pmecc_get_ecc_end_address();
+
+	if (nand_is_using_software_ecc()) {
+		for (i = 0; i < scheme->num_ecc_bytes; i++)
+			if (scheme->ecc_bytes_positions[i] == position)
+				return false;
+	}
+	return true;
+}
+
+/**
+ * \brief Find the first run of spare bytes able to hold a tag.
+ * \return the offset of the run, or -1 if there is none
+ */
+static int _find_tag_offset(const struct _nand_flash *nand)
+{
+	uint32_t spare_size = nand_model_get_page_spare_size(&nand->model);
+	uint32_t i, run = 0;
+
+	for (i = 0; i < spare_size; i++) {
+		run = _is_spare_byte_free(nand, i) ? run + 1 : 0;
+		if (run == NAND_FTL_TAG_SIZE)
+			return i + 1 - NAND_FTL_TAG_SIZE;
+	}
+	return -1;
+}
+
+/**
+ * \brief Write back the page combine buffer if it holds pending writes.
+ */
+static uint8_t _buffer_write_back(struct _media_nandflash *nf)
+{
+	if (!nf->dirty)
+		return MEDIA_STATUS_SUCCESS;
+
+	if (nand_ftl_write(&nf->ftl, nf->buffer_page, nf->buffer))
+		return MEDIA_STATUS_ERROR;
+	nf->dirty = false;
+	return MEDIA_STATUS_SUCCESS;
+}
+
+/**
+ * \brief Load a logical page in the combine buffer, writing back the page
+ * it held before if needed.
+ */
+static uint8_t _buffer_load(struct _media_nandflash *nf, uint32_t page)
+{
+	uint8_t status;
+
+	if (nf->buffer_page == page)
+		return MEDIA_STATUS_SUCCESS;
+
+	status = _buffer_write_back(nf);
+	if (status != MEDIA_STATUS_SUCCESS)
+		return status;
+
+	nf->buffer_page = NAND_FTL_NONE;
+	if (nand_ftl_read(&nf->ftl, page, nf->buffer))
+		return MEDIA_STATUS_ERROR;
+	nf->buffer_page = page;
+	return MEDIA_STATUS_SUCCESS;
+}
+
+/**
+ * \brief Reads a specified amount of data from a NAND flash media
+ * \param media Pointer to a Media instance
+ * \param address Address of the data to read
+ * \param data Pointer to the buffer in which to store the retrieved data
+ * \param length Length of the buffer
+ * \param callback Optional pointer to a callback function to invoke when
+ *                 the operation is finished
+ * \param callback_arg Optional pointer to an argument for the callback
+ * \return Operation result code
+ */
+static uint8_t media_nandflash_read(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_nandflash *nf =
+		(struct _media_nandflash *)media->interface;
+	uint32_t per_page = nf->ftl.page_size / MEDIA_NANDFLASH_BLOCK_SIZE;
+	uint8_t *out = (uint8_t *)data;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	while (length) {
+		uint32_t page = address / per_page;
+		uint32_t offset = address % per_page;
+		uint32_t count = per_page - offset;
+
+		if (count > length)
+			count = length;
+
+		if (count == per_page && page != nf->buffer_page) {
+			/* Whole page, read in place */
+			if (nand_ftl_read(&nf->ftl, page, out)) {
+				status = MEDIA_STATUS_ERROR;
+				break;
+			}
+		} else {
+			status = _buffer_load(nf, page);
+			if (status != MEDIA_STATUS_SUCCESS)
+				break;
+			memcpy(out, nf->buffer + offset * MEDIA_NANDFLASH_BLOCK_SIZE,
+					count * MEDIA_NANDFLASH_BLOCK_SIZE);
+		}
+		address += count;
+		length -= count;
+		out += count * MEDIA_NANDFLASH_BLOCK_SIZE;
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ *  \brief Writes data on a NAND flash media. Partial pages are held in the
+ *  combine buffer until another page is accessed.
+ *  \param media Pointer to a Media instance
+ *  \param address Address at which to write
+ *  \param data Pointer to the data to write
+ *  \param length Size of the data buffer
+ *  \param callback Optional pointer to a callback function to invoke when
+ *                  the write operation terminates
+ *  \param callback_arg Optional argument for the callback function
+ *  \return Operation result code
+ */
+static uint8_t media_nandflash_write(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_nandflash *nf =
+		(struct _media_nandflash *)media->interface;
+	uint32_t per_page = nf->ftl.page_size / MEDIA_NANDFLASH_BLOCK_SIZE;
+	const uint8_t *in = (const uint8_t *)data;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	while (length) {
+		uint32_t page = address / per_page;
+		uint32_t offset = address % per_page;
+		uint32_t count = per_page - offset;
+
+		if (count > length)
+			count = length;
+
+		if (count == per_page) {
+			/* Whole page, the buffered copy is superseded */
+			if (nf->buffer_page == page) {
+				nf->buffer_page = NAND_FTL_NONE;
+				nf->dirty = false;
+			}
+			if (nand_ftl_write(&nf->ftl, page, in)) {
+				status = MEDIA_STATUS_ERROR;
+				break;
+			}
+		} else {
+			status = _buffer_load(nf, page);
+			if (status != MEDIA_STATUS_SUCCESS)
+				break;
+			memcpy(nf->buffer + offset * MEDIA_NANDFLASH_BLOCK_SIZE, in,
+					count * MEDIA_NANDFLASH_BLOCK_SIZE);
+			nf->dirty = true;
+		}
+		address += count;
+		length -= count;
+		in += count * MEDIA_NANDFLASH_BLOCK_SIZE;
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ * \brief Write back the page combine buffer.
+ * \param media Pointer to a Media instance
+ * \return Operation result code
+ */
+static uint8_t media_nandflash_flush(struct _media *media)
+{
+	struct _media_nandflash *nf =
+		(struct _media_nandflash *)media->interface;
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	media->state = MEDIA_STATE_BUSY;
+	status = _buffer_write_back(nf);
+	media->state = MEDIA_STATE_READY;
+	return status;
+}
+
+/**
+ * \brief Perform a step of background garbage collection
+ * \param media Pointer to a Media instance
+ */
+static void media_nandflash_handler(struct _media *media)
+{
+	struct _media_nandflash *nf =
+		(struct _media_nandflash *)media->interface;
+
+	if (media->state != MEDIA_STATE_READY)
+		return;
+
+	media->state = MEDIA_STATE_BUSY;
+	nand_ftl_collect(&nf->ftl);
+	media->state = MEDIA_STATE_READY;
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ *  \brief Initializes a media on an area of an initialized NAND flash and
+ *  mounts its translation layer.
+ *  \param media Pointer to the Media instance to initialize
+ *  \param nandflash Pointer to the NAND flash media instance to use
+ *  \param nand Pointer to the NAND flash device, with its ECC configured
+ *  \param first_block First block of the area
+ *  \param num_blocks Number of blocks of the area
+ *  \param reserved_blocks Blocks not exported, used for garbage collection
+ *  and bad block replacement, at least NAND_FTL_MIN_RESERVED. A few percent
+ *  of the area is recommended. Must not change once the area is in use.
+ *  \param map Logical to physical map, of
+ *  NAND_FTL_NUM_PAGES(num_blocks, pages per block, reserved_blocks) entries
+ *  \param blocks Array of num_blocks block states
+ *  \param buffer Buffer of two pages. It shall follow the DMA alignment
+ *  requirements of the NAND flash driver, usually be aligned on entire cache
+ *  lines.
+ *  \return 1 if success.
+ */
+uint8_t media_nandflash_init(struct _media *media,
+		struct _media_nandflash *nandflash,
+		const struct _nand_flash *nand,
+		uint16_t first_block, uint16_t num_blocks,
+		uint16_t reserved_blocks, uint32_t *map,
+		struct _nand_ftl_block *blocks, void *buffer)
+{
+	uint32_t page_size = nand_model_get_page_data_size(&nand->model);
+	uint32_t pages_per_block = nand_model_get_block_size_in_pages(&nand->model);
+	int tag_offset;
+	uint8_t status;
+
+	assert(first_block + num_blocks <=
+			nand_model_get_device_size_in_blocks(&nand->model));
+
+	if (page_size < MEDIA_NANDFLASH_BLOCK_SIZE) {
+		trace_error("media_nandflash: unsupported page size\r\n");
+		return 0;
+	}
+
+	/* With the PMECC the tag is programmed apart from the data */
+	if (nand_is_using_pmecc()) {
+		if (!nand_onfi_is_compatible()) {
+			trace_warning("media_nandflash: partial page programs "
+					"assumed to be supported\r\n");
+		} else if (nand_onfi_get_programs_per_page() == 1) {
+			trace_error("media_nandflash: partial page programs "
+					"not supported with PMECC\r\n");
+			return 0;
+		}
+	}
+
+	tag_offset = _find_tag_offset(nand);
+	if (tag_offset < 0) {
+		trace_error("media_nandflash: no room for tags in spare area\r\n");
+		return 0;
+	}
+
+	memset(nandflash, 0, sizeof(*nandflash));
+	nandflash->nand = nand;
+	nandflash->first_block = first_block;
+	nandflash->tag_offset = tag_offset;
+	nandflash->buffer = (uint8_t *)buffer + page_size;
+	nandflash->buffer_page = NAND_FTL_NONE;
+
+	status = nand_ftl_mount(&nandflash->ftl, &_nand_ftl_ops, nandflash,
+			num_blocks, pages_per_block, page_size, reserved_blocks,
+			map, blocks, buffer);
+	if (status != NAND_FTL_SUCCESS) {
+		trace_error("media_nandflash: mount failed (%u)\r\n",
+				(unsigned)status);
+		return 0;
+	}
+
+	memset(media, 0, sizeof(*media));
+
+	media->write = media_nandflash_write;
+	media->read = media_nandflash_read;
+	media->flush = media_nandflash_flush;
+	media->handler = media_nandflash_handler;
+
+	media->block_size = MEDIA_NANDFLASH_BLOCK_SIZE;
+	media->size = nandflash->ftl.num_pages *
+		(page_size / MEDIA_NANDFLASH_BLOCK_SIZE);
+	media->interface = nandflash;
+
+	media->removable = false;
+	media->state = MEDIA_STATE_READY;
+
+	trace_info("media_nandflash: %u blocks, %u reserved, %u free\r\n",
+			(unsigned)num_blocks, (unsigned)reserved_blocks,
+			(unsigned)nandflash->ftl.free_blocks);
+	return 1;
+}
+
+/**
+ *  \brief Retrieve the statistics of the translation layer, e.g. to
+ *  evaluate the write amplification as flash_writes / host_writes.
+ *  \param media Pointer to a NAND flash Media instance
+ *  \param stats Pointer to the structure to fill
+ */
+void media_nandflash_get_stats(struct _media *media,
+		struct _nand_ftl_stats *stats)
+{
+	struct _media_nandflash *nf =
+		(struct _media_nandflash *)media->interface;
+
+	nand_ftl_get_stats(&nf->ftl, stats);
+}
+
+/**
+ *  \brief Reset the statistics of the translation layer.
+ *  \param media Pointer to a NAND flash Media instance
+ */
+void media_nandflash_reset_stats(struct _media *media)
+{
+	struct _media_nandflash *nf =
+		(struct _media_nandflash *)media->interface;
+
+	nand_ftl_reset_stats(&nf->ftl);
+}
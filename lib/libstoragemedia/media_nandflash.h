@@ -0,0 +1,98 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+  *  \file
+  *
+  *  Include Defines & macros for the media layer interface for raw NAND
+  *  flash.
+  *
+  *  The NAND flash media exports an area of a NAND flash device as a disk
+  *  of 512-byte blocks, through the flash translation layer of nand_ftl.h
+  *  which provides wear leveling, bad block management and consistency
+  *  across power failures.
+  *
+  *  Each NAND page holds several media blocks. Writes smaller than a page
+  *  are combined in a page buffer, written back when another page is
+  *  accessed or upon media_flush(). Garbage collection is performed during
+  *  writes when needed, and in the background by media_handler() which
+  *  should be called when the application is idle.
+  */
+
+#ifndef _MEDIA_NANDFLASH_H
+#define _MEDIA_NANDFLASH_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "media.h"
+#include "nand_ftl.h"
+
+#include "memories/nand-flash/nand_flash.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the media blocks */
+#define MEDIA_NANDFLASH_BLOCK_SIZE 512
+
+/*------------------------------------------------------------------------------
+ *      Types
+ *------------------------------------------------------------------------------*/
+
+/** NAND flash media instance */
+struct _media_nandflash {
+	struct _nand_ftl ftl;        /**< Translation layer state */
+	const struct _nand_flash *nand;
+	uint16_t first_block;        /**< First block of the area */
+	uint16_t tag_offset;         /**< Offset of the tags in the spare area */
+	uint8_t *buffer;             /**< Page combine buffer */
+	uint32_t buffer_page;        /**< Logical page held by the buffer */
+	bool dirty;                  /**< Buffer to be written back */
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern uint8_t media_nandflash_init(struct _media *media,
+		struct _media_nandflash *nandflash,
+		const struct _nand_flash *nand,
+		uint16_t first_block, uint16_t num_blocks,
+		uint16_t reserved_blocks, uint32_t *map,
+		struct _nand_ftl_block *blocks, void *buffer);
+
+extern void media_nandflash_get_stats(struct _media *media,
+		struct _nand_ftl_stats *stats);
+
+extern void media_nandflash_reset_stats(struct _media *media);
+
+#endif /* _MEDIA_NANDFLASH_H */
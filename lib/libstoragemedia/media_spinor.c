@@ -0,0 +1,555 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "chip.h"
+
+#include "media.h"
+#include "media_spinor.h"
+#include "media_private.h"
+
+#include "trace.h"
+
+#include "misc/cache.h"
+#include "memories/at25.h"
+#include "memories/spi-nor.h"
+#ifdef CONFIG_HAVE_QSPI
+#include "memories/qspiflash.h"
+#endif
+
+#include <string.h>
+
+/*---------------------------------------------------------------------------
+ *         Local definitions
+ *---------------------------------------------------------------------------*/
+
+/** Granularity of the comparisons and programming on write back */
+#define CHUNK_SIZE 256
+
+/** No sector in the buffer */
+#define NO_SECTOR 0xffffffffu
+
+/*---------------------------------------------------------------------------
+ *         Local variables
+ *---------------------------------------------------------------------------*/
+
+/** Buffer for the flash content compared on write back */
+CACHE_ALIGNED static uint8_t chunk_buf[CHUNK_SIZE];
+
+/*---------------------------------------------------------------------------
+ *      Flash access methods
+ *---------------------------------------------------------------------------*/
+
+static bool _at25_read(struct _media_spinor *nor, uint32_t addr,
+		void *data, uint32_t length)
+{
+	return at25_read((struct _at25 *)nor->flash, addr, (uint8_t *)data,
+			length) == AT25_SUCCESS;
+}
+
+static bool _at25_write(struct _media_spinor *nor, uint32_t addr,
+		const void *data, uint32_t length)
+{
+	return at25_write((struct _at25 *)nor->flash, addr,
+			(const uint8_t *)data, length) == AT25_SUCCESS;
+}
+
+static bool _at25_erase(struct _media_spinor *nor, uint32_t addr)
+{
+	return at25_erase_block((struct _at25 *)nor->flash, addr,
+			nor->sector_size) == AT25_SUCCESS;
+}
+
+#ifdef CONFIG_HAVE_QSPI
+
+static bool _qspiflash_read(struct _media_spinor *nor, uint32_t addr,
+		void *data, uint32_t length)
+{
+	return qspiflash_read((struct _qspiflash *)nor->flash, addr, data,
+			length);
+}
+
+static bool _qspiflash_write(struct _media_spinor *nor, uint32_t addr,
+		const void *data, uint32_t length)
+{
+	struct _qspiflash *flash = (struct _qspiflash *)nor->flash;
+
+	if (!qspiflash_write(flash, addr, data, length))
+		return false;
+
+	/* Restore the memory-mapped read mode */
+	return !nor->mapped || qspiflash_read(flash, 0, NULL, 0);
+}
+
+static bool _qspiflash_erase(struct _media_spinor *nor, uint32_t addr)
+{
+	struct _qspiflash *flash = (struct _qspiflash *)nor->flash;
+
+	if (!qspiflash_erase_block(flash, addr, nor->sector_size))
+		return false;
+
+	/* Restore the memory-mapped read mode */
+	return !nor->mapped || qspiflash_read(flash, 0, NULL, 0);
+}
+
+#endif /* CONFIG_HAVE_QSPI */
+
+/*---------------------------------------------------------------------------
+ *      Internal Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ * \brief Return the smallest erase size supported by a device.
+ */
+static uint32_t _get_sector_size(const struct _spi_nor_desc *desc)
+{
+	if (desc->flags & SPINOR_FLAG_ERASE_4K)
+		return 4 * 1024;
+	if (desc->flags & SPINOR_FLAG_ERASE_32K)
+		return 32 * 1024;
+	if (desc->flags & SPINOR_FLAG_ERASE_64K)
+		return 64 * 1024;
+	if (desc->flags & SPINOR_FLAG_ERASE_256K)
+		return 256 * 1024;
+	return 0;
+}
+
+/**
+ * \brief Program a whole sector, erasing it only if required.
+ * \param nor Pointer to the serial NOR media instance
+ * \param sector Sector index in the area
+ * \param data New content of the sector
+ */
+static uint8_t _sector_program(struct _media_spinor *nor, uint32_t sector,
+		const uint8_t *data)
+{
+	uint32_t addr = nor->offset + sector * nor->sector_size;
+	uint32_t pos, i;
+	bool erase = false;
+
+	nor->stats.write_backs++;
+
+	/* Check whether the new content only clears bits */
+	for (pos = 0; pos < nor->sector_size && !erase; pos += CHUNK_SIZE) {
+		if (!nor->flash_read(nor, addr + pos, chunk_buf, CHUNK_SIZE))
+			return MEDIA_STATUS_ERROR;
+		for (i = 0; i < CHUNK_SIZE; i++) {
+			if (data[pos + i] & ~chunk_buf[i]) {
+				erase = true;
+				break;
+			}
+		}
+	}
+
+	if (erase) {
+		if (!nor->flash_erase(nor, addr))
+			return MEDIA_STATUS_ERROR;
+		nor->stats.erases++;
+	} else {
+		nor->stats.erases_skipped++;
+	}
+
+	/* Program the chunks which are not blank, or which changed */
+	for (pos = 0; pos < nor->sector_size; pos += CHUNK_SIZE) {
+		const uint8_t *chunk = &data[pos];
+
+		if (erase) {
+			for (i = 0; i < CHUNK_SIZE; i++)
+				if (chunk[i] != 0xff)
+					break;
+		} else {
+			if (!nor->flash_read(nor, addr + pos, chunk_buf,
+						CHUNK_SIZE))
+				return MEDIA_STATUS_ERROR;
+			for (i = 0; i < CHUNK_SIZE; i++)
+				if (chunk[i] != chunk_buf[i])
+					break;
+		}
+		if (i == CHUNK_SIZE)
+			continue;
+
+		if (!nor->flash_write(nor, addr + pos, chunk, CHUNK_SIZE))
+			return MEDIA_STATUS_ERROR;
+		nor->stats.programs++;
+	}
+
+	if (nor->mapped)
+		cache_invalidate_region(nor->mapped + addr, nor->sector_size);
+
+	return MEDIA_STATUS_SUCCESS;
+}
+
+/**
+ * \brief Write back the sector buffer if it holds pending writes.
+ */
+static uint8_t _buffer_write_back(struct _media *media)
+{
+	struct _media_spinor *nor = (struct _media_spinor *)media->interface;
+	uint8_t status;
+
+	if (!nor->dirty)
+		return MEDIA_STATUS_SUCCESS;
+
+	status = _sector_program(nor, nor->buffer_sector, nor->buffer);
+	if (status != MEDIA_STATUS_SUCCESS) {
+		/* The flash content is unknown, drop the buffer */
+		nor->buffer_sector = NO_SECTOR;
+	}
+	nor->dirty = false;
+	media->mapped_read = (nor->mapped != NULL);
+	return status;
+}
+
+/**
+ * \brief Load a sector in the buffer, writing back the sector it held
+ * before if needed.
+ */
+static uint8_t _buffer_load(struct _media *media, uint32_t sector)
+{
+	struct _media_spinor *nor = (struct _media_spinor *)media->interface;
+	uint32_t addr = nor->offset + sector * nor->sector_size;
+	uint8_t status;
+
+	if (nor->buffer_sector == sector)
+		return MEDIA_STATUS_SUCCESS;
+
+	status = _buffer_write_back(media);
+	if (status != MEDIA_STATUS_SUCCESS)
+		return status;
+
+	nor->buffer_sector = NO_SECTOR;
+	if (nor->mapped)
+		memcpy(nor->buffer, nor->mapped + addr, nor->sector_size);
+	else if (!nor->flash_read(nor, addr, nor->buffer, nor->sector_size))
+		return MEDIA_STATUS_ERROR;
+	nor->buffer_sector = sector;
+	return MEDIA_STATUS_SUCCESS;
+}
+
+/**
+ * \brief Reads a specified amount of data from a serial NOR media
+ * \param media Pointer to a Media instance
+ * \param address Address of the data to read
+ * \param data Pointer to the buffer in which to store the retrieved data
+ * \param length Length of the buffer
+ * \param callback Optional pointer to a callback function to invoke when
+ *                 the operation is finished
+ * \param callback_arg Optional pointer to an argument for the callback
+ * \return Operation result code
+ */
+static uint8_t media_spinor_read(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_spinor *nor = (struct _media_spinor *)media->interface;
+	uint32_t per_sector = nor->sector_size / MEDIA_SPINOR_BLOCK_SIZE;
+	uint8_t *out = (uint8_t *)data;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	while (length) {
+		uint32_t sector = address / per_sector;
+		uint32_t count = per_sector - address % per_sector;
+		uint32_t size, offset;
+
+		if (count > length)
+			count = length;
+		size = count * MEDIA_SPINOR_BLOCK_SIZE;
+		offset = address * MEDIA_SPINOR_BLOCK_SIZE;
+
+		if (sector == nor->buffer_sector) {
+			memcpy(out, nor->buffer + offset % nor->sector_size, size);
+		} else if (nor->mapped) {
+			memcpy(out, nor->mapped + nor->offset + offset, size);
+		} else if (!nor->flash_read(nor, nor->offset + offset, out, size)) {
+			status = MEDIA_STATUS_ERROR;
+			break;
+		}
+		address += count;
+		length -= count;
+		out += size;
+	}
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ *  \brief Writes data on a serial NOR media. Partial sectors are held in
+ *  the sector buffer until another sector is written.
+ *  \param media Pointer to a Media instance
+ *  \param address Address at which to write
+ *  \param data Pointer to the data to write
+ *  \param length Size of the data buffer
+ *  \param callback Optional pointer to a callback function to invoke when
+ *                  the write operation terminates
+ *  \param callback_arg Optional argument for the callback function
+ *  \return Operation result code
+ */
+static uint8_t media_spinor_write(struct _media *media,
+		uint32_t address, void *data, uint32_t length,
+		media_callback_t callback, void *callback_arg)
+{
+	struct _media_spinor *nor = (struct _media_spinor *)media->interface;
+	uint32_t per_sector = nor->sector_size / MEDIA_SPINOR_BLOCK_SIZE;
+	const uint8_t *in = (const uint8_t *)data;
+	uint8_t status = MEDIA_STATUS_SUCCESS;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	if ((address + length) > media->size)
+		return MEDIA_STATUS_ERROR;
+
+	media->state = MEDIA_STATE_BUSY;
+
+	while (length) {
+		uint32_t sector = address / per_sector;
+		uint32_t offset = address % per_sector;
+		uint32_t count = per_sector - offset;
+
+		if (count > length)
+			count = length;
+
+		if (count == per_sector) {
+			/* Whole sector, the buffered copy is superseded */
+			if (nor->buffer_sector == sector) {
+				nor->buffer_sector = NO_SECTOR;
+				nor->dirty = false;
+			}
+			status = _sector_program(nor, sector, in);
+		} else {
+			status = _buffer_load(media, sector);
+			if (status == MEDIA_STATUS_SUCCESS) {
+				if (nor->dirty)
+					nor->stats.merged += count;
+				memcpy(nor->buffer + offset * MEDIA_SPINOR_BLOCK_SIZE,
+						in, count * MEDIA_SPINOR_BLOCK_SIZE);
+				nor->dirty = true;
+			}
+		}
+		if (status != MEDIA_STATUS_SUCCESS)
+			break;
+		address += count;
+		length -= count;
+		in += count * MEDIA_SPINOR_BLOCK_SIZE;
+	}
+
+	/* Mapped reads would miss the content of the sector buffer */
+	media->mapped_read = nor->mapped && !nor->dirty;
+
+	media->state = MEDIA_STATE_READY;
+
+	if (callback)
+		callback(callback_arg, status, 0, 0);
+
+	return status;
+}
+
+/**
+ * \brief Write back the sector buffer.
+ * \param media Pointer to a Media instance
+ * \return Operation result code
+ */
+static uint8_t media_spinor_flush(struct _media *media)
+{
+	uint8_t status;
+
+	if (media->state != MEDIA_STATE_READY)
+		return MEDIA_STATUS_BUSY;
+
+	media->state = MEDIA_STATE_BUSY;
+	status = _buffer_write_back(media);
+	media->state = MEDIA_STATE_READY;
+	return status;
+}
+
+/**
+ * \brief Common initialization of the serial NOR media.
+ */
+static uint8_t _media_spinor_init(struct _media *media,
+		struct _media_spinor *nor, const struct _spi_nor_desc *desc,
+		uint32_t offset, uint32_t size,
+		void *buffer, uint32_t buffer_size)
+{
+	uint32_t sector_size = _get_sector_size(desc);
+
+	if (!sector_size || sector_size > buffer_size) {
+		trace_error("media_spinor: sector buffer too small\r\n");
+		return 0;
+	}
+	if ((offset % sector_size) || (size % sector_size) || !size ||
+	    offset + size > desc->size) {
+		trace_error("media_spinor: area not aligned on sectors\r\n");
+		return 0;
+	}
+
+	nor->offset = offset;
+	nor->sector_size = sector_size;
+	nor->buffer = (uint8_t *)buffer;
+	nor->buffer_sector = NO_SECTOR;
+	nor->dirty = false;
+	memset(&nor->stats, 0, sizeof(nor->stats));
+
+	memset(media, 0, sizeof(*media));
+
+	media->write = media_spinor_write;
+	media->read = media_spinor_read;
+	media->flush = media_spinor_flush;
+
+	media->block_size = MEDIA_SPINOR_BLOCK_SIZE;
+	media->size = size / MEDIA_SPINOR_BLOCK_SIZE;
+	media->interface = nor;
+	if (nor->mapped) {
+		media->base_address =
+			((uint32_t)nor->mapped + offset) / MEDIA_SPINOR_BLOCK_SIZE;
+		media->mapped_read = true;
+	}
+
+	media->removable = false;
+	media->state = MEDIA_STATE_READY;
+
+	trace_info("media_spinor: %s, %uKB at 0x%x, %uKB sectors%s\r\n",
+			desc->name, (unsigned)(size / 1024), (unsigned)offset,
+			(unsigned)(sector_size / 1024),
+			nor->mapped ? ", mapped" : "");
+	return 1;
+}
+
+/*---------------------------------------------------------------------------
+ *      Exported Functions
+ *---------------------------------------------------------------------------*/
+
+/**
+ *  \brief Initializes a media on an area of a configured AT25 flash.
+ *  \param media Pointer to the Media instance to initialize
+ *  \param nor Pointer to the serial NOR media instance to use
+ *  \param at25 Pointer to the configured AT25 instance
+ *  \param offset Offset of the area in the flash, aligned on erase sectors
+ *  \param size Size of the area in bytes, aligned on erase sectors
+ *  \param buffer Sector buffer, at least as large as the smallest erase
+ *  size of the device. It shall follow the DMA alignment requirements of the
+ *  driver, usually be aligned on entire cache lines.
+ *  \param buffer_size Size of the sector buffer
+ *  \return 1 if success.
+ */
+uint8_t media_spinor_init_at25(struct _media *media,
+		struct _media_spinor *nor, struct _at25 *at25,
+		uint32_t offset, uint32_t size,
+		void *buffer, uint32_t buffer_size)
+{
+	memset(nor, 0, sizeof(*nor));
+	nor->flash_read = _at25_read;
+	nor->flash_write = _at25_write;
+	nor->flash_erase = _at25_erase;
+	nor->flash = at25;
+
+	return _media_spinor_init(media, nor, at25->desc, offset, size,
+			buffer, buffer_size);
+}
+
+#ifdef CONFIG_HAVE_QSPI
+/**
+ *  \brief Initializes a media on an area of a configured QSPI flash. Reads
+ *  are performed through the memory-mapped window of the QSPI controller,
+ *  unless the AESB is used.
+ *  \param media Pointer to the Media instance to initialize
+ *  \param nor Pointer to the serial NOR media instance to use
+ *  \param flash Pointer to the configured QSPI flash instance
+ *  \param offset Offset of the area in the flash, aligned on erase sectors
+ *  \param size Size of the area in bytes, aligned on erase sectors
+ *  \param buffer Sector buffer, at least as large as the smallest erase
+ *  size of the device. It shall follow the DMA alignment requirements of the
+ *  driver, usually be aligned on entire cache lines.
+ *  \param buffer_size Size of the sector buffer
+ *  \return 1 if success.
+ */
+uint8_t media_spinor_init_qspiflash(struct _media *media,
+		struct _media_spinor *nor, struct _qspiflash *flash,
+		uint32_t offset, uint32_t size,
+		void *buffer, uint32_t buffer_size)
+{
+	memset(nor, 0, sizeof(*nor));
+	nor->flash_read = _qspiflash_read;
+	nor->flash_write = _qspiflash_write;
+	nor->flash_erase = _qspiflash_erase;
+	nor->flash = flash;
+
+#ifdef CONFIG_HAVE_AESB
+	if (!flash->use_aesb)
+#endif
+	{
+		if (qspiflash_read(flash, 0, NULL, 0))
+			nor->mapped = (uint8_t *)get_qspi_mem_from_addr(flash->qspi);
+	}
+
+	return _media_spinor_init(media, nor, &flash->desc, offset, size,
+			buffer, buffer_size);
+}
+#endif /* CONFIG_HAVE_QSPI */
+
+/**
+ *  \brief Retrieve the statistics of the media.
+ *  \param media Pointer to a serial NOR Media instance
+ *  \param stats Pointer to the structure to fill
+ */
+void media_spinor_get_stats(struct _media *media,
+		struct _media_spinor_stats *stats)
+{
+	struct _media_spinor *nor = (struct _media_spinor *)media->interface;
+
+	memcpy(stats, &nor->stats, sizeof(*stats));
+}
+
+/**
+ *  \brief Reset the statistics of the media.
+ *  \param media Pointer to a serial NOR Media instance
+ */
+void media_spinor_reset_stats(struct _media *media)
+{
+	struct _media_spinor *nor = (struct _media_spinor *)media->interface;
+
+	memset(&nor->stats, 0, sizeof(nor->stats));
+}
@@ -0,0 +1,121 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+  *  \file
+  *
+  *  Include Defines & macros for the media layer interface for serial NOR
+  *  flashes.
+  *
+  *  The serial NOR media exports an area of an AT25 or QSPI flash as a disk
+  *  of 512-byte blocks. Writes are merged in a buffer of one erase sector,
+  *  written back when another sector is written or upon media_flush(). A
+  *  sector is only erased when its new content sets bits which are cleared
+  *  in the flash, and only the pages which changed or are not blank are
+  *  programmed.
+  *
+  *  On QSPI flashes, blocks are read through the memory-mapped window of the
+  *  QSPI controller, and mapped reads are advertised to the media users (e.g.
+  *  the USB mass storage class driver) whenever no write is pending in the
+  *  sector buffer.
+  */
+
+#ifndef _MEDIA_SPINOR_H
+#define _MEDIA_SPINOR_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "media.h"
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Size of the media blocks */
+#define MEDIA_SPINOR_BLOCK_SIZE 512
+
+/*------------------------------------------------------------------------------
+ *      Types
+ *------------------------------------------------------------------------------*/
+
+struct _at25;
+struct _qspiflash;
+struct _media_spinor;
+
+/** Statistics */
+struct _media_spinor_stats {
+	uint32_t write_backs;    /**< Sectors written back */
+	uint32_t erases;         /**< Sectors erased */
+	uint32_t erases_skipped; /**< Sectors written back without erase */
+	uint32_t programs;       /**< Chunks of 256 bytes programmed */
+	uint32_t merged;         /**< Blocks written to an already dirty
+	                          * sector buffer */
+};
+
+/** Serial NOR media instance */
+struct _media_spinor {
+	/** Flash access methods, returning true on success */
+	bool (*flash_read)(struct _media_spinor *nor, uint32_t addr,
+			void *data, uint32_t length);
+	bool (*flash_write)(struct _media_spinor *nor, uint32_t addr,
+			const void *data, uint32_t length);
+	bool (*flash_erase)(struct _media_spinor *nor, uint32_t addr);
+
+	void *flash;             /**< AT25 or QSPI flash instance */
+	uint32_t offset;         /**< Offset of the area in the flash */
+	uint32_t sector_size;    /**< Erase size */
+	uint8_t *mapped;         /**< Memory-mapped area, NULL if none */
+	uint8_t *buffer;         /**< Sector buffer */
+	uint32_t buffer_sector;  /**< Sector held by the buffer */
+	bool dirty;              /**< Buffer to be written back */
+	struct _media_spinor_stats stats;
+};
+
+/*------------------------------------------------------------------------------
+ *      Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern uint8_t media_spinor_init_at25(struct _media *media,
+		struct _media_spinor *nor, struct _at25 *at25,
+		uint32_t offset, uint32_t size,
+		void *buffer, uint32_t buffer_size);
+
+extern uint8_t media_spinor_init_qspiflash(struct _media *media,
+		struct _media_spinor *nor, struct _qspiflash *flash,
+		uint32_t offset, uint32_t size,
+		void *buffer, uint32_t buffer_size);
+
+extern void media_spinor_get_stats(struct _media *media,
+		struct _media_spinor_stats *stats);
+
+extern void media_spinor_reset_stats(struct _media *media);
+
+#endif /* _MEDIA_SPINOR_H */
@@ -0,0 +1,623 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*---------------------------------------------------------------------------
+ *         Headers
+ *---------------------------------------------------------------------------*/
+
+#include "nand_ftl.h"
+
+#include "crc.h"
+
+#include <string.h>
+
+/*---------------------------------------------------------------------------
+ *         Local definitions
+ *---------------------------------------------------------------------------*/
+
+/** Block states */
+enum {
+	BLOCK_FREE,       /* only stale pages, erased before use */
+	BLOCK_USED,       /* holds pages, may be the open block */
+	BLOCK_RETIRING,   /* program failed, to be evacuated and retired */
+	BLOCK_BAD,
+};
+
+/** Result of a tag decoding */
+enum {
+	TAG_VALID,
+	TAG_ERASED,
+	TAG_INVALID,
+};
+
+/** Free blocks required before writing, one for the write and one for the
+ * relocations of garbage collection */
+#define MIN_FREE_BLOCKS     2
+
+/** Default number of free blocks kept by background garbage collection */
+#define DEFAULT_GC_THRESHOLD 4
+
+/** Default tolerated spread between the erase counters */
+#define DEFAULT_WL_THRESHOLD 128
+
+/*---------------------------------------------------------------------------
+ *         Local functions
+ *---------------------------------------------------------------------------*/
+
+static void _put_u32(uint8_t *buf, uint32_t value)
+{
+	buf[0] = value;
+	buf[1] = value >> 8;
+	buf[2] = value >> 16;
+	buf[3] = value >> 24;
+}
+
+static uint32_t _get_u32(const uint8_t *buf)
+{
+	return buf[0] | (buf[1] << 8) | (buf[2] << 16) |
+		((uint32_t)buf[3] << 24);
+}
+
+/**
+ * \brief Serialize a page tag. The tag is protected by a CRC as the spare
+ * bytes may not be covered by the ECC.
+ */
+static void _tag_encode(uint8_t *tag, uint32_t lpn, uint32_t seq,
+		uint32_t erase_count)
+{
+	uint16_t crc;
+
+	_put_u32(&tag[0], lpn);
+	_put_u32(&tag[4], seq);
+	_put_u32(&tag[8], erase_count);
+	crc = crc_compute(CRC_16_CCITT, tag, 12);
+	tag[12] = crc;
+	tag[13] = crc >> 8;
+}
+
+static uint8_t _tag_decode(const uint8_t *tag, uint32_t *lpn, uint32_t *seq,
+		uint32_t *erase_count)
+{
+	unsigned i;
+
+	for (i = 0; i < NAND_FTL_TAG_SIZE; i++)
+		if (tag[i] != 0xff)
+			break;
+	if (i == NAND_FTL_TAG_SIZE)
+		return TAG_ERASED;
+
+	if (crc_compute(CRC_16_CCITT, tag, 12) !=
+	    (uint32_t)(tag[12] | (tag[13] << 8)))
+		return TAG_INVALID;
+
+	*lpn = _get_u32(&tag[0]);
+	*seq = _get_u32(&tag[4]);
+	*erase_count = _get_u32(&tag[8]);
+	return TAG_VALID;
+}
+
+/**
+ * \brief Mark a block as bad and stop using it.
+ */
+static void _ftl_retire(struct _nand_ftl *ftl, uint32_t block)
+{
+	struct _nand_ftl_block *b = &ftl->blocks[block];
+
+	if (b->state == BLOCK_FREE)
+		ftl->free_blocks--;
+	if (b->state == BLOCK_RETIRING)
+		ftl->retiring--;
+	if (ftl->open == block)
+		ftl->open = NAND_FTL_NONE;
+	b->state = BLOCK_BAD;
+	ftl->good_blocks--;
+	ftl->stats.bad_blocks++;
+	ftl->ops->mark_bad(ftl->dev, block);
+}
+
+/**
+ * \brief Drop a physical page from the valid pages of its block. Blocks
+ * left without valid pages are freed, or retired if their programming
+ * failed.
+ */
+static void _ftl_invalidate(struct _nand_ftl *ftl, uint32_t ppn)
+{
+	uint32_t block = ppn / ftl->pages_per_block;
+	struct _nand_ftl_block *b = &ftl->blocks[block];
+
+	b->valid--;
+	if (b->valid || block == ftl->open)
+		return;
+	if (b->state == BLOCK_RETIRING) {
+		_ftl_retire(ftl, block);
+	} else if (b->state == BLOCK_USED) {
+		b->state = BLOCK_FREE;
+		ftl->free_blocks++;
+	}
+}
+
+/**
+ * \brief Open the free block with the lowest erase count, erasing it if
+ * needed.
+ */
+static bool _ftl_open_block(struct _nand_ftl *ftl)
+{
+	uint32_t i, block;
+
+	/* Close the previous block */
+	if (ftl->open != NAND_FTL_NONE) {
+		block = ftl->open;
+		ftl->open = NAND_FTL_NONE;
+		if (ftl->blocks[block].valid == 0 &&
+		    ftl->blocks[block].state == BLOCK_USED) {
+			ftl->blocks[block].state = BLOCK_FREE;
+			ftl->free_blocks++;
+		}
+	}
+
+	for (;;) {
+		struct _nand_ftl_block *b;
+
+		block = NAND_FTL_NONE;
+		for (i = 0; i < ftl->num_blocks; i++) {
+			b = &ftl->blocks[i];
+			if (b->state != BLOCK_FREE)
+				continue;
+			if (block == NAND_FTL_NONE ||
+			    b->erase_count < ftl->blocks[block].erase_count)
+				block = i;
+		}
+		if (block == NAND_FTL_NONE)
+			return false;
+
+		b = &ftl->blocks[block];
+		if (ftl->ops->erase(ftl->dev, block)) {
+			_ftl_retire(ftl, block);
+			continue;
+		}
+		b->erase_count++;
+		ftl->stats.erases++;
+
+		b->state = BLOCK_USED;
+		b->valid = 0;
+		ftl->free_blocks--;
+		ftl->open = block;
+		ftl->next_page = 0;
+		return true;
+	}
+}
+
+/**
+ * \brief Program a logical page in the open block and map it. A block
+ * whose programming fails is queued for retirement and the page is
+ * programmed elsewhere.
+ */
+static uint8_t _ftl_program(struct _nand_ftl *ftl, uint32_t lpn,
+		const void *data)
+{
+	uint8_t tag[NAND_FTL_TAG_SIZE];
+	uint32_t block, page, ppn;
+
+	for (;;) {
+		struct _nand_ftl_block *b;
+
+		if (ftl->open == NAND_FTL_NONE ||
+		    ftl->next_page == ftl->pages_per_block) {
+			if (!_ftl_open_block(ftl))
+				return NAND_FTL_ERROR_FULL;
+		}
+
+		block = ftl->open;
+		page = ftl->next_page++;
+		b = &ftl->blocks[block];
+		if (page == 0)
+			b->seq = ftl->seq;
+		_tag_encode(tag, lpn, ftl->seq++, b->erase_count);
+
+		ftl->stats.flash_writes++;
+		if (ftl->ops->write(ftl->dev, block, page, data, tag) == 0)
+			break;
+
+		/* Close the block, it will be evacuated and retired */
+		ftl->open = NAND_FTL_NONE;
+		if (b->valid) {
+			b->state = BLOCK_RETIRING;
+			ftl->retiring++;
+		} else {
+			_ftl_retire(ftl, block);
+		}
+	}
+
+	ppn = block * ftl->pages_per_block + page;
+	if (ftl->map[lpn] != NAND_FTL_NONE)
+		_ftl_invalidate(ftl, ftl->map[lpn]);
+	ftl->map[lpn] = ppn;
+	ftl->blocks[block].valid++;
+	return NAND_FTL_SUCCESS;
+}
+
+/**
+ * \brief Move the valid pages of a block to the open block.
+ * \param copies statistics counter of the pages moved
+ */
+static uint8_t _ftl_evacuate(struct _nand_ftl *ftl, uint32_t block,
+		uint32_t *copies)
+{
+	uint8_t tag[NAND_FTL_TAG_SIZE];
+	uint32_t page, lpn, seq, erase_count, ppn;
+	uint8_t status;
+
+	for (page = 0; page < ftl->pages_per_block; page++) {
+		if (ftl->blocks[block].valid == 0)
+			break;
+
+		ppn = block * ftl->pages_per_block + page;
+		if (ftl->ops->read_tag(ftl->dev, block, page, tag))
+			continue;
+		if (_tag_decode(tag, &lpn, &seq, &erase_count) != TAG_VALID)
+			continue;
+		if (lpn >= ftl->num_pages || ftl->map[lpn] != ppn)
+			continue;
+
+		if (ftl->ops->read_data(ftl->dev, block, page, ftl->page_buf)) {
+			ftl->stats.lost_pages++;
+			ftl->map[lpn] = NAND_FTL_NONE;
+			_ftl_invalidate(ftl, ppn);
+			continue;
+		}
+		status = _ftl_program(ftl, lpn, ftl->page_buf);
+		if (status != NAND_FTL_SUCCESS)
+			return status;
+		(*copies)++;
+	}
+	return NAND_FTL_SUCCESS;
+}
+
+/**
+ * \brief Evacuate and retire the blocks whose programming failed.
+ */
+static uint8_t _ftl_retire_pending(struct _nand_ftl *ftl)
+{
+	uint32_t block;
+	uint8_t status;
+
+	for (block = 0; ftl->retiring && block < ftl->num_blocks; block++) {
+		if (ftl->blocks[block].state != BLOCK_RETIRING)
+			continue;
+		status = _ftl_evacuate(ftl, block, &ftl->stats.gc_copies);
+		if (status != NAND_FTL_SUCCESS)
+			return status;
+		/* Evacuation retires the block once it is empty */
+		if (ftl->blocks[block].state == BLOCK_RETIRING)
+			_ftl_retire(ftl, block);
+	}
+	return NAND_FTL_SUCCESS;
+}
+
+/**
+ * \brief Select the used block with the fewest valid pages.
+ */
+static uint32_t _ftl_gc_victim(struct _nand_ftl *ftl)
+{
+	uint32_t i, victim = NAND_FTL_NONE;
+
+	for (i = 0; i < ftl->num_blocks; i++) {
+		const struct _nand_ftl_block *b = &ftl->blocks[i];
+		if (b->state != BLOCK_USED || i == ftl->open)
+			continue;
+		if (b->valid >= ftl->pages_per_block)
+			continue;
+		if (victim == NAND_FTL_NONE ||
+		    b->valid < ftl->blocks[victim].valid ||
+		    (b->valid == ftl->blocks[victim].valid &&
+		     b->erase_count < ftl->blocks[victim].erase_count))
+			victim = i;
+	}
+	return victim;
+}
+
+/**
+ * \brief Select the used block with the lowest erase count if the erase
+ * counts spread beyond the wear leveling threshold.
+ */
+static uint32_t _ftl_wl_victim(struct _nand_ftl *ftl)
+{
+	uint32_t i, victim = NAND_FTL_NONE, max = 0;
+
+	for (i = 0; i < ftl->num_blocks; i++) {
+		const struct _nand_ftl_block *b = &ftl->blocks[i];
+		if (b->state == BLOCK_BAD)
+			continue;
+		if (b->erase_count > max)
+			max = b->erase_count;
+		if (b->state != BLOCK_USED || i == ftl->open)
+			continue;
+		if (victim == NAND_FTL_NONE ||
+		    b->erase_count < ftl->blocks[victim].erase_count)
+			victim = i;
+	}
+	if (victim != NAND_FTL_NONE &&
+	    max - ftl->blocks[victim].erase_count <= ftl->wl_threshold)
+		victim = NAND_FTL_NONE;
+	return victim;
+}
+
+/**
+ * \brief Reclaim blocks until the specified number of blocks is free.
+ */
+static uint8_t _ftl_gc(struct _nand_ftl *ftl, uint32_t min_free)
+{
+	uint32_t victim, loops = ftl->num_blocks;
+	uint8_t status;
+
+	while (ftl->free_blocks < min_free && loops--) {
+		victim = _ftl_gc_victim(ftl);
+		if (victim == NAND_FTL_NONE)
+			break;
+		status = _ftl_evacuate(ftl, victim, &ftl->stats.gc_copies);
+		if (status != NAND_FTL_SUCCESS)
+			return status;
+	}
+	return NAND_FTL_SUCCESS;
+}
+
+/**
+ * \brief Relocate the coldest block if the erase counts diverge.
+ * \return true if a block was relocated
+ */
+static bool _ftl_wear_level(struct _nand_ftl *ftl)
+{
+	uint32_t victim;
+
+	ftl->wl_erases = ftl->stats.erases;
+	victim = _ftl_wl_victim(ftl);
+	if (victim == NAND_FTL_NONE)
+		return false;
+	return _ftl_evacuate(ftl, victim, &ftl->stats.wl_copies) ==
+		NAND_FTL_SUCCESS;
+}
+
+/**
+ * \brief Rebuild the map from the tags of a used block.
+ * \return the highest sequence number found
+ */
+static uint32_t _ftl_replay_block(struct _nand_ftl *ftl, uint32_t block)
+{
+	uint8_t tag[NAND_FTL_TAG_SIZE];
+	uint32_t page, lpn, seq, erase_count, max_seq = 0;
+
+	for (page = 0; page < ftl->pages_per_block; page++) {
+		if (ftl->ops->read_tag(ftl->dev, block, page, tag))
+			continue;
+		switch (_tag_decode(tag, &lpn, &seq, &erase_count)) {
+		case TAG_ERASED:
+			/* Pages are programmed in order */
+			return max_seq;
+		case TAG_VALID:
+			if (seq > max_seq)
+				max_seq = seq;
+			if (lpn >= ftl->num_pages)
+				break;
+			if (ftl->map[lpn] != NAND_FTL_NONE)
+				ftl->blocks[ftl->map[lpn] / ftl->pages_per_block].valid--;
+			ftl->map[lpn] = block * ftl->pages_per_block + page;
+			ftl->blocks[block].valid++;
+			break;
+		default:
+			/* Interrupted or failed programming */
+			break;
+		}
+	}
+	return max_seq;
+}
+
+/*---------------------------------------------------------------------------
+ *         Exported functions
+ *---------------------------------------------------------------------------*/
+
+uint8_t nand_ftl_mount(struct _nand_ftl *ftl,
+		const struct _nand_ftl_ops *ops, void *dev,
+		uint32_t num_blocks, uint32_t pages_per_block,
+		uint32_t page_size, uint32_t reserved_blocks,
+		uint32_t *map, struct _nand_ftl_block *blocks, void *page_buf)
+{
+	uint8_t tag[NAND_FTL_TAG_SIZE];
+	uint32_t i, page, lpn, seq, erase_count;
+	uint32_t known = 0, total = 0, last, max_seq = 0;
+
+	if (pages_per_block == 0 || pages_per_block > 0xffff ||
+	    page_size == 0 || reserved_blocks < NAND_FTL_MIN_RESERVED ||
+	    num_blocks <= reserved_blocks)
+		return NAND_FTL_ERROR_PARAM;
+
+	memset(ftl, 0, sizeof(*ftl));
+	ftl->ops = ops;
+	ftl->dev = dev;
+	ftl->num_blocks = num_blocks;
+	ftl->pages_per_block = pages_per_block;
+	ftl->page_size = page_size;
+	ftl->num_pages = NAND_FTL_NUM_PAGES(num_blocks, pages_per_block,
+			reserved_blocks);
+	ftl->map = map;
+	ftl->blocks = blocks;
+	ftl->page_buf = (uint8_t *)page_buf;
+	ftl->open = NAND_FTL_NONE;
+	ftl->gc_threshold = DEFAULT_GC_THRESHOLD;
+	if (ftl->gc_threshold > reserved_blocks - 1)
+		ftl->gc_threshold = reserved_blocks - 1;
+	ftl->wl_threshold = DEFAULT_WL_THRESHOLD;
+
+	for (i = 0; i < ftl->num_pages; i++)
+		map[i] = NAND_FTL_NONE;
+
+	/* Classify the blocks from the first readable tag: erased blocks, or
+	 * blocks whose erase was interrupted, are free */
+	for (i = 0; i < num_blocks; i++) {
+		struct _nand_ftl_block *b = &blocks[i];
+
+		memset(b, 0, sizeof(*b));
+		b->erase_count = NAND_FTL_NONE;
+		if (ops->is_bad(dev, i)) {
+			b->state = BLOCK_BAD;
+			continue;
+		}
+		ftl->good_blocks++;
+		b->state = BLOCK_FREE;
+		for (page = 0; page < pages_per_block; page++) {
+			uint8_t decoded = TAG_INVALID;
+			if (ops->read_tag(dev, i, page, tag) == 0)
+				decoded = _tag_decode(tag, &lpn, &seq, &erase_count);
+			if (decoded == TAG_ERASED)
+				break;
+			if (decoded == TAG_VALID) {
+				b->state = BLOCK_USED;
+				b->seq = seq;
+				b->erase_count = erase_count;
+				known++;
+				total += erase_count;
+				break;
+			}
+		}
+	}
+
+	/* Replay the used blocks in the order they were written */
+	last = 0;
+	for (;;) {
+		uint32_t block = NAND_FTL_NONE;
+
+		for (i = 0; i < num_blocks; i++) {
+			if (blocks[i].state != BLOCK_USED || blocks[i].seq <= last)
+				continue;
+			if (block == NAND_FTL_NONE || blocks[i].seq < blocks[block].seq)
+				block = i;
+		}
+		if (block == NAND_FTL_NONE)
+			break;
+		last = blocks[block].seq;
+		seq = _ftl_replay_block(ftl, block);
+		if (seq > max_seq)
+			max_seq = seq;
+	}
+	ftl->seq = max_seq + 1;
+
+	/* Free the blocks without valid pages, give the blocks without erase
+	 * counter the average one */
+	for (i = 0; i < num_blocks; i++) {
+		struct _nand_ftl_block *b = &blocks[i];
+
+		if (b->state == BLOCK_BAD)
+			continue;
+		if (b->state == BLOCK_USED && b->valid == 0)
+			b->state = BLOCK_FREE;
+		if (b->state == BLOCK_FREE)
+			ftl->free_blocks++;
+		if (b->erase_count == NAND_FTL_NONE)
+			b->erase_count = known ? total / known : 0;
+	}
+	ftl->wl_erases = 0;
+
+	if (ftl->good_blocks < num_blocks - reserved_blocks + MIN_FREE_BLOCKS)
+		return NAND_FTL_ERROR_FULL;
+	return NAND_FTL_SUCCESS;
+}
+
+uint8_t nand_ftl_read(struct _nand_ftl *ftl, uint32_t page, void *data)
+{
+	uint32_t ppn;
+
+	if (page >= ftl->num_pages)
+		return NAND_FTL_ERROR_RANGE;
+
+	ppn = ftl->map[page];
+	if (ppn == NAND_FTL_NONE) {
+		memset(data, 0xff, ftl->page_size);
+		return NAND_FTL_SUCCESS;
+	}
+
+	if (ftl->ops->read_data(ftl->dev, ppn / ftl->pages_per_block,
+				ppn % ftl->pages_per_block, data))
+		return NAND_FTL_ERROR_IO;
+	return NAND_FTL_SUCCESS;
+}
+
+uint8_t nand_ftl_write(struct _nand_ftl *ftl, uint32_t page,
+		const void *data)
+{
+	uint8_t status;
+
+	if (page >= ftl->num_pages)
+		return NAND_FTL_ERROR_RANGE;
+
+	status = _ftl_retire_pending(ftl);
+	if (status != NAND_FTL_SUCCESS)
+		return status;
+
+	/* Foreground garbage collection and wear leveling */
+	status = _ftl_gc(ftl, MIN_FREE_BLOCKS);
+	if (status != NAND_FTL_SUCCESS)
+		return status;
+	if (ftl->stats.erases - ftl->wl_erases >= ftl->wl_threshold)
+		_ftl_wear_level(ftl);
+
+	status = _ftl_program(ftl, page, data);
+	if (status == NAND_FTL_SUCCESS)
+		ftl->stats.host_writes++;
+	return status;
+}
+
+bool nand_ftl_collect(struct _nand_ftl *ftl)
+{
+	uint32_t victim;
+
+	if (ftl->retiring)
+		return _ftl_retire_pending(ftl) == NAND_FTL_SUCCESS;
+
+	if (ftl->free_blocks < ftl->gc_threshold) {
+		victim = _ftl_gc_victim(ftl);
+		if (victim != NAND_FTL_NONE)
+			return _ftl_evacuate(ftl, victim,
+					&ftl->stats.gc_copies) == NAND_FTL_SUCCESS;
+	}
+
+	return _ftl_wear_level(ftl);
+}
+
+void nand_ftl_get_stats(const struct _nand_ftl *ftl,
+		struct _nand_ftl_stats *stats)
+{
+	memcpy(stats, &ftl->stats, sizeof(*stats));
+}
+
+void nand_ftl_reset_stats(struct _nand_ftl *ftl)
+{
+	memset(&ftl->stats, 0, sizeof(ftl->stats));
+	ftl->wl_erases = 0;
+}
@@ -0,0 +1,214 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+  *  \file
+  *
+  *  Log-structured NAND flash translation layer.
+  *
+  *  Logical pages are written sequentially in the free pages of an open
+  *  block and the page-level logical-to-physical map is kept in RAM. Each
+  *  page carries a tag, stored by the driver in the spare area, holding the
+  *  logical page number, a sequence number and the erase counter of its
+  *  block. The map, the valid page counts and the erase counters are rebuilt
+  *  by scanning the tags when mounting, the most recent copy of a logical
+  *  page winning: an interrupted write or erase leaves the previous copy of
+  *  the data mapped.
+  *
+  *  Blocks only holding stale pages are reclaimed by garbage collection,
+  *  either when the free blocks run short during a write or in the
+  *  background through nand_ftl_collect(). Free blocks are allocated in
+  *  order of increasing erase count and, when the erase counts diverge,
+  *  the coldest blocks are relocated so that their blocks can be reused.
+  *
+  *  Erase or program failures retire the block as bad, its valid pages being
+  *  moved to another block first.
+  *
+  *  The FTL does not depend on the NAND driver: the flash is accessed
+  *  through a struct _nand_ftl_ops instance, which may as well simulate it.
+  */
+
+#ifndef _NAND_FTL_H
+#define _NAND_FTL_H
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Operation result codes */
+#define NAND_FTL_SUCCESS          0
+#define NAND_FTL_ERROR_IO         1  /**< Unrecoverable read error */
+#define NAND_FTL_ERROR_FULL       2  /**< Not enough good blocks left */
+#define NAND_FTL_ERROR_RANGE      3  /**< Logical page out of range */
+#define NAND_FTL_ERROR_PARAM      4  /**< Invalid geometry */
+
+/** Size of the serialized page tag */
+#define NAND_FTL_TAG_SIZE         14
+
+/** Invalid page or block number */
+#define NAND_FTL_NONE             0xffffffffu
+
+/** Number of logical pages, to size the map given to nand_ftl_mount() */
+#define NAND_FTL_NUM_PAGES(num_blocks, pages_per_block, reserved_blocks) \
+	(((num_blocks) - (reserved_blocks)) * (pages_per_block))
+
+/** Smallest number of reserved blocks */
+#define NAND_FTL_MIN_RESERVED     4
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Flash access methods. Block and page numbers are relative to the area
+ * managed by the FTL. Methods return 0 on success. */
+struct _nand_ftl_ops {
+	/** Read the data of a page, with ECC correction */
+	uint8_t (*read_data)(void *dev, uint32_t block, uint32_t page,
+			void *data);
+
+	/** Read the tag of a page, all bytes are 0xff on an erased page */
+	uint8_t (*read_tag)(void *dev, uint32_t block, uint32_t page,
+			uint8_t *tag);
+
+	/** Program the data and the tag of an erased page */
+	uint8_t (*write)(void *dev, uint32_t block, uint32_t page,
+			const void *data, const uint8_t *tag);
+
+	/** Erase a block */
+	uint8_t (*erase)(void *dev, uint32_t block);
+
+	/** Check the factory or runtime bad block marker */
+	bool (*is_bad)(void *dev, uint32_t block);
+
+	/** Mark a block as bad */
+	void (*mark_bad)(void *dev, uint32_t block);
+};
+
+/** Block state, private to the FTL */
+struct _nand_ftl_block {
+	uint32_t erase_count;    /**< Number of erase cycles */
+	uint32_t seq;            /**< Sequence number of the first page */
+	uint16_t valid;          /**< Number of mapped pages */
+	uint8_t state;           /**< Free, used, retiring or bad */
+	uint8_t reserved;
+};
+
+/** Statistics, in number of pages unless otherwise specified */
+struct _nand_ftl_stats {
+	uint32_t host_writes;    /**< Pages written by nand_ftl_write() */
+	uint32_t flash_writes;   /**< Pages programmed */
+	uint32_t gc_copies;      /**< Pages relocated by garbage collection */
+	uint32_t wl_copies;      /**< Pages relocated by wear leveling */
+	uint32_t erases;         /**< Blocks erased */
+	uint32_t bad_blocks;     /**< Blocks retired at runtime */
+	uint32_t lost_pages;     /**< Pages unreadable during relocation */
+};
+
+/** FTL instance */
+struct _nand_ftl {
+	const struct _nand_ftl_ops *ops;
+	void *dev;
+	uint32_t num_blocks;     /**< Physical blocks */
+	uint32_t pages_per_block;
+	uint32_t page_size;      /**< Page data size in bytes */
+	uint32_t num_pages;      /**< Logical pages */
+	uint32_t *map;           /**< Logical to physical page map */
+	struct _nand_ftl_block *blocks;
+	uint8_t *page_buf;       /**< Relocation buffer, one page */
+	uint32_t seq;            /**< Next sequence number */
+	uint32_t open;           /**< Block being written */
+	uint32_t next_page;      /**< Next free page of the open block */
+	uint32_t free_blocks;    /**< Free or erased good blocks */
+	uint32_t good_blocks;
+	uint32_t gc_threshold;   /**< Free blocks kept by background GC */
+	uint32_t wl_threshold;   /**< Tolerated erase count spread */
+	uint32_t wl_erases;      /**< Erase count at the last wear check */
+	uint32_t retiring;       /**< Blocks waiting to be retired */
+	struct _nand_ftl_stats stats;
+};
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Scan the flash and rebuild the FTL state.
+ * \param ftl FTL instance
+ * \param ops flash access methods
+ * \param dev argument of the access methods
+ * \param num_blocks number of blocks of the managed area
+ * \param pages_per_block number of pages per block
+ * \param page_size page data size in bytes
+ * \param reserved_blocks blocks not exported as logical pages, kept for
+ * garbage collection and bad block replacement; at least
+ * NAND_FTL_MIN_RESERVED. Must not change once the flash is in use.
+ * \param map logical to physical map, NAND_FTL_NUM_PAGES() entries
+ * \param blocks block states, num_blocks entries
+ * \param page_buf buffer of one page
+ * \return NAND_FTL_SUCCESS or an error code
+ */
+extern uint8_t nand_ftl_mount(struct _nand_ftl *ftl,
+		const struct _nand_ftl_ops *ops, void *dev,
+		uint32_t num_blocks, uint32_t pages_per_block,
+		uint32_t page_size, uint32_t reserved_blocks,
+		uint32_t *map, struct _nand_ftl_block *blocks, void *page_buf);
+
+/**
+ * \brief Read a logical page. Pages never written read as 0xff.
+ */
+extern uint8_t nand_ftl_read(struct _nand_ftl *ftl, uint32_t page,
+		void *data);
+
+/**
+ * \brief Write a logical page. The previous copy stays mapped until the
+ * new one is programmed.
+ */
+extern uint8_t nand_ftl_write(struct _nand_ftl *ftl, uint32_t page,
+		const void *data);
+
+/**
+ * \brief Perform one step of background garbage collection or wear
+ * leveling, to be called when the flash is idle.
+ * \return true if a block was reclaimed, false if there was nothing to do
+ */
+extern bool nand_ftl_collect(struct _nand_ftl *ftl);
+
+extern void nand_ftl_get_stats(const struct _nand_ftl *ftl,
+		struct _nand_ftl_stats *stats);
+
+extern void nand_ftl_reset_stats(struct _nand_ftl *ftl);
+
+#endif /* _NAND_FTL_H */
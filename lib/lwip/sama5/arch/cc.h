@@ -77,5 +77,12 @@ typedef u32_t mem_ptr_t;
     #error "This compiler does not support."
 #endif
 
+/* Optimized checksum routines (arch/chksum.c) */
+u16_t sama5_chksum(void *dataptr, u16_t len);
+u16_t sama5_chksum_copy(void *dst, const void *src, u16_t len);
+
+#define LWIP_CHKSUM sama5_chksum
+#define LWIP_CHKSUM_COPY(dst, src, len) sama5_chksum_copy(dst, src, len)
+
 #endif  /* _CC_H */
 
@@ -0,0 +1,189 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lwip/opt.h"
+#include "lwip/inet_chksum.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Add 32-bit words to a 64-bit accumulator.
+ * The carries out of bit 31 pile up in the upper half of the accumulator
+ * (the compiler emits an ADDS/ADC pair per word) and are folded back at
+ * the end, which gives the same result as a 16-bit one's complement sum.
+ */
+static uint64_t _sum_words(const uint32_t *src, uint32_t words, uint64_t acc)
+{
+	while (words >= 8) {
+		acc += src[0];
+		acc += src[1];
+		acc += src[2];
+		acc += src[3];
+		acc += src[4];
+		acc += src[5];
+		acc += src[6];
+		acc += src[7];
+		src += 8;
+		words -= 8;
+	}
+	while (words--)
+		acc += *src++;
+	return acc;
+}
+
+/**
+ * \brief Same as _sum_words() but also copy the words to dst.
+ */
+static uint64_t _copy_sum_words(uint32_t *dst, const uint32_t *src,
+		uint32_t words, uint64_t acc)
+{
+	while (words >= 8) {
+		uint32_t w0 = src[0], w1 = src[1], w2 = src[2], w3 = src[3];
+		uint32_t w4 = src[4], w5 = src[5], w6 = src[6], w7 = src[7];
+		dst[0] = w0; dst[1] = w1; dst[2] = w2; dst[3] = w3;
+		dst[4] = w4; dst[5] = w5; dst[6] = w6; dst[7] = w7;
+		acc += w0;
+		acc += w1;
+		acc += w2;
+		acc += w3;
+		acc += w4;
+		acc += w5;
+		acc += w6;
+		acc += w7;
+		src += 8;
+		dst += 8;
+		words -= 8;
+	}
+	while (words--) {
+		uint32_t w = *src++;
+		*dst++ = w;
+		acc += w;
+	}
+	return acc;
+}
+
+/**
+ * \brief Checksum a buffer, copying it to dst if dst is not NULL.
+ * dst and src must have the same alignment modulo 4.
+ */
+static u16_t _chksum(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	uint64_t acc = 0;
+	uint32_t sum, words;
+	u16_t t = 0;
+	int odd = (uint32_t)src & 1;
+
+	/* Align on 16 bits: the first byte is the upper half of its word in
+	 * memory order, the result is byte-swapped at the end */
+	if (odd && len > 0) {
+		((u8_t *)&t)[1] = *src;
+		if (dst)
+			*dst++ = *src;
+		src++;
+		len--;
+	}
+
+	/* Align on 32 bits */
+	if (((uint32_t)src & 2) && len >= 2) {
+		acc += *(const u16_t *)src;
+		if (dst) {
+			*(u16_t *)dst = *(const u16_t *)src;
+			dst += 2;
+		}
+		src += 2;
+		len -= 2;
+	}
+
+	words = len / 4;
+	if (dst) {
+		acc = _copy_sum_words((uint32_t *)dst, (const uint32_t *)src,
+				words, acc);
+		dst += words * 4;
+	} else {
+		acc = _sum_words((const uint32_t *)src, words, acc);
+	}
+	src += words * 4;
+	len -= words * 4;
+
+	/* Trailing half-word and byte */
+	if (len >= 2) {
+		acc += *(const u16_t *)src;
+		if (dst) {
+			*(u16_t *)dst = *(const u16_t *)src;
+			dst += 2;
+		}
+		src += 2;
+		len -= 2;
+	}
+	if (len) {
+		((u8_t *)&t)[0] = *src;
+		if (dst)
+			*dst = *src;
+	}
+	acc += t;
+
+	/* Fold 64 -> 32 -> 16 bits */
+	acc = (acc >> 32) + (acc & 0xffffffffu);
+	acc = (acc >> 32) + (acc & 0xffffffffu);
+	sum = (uint32_t)acc;
+	sum = (sum >> 16) + (sum & 0xffffu);
+	sum = (sum >> 16) + (sum & 0xffffu);
+
+	if (odd)
+		sum = ((sum & 0xffu) << 8) | ((sum & 0xff00u) >> 8);
+	return (u16_t)sum;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+u16_t sama5_chksum(void *dataptr, u16_t len)
+{
+	return _chksum(NULL, dataptr, len);
+}
+
+u16_t sama5_chksum_copy(void *dst, const void *src, u16_t len)
+{
+	if (((uint32_t)dst ^ (uint32_t)src) & 3) {
+		/* Alignments differ: no word copy possible */
+		memcpy(dst, src, len);
+		return _chksum(NULL, dst, len);
+	}
+	return _chksum(dst, src, len);
+}
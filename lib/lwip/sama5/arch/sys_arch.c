@@ -39,6 +39,22 @@
 
 #include "sys_arch.h"
 
+#include "lwip/tcp.h"
+#include "lwip/ip_frag.h"
+#include "lwip/dhcp.h"
+#include "netif/etharp.h"
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** lwIP timer called periodically without system */
+struct _sys_timer {
+	uint32_t interval;
+	uint32_t last;
+	void (*handler)(void);
+};
+
 /*----------------------------------------------------------------------------
  *        Variables
  *----------------------------------------------------------------------------*/
@@ -46,6 +62,24 @@
 /** clock tick count */
 static volatile uint32_t clock_tick;
 
+/** lwIP timers, intervals in ms */
+static struct _sys_timer sys_timers[] = {
+#if LWIP_TCP
+	{ TCP_FAST_INTERVAL, 0, tcp_fasttmr },
+	{ TCP_SLOW_INTERVAL, 0, tcp_slowtmr },
+#endif
+#if LWIP_ARP
+	{ ARP_TMR_INTERVAL, 0, etharp_tmr },
+#endif
+#if IP_REASSEMBLY
+	{ IP_TMR_INTERVAL, 0, ip_reass_tmr },
+#endif
+#if LWIP_DHCP
+	{ DHCP_COARSE_TIMER_MSECS, 0, dhcp_coarse_tmr },
+	{ DHCP_FINE_TIMER_MSECS, 0, dhcp_fine_tmr },
+#endif
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -94,3 +128,22 @@ unsigned int sys_get_ms(void)
 	return clock_tick;
 }
 
+/**
+ * Call the lwIP timers which expired since the previous call. The timers
+ * follow the TC0 tick started by sys_init_timing() but run in the caller
+ * context, lwIP being not reentrant with NO_SYS==1: call this function from
+ * the main loop, along with ethif_poll().
+ */
+void sys_timers_update(void)
+{
+	uint32_t now = clock_tick;
+	unsigned i;
+
+	for (i = 0; i < ARRAY_SIZE(sys_timers); i++) {
+		struct _sys_timer *timer = &sys_timers[i];
+		if ((now - timer->last) >= timer->interval) {
+			timer->last = now;
+			timer->handler();
+		}
+	}
+}
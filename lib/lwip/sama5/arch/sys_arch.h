@@ -39,5 +39,6 @@
 
 void sys_init_timing(void);
 u32_t sys_get_ms(void);
+void sys_timers_update(void);
 
 #endif
@@ -42,6 +42,7 @@
 #include "board.h"
 
 #include "compiler.h"
+#include "ring.h"
 
 #if defined(CONFIG_HAVE_EMAC)
 #include "peripherals/emacd.h"
@@ -58,6 +59,9 @@
 #include "lwip/pbuf.h"
 #include "lwip/sys.h"
 #include "lwip/stats.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/ip.h"
+#include "lwip/tcp.h"
 #include "netif/etharp.h"
 
 #include <string.h>
@@ -72,10 +76,42 @@
 #define IFNAME1 'n'
 
 /* Number of buffer for RX */
-#define RX_BUFFERS  16
+#define RX_BUFFERS  ETHIF_RX_BUFFERS
 
 /* Number of buffer for TX */
-#define TX_BUFFERS  8
+#define TX_BUFFERS  ETHIF_TX_BUFFERS
+
+#if ETHIF_ZERO_COPY
+#if defined(CONFIG_HAVE_EMAC)
+/* The EMAC receives in 128-byte units */
+#define RX_UNITSIZE ETH_RX_UNITSIZE
+#else
+/* The GMAC receives in units as large as a pool pbuf holds once its payload
+ * is aligned on a cache line: a frame fits in a single unit once
+ * PBUF_POOL_BUFSIZE >= ETH_MAX_FRAME_LENGTH + L1_CACHE_BYTES + ETH_PAD_SIZE */
+#define RX_UNITSIZE_FIT \
+	((PBUF_POOL_BUFSIZE - L1_CACHE_BYTES - ETH_PAD_SIZE) & ~63u)
+#if RX_UNITSIZE_FIT >= ETH_MAX_FRAME_LENGTH
+#define RX_UNITSIZE ETH_MAX_FRAME_LENGTH
+#else
+#define RX_UNITSIZE RX_UNITSIZE_FIT
+#endif
+#endif
+
+#if PBUF_POOL_SIZE < RX_BUFFERS + (ETH_MAX_FRAME_LENGTH + RX_UNITSIZE - 1) / RX_UNITSIZE
+#error ETHIF_ZERO_COPY: PBUF_POOL_SIZE cannot refill the RX ring after a full-size frame
+#endif
+#if RX_UNITSIZE < 64 || PBUF_POOL_BUFSIZE < (RX_UNITSIZE + L1_CACHE_BYTES + ETH_PAD_SIZE)
+#error ETHIF_ZERO_COPY: PBUF_POOL_BUFSIZE too small for an RX unit
+#endif
+
+/* Maximum number of buffers in a frame sent without copy */
+#define TX_MAX_SG   (TX_BUFFERS / 2)
+#endif
+
+#if ETHIF_CHECKSUM_OFFLOAD && defined(CONFIG_HAVE_EMAC)
+#error ETHIF_CHECKSUM_OFFLOAD requires the GMAC
+#endif
 
 #if defined(CONFIG_HAVE_EMAC)
 #   define ETH_PINS EMAC0_PINS
@@ -119,6 +155,21 @@ static struct _eth_desc gGTxDs[TX_BUFFERS];
 ALIGNED(8) SECTION(".region_ddr_nocache")
 static struct _eth_desc gGRxDs[RX_BUFFERS];
 
+#if ETHIF_ZERO_COPY
+/** pbufs attached to the RX descriptors */
+static struct pbuf *rx_pbufs[RX_BUFFERS];
+
+/** pbufs being transmitted, in transmission order */
+static struct pbuf *tx_pbufs[TX_BUFFERS];
+static uint16_t tx_pbufs_head;
+static uint16_t tx_pbufs_tail;
+
+/** Number of frames sent (updated from the TX interrupt) */
+static volatile uint32_t tx_frames_sent;
+
+/** Number of frames whose pbufs have been released */
+static uint32_t tx_frames_freed;
+#else
 /** TX Buffers */
 ALIGNED(32) SECTION(".region_ddr")
 static uint8_t pGTxBuffer[TX_BUFFERS * ETH_TX_UNITSIZE];
@@ -126,6 +177,7 @@ static uint8_t pGTxBuffer[TX_BUFFERS * ETH_TX_UNITSIZE];
 /** RX Buffers */
 ALIGNED(32) SECTION(".region_ddr")
 static uint8_t pGRxBuffer[RX_BUFFERS * ETH_RX_UNITSIZE];
+#endif
 
 /** TX callbacks list */
 static ethd_callback_t gGTxCbs[TX_BUFFERS];
@@ -138,6 +190,145 @@ static ethd_callback_t gGTxCbs[TX_BUFFERS];
 static void  ethif_input(struct netif *netif);
 static err_t ethif_output(struct netif *netif, struct pbuf *p, struct ip_addr *ipaddr);
 
+#if ETHIF_ZERO_COPY
+/**
+ * Allocate a pool pbuf to be used as RX DMA buffer. The payload is moved to
+ * the next cache line boundary (leaving room for the padding word) so that
+ * cache maintenance on the RX_UNITSIZE bytes received never touches the
+ * pbuf header or a neighbour pbuf.
+ */
+static struct pbuf *_ethif_rx_pbuf_alloc(void)
+{
+	struct pbuf *p;
+	uint32_t offset;
+
+	p = pbuf_alloc(PBUF_RAW, PBUF_POOL_BUFSIZE, PBUF_POOL);
+	if (p == NULL)
+		return NULL;
+
+	offset = (L1_CACHE_BYTES - (((uint32_t)p->payload + ETH_PAD_SIZE)
+			& (L1_CACHE_BYTES - 1))) & (L1_CACHE_BYTES - 1);
+	pbuf_header(p, -(s16_t)(offset + ETH_PAD_SIZE));
+	return p;
+}
+
+/**
+ * TX callback, invoked from interrupt once per frame sent
+ */
+static void _ethif_tx_done(uint8_t queue, uint32_t status)
+{
+	tx_frames_sent++;
+}
+
+/**
+ * Release the pbufs of the frames that have been sent
+ */
+static void _ethif_tx_reclaim(void)
+{
+	while (tx_frames_freed != tx_frames_sent) {
+		pbuf_free(tx_pbufs[tx_pbufs_tail]);
+		tx_pbufs[tx_pbufs_tail] = NULL;
+		RING_INC(tx_pbufs_tail, TX_BUFFERS);
+		tx_frames_freed++;
+	}
+}
+
+/**
+ * Get the length of the Ethernet, IP and TCP headers of a TCP frame. lwIP
+ * rewrites these headers in place when it retransmits a segment, possibly
+ * while the MAC still reads the previous transmission: they are sent from
+ * a copy, the payload that follows them is never modified.
+ *
+ * @param p the frame, starting with the destination address
+ * @return 0 if the frame is not TCP, the length of the headers otherwise,
+ *         larger than p->len if they do not all lie in the first pbuf
+ */
+static u16_t _ethif_tcp_headers_len(struct pbuf *p)
+{
+	const u8_t *frame = (const u8_t*)p->payload;
+	u16_t len = SIZEOF_ETH_HDR - ETH_PAD_SIZE;
+	u16_t type;
+
+	if (p->len < len)
+		return p->len + 1;
+	type = (frame[len - 2] << 8) | frame[len - 1];
+#if ETHARP_SUPPORT_VLAN
+	if (type == ETHTYPE_VLAN) {
+		len += SIZEOF_VLAN_HDR;
+		if (p->len < len)
+			return p->len + 1;
+		type = (frame[len - 2] << 8) | frame[len - 1];
+	}
+#endif
+	if (type != ETHTYPE_IP)
+		return 0;
+	if (p->len < len + IP_HLEN)
+		return p->len + 1;
+	if (frame[len + 9] != IP_PROTO_TCP)
+		return 0;
+	len += (frame[len] & 0x0f) * 4;
+	if (p->len < len + TCP_HLEN)
+		return p->len + 1;
+	len += (frame[len + 12] >> 4) * 4;
+	return len;
+}
+#endif
+
+#if ETHIF_CHECKSUM_OFFLOAD
+/**
+ * Verify the checksums the GMAC did not check on a received IP packet.
+ * Packets with a bad checksum have already been dropped by the GMAC, only
+ * the IP header of unrecognised packets and the TCP/UDP checksum of
+ * packets with IP options are left to software. The TCP/UDP checksums of
+ * fragmented datagrams are not verified.
+ *
+ * @param p the IP packet, starting with the IP header
+ * @param csum the checksums verified by the GMAC
+ * @return 1 if the packet can be passed to the stack, 0 otherwise
+ */
+static int _ethif_check_ip(struct pbuf *p, enum _eth_rx_csum csum)
+{
+	struct ip_hdr *iphdr = p->payload;
+	u16_t hlen, len;
+	u8_t proto;
+	int ok;
+
+	if (csum == ETH_RX_CSUM_IP_TCP || csum == ETH_RX_CSUM_IP_UDP)
+		return 1;
+
+	if (p->len < IP_HLEN)
+		return 0;
+	hlen = IPH_HL(iphdr) * 4;
+	len = ntohs(IPH_LEN(iphdr));
+	if (hlen < IP_HLEN || hlen > p->len || len < hlen || len > p->tot_len)
+		return 0;
+
+	if (csum == ETH_RX_CSUM_NONE && inet_chksum(iphdr, hlen) != 0)
+		return 0;
+
+	proto = IPH_PROTO(iphdr);
+	if (proto != IP_PROTO_TCP && proto != IP_PROTO_UDP)
+		return 1;
+	if (IPH_OFFSET(iphdr) & htons(IP_OFFMASK | IP_MF))
+		return 1;
+
+	/* Trim the Ethernet padding before summing the payload */
+	pbuf_realloc(p, len);
+	pbuf_header(p, -(s16_t)hlen);
+	if (proto == IP_PROTO_UDP && p->len >= 8 &&
+	    ((u16_t *)p->payload)[3] == 0) {
+		/* Null UDP checksum field: no checksum */
+		ok = 1;
+	} else {
+		ok = inet_chksum_pseudo(p, (struct ip_addr *)&iphdr->src,
+				(struct ip_addr *)&iphdr->dest,
+				proto, p->tot_len) == 0;
+	}
+	pbuf_header(p, (s16_t)hlen);
+	return ok;
+}
+#endif
+
 static void glow_level_init(struct netif *netif)
 {
     struct ethif *ethif = netif->state;
@@ -160,7 +351,28 @@ static void glow_level_init(struct netif *netif)
 	/* Init GMAC */
 	pio_configure(eth_pins, ARRAY_SIZE(eth_pins));
 	ethd_configure(&_ethd, ETH_TYPE, ETH_ADDR, 1, 0);
+#if ETHIF_CHECKSUM_OFFLOAD
+	if (ethd_set_offload(&_ethd, ETH_OFFLOAD_RX_CSUM | ETH_OFFLOAD_TX_CSUM) != ETH_OK)
+		printf("E: Checksum offload not supported\n\r");
+#endif
+#if ETHIF_ZERO_COPY
+	ethd_setup_queue(&_ethd, 0, RX_BUFFERS, NULL, gGRxDs, TX_BUFFERS, NULL, gGTxDs, gGTxCbs);
+	if (ethd_set_rx_unit_size(&_ethd, 0, RX_UNITSIZE) != ETH_OK)
+		printf("E: RX unit size %u not supported\n\r", RX_UNITSIZE);
+	{
+		int i;
+		for (i = 0; i < RX_BUFFERS; i++) {
+			rx_pbufs[i] = _ethif_rx_pbuf_alloc();
+			if (rx_pbufs[i] == NULL) {
+				printf("E: Not enough pbufs for RX ring\n\r");
+				break;
+			}
+			ethd_set_rx_buffer(&_ethd, 0, i, rx_pbufs[i]->payload);
+		}
+	}
+#else
 	ethd_setup_queue(&_ethd, 0, RX_BUFFERS, pGRxBuffer, gGRxDs, TX_BUFFERS, pGTxBuffer, gGTxDs, gGTxCbs);
+#endif
 	ethd_set_mac_addr(&_ethd, 0, Ethif_config.ethaddr.addr);
 	ethd_start(&_ethd);
 
@@ -183,6 +395,90 @@ static void glow_level_init(struct netif *netif)
  * @return ERR_OK if the packet could be sent
  *         an err_t value if the packet couldn't be sent
  */
+#if ETHIF_ZERO_COPY
+static err_t glow_level_output(struct netif *netif, struct pbuf *p)
+{
+	struct _eth_sg sg[TX_MAX_SG];
+	struct _eth_sg_list sgl;
+	struct pbuf *frame, *q;
+	u16_t hdr_len, skip;
+	uint8_t rc;
+
+	_ethif_tx_reclaim();
+
+#if ETH_PAD_SIZE
+	pbuf_header(p, -ETH_PAD_SIZE);    /* drop the padding word */
+#endif
+
+	/* Count the non-empty buffers of the chain, plus the copy of the
+	 * TCP headers */
+	hdr_len = _ethif_tcp_headers_len(p);
+	sgl.size = hdr_len ? 1 : 0;
+	for (q = p; q != NULL; q = q->next) {
+		if (q->len > (q == p ? hdr_len : 0))
+			sgl.size++;
+	}
+
+	if (sgl.size > TX_MAX_SG || hdr_len > p->len) {
+		/* Too fragmented, or TCP headers spread over several
+		 * buffers: merge the chain into a single buffer */
+		frame = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+		if (frame == NULL)
+			goto err_mem;
+		pbuf_copy(frame, p);
+		hdr_len = 0;
+	} else if (hdr_len) {
+		/* Copy of the headers, followed by the rest of the frame kept
+		 * until the end of transmission */
+		frame = pbuf_alloc(PBUF_RAW, hdr_len, PBUF_RAM);
+		if (frame == NULL)
+			goto err_mem;
+		memcpy(frame->payload, p->payload, hdr_len);
+		pbuf_chain(frame, p);
+	} else {
+		/* Keep the pbuf until the end of transmission */
+		frame = p;
+		pbuf_ref(frame);
+	}
+
+	sgl.size = 0;
+	sgl.entries = sg;
+	for (q = frame; q != NULL; q = q->next) {
+		/* Skip the headers sent from the copy */
+		skip = (hdr_len && q == p) ? hdr_len : 0;
+		if (q->len == skip)
+			continue;
+		sg[sgl.size].size = q->len - skip;
+		sg[sgl.size].buffer = (u8_t*)q->payload + skip;
+		sg[sgl.size].next = NULL;
+		if (sgl.size > 0)
+			sg[sgl.size - 1].next = &sg[sgl.size];
+		sgl.size++;
+	}
+
+	rc = ethd_send_sg(&_ethd, 0, &sgl, _ethif_tx_done);
+#if ETH_PAD_SIZE
+	pbuf_header(p, ETH_PAD_SIZE);     /* reclaim the padding word */
+#endif
+	if (rc != ETH_OK) {
+		pbuf_free(frame);
+		return ERR_BUF;
+	}
+	tx_pbufs[tx_pbufs_head] = frame;
+	RING_INC(tx_pbufs_head, TX_BUFFERS);
+
+	LINK_STATS_INC(link.xmit);
+	return ERR_OK;
+
+err_mem:
+#if ETH_PAD_SIZE
+	pbuf_header(p, ETH_PAD_SIZE);
+#endif
+	LINK_STATS_INC(link.memerr);
+	LINK_STATS_INC(link.drop);
+	return ERR_MEM;
+}
+#else
 static err_t glow_level_output(struct netif *netif, struct pbuf *p)
 {
     struct pbuf *q;
@@ -216,6 +512,7 @@ static err_t glow_level_output(struct netif *netif, struct pbuf *p)
     LINK_STATS_INC(link.xmit);
     return ERR_OK;
 }
+#endif
 
 /**
  * Should allocate a pbuf and transfer the bytes of the incoming
@@ -225,6 +522,60 @@ static err_t glow_level_output(struct netif *netif, struct pbuf *p)
  * @return a pbuf filled with the received packet (including MAC header)
  *         NULL on memory error
  */
+#if ETHIF_ZERO_COPY
+static struct pbuf *glow_level_input(struct netif *netif)
+{
+	struct pbuf *fresh[RX_BUFFERS];
+	struct pbuf *p = NULL, *q;
+	uint32_t frmlen;
+	uint16_t first, count, idx, i;
+	uint8_t rc;
+
+	rc = ethd_poll_frame(&_ethd, 0, &first, &count, &frmlen);
+	if (rc != ETH_OK)
+		return NULL;
+
+	/* Get replacement buffers first, the frame is dropped if the
+	 * ring cannot be refilled */
+	for (i = 0; i < count; i++) {
+		fresh[i] = _ethif_rx_pbuf_alloc();
+		if (fresh[i] == NULL)
+			break;
+	}
+	if (i < count) {
+		while (i > 0)
+			pbuf_free(fresh[--i]);
+		for (i = 0, idx = first; i < count; i++) {
+			ethd_set_rx_buffer(&_ethd, 0, idx, rx_pbufs[idx]->payload);
+			RING_INC(idx, RX_BUFFERS);
+		}
+		LINK_STATS_INC(link.memerr);
+		LINK_STATS_INC(link.drop);
+		return NULL;
+	}
+
+	/* Hand the filled buffers up as a pbuf chain and refill the ring */
+	for (i = 0, idx = first; i < count; i++) {
+		q = rx_pbufs[idx];
+		q->len = q->tot_len = min_u32(frmlen, RX_UNITSIZE);
+		frmlen -= q->len;
+		if (p == NULL)
+			p = q;
+		else
+			pbuf_cat(p, q);
+
+		rx_pbufs[idx] = fresh[i];
+		ethd_set_rx_buffer(&_ethd, 0, idx, fresh[i]->payload);
+		RING_INC(idx, RX_BUFFERS);
+	}
+
+#if ETH_PAD_SIZE
+	pbuf_header(p, ETH_PAD_SIZE);           /* reclaim the padding word */
+#endif
+	LINK_STATS_INC(link.recv);
+	return p;
+}
+#else
 static struct pbuf *glow_level_input(struct netif *netif)
 {
     struct pbuf *p, *q;
@@ -278,6 +629,7 @@ static struct pbuf *glow_level_input(struct netif *netif)
     }
     return p;
 }
+#endif
 
 /**
  * This function is called by the TCP/IP stack when an IP packet
@@ -306,12 +658,18 @@ static void ethif_input(struct netif *netif)
     struct ethif *ethif;
     struct eth_hdr *ethhdr;
     struct pbuf *p;
+#if ETHIF_CHECKSUM_OFFLOAD
+    enum _eth_rx_csum csum;
+#endif
     ethif = netif->state;
 
     /* move received packet into a new pbuf */
     p = glow_level_input(netif);
     /* no packet could be read, silently ignore this */
     if (p == NULL) return;
+#if ETHIF_CHECKSUM_OFFLOAD
+    csum = ethd_get_rx_csum(&_ethd, 0);
+#endif
     /* points to packet payload, which starts with an Ethernet header */
     ethhdr = p->payload;
 
@@ -320,6 +678,15 @@ static void ethif_input(struct netif *netif)
         case ETHTYPE_IP:
             /* skip Ethernet header */
             pbuf_header(p, -(s16_t)sizeof(struct eth_hdr));
+#if ETHIF_CHECKSUM_OFFLOAD
+            /* lwIP does not check the checksums itself */
+            if (!_ethif_check_ip(p, csum)) {
+                LINK_STATS_INC(link.chkerr);
+                LINK_STATS_INC(link.drop);
+                pbuf_free(p);
+                break;
+            }
+#endif
             /* pass to network layer */
             netif->input(p, netif);
             break;
@@ -388,6 +755,9 @@ err_t ethif_init(struct netif *netif)
  */
 void ethif_poll(struct netif *netif)
 {
+#if ETHIF_ZERO_COPY
+    _ethif_tx_reclaim();
+#endif
     ethif_input(netif);
 }
 
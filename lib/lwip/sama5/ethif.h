@@ -39,6 +39,37 @@
 #include "lwip/err.h"
 #include "netif/etharp.h"
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of RX buffer descriptors */
+#ifndef ETHIF_RX_BUFFERS
+#define ETHIF_RX_BUFFERS                16
+#endif
+
+/** Number of TX buffer descriptors */
+#ifndef ETHIF_TX_BUFFERS
+#define ETHIF_TX_BUFFERS                8
+#endif
+
+/**
+ * ETHIF_ZERO_COPY==1: RX descriptors point directly into PBUF_POOL pbufs
+ * which are handed up to the stack and replaced by fresh ones, TX
+ * descriptors point to the pbuf payloads which are referenced until the
+ * end of transmission. The headers of TCP frames are sent from a copy, as
+ * lwIP rewrites them in place on retransmission. The ring holds ETHIF_RX_BUFFERS pool pbufs at all
+ * times, PBUF_POOL_SIZE must leave enough on top to refill it after a
+ * full-size frame.
+ * The GMAC RX buffers are sized to the pool pbufs: with PBUF_POOL_BUFSIZE
+ * >= 1536 + L1_CACHE_BYTES + ETH_PAD_SIZE, each frame takes one descriptor
+ * and ETHIF_RX_BUFFERS is the number of frames the ring holds. The EMAC
+ * receives in 128-byte units, a full frame then takes 12 descriptors.
+ */
+#ifndef ETHIF_ZERO_COPY
+#define ETHIF_ZERO_COPY                 0
+#endif
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -42,6 +42,66 @@
  */
 #define NO_SYS                          1
 
+/*
+   -------------------------------------------
+   ---------- Configuration profile ----------
+   -------------------------------------------
+*/
+/**
+ * Two profiles are available. The default one keeps the footprint of the
+ * stack to a few KB, enough for the demonstrations but limited to some
+ * hundred KB/s on a TCP connection. The throughput profile, selected by
+ * CONFIG_LIB_LWIP_THROUGHPUT = y in the application Makefile, uses MTU-sized
+ * pool buffers, deep GMAC rings and large TCP windows. It is intended for
+ * DDR variants, the RAM it takes is:
+ * - PBUF_POOL: 48 pbufs of 1616 bytes in zero-copy mode (GMAC), 76KB; 40
+ *   pbufs plus a 12KB RX ring and 24KB of TX buffers in copy mode (EMAC),
+ *   99KB;
+ * - heap (MEM_SIZE): 31KB, holding the TCP send buffer;
+ * - TCP segments, PCBs and pbuf headers: about 4KB.
+ * That is about 111KB in zero-copy mode and 134KB in copy mode.
+ */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+
+/**
+ * ETHIF_ZERO_COPY: the GMAC receives straight into the pool pbufs, one
+ * frame per descriptor. The EMAC only has 128-byte receive units and keeps
+ * copying through its static ring.
+ */
+#ifndef ETHIF_ZERO_COPY
+#ifdef CONFIG_HAVE_EMAC
+#define ETHIF_ZERO_COPY                 0
+#else
+#define ETHIF_ZERO_COPY                 1
+#endif
+#endif
+
+/**
+ * ETHIF_RX_FRAMES: number of full-size frames the MAC can receive before
+ * ethif_poll() reads them. With the EMAC or in copy mode a 1536-byte frame
+ * spans 12 receive units of 128 bytes.
+ */
+#define ETHIF_RX_FRAMES                 8
+#if ETHIF_ZERO_COPY
+#ifdef CONFIG_HAVE_EMAC
+#error The throughput profile does not support ETHIF_ZERO_COPY with the EMAC
+#endif
+#define ETHIF_RX_BUFFERS                ETHIF_RX_FRAMES
+#else
+#define ETHIF_RX_BUFFERS                (ETHIF_RX_FRAMES * 12)
+#endif
+
+/** ETHIF_TX_BUFFERS: number of frames queued for transmission. */
+#define ETHIF_TX_BUFFERS                16
+
+#else
+
+/** Number of RX and TX buffer descriptors */
+#define ETHIF_RX_BUFFERS                16
+#define ETHIF_TX_BUFFERS                8
+
+#endif /* CONFIG_LIB_LWIP_THROUGHPUT */
+
 
 /*
    ------------------------------------
@@ -66,7 +126,11 @@
  * MEM_SIZE: the size of the heap memory. If the application will send
  * a lot of data that needs to be copied, this should be set high.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define MEM_SIZE                        (TCP_SND_BUF + 8 * 1024)
+#else
 #define MEM_SIZE                        1600
+#endif
 
 /**
  * MEMP_OVERFLOW_CHECK: memp overflow protection reserves a configurable
@@ -95,7 +159,11 @@
  * If the application sends a lot of data out of ROM (or other static memory),
  * this should be set high.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define MEMP_NUM_PBUF                   TCP_SND_QUEUELEN
+#else
 #define MEMP_NUM_PBUF                   4
+#endif
 
 /**
  * MEMP_NUM_RAW_PCB: Number of raw connection PCBs
@@ -108,13 +176,21 @@
  * per active UDP "connection".
  * (requires the LWIP_UDP option)
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define MEMP_NUM_UDP_PCB                4
+#else
 #define MEMP_NUM_UDP_PCB                1
+#endif
 
 /**
  * MEMP_NUM_TCP_PCB: the number of simulatenously active TCP connections.
  * (requires the LWIP_TCP option)
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define MEMP_NUM_TCP_PCB                4
+#else
 #define MEMP_NUM_TCP_PCB                2
+#endif
 
 /**
  * MEMP_NUM_TCP_PCB_LISTEN: the number of listening TCP connections.
@@ -125,8 +201,14 @@
 /**
  * MEMP_NUM_TCP_SEG: the number of simultaneously queued TCP segments.
  * (requires the LWIP_TCP option)
+ * The throughput profile covers a full send queue plus a full receive
+ * window of out-of-order segments.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define MEMP_NUM_TCP_SEG                (TCP_SND_QUEUELEN + TCP_WND / TCP_MSS)
+#else
 #define MEMP_NUM_TCP_SEG                5
+#endif
 
 /**
  * MEMP_NUM_SYS_TIMEOUT: the number of simulateously active timeouts.
@@ -147,11 +229,38 @@
 
 /**
  * PBUF_POOL_SIZE: the number of buffers in the pbuf pool.
- */
+ * The throughput profile holds a full receive window plus the frames the
+ * ring can deliver in one burst. In zero-copy mode the pbufs attached to
+ * the RX ring come on top: one per frame.
+ */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#if ETHIF_ZERO_COPY
+#define PBUF_POOL_SIZE                  (ETHIF_RX_BUFFERS + ETHIF_RX_FRAMES + TCP_WND / TCP_MSS)
+#else
+#define PBUF_POOL_SIZE                  (ETHIF_RX_FRAMES + TCP_WND / TCP_MSS)
+#endif
+#elif defined(ETHIF_ZERO_COPY) && ETHIF_ZERO_COPY
+/* The RX ring plus a full-size frame: 12 EMAC units of 128 bytes or 8
+ * GMAC units of 192 bytes */
+#ifdef CONFIG_HAVE_EMAC
+#define PBUF_POOL_SIZE                  (ETHIF_RX_BUFFERS + 12)
+#else
+#define PBUF_POOL_SIZE                  (ETHIF_RX_BUFFERS + 8)
+#endif
+#else
 #define PBUF_POOL_SIZE                  6
+#endif
 
-/* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
+/**
+ * PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool.
+ * The throughput profile fits a 1536-byte GMAC receive unit behind the
+ * padding word and a cache-aligned payload (1536 + 32 + 2, rounded up).
+ */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define PBUF_POOL_BUFSIZE               1600
+#else
 #define PBUF_POOL_BUFSIZE               256
+#endif
 
 /*
    ---------------------------------
@@ -166,7 +275,11 @@
 /**
  * ARP_TABLE_SIZE: Number of active MAC-IP address pairs cached.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define ARP_TABLE_SIZE                  4
+#else
 #define ARP_TABLE_SIZE                  2
+#endif
 
 /**
  * ARP_QUEUEING==1: Outgoing packets are queued during hardware address
@@ -284,7 +397,11 @@
 /**
  * LWIP_UDP==1: Turn on UDP.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define LWIP_UDP                        1
+#else
 #define LWIP_UDP                        0
+#endif
 
 /*
    ---------------------------------
@@ -300,8 +417,14 @@
 /**
  * TCP_WND: The size of a TCP window.  This must be at least
  * (2 * TCP_MSS) for things to work well
+ * This version of lwIP does not implement window scaling (RFC 1323), the
+ * window is limited to 0xffff.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define TCP_WND                         (32 * TCP_MSS)
+#else
 #define TCP_WND                         1024
+#endif
 
 /**
  * TCP_SYNMAXRTX: Maximum number of retransmissions of SYN segments.
@@ -312,7 +435,11 @@
  * TCP_QUEUE_OOSEQ==1: TCP will queue segments that arrive out of order.
  * Define to 0 if your device is low on memory.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define TCP_QUEUE_OOSEQ                 1
+#else
 #define TCP_QUEUE_OOSEQ                 0
+#endif
 
 /**
  * TCP_MSS: TCP Maximum segment size. (default is 536, a conservative default,
@@ -321,18 +448,30 @@
  * when opening a connection. For the transmit size, this MSS sets
  * an upper limit on the MSS advertised by the remote host.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define TCP_MSS                         1460
+#else
 #define TCP_MSS                         128
+#endif
 
 /**
  * TCP_SND_BUF: TCP sender buffer space (bytes).
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define TCP_SND_BUF                     (16 * TCP_MSS)
+#else
 #define TCP_SND_BUF                     1536
+#endif
 
 /**
  * TCP_SND_QUEUELEN: TCP sender buffer space (pbufs). This must be at least
  * as much as (2 * TCP_SND_BUF/TCP_MSS) for things to work.
  */
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+#define TCP_SND_QUEUELEN                (4 * TCP_SND_BUF / TCP_MSS)
+#else
 #define TCP_SND_QUEUELEN                2 * TCP_SND_BUF/TCP_MSS
+#endif
 
 /*
    ------------------------------------
@@ -366,6 +505,39 @@
 #define LWIP_SOCKET                     0
 
 
+/*
+   --------------------------------------
+   ---------- Checksum options ----------
+   --------------------------------------
+*/
+/**
+ * ETHIF_CHECKSUM_OFFLOAD==1: Let the GMAC generate the IP, TCP and UDP
+ * checksums of sent frames and check them on received frames. lwIP then
+ * skips its own checksum computations, ethif only verifies in software
+ * the few packets the GMAC could not check.
+ */
+#ifndef ETHIF_CHECKSUM_OFFLOAD
+#define ETHIF_CHECKSUM_OFFLOAD          0
+#endif
+
+#if ETHIF_CHECKSUM_OFFLOAD
+#define CHECKSUM_GEN_IP                 0
+#define CHECKSUM_GEN_UDP                0
+#define CHECKSUM_GEN_TCP                0
+#define CHECKSUM_CHECK_IP               0
+#define CHECKSUM_CHECK_UDP              0
+#define CHECKSUM_CHECK_TCP              0
+#endif
+
+/**
+ * LWIP_CHECKSUM_ON_COPY==1: Sum the TCP data while tcp_write() copies it,
+ * instead of reading it again when the segment is sent. Useless when the
+ * GMAC generates the checksums.
+ */
+#if !ETHIF_CHECKSUM_OFFLOAD
+#define LWIP_CHECKSUM_ON_COPY           1
+#endif
+
 /*
    ----------------------------------------
    ---------- Statistics options ----------
@@ -336,8 +336,8 @@ inet_chksum_pseudo(struct pbuf *p,
  * @param proto_len length of the ip data part (used for checksum of pseudo header)
  * @return checksum (as u16_t) to be saved directly in the protocol header
  */
-/* Currently only used by UDPLITE, although this could change in the future. */
-#if LWIP_UDPLITE
+/* Used by UDPLITE and by TCP when the data checksum has been computed on copy. */
+#if LWIP_UDPLITE || LWIP_CHECKSUM_ON_COPY
 u16_t
 inet_chksum_pseudo_partial(struct pbuf *p,
        struct ip_addr *src, struct ip_addr *dest,
@@ -388,7 +388,7 @@ inet_chksum_pseudo_partial(struct pbuf *p,
   LWIP_DEBUGF(INET_DEBUG, ("inet_chksum_pseudo(): pbuf chain lwip_chksum()=%"X32_F"\n", acc));
   return (u16_t)~(acc & 0xffffUL);
 }
-#endif /* LWIP_UDPLITE */
+#endif /* LWIP_UDPLITE || LWIP_CHECKSUM_ON_COPY */
 
 /* inet_chksum:
  *
@@ -436,3 +436,21 @@ inet_chksum_pbuf(struct pbuf *p)
   }
   return (u16_t)~(acc & 0xffffUL);
 }
+
+#if LWIP_CHECKSUM_ON_COPY && defined(LWIP_CHKSUM_COPY_ALGORITHM)
+/**
+ * Copy a buffer and calculate its checksum. Reference implementation
+ * used when the port does not provide LWIP_CHKSUM_COPY.
+ *
+ * @param dst destination buffer
+ * @param src source buffer
+ * @param len number of bytes to copy
+ * @return unfolded checksum of the data, as returned by LWIP_CHKSUM
+ */
+u16_t
+lwip_chksum_copy(void *dst, const void *src, u16_t len)
+{
+  MEMCPY(dst, src, len);
+  return LWIP_CHKSUM(dst, len);
+}
+#endif /* LWIP_CHECKSUM_ON_COPY && LWIP_CHKSUM_COPY_ALGORITHM */
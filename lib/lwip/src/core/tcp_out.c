@@ -162,6 +162,10 @@ tcp_enqueue(struct tcp_pcb *pcb, void *arg, u16_t len,
   void *ptr;
   u16_t queuelen;
   u8_t optlen;
+#if LWIP_CHECKSUM_ON_COPY
+  u16_t chksum = 0;
+  u8_t seg_flags;
+#endif /* LWIP_CHECKSUM_ON_COPY */
 
   LWIP_DEBUGF(TCP_OUTPUT_DEBUG, 
               ("tcp_enqueue(pcb=%p, arg=%p, len=%"U16_F", flags=%"X16_F", apiflags=%"U16_F")\n",
@@ -253,7 +257,11 @@ tcp_enqueue(struct tcp_pcb *pcb, void *arg, u16_t len,
                   (seg->p->len >= seglen + optlen));
       queuelen += pbuf_clen(seg->p);
       if (arg != NULL) {
+#if LWIP_CHECKSUM_ON_COPY
+        chksum = LWIP_CHKSUM_COPY((char *)seg->p->payload + optlen, ptr, seglen);
+#else /* LWIP_CHECKSUM_ON_COPY */
         MEMCPY((char *)seg->p->payload + optlen, ptr, seglen);
+#endif /* LWIP_CHECKSUM_ON_COPY */
       }
       seg->dataptr = seg->p->payload;
     }
@@ -317,6 +325,13 @@ tcp_enqueue(struct tcp_pcb *pcb, void *arg, u16_t len,
     /* don't fill in tcphdr->ackno and tcphdr->wnd until later */
 
     seg->flags = optflags;
+#if LWIP_CHECKSUM_ON_COPY
+    if ((apiflags & TCP_WRITE_FLAG_COPY) && (arg != NULL)) {
+      /* the data follows the header and options, both of even length */
+      seg->flags |= TF_SEG_DATA_CHECKSUMMED;
+      seg->chksum = chksum;
+    }
+#endif /* LWIP_CHECKSUM_ON_COPY */
 
     /* Set the length of the header */
     TCPH_HDRLEN_SET(seg->tcphdr, (5 + optlen / 4));
@@ -350,7 +365,8 @@ tcp_enqueue(struct tcp_pcb *pcb, void *arg, u16_t len,
     /* fit within max seg size */
     (useg->len + queue->len <= pcb->mss) &&
     /* only concatenate segments with the same options */
-    (useg->flags == queue->flags) &&
+    ((useg->flags & (TF_SEG_OPTS_MSS | TF_SEG_OPTS_TS)) ==
+     (queue->flags & (TF_SEG_OPTS_MSS | TF_SEG_OPTS_TS))) &&
     /* segments are consecutive */
     (ntohl(useg->tcphdr->seqno) + useg->len == ntohl(queue->tcphdr->seqno)) ) {
     /* Remove TCP header from first segment of our to-be-queued list */
@@ -374,6 +390,20 @@ tcp_enqueue(struct tcp_pcb *pcb, void *arg, u16_t len,
       TCPH_SET_FLAG(useg->tcphdr, TCP_FIN);
     } else {
       LWIP_ASSERT("zero-length pbuf", (queue->p != NULL) && (queue->p->len > 0));
+#if LWIP_CHECKSUM_ON_COPY
+      seg_flags = useg->flags & queue->flags;
+      if (seg_flags & TF_SEG_DATA_CHECKSUMMED) {
+        /* the new data starts at an odd offset if useg->len is odd */
+        u32_t acc = queue->chksum;
+        if (useg->len & 1) {
+          acc = ((acc & 0xff) << 8) | ((acc & 0xff00) >> 8);
+        }
+        acc += useg->chksum;
+        useg->chksum = (u16_t)((acc >> 16) + (acc & 0xffffUL));
+      }
+      useg->flags = (useg->flags & ~TF_SEG_DATA_CHECKSUMMED) |
+                    (seg_flags & TF_SEG_DATA_CHECKSUMMED);
+#endif /* LWIP_CHECKSUM_ON_COPY */
       pbuf_cat(useg->p, queue->p);
       useg->len += queue->len;
       useg->next = queue->next;
@@ -730,6 +760,20 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb)
 
   seg->tcphdr->chksum = 0;
 #if CHECKSUM_GEN_TCP
+#if LWIP_CHECKSUM_ON_COPY
+  if (seg->flags & TF_SEG_DATA_CHECKSUMMED) {
+    /* only sum the pseudo header and TCP header, then add the data checksum */
+    u32_t acc;
+    acc = (u16_t)~inet_chksum_pseudo_partial(seg->p,
+             &(pcb->local_ip),
+             &(pcb->remote_ip),
+             IP_PROTO_TCP, seg->p->tot_len, TCPH_HDRLEN(seg->tcphdr) * 4);
+    acc += seg->chksum;
+    acc = (acc >> 16) + (acc & 0xffffUL);
+    acc = (acc >> 16) + (acc & 0xffffUL);
+    seg->tcphdr->chksum = (u16_t)~acc;
+  } else
+#endif /* LWIP_CHECKSUM_ON_COPY */
   seg->tcphdr->chksum = inet_chksum_pseudo(seg->p,
              &(pcb->local_ip),
              &(pcb->remote_ip),
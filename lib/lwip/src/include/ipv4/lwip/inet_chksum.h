@@ -46,12 +46,22 @@ u16_t inet_chksum_pbuf(struct pbuf *p);
 u16_t inet_chksum_pseudo(struct pbuf *p,
        struct ip_addr *src, struct ip_addr *dest,
        u8_t proto, u16_t proto_len);
-#if LWIP_UDPLITE
+#if LWIP_UDPLITE || LWIP_CHECKSUM_ON_COPY
 u16_t inet_chksum_pseudo_partial(struct pbuf *p,
        struct ip_addr *src, struct ip_addr *dest,
        u8_t proto, u16_t proto_len, u16_t chksum_len);
 #endif
 
+#if LWIP_CHECKSUM_ON_COPY
+/** Copy len bytes from src to dst and return the (unfolded, not inverted)
+ * checksum of the data, like LWIP_CHKSUM would */
+#ifndef LWIP_CHKSUM_COPY
+#define LWIP_CHKSUM_COPY(dst, src, len) lwip_chksum_copy(dst, src, len)
+#define LWIP_CHKSUM_COPY_ALGORITHM 1
+u16_t lwip_chksum_copy(void *dst, const void *src, u16_t len);
+#endif
+#endif /* LWIP_CHECKSUM_ON_COPY */
+
 #ifdef __cplusplus
 }
 #endif
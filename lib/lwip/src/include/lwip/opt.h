@@ -1583,6 +1583,16 @@
 #define CHECKSUM_CHECK_TCP              1
 #endif
 
+/**
+ * LWIP_CHECKSUM_ON_COPY==1: Calculate the checksum of TCP data while copying
+ * it from the application buffer (tcp_write() with TCP_WRITE_FLAG_COPY), so
+ * that only the headers are summed when the segment is sent. The copy
+ * routine can be replaced by defining LWIP_CHKSUM_COPY in cc.h.
+ */
+#ifndef LWIP_CHECKSUM_ON_COPY
+#define LWIP_CHECKSUM_ON_COPY           0
+#endif
+
 /*
    ---------------------------------------
    ---------- Debugging options ----------
@@ -529,7 +529,11 @@ struct tcp_seg {
   u8_t  flags;
 #define TF_SEG_OPTS_MSS   (u8_t)0x01U   /* Include MSS option. */
 #define TF_SEG_OPTS_TS    (u8_t)0x02U   /* Include timestamp option. */
+#define TF_SEG_DATA_CHECKSUMMED (u8_t)0x04U /* chksum holds the checksum of the data */
   struct tcp_hdr *tcphdr;  /* the TCP header */
+#if LWIP_CHECKSUM_ON_COPY
+  u16_t chksum;            /* checksum of the data, if TF_SEG_DATA_CHECKSUMMED */
+#endif /* LWIP_CHECKSUM_ON_COPY */
 };
 
 #define LWIP_TCP_OPT_LENGTH(flags)              \
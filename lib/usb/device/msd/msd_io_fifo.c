@@ -36,8 +36,14 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include "intmath.h"
+#include "timer.h"
+
 #include "usb/device/msd/msd_io_fifo.h"
 
+#include <stdio.h>
+#include <string.h>
+
 /*------------------------------------------------------------------------------
  *         Internal variables
  *------------------------------------------------------------------------------*/
@@ -70,6 +76,109 @@ void msd_io_fifo_init(MSDIOFifo *p_fifo,
 
 	p_fifo->fullCnt = 0;
 	p_fifo->nullCnt = 0;
+
+	p_fifo->depth = MSDIO_DEFAULT_DEPTH;
+	msd_io_fifo_reset_stats(p_fifo);
+}
+
+/**
+ * \brief  Set the number of chunks the buffer of a MSDIOFifo is split into.
+ *
+ * A deeper FIFO lets the USB and media transfers overlap more but splits them
+ * in smaller chunks. Takes effect at the next READ/WRITE command.
+ * \param  fifo   Pointer to a MSDIOFifo instance
+ * \param  depth  Number of chunks, 1 to disable overlapping
+ */
+void msd_io_fifo_set_depth(MSDIOFifo *fifo, uint8_t depth)
+{
+	fifo->depth = depth ? depth : 1;
+}
+
+/**
+ * \brief  Prepare a MSDIOFifo for a READ/WRITE command.
+ *
+ * The chunk size is the buffer size divided by the depth, rounded down to a
+ * multiple of the block size.
+ * \param  fifo        Pointer to a MSDIOFifo instance
+ * \param  data_total  Size of the data of the command in bytes
+ * \param  block_size  Size of a block in bytes
+ */
+void msd_io_fifo_start(MSDIOFifo *fifo, uint32_t data_total,
+		uint16_t block_size)
+{
+	uint32_t chunk;
+
+	fifo->dataTotal = data_total;
+	fifo->blockSize = block_size;
+
+	chunk = fifo->bufferSize / fifo->depth;
+	chunk -= chunk % block_size;
+	fifo->chunkSize = max_u32(block_size, chunk);
+	fifo->ringSize = fifo->chunkSize *
+		max_u32(1, min_u32(fifo->depth, fifo->bufferSize / fifo->chunkSize));
+
+	fifo->fullCnt = 0;
+	fifo->nullCnt = 0;
+	fifo->startTick = timer_get_tick();
+
+	fifo->inputNdx = 0;
+	fifo->inputTotal = 0;
+	fifo->outputNdx = 0;
+	fifo->outputTotal = 0;
+}
+
+/**
+ * \brief  Account a completed READ/WRITE command in the statistics.
+ * \param  fifo       Pointer to a MSDIOFifo instance
+ * \param  direction  MSDIO_DIR_READ or MSDIO_DIR_WRITE
+ */
+void msd_io_fifo_end(MSDIOFifo *fifo, uint8_t direction)
+{
+	MSDIOStats *stats = &fifo->stats[direction];
+
+	stats->commands++;
+	stats->bytes += fifo->dataTotal;
+	stats->ticks += timer_get_interval(fifo->startTick, timer_get_tick());
+	stats->nullCnt += fifo->nullCnt;
+	stats->fullCnt += fifo->fullCnt;
+}
+
+/**
+ * \brief  Clear the statistics of a MSDIOFifo.
+ * \param  fifo  Pointer to a MSDIOFifo instance
+ */
+void msd_io_fifo_reset_stats(MSDIOFifo *fifo)
+{
+	memset(fifo->stats, 0, sizeof(fifo->stats));
+}
+
+/**
+ * \brief  Print the throughput of a MSDIOFifo on the console.
+ *
+ * Time is only accounted while READ/WRITE commands execute, so that the
+ * throughput reflects the data path and not the idle time of the host.
+ * \param  fifo  Pointer to a MSDIOFifo instance
+ */
+void msd_io_fifo_print_stats(const MSDIOFifo *fifo)
+{
+	static const char *names[2] = { "write", "read" };
+	uint32_t i, ms, kbytes;
+
+	for (i = 0; i < 2; i++) {
+		const MSDIOStats *stats = &fifo->stats[i];
+
+		ms = (uint32_t)(((uint64_t)stats->ticks *
+			timer_get_resolution()) / 1000);
+		kbytes = (uint32_t)(stats->bytes / 1024);
+		printf("%-5s: %u cmds, %u KB in %u ms", names[i],
+		       (unsigned)stats->commands, (unsigned)kbytes,
+		       (unsigned)ms);
+		if (ms)
+			printf(", %u KB/s", (unsigned)(
+			       ((uint64_t)kbytes * 1000) / ms));
+		printf(", fifo null %u full %u\r\n",
+		       (unsigned)stats->nullCnt, (unsigned)stats->fullCnt);
+	}
 }
 
 /**@}*/
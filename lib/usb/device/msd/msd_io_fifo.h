@@ -39,6 +39,8 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdint.h>
+
 /*------------------------------------------------------------------------------
  *         Definitions
  *------------------------------------------------------------------------------*/
@@ -63,17 +65,37 @@
 /** FIFO offset before USB transmit start */
 /*#define MSDIO_FIFO_OFFSET   (4*512) */
 
-
-/** FIFO trunk size (in each transfer, large amount of data) */
-#if !defined(MSD_OP_BUFFER)
-#define MSDIO_READ10_CHUNK_SIZE     (128 * 512)
-#define MSDIO_WRITE10_CHUNK_SIZE    (128 * 512)
+/** Default number of chunks the FIFO buffer is split into. With 2 chunks or
+ * more, the USB transfer of a chunk overlaps the media access of the
+ * previous one. */
+#ifndef MSDIO_DEFAULT_DEPTH
+#define MSDIO_DEFAULT_DEPTH 2
 #endif
 
+/** FIFO direction, as the flowDirection of the data monitor and index of
+ * MSDIOFifo::stats */
+#define MSDIO_DIR_WRITE     0
+#define MSDIO_DIR_READ      1
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
 
+/** \brief Streaming statistics of one direction of a MSDIOFifo */
+typedef struct _MSDIOStats {
+
+	/** Number of commands completed */
+	uint32_t        commands;
+	/** Number of bytes transferred */
+	uint64_t        bytes;
+	/** Time spent in the commands, in timer ticks */
+	uint32_t        ticks;
+	/** Times when fifo had no data to send */
+	uint32_t        nullCnt;
+	/** Times when fifo could not load more input data */
+	uint32_t        fullCnt;
+} MSDIOStats;
+
 /** \brief FIFO buffer for READ/WRITE (disk) operation of a mass storage device */
 typedef struct _MSDIOFifo {
 
@@ -98,11 +120,15 @@ typedef struct _MSDIOFifo {
 	unsigned int    dataTotal;
 	/** The size of the block in bytes */
 	unsigned short  blockSize;
-#if  defined(MSDIO_READ10_CHUNK_SIZE) || defined(MSDIO_WRITE10_CHUNK_SIZE)
+	/** Number of chunks the buffer is split into */
+	unsigned char   depth;
 	/** The size of one chunk */
 	/** (1 block, or several blocks for large amount data R/W) */
 	unsigned int    chunkSize;
-#endif
+	/** The size of the part of the buffer used by the chunks */
+	unsigned int    ringSize;
+	/** The media block address of the next chunk */
+	uint32_t        blockAddress;
 	/** State of input & output */
 	unsigned char   inputState;
 	unsigned char   outputState;
@@ -113,6 +139,10 @@ typedef struct _MSDIOFifo {
 	unsigned short  nullCnt;
 	/** Times when fifo can not load more input data */
 	unsigned short  fullCnt;
+	/** Tick at which the current command started */
+	uint32_t        startTick;
+	/** Statistics accumulated over the commands, per direction */
+	MSDIOStats      stats[2];
 } MSDIOFifo, *PMSDIOFifo;
 
 /*------------------------------------------------------------------------------
@@ -138,6 +168,17 @@ typedef struct _MSDIOFifo {
 extern void msd_io_fifo_init(MSDIOFifo *pFifo,
 						   void * pBuffer, unsigned int bufferSize);
 
+extern void msd_io_fifo_set_depth(MSDIOFifo *fifo, uint8_t depth);
+
+extern void msd_io_fifo_start(MSDIOFifo *fifo, uint32_t data_total,
+		uint16_t block_size);
+
+extern void msd_io_fifo_end(MSDIOFifo *fifo, uint8_t direction);
+
+extern void msd_io_fifo_reset_stats(MSDIOFifo *fifo);
+
+extern void msd_io_fifo_print_stats(const MSDIOFifo *fifo);
+
 /**@}*/
 
 #endif /* _MSDIOFIFO_H */
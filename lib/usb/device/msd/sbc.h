@@ -82,6 +82,12 @@
  * - SBC_MODE_SENSE_6
  * - SBC_VERIFY_10
  * - SBC_READ_FORMAT_CAPACITIES
+ *
+ * \section Optional Codes for higher throughput
+ * - SBC_READ_16
+ * - SBC_WRITE_16
+ * - SBC_SYNCHRONIZE_CACHE_10
+ * - SBC_SYNCHRONIZE_CACHE_16
  */
 
 /** Request information regarding parameters of the target and Logical Unit. */
@@ -106,6 +112,16 @@
 #define SBC_VERIFY_10                                   0x2F
 /** Request a list of the possible capacities that can be formatted on medium */
 #define SBC_READ_FORMAT_CAPACITIES                      0x23
+/** Request the transfer data to the host, with a 64-bit block address. */
+#define SBC_READ_16                                     0x88
+/** Request that the device write the data transferred by the host, with a
+ * 64-bit block address. */
+#define SBC_WRITE_16                                    0x8A
+/** Request that the device write its cached data to the medium. */
+#define SBC_SYNCHRONIZE_CACHE_10                        0x35
+/** Request that the device write its cached data to the medium, with a
+ * 64-bit block address. */
+#define SBC_SYNCHRONIZE_CACHE_16                        0x91
 /**      @}*/
 
 /** \addtogroup usbd_sbc_periph_quali SBC Periph. Qualifiers
@@ -436,6 +452,28 @@ typedef PACKED_STRUCT _SBCRead10 {
 
 } SBCRead10;
 
+/**
+ * \typedef SBCRead16
+ * \brief  Data structure for the READ (16) command
+ * \see    sbc3r07.pdf
+ */
+typedef PACKED_STRUCT _SBCRead16 {
+
+	uint8_t bOperationCode;          /*!< 0x88 : SBC_READ_16 */
+	uint8_t bDld2:1,                 /*!< Duration limit descriptor bit */
+				  isFUA_NV:1,              /*!< Cache control bit */
+				  bReserved1:1,            /*!< Reserved bit */
+				  isFUA:1,                 /*!< Cache control bit */
+				  isDPO:1,                 /*!< Cache control bit */
+				  bRdProtect:3;            /*!< Protection information to send */
+	uint8_t pLogicalBlockAddress[8]; /*!< Index of first block to read */
+	uint8_t pTransferLength[4];      /*!< Number of blocks to transmit */
+	uint8_t bGroupNumber:5,          /*!< Information grouping */
+				  bReserved2:3;            /*!< Reserved bits */
+	uint8_t bControl;                /*!< 0x00 */
+
+} SBCRead16;
+
 /**
  * \typedef SBCReadCapacity10
  * \brief  Structure for the READ CAPACITY (10) command
@@ -542,6 +580,28 @@ typedef PACKED_STRUCT _SBCWrite10 {
 
 } SBCWrite10;
 
+/**
+ * \typedef SBCWrite16
+ * \brief  Structure for the WRITE (16) command
+ * \see    sbc3r07.pdf
+ */
+typedef PACKED_STRUCT _SBCWrite16 {
+
+	uint8_t bOperationCode;          /*!< 0x8A : SBC_WRITE_16 */
+	uint8_t bDld2:1,                 /*!< Duration limit descriptor bit */
+				  isFUA_NV:1,              /*!< Cache control bit */
+				  bReserved1:1,            /*!< Reserved bit */
+				  isFUA:1,                 /*!< Cache control bit */
+				  isDPO:1,                 /*!< Cache control bit */
+				  bWrProtect:3;            /*!< Protection information to send */
+	uint8_t pLogicalBlockAddress[8]; /*!< First block to write */
+	uint8_t pTransferLength[4];      /*!< Number of blocks to write */
+	uint8_t bGroupNumber:5,          /*!< Information grouping */
+				  bReserved2:3;            /*!< Reserved bits */
+	uint8_t bControl;                /*!< 0x00 */
+
+} SBCWrite16;
+
 /**
  * \typedef SBCMediumRemoval
  * \brief  Structure for the PREVENT/ALLOW MEDIUM REMOVAL command
@@ -656,6 +716,8 @@ typedef PACKED_STRUCT _SBCReadWriteErrorRecovery {
  * \see    SBCRequestSense
  * \see    SBCTestUnitReady
  * \see    SBCWrite10
+ * \see    SBCRead16
+ * \see    SBCWrite16
  * \see    SBCMediumRemoval
  * \see    SBCModeSense6
  */
@@ -670,6 +732,8 @@ typedef PACKED_UNION _SBCCommand {
 	SBCWrite10        write10;        /*!< WRITE (10) command */
 	SBCMediumRemoval  mediumRemoval;  /*!< PREVENT/ALLOW MEDIUM REMOVAL command */
 	SBCModeSense6     modeSense6;     /*!< MODE SENSE (6) command */
+	SBCRead16         read16;         /*!< READ (16) command */
+	SBCWrite16        write16;        /*!< WRITE (16) command */
 
 } SBCCommand;
 
@@ -37,7 +37,6 @@
  *------------------------------------------------------------------------------*/
 
 #include "trace.h"
-#include "intmath.h"
 
 #include "libstoragemedia/media.h"
 
@@ -140,10 +139,38 @@ static bool sbc_lun_can_be_written(MSDLun *lun)
 }
 
 /**
- * \brief  Performs a WRITE (10) command on the specified LUN.
+ * \brief  Get the block range of a READ/WRITE (10) or (16) command.
+ * \param  command  Pointer to the command
+ * \param  lba      Pointer to store the first block address
+ * \param  blocks   Pointer to store the number of blocks
+ * \return false if the block address does not fit in 32 bits
+ */
+static bool sbc_get_block_range(SBCCommand *command, uint32_t *lba,
+		uint32_t *blocks)
+{
+	switch (command->bOperationCode) {
+	case SBC_READ_16:
+	case SBC_WRITE_16:
+		/* READ (16) and WRITE (16) have the same layout */
+		*lba = DWORDB((&command->read16.pLogicalBlockAddress[4]));
+		*blocks = DWORDB(command->read16.pTransferLength);
+		return DWORDB(command->read16.pLogicalBlockAddress) == 0;
+
+	default:
+		/* READ (10) and WRITE (10) have the same layout */
+		*lba = DWORDB(command->read10.pLogicalBlockAddress);
+		*blocks = WORDB(command->read10.pTransferLength);
+		return true;
+	}
+}
+
+/**
+ * \brief  Performs a WRITE (10) or WRITE (16) command on the specified LUN.
  *
- *         The data to write is first received from the USB host and then
- *         actually written on the media.
+ *         The data to write is received from the USB host into the chunks of
+ *         the LUN FIFO and written on the media chunk by chunk. With a FIFO
+ *         depth of 2 or more, the reception of a chunk overlaps the media
+ *         write of the previous one.
  *         This function operates asynchronously and must be called multiple
  *         times to complete. A result code of MSDDriver_STATUS_INCOMPLETE
  *         indicates that at least another call of the method is necessary.
@@ -153,15 +180,15 @@ static bool sbc_lun_can_be_written(MSDLun *lun)
  * \see    MSDLun
  * \see    MSDCommandState
  */
-static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
+static uint8_t sbc_write(MSDLun *lun, MSDCommandState *command_state)
 {
 	uint8_t status;
 	uint8_t result = MSDD_STATUS_INCOMPLETE;
-	SBCRead10 *command = (SBCRead10 *) command_state->cbw.pCommand;
+	SBCCommand *command = (SBCCommand *) command_state->cbw.pCommand;
 	MSDTransfer *transfer = &(command_state->transfer);
 	MSDTransfer *disktransfer = &(command_state->disktransfer);
 	MSDIOFifo *fifo = &lun->ioFifo;
-	uint32_t lba, old_chunk_size, new_chunk_size;
+	uint32_t blocks, old_chunk_size, new_chunk_size;
 
 	/* Init command state */
 	if (command_state->state == 0) {
@@ -171,36 +198,37 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 		if (!sbc_lun_can_be_written(lun)) {
 			return MSDD_STATUS_RW;
 		}
+		else if (!sbc_get_block_range(command, &fifo->blockAddress,
+					&blocks)) {
+			trace_warning("sbc_write: Block address out of range\n\r");
+			sbc_update_sense_data(lun->requestSenseData,
+					SBC_SENSE_KEY_ILLEGAL_REQUEST,
+					SBC_ASC_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE, 0);
+			return MSDD_STATUS_RW;
+		}
 		else {
 			/* Initialize FIFO */
-			fifo->dataTotal = command_state->length;
-			fifo->blockSize = lun->blockSize *
-				media_get_block_size(lun->media);
-#ifdef MSDIO_WRITE10_CHUNK_SIZE
-			fifo->chunkSize = max_u32(fifo->blockSize,
-						  MSDIO_WRITE10_CHUNK_SIZE);
-#endif
-			fifo->fullCnt = 0;
-			fifo->nullCnt = 0;
+			msd_io_fifo_start(fifo, command_state->length,
+					lun->blockSize *
+					media_get_block_size(lun->media));
 
 			/* Initialize FIFO output (Disk) */
-			fifo->outputNdx = 0;
-			fifo->outputTotal = 0;
 			fifo->outputState = MSDIO_IDLE;
 			transfer->semaphore = 0;
 
 			/* Initialize FIFO input (USB) */
-			fifo->inputNdx = 0;
-			fifo->inputTotal = 0;
 			fifo->inputState = MSDIO_START;
 			disktransfer->semaphore = 0;
 		}
 	}
 
 	if (command_state->length == 0) {
+		msd_io_fifo_end(fifo, MSDIO_DIR_WRITE);
+
 		/* Perform the callback! */
 		if (lun->dataMonitor) {
-			lun->dataMonitor(0, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
+			lun->dataMonitor(MSDIO_DIR_WRITE, fifo->dataTotal,
+					fifo->nullCnt, fifo->fullCnt);
 		}
 		return MSDD_STATUS_SUCCESS;
 	}
@@ -215,7 +243,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 	switch(fifo->inputState) {
 	case MSDIO_IDLE:
 		if (fifo->inputTotal < fifo->dataTotal &&
-				fifo->inputTotal - fifo->outputTotal < fifo->bufferSize) {
+				fifo->inputTotal - fifo->outputTotal < fifo->ringSize) {
 			fifo->inputState = MSDIO_START;
 		}
 		break;
@@ -228,36 +256,28 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 			break;
 		}
 
-		/* Read one block of data sent by the host */
+		/* Read one chunk of data sent by the host */
 		if (media_is_mapped_write_supported(lun->media)) {
 			uint32_t mappedAddr;
 			/* Validate the specified block range then write
 			 * directly to the memory area assigned to the device */
-			status = lun_access(lun,
-					DWORDB(command->pLogicalBlockAddress),
-					WORDB(command->pTransferLength), 1);
+			status = lun_access(lun, fifo->blockAddress,
+					fifo->dataTotal / fifo->blockSize, 1);
 			if (status != USBD_STATUS_SUCCESS)
 				msd_driver_callback(transfer,
 						MEDIA_STATUS_ERROR, 0, 0);
 			else {
 				mappedAddr = media_get_mapped_address(lun->media,
-						DWORDB(command->pLogicalBlockAddress)
-						* lun->blockSize);
+						fifo->blockAddress * lun->blockSize);
 				status = usbd_read(command_state->pipeOUT,
 						(void*)mappedAddr, fifo->dataTotal,
 						msd_driver_callback, transfer);
 			}
 		} else {
-			/* Read block to buffer */
-#ifdef MSDIO_WRITE10_CHUNK_SIZE
+			/* Read chunk to buffer */
 			status = usbd_read(command_state->pipeOUT,
 					&fifo->pBuffer[fifo->inputNdx], fifo->chunkSize,
 					msd_driver_callback, transfer);
-#else
-			status = usbd_read(command_state->pipeOUT,
-					&fifo->pBuffer[fifo->inputNdx], fifo->blockSize,
-					msd_driver_callback, transfer);
-#endif
 		}
 
 		/* Check operation result code */
@@ -300,15 +320,9 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 				fifo->inputState = MSDIO_IDLE;
 			} else {
 				/* Update input index */
-#ifdef MSDIO_WRITE10_CHUNK_SIZE
 				MSDIOFifo_IncNdx(fifo->inputNdx, fifo->chunkSize,
-						fifo->bufferSize);
+						fifo->ringSize);
 				fifo->inputTotal += fifo->chunkSize;
-#else
-				MSDIOFifo_IncNdx(fifo->inputNdx, fifo->blockSize,
-						fifo->bufferSize);
-				fifo->inputTotal += fifo->blockSize;
-#endif
 
 				/* Start Next block */
 
@@ -352,21 +366,15 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 		break;
 
 	case MSDIO_START:
-		/* Write the block to the media */
+		/* Write the chunk to the media */
 		if (media_is_mapped_write_supported(lun->media)) {
 			msd_driver_callback(disktransfer, MEDIA_STATUS_SUCCESS, 0, 0);
 			status = LUN_STATUS_SUCCESS;
 		} else {
-#ifdef MSDIO_WRITE10_CHUNK_SIZE
-			status = lun_write(lun, DWORDB(command->pLogicalBlockAddress),
+			status = lun_write(lun, fifo->blockAddress,
 					&fifo->pBuffer[fifo->outputNdx],
 					fifo->chunkSize / fifo->blockSize,
 					msd_driver_callback, disktransfer);
-#else
-			status = lun_write(lun, DWORDB(command->pLogicalBlockAddress),
-					&fifo->pBuffer[fifo->outputNdx], 1,
-					msd_driver_callback, disktransfer);
-#endif
 		}
 
 		/* Check operation result code */
@@ -398,7 +406,7 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 
 	case MSDIO_NEXT:
 		/* Check operation result code */
-		if (transfer->status != USBD_STATUS_SUCCESS) {
+		if (disktransfer->status != USBD_STATUS_SUCCESS) {
 			trace_warning("RBC_Write10: Failed to write\n\r");
 			sbc_update_sense_data(lun->requestSenseData,
 					SBC_SENSE_KEY_RECOVERED_ERROR,
@@ -416,19 +424,10 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 				fifo->outputState = MSDIO_IDLE;
 			} else {
 				/* Update output index */
-				lba = DWORDB(command->pLogicalBlockAddress);
-#ifdef MSDIO_WRITE10_CHUNK_SIZE
-				lba += fifo->chunkSize / fifo->blockSize;
+				fifo->blockAddress += fifo->chunkSize / fifo->blockSize;
 				MSDIOFifo_IncNdx(fifo->outputNdx, fifo->chunkSize,
-						fifo->bufferSize);
+						fifo->ringSize);
 				fifo->outputTotal += fifo->chunkSize;
-#else
-				lba++;
-				MSDIOFifo_IncNdx(fifo->outputNdx, fifo->blockSize,
-						fifo->bufferSize);
-				fifo->outputTotal += fifo->blockSize;
-#endif
-				STORE_DWORDB(lba, command->pLogicalBlockAddress);
 
 				/* Start Next block */
 
@@ -457,13 +456,18 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
 		break;
 	}
 
+	fifo->chunkSize = old_chunk_size;
+
 	return result;
 }
 
 /**
- * \brief  Performs a READ (10) command on specified LUN.
+ * \brief  Performs a READ (10) or READ (16) command on specified LUN.
  *
- *         The data is first read from the media and then sent to the USB host.
+ *         The data is read from the media into the chunks of the LUN FIFO and
+ *         sent to the USB host chunk by chunk. With a FIFO depth of 2 or more,
+ *         the media read of a chunk overlaps the transmission of the previous
+ *         one.
  *         This function operates asynchronously and must be called multiple
  *         times to complete. A result code of MSDDriver_STATUS_INCOMPLETE
  *         indicates that at least another call of the method is necessary.
@@ -473,15 +477,15 @@ static uint8_t sbc_write10(MSDLun *lun, MSDCommandState *command_state)
  * \see    MSDLun
  * \see    MSDCommandState
  */
-static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
+static uint8_t sbc_read(MSDLun *lun, MSDCommandState *command_state)
 {
 	uint8_t status;
 	uint8_t result = MSDD_STATUS_INCOMPLETE;
-	SBCRead10 *command = (SBCRead10*)command_state->cbw.pCommand;
+	SBCCommand *command = (SBCCommand*)command_state->cbw.pCommand;
 	MSDTransfer *transfer = &(command_state->transfer);
 	MSDTransfer *disktransfer = &(command_state->disktransfer);
 	MSDIOFifo   *fifo = &lun->ioFifo;
-	uint32_t lba, old_chunk_size, new_chunk_size;
+	uint32_t blocks, old_chunk_size, new_chunk_size;
 
 	/* Init command state */
 	if (command_state->state == 0) {
@@ -490,18 +494,19 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 		if (!sbc_lun_is_ready(lun)) {
 			return MSDD_STATUS_RW;
 		}
+		else if (!sbc_get_block_range(command, &fifo->blockAddress,
+					&blocks)) {
+			trace_warning("sbc_read: Block address out of range\n\r");
+			sbc_update_sense_data(lun->requestSenseData,
+					SBC_SENSE_KEY_ILLEGAL_REQUEST,
+					SBC_ASC_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE, 0);
+			return MSDD_STATUS_RW;
+		}
 		else {
 			/* Initialize FIFO */
-
-			fifo->dataTotal = command_state->length;
-			fifo->blockSize = lun->blockSize *
-				media_get_block_size(lun->media);
-#ifdef MSDIO_READ10_CHUNK_SIZE
-			fifo->chunkSize = max_u32(fifo->blockSize,
-						  MSDIO_READ10_CHUNK_SIZE);
-#endif
-			fifo->fullCnt = 0;
-			fifo->nullCnt = 0;
+			msd_io_fifo_start(fifo, command_state->length,
+					lun->blockSize *
+					media_get_block_size(lun->media));
 
 #ifdef MSDIO_FIFO_OFFSET
 			/* Enable offset if total size >= 2*bufferSize */
@@ -512,14 +517,10 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 #endif
 
 			/* Initialize FIFO output (USB) */
-			fifo->outputNdx = 0;
-			fifo->outputTotal = 0;
 			fifo->outputState = MSDIO_IDLE;
 			transfer->semaphore = 0;
 
 			/* Initialize FIFO input (Disk) */
-			fifo->inputNdx = 0;
-			fifo->inputTotal = 0;
 			fifo->inputState = MSDIO_START;
 			disktransfer->semaphore = 0;
 		}
@@ -527,9 +528,12 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 
 	/* Check length */
 	if (command_state->length == 0) {
+		msd_io_fifo_end(fifo, MSDIO_DIR_READ);
+
 		/* Perform the callback! */
 		if (lun->dataMonitor) {
-			lun->dataMonitor(1, fifo->dataTotal, fifo->nullCnt, fifo->fullCnt);
+			lun->dataMonitor(MSDIO_DIR_READ, fifo->dataTotal,
+					fifo->nullCnt, fifo->fullCnt);
 		}
 		return MSDD_STATUS_SUCCESS;
 	}
@@ -544,34 +548,27 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 	switch(fifo->inputState) {
 	case MSDIO_IDLE:
 		if (fifo->inputTotal < fifo->dataTotal &&
-				fifo->inputTotal - fifo->outputTotal < fifo->bufferSize) {
+				fifo->inputTotal - fifo->outputTotal < fifo->ringSize) {
 			fifo->inputState = MSDIO_START;
 		}
 		break;
 
 	case MSDIO_START:
-		/* Read one block of data from the media */
+		/* Read one chunk of data from the media */
 		if (media_is_mapped_read_supported(lun->media)) {
 			/* Data are in memory already. We only need to validate
 			 * the block range. */
-			status = lun_access(lun,
-					DWORDB(command->pLogicalBlockAddress),
-					WORDB(command->pTransferLength), 0);
+			status = lun_access(lun, fifo->blockAddress,
+					fifo->dataTotal / fifo->blockSize, 0);
 			msd_driver_callback(disktransfer,
 					status == USBD_STATUS_SUCCESS
 					? MEDIA_STATUS_SUCCESS
 					: MEDIA_STATUS_ERROR, 0, 0);
 		} else {
-#ifdef MSDIO_READ10_CHUNK_SIZE
-			status = lun_read(lun, DWORDB(command->pLogicalBlockAddress),
+			status = lun_read(lun, fifo->blockAddress,
 					&fifo->pBuffer[fifo->inputNdx],
 					fifo->chunkSize / fifo->blockSize,
 					msd_driver_callback, disktransfer);
-#else
-			status = lun_read(lun, DWORDB(command->pLogicalBlockAddress),
-					&fifo->pBuffer[fifo->inputNdx], 1,
-					msd_driver_callback, disktransfer);
-#endif
 		}
 
 		/* Check operation result code */
@@ -620,19 +617,10 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 				fifo->inputTotal = fifo->dataTotal;
 			} else {
 				/* Update block address, and input index */
-				lba = DWORDB(command->pLogicalBlockAddress);
-#ifdef MSDIO_READ10_CHUNK_SIZE
-				lba += fifo->chunkSize / fifo->blockSize;
+				fifo->blockAddress += fifo->chunkSize / fifo->blockSize;
 				MSDIOFifo_IncNdx(fifo->inputNdx, fifo->chunkSize,
-						fifo->bufferSize);
+						fifo->ringSize);
 				fifo->inputTotal += fifo->chunkSize;
-#else
-				lba++;
-				MSDIOFifo_IncNdx(fifo->inputNdx, fifo->blockSize,
-						fifo->bufferSize);
-				fifo->inputTotal += fifo->blockSize;
-#endif
-				STORE_DWORDB(lba, command->pLogicalBlockAddress);
 
 				/* Start Next block */
 
@@ -691,23 +679,17 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 			break;
 		}
 
-		/* Send the block to the host */
+		/* Send the chunk to the host */
 		if (media_is_mapped_read_supported(lun->media)) {
 			uint32_t mappedAddr = media_get_mapped_address(lun->media,
-					DWORDB(command->pLogicalBlockAddress) * lun->blockSize);
+					fifo->blockAddress * lun->blockSize);
 			status = usbd_write(command_state->pipeIN,
 					(void*)mappedAddr, command_state->length,
 					msd_driver_callback, transfer);
 		} else {
-#ifdef MSDIO_READ10_CHUNK_SIZE
 			status = usbd_write(command_state->pipeIN,
 					&fifo->pBuffer[fifo->outputNdx], fifo->chunkSize,
 					msd_driver_callback, transfer);
-#else
-			status = usbd_write(command_state->pipeIN,
-					&fifo->pBuffer[fifo->outputNdx], fifo->blockSize,
-					msd_driver_callback, transfer);
-#endif
 		}
 
 		/* Check operation result code */
@@ -747,15 +729,9 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 				command_state->length = 0;
 			} else {
 				/* Update output index */
-#ifdef MSDIO_READ10_CHUNK_SIZE
 				MSDIOFifo_IncNdx(fifo->outputNdx, fifo->chunkSize,
-						fifo->bufferSize);
+						fifo->ringSize);
 				fifo->outputTotal += fifo->chunkSize;
-#else
-				MSDIOFifo_IncNdx(fifo->outputNdx, fifo->blockSize,
-						fifo->bufferSize);
-				fifo->outputTotal += fifo->blockSize;
-#endif
 
 				/* Start Next block */
 
@@ -784,6 +760,8 @@ static uint8_t sbc_read10(MSDLun *lun, MSDCommandState *command_state)
 		break;
 	}
 
+	fifo->chunkSize = old_chunk_size;
+
 	return result;
 }
 
@@ -1140,6 +1118,20 @@ void sbc_update_sense_data(SBCRequestSenseData *request_sense_data,
 		additional_sense_code_qualifier;
 }
 
+/**
+ * \brief  Convert a number of blocks to a transfer length in bytes, saturated
+ *         to 32 bits.
+ * \param  blocks  Number of blocks
+ * \param  lun     Pointer to the LUN affected by the command
+ */
+static uint32_t sbc_get_transfer_length(uint32_t blocks, MSDLun *lun)
+{
+	uint64_t length = (uint64_t)blocks * lun->blockSize *
+		media_get_block_size(lun->media);
+
+	return length > UINT32_MAX ? UINT32_MAX : (uint32_t)length;
+}
+
 /**
  * \brief  Return information about the transfer length and direction expected
  *         by the device for a particular command.
@@ -1200,7 +1192,21 @@ bool sbc_get_command_information(void *command_ptr, uint32_t *length,
 			lun->blockSize * media_get_block_size(lun->media);
 		break;
 
+	case SBC_READ_16:
+		(*type) = MSDD_DEVICE_TO_HOST;
+		(*length) = sbc_get_transfer_length(
+				DWORDB(command->read16.pTransferLength), lun);
+		break;
+
+	case SBC_WRITE_16:
+		(*type) = MSDD_HOST_TO_DEVICE;
+		(*length) = sbc_get_transfer_length(
+				DWORDB(command->write16.pTransferLength), lun);
+		break;
+
 	case SBC_VERIFY_10:
+	case SBC_SYNCHRONIZE_CACHE_10:
+	case SBC_SYNCHRONIZE_CACHE_16:
 		(*type) = MSDD_NO_TRANSFER;
 		break;
 
@@ -1231,13 +1237,15 @@ uint8_t sbc_process_command(MSDLun *lun, MSDCommandState *command_state)
 
 	switch (command->bOperationCode) {
 	case SBC_READ_10:
-		/* Perform the Read10 command */
-		result = sbc_read10(lun, command_state);
+	case SBC_READ_16:
+		/* Perform the Read10/Read16 command */
+		result = sbc_read(lun, command_state);
 		break;
 
 	case SBC_WRITE_10:
-		/* Perform the Write10 command */
-		result = sbc_write10(lun, command_state);
+	case SBC_WRITE_16:
+		/* Perform the Write10/Write16 command */
+		result = sbc_write(lun, command_state);
 		break;
 
 	case SBC_READ_CAPACITY_10:
@@ -1246,6 +1254,8 @@ uint8_t sbc_process_command(MSDLun *lun, MSDCommandState *command_state)
 		break;
 
 	case SBC_VERIFY_10:
+	case SBC_SYNCHRONIZE_CACHE_10:
+	case SBC_SYNCHRONIZE_CACHE_16:
 		/* Flush media */
 		media_flush(lun->media);
 		result = MSDD_STATUS_SUCCESS;
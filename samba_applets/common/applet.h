@@ -30,6 +30,7 @@
 #ifndef _APPLET_H_
 #define _APPLET_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
@@ -43,6 +44,10 @@
 #define APPLET_CMD_WRITE_PAGES       0x33 /* Write pages */
 #define APPLET_CMD_READ_BOOTCFG      0x34 /* Read Boot Config */
 #define APPLET_CMD_WRITE_BOOTCFG     0x35 /* Write Boot Config */
+#define APPLET_CMD_WRITE_BUFFER      0x36 /* Write pages from one of the buffers */
+#define APPLET_CMD_BUFFER_STATUS     0x37 /* Buffers layout and status */
+#define APPLET_CMD_WRITE_IMAGE       0x38 /* Write sparse/compressed records */
+#define APPLET_CMD_VERIFY            0x39 /* Checksum of a page range */
 
 #define APPLET_SUCCESS               0x00 /* Operation was successful */
 #define APPLET_DEV_UNKNOWN           0x01 /* Device unknown */
@@ -56,6 +61,30 @@
 #define APPLET_BAD_BLOCK             0x09 /* Read / write found bad block */
 #define APPLET_PMECC_CONFIG          0x0A /* ECC configure failure */
 #define APPLET_FAIL                  0x0F /* Generic/Unknown failure */
+#define APPLET_BUSY                  0x10 /* Operation still in progress */
+
+/* Number of buffers of the buffered write mode */
+#define APPLET_BUFFER_COUNT          2
+
+/*
+ * Records of the 'write image' command. Each record starts with a
+ * little-endian header word: type in bits 31..28, number of pages in bits
+ * 27..0. Records are word-aligned.
+ */
+#define APPLET_IMAGE_RAW             0x0 /* Followed by the pages */
+#define APPLET_IMAGE_LZ4             0x1 /* Followed by the size of the LZ4
+                                          * block (word) and the block, padded
+                                          * to a word */
+#define APPLET_IMAGE_FILL            0x2 /* Followed by the 32-bit value
+                                          * filling the pages */
+#define APPLET_IMAGE_SKIP            0x3 /* Pages left untouched */
+
+#define APPLET_IMAGE_HEADER(type, pages) \
+	(((uint32_t)(type) << 28) | ((pages) & 0x0fffffff))
+
+/* Algorithms of the 'verify' command */
+#define APPLET_VERIFY_CRC32          0x0 /* CRC-32 (Ethernet, zip) */
+#define APPLET_VERIFY_SHA256         0x1 /* SHA-256, on devices with SHA */
 
 /* Communication link identification */
 #define COMM_TYPE_USB                0x00
@@ -117,8 +146,125 @@ union read_write_erase_pages_mailbox {
 	} out;
 };
 
+/**
+ * \brief Mailbox content for the 'write buffer' command.
+ *
+ * The applet buffer is split in APPLET_BUFFER_COUNT buffers: the host uploads
+ * the next data to a buffer while the write from the other one is finishing.
+ * The command returns once the data of the buffer has been sent to the
+ * memory, the end of the write is checked by the next command.
+ */
+union write_buffer_mailbox {
+	struct {
+		/** Index of the buffer holding the data */
+		uint32_t buffer;
+		/** Write offset (in pages) */
+		uint32_t offset;
+		/** Write length (in pages) */
+		uint32_t length;
+	} in;
+
+	struct {
+		/** Status of each buffer, APPLET_BUSY until its write is over */
+		uint32_t status[APPLET_BUFFER_COUNT];
+	} out;
+};
+
+/** Mailbox content for the 'buffer status' command. */
+union buffer_status_mailbox {
+	struct {
+		/** Non-zero to wait for the end of the write in progress */
+		uint32_t wait;
+	} in;
+
+	struct {
+		/** Number of buffers */
+		uint32_t count;
+		/** Size of each buffer (in bytes) */
+		uint32_t size;
+		/** Address of each buffer */
+		uint32_t addr[APPLET_BUFFER_COUNT];
+		/** Status of each buffer */
+		uint32_t status[APPLET_BUFFER_COUNT];
+		/** Largest number of pages of an LZ4 image record */
+		uint32_t image_pages;
+	} out;
+};
+
+/**
+ * \brief Mailbox content for the 'write image' command.
+ *
+ * The buffer holds a sequence of APPLET_IMAGE_* records, written from the
+ * given offset on. When the memory is erased before being written (NAND, NOR),
+ * the pages holding only the erased value are not programmed.
+ */
+union write_image_mailbox {
+	struct {
+		/** Index of the buffer holding the records */
+		uint32_t buffer;
+		/** Write offset (in pages) */
+		uint32_t offset;
+		/** Size of the records (in bytes) */
+		uint32_t size;
+	} in;
+
+	struct {
+		/** Pages covered by the records processed */
+		uint32_t pages;
+		/** Pages actually programmed */
+		uint32_t written;
+		/** Status of each buffer, APPLET_BUSY until its write is over */
+		uint32_t status[APPLET_BUFFER_COUNT];
+	} out;
+};
+
+/**
+ * \brief Mailbox content for the 'verify' command.
+ *
+ * The pages are read as by the 'read pages' command, NAND pages being
+ * corrected by the ECC, and only their checksum is returned.
+ */
+union verify_mailbox {
+	struct {
+		/** Algorithm (APPLET_VERIFY_*) */
+		uint32_t algo;
+		/** Read offset (in pages) */
+		uint32_t offset;
+		/** Read length (in pages) */
+		uint32_t length;
+	} in;
+
+	struct {
+		/** Pages read */
+		uint32_t pages;
+		/** CRC-32 in the first word, or the SHA-256 digest bytes in
+		 * order */
+		uint32_t digest[8];
+	} out;
+};
+
 typedef uint32_t (*applet_command_handler_t)(uint32_t cmd, uint32_t *args);
 
+/** Memory operations of the buffered write mode. */
+struct applet_buffer_ops
+{
+	/** Write pages, may return before the memory has programmed the last
+	 * ones. The data shall not be modified until wait_write returns.
+	 * Returns an APPLET_* status. */
+	uint32_t (*start_write)(const uint8_t *data, uint32_t offset,
+			uint32_t length);
+	/** Wait for the end of the last write, returns an APPLET_* status.
+	 * NULL if start_write always waits. */
+	uint32_t (*wait_write)(void);
+	/** Read pages, returns an APPLET_* status. Used by the 'verify'
+	 * command. */
+	uint32_t (*read)(uint8_t *data, uint32_t offset, uint32_t length);
+	/** true if the memory is erased before being written, the pages of
+	 * images holding only erased_value are then skipped */
+	bool skip_erased;
+	uint32_t erased_value;
+};
+
 struct applet_command
 {
 	uint32_t command;
@@ -132,6 +278,9 @@ extern const struct applet_command applet_commands[];
 
 extern void applet_set_init_params(uint32_t comm, uint32_t trace);
 
+extern bool applet_setup_buffers(uint8_t *buffer, uint32_t size,
+		uint32_t page_size, const struct applet_buffer_ops *ops);
+
 extern applet_command_handler_t get_applet_command_handler(uint8_t cmd);
 
 extern void applet_main(struct applet_mailbox *mailbox);
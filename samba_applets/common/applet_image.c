@@ -0,0 +1,248 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "applet.h"
+#include "applet_image.h"
+#include "lz4.h"
+#include "trace.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static bool is_erased(const struct applet_image *image, const uint8_t *data)
+{
+	const uint32_t *word = (const uint32_t*)data;
+	uint32_t i;
+
+	for (i = 0; i < image->page_size / 4; i++)
+		if (word[i] != image->ops->erased_value)
+			return false;
+	return true;
+}
+
+/**
+ * \brief Wait for the end of the last write, if it is still in progress.
+ */
+static uint32_t wait_write(struct applet_image *image)
+{
+	if (!image->pending)
+		return APPLET_SUCCESS;
+
+	image->pending = false;
+	return image->ops->wait_write();
+}
+
+/**
+ * \brief Start writing pages once the previous write is over, the memory
+ * performing one write at a time.
+ */
+static uint32_t write(struct applet_image *image, const uint8_t *data,
+		uint32_t offset, uint32_t count)
+{
+	uint32_t status;
+
+	/* records of zero pages are valid but write nothing */
+	if (count == 0)
+		return APPLET_SUCCESS;
+
+	status = wait_write(image);
+	if (status != APPLET_SUCCESS)
+		return status;
+
+	status = image->ops->start_write(data, offset, count);
+	if (status != APPLET_SUCCESS)
+		return status;
+
+	image->pending = image->ops->wait_write != NULL;
+	image->written += count;
+	return APPLET_SUCCESS;
+}
+
+/**
+ * \brief Write pages, leaving out the erased ones if the memory is erased
+ * beforehand.
+ */
+static uint32_t write_pages(struct applet_image *image, const uint8_t *data,
+		uint32_t offset, uint32_t count)
+{
+	uint32_t first, i, status;
+
+	if (!image->ops->skip_erased)
+		return write(image, data, offset, count);
+
+	/* write the runs of non-erased pages */
+	for (first = 0, i = 0; i <= count; i++) {
+		if (i < count && !is_erased(image, data + i * image->page_size))
+			continue;
+		if (i > first) {
+			status = write(image, data + first * image->page_size,
+					offset + first, i - first);
+			if (status != APPLET_SUCCESS)
+				return status;
+		}
+		first = i + 1;
+	}
+	return APPLET_SUCCESS;
+}
+
+static uint32_t write_fill(struct applet_image *image, uint32_t value,
+		uint32_t offset, uint32_t count)
+{
+	uint32_t *word = (uint32_t*)image->staging;
+	uint32_t max_pages = image->staging_size / image->page_size;
+	uint32_t chunk, i, status;
+
+	if (image->ops->skip_erased && value == image->ops->erased_value)
+		return APPLET_SUCCESS;
+
+	/* the staging area may be the source of the write in progress */
+	status = wait_write(image);
+	if (status != APPLET_SUCCESS)
+		return status;
+
+	chunk = count < max_pages ? count : max_pages;
+	for (i = 0; i < chunk * image->page_size / 4; i++)
+		word[i] = value;
+
+	while (count) {
+		chunk = count < max_pages ? count : max_pages;
+		status = write(image, image->staging, offset, chunk);
+		if (status != APPLET_SUCCESS)
+			return status;
+		offset += chunk;
+		count -= chunk;
+	}
+	return APPLET_SUCCESS;
+}
+
+static uint32_t write_lz4(struct applet_image *image, const uint8_t *block,
+		uint32_t block_size, uint32_t offset, uint32_t count)
+{
+	uint32_t len, status;
+
+	if (count > image->staging_size / image->page_size) {
+		trace_error_wp("LZ4 record too large: %u pages\r\n",
+				(unsigned)count);
+		return APPLET_FAIL;
+	}
+
+	/* the staging area may be the source of the write in progress */
+	status = wait_write(image);
+	if (status != APPLET_SUCCESS)
+		return status;
+
+	if (!lz4_decompress(block, block_size, image->staging,
+				count * image->page_size, &len) ||
+	    len != count * image->page_size) {
+		trace_error_wp("Corrupted LZ4 record at page %u\r\n",
+				(unsigned)offset);
+		return APPLET_FAIL;
+	}
+
+	return write_pages(image, image->staging, offset, count);
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint32_t applet_image_write(struct applet_image *image,
+		const uint8_t *records, uint32_t size, uint32_t offset)
+{
+	const uint32_t page_size = image->page_size;
+	uint32_t pos = 0;
+	uint32_t header, type, count, value;
+	uint32_t status = APPLET_SUCCESS;
+
+	image->pages = 0;
+	image->written = 0;
+	image->pending = false;
+
+	while (pos < size) {
+		if (size - pos < 4)
+			goto invalid;
+		header = *(const uint32_t*)(records + pos);
+		pos += 4;
+		type = header >> 28;
+		count = header & 0x0fffffff;
+
+		switch (type) {
+		case APPLET_IMAGE_RAW:
+			if (count > (size - pos) / page_size)
+				goto invalid;
+			status = write_pages(image, records + pos, offset,
+					count);
+			pos += count * page_size;
+			break;
+
+		case APPLET_IMAGE_LZ4:
+			if (size - pos < 4)
+				goto invalid;
+			value = *(const uint32_t*)(records + pos);
+			pos += 4;
+			if (value > size - pos)
+				goto invalid;
+			status = write_lz4(image, records + pos, value, offset,
+					count);
+			pos += (value + 3) & ~3u;
+			break;
+
+		case APPLET_IMAGE_FILL:
+			if (size - pos < 4)
+				goto invalid;
+			value = *(const uint32_t*)(records + pos);
+			pos += 4;
+			status = write_fill(image, value, offset, count);
+			break;
+
+		case APPLET_IMAGE_SKIP:
+			break;
+
+		default:
+			goto invalid;
+		}
+
+		if (status != APPLET_SUCCESS)
+			return status;
+		offset += count;
+		image->pages += count;
+	}
+	return APPLET_SUCCESS;
+
+invalid:
+	trace_error_wp("Invalid image record at byte %u\r\n", (unsigned)pos);
+	return APPLET_FAIL;
+}
@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _APPLET_IMAGE_H_
+#define _APPLET_IMAGE_H_
+
+#include "applet.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+/** Writer of the records of the 'write image' command */
+struct applet_image
+{
+	const struct applet_buffer_ops *ops;
+	uint32_t page_size;
+	/** Decompression area of the LZ4 records, a multiple of page_size */
+	uint8_t *staging;
+	uint32_t staging_size;
+
+	/* following fields are updated by applet_image_write() */
+	uint32_t pages;    /* pages covered by the records processed */
+	uint32_t written;  /* pages programmed */
+	bool pending;      /* the end of the last write is not waited for */
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Write a sequence of APPLET_IMAGE_* records, starting at the given
+ * page. The memory needed does not depend on the image: the records are read
+ * in place and LZ4 blocks are decompressed to the staging area.
+ * \param image  Writer, with the memory operations and the staging area set.
+ * \param records  Word-aligned records.
+ * \param size  Size of the records, in bytes.
+ * \param offset  Page of the memory written by the first record.
+ * \return APPLET_SUCCESS, APPLET_FAIL if a record is invalid or the status of
+ * the write operation that failed.
+ */
+extern uint32_t applet_image_write(struct applet_image *image,
+		const uint8_t *records, uint32_t size, uint32_t offset);
+
+#endif /* _APPLET_IMAGE_H_ */
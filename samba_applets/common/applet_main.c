@@ -31,6 +31,10 @@
 #include "board.h"
 #include "applet.h"
 #include "applet_legacy.h"
+#include "applet_image.h"
+#ifdef CONFIG_SAMBA_APPLET_VERIFY
+#include "applet_verify.h"
+#endif
 #include "trace.h"
 #include "timer.h"
 #include "peripherals/dma.h"
@@ -39,6 +43,7 @@
 #include "peripherals/sfc.h"
 #include "misc/console.h"
 
+#include <assert.h>
 #include <string.h>
 
 /* define this to enable debug display of mailbox content */
@@ -55,6 +60,15 @@ static uint32_t _comm_type;
 uint8_t *applet_buffer;
 uint32_t applet_buffer_size;
 
+/* buffered write mode */
+static const struct applet_buffer_ops *_buffer_ops;
+static uint8_t *_buffers[APPLET_BUFFER_COUNT];
+static uint32_t _buffers_size;
+static uint32_t _buffers_page_size;
+static uint32_t _buffers_status[APPLET_BUFFER_COUNT];
+static int _pending_buffer = -1;
+static struct applet_image _image;
+
 /*----------------------------------------------------------------------------
  *         Local functions
  *----------------------------------------------------------------------------*/
@@ -86,6 +100,180 @@ static void debug_display_mailbox(struct applet_mailbox *mailbox)
 #endif
 }
 
+/**
+ * \brief Wait for the end of the buffered write in progress, if any, and
+ * record its status.
+ */
+static void wait_pending_write(void)
+{
+	if (_pending_buffer < 0)
+		return;
+
+	_buffers_status[_pending_buffer] = _buffer_ops->wait_write();
+	if (_buffers_status[_pending_buffer] != APPLET_SUCCESS)
+		trace_error_wp("Write from buffer %d failed\r\n",
+				_pending_buffer);
+	_pending_buffer = -1;
+}
+
+static uint32_t handle_cmd_write_buffer(uint32_t cmd, uint32_t *mailbox)
+{
+	union write_buffer_mailbox *mbx =
+		(union write_buffer_mailbox*)mailbox;
+	uint32_t index = mbx->in.buffer;
+	uint32_t offset = mbx->in.offset;
+	uint32_t length = mbx->in.length;
+	uint32_t status = APPLET_SUCCESS;
+	int i;
+
+	assert(cmd == APPLET_CMD_WRITE_BUFFER);
+
+	if (index >= APPLET_BUFFER_COUNT) {
+		trace_error_wp("Invalid buffer %u\r\n", (unsigned)index);
+		return APPLET_FAIL;
+	}
+
+	/* check that requested size does not overflow buffer */
+	if (length > _buffers_size / _buffers_page_size) {
+		trace_error_wp("Buffer overflow\r\n");
+		return APPLET_FAIL;
+	}
+
+	/* the memory performs one write at a time: the previous one
+	 * completes now, the host having uploaded this buffer meanwhile */
+	wait_pending_write();
+
+	if (length)
+		status = _buffer_ops->start_write(_buffers[index], offset,
+				length);
+	if (status == APPLET_SUCCESS && length && _buffer_ops->wait_write) {
+		_buffers_status[index] = APPLET_BUSY;
+		_pending_buffer = index;
+	} else {
+		_buffers_status[index] = status;
+	}
+
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++)
+		mbx->out.status[i] = _buffers_status[i];
+
+	return status;
+}
+
+static uint32_t handle_cmd_write_image(uint32_t cmd, uint32_t *mailbox)
+{
+	union write_image_mailbox *mbx =
+		(union write_image_mailbox*)mailbox;
+	uint32_t index = mbx->in.buffer;
+	uint32_t offset = mbx->in.offset;
+	uint32_t size = mbx->in.size;
+	uint32_t status;
+	int i;
+
+	assert(cmd == APPLET_CMD_WRITE_IMAGE);
+
+	if (index >= APPLET_BUFFER_COUNT) {
+		trace_error_wp("Invalid buffer %u\r\n", (unsigned)index);
+		return APPLET_FAIL;
+	}
+
+	if (size > _buffers_size || (size & 3)) {
+		trace_error_wp("Invalid image size %u\r\n", (unsigned)size);
+		return APPLET_FAIL;
+	}
+
+	wait_pending_write();
+
+	status = applet_image_write(&_image, _buffers[index], size, offset);
+	if (_image.pending) {
+		if (status == APPLET_SUCCESS) {
+			/* the last write goes on while the host uploads the
+			 * next buffer */
+			_buffers_status[index] = APPLET_BUSY;
+			_pending_buffer = index;
+		} else {
+			_buffer_ops->wait_write();
+			_buffers_status[index] = status;
+		}
+	} else {
+		_buffers_status[index] = status;
+	}
+
+	mbx->out.pages = _image.pages;
+	mbx->out.written = _image.written;
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++)
+		mbx->out.status[i] = _buffers_status[i];
+
+	return status;
+}
+
+#ifdef CONFIG_SAMBA_APPLET_VERIFY
+static uint32_t handle_cmd_verify(uint32_t cmd, uint32_t *mailbox)
+{
+	union verify_mailbox *mbx = (union verify_mailbox*)mailbox;
+	uint32_t algo = mbx->in.algo;
+	uint32_t offset = mbx->in.offset;
+	uint32_t length = mbx->in.length;
+	struct applet_verify verify;
+	uint32_t status;
+	int i;
+
+	assert(cmd == APPLET_CMD_VERIFY);
+
+	if (!_buffer_ops->read) {
+		trace_error_wp("Verify not supported\r\n");
+		return APPLET_FAIL;
+	}
+
+	verify.ops = _buffer_ops;
+	verify.page_size = _buffers_page_size;
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++)
+		verify.buffers[i] = _buffers[i];
+	verify.buffer_size = _buffers_size;
+
+	memset(mbx->out.digest, 0, sizeof(mbx->out.digest));
+	status = applet_verify(&verify, algo, offset, length,
+			mbx->out.digest);
+	mbx->out.pages = verify.pages;
+
+	trace_info_wp("Verified %u pages at page 0x%08x\r\n",
+			(unsigned)verify.pages, (unsigned)offset);
+
+	return status;
+}
+#endif /* CONFIG_SAMBA_APPLET_VERIFY */
+
+static uint32_t handle_cmd_buffer_status(uint32_t cmd, uint32_t *mailbox)
+{
+	union buffer_status_mailbox *mbx =
+		(union buffer_status_mailbox*)mailbox;
+	int i;
+
+	assert(cmd == APPLET_CMD_BUFFER_STATUS);
+
+	if (mbx->in.wait)
+		wait_pending_write();
+
+	mbx->out.count = APPLET_BUFFER_COUNT;
+	mbx->out.size = _buffers_size;
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++) {
+		mbx->out.addr[i] = (uint32_t)_buffers[i];
+		mbx->out.status[i] = _buffers_status[i];
+	}
+	mbx->out.image_pages = _image.staging_size / _image.page_size;
+
+	return APPLET_SUCCESS;
+}
+
+static const struct applet_command buffer_commands[] = {
+	{ APPLET_CMD_WRITE_BUFFER, handle_cmd_write_buffer },
+	{ APPLET_CMD_BUFFER_STATUS, handle_cmd_buffer_status },
+	{ APPLET_CMD_WRITE_IMAGE, handle_cmd_write_image },
+#ifdef CONFIG_SAMBA_APPLET_VERIFY
+	{ APPLET_CMD_VERIFY, handle_cmd_verify },
+#endif
+	{ 0, NULL }
+};
+
 /*----------------------------------------------------------------------------
  *         Public functions
  *----------------------------------------------------------------------------*/
@@ -104,12 +292,56 @@ void applet_set_init_params(uint32_t comm, uint32_t trace)
 	}
 }
 
+/**
+ * \brief Enable the buffered write mode, splitting the given buffer in
+ * APPLET_BUFFER_COUNT buffers of a whole number of pages, plus a quarter kept
+ * for the decompression of the image records. To be called by the
+ * 'initialize' handler of the applets supporting it.
+ * \return false if the buffer is too small.
+ */
+bool applet_setup_buffers(uint8_t *buffer, uint32_t size, uint32_t page_size,
+		const struct applet_buffer_ops *ops)
+{
+	uint32_t staging_size;
+	int i;
+
+	staging_size = size / 4;
+	staging_size -= staging_size % page_size;
+	size = (size - staging_size) / APPLET_BUFFER_COUNT;
+	size -= size % page_size;
+	if (size == 0 || staging_size == 0) {
+		_buffer_ops = NULL;
+		return false;
+	}
+
+	_buffer_ops = ops;
+	_buffers_size = size;
+	_buffers_page_size = page_size;
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++) {
+		_buffers[i] = buffer + i * size;
+		_buffers_status[i] = APPLET_SUCCESS;
+	}
+	_pending_buffer = -1;
+
+	memset(&_image, 0, sizeof(_image));
+	_image.ops = ops;
+	_image.page_size = page_size;
+	_image.staging = buffer + APPLET_BUFFER_COUNT * size;
+	_image.staging_size = staging_size;
+	return true;
+}
+
 applet_command_handler_t get_applet_command_handler(uint8_t cmd)
 {
 	int i;
 	for (i = 0; applet_commands[i].handler; i++)
 		if (applet_commands[i].command == cmd)
 			return applet_commands[i].handler;
+	if (_buffer_ops) {
+		for (i = 0; buffer_commands[i].handler; i++)
+			if (buffer_commands[i].command == cmd)
+				return buffer_commands[i].handler;
+	}
 	return NULL;
 }
 
@@ -137,6 +369,13 @@ void applet_main(struct applet_mailbox *mailbox)
 	/* set default status */
 	mailbox->status = APPLET_FAIL;
 
+	/* other commands access the memory, let the buffered write in
+	 * progress complete first */
+	if (mailbox->command != APPLET_CMD_WRITE_BUFFER &&
+	    mailbox->command != APPLET_CMD_WRITE_IMAGE &&
+	    mailbox->command != APPLET_CMD_BUFFER_STATUS)
+		wait_pending_write();
+
 	/* look for handler and call it */
 	handler = get_applet_command_handler(mailbox->command);
 	if (handler) {
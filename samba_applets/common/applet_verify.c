@@ -0,0 +1,150 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "applet.h"
+#include "applet_verify.h"
+#include "crc.h"
+#include "trace.h"
+
+#ifdef CONFIG_HAVE_SHA
+#include "peripherals/cryptod.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t verify_crc32(struct applet_verify *verify, uint32_t offset,
+		uint32_t length, uint32_t *digest)
+{
+	const uint32_t max_pages = verify->buffer_size / verify->page_size;
+	struct _crc_ctx crc;
+	uint32_t count, status;
+
+	if (!crc_init(&crc, CRC_32)) {
+		trace_error_wp("CRC-32 not built in\r\n");
+		return APPLET_FAIL;
+	}
+
+	while (length) {
+		count = length < max_pages ? length : max_pages;
+		status = verify->ops->read(verify->buffers[0], offset, count);
+		if (status != APPLET_SUCCESS)
+			return status;
+		crc_update(&crc, verify->buffers[0], count * verify->page_size);
+		verify->pages += count;
+		offset += count;
+		length -= count;
+	}
+	digest[0] = crc_final(&crc);
+	return APPLET_SUCCESS;
+}
+
+#ifdef CONFIG_HAVE_SHA
+/**
+ * \brief Hash the pages with the SHA engine. The engine fetches the pages of
+ * one buffer by DMA while the next pages are read to the other buffer.
+ */
+static uint32_t verify_sha256(struct applet_verify *verify, uint32_t offset,
+		uint32_t length, uint32_t *digest)
+{
+	const uint32_t max_pages = verify->buffer_size / verify->page_size;
+	const struct _cryptod_cfg cfg = { .algo = CRYPTOD_ALGO_SHA256 };
+	struct _cryptod_session session;
+	struct _cryptod_sg sg;
+	uint32_t count, status;
+	int current = 0;
+
+	if (cryptod_init(&session, &cfg) != CRYPTOD_SUCCESS) {
+		trace_error_wp("SHA engine not available\r\n");
+		return APPLET_FAIL;
+	}
+
+	count = length < max_pages ? length : max_pages;
+	status = length ? verify->ops->read(verify->buffers[0], offset, count)
+	                : APPLET_SUCCESS;
+	while (length && status == APPLET_SUCCESS) {
+		sg.src = verify->buffers[current];
+		sg.dst = NULL;
+		sg.len = count * verify->page_size;
+		if (cryptod_update(&session, &sg, 1, NULL, NULL)
+				!= CRYPTOD_SUCCESS) {
+			status = APPLET_FAIL;
+			break;
+		}
+		verify->pages += count;
+		offset += count;
+		length -= count;
+		if (!length)
+			break;
+
+		current = (current + 1) % APPLET_BUFFER_COUNT;
+		count = length < max_pages ? length : max_pages;
+		status = verify->ops->read(verify->buffers[current], offset,
+				count);
+
+		/* the engine is done with the previous pages once these ones
+		 * are read, queue them in turn */
+		cryptod_wait(&session);
+	}
+
+	/* end the session in any case to release the engine */
+	cryptod_wait(&session);
+	cryptod_final(&session, NULL, digest, 0, NULL, NULL);
+	cryptod_wait(&session);
+	return status;
+}
+#endif /* CONFIG_HAVE_SHA */
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint32_t applet_verify(struct applet_verify *verify, uint32_t algo,
+		uint32_t offset, uint32_t length, uint32_t *digest)
+{
+	verify->pages = 0;
+
+	switch (algo) {
+	case APPLET_VERIFY_CRC32:
+		return verify_crc32(verify, offset, length, digest);
+#ifdef CONFIG_HAVE_SHA
+	case APPLET_VERIFY_SHA256:
+		return verify_sha256(verify, offset, length, digest);
+#endif
+	default:
+		trace_error_wp("Unsupported verify algorithm %u\r\n",
+				(unsigned)algo);
+		return APPLET_FAIL;
+	}
+}
@@ -0,0 +1,72 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _APPLET_VERIFY_H_
+#define _APPLET_VERIFY_H_
+
+#include "applet.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+/** Checksum computation of the 'verify' command */
+struct applet_verify
+{
+	const struct applet_buffer_ops *ops;
+	uint32_t page_size;
+	/** Buffers the pages are read to, alternately when the checksum is
+	 * computed by the hardware */
+	uint8_t *buffers[APPLET_BUFFER_COUNT];
+	uint32_t buffer_size;  /* in bytes, a multiple of page_size */
+
+	/* following field is updated by applet_verify() */
+	uint32_t pages;  /* pages read */
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Compute the checksum of a page range.
+ * \param verify  Context, with the memory operations and buffers set.
+ * \param algo  APPLET_VERIFY_CRC32 or APPLET_VERIFY_SHA256.
+ * \param offset  First page.
+ * \param length  Number of pages.
+ * \param digest  Receives the CRC-32 in the first word or the SHA-256 digest.
+ * \return APPLET_SUCCESS, APPLET_FAIL if the algorithm is not supported or
+ * the status of the read operation that failed.
+ */
+extern uint32_t applet_verify(struct applet_verify *verify, uint32_t algo,
+		uint32_t offset, uint32_t length, uint32_t *digest);
+
+#endif /* _APPLET_VERIFY_H_ */
@@ -68,6 +68,9 @@ static uint8_t *buffer;
 static uint32_t buffer_size;
 static uint32_t erase_support;
 
+static struct _qspiflash_job write_job;
+static volatile bool write_job_success;
+
 /*----------------------------------------------------------------------------
  *         Local functions
  *----------------------------------------------------------------------------*/
@@ -90,6 +93,69 @@ static bool configure_instance_pio(uint32_t instance, uint32_t ioset, Qspi** add
 	return false;
 }
 
+static void write_job_done(struct _qspiflash *qspiflash, bool success,
+		void *arg)
+{
+	write_job_success = success;
+}
+
+static uint32_t start_buffer_write(const uint8_t *data, uint32_t offset,
+		uint32_t length)
+{
+	uint32_t page_size = flash.desc.page_size;
+	uint32_t addr = offset * page_size;
+	uint32_t size = (length - 1) * page_size;
+
+	/* program all pages but the last one */
+	if (size && !qspiflash_write(&flash, addr, data, size)) {
+		trace_error("Write error\r\n");
+		return APPLET_WRITE_FAIL;
+	}
+
+	/* the last page is copied by the driver and programmed while the
+	 * host uploads the next buffer */
+	write_job_success = true;
+	if (!qspiflash_write_async(&flash, &write_job, addr + size,
+				data + size, page_size, write_job_done, NULL)) {
+		trace_error("Write error\r\n");
+		return APPLET_WRITE_FAIL;
+	}
+
+	trace_info_wp("Writing %u bytes at 0x%08x\r\n",
+			(unsigned)(size + page_size), (unsigned)addr);
+
+	return APPLET_SUCCESS;
+}
+
+static uint32_t wait_buffer_write(void)
+{
+	while (qspiflash_is_busy(&flash))
+		qspiflash_poll(&flash);
+
+	return write_job_success ? APPLET_SUCCESS : APPLET_WRITE_FAIL;
+}
+
+static uint32_t read_buffer(uint8_t *data, uint32_t offset, uint32_t length)
+{
+	uint32_t page_size = flash.desc.page_size;
+
+	if (!qspiflash_read(&flash, offset * page_size, data,
+				length * page_size)) {
+		trace_error("Read error\r\n");
+		return APPLET_READ_FAIL;
+	}
+
+	return APPLET_SUCCESS;
+}
+
+static const struct applet_buffer_ops buffer_ops = {
+	.start_write = start_buffer_write,
+	.wait_write = wait_buffer_write,
+	.read = read_buffer,
+	.skip_erased = true,
+	.erased_value = 0xffffffff,
+};
+
 static uint32_t handle_cmd_initialize(uint32_t cmd, uint32_t *mailbox)
 {
 	union initialize_mailbox *mbx = (union initialize_mailbox*)mailbox;
@@ -170,6 +236,8 @@ static uint32_t handle_cmd_initialize(uint32_t cmd, uint32_t *mailbox)
 		trace_info_wp("Buffer Address: 0x%08x\r\n", (unsigned)buffer);
 		trace_info_wp("Buffer Size: %u bytes\r\n", (unsigned)buffer_size);
 
+		applet_setup_buffers(buffer, buffer_size, page_size, &buffer_ops);
+
 		mbx->out.buf_addr = (uint32_t)buffer;
 		mbx->out.buf_size = buffer_size;
 		mbx->out.page_size = page_size;
@@ -95,6 +95,9 @@ static uint32_t buffer_size;
 
 static uint32_t mem_size;
 
+/* Status of the buffered write in progress */
+static volatile uint32_t write_status;
+
 /* Driver instance data (a.k.a. MCI driver instance) */
 static struct sdmmc_set drv;
 
@@ -207,6 +210,74 @@ static char* get_supported_voltage_string(uint32_t supported_voltages)
 	return str;
 }
 
+static void write_done(uint32_t status, void *arg)
+{
+	write_status = status;
+}
+
+static uint32_t start_buffer_write(const uint8_t *data, uint32_t offset,
+		uint32_t length)
+{
+	/* check that requested offset/size does not overflow memory */
+	if (offset + length > mem_size) {
+		trace_error_wp("Memory overflow\r\n");
+		return APPLET_FAIL;
+	}
+
+	/* queue the request: the controller sends the data by DMA while
+	 * the host uploads the next buffer */
+	write_status = SDMMC_BUSY;
+	if (SD_Write(&lib, offset, data, length, write_done, NULL)
+			!= SDMMC_OK) {
+		trace_error_wp("Error while writing %u bytes at offset 0x%08x\r\n",
+				(unsigned)(length * BLOCK_SIZE),
+				(unsigned)(offset * BLOCK_SIZE));
+		return APPLET_WRITE_FAIL;
+	}
+
+	return APPLET_SUCCESS;
+}
+
+static uint32_t wait_buffer_write(void)
+{
+	/* the low-level driver is in polling mode, this makes the request
+	 * progress */
+	while (!SD_IsRequestQueueIdle(&lib));
+
+	if (write_status != SDMMC_OK) {
+		trace_error_wp("Buffered write failed: %u\r\n",
+				(unsigned)write_status);
+		return APPLET_WRITE_FAIL;
+	}
+
+	return APPLET_SUCCESS;
+}
+
+static uint32_t read_buffer(uint8_t *data, uint32_t offset, uint32_t length)
+{
+	/* check that requested offset/size does not overflow memory */
+	if (offset + length > mem_size) {
+		trace_error_wp("Memory overflow\r\n");
+		return APPLET_FAIL;
+	}
+
+	if (SD_Read(&lib, offset, data, length, NULL, NULL) != SDMMC_OK) {
+		trace_error_wp("Error while reading %u bytes at offset 0x%08x\r\n",
+				(unsigned)(length * BLOCK_SIZE),
+				(unsigned)(offset * BLOCK_SIZE));
+		return APPLET_READ_FAIL;
+	}
+
+	return APPLET_SUCCESS;
+}
+
+static const struct applet_buffer_ops buffer_ops = {
+	.start_write = start_buffer_write,
+	.wait_write = wait_buffer_write,
+	.read = read_buffer,
+	.skip_erased = false,
+};
+
 static uint32_t handle_cmd_initialize(uint32_t cmd, uint32_t *mailbox)
 {
 	union initialize_mailbox *mbx = (union initialize_mailbox*)mailbox;
@@ -354,6 +425,8 @@ static uint32_t handle_cmd_initialize(uint32_t cmd, uint32_t *mailbox)
 		return APPLET_FAIL;
 	}
 
+	applet_setup_buffers(buffer, buffer_size, BLOCK_SIZE, &buffer_ops);
+
 	mbx->out.buf_addr = (uint32_t)buffer;
 	mbx->out.buf_size = buffer_size;
 	mbx->out.page_size = BLOCK_SIZE;
@@ -105,6 +105,54 @@ static bool configure_instance_pio(uint32_t instance, uint32_t ioset,
 	return false;
 }
 
+static uint32_t start_buffer_write(const uint8_t *data, uint32_t offset,
+		uint32_t length)
+{
+	uint32_t page_size = at25drv.desc->page_size;
+
+	/* at25_write returns once the last page has been sent, the memory
+	 * programs it while the host uploads the next buffer */
+	if (at25_write(&at25drv, offset * page_size, data,
+				length * page_size) != AT25_SUCCESS) {
+		trace_error("Write error\r\n");
+		return APPLET_WRITE_FAIL;
+	}
+
+	trace_info_wp("Writing %u bytes at 0x%08x\r\n",
+			(unsigned)(length * page_size),
+			(unsigned)(offset * page_size));
+
+	return APPLET_SUCCESS;
+}
+
+static uint32_t wait_buffer_write(void)
+{
+	at25_wait(&at25drv);
+
+	return APPLET_SUCCESS;
+}
+
+static uint32_t read_buffer(uint8_t *data, uint32_t offset, uint32_t length)
+{
+	uint32_t page_size = at25drv.desc->page_size;
+
+	if (at25_read(&at25drv, offset * page_size, data,
+				length * page_size) != AT25_SUCCESS) {
+		trace_error("Read error\r\n");
+		return APPLET_READ_FAIL;
+	}
+
+	return APPLET_SUCCESS;
+}
+
+static const struct applet_buffer_ops buffer_ops = {
+	.start_write = start_buffer_write,
+	.wait_write = wait_buffer_write,
+	.read = read_buffer,
+	.skip_erased = true,
+	.erased_value = 0xffffffff,
+};
+
 static uint32_t handle_cmd_initialize(uint32_t cmd, uint32_t *mailbox)
 {
 	union initialize_mailbox *mbx = (union initialize_mailbox*)mailbox;
@@ -208,6 +256,8 @@ static uint32_t handle_cmd_initialize(uint32_t cmd, uint32_t *mailbox)
 		trace_info_wp("Buffer Size: %u bytes\r\n",
 				(unsigned)buffer_size);
 
+		applet_setup_buffers(buffer, buffer_size, page_size, &buffer_ops);
+
 		mbx->out.buf_addr = (uint32_t)buffer;
 		mbx->out.buf_size = buffer_size;
 		mbx->out.page_size = page_size;
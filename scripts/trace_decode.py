@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+#         SAM Software Package License
+# ----------------------------------------------------------------------------
+# Copyright (c) 2016, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+# Decode the binary traces output by utils/trace_deferred.c when the
+# application is built with CONFIG_TRACE_DEFERRED=y and CONFIG_TRACE_BINARY=y.
+#
+# usage: trace_decode.py <application.elf> [<capture file>]
+#
+# The capture (standard input by default) is the raw byte stream received on
+# the console. Format strings and the strings of %s arguments are read from
+# the ELF file. Requires pyelftools.
+
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+TRACE_MAGIC = 0xA5
+RECORD_WORDS = 3
+LEVELS = "SFEWID"
+
+SPEC = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?([hlzjtL]*)([diuxXocspfFeEgG%])")
+
+
+class Image:
+    """Read-only view of the loadable sections of an ELF file."""
+
+    def __init__(self, path):
+        self.segments = []
+        with open(path, "rb") as f:
+            elf = ELFFile(f)
+            for section in elf.iter_sections():
+                addr = section["sh_addr"]
+                if addr and section["sh_type"] == "SHT_PROGBITS":
+                    self.segments.append((addr, section.data()))
+
+    def string(self, addr):
+        for start, data in self.segments:
+            if start <= addr < start + len(data):
+                end = data.find(b"\0", addr - start)
+                if end < 0:
+                    end = len(data)
+                return data[addr - start:end].decode("latin-1")
+        return None
+
+
+def format_trace(image, fmt, args):
+    out = []
+    pos = 0
+    args = list(args)
+
+    def pop(words=1):
+        if len(args) < words:
+            return 0
+        value = args.pop(0)
+        if words == 2:
+            value |= args.pop(0) << 32
+        return value
+
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = str(struct.unpack("<i", struct.pack("<I", pop()))[0])
+        if prec == "*":
+            prec = str(struct.unpack("<i", struct.pack("<I", pop()))[0])
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        if conv in "fFeEgG":
+            value = struct.unpack("<d", struct.pack("<Q", pop(2)))[0]
+            out.append((spec + conv) % value)
+        elif conv == "s":
+            addr = pop()
+            text = image.string(addr)
+            out.append((spec + "s") % (text if text is not None else "<0x%08x>" % addr))
+        elif conv == "p":
+            out.append((spec + "s") % ("0x%08x" % pop()))
+        elif conv == "c":
+            out.append((spec + "c") % (pop() & 0xFF))
+        else:
+            words = 2 if length.count("l") >= 2 else 1
+            bits = 32 * words
+            value = pop(words)
+            if conv in "di" and value >> (bits - 1):
+                value -= 1 << bits
+            out.append((spec + conv.replace("u", "d")) % value)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def records(stream):
+    """Yield (level, tick, format address, args) for each record, skipping
+    garbage until a valid header is found."""
+    data = stream.read()
+    pos = 0
+    while pos + 4 * RECORD_WORDS <= len(data):
+        header, = struct.unpack_from("<I", data, pos)
+        size = header & 0xFF
+        if header >> 24 != TRACE_MAGIC or size < RECORD_WORDS or \
+                pos + 4 * size > len(data):
+            pos += 1
+            continue
+        words = struct.unpack_from("<%dI" % size, data, pos)
+        pos += 4 * size
+        yield (header >> 8) & 0xFF, words[2], words[1], words[RECORD_WORDS:]
+
+
+def main():
+    if len(sys.argv) < 2:
+        sys.stderr.write("usage: %s <application.elf> [<capture>]\n" % sys.argv[0])
+        return 1
+
+    image = Image(sys.argv[1])
+    stream = open(sys.argv[2], "rb") if len(sys.argv) > 2 else sys.stdin.buffer
+
+    for level, tick, fmt_addr, args in records(stream):
+        if fmt_addr == 0:
+            drops = " ".join("%s%u" % (LEVELS[i], args[i])
+                             for i in range(1, min(len(args), len(LEVELS))))
+            line = "-W- traces dropped (%s)\n" % drops
+        else:
+            fmt = image.string(fmt_addr)
+            if fmt is None:
+                line = "<unknown format 0x%08x>\n" % fmt_addr
+            else:
+                line = format_trace(image, fmt, args)
+        sys.stdout.write("[%10u] %s" % (tick, line.replace("\r", "")))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,55 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host replacement for utils/trace.h in the applet_image tests: the records
+ * rejected on purpose are counted in trace_errors instead of being printed.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/** Number of errors traced, defined by the test program */
+extern unsigned trace_errors;
+
+#define trace_fatal(...)      do { fprintf(stderr, "-F- " __VA_ARGS__); abort(); } while (0)
+#define trace_fatal_wp(...)   do { fprintf(stderr, __VA_ARGS__); abort(); } while (0)
+#define trace_error(...)      ((void)trace_errors++)
+#define trace_error_wp(...)   ((void)trace_errors++)
+#define trace_warning(...)    fprintf(stderr, "-W- " __VA_ARGS__)
+#define trace_warning_wp(...) fprintf(stderr, __VA_ARGS__)
+#define trace_info(...)       ((void)0)
+#define trace_info_wp(...)    ((void)0)
+#define trace_debug(...)      ((void)0)
+#define trace_debug_wp(...)   ((void)0)
+
+#endif /* _TRACE_H_ */
@@ -0,0 +1,673 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * samba_applets/common/applet_image: random images of RAW, LZ4, FILL and SKIP
+ * records written to a memory model, with and without erased pages skipped
+ * and with synchronous and asynchronous writes. The model checks that each
+ * page is programmed at most once, that one write runs at a time and that
+ * the source of a write is not modified before its end. Invalid and
+ * truncated records shall be rejected without reading past the records, and
+ * write errors shall stop the walk.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "applet.h"
+#include "applet_image.h"
+#include "compiler.h"
+#include "trace.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define MAX_PAGE_SIZE 2048
+
+/** Pages of the memory model */
+#define MAX_PAGES 256
+
+/** Pages of the staging area */
+#define STAGING_PAGES 4
+
+#define ERASED 0xffffffffu
+
+/** Largest records of an image */
+#define MAX_RECORDS_SIZE (MAX_PAGES * MAX_PAGE_SIZE + 1024)
+
+/** Random images per test */
+#define ROUNDS 300
+
+/** Memory model */
+struct memory {
+	uint32_t page_size;
+	uint8_t data[MAX_PAGES * MAX_PAGE_SIZE];
+	uint8_t programs[MAX_PAGES];
+
+	/* write in progress */
+	bool pending;
+	const uint8_t *src;
+	uint32_t len;
+	uint8_t snapshot[MAX_PAGES * MAX_PAGE_SIZE];
+
+	uint32_t starts;       /* calls to start_write */
+	uint32_t fail_start;   /* start_write call failing, 0 for none */
+	uint32_t fail_wait;    /* wait of the start_write call failing */
+};
+
+/** Image under construction and what writing it shall give */
+struct builder {
+	uint32_t size;
+	uint32_t page;                   /* page of the next record */
+	uint32_t cuts[128];              /* sizes of the valid prefixes */
+	uint32_t ncuts;
+	uint8_t data[MAX_PAGES * MAX_PAGE_SIZE];
+	uint8_t programs[MAX_PAGES];
+	uint32_t written;
+};
+
+/** Buffer placed before an inaccessible page */
+struct guarded {
+	uint8_t *area;
+	size_t area_size;
+	uint8_t *end;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+unsigned trace_errors;
+
+static struct memory mem;
+
+static struct builder expected;
+
+static uint32_t records[MAX_RECORDS_SIZE / 4];
+
+static uint32_t staging[STAGING_PAGES * MAX_PAGE_SIZE / 4];
+
+static struct applet_buffer_ops ops;
+
+static struct applet_image image;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Memory model */
+
+static uint32_t _start_write(const uint8_t *data, uint32_t offset,
+		uint32_t length)
+{
+	uint32_t page_size = mem.page_size;
+	uint32_t i;
+
+	CHECK(!mem.pending);
+	CHECK(length > 0);
+	CHECK(offset + length <= MAX_PAGES);
+	if (offset + length > MAX_PAGES)
+		return APPLET_WRITE_FAIL;
+
+	if (++mem.starts == mem.fail_start)
+		return APPLET_WRITE_FAIL;
+
+	for (i = offset; i < offset + length; i++) {
+		CHECK_EQ(mem.programs[i], 0);
+		mem.programs[i]++;
+	}
+	memcpy(mem.data + offset * page_size, data, length * page_size);
+
+	if (ops.wait_write) {
+		mem.pending = true;
+		mem.src = data;
+		mem.len = length * page_size;
+		memcpy(mem.snapshot, data, mem.len);
+	}
+	return APPLET_SUCCESS;
+}
+
+static uint32_t _wait_write(void)
+{
+	CHECK(mem.pending);
+	mem.pending = false;
+	CHECK_MEM(mem.src, mem.snapshot, mem.len, mem.starts);
+	return mem.starts == mem.fail_wait ? APPLET_WRITE_FAIL : APPLET_SUCCESS;
+}
+
+static void _reset(uint32_t page_size, bool skip_erased, bool async)
+{
+	mem.page_size = page_size;
+	memset(mem.data, 0xff, MAX_PAGES * page_size);
+	memset(mem.programs, 0, sizeof(mem.programs));
+	mem.pending = false;
+	mem.starts = 0;
+	mem.fail_start = 0;
+	mem.fail_wait = 0;
+
+	ops.start_write = _start_write;
+	ops.wait_write = async ? _wait_write : NULL;
+	ops.skip_erased = skip_erased;
+	ops.erased_value = ERASED;
+
+	memset(&image, 0, sizeof(image));
+	image.ops = &ops;
+	image.page_size = page_size;
+	image.staging = (uint8_t*)staging;
+	image.staging_size = STAGING_PAGES * page_size;
+}
+
+/** Write the records, then wait for the last write as the applet does */
+static uint32_t _write(const uint8_t *data, uint32_t size, uint32_t offset)
+{
+	uint32_t status;
+
+	status = applet_image_write(&image, data, size, offset);
+	CHECK_EQ(image.pending, mem.pending);
+	if (image.pending && status == APPLET_SUCCESS)
+		status = ops.wait_write();
+	return status;
+}
+
+/* LZ4 encoder, runs of 8 bytes or more become matches at offset 1 */
+
+static uint8_t *_put_length(uint8_t *op, uint32_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+	return op;
+}
+
+static uint8_t *_put_sequence(uint8_t *op, const uint8_t *lit,
+		uint32_t lit_len, uint32_t match_len)
+{
+	uint8_t *token = op++;
+
+	*token = (lit_len < 15 ? lit_len : 15) << 4;
+	if (lit_len >= 15)
+		op = _put_length(op, lit_len - 15);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+	if (!match_len)
+		return op;
+
+	*op++ = 1;
+	*op++ = 0;
+	match_len -= 4;
+	*token |= match_len < 15 ? match_len : 15;
+	if (match_len >= 15)
+		op = _put_length(op, match_len - 15);
+	return op;
+}
+
+static uint32_t _lz4_encode(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+	uint8_t *op = dst;
+	uint32_t anchor = 0, pos = 0, run;
+
+	while (pos < len) {
+		for (run = 1; pos + run < len && src[pos + run] == src[pos];)
+			run++;
+		if (run >= 8) {
+			op = _put_sequence(op, src + anchor, pos + 1 - anchor,
+					run - 1);
+			anchor = pos + run;
+		}
+		pos += run;
+	}
+	op = _put_sequence(op, src + anchor, len - anchor, 0);
+	return op - dst;
+}
+
+/* Image builder */
+
+static void _fill_page(uint8_t *page, uint32_t page_size)
+{
+	uint32_t i, n;
+
+	switch (rand() % 4) {
+	case 0:
+		memset(page, 0xff, page_size);
+		break;
+	case 1:
+		for (i = 0; i < page_size; i++)
+			page[i] = rand();
+		break;
+	case 2:
+		for (i = 0; i < page_size; i += n) {
+			n = 1 + rand() % 64;
+			if (n > page_size - i)
+				n = page_size - i;
+			memset(page + i, (rand() & 1) ? 0xff : rand(), n);
+		}
+		break;
+	case 3:
+		/* erased but for one byte */
+		memset(page, 0xff, page_size);
+		page[rand() % page_size] = rand();
+		break;
+	}
+}
+
+static bool _is_erased(const uint8_t *page, uint32_t page_size)
+{
+	uint32_t i;
+
+	for (i = 0; i < page_size; i++)
+		if (page[i] != 0xff)
+			return false;
+	return true;
+}
+
+static void _begin(uint32_t offset)
+{
+	expected.size = 0;
+	expected.page = offset;
+	expected.cuts[0] = 0;
+	expected.ncuts = 1;
+	memset(expected.data, 0xff, MAX_PAGES * image.page_size);
+	memset(expected.programs, 0, sizeof(expected.programs));
+	expected.written = 0;
+}
+
+static void _put_word(uint32_t value)
+{
+	memcpy((uint8_t*)records + expected.size, &value, 4);
+	expected.size += 4;
+}
+
+/** Expect the pages of a record, given their content */
+static void _expect(const uint8_t *data, uint32_t count, bool write)
+{
+	uint32_t page_size = image.page_size;
+	uint32_t i;
+
+	for (i = 0; i < count; i++, data += page_size) {
+		if (!write)
+			continue;
+		memcpy(expected.data + (expected.page + i) * page_size, data,
+				page_size);
+		if (ops.skip_erased && _is_erased(data, page_size))
+			continue;
+		expected.programs[expected.page + i] = 1;
+		expected.written++;
+	}
+	expected.page += count;
+	expected.cuts[expected.ncuts++] = expected.size;
+}
+
+static void _add_raw(uint32_t count)
+{
+	uint32_t page_size = image.page_size;
+	uint8_t *data;
+	uint32_t i;
+
+	_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_RAW, count));
+	data = (uint8_t*)records + expected.size;
+	for (i = 0; i < count; i++)
+		_fill_page(data + i * page_size, page_size);
+	expected.size += count * page_size;
+	_expect(data, count, true);
+}
+
+static void _add_lz4(uint32_t count)
+{
+	static uint8_t pages[STAGING_PAGES * MAX_PAGE_SIZE];
+	uint32_t page_size = image.page_size;
+	uint32_t i, len;
+
+	for (i = 0; i < count; i++)
+		_fill_page(pages + i * page_size, page_size);
+
+	_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_LZ4, count));
+	len = _lz4_encode(pages, count * page_size,
+			(uint8_t*)records + expected.size + 4);
+	_put_word(len);
+	expected.size += len;
+
+	/* the padding may be cut from the last record */
+	for (; len & 3; len++) {
+		expected.cuts[expected.ncuts++] = expected.size;
+		((uint8_t*)records)[expected.size++] = 0;
+	}
+	_expect(pages, count, true);
+}
+
+static void _add_fill(uint32_t count, uint32_t value)
+{
+	static uint32_t page[MAX_PAGE_SIZE / 4];
+	uint32_t i;
+
+	_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_FILL, count));
+	_put_word(value);
+	for (i = 0; i < image.page_size / 4; i++)
+		page[i] = value;
+	for (i = 0; i < count; i++) {
+		_expect((uint8_t*)page, 1, true);
+		expected.ncuts--;
+	}
+	expected.cuts[expected.ncuts++] = expected.size;
+}
+
+static void _add_skip(uint32_t count)
+{
+	_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_SKIP, count));
+	_expect(NULL, count, false);
+}
+
+/** Random image of at most max_records records from page offset on */
+static void _build(uint32_t offset, uint32_t max_records)
+{
+	uint32_t n, count;
+
+	_begin(offset);
+	for (n = 1 + rand() % max_records; n; n--) {
+		count = rand() % 13;
+		if (expected.page + count > MAX_PAGES)
+			break;
+		switch (rand() % 4) {
+		case 0:
+			_add_raw(count);
+			break;
+		case 1:
+			_add_lz4(count % (STAGING_PAGES + 1));
+			break;
+		case 2:
+			switch (rand() % 3) {
+			case 0:
+				_add_fill(count, ERASED);
+				break;
+			case 1:
+				_add_fill(count, 0);
+				break;
+			default:
+				_add_fill(count, rand());
+				break;
+			}
+			break;
+		case 3:
+			_add_skip(count);
+			break;
+		}
+	}
+}
+
+static void _check_memory(uint32_t id)
+{
+	uint32_t pages = expected.page;
+
+	CHECK_MEM(mem.programs, expected.programs, pages, id);
+	CHECK_MEM(mem.data, expected.data, pages * image.page_size, id);
+	CHECK_EQ(image.written, expected.written);
+}
+
+static void _guarded_alloc(struct guarded *g, size_t size)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	size = (size + page - 1) / page * page;
+	g->area_size = size + page;
+	g->area = mmap(NULL, g->area_size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (g->area == MAP_FAILED)
+		abort();
+	if (mprotect(g->area, size, PROT_READ | PROT_WRITE))
+		abort();
+	g->end = g->area + size;
+}
+
+static void _guarded_free(struct guarded *g)
+{
+	munmap(g->area, g->area_size);
+}
+
+static uint32_t _random_page_size(void)
+{
+	return (rand() & 1) ? 512 : MAX_PAGE_SIZE;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* Random images, every page shall hold its expected content */
+static void test_write(bool skip_erased, bool async)
+{
+	uint32_t round, offset;
+
+	for (round = 0; round < ROUNDS; round++) {
+		_reset(_random_page_size(), skip_erased, async);
+		offset = rand() % 8;
+		_build(offset, 16);
+		CHECK_EQ(_write((uint8_t*)records, expected.size, offset),
+				APPLET_SUCCESS);
+		CHECK_EQ(image.pages, expected.page - offset);
+		_check_memory(round);
+	}
+}
+
+/* FILL records larger than the staging area, written in several chunks */
+static void test_fill_chunks(void)
+{
+	uint32_t count;
+
+	for (count = 1; count <= 3 * STAGING_PAGES + 1; count++) {
+		_reset(512, true, true);
+		_begin(0);
+		_add_fill(count, 0x12345678);
+		CHECK_EQ(_write((uint8_t*)records, expected.size, 0),
+				APPLET_SUCCESS);
+		CHECK_EQ(mem.starts, (count + STAGING_PAGES - 1) / STAGING_PAGES);
+		_check_memory(count);
+	}
+}
+
+/* Invalid records after a valid one, which shall be written */
+static void test_invalid(void)
+{
+	static const uint8_t bad_block[] = { 0x14, 'a', 0x00, 0x00 };
+	uint8_t *block;
+	uint32_t i, len, run;
+
+	for (i = 0; i < 12; i++) {
+		_reset(512, false, true);
+		_begin(0);
+		_add_fill(1, 0);
+
+		switch (i) {
+		case 0:
+			/* unknown types */
+			_put_word(APPLET_IMAGE_HEADER(0x4, 1));
+			break;
+		case 1:
+			_put_word(APPLET_IMAGE_HEADER(0xf, 0));
+			break;
+		case 2:
+			/* RAW record longer than the records */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_RAW, 2));
+			expected.size += 512;
+			break;
+		case 3:
+			/* RAW page count wrapping to one page once multiplied */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_RAW,
+					0x00800001));
+			expected.size += 512;
+			break;
+		case 4:
+			/* LZ4 record without its size */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_LZ4, 1));
+			break;
+		case 5:
+			/* LZ4 block longer than the records */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_LZ4, 1));
+			_put_word(9);
+			_put_word(0);
+			_put_word(0);
+			break;
+		case 6:
+			/* LZ4 record larger than the staging area */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_LZ4,
+					STAGING_PAGES + 1));
+			memset(staging, 0, sizeof(staging));
+			block = (uint8_t*)records + expected.size + 4;
+			len = _lz4_encode((uint8_t*)staging,
+					(STAGING_PAGES + 1) * 512, block);
+			_put_word(len);
+			expected.size += (len + 3) & ~3u;
+			break;
+		case 7:
+		case 8:
+			/* LZ4 block shorter or longer than its pages */
+			run = i == 7 ? 511 : 513;
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_LZ4, 1));
+			memset(staging, 0, run);
+			block = (uint8_t*)records + expected.size + 4;
+			len = _lz4_encode((uint8_t*)staging, run, block);
+			_put_word(len);
+			expected.size += (len + 3) & ~3u;
+			break;
+		case 9:
+			/* corrupted LZ4 block: offset 0 */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_LZ4, 1));
+			_put_word(sizeof(bad_block));
+			memcpy((uint8_t*)records + expected.size, bad_block,
+					sizeof(bad_block));
+			expected.size += sizeof(bad_block);
+			break;
+		case 10:
+			/* FILL record without its value */
+			_put_word(APPLET_IMAGE_HEADER(APPLET_IMAGE_FILL, 1));
+			break;
+		case 11:
+			/* bytes after the last record */
+			expected.size += 2;
+			break;
+		}
+
+		trace_errors = 0;
+		CHECK_EQ(_write((uint8_t*)records, expected.size, 0),
+				APPLET_FAIL);
+		CHECK_EQ(trace_errors, 1);
+		CHECK_EQ(image.pages, 1);
+		CHECK_EQ(mem.programs[0], 1);
+		CHECK_EQ(mem.programs[1], 0);
+	}
+}
+
+/*
+ * Every prefix of an image is written if it ends at a record boundary and
+ * rejected otherwise. The records are placed against an inaccessible page.
+ */
+static void test_truncated(void)
+{
+	struct guarded g;
+	uint32_t round, cut, i;
+	bool boundary;
+	uint8_t *data;
+
+	_guarded_alloc(&g, MAX_RECORDS_SIZE);
+	for (round = 0; round < 30; round++) {
+		_reset(512, rand() & 1, rand() & 1);
+		_build(0, 6);
+		for (cut = 0; cut <= expected.size; cut++) {
+			_reset(512, ops.skip_erased, ops.wait_write != NULL);
+			data = g.end - cut;
+			memcpy(data, records, cut);
+			boundary = false;
+			for (i = 0; i < expected.ncuts; i++)
+				boundary |= expected.cuts[i] == cut;
+			trace_errors = 0;
+			CHECK_EQ(_write(data, cut, 0) == APPLET_SUCCESS,
+					boundary);
+			CHECK_EQ(trace_errors, !boundary);
+		}
+	}
+	_guarded_free(&g);
+}
+
+/* A failed write stops the walk and its status is returned */
+static void test_write_error(bool async)
+{
+	uint32_t round, starts, n;
+
+	for (round = 0; round < 50; round++) {
+		_reset(512, false, async);
+		_build(0, 8);
+		CHECK_EQ(_write((uint8_t*)records, expected.size, 0),
+				APPLET_SUCCESS);
+		starts = mem.starts;
+
+		for (n = 1; n <= starts; n++) {
+			_reset(512, false, async);
+			mem.fail_start = n;
+			CHECK_EQ(_write((uint8_t*)records, expected.size, 0),
+					APPLET_WRITE_FAIL);
+			CHECK_EQ(mem.starts, n);
+
+			if (!async)
+				continue;
+			_reset(512, false, async);
+			mem.fail_wait = n;
+			CHECK_EQ(_write((uint8_t*)records, expected.size, 0),
+					APPLET_WRITE_FAIL);
+			CHECK_EQ(mem.starts, n);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_write, false, false);
+	RUN_TEST(test_write, false, true);
+	RUN_TEST(test_write, true, false);
+	RUN_TEST(test_write, true, true);
+	RUN_TEST(test_fill_chunks);
+	RUN_TEST(test_invalid);
+	RUN_TEST(test_truncated);
+	RUN_TEST(test_write_error, false);
+	RUN_TEST(test_write_error, true);
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,305 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * lib/lwip/sama5/arch/chksum.c, the LWIP_CHKSUM and LWIP_CHKSUM_COPY
+ * routines of the port, against the byte-wise reference algorithm of lwIP
+ * (LWIP_CHKSUM_ALGORITHM 1, the default before the port had its own).
+ *
+ * Every length up to a few hundred bytes is summed at every start offset
+ * modulo 8, with random data and with carry-heavy data (0xff bytes, and
+ * words just below a carry), up to the longest length lwIP passes. The copy
+ * variant is checked with source and destination of the same and of
+ * different alignments, for the copied bytes and the bytes around them. A
+ * benchmark reports the bytes per cycle of each routine.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "lwip/opt.h"
+#include "lwip/inet_chksum.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Longest length checked at every offset */
+#define SHORT_LENGTHS 300
+
+/** Longest length lwIP passes, u16_t */
+#define MAX_LENGTH 0xffff
+
+/** Guard bytes around the destination of the copies */
+#define GUARD 16
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t src_buf[MAX_LENGTH + 64] __attribute__((aligned(64)));
+static uint8_t dst_buf[MAX_LENGTH + 64 + 2 * GUARD] __attribute__((aligned(64)));
+static uint8_t expected_dst[sizeof(dst_buf)] __attribute__((aligned(64)));
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* lwip_standard_chksum(), LWIP_CHKSUM_ALGORITHM 1, from inet_chksum.c */
+static u16_t _reference_chksum(void *dataptr, u16_t len)
+{
+	u32_t acc;
+	u16_t src;
+	u8_t *octetptr;
+
+	acc = 0;
+	octetptr = (u8_t*)dataptr;
+	while (len > 1) {
+		src = (*octetptr) << 8;
+		octetptr++;
+		src |= (*octetptr);
+		octetptr++;
+		acc += src;
+		len -= 2;
+	}
+	if (len > 0) {
+		src = (*octetptr) << 8;
+		acc += src;
+	}
+	acc = (acc >> 16) + (acc & 0x0000ffffUL);
+	if ((acc & 0xffff0000UL) != 0)
+		acc = (acc >> 16) + (acc & 0x0000ffffUL);
+	return htons((u16_t)acc);
+}
+
+/* Both routines return the same non-inverted sum, 0x0000 included */
+static void _check_sum(uint8_t *data, uint32_t len)
+{
+	u16_t expected = _reference_chksum(data, len);
+	u16_t sum = LWIP_CHKSUM(data, len);
+
+	if (sum != expected) {
+		fprintf(stderr, "offset %u length %u: 0x%04x != 0x%04x\n",
+			(unsigned)((uintptr_t)data & 63), (unsigned)len,
+			sum, expected);
+		host_test_failures++;
+	}
+}
+
+static void _check_copy(uint32_t src_offset, uint32_t dst_offset,
+		uint32_t len)
+{
+	uint8_t *src = src_buf + src_offset;
+	uint8_t *dst = dst_buf + GUARD + dst_offset;
+	u16_t sum;
+
+	memset(dst_buf, 0x5a, sizeof(dst_buf));
+	memcpy(expected_dst, dst_buf, sizeof(dst_buf));
+	memcpy(expected_dst + GUARD + dst_offset, src, len);
+
+	sum = LWIP_CHKSUM_COPY(dst, src, len);
+	CHECK_EQ(sum, _reference_chksum(src, len));
+	CHECK_MEM(dst_buf, expected_dst, sizeof(dst_buf),
+		  (src_offset << 24) | (dst_offset << 16) | len);
+}
+
+static double _elapsed(const struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static uint64_t _cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+
+	/* No portable cycle counter: count nanoseconds */
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* Every short length at every offset, random data */
+static void test_random(void)
+{
+	uint32_t offset, len, i;
+
+	for (i = 0; i < sizeof(src_buf); i++)
+		src_buf[i] = rand();
+	for (offset = 0; offset < 8; offset++)
+		for (len = 0; len <= SHORT_LENGTHS; len++)
+			_check_sum(src_buf + offset, len);
+}
+
+/* Data that makes every addition carry, short and long */
+static void test_carries(void)
+{
+	static const uint8_t patterns[][4] = {
+		{ 0xff, 0xff, 0xff, 0xff },
+		{ 0xff, 0xfe, 0xff, 0xfe },
+		{ 0xfe, 0xff, 0xfe, 0xff },
+		{ 0xff, 0xff, 0xff, 0x00 },
+		{ 0x80, 0x00, 0x80, 0x01 },
+	};
+	static const uint32_t long_lengths[] = {
+		1499, 1500, 4095, 4096, 32767, 65533, 65534, MAX_LENGTH,
+	};
+	uint32_t p, offset, len, i;
+
+	for (p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+		for (i = 0; i < sizeof(src_buf); i++)
+			src_buf[i] = patterns[p][i & 3];
+		for (offset = 0; offset < 8; offset++) {
+			for (len = 0; len <= SHORT_LENGTHS; len++)
+				_check_sum(src_buf + offset, len);
+			for (i = 0; i < sizeof(long_lengths) / sizeof(long_lengths[0]); i++)
+				_check_sum(src_buf + offset, long_lengths[i]);
+		}
+	}
+
+	/* All zero: the sum is 0x0000, not 0xffff */
+	memset(src_buf, 0, sizeof(src_buf));
+	_check_sum(src_buf + 1, 100);
+}
+
+/* Copy and sum, at every pair of source and destination offsets */
+static void test_copy(void)
+{
+	uint32_t src_offset, dst_offset, len, i;
+
+	for (i = 0; i < sizeof(src_buf); i++)
+		src_buf[i] = rand();
+	for (src_offset = 0; src_offset < 4; src_offset++) {
+		for (dst_offset = 0; dst_offset < 4; dst_offset++) {
+			for (len = 0; len <= 80; len++)
+				_check_copy(src_offset, dst_offset, len);
+			_check_copy(src_offset, dst_offset, 1500);
+		}
+	}
+
+	memset(src_buf, 0xff, sizeof(src_buf));
+	_check_copy(1, 1, MAX_LENGTH);
+	_check_copy(2, 1, MAX_LENGTH);
+}
+
+/*----------------------------------------------------------------------------
+ *        Benchmark
+ *----------------------------------------------------------------------------*/
+
+typedef u16_t (*bench_fn_t)(uint8_t *dst, uint8_t *src, u16_t len);
+
+static u16_t _bench_reference(uint8_t *dst, uint8_t *src, u16_t len)
+{
+	return _reference_chksum(src, len);
+}
+
+static u16_t _bench_chksum(uint8_t *dst, uint8_t *src, u16_t len)
+{
+	return LWIP_CHKSUM(src, len);
+}
+
+static u16_t _bench_chksum_copy(uint8_t *dst, uint8_t *src, u16_t len)
+{
+	return LWIP_CHKSUM_COPY(dst, src, len);
+}
+
+/* Bytes per cycle of a routine, for 0.1 s */
+static double _measure(bench_fn_t fn, uint8_t *dst, uint8_t *src, u16_t len)
+{
+	volatile u16_t sink = 0;
+	struct timespec start;
+	uint64_t cycles, bytes = 0;
+	uint32_t i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	cycles = _cycles();
+	do {
+		for (i = 0; i < 64; i++)
+			sink ^= fn(dst, src, len);
+		bytes += 64 * len;
+	} while (_elapsed(&start) < 0.1);
+	cycles = _cycles() - cycles;
+	(void)sink;
+	return (double)bytes / cycles;
+}
+
+/* Bytes per cycle (per TSC tick on x86, per nanosecond elsewhere) over
+ * Ethernet-sized buffers, aligned and not */
+static void benchmark(void)
+{
+	static const uint32_t lengths[] = { 64, 1460 };
+	uint32_t l, offset;
+	double ref, fast, copy;
+
+	for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+		for (offset = 0; offset < 2; offset++) {
+			uint8_t *src = src_buf + offset;
+			uint8_t *dst = dst_buf + offset;
+
+			ref = _measure(_bench_reference, dst, src, lengths[l]);
+			fast = _measure(_bench_chksum, dst, src, lengths[l]);
+			copy = _measure(_bench_chksum_copy, dst, src, lengths[l]);
+			printf("%4u bytes at +%u: reference %.2f, sama5_chksum "
+			       "%.2f (%.1fx), sama5_chksum_copy %.2f bytes/cycle\n",
+			       (unsigned)lengths[l], (unsigned)offset, ref, fast,
+			       fast / ref, copy);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_random);
+	RUN_TEST(test_carries);
+	RUN_TEST(test_copy);
+	benchmark();
+	return HOST_TEST_EXIT();
+}
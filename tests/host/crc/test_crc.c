@@ -0,0 +1,284 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * utils/crc: check values of each algorithm, incremental and unaligned
+ * updates against a bit-wise reference, rejection of algorithms that are not
+ * built in, and throughput of the CRC-8 and CRC-32 against the former
+ * byte-wise compute_crc8().
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "crc.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/* Table of the former compute_crc8(), kept verbatim */
+static const uint8_t old_crc8_table[] =
+{
+	0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,
+	157,195, 33,127,252,162, 64, 30, 95,  1,227,189, 62, 96,130,220,
+	35,125,159,193, 66, 28,254,160,225,191, 93,  3,128,222, 60, 98,
+	190,224,  2, 92,223,129, 99, 61,124, 34,192,158, 29, 67,161,255,
+	70, 24,250,164, 39,121,155,197,132,218, 56,102,229,187, 89,  7,
+	219,133,103, 57,186,228,  6, 88, 25, 71,165,251,120, 38,196,154,
+	101, 59,217,135,  4, 90,184,230,167,249, 27, 69,198,152,122, 36,
+	248,166, 68, 26,153,199, 37,123, 58,100,134,216, 91,  5,231,185,
+	140,210, 48,110,237,179, 81, 15, 78, 16,242,172, 47,113,147,205,
+	17, 79,173,243,112, 46,204,146,211,141,111, 49,178,236, 14, 80,
+	175,241, 19, 77,206,144,114, 44,109, 51,209,143, 12, 82,176,238,
+	50,108,142,208, 83, 13,239,177,240,174, 76, 18,145,207, 45,115,
+	202,148,118, 40,171,245, 23, 73,  8, 86,180,234,105, 55,213,139,
+	87,  9,235,181, 54,104,138,212,149,203, 41,119,244,170, 72, 22,
+	233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,
+	116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/* Global state of the former compute_crc8() */
+static uint8_t old_crc8;
+
+static const char check_string[] = "123456789";
+
+static uint8_t buffer[4096 + 8];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Bit-wise reference of the reflected 32-bit CRCs */
+static uint32_t _reference_crc32(uint32_t poly, const uint8_t* data,
+		uint32_t length)
+{
+	uint32_t crc = 0xffffffff, i;
+
+	while (length--) {
+		crc ^= *data++;
+		for (i = 0; i < 8; i++)
+			crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+	}
+	return crc ^ 0xffffffff;
+}
+
+/* Bit-wise reference of CRC-16/CCITT-FALSE */
+static uint32_t _reference_crc16(const uint8_t* data, uint32_t length)
+{
+	uint16_t crc = 0xffff;
+	uint32_t i;
+
+	while (length--) {
+		crc ^= *data++ << 8;
+		for (i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+static uint32_t _reference(enum _crc_type type, const uint8_t* data,
+		uint32_t length)
+{
+	switch (type) {
+	case CRC_16_CCITT:
+		return _reference_crc16(data, length);
+	case CRC_32:
+		return _reference_crc32(0xEDB88320u, data, length);
+	case CRC_32C:
+		return _reference_crc32(0x82F63B78u, data, length);
+	default:
+		return 0;
+	}
+}
+
+/* The former compute_crc8(): global state, 8-bit length */
+static uint8_t _old_compute_crc8(uint8_t* data, uint8_t length)
+{
+	old_crc8 = 0x00;
+	while (length) {
+		old_crc8 = old_crc8_table[old_crc8 ^ *data];
+		data++;
+		length--;
+	}
+	return old_crc8;
+}
+
+static double _elapsed(const struct timespec* start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static void test_check_value(enum _crc_type type, uint32_t expected)
+{
+	CHECK_EQ(crc_compute(type, check_string, 9), expected);
+}
+
+/* Every alignment and length up to a few slices, and the same data fed in
+ * odd-sized pieces */
+static void test_unaligned(enum _crc_type type)
+{
+	struct _crc_ctx ctx;
+	uint32_t offset, length, done, piece;
+
+	for (offset = 0; offset < 8; offset++) {
+		for (length = 0; length <= 67; length++)
+			CHECK_EQ(crc_compute(type, buffer + offset, length),
+				 _reference(type, buffer + offset, length));
+	}
+
+	crc_init(&ctx, type);
+	for (done = 0, piece = 1; done < 4096; done += piece, piece = piece * 3 % 29 + 1) {
+		if (piece > 4096 - done)
+			piece = 4096 - done;
+		crc_update(&ctx, buffer + 1 + done, piece);
+	}
+	CHECK_EQ(crc_final(&ctx), _reference(type, buffer + 1, 4096));
+}
+
+/* compute_crc8() gives the same result as the former implementation on
+ * every length it accepted */
+static void test_crc8_compat(void)
+{
+	uint32_t offset, length;
+
+	for (offset = 0; offset < 8; offset++) {
+		for (length = 0; length <= 255; length++)
+			CHECK_EQ(compute_crc8(buffer + offset, length),
+				 _old_compute_crc8(buffer + offset, length));
+	}
+}
+
+#if !defined(CONFIG_CRC_16) || !defined(CONFIG_CRC_32) || !defined(CONFIG_CRC_32C)
+/* An algorithm that is not built in is reported, not computed */
+static void test_not_built(enum _crc_type type)
+{
+	struct _crc_ctx ctx;
+
+	CHECK(!crc_init(&ctx, type));
+	crc_update(&ctx, buffer, 64);
+	CHECK_EQ(crc_final(&ctx), 0);
+	CHECK_EQ(crc_compute(type, buffer, 64), 0);
+}
+#endif
+
+/* Throughput over 64 MB: the former compute_crc8(), fed 255-byte pieces as
+ * its 8-bit length requires, then each built-in algorithm. */
+static void benchmark(void)
+{
+	static uint8_t data[1024 * 1024];
+	static const struct {
+		enum _crc_type type;
+		const char* name;
+	} algos[] = {
+		{ CRC_8_MAXIM, "CRC-8" },
+#ifdef CONFIG_CRC_16
+		{ CRC_16_CCITT, "CRC-16" },
+#endif
+#ifdef CONFIG_CRC_32
+		{ CRC_32, "CRC-32" },
+#endif
+#ifdef CONFIG_CRC_32C
+		{ CRC_32C, "CRC-32C" },
+#endif
+	};
+	struct timespec start;
+	volatile uint32_t sink = 0;
+	double old_mbs, mbs;
+	uint32_t i, j, offset;
+
+	memset(data, 0xa5, sizeof(data));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 64; i++) {
+		for (offset = 0; offset + 255 <= sizeof(data); offset += 255)
+			sink ^= _old_compute_crc8(data + offset, 255);
+	}
+	old_mbs = 64 / _elapsed(&start);
+	printf("%-8s former compute_crc8: %.0f MB/s\n", "CRC-8", old_mbs);
+
+	for (j = 0; j < sizeof(algos) / sizeof(algos[0]); j++) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < 64; i++)
+			sink ^= crc_compute(algos[j].type, data, sizeof(data));
+		mbs = 64 / _elapsed(&start);
+		printf("%-8s slices %u: %.0f MB/s (%.1fx former CRC-8)\n",
+		       algos[j].name, CRC_SLICES, mbs, mbs / old_mbs);
+	}
+	(void)sink;
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t i;
+
+	srand(1);
+	for (i = 0; i < sizeof(buffer); i++)
+		buffer[i] = rand();
+
+	RUN_TEST(test_check_value, CRC_8_MAXIM, 0xa1);
+	RUN_TEST(test_crc8_compat);
+#ifdef CONFIG_CRC_16
+	RUN_TEST(test_check_value, CRC_16_CCITT, 0x29b1);
+	RUN_TEST(test_unaligned, CRC_16_CCITT);
+#else
+	RUN_TEST(test_not_built, CRC_16_CCITT);
+#endif
+#ifdef CONFIG_CRC_32
+	RUN_TEST(test_check_value, CRC_32, 0xcbf43926);
+	RUN_TEST(test_unaligned, CRC_32);
+#else
+	RUN_TEST(test_not_built, CRC_32);
+#endif
+#ifdef CONFIG_CRC_32C
+	RUN_TEST(test_check_value, CRC_32C, 0xe3069283);
+	RUN_TEST(test_unaligned, CRC_32C);
+#else
+	RUN_TEST(test_not_built, CRC_32C);
+#endif
+	benchmark();
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,987 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "crypto_sim.h"
+#include "soft_crypto.h"
+
+#include "mutex.h"
+
+#include "misc/cache.h"
+
+#include "peripherals/aes.h"
+#include "peripherals/dma.h"
+#include "peripherals/pmc.h"
+#include "peripherals/sha.h"
+#include "peripherals/tdes.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SIM_CHANNELS   8
+
+/** Longest descriptor list accepted, catches unterminated lists */
+#define SIM_MAX_ITEMS  256
+
+/** Status polls of a flag that never rises before it is reported */
+#define SIM_MAX_POLLS  1000
+
+struct dma_channel {
+	uint8_t src;
+	uint8_t dst;
+	dma_callback_t callback;
+	void *arg;
+	struct dma_xfer_item *list;
+	bool configured;
+	bool running;
+};
+
+/** Engine fed by the DMA */
+struct _sim_engine {
+	uint32_t id;
+	const volatile void *idata;
+	const volatile void *odata;  /* NULL if the engine has no output */
+	/* process the input stream, return the number of output bytes */
+	uint32_t (*process)(const uint8_t *in, uint32_t len, uint8_t *out);
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported variables
+ *----------------------------------------------------------------------------*/
+
+struct _crypto_sim crypto_sim;
+
+Aes crypto_sim_aes;
+Sha crypto_sim_sha;
+Tdes crypto_sim_tdes;
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _cpsr;
+static bool _in_irq;
+static uint64_t _pmc;
+
+static struct dma_channel _channels[SIM_CHANNELS];
+static uint8_t _channel_count;
+
+/** Streams of the transfer being completed */
+static uint8_t *_in;
+static uint8_t *_out;
+static uint32_t _capacity;
+
+static struct {
+	uint32_t mr;
+	struct _soft_aes key;
+	uint32_t key_len;
+	uint8_t iv[16];
+	uint32_t aad_len;
+	uint32_t data_len;
+	uint8_t tag[16];
+	bool tag_ready;
+	uint32_t polls;
+} _aes;
+
+static struct {
+	uint32_t mr;
+	uint8_t key[3][8];
+	struct _soft_des des[3];
+	uint8_t iv[8];
+} _tdes;
+
+static struct {
+	uint32_t mr;
+	struct _soft_sha sha;
+	bool first;
+	bool started;
+} _sha;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _error(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	fprintf(stderr, "crypto_sim: ");
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	crypto_sim.errors++;
+}
+
+static void _xor(uint8_t *out, const uint8_t *a, const uint8_t *b,
+		uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		out[i] = a[i] ^ b[i];
+}
+
+static bool _is_zero(const uint8_t *data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		if (data[i])
+			return false;
+	return true;
+}
+
+/** GCM with tag generation: the zero-padded AAD blocks then the
+ * zero-padded text blocks, sized by AADLENR and CLENR, the counter starting
+ * from IVR = inc32(J0). Returns the padded text. */
+static uint32_t _aes_gcm_process(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+	const bool encrypt = _aes.mr & AES_MR_CIPHER;
+	const uint32_t aad_size = (_aes.aad_len + 15) & ~15u;
+	const uint32_t text_size = (_aes.data_len + 15) & ~15u;
+	const uint8_t *text = in + aad_size;
+	struct _soft_ghash ghash;
+	uint8_t h[16], ctr[16], ks[16];
+	uint32_t pos, n, count;
+	uint8_t i;
+
+	/* Let the driver read whatever tag was computed */
+	_aes.tag_ready = true;
+	_aes.polls = 0;
+
+	if (!(_aes.mr & AES_MR_GTAGEN))
+		_error("AES GCM without GTAGEN not simulated");
+	if (len != aad_size + text_size) {
+		_error("AES GCM input of %u bytes for %u AAD and %u text "
+				"bytes", len, _aes.aad_len, _aes.data_len);
+		return 0;
+	}
+	if (crypto_sim.no_compute)
+		return text_size;
+	if (!_is_zero(in + _aes.aad_len, aad_size - _aes.aad_len) ||
+	    !_is_zero(text + _aes.data_len, text_size - _aes.data_len))
+		_error("AES GCM padding not zero");
+
+	memset(h, 0, sizeof(h));
+	soft_aes_encrypt(&_aes.key, h, h);
+	soft_ghash_init(&ghash, h);
+	soft_ghash_update(&ghash, in, _aes.aad_len);
+
+	/* inc32() on the big-endian low word of the counter */
+	memcpy(ctr, _aes.iv, sizeof(ctr));
+	count = ((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) |
+		((uint32_t)ctr[14] << 8) | ctr[15];
+	for (pos = 0; pos < text_size; pos += 16, count++) {
+		n = _aes.data_len - pos < 16 ? _aes.data_len - pos : 16;
+		for (i = 0; i < 4; i++)
+			ctr[15 - i] = count >> (8 * i);
+		soft_aes_encrypt(&_aes.key, ctr, ks);
+		if (!encrypt)
+			soft_ghash_update(&ghash, text + pos, n);
+		/* The padding bytes of the last block are output too */
+		_xor(out + pos, text + pos, ks, 16);
+		if (encrypt)
+			soft_ghash_update(&ghash, out + pos, n);
+	}
+	soft_ghash_lengths(&ghash, _aes.aad_len, _aes.data_len);
+
+	/* T = GHASH ^ E(K, J0), J0 being the counter before IVR */
+	memcpy(ctr, _aes.iv, sizeof(ctr));
+	count = ((uint32_t)ctr[12] << 24) | ((uint32_t)ctr[13] << 16) |
+		((uint32_t)ctr[14] << 8) | ctr[15];
+	count--;
+	for (i = 0; i < 4; i++)
+		ctr[15 - i] = count >> (8 * i);
+	soft_aes_encrypt(&_aes.key, ctr, ks);
+	soft_ghash_output(&ghash, _aes.tag);
+	_xor(_aes.tag, _aes.tag, ks, 16);
+	return text_size;
+}
+
+static uint32_t _aes_process(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+	const uint32_t mode = _aes.mr & AES_MR_OPMOD_Msk;
+	const bool encrypt = _aes.mr & AES_MR_CIPHER;
+	uint8_t ks[16];
+	uint32_t pos;
+	uint8_t i;
+
+	if ((_aes.mr & AES_MR_SMOD_Msk) != AES_MR_SMOD_IDATAR0_START)
+		_error("AES not in DMA start mode");
+	if (((_aes.mr & AES_MR_KEYSIZE_Msk) >> AES_MR_KEYSIZE_Pos) !=
+	    _aes.key_len / 8 - 2)
+		_error("AES key size field does not match the key");
+	if (len % 16) {
+		_error("AES input of %u bytes", len);
+		return 0;
+	}
+	if (mode == AES_MR_OPMOD_CFB &&
+	    (_aes.mr & AES_MR_CFBS_Msk) != AES_MR_CFBS_SIZE_128BIT)
+		_error("AES CFB segment size not simulated");
+	if (mode == AES_MR_OPMOD_GCM)
+		return _aes_gcm_process(in, len, out);
+	if (crypto_sim.no_compute)
+		return len;
+
+	for (pos = 0; pos < len; pos += 16) {
+		const uint8_t *src = in + pos;
+		uint8_t *dst = out + pos;
+
+		switch (mode) {
+		case AES_MR_OPMOD_ECB:
+			if (encrypt)
+				soft_aes_encrypt(&_aes.key, src, dst);
+			else
+				soft_aes_decrypt(&_aes.key, src, dst);
+			break;
+		case AES_MR_OPMOD_CBC:
+			if (encrypt) {
+				_xor(ks, src, _aes.iv, 16);
+				soft_aes_encrypt(&_aes.key, ks, dst);
+				memcpy(_aes.iv, dst, 16);
+			} else {
+				soft_aes_decrypt(&_aes.key, src, ks);
+				_xor(dst, ks, _aes.iv, 16);
+				memcpy(_aes.iv, src, 16);
+			}
+			break;
+		case AES_MR_OPMOD_OFB:
+			soft_aes_encrypt(&_aes.key, _aes.iv, _aes.iv);
+			_xor(dst, src, _aes.iv, 16);
+			break;
+		case AES_MR_OPMOD_CFB:
+			soft_aes_encrypt(&_aes.key, _aes.iv, ks);
+			if (encrypt) {
+				_xor(dst, src, ks, 16);
+				memcpy(_aes.iv, dst, 16);
+			} else {
+				memcpy(_aes.iv, src, 16);
+				_xor(dst, src, ks, 16);
+			}
+			break;
+		case AES_MR_OPMOD_CTR:
+			soft_aes_encrypt(&_aes.key, _aes.iv, ks);
+			_xor(dst, src, ks, 16);
+			/* 16-bit counter, no carry to the upper bytes */
+			for (i = 15; i >= 14; i--)
+				if (++_aes.iv[i])
+					break;
+			break;
+		default:
+			_error("AES mode 0x%x not simulated", mode);
+			return len;
+		}
+	}
+	return len;
+}
+
+static void _tdes_block(const uint8_t *in, uint8_t *out, bool encrypt)
+{
+	const bool triple = (_tdes.mr & TDES_MR_TDESMOD_Msk) ==
+		TDES_MR_TDESMOD_TRIPLE_DES;
+	/* KEYMOD: two-key mode, K3 = K1 */
+	const struct _soft_des *k3 = (_tdes.mr & TDES_MR_KEYMOD) ?
+		&_tdes.des[0] : &_tdes.des[2];
+
+	if (!triple) {
+		if (encrypt)
+			soft_des_encrypt(&_tdes.des[0], in, out);
+		else
+			soft_des_decrypt(&_tdes.des[0], in, out);
+	} else if (encrypt) {
+		soft_des_encrypt(&_tdes.des[0], in, out);
+		soft_des_decrypt(&_tdes.des[1], out, out);
+		soft_des_encrypt(k3, out, out);
+	} else {
+		soft_des_decrypt(k3, in, out);
+		soft_des_encrypt(&_tdes.des[1], out, out);
+		soft_des_decrypt(&_tdes.des[0], out, out);
+	}
+}
+
+static uint32_t _tdes_process(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+	const uint32_t mode = _tdes.mr & TDES_MR_OPMOD_Msk;
+	const bool encrypt = _tdes.mr & TDES_MR_CIPHER;
+	uint8_t ks[8];
+	uint32_t pos;
+
+	if ((_tdes.mr & TDES_MR_SMOD_Msk) != TDES_MR_SMOD_IDATAR0_START)
+		_error("TDES not in DMA start mode");
+	if ((_tdes.mr & TDES_MR_TDESMOD_Msk) == TDES_MR_TDESMOD_XTEA)
+		_error("XTEA not simulated");
+	if (mode == TDES_MR_OPMOD_CFB &&
+	    (_tdes.mr & TDES_MR_CFBS_Msk) != TDES_MR_CFBS_SIZE_64BIT)
+		_error("TDES CFB segment size not simulated");
+	if (len % 8) {
+		_error("TDES input of %u bytes", len);
+		return 0;
+	}
+	if (crypto_sim.no_compute)
+		return len;
+
+	for (pos = 0; pos < len; pos += 8) {
+		const uint8_t *src = in + pos;
+		uint8_t *dst = out + pos;
+
+		switch (mode) {
+		case TDES_MR_OPMOD_ECB:
+			_tdes_block(src, dst, encrypt);
+			break;
+		case TDES_MR_OPMOD_CBC:
+			if (encrypt) {
+				_xor(ks, src, _tdes.iv, 8);
+				_tdes_block(ks, dst, true);
+				memcpy(_tdes.iv, dst, 8);
+			} else {
+				_tdes_block(src, ks, false);
+				_xor(dst, ks, _tdes.iv, 8);
+				memcpy(_tdes.iv, src, 8);
+			}
+			break;
+		case TDES_MR_OPMOD_OFB:
+			_tdes_block(_tdes.iv, _tdes.iv, true);
+			_xor(dst, src, _tdes.iv, 8);
+			break;
+		case TDES_MR_OPMOD_CFB:
+			_tdes_block(_tdes.iv, ks, true);
+			if (encrypt) {
+				_xor(dst, src, ks, 8);
+				memcpy(_tdes.iv, dst, 8);
+			} else {
+				memcpy(_tdes.iv, src, 8);
+				_xor(dst, src, ks, 8);
+			}
+			break;
+		}
+	}
+	return len;
+}
+
+static uint32_t _sha_process(const uint8_t *in, uint32_t len, uint8_t *out)
+{
+	const uint32_t algo = (_sha.mr & SHA_MR_ALGO_Msk) >> SHA_MR_ALGO_Pos;
+	uint32_t block_size, pos;
+
+	(void)out;
+
+	if ((_sha.mr & SHA_MR_SMOD_Msk) != SHA_MR_SMOD_IDATAR0_START)
+		_error("SHA not in DMA start mode");
+	if (algo > SOFT_SHA224) {
+		_error("SHA algorithm %u not simulated", algo);
+		return 0;
+	}
+	block_size = soft_sha_block_size(algo);
+	if (len % block_size) {
+		_error("SHA input of %u bytes", len);
+		return 0;
+	}
+	if (_sha.first) {
+		soft_sha_init(&_sha.sha, algo);
+		_sha.first = false;
+		_sha.started = true;
+	} else if (!_sha.started) {
+		_error("SHA message started without FIRST");
+	}
+	if (crypto_sim.no_compute)
+		return 0;
+
+	for (pos = 0; pos < len; pos += block_size)
+		soft_sha_block(&_sha.sha, in + pos);
+	return 0;
+}
+
+static const struct _sim_engine _engines[] = {
+	{ ID_AES, crypto_sim_aes.AES_IDATAR, crypto_sim_aes.AES_ODATAR,
+	  _aes_process },
+	{ ID_TDES, crypto_sim_tdes.TDES_IDATAR, crypto_sim_tdes.TDES_ODATAR,
+	  _tdes_process },
+	{ ID_SHA, crypto_sim_sha.SHA_IDATAR, NULL, _sha_process },
+};
+
+static const struct _sim_engine *_get_engine(uint8_t id)
+{
+	uint8_t i;
+
+	for (i = 0; i < ARRAY_SIZE(_engines); i++)
+		if (_engines[i].id == id)
+			return &_engines[i];
+	return NULL;
+}
+
+static struct dma_channel *_find_channel(uint8_t src, uint8_t dst)
+{
+	uint8_t i;
+
+	for (i = 0; i < _channel_count; i++)
+		if (_channels[i].src == src && _channels[i].dst == dst)
+			return &_channels[i];
+	return NULL;
+}
+
+static void _reserve(uint32_t len)
+{
+	if (len <= _capacity)
+		return;
+	_capacity = len * 2;
+	_in = realloc(_in, _capacity);
+	_out = realloc(_out, _capacity);
+	if (!_in || !_out) {
+		fprintf(stderr, "crypto_sim: out of memory\n");
+		exit(1);
+	}
+}
+
+static struct dma_xfer_item *_next_item(const struct dma_xfer_item *item)
+{
+	if (!(item->mbr_ubc & XDMA_UBC_NDE))
+		return NULL;
+	return (struct dma_xfer_item*)item->mbr_nda;
+}
+
+static uint32_t _item_len(const struct dma_xfer_item *item)
+{
+	return (item->mbr_ubc & XDMA_UBC_UBLEN_Msk) * 4;
+}
+
+/** Gather the input of an engine from the list of its input channel */
+static uint32_t _gather(const struct _sim_engine *engine,
+		const struct dma_channel *tx)
+{
+	const struct dma_xfer_item *item;
+	uint32_t len = 0, n, count = 0;
+
+	for (item = tx->list; item; item = _next_item(item)) {
+		if (++count > SIM_MAX_ITEMS) {
+			_error("input list of engine %u too long",
+					engine->id);
+			break;
+		}
+		if (item->mbr_da != engine->idata)
+			_error("input descriptor of engine %u not targeting "
+					"IDATAR0", engine->id);
+		n = _item_len(item);
+		_reserve(len + n);
+		if (!crypto_sim.no_compute)
+			memcpy(_in + len, item->mbr_sa, n);
+		len += n;
+	}
+	crypto_sim.descriptors += count;
+	return len;
+}
+
+/** Scatter the output of an engine through the list of its output channel */
+static void _scatter(const struct _sim_engine *engine,
+		const struct dma_channel *rx, uint32_t len)
+{
+	const struct dma_xfer_item *item;
+	uint32_t pos = 0, n, count = 0;
+
+	for (item = rx->list; item; item = _next_item(item)) {
+		if (++count > SIM_MAX_ITEMS) {
+			_error("output list of engine %u too long",
+					engine->id);
+			break;
+		}
+		if (item->mbr_sa != engine->odata)
+			_error("output descriptor of engine %u not reading "
+					"ODATAR0", engine->id);
+		n = _item_len(item);
+		if (pos + n > len) {
+			_error("output list of engine %u longer than its "
+					"output (%u bytes)", engine->id, len);
+			return;
+		}
+		if (!crypto_sim.no_compute)
+			memcpy(item->mbr_da, _out + pos, n);
+		pos += n;
+	}
+	crypto_sim.descriptors += count;
+	if (pos != len)
+		_error("output list of engine %u covers %u of %u bytes",
+				engine->id, pos, len);
+}
+
+static bool _step_engine(const struct _sim_engine *engine)
+{
+	struct dma_channel *tx = _find_channel(DMA_PERIPH_MEMORY, engine->id);
+	struct dma_channel *rx = _find_channel(engine->id, DMA_PERIPH_MEMORY);
+	dma_callback_t tx_cb, rx_cb = NULL;
+	uint32_t len, out_len;
+
+	if (!tx || !tx->running)
+		return false;
+
+	if (!(_pmc & (1ull << engine->id)))
+		_error("engine %u fed with its clock disabled", engine->id);
+	len = _gather(engine, tx);
+	_reserve(len);
+	out_len = engine->process(_in, len, _out);
+	crypto_sim.transfers++;
+	crypto_sim.bytes += len;
+
+	if (out_len) {
+		if (!rx || !rx->running)
+			_error("output of engine %u not read", engine->id);
+		else
+			_scatter(engine, rx, out_len);
+	} else if (rx && rx->running) {
+		_error("output channel of engine %u started without output",
+				engine->id);
+	}
+
+	/* The channels stop at the end of their lists and raise their
+	 * interrupts, the input one first */
+	tx->running = false;
+	tx_cb = tx->callback;
+	if (rx && out_len) {
+		rx->running = false;
+		rx_cb = rx->callback;
+	}
+	_in_irq = true;
+	_cpsr |= CPSR_MASK_IRQ;
+	if (tx_cb)
+		tx_cb(tx, tx->arg);
+	if (rx_cb)
+		rx_cb(rx, rx->arg);
+	_cpsr &= ~CPSR_MASK_IRQ;
+	_in_irq = false;
+	return true;
+}
+
+/** Complete a transfer in the middle of the queueing of an update */
+static void _interrupt(void)
+{
+	if (crypto_sim.irq_in_queue && !_in_irq)
+		crypto_sim_step();
+}
+
+/*----------------------------------------------------------------------------
+ *        Simulator functions
+ *----------------------------------------------------------------------------*/
+
+void crypto_sim_reset(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < _channel_count; i++) {
+		_channels[i].configured = false;
+		_channels[i].running = false;
+	}
+	memset(&_aes, 0, sizeof(_aes));
+	memset(&_tdes, 0, sizeof(_tdes));
+	memset(&_sha, 0, sizeof(_sha));
+	memset(&crypto_sim, 0, sizeof(crypto_sim));
+	_pmc = 0;
+	_cpsr = 0;
+}
+
+bool crypto_sim_step(void)
+{
+	uint8_t i;
+
+	/* A completion raised with IRQs masked stays pending */
+	if (_cpsr & CPSR_MASK_IRQ)
+		return false;
+	for (i = 0; i < ARRAY_SIZE(_engines); i++)
+		if (_step_engine(&_engines[i]))
+			return true;
+	return false;
+}
+
+bool crypto_sim_is_running(uint32_t id)
+{
+	struct dma_channel *tx = _find_channel(DMA_PERIPH_MEMORY, id);
+
+	return tx && tx->running;
+}
+
+/*----------------------------------------------------------------------------
+ *        Core and PMC
+ *----------------------------------------------------------------------------*/
+
+uint32_t cpsr_get(void)
+{
+	return _cpsr;
+}
+
+void cpsr_set_bits(uint32_t mask)
+{
+	_cpsr |= mask;
+}
+
+void cpsr_clear_bits(uint32_t mask)
+{
+	_cpsr &= ~mask;
+}
+
+int mutex_try_lock(mutex_t* mutex)
+{
+	if (*mutex)
+		return 0;
+	*mutex = 1;
+	return 1;
+}
+
+void mutex_lock(mutex_t* mutex)
+{
+	if (!mutex_try_lock(mutex))
+		_error("deadlock on mutex %p", (void*)mutex);
+}
+
+void mutex_unlock(mutex_t* mutex)
+{
+	if (!*mutex)
+		_error("unlock of a free mutex");
+	*mutex = 0;
+}
+
+int mutex_is_locked(const mutex_t* mutex)
+{
+	return *mutex;
+}
+
+void pmc_enable_peripheral(uint32_t id)
+{
+	_pmc |= 1ull << id;
+}
+
+/*----------------------------------------------------------------------------
+ *        Cache
+ *----------------------------------------------------------------------------*/
+
+void cache_invalidate_region(void *start, uint32_t length)
+{
+	const uintptr_t mask = L1_CACHE_BYTES - 1;
+	const uint8_t *line = (const uint8_t*)((uintptr_t)start & ~mask);
+	const uint8_t *end = (const uint8_t*)
+		(((uintptr_t)start + length + mask) & ~mask);
+	const uint8_t *p;
+
+	if (!length || !crypto_sim.is_live)
+		return;
+	for (p = line; p < end; p++) {
+		if (crypto_sim.is_live(p)) {
+			_error("invalidation of %p+%u drops live data at %p",
+					start, (unsigned)length, p);
+			return;
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        DMA driver
+ *----------------------------------------------------------------------------*/
+
+void dma_poll(void)
+{
+	while (crypto_sim_step());
+}
+
+struct dma_channel *dma_allocate_channel(uint8_t src, uint8_t dest)
+{
+	struct dma_channel *channel;
+
+	if ((src == DMA_PERIPH_MEMORY) == (dest == DMA_PERIPH_MEMORY)) {
+		_error("channel %u to %u not between memory and a peripheral",
+				src, dest);
+		return NULL;
+	}
+	if (_channel_count >= SIM_CHANNELS)
+		return NULL;
+	channel = &_channels[_channel_count++];
+	memset(channel, 0, sizeof(*channel));
+	channel->src = src;
+	channel->dst = dest;
+	return channel;
+}
+
+uint32_t dma_set_callback(struct dma_channel *channel,
+		dma_callback_t callback, void *user_arg)
+{
+	channel->callback = callback;
+	channel->arg = user_arg;
+	return DMA_OK;
+}
+
+uint32_t dma_prepare_item(struct dma_channel *channel,
+		const struct dma_xfer_item_tmpl *tmpl,
+		struct dma_xfer_item *item)
+{
+	const bool input = channel->dst != DMA_PERIPH_MEMORY;
+	const struct _sim_engine *engine =
+		_get_engine(input ? channel->dst : channel->src);
+	const uint32_t chunk = 1u << tmpl->chunk_size;
+
+	if (tmpl->data_width != DMA_DATA_WIDTH_WORD)
+		_error("transfer width %u", tmpl->data_width);
+	if (!tmpl->blk_size || tmpl->blk_size > DMA_MAX_BT_SIZE)
+		_error("microblock of %u words", (unsigned)tmpl->blk_size);
+	/* The peripheral requests chunks, a partial last chunk is never
+	 * requested */
+	if (tmpl->blk_size % chunk)
+		_error("microblock of %u words with chunks of %u",
+				(unsigned)tmpl->blk_size, chunk);
+	if (input && (!tmpl->upd_sa_per_data || tmpl->upd_da_per_data))
+		_error("input descriptor not from memory to register");
+	if (!input && (tmpl->upd_sa_per_data || !tmpl->upd_da_per_data))
+		_error("output descriptor not from register to memory");
+	if (!engine)
+		_error("no engine on channel %u to %u", channel->src,
+				channel->dst);
+	else if ((input && tmpl->da != engine->idata) ||
+		 (!input && tmpl->sa != engine->odata))
+		_error("descriptor not on the data register of engine %u",
+				engine->id);
+	if ((uint32_t)(uintptr_t)(input ? tmpl->sa : tmpl->da) & 3)
+		_error("unaligned memory address %p",
+				input ? tmpl->sa : (const void*)tmpl->da);
+
+	item->mbr_nda = NULL;
+	item->mbr_ubc = XDMA_UBC_UBLEN(tmpl->blk_size) | XDMA_UBC_NVIEW_NDV1;
+	item->mbr_sa = tmpl->sa;
+	item->mbr_da = tmpl->da;
+	_interrupt();
+	return DMA_OK;
+}
+
+uint32_t dma_link_item(struct dma_channel *channel,
+		struct dma_xfer_item *item, struct dma_xfer_item *next_item)
+{
+	(void)channel;
+
+	item->mbr_nda = next_item;
+	if (next_item)
+		item->mbr_ubc |= XDMA_UBC_NDE_FETCH_EN | XDMA_UBC_NSEN_UPDATED |
+			XDMA_UBC_NDEN_UPDATED;
+	else
+		item->mbr_ubc &= ~(XDMA_UBC_NDE | XDMA_UBC_NSEN |
+				XDMA_UBC_NDEN);
+
+	_interrupt();
+	return DMA_OK;
+}
+
+uint32_t dma_configure_sg_transfer(struct dma_channel *channel,
+		struct dma_xfer_item_tmpl *tmpl,
+		struct dma_xfer_item *desc_list)
+{
+	if (channel->running)
+		_error("reconfiguration of a running channel");
+	if (tmpl->sa != desc_list->mbr_sa || tmpl->da != desc_list->mbr_da ||
+	    tmpl->blk_size != (desc_list->mbr_ubc & XDMA_UBC_UBLEN_Msk))
+		_error("template does not match the first descriptor");
+	channel->list = desc_list;
+	channel->configured = true;
+	return DMA_OK;
+}
+
+uint32_t dma_start_transfer(struct dma_channel *channel)
+{
+	if (!channel->configured) {
+		_error("start of an unconfigured channel");
+		return DMA_ERROR;
+	}
+	if (channel->running) {
+		_error("start of a running channel");
+		return DMA_ERROR;
+	}
+	channel->running = true;
+	if (channel->dst != DMA_PERIPH_MEMORY) {
+		if (_in_irq)
+			crypto_sim.irq_starts++;
+		else
+			crypto_sim.thread_starts++;
+	}
+	return DMA_OK;
+}
+
+uint32_t dma_stop_transfer(struct dma_channel *channel)
+{
+	channel->running = false;
+	channel->configured = false;
+	return DMA_OK;
+}
+
+/*----------------------------------------------------------------------------
+ *        AES driver
+ *----------------------------------------------------------------------------*/
+
+void aes_soft_reset(void)
+{
+	memset(&_aes, 0, sizeof(_aes));
+}
+
+void aes_configure(uint32_t mode)
+{
+	_aes.mr = mode;
+}
+
+uint32_t aes_get_status(void)
+{
+	uint32_t status = AES_ISR_DATRDY;
+
+	if (_aes.tag_ready) {
+		status |= AES_ISR_TAGRDY;
+	} else if (++_aes.polls == SIM_MAX_POLLS) {
+		/* Report the wait and let it end */
+		_error("AES tag never ready");
+		_aes.tag_ready = true;
+	}
+	return status;
+}
+
+void aes_write_key(const uint32_t *key, uint32_t len)
+{
+	if (len != 16 && len != 24 && len != 32) {
+		_error("AES key of %u bytes", len);
+		return;
+	}
+	_aes.key_len = len;
+	crypto_sim.aes_keys++;
+	soft_aes_set_key(&_aes.key, (const uint8_t*)key, len);
+}
+
+void aes_set_vector(const uint32_t *vector)
+{
+	/* A new GCM message starts, its tag is not ready before its
+	 * transfer */
+	memcpy(_aes.iv, vector, 16);
+	_aes.tag_ready = false;
+	_aes.polls = 0;
+}
+
+void aes_set_aad_len(uint32_t len)
+{
+	_aes.aad_len = len;
+}
+
+void aes_set_data_len(uint32_t len)
+{
+	_aes.data_len = len;
+}
+
+void aes_get_gcm_tag(uint32_t *tag)
+{
+	memcpy(tag, _aes.tag, 16);
+}
+
+void aes_get_gcm_hash_subkey(uint32_t *h)
+{
+	const uint8_t zero[16] = { 0 };
+
+	soft_aes_encrypt(&_aes.key, zero, (uint8_t*)h);
+}
+
+/*----------------------------------------------------------------------------
+ *        TDES driver
+ *----------------------------------------------------------------------------*/
+
+static void _tdes_write_key(uint8_t index, uint32_t word0, uint32_t word1)
+{
+	memcpy(_tdes.key[index], &word0, 4);
+	memcpy(_tdes.key[index] + 4, &word1, 4);
+	soft_des_set_key(&_tdes.des[index], _tdes.key[index]);
+}
+
+void tdes_soft_reset(void)
+{
+	memset(&_tdes, 0, sizeof(_tdes));
+}
+
+void tdes_configure(uint32_t mode)
+{
+	_tdes.mr = mode;
+}
+
+void tdes_write_key1(uint32_t key_word0, uint32_t key_word1)
+{
+	_tdes_write_key(0, key_word0, key_word1);
+}
+
+void tdes_write_key2(uint32_t key_word0, uint32_t key_word1)
+{
+	_tdes_write_key(1, key_word0, key_word1);
+}
+
+void tdes_write_key3(uint32_t key_word0, uint32_t key_word1)
+{
+	_tdes_write_key(2, key_word0, key_word1);
+}
+
+void tdes_set_vector(uint32_t v0, uint32_t v1)
+{
+	memcpy(_tdes.iv, &v0, 4);
+	memcpy(_tdes.iv + 4, &v1, 4);
+}
+
+/*----------------------------------------------------------------------------
+ *        SHA driver
+ *----------------------------------------------------------------------------*/
+
+void sha_soft_reset(void)
+{
+	memset(&_sha, 0, sizeof(_sha));
+}
+
+void sha_configure(uint32_t mode)
+{
+	_sha.mr = mode;
+}
+
+void sha_first_block(void)
+{
+	_sha.first = true;
+}
+
+uint32_t sha_get_status(void)
+{
+	return SHA_ISR_DATRDY;
+}
+
+void sha_get_output(uint32_t *data)
+{
+	soft_sha_output(&_sha.sha, (uint8_t*)data);
+}
+
+uint8_t sha_get_dma_chunk_size(uint8_t mode)
+{
+	/* SAMA5D2 and SAMA5D4 */
+	return mode <= SHA_224 ? DMA_CHUNK_SIZE_16 : 0;
+}
@@ -0,0 +1,118 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Software backend of cryptod.c: the AES, TDES and SHA engines and the DMA
+ * controller feeding them, implemented with the functions of the peripheral
+ * drivers (aes_*, tdes_*, sha_*, dma_*) and the algorithms of
+ * soft_crypto.c.
+ *
+ * Transfers run when the test steps the simulator, which stands for the
+ * hardware progressing between two instructions of the thread: a step takes
+ * the descriptor list of the running input channel of an engine, feeds the
+ * engine, writes its output through the list of the output channel and
+ * invokes the completion callbacks as the DMA interrupt would, with IRQs
+ * masked. dma_poll() runs the transfers until none is left.
+ *
+ * The AES engine runs GCM with tag generation over one transfer per message,
+ * the GHASH being computed by the software fallback of soft_crypto.c. The
+ * tag is ready once the transfer completes and until the next IV is written.
+ *
+ * Cache invalidations operate on whole L1_CACHE_BYTES lines, as on the
+ * target. A line holding a byte for which the is_live hook of the test
+ * returns true, data of the CPU that no DMA writes, would be lost.
+ *
+ * Misuse of the hardware by the driver (wrong register, overlong or
+ * truncated lists, missing output channel, restart of a running channel,
+ * GCM lengths not matching the transfer, non-zero GCM padding, loss of live
+ * data by a cache invalidation...) is reported on stderr and counted in
+ * crypto_sim.errors.
+ */
+
+#ifndef _CRYPTO_SIM_H_
+#define _CRYPTO_SIM_H_
+
+#include "chip.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Simulator state */
+struct _crypto_sim {
+	/* Behaviour */
+	bool irq_in_queue;      /**< run one transfer from dma_prepare_item()
+	                             and dma_link_item() if IRQs are enabled,
+	                             as a completion interrupting the queueing
+	                             of an update */
+	bool no_compute;        /**< the DMA and the engines leave the data
+	                             untouched, to measure the cost of the
+	                             driver */
+	bool (*is_live)(const uint8_t *addr);
+	                        /**< whether the CPU holds data at an address,
+	                             checked on cache invalidations, may be
+	                             NULL */
+
+	/* Counters */
+	uint32_t errors;        /**< misuses of the hardware */
+	uint32_t transfers;     /**< input transfers completed */
+	uint32_t descriptors;   /**< descriptors executed, input and output */
+	uint64_t bytes;         /**< bytes fed to the engines */
+	uint32_t thread_starts; /**< input transfers started by the thread */
+	uint32_t irq_starts;    /**< input transfers started from a DMA
+	                             completion */
+	uint32_t aes_keys;      /**< keys written to the AES engine */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported symbols
+ *----------------------------------------------------------------------------*/
+
+extern struct _crypto_sim crypto_sim;
+
+/**
+ * \brief Reset the engines and the counters. DMA channels stay allocated,
+ * transfers in progress are dropped.
+ */
+extern void crypto_sim_reset(void);
+
+/**
+ * \brief Complete the running transfer of one engine.
+ * \return false if no transfer is running.
+ */
+extern bool crypto_sim_step(void);
+
+/**
+ * \brief Check whether the input channel of an engine is running.
+ * \param id  Peripheral ID of the engine.
+ */
+extern bool crypto_sim_is_running(uint32_t id);
+
+#endif /* _CRYPTO_SIM_H_ */
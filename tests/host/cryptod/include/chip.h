@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host replacement of the chip header for cryptod.c: the AES, SHA, TDES and
+ * XDMAC register definitions of the SAMA5D2, with the engines mapped on the
+ * register blocks of the simulator (see crypto_sim.h).
+ */
+
+#ifndef _CHIP_H_
+#define _CHIP_H_
+
+#include "compiler.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define __I  volatile const
+#define __O  volatile
+#define __IO volatile
+
+#define L1_CACHE_BYTES      (32u)
+
+#include "component/component_aes.h"
+#include "component/component_sha.h"
+#include "component/component_tdes.h"
+#include "component/component_xdmac.h"
+
+#include "core/arm_cpsr.h"
+
+#define ID_AES              (9)
+#define ID_TDES             (11)
+#define ID_SHA              (12)
+
+extern Aes crypto_sim_aes;
+extern Sha crypto_sim_sha;
+extern Tdes crypto_sim_tdes;
+
+#define AES                 (&crypto_sim_aes)
+#define SHA                 (&crypto_sim_sha)
+#define TDES                (&crypto_sim_tdes)
+
+static inline void dsb(void)
+{
+	COMPILER_BARRIER();
+}
+
+#endif /* _CHIP_H_ */
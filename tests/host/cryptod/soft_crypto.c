@@ -0,0 +1,811 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "soft_crypto.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/* DES permutations, 1-based bit numbers counted from the MSB */
+
+static const uint8_t _des_ip[64] = {
+	58, 50, 42, 34, 26, 18, 10, 2, 60, 52, 44, 36, 28, 20, 12, 4,
+	62, 54, 46, 38, 30, 22, 14, 6, 64, 56, 48, 40, 32, 24, 16, 8,
+	57, 49, 41, 33, 25, 17, 9, 1, 59, 51, 43, 35, 27, 19, 11, 3,
+	61, 53, 45, 37, 29, 21, 13, 5, 63, 55, 47, 39, 31, 23, 15, 7,
+};
+
+static const uint8_t _des_fp[64] = {
+	40, 8, 48, 16, 56, 24, 64, 32, 39, 7, 47, 15, 55, 23, 63, 31,
+	38, 6, 46, 14, 54, 22, 62, 30, 37, 5, 45, 13, 53, 21, 61, 29,
+	36, 4, 44, 12, 52, 20, 60, 28, 35, 3, 43, 11, 51, 19, 59, 27,
+	34, 2, 42, 10, 50, 18, 58, 26, 33, 1, 41, 9, 49, 17, 57, 25,
+};
+
+static const uint8_t _des_e[48] = {
+	32, 1, 2, 3, 4, 5, 4, 5, 6, 7, 8, 9,
+	8, 9, 10, 11, 12, 13, 12, 13, 14, 15, 16, 17,
+	16, 17, 18, 19, 20, 21, 20, 21, 22, 23, 24, 25,
+	24, 25, 26, 27, 28, 29, 28, 29, 30, 31, 32, 1,
+};
+
+static const uint8_t _des_p[32] = {
+	16, 7, 20, 21, 29, 12, 28, 17, 1, 15, 23, 26, 5, 18, 31, 10,
+	2, 8, 24, 14, 32, 27, 3, 9, 19, 13, 30, 6, 22, 11, 4, 25,
+};
+
+static const uint8_t _des_pc1[56] = {
+	57, 49, 41, 33, 25, 17, 9, 1, 58, 50, 42, 34, 26, 18,
+	10, 2, 59, 51, 43, 35, 27, 19, 11, 3, 60, 52, 44, 36,
+	63, 55, 47, 39, 31, 23, 15, 7, 62, 54, 46, 38, 30, 22,
+	14, 6, 61, 53, 45, 37, 29, 21, 13, 5, 28, 20, 12, 4,
+};
+
+static const uint8_t _des_pc2[48] = {
+	14, 17, 11, 24, 1, 5, 3, 28, 15, 6, 21, 10,
+	23, 19, 12, 4, 26, 8, 16, 7, 27, 20, 13, 2,
+	41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48,
+	44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32,
+};
+
+static const uint8_t _des_shifts[16] = {
+	1, 1, 2, 2, 2, 2, 2, 2, 1, 2, 2, 2, 2, 2, 2, 1,
+};
+
+static const uint8_t _des_sbox[8][64] = {
+	{ 14, 4, 13, 1, 2, 15, 11, 8, 3, 10, 6, 12, 5, 9, 0, 7,
+	  0, 15, 7, 4, 14, 2, 13, 1, 10, 6, 12, 11, 9, 5, 3, 8,
+	  4, 1, 14, 8, 13, 6, 2, 11, 15, 12, 9, 7, 3, 10, 5, 0,
+	  15, 12, 8, 2, 4, 9, 1, 7, 5, 11, 3, 14, 10, 0, 6, 13 },
+	{ 15, 1, 8, 14, 6, 11, 3, 4, 9, 7, 2, 13, 12, 0, 5, 10,
+	  3, 13, 4, 7, 15, 2, 8, 14, 12, 0, 1, 10, 6, 9, 11, 5,
+	  0, 14, 7, 11, 10, 4, 13, 1, 5, 8, 12, 6, 9, 3, 2, 15,
+	  13, 8, 10, 1, 3, 15, 4, 2, 11, 6, 7, 12, 0, 5, 14, 9 },
+	{ 10, 0, 9, 14, 6, 3, 15, 5, 1, 13, 12, 7, 11, 4, 2, 8,
+	  13, 7, 0, 9, 3, 4, 6, 10, 2, 8, 5, 14, 12, 11, 15, 1,
+	  13, 6, 4, 9, 8, 15, 3, 0, 11, 1, 2, 12, 5, 10, 14, 7,
+	  1, 10, 13, 0, 6, 9, 8, 7, 4, 15, 14, 3, 11, 5, 2, 12 },
+	{ 7, 13, 14, 3, 0, 6, 9, 10, 1, 2, 8, 5, 11, 12, 4, 15,
+	  13, 8, 11, 5, 6, 15, 0, 3, 4, 7, 2, 12, 1, 10, 14, 9,
+	  10, 6, 9, 0, 12, 11, 7, 13, 15, 1, 3, 14, 5, 2, 8, 4,
+	  3, 15, 0, 6, 10, 1, 13, 8, 9, 4, 5, 11, 12, 7, 2, 14 },
+	{ 2, 12, 4, 1, 7, 10, 11, 6, 8, 5, 3, 15, 13, 0, 14, 9,
+	  14, 11, 2, 12, 4, 7, 13, 1, 5, 0, 15, 10, 3, 9, 8, 6,
+	  4, 2, 1, 11, 10, 13, 7, 8, 15, 9, 12, 5, 6, 3, 0, 14,
+	  11, 8, 12, 7, 1, 14, 2, 13, 6, 15, 0, 9, 10, 4, 5, 3 },
+	{ 12, 1, 10, 15, 9, 2, 6, 8, 0, 13, 3, 4, 14, 7, 5, 11,
+	  10, 15, 4, 2, 7, 12, 9, 5, 6, 1, 13, 14, 0, 11, 3, 8,
+	  9, 14, 15, 5, 2, 8, 12, 3, 7, 0, 4, 10, 1, 13, 11, 6,
+	  4, 3, 2, 12, 9, 5, 15, 10, 11, 14, 1, 7, 6, 0, 8, 13 },
+	{ 4, 11, 2, 14, 15, 0, 8, 13, 3, 12, 9, 7, 5, 10, 6, 1,
+	  13, 0, 11, 7, 4, 9, 1, 10, 14, 3, 5, 12, 2, 15, 8, 6,
+	  1, 4, 11, 13, 12, 3, 7, 14, 10, 15, 6, 8, 0, 5, 9, 2,
+	  6, 11, 13, 8, 1, 4, 10, 7, 9, 5, 0, 15, 14, 2, 3, 12 },
+	{ 13, 2, 8, 4, 6, 15, 11, 1, 10, 9, 3, 14, 5, 0, 12, 7,
+	  1, 15, 13, 8, 10, 3, 7, 4, 12, 5, 6, 11, 0, 14, 9, 2,
+	  7, 11, 4, 1, 9, 12, 14, 2, 0, 6, 10, 13, 15, 3, 5, 8,
+	  2, 1, 14, 7, 4, 10, 8, 13, 15, 12, 9, 0, 3, 5, 6, 11 },
+};
+
+static const uint32_t _sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static const uint64_t _sha512_k[80] = {
+	0x428a2f98d728ae22ull, 0x7137449123ef65cdull,
+	0xb5c0fbcfec4d3b2full, 0xe9b5dba58189dbbcull,
+	0x3956c25bf348b538ull, 0x59f111f1b605d019ull,
+	0x923f82a4af194f9bull, 0xab1c5ed5da6d8118ull,
+	0xd807aa98a3030242ull, 0x12835b0145706fbeull,
+	0x243185be4ee4b28cull, 0x550c7dc3d5ffb4e2ull,
+	0x72be5d74f27b896full, 0x80deb1fe3b1696b1ull,
+	0x9bdc06a725c71235ull, 0xc19bf174cf692694ull,
+	0xe49b69c19ef14ad2ull, 0xefbe4786384f25e3ull,
+	0x0fc19dc68b8cd5b5ull, 0x240ca1cc77ac9c65ull,
+	0x2de92c6f592b0275ull, 0x4a7484aa6ea6e483ull,
+	0x5cb0a9dcbd41fbd4ull, 0x76f988da831153b5ull,
+	0x983e5152ee66dfabull, 0xa831c66d2db43210ull,
+	0xb00327c898fb213full, 0xbf597fc7beef0ee4ull,
+	0xc6e00bf33da88fc2ull, 0xd5a79147930aa725ull,
+	0x06ca6351e003826full, 0x142929670a0e6e70ull,
+	0x27b70a8546d22ffcull, 0x2e1b21385c26c926ull,
+	0x4d2c6dfc5ac42aedull, 0x53380d139d95b3dfull,
+	0x650a73548baf63deull, 0x766a0abb3c77b2a8ull,
+	0x81c2c92e47edaee6ull, 0x92722c851482353bull,
+	0xa2bfe8a14cf10364ull, 0xa81a664bbc423001ull,
+	0xc24b8b70d0f89791ull, 0xc76c51a30654be30ull,
+	0xd192e819d6ef5218ull, 0xd69906245565a910ull,
+	0xf40e35855771202aull, 0x106aa07032bbd1b8ull,
+	0x19a4c116b8d2d0c8ull, 0x1e376c085141ab53ull,
+	0x2748774cdf8eeb99ull, 0x34b0bcb5e19b48a8ull,
+	0x391c0cb3c5c95a63ull, 0x4ed8aa4ae3418acbull,
+	0x5b9cca4f7763e373ull, 0x682e6ff3d6b2b8a3ull,
+	0x748f82ee5defb2fcull, 0x78a5636f43172f60ull,
+	0x84c87814a1f0ab72ull, 0x8cc702081a6439ecull,
+	0x90befffa23631e28ull, 0xa4506cebde82bde9ull,
+	0xbef9a3f7b2c67915ull, 0xc67178f2e372532bull,
+	0xca273eceea26619cull, 0xd186b8c721c0c207ull,
+	0xeada7dd6cde0eb1eull, 0xf57d4f7fee6ed178ull,
+	0x06f067aa72176fbaull, 0x0a637dc5a2c898a6ull,
+	0x113f9804bef90daeull, 0x1b710b35131c471bull,
+	0x28db77f523047d84ull, 0x32caab7b40c72493ull,
+	0x3c9ebe0a15c9bebcull, 0x431d67c49c100d4cull,
+	0x4cc5d4becb3e42b6ull, 0x597f299cfc657e2aull,
+	0x5fcb6fab3ad6faecull, 0x6c44198c4a475817ull,
+};
+
+static const uint32_t _sha1_iv[5] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+};
+
+static const uint32_t _sha224_iv[8] = {
+	0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939,
+	0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4,
+};
+
+static const uint32_t _sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+static const uint64_t _sha384_iv[8] = {
+	0xcbbb9d5dc1059ed8ull, 0x629a292a367cd507ull,
+	0x9159015a3070dd17ull, 0x152fecd8f70e5939ull,
+	0x67332667ffc00b31ull, 0x8eb44a8768581511ull,
+	0xdb0c2e0d64f98fa7ull, 0x47b5481dbefa4fa4ull,
+};
+
+static const uint64_t _sha512_iv[8] = {
+	0x6a09e667f3bcc908ull, 0xbb67ae8584caa73bull,
+	0x3c6ef372fe94f82bull, 0xa54ff53a5f1d36f1ull,
+	0x510e527fade682d1ull, 0x9b05688c2b3e6c1full,
+	0x1f83d9abfb41bd6bull, 0x5be0cd19137e2179ull,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** AES S-boxes and round tables, computed on first use */
+static uint8_t _sbox[256];
+static uint8_t _inv_sbox[256];
+static uint32_t _te[256];
+static uint32_t _td[256];
+static bool _aes_ready;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _ror32(uint32_t x, uint8_t n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+static uint64_t _ror64(uint64_t x, uint8_t n)
+{
+	return (x >> n) | (x << (64 - n));
+}
+
+static uint32_t _get_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+		((uint32_t)p[2] << 8) | p[3];
+}
+
+static void _put_be32(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+}
+
+static uint64_t _get_be64(const uint8_t *p)
+{
+	return ((uint64_t)_get_be32(p) << 32) | _get_be32(p + 4);
+}
+
+static void _put_be64(uint8_t *p, uint64_t v)
+{
+	_put_be32(p, v >> 32);
+	_put_be32(p + 4, v);
+}
+
+/** Multiply the running GHASH by H in GF(2^128), bits reflected as per
+ * NIST SP 800-38D */
+static void _ghash_mul(struct _soft_ghash *ghash)
+{
+	uint64_t z[2] = { 0, 0 };
+	uint64_t v[2] = { ghash->h[0], ghash->h[1] };
+	uint64_t lsb;
+	uint8_t i;
+
+	for (i = 0; i < 128; i++) {
+		if ((ghash->y[i >> 6] >> (63 - (i & 63))) & 1) {
+			z[0] ^= v[0];
+			z[1] ^= v[1];
+		}
+		lsb = v[1] & 1;
+		v[1] = (v[1] >> 1) | (v[0] << 63);
+		v[0] >>= 1;
+		if (lsb)
+			v[0] ^= 0xe1ull << 56;
+	}
+	ghash->y[0] = z[0];
+	ghash->y[1] = z[1];
+}
+
+/** Multiply in GF(2^8) modulo x^8 + x^4 + x^3 + x + 1 */
+static uint8_t _gf256_mul(uint8_t a, uint8_t b)
+{
+	uint8_t r = 0;
+
+	while (b) {
+		if (b & 1)
+			r ^= a;
+		a = (a << 1) ^ (a & 0x80 ? 0x1b : 0);
+		b >>= 1;
+	}
+	return r;
+}
+
+static void _aes_tables(void)
+{
+	uint8_t p = 1, q = 1, x;
+	uint32_t i;
+
+	if (_aes_ready)
+		return;
+
+	/* p walks the multiplicative group by powers of 3, q = 1/p */
+	do {
+		p = p ^ (p << 1) ^ (p & 0x80 ? 0x1b : 0);
+		q ^= q << 1;
+		q ^= q << 2;
+		q ^= q << 4;
+		if (q & 0x80)
+			q ^= 0x09;
+		x = q ^ (q << 1 | q >> 7) ^ (q << 2 | q >> 6) ^
+			(q << 3 | q >> 5) ^ (q << 4 | q >> 4);
+		_sbox[p] = x ^ 0x63;
+	} while (p != 1);
+	_sbox[0] = 0x63;
+
+	for (i = 0; i < 256; i++) {
+		const uint8_t s = _sbox[i];
+
+		_inv_sbox[s] = i;
+		_te[i] = ((uint32_t)_gf256_mul(s, 2) << 24) |
+			((uint32_t)s << 16) | ((uint32_t)s << 8) |
+			_gf256_mul(s, 3);
+	}
+	for (i = 0; i < 256; i++) {
+		const uint8_t s = _inv_sbox[i];
+
+		_td[i] = ((uint32_t)_gf256_mul(s, 14) << 24) |
+			((uint32_t)_gf256_mul(s, 9) << 16) |
+			((uint32_t)_gf256_mul(s, 13) << 8) |
+			_gf256_mul(s, 11);
+	}
+	_aes_ready = true;
+}
+
+static uint32_t _sub_word(uint32_t w)
+{
+	return ((uint32_t)_sbox[w >> 24] << 24) |
+		((uint32_t)_sbox[(w >> 16) & 0xff] << 16) |
+		((uint32_t)_sbox[(w >> 8) & 0xff] << 8) |
+		_sbox[w & 0xff];
+}
+
+static uint32_t _inv_mix_column(uint32_t w)
+{
+	return _td[_sbox[w >> 24]] ^
+		_ror32(_td[_sbox[(w >> 16) & 0xff]], 8) ^
+		_ror32(_td[_sbox[(w >> 8) & 0xff]], 16) ^
+		_ror32(_td[_sbox[w & 0xff]], 24);
+}
+
+static uint64_t _permute(uint64_t in, uint8_t in_bits, const uint8_t *table,
+		uint8_t count)
+{
+	uint64_t out = 0;
+	uint8_t i;
+
+	for (i = 0; i < count; i++)
+		out = (out << 1) | ((in >> (in_bits - table[i])) & 1);
+	return out;
+}
+
+static uint32_t _des_f(uint32_t r, uint64_t subkey)
+{
+	const uint64_t x = _permute(r, 32, _des_e, 48) ^ subkey;
+	uint32_t out = 0;
+	uint8_t i, b;
+
+	for (i = 0; i < 8; i++) {
+		b = (x >> (42 - 6 * i)) & 0x3f;
+		out = (out << 4) |
+			_des_sbox[i][(b & 0x20) | ((b & 1) << 4) |
+				((b >> 1) & 0xf)];
+	}
+	return _permute(out, 32, _des_p, 32);
+}
+
+static void _des_crypt(const struct _soft_des *des, const uint8_t *in,
+		uint8_t *out, bool decrypt)
+{
+	uint64_t block = _permute(_get_be64(in), 64, _des_ip, 64);
+	uint32_t l = block >> 32, r = block, t;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++) {
+		t = r;
+		r = l ^ _des_f(r, des->sk[decrypt ? 15 - i : i]);
+		l = t;
+	}
+	block = ((uint64_t)r << 32) | l;
+	_put_be64(out, _permute(block, 64, _des_fp, 64));
+}
+
+static void _sha1_block(uint32_t *h, const uint8_t *block)
+{
+	uint32_t w[80], a, b, c, d, e, f, k, t;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = _get_be32(block + 4 * i);
+	for (; i < 80; i++)
+		w[i] = _ror32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 31);
+
+	a = h[0];
+	b = h[1];
+	c = h[2];
+	d = h[3];
+	e = h[4];
+	for (i = 0; i < 80; i++) {
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5a827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ed9eba1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8f1bbcdc;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xca62c1d6;
+		}
+		t = _ror32(a, 27) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = _ror32(b, 2);
+		b = a;
+		a = t;
+	}
+	h[0] += a;
+	h[1] += b;
+	h[2] += c;
+	h[3] += d;
+	h[4] += e;
+}
+
+static void _sha256_block(uint32_t *h, const uint8_t *block)
+{
+	uint32_t w[64], v[8], s0, s1, t1, t2;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = _get_be32(block + 4 * i);
+	for (; i < 64; i++) {
+		s0 = _ror32(w[i - 15], 7) ^ _ror32(w[i - 15], 18) ^
+			(w[i - 15] >> 3);
+		s1 = _ror32(w[i - 2], 17) ^ _ror32(w[i - 2], 19) ^
+			(w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	memcpy(v, h, sizeof(v));
+	for (i = 0; i < 64; i++) {
+		s1 = _ror32(v[4], 6) ^ _ror32(v[4], 11) ^ _ror32(v[4], 25);
+		t1 = v[7] + s1 + ((v[4] & v[5]) ^ (~v[4] & v[6])) +
+			_sha256_k[i] + w[i];
+		s0 = _ror32(v[0], 2) ^ _ror32(v[0], 13) ^ _ror32(v[0], 22);
+		t2 = s0 + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		memmove(v + 1, v, 7 * sizeof(v[0]));
+		v[4] += t1;
+		v[0] = t1 + t2;
+	}
+	for (i = 0; i < 8; i++)
+		h[i] += v[i];
+}
+
+static void _sha512_block(uint64_t *h, const uint8_t *block)
+{
+	uint64_t w[80], v[8], s0, s1, t1, t2;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++)
+		w[i] = _get_be64(block + 8 * i);
+	for (; i < 80; i++) {
+		s0 = _ror64(w[i - 15], 1) ^ _ror64(w[i - 15], 8) ^
+			(w[i - 15] >> 7);
+		s1 = _ror64(w[i - 2], 19) ^ _ror64(w[i - 2], 61) ^
+			(w[i - 2] >> 6);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	memcpy(v, h, sizeof(v));
+	for (i = 0; i < 80; i++) {
+		s1 = _ror64(v[4], 14) ^ _ror64(v[4], 18) ^ _ror64(v[4], 41);
+		t1 = v[7] + s1 + ((v[4] & v[5]) ^ (~v[4] & v[6])) +
+			_sha512_k[i] + w[i];
+		s0 = _ror64(v[0], 28) ^ _ror64(v[0], 34) ^ _ror64(v[0], 39);
+		t2 = s0 + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+		memmove(v + 1, v, 7 * sizeof(v[0]));
+		v[4] += t1;
+		v[0] = t1 + t2;
+	}
+	for (i = 0; i < 8; i++)
+		h[i] += v[i];
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void soft_aes_set_key(struct _soft_aes *aes, const uint8_t *key, uint32_t len)
+{
+	const uint32_t nk = len / 4;
+	uint32_t i, words, t;
+	uint8_t rcon = 1;
+
+	_aes_tables();
+	aes->rounds = nk + 6;
+	words = 4 * (aes->rounds + 1);
+
+	for (i = 0; i < nk; i++)
+		aes->rk[i] = _get_be32(key + 4 * i);
+	for (; i < words; i++) {
+		t = aes->rk[i - 1];
+		if (i % nk == 0) {
+			t = _sub_word(_ror32(t, 24)) ^ ((uint32_t)rcon << 24);
+			rcon = _gf256_mul(rcon, 2);
+		} else if (nk > 6 && i % nk == 4) {
+			t = _sub_word(t);
+		}
+		aes->rk[i] = aes->rk[i - nk] ^ t;
+	}
+
+	/* Equivalent inverse cipher: reversed round keys, InvMixColumns
+	 * applied to the inner ones */
+	for (i = 0; i < words; i += 4) {
+		const uint32_t *src = aes->rk + words - 4 - i;
+		uint8_t j;
+
+		for (j = 0; j < 4; j++)
+			aes->dk[i + j] = (i == 0 || i == words - 4) ?
+				src[j] : _inv_mix_column(src[j]);
+	}
+}
+
+void soft_aes_encrypt(const struct _soft_aes *aes, const uint8_t *in,
+		uint8_t *out)
+{
+	const uint32_t *rk = aes->rk;
+	uint32_t s[4], t[4];
+	uint8_t r, i;
+
+	for (i = 0; i < 4; i++)
+		s[i] = _get_be32(in + 4 * i) ^ rk[i];
+	for (r = 1; r < aes->rounds; r++) {
+		rk += 4;
+		for (i = 0; i < 4; i++)
+			t[i] = _te[s[i] >> 24] ^
+				_ror32(_te[(s[(i + 1) & 3] >> 16) & 0xff], 8) ^
+				_ror32(_te[(s[(i + 2) & 3] >> 8) & 0xff], 16) ^
+				_ror32(_te[s[(i + 3) & 3] & 0xff], 24) ^ rk[i];
+		memcpy(s, t, sizeof(s));
+	}
+	rk += 4;
+	for (i = 0; i < 4; i++)
+		_put_be32(out + 4 * i,
+			(((uint32_t)_sbox[s[i] >> 24] << 24) |
+			 ((uint32_t)_sbox[(s[(i + 1) & 3] >> 16) & 0xff] << 16) |
+			 ((uint32_t)_sbox[(s[(i + 2) & 3] >> 8) & 0xff] << 8) |
+			 _sbox[s[(i + 3) & 3] & 0xff]) ^ rk[i]);
+}
+
+void soft_aes_decrypt(const struct _soft_aes *aes, const uint8_t *in,
+		uint8_t *out)
+{
+	const uint32_t *dk = aes->dk;
+	uint32_t s[4], t[4];
+	uint8_t r, i;
+
+	for (i = 0; i < 4; i++)
+		s[i] = _get_be32(in + 4 * i) ^ dk[i];
+	for (r = 1; r < aes->rounds; r++) {
+		dk += 4;
+		for (i = 0; i < 4; i++)
+			t[i] = _td[s[i] >> 24] ^
+				_ror32(_td[(s[(i + 3) & 3] >> 16) & 0xff], 8) ^
+				_ror32(_td[(s[(i + 2) & 3] >> 8) & 0xff], 16) ^
+				_ror32(_td[s[(i + 1) & 3] & 0xff], 24) ^ dk[i];
+		memcpy(s, t, sizeof(s));
+	}
+	dk += 4;
+	for (i = 0; i < 4; i++)
+		_put_be32(out + 4 * i,
+			(((uint32_t)_inv_sbox[s[i] >> 24] << 24) |
+			 ((uint32_t)_inv_sbox[(s[(i + 3) & 3] >> 16) & 0xff] << 16) |
+			 ((uint32_t)_inv_sbox[(s[(i + 2) & 3] >> 8) & 0xff] << 8) |
+			 _inv_sbox[s[(i + 1) & 3] & 0xff]) ^ dk[i]);
+}
+
+void soft_ghash_init(struct _soft_ghash *ghash, const uint8_t *h)
+{
+	ghash->h[0] = _get_be64(h);
+	ghash->h[1] = _get_be64(h + 8);
+	ghash->y[0] = ghash->y[1] = 0;
+}
+
+void soft_ghash_update(struct _soft_ghash *ghash, const uint8_t *data,
+		uint32_t len)
+{
+	uint8_t block[16];
+	uint32_t n;
+
+	for (; len; len -= n, data += n) {
+		n = len < 16 ? len : 16;
+		memset(block, 0, sizeof(block));
+		memcpy(block, data, n);
+		ghash->y[0] ^= _get_be64(block);
+		ghash->y[1] ^= _get_be64(block + 8);
+		_ghash_mul(ghash);
+	}
+}
+
+void soft_ghash_lengths(struct _soft_ghash *ghash, uint64_t aad_len,
+		uint64_t text_len)
+{
+	ghash->y[0] ^= aad_len * 8;
+	ghash->y[1] ^= text_len * 8;
+	_ghash_mul(ghash);
+}
+
+void soft_ghash_output(const struct _soft_ghash *ghash, uint8_t *y)
+{
+	_put_be64(y, ghash->y[0]);
+	_put_be64(y + 8, ghash->y[1]);
+}
+
+void soft_gcm(const struct _soft_aes *aes, bool encrypt,
+		const uint8_t *iv, uint32_t iv_len, const uint8_t *aad,
+		uint32_t aad_len, const uint8_t *in, uint32_t len, uint8_t *out,
+		uint8_t *tag)
+{
+	struct _soft_ghash ghash;
+	uint8_t h[16], j0[16], ctr[16], ks[16];
+	uint32_t pos, n, i, count;
+
+	memset(h, 0, sizeof(h));
+	soft_aes_encrypt(aes, h, h);
+	soft_ghash_init(&ghash, h);
+
+	/* J0 = IV || 0^31 || 1 for 96-bit IVs, GHASH of the IV otherwise */
+	if (iv_len == 12) {
+		memcpy(j0, iv, 12);
+		_put_be32(j0 + 12, 1);
+	} else {
+		soft_ghash_update(&ghash, iv, iv_len);
+		soft_ghash_lengths(&ghash, 0, iv_len);
+		soft_ghash_output(&ghash, j0);
+		soft_ghash_init(&ghash, h);
+	}
+
+	soft_ghash_update(&ghash, aad, aad_len);
+	memcpy(ctr, j0, sizeof(ctr));
+	count = _get_be32(j0 + 12);
+	for (pos = 0; pos < len; pos += n) {
+		n = len - pos < 16 ? len - pos : 16;
+		_put_be32(ctr + 12, ++count);
+		soft_aes_encrypt(aes, ctr, ks);
+		if (!encrypt)
+			soft_ghash_update(&ghash, in + pos, n);
+		for (i = 0; i < n; i++)
+			out[pos + i] = in[pos + i] ^ ks[i];
+		if (encrypt)
+			soft_ghash_update(&ghash, out + pos, n);
+	}
+	soft_ghash_lengths(&ghash, aad_len, len);
+
+	soft_ghash_output(&ghash, tag);
+	soft_aes_encrypt(aes, j0, ks);
+	for (i = 0; i < 16; i++)
+		tag[i] ^= ks[i];
+}
+
+void soft_des_set_key(struct _soft_des *des, const uint8_t *key)
+{
+	const uint64_t cd = _permute(_get_be64(key), 64, _des_pc1, 56);
+	uint32_t c = cd >> 28, d = cd & 0xfffffff;
+	uint8_t i;
+
+	for (i = 0; i < 16; i++) {
+		c = ((c << _des_shifts[i]) | (c >> (28 - _des_shifts[i]))) &
+			0xfffffff;
+		d = ((d << _des_shifts[i]) | (d >> (28 - _des_shifts[i]))) &
+			0xfffffff;
+		des->sk[i] = _permute(((uint64_t)c << 28) | d, 56, _des_pc2,
+				48);
+	}
+}
+
+void soft_des_encrypt(const struct _soft_des *des, const uint8_t *in,
+		uint8_t *out)
+{
+	_des_crypt(des, in, out, false);
+}
+
+void soft_des_decrypt(const struct _soft_des *des, const uint8_t *in,
+		uint8_t *out)
+{
+	_des_crypt(des, in, out, true);
+}
+
+uint32_t soft_sha_block_size(enum _soft_sha_algo algo)
+{
+	return algo == SOFT_SHA384 || algo == SOFT_SHA512 ? 128 : 64;
+}
+
+uint32_t soft_sha_digest_size(enum _soft_sha_algo algo)
+{
+	switch (algo) {
+	case SOFT_SHA1:
+		return 20;
+	case SOFT_SHA224:
+		return 28;
+	case SOFT_SHA256:
+		return 32;
+	case SOFT_SHA384:
+		return 48;
+	default:
+		return 64;
+	}
+}
+
+void soft_sha_init(struct _soft_sha *sha, enum _soft_sha_algo algo)
+{
+	memset(sha, 0, sizeof(*sha));
+	sha->algo = algo;
+	switch (algo) {
+	case SOFT_SHA1:
+		memcpy(sha->h32, _sha1_iv, sizeof(_sha1_iv));
+		break;
+	case SOFT_SHA224:
+		memcpy(sha->h32, _sha224_iv, sizeof(_sha224_iv));
+		break;
+	case SOFT_SHA256:
+		memcpy(sha->h32, _sha256_iv, sizeof(_sha256_iv));
+		break;
+	case SOFT_SHA384:
+		memcpy(sha->h64, _sha384_iv, sizeof(_sha384_iv));
+		break;
+	case SOFT_SHA512:
+		memcpy(sha->h64, _sha512_iv, sizeof(_sha512_iv));
+		break;
+	}
+}
+
+void soft_sha_block(struct _soft_sha *sha, const uint8_t *block)
+{
+	switch (sha->algo) {
+	case SOFT_SHA1:
+		_sha1_block(sha->h32, block);
+		break;
+	case SOFT_SHA224:
+	case SOFT_SHA256:
+		_sha256_block(sha->h32, block);
+		break;
+	case SOFT_SHA384:
+	case SOFT_SHA512:
+		_sha512_block(sha->h64, block);
+		break;
+	}
+}
+
+void soft_sha_output(const struct _soft_sha *sha, uint8_t *digest)
+{
+	const uint32_t size = soft_sha_digest_size(sha->algo);
+	uint8_t buf[64];
+	uint8_t i;
+
+	if (sha->algo == SOFT_SHA384 || sha->algo == SOFT_SHA512) {
+		for (i = 0; i < 8; i++)
+			_put_be64(buf + 8 * i, sha->h64[i]);
+		memcpy(digest, buf, size);
+	} else {
+		for (i = 0; i < size / 4; i++)
+			_put_be32(digest + 4 * i, sha->h32[i]);
+	}
+}
+
+void soft_sha(enum _soft_sha_algo algo, const uint8_t *data, uint32_t len,
+		uint8_t *digest)
+{
+	const uint32_t block_size = soft_sha_block_size(algo);
+	const uint64_t bits = (uint64_t)len * 8;
+	struct _soft_sha sha;
+	uint8_t block[2 * 128];
+	uint32_t rem, size;
+
+	soft_sha_init(&sha, algo);
+	for (; len >= block_size; len -= block_size, data += block_size)
+		soft_sha_block(&sha, data);
+
+	/* 0x80, zeros, then the message length in bits on 64 bits (the
+	 * upper half of the 128-bit field of SHA-384/512 stays zero) */
+	rem = len;
+	size = rem + 1 + block_size / 8 <= block_size ?
+		block_size : 2 * block_size;
+	memcpy(block, data, rem);
+	block[rem] = 0x80;
+	memset(block + rem + 1, 0, size - rem - 1);
+	_put_be64(block + size - 8, bits);
+	soft_sha_block(&sha, block);
+	if (size > block_size)
+		soft_sha_block(&sha, block + block_size);
+	soft_sha_output(&sha, digest);
+}
@@ -0,0 +1,170 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Software implementations of the algorithms of the AES, TDES and SHA
+ * engines, used by the simulated engines and as reference by the tests.
+ * GHASH is the software fallback of the GCM mode of the AES engine.
+ * Written for clarity, not for speed or side-channel resistance.
+ */
+
+#ifndef _SOFT_CRYPTO_H_
+#define _SOFT_CRYPTO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Expanded AES key */
+struct _soft_aes {
+	uint32_t rk[60];    /**< encryption round keys, big-endian words */
+	uint32_t dk[60];    /**< decryption round keys, equivalent inverse
+	                         cipher */
+	uint8_t rounds;     /**< 10, 12 or 14 */
+};
+
+/** Expanded DES key */
+struct _soft_des {
+	uint64_t sk[16];    /**< 48-bit subkeys */
+};
+
+/** GHASH state of GCM, as per NIST SP 800-38D */
+struct _soft_ghash {
+	uint64_t h[2];      /**< hash subkey, big-endian halves */
+	uint64_t y[2];      /**< running hash, big-endian halves */
+};
+
+/** SHA algorithms, in the order of the SHA_MR_ALGO field */
+enum _soft_sha_algo {
+	SOFT_SHA1,
+	SOFT_SHA256,
+	SOFT_SHA384,
+	SOFT_SHA512,
+	SOFT_SHA224,
+};
+
+/** SHA state */
+struct _soft_sha {
+	enum _soft_sha_algo algo;
+	uint32_t h32[8];    /**< SHA-1/224/256 */
+	uint64_t h64[8];    /**< SHA-384/512 */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Expand an AES key of 16, 24 or 32 bytes.
+ */
+extern void soft_aes_set_key(struct _soft_aes *aes, const uint8_t *key,
+		uint32_t len);
+
+extern void soft_aes_encrypt(const struct _soft_aes *aes,
+		const uint8_t *in, uint8_t *out);
+
+extern void soft_aes_decrypt(const struct _soft_aes *aes,
+		const uint8_t *in, uint8_t *out);
+
+/**
+ * \brief Start a GHASH with the hash subkey H = E(K, 0^128).
+ */
+extern void soft_ghash_init(struct _soft_ghash *ghash, const uint8_t *h);
+
+/**
+ * \brief Hash data, the last partial block being padded with zeros.
+ */
+extern void soft_ghash_update(struct _soft_ghash *ghash, const uint8_t *data,
+		uint32_t len);
+
+/**
+ * \brief Hash the block of the AAD and text lengths, in bytes.
+ */
+extern void soft_ghash_lengths(struct _soft_ghash *ghash, uint64_t aad_len,
+		uint64_t text_len);
+
+/**
+ * \brief Get the current 16-byte hash.
+ */
+extern void soft_ghash_output(const struct _soft_ghash *ghash, uint8_t *y);
+
+/**
+ * \brief Encrypt or decrypt a whole AES-GCM message of any IV length, and
+ * compute its 16-byte tag (over the ciphertext in both directions).
+ */
+extern void soft_gcm(const struct _soft_aes *aes, bool encrypt,
+		const uint8_t *iv, uint32_t iv_len, const uint8_t *aad,
+		uint32_t aad_len, const uint8_t *in, uint32_t len, uint8_t *out,
+		uint8_t *tag);
+
+/**
+ * \brief Expand an 8-byte DES key, parity bits are ignored.
+ */
+extern void soft_des_set_key(struct _soft_des *des, const uint8_t *key);
+
+extern void soft_des_encrypt(const struct _soft_des *des,
+		const uint8_t *in, uint8_t *out);
+
+extern void soft_des_decrypt(const struct _soft_des *des,
+		const uint8_t *in, uint8_t *out);
+
+/**
+ * \brief Get the block size of a SHA algorithm, in bytes.
+ */
+extern uint32_t soft_sha_block_size(enum _soft_sha_algo algo);
+
+/**
+ * \brief Get the digest size of a SHA algorithm, in bytes.
+ */
+extern uint32_t soft_sha_digest_size(enum _soft_sha_algo algo);
+
+/**
+ * \brief Load the initial hash value of an algorithm.
+ */
+extern void soft_sha_init(struct _soft_sha *sha, enum _soft_sha_algo algo);
+
+/**
+ * \brief Process one block, of soft_sha_block_size() bytes.
+ */
+extern void soft_sha_block(struct _soft_sha *sha, const uint8_t *block);
+
+/**
+ * \brief Get the current hash value, truncated to the digest size. No
+ * padding is added.
+ */
+extern void soft_sha_output(const struct _soft_sha *sha, uint8_t *digest);
+
+/**
+ * \brief Hash a whole message, padding included.
+ */
+extern void soft_sha(enum _soft_sha_algo algo, const uint8_t *data,
+		uint32_t len, uint8_t *digest);
+
+#endif /* _SOFT_CRYPTO_H_ */
@@ -0,0 +1,750 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * AES-GCM records of cryptod.c on the software backend of crypto_sim.c:
+ * NIST GCM test vectors with the text split in place or through the bounce
+ * buffers, random record layouts compared with the soft_crypto.c GCM
+ * (descriptor counts included, to check which blocks are bounced), tag
+ * checks on decryption, back-to-back records and parameter checks. The
+ * bytes of buf_in and buf_out outside the text entries are live data of the
+ * CPU, that the cache invalidations of the driver shall not drop.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "crypto_sim.h"
+#include "soft_crypto.h"
+
+#include "peripherals/cryptod.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define BUF_SIZE      (64 * 1024)
+
+/** Maximum number of entries of a list in the random records */
+#define MAX_ENTRIES   4
+
+/** GCM known answer */
+struct _gcm_kat {
+	const char *key;
+	const char *iv;
+	const char *pt;
+	const char *aad;
+	const char *ct;
+	const char *tag;
+};
+
+/** Split of a record as done by the driver: word-aligned runs of blocks in
+ * place, unless their cache lines extend past their text entry, other blocks
+ * gathered in bounce buffers */
+struct _layout {
+	uint32_t tx;        /* input descriptors */
+	uint32_t rx;        /* output descriptors */
+	uint32_t bounced;   /* bounce buffers */
+	uint32_t pieces;    /* output pieces copied from the bounce buffers */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+#define GCM_KEY  "feffe9928665731c6d6a8f9467308308"
+#define GCM_IV   "cafebabefacedbaddecaf888"
+#define GCM_IV8  "cafebabefacedbad"
+#define GCM_IV60 "9313225df88406e555909c5aff5269aa" \
+                 "6a7a9538534f7da1e4c303d2a318a728" \
+                 "c3c0c95156809539fcf0e2429a6b5254" \
+                 "16aedbf5a0de6a57a637b39b"
+#define GCM_PT60 "d9313225f88406e5a55909c5aff5269a" \
+                 "86a7a9531534f7da2e4c303d8a318a72" \
+                 "1c3c0c95956809532fcf0e2449a6b525" \
+                 "b16aedf5aa0de657ba637b39"
+#define GCM_PT   GCM_PT60 "1aafd255"
+#define GCM_AAD  "feedfacedeadbeeffeedfacedeadbeefabaddad2"
+#define ZERO16   "00000000000000000000000000000000"
+
+/* Test cases 1 to 6 and 13 to 18 of the GCM specification, as published
+ * with the NIST GCM test vectors */
+static const struct _gcm_kat _gcm_kats[] = {
+	{ ZERO16, "000000000000000000000000", "", "",
+	  "",
+	  "58e2fccefa7e3061367f1d57a4e7455a" },
+	{ ZERO16, "000000000000000000000000", ZERO16, "",
+	  "0388dace60b6a392f328c2b971b2fe78",
+	  "ab6e47d42cec13bdf53a67b21257bddf" },
+	{ GCM_KEY, GCM_IV, GCM_PT, "",
+	  "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+	  "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+	  "4d5c2af327cd64a62cf35abd2ba6fab4" },
+	{ GCM_KEY, GCM_IV, GCM_PT60, GCM_AAD,
+	  "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+	  "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+	  "5bc94fbc3221a5db94fae95ae7121a47" },
+	{ GCM_KEY, GCM_IV8, GCM_PT60, GCM_AAD,
+	  "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c7423"
+	  "73806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+	  "3612d2e79e3b0785561be14aaca2fccb" },
+	{ GCM_KEY, GCM_IV60, GCM_PT60, GCM_AAD,
+	  "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+	  "01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+	  "619cc5aefffe0bfa462af43c1699d050" },
+	{ ZERO16 ZERO16, "000000000000000000000000", "", "",
+	  "",
+	  "530f8afbc74536b9a963b4f1c4cb738b" },
+	{ ZERO16 ZERO16, "000000000000000000000000", ZERO16, "",
+	  "cea7403d4d606b6e074ec5d3baf39d18",
+	  "d0d1c8a799996bf0265b98b5d48ab919" },
+	{ GCM_KEY GCM_KEY, GCM_IV, GCM_PT, "",
+	  "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+	  "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662898015ad",
+	  "b094dac5d93471bdec1a502270e3cc6c" },
+	{ GCM_KEY GCM_KEY, GCM_IV, GCM_PT60, GCM_AAD,
+	  "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+	  "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+	  "76fc6ece0f4e1768cddf8853bb2d551b" },
+	{ GCM_KEY GCM_KEY, GCM_IV8, GCM_PT60, GCM_AAD,
+	  "c3762df1ca787d32ae47c13bf19844cbaf1ae14d0b976afac52ff7d79bba9de0"
+	  "feb582d33934a4f0954cc2363bc73f7862ac430e64abe499f47c9b1f",
+	  "3a337dbf46a792c45e454913fe2ea8f2" },
+	{ GCM_KEY GCM_KEY, GCM_IV60, GCM_PT60, GCM_AAD,
+	  "5a8def2f0c9e53f1f75d7853659e2a20eeb2b22aafde6419a058ab4f6f746bf4"
+	  "0fc0c3b780f244452da3ebf1c5d82cdea2418997200ef82e44ae7e3f",
+	  "a44a8266ee1c8eb0c8b5d4cf5ae9f19a" },
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+ALIGNED(32) static uint8_t buf_in[BUF_SIZE];
+ALIGNED(32) static uint8_t buf_out[BUF_SIZE];
+ALIGNED(32) static uint8_t buf_ref[BUF_SIZE];
+
+/** Arguments of the completion callbacks, in call order */
+static uintptr_t done[256];
+static uint32_t done_count;
+
+/** Callbacks invoked while the next record was already running */
+static uint32_t done_running;
+
+/** Bytes of buf_in and buf_out in text entries, the others are live */
+static bool owned_in[BUF_SIZE];
+static bool owned_out[BUF_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _unhex(const char *hex, uint8_t *out)
+{
+	uint32_t len = strlen(hex) / 2, i;
+	unsigned v;
+
+	for (i = 0; i < len; i++) {
+		sscanf(hex + 2 * i, "%2x", &v);
+		out[i] = v;
+	}
+	return len;
+}
+
+static void _random(uint8_t *data, uint32_t length)
+{
+	uint32_t i;
+
+	for (i = 0; i < length; i++)
+		data[i] = rand();
+}
+
+static bool _is_live(const uint8_t *addr)
+{
+	if (addr >= buf_in && addr < buf_in + BUF_SIZE)
+		return !owned_in[addr - buf_in];
+	if (addr >= buf_out && addr < buf_out + BUF_SIZE)
+		return !owned_out[addr - buf_out];
+	return false;
+}
+
+/** Mark the output of text entries as owned by the driver */
+static void _own(const struct _cryptod_sg *sg, uint32_t count)
+{
+	const uint8_t *dst;
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		dst = (const uint8_t*)sg[i].dst;
+		if (dst >= buf_in && dst < buf_in + BUF_SIZE)
+			memset(owned_in + (dst - buf_in), 1, sg[i].len);
+		else if (dst >= buf_out && dst < buf_out + BUF_SIZE)
+			memset(owned_out + (dst - buf_out), 1, sg[i].len);
+	}
+}
+
+static void _disown(void)
+{
+	memset(owned_in, 0, sizeof(owned_in));
+	memset(owned_out, 0, sizeof(owned_out));
+}
+
+static void _setup(void)
+{
+	crypto_sim_reset();
+	crypto_sim.is_live = _is_live;
+	_disown();
+	done_count = 0;
+	done_running = 0;
+}
+
+static void _callback(void *arg)
+{
+	if (done_count < ARRAY_SIZE(done))
+		done[done_count] = (uintptr_t)arg;
+	done_count++;
+	if (crypto_sim_is_running(ID_AES))
+		done_running++;
+}
+
+static uint32_t _init(struct _cryptod_session *session, bool encrypt,
+		const uint8_t *key, uint8_t key_len)
+{
+	struct _cryptod_cfg cfg;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.algo = CRYPTOD_ALGO_AES;
+	cfg.mode = CRYPTOD_MODE_GCM;
+	cfg.encrypt = encrypt;
+	cfg.key = key;
+	cfg.key_len = key_len;
+	return cryptod_init(session, &cfg);
+}
+
+static void _end(struct _cryptod_session *session)
+{
+	uint32_t rc;
+
+	while ((rc = cryptod_final(session, NULL, NULL, 0, NULL,
+				NULL)) == CRYPTOD_ERROR_BUSY)
+		crypto_sim_step();
+	CHECK_EQ(rc, CRYPTOD_SUCCESS);
+	cryptod_wait(session);
+	CHECK(!session->active);
+}
+
+static uint32_t _queue(struct _cryptod_session *session,
+		struct _cryptod_gcm_record *record, uintptr_t arg)
+{
+	uint32_t rc;
+
+	/* Let the hardware progress while both banks are in use */
+	while ((rc = cryptod_gcm_queue(session, record, _callback,
+				(void*)arg)) == CRYPTOD_ERROR_BUSY)
+		crypto_sim_step();
+	return rc;
+}
+
+/**
+ * \brief Queue a record and run the hardware until it completes.
+ * \return the status of the record, or the error of the queueing.
+ */
+static uint32_t _process(struct _cryptod_session *session,
+		struct _cryptod_gcm_record *record)
+{
+	uint32_t rc = _queue(session, record, 0);
+
+	if (rc != CRYPTOD_SUCCESS)
+		return rc;
+	while (record->status == CRYPTOD_ERROR_BUSY && crypto_sim_step());
+	return record->status;
+}
+
+/** Largest run of whole blocks written in place from dst + pos, whose first
+ * and last cache lines do not extend past the entry of len bytes at dst */
+static uint32_t _run_len(uintptr_t dst, uint32_t pos, uint32_t len)
+{
+	const uintptr_t line = L1_CACHE_BYTES;
+	uint32_t n;
+
+	if ((dst + pos) / line * line < dst)
+		return 0;
+	for (n = (len - pos) & ~15u; n; n -= 16)
+		if ((dst + pos + n + line - 1) / line * line <= dst + len)
+			break;
+	return n;
+}
+
+/** Expected split of a list of a record, see struct _layout */
+static void _plan(const struct _cryptod_sg *sg, uint32_t count, bool output,
+		struct _layout *layout)
+{
+	uint32_t i, pos, n, carry = 0;
+
+	for (i = 0; i < count; i++) {
+		const uintptr_t src = (uintptr_t)sg[i].src;
+		const uintptr_t dst = (uintptr_t)sg[i].dst;
+		const uint32_t len = sg[i].len;
+
+		for (pos = 0; pos < len; pos += n) {
+			n = 0;
+			if (!carry && len - pos >= 16 && !((src + pos) & 3) &&
+			    (!output || !((dst + pos) & 3)))
+				n = output ? _run_len(dst, pos, len) :
+					(len - pos) & ~15u;
+			if (n) {
+				layout->tx++;
+				layout->rx += output;
+				continue;
+			}
+			if (!carry)
+				layout->bounced++;
+			n = 16 - carry < len - pos ? 16 - carry : len - pos;
+			layout->pieces += output;
+			carry = (carry + n) % 16;
+			if (!carry) {
+				layout->tx++;
+				layout->rx += output;
+			}
+		}
+	}
+	if (carry) {
+		layout->tx++;
+		layout->rx += output;
+	}
+}
+
+static bool _layout_fits(const struct _layout *layout)
+{
+	return layout->bounced <= CRYPTOD_GCM_SPLIT_COUNT &&
+		layout->tx <= CRYPTOD_DESC_COUNT &&
+		layout->rx <= CRYPTOD_DESC_COUNT &&
+		layout->pieces <= 2 * CRYPTOD_GCM_SPLIT_COUNT;
+}
+
+/**
+ * \brief Cut len bytes at buf_in + pos into up to max entries of random
+ * lengths, the input and the output at buf_out + pos being each misaligned
+ * one time out of three, with gaps between the entries.
+ * \return the number of entries, pos being moved past the last one.
+ */
+static uint32_t _cut(struct _cryptod_sg *sg, uint32_t max, uint32_t len,
+		uint32_t *pos)
+{
+	uint32_t count = 0, n, base;
+
+	while (len && count < max) {
+		n = count == max - 1 ? len : 1 + rand() % len;
+		base = (*pos + 3) & ~3u;
+		sg[count].src = buf_in + base +
+			(rand() % 3 ? 0 : 1 + rand() % 3);
+		sg[count].dst = buf_out + base +
+			(rand() % 3 ? 0 : 1 + rand() % 3);
+		sg[count].len = n;
+		*pos = base + 3 + n + rand() % 8;
+		len -= n;
+		count++;
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/**
+ * NIST vectors, encryption then decryption in place, the text in entries of
+ * piece bytes starting at offset from a cache line (piece 0 for a single
+ * entry). Entries of whole blocks at aligned addresses must not be bounced.
+ */
+static void test_gcm_kat(uint32_t piece, uint32_t offset)
+{
+	uint8_t key[32], iv[64], pt[64], ct[64], tag[16], out_tag[16];
+	struct _cryptod_sg aad_sg, text_sg[16];
+	struct _cryptod_gcm_record record;
+	struct _cryptod_session session;
+	struct _layout layout;
+	uint32_t i, j, key_len, pt_len, aad_len, count, descriptors;
+	uint8_t *text = buf_in + offset;
+	uint8_t *aad = buf_in + BUF_SIZE / 2;
+
+	_setup();
+	for (i = 0; i < ARRAY_SIZE(_gcm_kats); i++) {
+		const struct _gcm_kat *kat = &_gcm_kats[i];
+
+		key_len = _unhex(kat->key, key);
+		_unhex(kat->pt, pt);
+		pt_len = _unhex(kat->ct, ct);
+		aad_len = _unhex(kat->aad, aad);
+		_unhex(kat->tag, tag);
+
+		memset(&record, 0, sizeof(record));
+		record.iv = iv;
+		record.iv_len = _unhex(kat->iv, iv);
+		aad_sg.src = aad;
+		aad_sg.dst = NULL;
+		aad_sg.len = aad_len;
+		record.aad = &aad_sg;
+		record.aad_count = 1;
+		count = 0;
+		for (j = 0; j < pt_len; j += text_sg[count++].len) {
+			text_sg[count].src = text + j;
+			text_sg[count].dst = text + j;
+			text_sg[count].len = piece && pt_len - j > piece ?
+				piece : pt_len - j;
+		}
+		record.text = text_sg;
+		record.text_count = count;
+		memset(&layout, 0, sizeof(layout));
+		_plan(&aad_sg, 1, false, &layout);
+		_plan(text_sg, count, true, &layout);
+		/* Whole cache lines of text are transferred in place, only
+		 * the blocks of the last partial line are bounced */
+		if (!(offset % L1_CACHE_BYTES) && !(piece % L1_CACHE_BYTES))
+			CHECK_EQ(layout.bounced, (aad_len % 16 != 0) +
+				(pt_len % L1_CACHE_BYTES + 15) / 16);
+		_disown();
+		_own(text_sg, count);
+
+		/* Encryption, full tag. Records without AAD nor text are not
+		 * supported by the driver. */
+		memcpy(text, pt, pt_len);
+		record.tag = out_tag;
+		record.tag_len = 16;
+		CHECK_EQ(_init(&session, true, key, key_len), CRYPTOD_SUCCESS);
+		if (!aad_len && !pt_len) {
+			CHECK_EQ(_process(&session, &record),
+					CRYPTOD_INVALID_PARAM);
+			_end(&session);
+			continue;
+		}
+		descriptors = crypto_sim.descriptors;
+		CHECK_EQ(_process(&session, &record), CRYPTOD_SUCCESS);
+		CHECK_EQ(crypto_sim.descriptors - descriptors,
+				layout.tx + layout.rx);
+		_end(&session);
+		CHECK_MEM(text, ct, pt_len, i);
+		CHECK_MEM(out_tag, tag, 16, i);
+
+		/* Decryption of the result, then with each tag length and a
+		 * corrupted tag */
+		CHECK_EQ(_init(&session, false, key, key_len), CRYPTOD_SUCCESS);
+		record.tag = tag;
+		CHECK_EQ(_process(&session, &record), CRYPTOD_SUCCESS);
+		CHECK_MEM(text, pt, pt_len, i);
+		record.tag_len = 4 + rand() % 13;
+		memcpy(text, ct, pt_len);
+		tag[rand() % record.tag_len] ^= 1 << (rand() % 8);
+		CHECK_EQ(_process(&session, &record), CRYPTOD_ERROR_AUTH);
+		_end(&session);
+	}
+
+	CHECK_EQ(crypto_sim.aes_keys, 2 * ARRAY_SIZE(_gcm_kats) - 2);
+	CHECK_EQ(crypto_sim.errors, 0);
+}
+
+/**
+ * Random records: key sizes, IV lengths, AAD and text cut in entries of any
+ * length and alignment. Records exceeding the descriptors or bounce buffers
+ * shall be rejected, the others shall match soft_gcm() without touching the
+ * bytes around the output entries.
+ */
+static void test_gcm_random(void)
+{
+	static const uint8_t key_lens[] = { 16, 24, 32 };
+	uint8_t key[32], iv[64], aad[256], tag[16], ref_tag[16];
+	struct _cryptod_sg aad_sg[MAX_ENTRIES], text_sg[MAX_ENTRIES];
+	struct _cryptod_gcm_record record;
+	struct _cryptod_session session;
+	struct _layout layout;
+	struct _soft_aes aes;
+	uint8_t *ref = buf_ref + BUF_SIZE / 2;
+	uint32_t round, i, pos, n, aad_len, text_len, key_len, descriptors;
+	uint32_t accepted = 0, rejected = 0;
+	bool encrypt;
+
+	_setup();
+	for (round = 0; round < 1000; round++) {
+		key_len = key_lens[rand() % ARRAY_SIZE(key_lens)];
+		_random(key, key_len);
+		memset(&record, 0, sizeof(record));
+		record.iv = iv;
+		record.iv_len = rand() & 1 ? 12 : 1 + rand() % sizeof(iv);
+		_random(iv, record.iv_len);
+		record.tag = tag;
+		record.tag_len = 4 + rand() % 13;
+		aad_len = rand() % 4 ? rand() % 80 : 0;
+		text_len = rand() % 4 ? rand() % 600 : 0;
+		if (!aad_len && !text_len)
+			text_len = 1 + rand() % 32;
+		encrypt = rand() & 1;
+		crypto_sim.irq_in_queue = rand() & 1;
+
+		/* Lay the entries out in buf_in, the output entries around
+		 * the same offsets in buf_out */
+		pos = 0;
+		record.aad = aad_sg;
+		record.aad_count = _cut(aad_sg, 1 + rand() % MAX_ENTRIES,
+				aad_len, &pos);
+		record.text = text_sg;
+		record.text_count = _cut(text_sg, 1 + rand() % MAX_ENTRIES,
+				text_len, &pos);
+		_random(buf_in, pos);
+		_random(buf_out, pos);
+		memcpy(buf_ref, buf_out, pos);
+		for (i = 0, n = 0; i < record.aad_count; n += aad_sg[i++].len)
+			memcpy(aad + n, aad_sg[i].src, aad_sg[i].len);
+		for (i = 0, n = 0; i < record.text_count; n += text_sg[i++].len)
+			memcpy(ref + n, text_sg[i].src, text_sg[i].len);
+
+		/* Expected output, placed at the offsets of the entries */
+		soft_aes_set_key(&aes, key, key_len);
+		soft_gcm(&aes, encrypt, iv, record.iv_len, aad, aad_len,
+				ref, text_len, ref, ref_tag);
+		for (i = 0, n = 0; i < record.text_count; n += text_sg[i++].len)
+			memcpy(buf_ref + ((uint8_t*)text_sg[i].dst - buf_out),
+					ref + n, text_sg[i].len);
+		if (encrypt)
+			memset(tag, 0, sizeof(tag));
+		else
+			memcpy(tag, ref_tag, sizeof(tag));
+		memset(&layout, 0, sizeof(layout));
+		_plan(aad_sg, record.aad_count, false, &layout);
+		_plan(text_sg, record.text_count, true, &layout);
+		_disown();
+		_own(text_sg, record.text_count);
+
+		CHECK_EQ(_init(&session, encrypt, key, key_len),
+				CRYPTOD_SUCCESS);
+		descriptors = crypto_sim.descriptors;
+		if (!_layout_fits(&layout)) {
+			CHECK_EQ(_process(&session, &record),
+					CRYPTOD_INVALID_PARAM);
+			rejected++;
+		} else {
+			CHECK_EQ(_process(&session, &record),
+					CRYPTOD_SUCCESS);
+			CHECK_EQ(crypto_sim.descriptors - descriptors,
+					layout.tx + layout.rx);
+			CHECK_MEM(buf_out, buf_ref, pos, round);
+			if (encrypt)
+				CHECK_MEM(tag, ref_tag, record.tag_len, round);
+			accepted++;
+		}
+		_end(&session);
+	}
+	crypto_sim.irq_in_queue = false;
+
+	/* About half of the layouts fit */
+	CHECK(accepted > 300);
+	CHECK(rejected > 300);
+	CHECK_EQ(crypto_sim.errors, 0);
+}
+
+/**
+ * Records queued back-to-back on one key with their own IVs: the key is
+ * written once, only the first record is started by the thread and each
+ * callback but the last finds the next record running.
+ */
+static void test_gcm_pipelining(bool irq_in_queue)
+{
+	const uint32_t count = 64;
+	static struct _cryptod_gcm_record records[64];
+	static uint8_t ivs[64][16], tags[64][16], aads[64][24];
+	struct _cryptod_sg aad_sg[64], text_sg[64];
+	struct _cryptod_session session;
+	struct _soft_aes aes;
+	uint8_t key[32], ref_tag[16];
+	uint32_t i, pos = 0, len;
+
+	_setup();
+	crypto_sim.irq_in_queue = irq_in_queue;
+	_random(key, sizeof(key));
+	soft_aes_set_key(&aes, key, sizeof(key));
+	CHECK_EQ(_init(&session, true, key, sizeof(key)), CRYPTOD_SUCCESS);
+	for (i = 0; i < count; i++) {
+		/* Telemetry-like frames: a small header, some payload */
+		len = 16 * (rand() % 32) + rand() % 16;
+		memset(&records[i], 0, sizeof(records[i]));
+		_random(ivs[i], sizeof(ivs[i]));
+		_random(aads[i], sizeof(aads[i]));
+		records[i].iv = ivs[i];
+		records[i].iv_len = i % 8 ? 12 : 16;
+		aad_sg[i].src = aads[i];
+		aad_sg[i].dst = NULL;
+		aad_sg[i].len = 8 + rand() % 16;
+		records[i].aad = &aad_sg[i];
+		records[i].aad_count = 1;
+		_random(buf_in + pos, len);
+		text_sg[i].src = buf_in + pos;
+		text_sg[i].dst = buf_out + pos;
+		text_sg[i].len = len;
+		records[i].text = &text_sg[i];
+		records[i].text_count = 1;
+		_own(&text_sg[i], 1);
+		records[i].tag = tags[i];
+		records[i].tag_len = 16;
+		CHECK_EQ(_queue(&session, &records[i], i), CRYPTOD_SUCCESS);
+		pos += (len + 31) & ~31u;
+	}
+	_end(&session);
+
+	for (i = 0, pos = 0; i < count; i++) {
+		len = text_sg[i].len;
+		soft_gcm(&aes, true, ivs[i], records[i].iv_len, aads[i],
+				aad_sg[i].len, buf_in + pos, len, buf_ref + pos,
+				ref_tag);
+		CHECK_EQ(records[i].status, CRYPTOD_SUCCESS);
+		CHECK_MEM(buf_out + pos, buf_ref + pos, len, i);
+		CHECK_MEM(tags[i], ref_tag, 16, i);
+		pos += (len + 31) & ~31u;
+	}
+	CHECK_EQ(done_count, count);
+	for (i = 0; i < count && i < ARRAY_SIZE(done); i++)
+		CHECK_EQ(done[i], i);
+	CHECK_EQ(crypto_sim.aes_keys, 1);
+	if (!irq_in_queue) {
+		CHECK_EQ(crypto_sim.thread_starts, 1);
+		CHECK_EQ(crypto_sim.irq_starts, count - 1);
+		CHECK_EQ(done_running, count - 1);
+	}
+	crypto_sim.irq_in_queue = false;
+	CHECK_EQ(crypto_sim.errors, 0);
+}
+
+static void test_gcm_params(void)
+{
+	uint8_t key[16] = { 0 }, iv[12] = { 0 }, tag[16];
+	struct _cryptod_sg sg[CRYPTOD_GCM_SPLIT_COUNT + 1];
+	struct _cryptod_gcm_record record, other;
+	struct _cryptod_session session;
+	uint32_t i;
+
+	_setup();
+	CHECK_EQ(_init(&session, true, key, sizeof(key)), CRYPTOD_SUCCESS);
+	sg[0].src = buf_in;
+	sg[0].dst = buf_out;
+	sg[0].len = 64;
+	memset(&record, 0, sizeof(record));
+	record.iv = iv;
+	record.iv_len = sizeof(iv);
+	record.text = sg;
+	record.text_count = 1;
+	record.tag = tag;
+	record.tag_len = 16;
+
+	/* IV, tag and lists */
+	record.iv = NULL;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	record.iv = iv;
+	record.iv_len = 0;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	record.iv_len = sizeof(iv);
+	record.tag_len = 3;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	record.tag_len = 17;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	record.tag_len = 16;
+	record.text = NULL;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	record.text = sg;
+	sg[0].len = 0;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	sg[0].len = 64;
+	sg[0].dst = NULL;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	sg[0].dst = buf_out;
+
+	/* One block more than the bounce buffers, then one entry more than
+	 * the descriptors */
+	sg[0].src = buf_in + 1;
+	sg[0].len = 16 * (CRYPTOD_GCM_SPLIT_COUNT + 1);
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	for (i = 0; i < ARRAY_SIZE(sg); i++) {
+		sg[i].src = buf_in + 64 * i;
+		sg[i].dst = buf_out + 64 * i;
+		sg[i].len = 32;
+	}
+	_own(sg, ARRAY_SIZE(sg));
+	record.text_count = CRYPTOD_DESC_COUNT + 1;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	record.text_count = CRYPTOD_DESC_COUNT;
+	CHECK_EQ(crypto_sim.transfers, 0);
+
+	/* Two records pending at most, the third waits */
+	other = record;
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_SUCCESS);
+	CHECK_EQ(record.status, CRYPTOD_ERROR_BUSY);
+	CHECK_EQ(cryptod_gcm_queue(&session, &other, NULL, NULL),
+			CRYPTOD_SUCCESS);
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_ERROR_BUSY);
+	_end(&session);
+	CHECK_EQ(record.status, CRYPTOD_SUCCESS);
+	CHECK_EQ(other.status, CRYPTOD_SUCCESS);
+
+	/* Records need an active GCM session */
+	CHECK_EQ(cryptod_gcm_queue(&session, &record, NULL, NULL),
+			CRYPTOD_INVALID_PARAM);
+	CHECK_EQ(crypto_sim.errors, 0);
+}
+
+int main(void)
+{
+	srand(1);
+
+	RUN_TEST(test_gcm_kat, 0, 0);
+	RUN_TEST(test_gcm_kat, 16, 0);
+	RUN_TEST(test_gcm_kat, 7, 0);
+	RUN_TEST(test_gcm_kat, 0, 1);
+	RUN_TEST(test_gcm_kat, 32, 0);
+	RUN_TEST(test_gcm_kat, 32, 2);
+	RUN_TEST(test_gcm_random);
+	RUN_TEST(test_gcm_pipelining, false);
+	RUN_TEST(test_gcm_pipelining, true);
+	RUN_TEST(test_gcm_params);
+
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,245 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * samba_applets/common/applet_verify on a memory model and the software
+ * backend of crypto_sim.c: CRC-32 and SHA-256 of page ranges against
+ * utils/crc and soft_crypto.c for any number of pages per read, reads
+ * staying within the buffers, with the SHA engine hashing one buffer while
+ * the other is read, and read errors, after which the engine shall be
+ * released.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "crypto_sim.h"
+#include "soft_crypto.h"
+
+#include "applet.h"
+#include "applet_verify.h"
+#include "crc.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define PAGE_SIZE 512
+
+/** Pages of the memory model */
+#define MAX_PAGES 256
+
+/** Largest buffers, in pages */
+#define MAX_BUFFER_PAGES 8
+
+/** Random ranges per test */
+#define ROUNDS 300
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t mem[MAX_PAGES * PAGE_SIZE];
+
+ALIGNED(32) static uint8_t buffers[APPLET_BUFFER_COUNT]
+		[MAX_BUFFER_PAGES * PAGE_SIZE];
+
+static struct applet_buffer_ops ops;
+
+static struct applet_verify verify;
+
+/** Read calls, and the one failing (0 for none) */
+static uint32_t reads;
+static uint32_t fail_read;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _read(uint8_t *data, uint32_t offset, uint32_t length)
+{
+	const uint32_t size = length * verify.page_size;
+	uint32_t i;
+	bool in_buffer = false;
+
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++)
+		in_buffer |= data == verify.buffers[i];
+	CHECK(in_buffer);
+	CHECK(length > 0);
+	CHECK(size <= verify.buffer_size);
+	CHECK((offset + length) * verify.page_size <= sizeof(mem));
+
+	if (++reads == fail_read)
+		return APPLET_READ_FAIL;
+
+	/* let the engine progress during the read, or not */
+	if (rand() & 1)
+		crypto_sim_step();
+	memcpy(data, mem + offset * verify.page_size, size);
+	return APPLET_SUCCESS;
+}
+
+static void _setup(uint32_t page_size, uint32_t buffer_pages)
+{
+	uint32_t i;
+
+	crypto_sim_reset();
+	reads = 0;
+	fail_read = 0;
+
+	ops.read = _read;
+
+	verify.ops = &ops;
+	verify.page_size = page_size;
+	for (i = 0; i < APPLET_BUFFER_COUNT; i++)
+		verify.buffers[i] = buffers[i];
+	verify.buffer_size = buffer_pages * page_size;
+}
+
+static void _random(uint8_t *data, uint32_t length)
+{
+	uint32_t i;
+
+	for (i = 0; i < length; i++)
+		data[i] = rand();
+}
+
+/** Expected digest of a page range */
+static void _expected(uint32_t algo, uint32_t offset, uint32_t length,
+		uint32_t *digest)
+{
+	const uint8_t *data = mem + offset * verify.page_size;
+	const uint32_t size = length * verify.page_size;
+
+	if (algo == APPLET_VERIFY_CRC32)
+		digest[0] = crc_compute(CRC_32, data, size);
+	else
+		soft_sha(SOFT_SHA256, data, size, (uint8_t*)digest);
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* CRC-32 check value of the catalogue, one 9-byte page */
+static void test_crc32_check(void)
+{
+	uint32_t digest = 0;
+
+	_setup(9, 1);
+	memcpy(mem, "123456789", 9);
+	CHECK_EQ(applet_verify(&verify, APPLET_VERIFY_CRC32, 0, 1, &digest),
+			APPLET_SUCCESS);
+	CHECK_EQ(digest, 0xcbf43926);
+	CHECK_EQ(verify.pages, 1);
+}
+
+/* Random ranges against the digest of the whole range at once */
+static void test_ranges(uint32_t algo)
+{
+	const uint32_t words = algo == APPLET_VERIFY_CRC32 ? 1 : 8;
+	uint32_t digest[8], expected[8];
+	uint32_t round, offset, length;
+
+	_random(mem, sizeof(mem));
+	for (round = 0; round < ROUNDS; round++) {
+		_setup(PAGE_SIZE, 1 + rand() % MAX_BUFFER_PAGES);
+		offset = rand() % MAX_PAGES;
+		length = rand() % (MAX_PAGES - offset + 1);
+		if (round == 0)
+			length = 0;
+
+		_expected(algo, offset, length, expected);
+		memset(digest, 0, sizeof(digest));
+		CHECK_EQ(applet_verify(&verify, algo, offset, length, digest),
+				APPLET_SUCCESS);
+		CHECK_MEM(digest, expected, words * 4, round);
+		CHECK_EQ(verify.pages, length);
+		CHECK_EQ(reads, (length + verify.buffer_size / PAGE_SIZE - 1) /
+				(verify.buffer_size / PAGE_SIZE));
+	}
+	CHECK_EQ(crypto_sim.errors, 0);
+}
+
+/* The status of a failed read is returned and the engine is released */
+static void test_read_error(uint32_t algo)
+{
+	uint32_t digest[8], expected[8];
+	uint32_t n;
+
+	_random(mem, sizeof(mem));
+	for (n = 1; n <= 8; n++) {
+		_setup(PAGE_SIZE, 2);
+		fail_read = n;
+		CHECK_EQ(applet_verify(&verify, algo, 0, 16, digest),
+				APPLET_READ_FAIL);
+		CHECK_EQ(reads, n);
+		CHECK_EQ(verify.pages, 2 * (n - 1));
+
+		/* the next verify works */
+		fail_read = 0;
+		_expected(algo, 3, 5, expected);
+		CHECK_EQ(applet_verify(&verify, algo, 3, 5, digest),
+				APPLET_SUCCESS);
+		CHECK_MEM(digest, expected,
+				algo == APPLET_VERIFY_CRC32 ? 4 : 32, n);
+	}
+	CHECK_EQ(crypto_sim.errors, 0);
+}
+
+static void test_unsupported(void)
+{
+	uint32_t digest[8];
+
+	_setup(PAGE_SIZE, 1);
+	CHECK_EQ(applet_verify(&verify, 0xff, 0, 1, digest), APPLET_FAIL);
+	CHECK_EQ(reads, 0);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_crc32_check);
+	RUN_TEST(test_ranges, APPLET_VERIFY_CRC32);
+	RUN_TEST(test_ranges, APPLET_VERIFY_SHA256);
+	RUN_TEST(test_read_error, APPLET_VERIFY_CRC32);
+	RUN_TEST(test_read_error, APPLET_VERIFY_SHA256);
+	RUN_TEST(test_unsupported);
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,74 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host replacement for network/phy.h, the loopback link is always up.
+ */
+
+#ifndef _PHY_H_
+#define _PHY_H_
+
+#include "peripherals/ethd.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PHY_DEFAULT_RETRIES 300000
+
+enum _phy_if_eth {
+	PHY_IF_EMAC,
+	PHY_IF_GMAC,
+};
+
+struct _phy_desc {
+	void* addr;
+	enum _phy_if_eth phy_if;
+	uint32_t retries;
+	uint8_t phy_addr;
+};
+
+struct _phy {
+	const struct _phy_desc* desc;
+	uint8_t phy_addr;
+};
+
+static inline bool phy_configure(struct _phy* phy)
+{
+	phy->phy_addr = phy->desc->phy_addr;
+	return true;
+}
+
+static inline bool phy_auto_negotiate(const struct _phy* phy, uint32_t time_out)
+{
+	(void)phy;
+	(void)time_out;
+	return true;
+}
+
+#endif /* _PHY_H_ */
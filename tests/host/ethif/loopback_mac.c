@@ -0,0 +1,380 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "ring.h"
+
+#ifdef CONFIG_HAVE_EMAC
+#include "peripherals/emacd.h"
+#endif
+#ifdef CONFIG_HAVE_GMAC
+#include "peripherals/gmacd.h"
+#endif
+
+#include "loopback_mac.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+struct _host_mac {
+	struct _ethd* ethd;
+	bool started;
+	uint8_t mac[6];
+	uint16_t rx_cur;     /**< Next RX descriptor the DMA writes */
+	uint16_t tx_cur;     /**< Next TX descriptor the DMA reads */
+	struct _loopback_mac_stats stats;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+struct _host_mac host_mac0;
+
+static uint8_t _tx_frame[ETH_MAX_FRAME_LENGTH];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void* _desc_buffer(const struct _eth_desc* desc)
+{
+	return (void*)(uintptr_t)(desc->addr & ETH_RX_ADDR_MASK);
+}
+
+static uint16_t _rx_next(const struct _ethd_queue* q, uint16_t idx)
+{
+	if (q->rx_desc[idx].addr & ETH_RX_ADDR_WRAP)
+		return 0;
+	assert(idx + 1 < q->rx_size);
+	return idx + 1;
+}
+
+static uint16_t _tx_next(const struct _ethd_queue* q, uint16_t idx)
+{
+	if (q->tx_desc[idx].status & ETH_TX_STATUS_WRAP)
+		return 0;
+	assert(idx + 1 < q->tx_size);
+	return idx + 1;
+}
+
+static void _reset_rx(struct _host_mac* mac, struct _ethd_queue* q)
+{
+	uint32_t addr = (uint32_t)(uintptr_t)q->rx_buffer;
+	uint32_t i;
+
+	q->rx_head = 0;
+	for (i = 0; i < q->rx_size; i++) {
+		if (q->rx_buffer) {
+			q->rx_desc[i].addr = addr & ETH_RX_ADDR_MASK;
+			addr += q->rx_unit_size;
+		} else {
+			q->rx_desc[i].addr = ETH_RX_ADDR_OWN;
+		}
+		q->rx_desc[i].status = 0;
+	}
+	q->rx_desc[q->rx_size - 1].addr |= ETH_RX_ADDR_WRAP;
+	mac->rx_cur = 0;
+}
+
+static void _reset_tx(struct _host_mac* mac, struct _ethd_queue* q)
+{
+	uint32_t addr = (uint32_t)(uintptr_t)q->tx_buffer;
+	uint32_t i;
+
+	RING_CLEAR(q->tx_head, q->tx_tail);
+	for (i = 0; i < q->tx_size; i++) {
+		q->tx_desc[i].addr = addr;
+		q->tx_desc[i].status = ETH_TX_STATUS_USED;
+		if (q->tx_buffer)
+			addr += ETH_TX_UNITSIZE;
+	}
+	q->tx_desc[q->tx_size - 1].status |= ETH_TX_STATUS_WRAP;
+	mac->tx_cur = 0;
+}
+
+/* Same walk as _gmacd_tx_complete_handler() */
+static void _tx_complete(struct _ethd_queue* q)
+{
+	struct _eth_desc* desc;
+	ethd_callback_t callback;
+
+	while (!RING_EMPTY(q->tx_head, q->tx_tail)) {
+		desc = &q->tx_desc[q->tx_tail];
+		if ((desc->status & ETH_TX_STATUS_USED) == 0)
+			break;
+		while ((desc->status & ETH_TX_STATUS_LASTBUF) == 0) {
+			RING_INC(q->tx_tail, q->tx_size);
+			desc = &q->tx_desc[q->tx_tail];
+		}
+		if (q->tx_callbacks) {
+			callback = q->tx_callbacks[q->tx_tail];
+			if (callback)
+				callback(0, 0);
+		}
+		RING_INC(q->tx_tail, q->tx_size);
+	}
+
+	if (q->tx_wakeup_callback &&
+	    RING_SPACE(q->tx_head, q->tx_tail, q->tx_size) >= q->tx_wakeup_threshold)
+		q->tx_wakeup_callback(0);
+}
+
+/*----------------------------------------------------------------------------
+ *        MAC operations
+ *----------------------------------------------------------------------------*/
+
+static void _loopback_configure(struct _ethd* ethd, void* addr,
+		uint8_t enable_caf, uint8_t enable_nbc)
+{
+	struct _host_mac* mac = addr;
+
+	memset(mac, 0, sizeof(*mac));
+	memset(ethd->queues, 0, sizeof(ethd->queues));
+	mac->ethd = ethd;
+}
+
+static uint8_t _loopback_setup_queue(struct _ethd* ethd, uint8_t queue,
+		uint16_t rx_size, uint8_t* rx_buffer, struct _eth_desc* rx_desc,
+		uint16_t tx_size, uint8_t* tx_buffer, struct _eth_desc* tx_desc,
+		ethd_callback_t* tx_callbacks)
+{
+	struct _ethd_queue* q = &ethd->queues[queue];
+
+	if (queue != 0 || rx_size <= 1 || tx_size <= 1)
+		return ETH_PARAM;
+	/* The drivers keep the buffer addresses in 32-bit descriptors */
+	assert((uintptr_t)rx_desc < 0x100000000ull);
+	assert((uintptr_t)tx_desc < 0x100000000ull);
+	assert(((uintptr_t)rx_desc & 7) == 0 && ((uintptr_t)tx_desc & 7) == 0);
+
+	q->rx_buffer = rx_buffer;
+	q->rx_desc = rx_desc;
+	q->rx_size = rx_size;
+	q->rx_unit_size = ETH_RX_UNITSIZE;
+	q->rx_callback = NULL;
+	q->rx_csum = ETH_RX_CSUM_NONE;
+	q->tx_buffer = tx_buffer;
+	q->tx_desc = tx_desc;
+	q->tx_size = tx_size;
+	q->tx_callbacks = tx_callbacks;
+	q->tx_wakeup_callback = NULL;
+
+	_reset_rx((struct _host_mac*)ethd->addr, q);
+	_reset_tx((struct _host_mac*)ethd->addr, q);
+	return ETH_OK;
+}
+
+static void _loopback_start(struct _ethd* ethd)
+{
+	((struct _host_mac*)ethd->addr)->started = true;
+}
+
+static void _loopback_reset(struct _ethd* ethd)
+{
+	_reset_rx((struct _host_mac*)ethd->addr, &ethd->queues[0]);
+	_reset_tx((struct _host_mac*)ethd->addr, &ethd->queues[0]);
+}
+
+static void _loopback_set_mac_addr(struct _host_mac* mac, uint8_t sa_idx, uint8_t* addr)
+{
+	if (sa_idx == 0)
+		memcpy(mac->mac, addr, sizeof(mac->mac));
+}
+
+static void _loopback_start_transmission(struct _host_mac* mac)
+{
+	/* Frames are sent by loopback_mac_transmit() */
+}
+
+static void _loopback_set_rx_callback(struct _ethd* ethd, uint8_t queue,
+		ethd_callback_t callback)
+{
+	ethd->queues[queue].rx_callback = callback;
+}
+
+#ifdef CONFIG_HAVE_GMAC
+/* Same checks as gmacd_set_rx_unit_size() and gmac_set_rx_buffer_size() */
+static uint8_t _loopback_set_rx_unit_size(struct _ethd* ethd, uint8_t queue,
+		uint16_t size)
+{
+	struct _ethd_queue* q = &ethd->queues[queue];
+
+	if (queue != 0 || q->rx_buffer)
+		return ETH_PARAM;
+	if (size == 0 || (size & 63) || (size >> 6) > 0xff)
+		return ETH_PARAM;
+	q->rx_unit_size = size;
+	return ETH_OK;
+}
+#endif
+
+#ifdef CONFIG_HAVE_EMAC
+/* The EMAC only receives in ETH_RX_UNITSIZE buffers */
+const struct _ethd_op _emac_op = {
+	.configure = (_ethd_configure)_loopback_configure,
+	.setup_queue = (_ethd_setup_queue)_loopback_setup_queue,
+	.start = (_ethd_start)_loopback_start,
+	.reset = (_ethd_reset)_loopback_reset,
+	.set_mac_addr = (_eth_set_mac_addr)_loopback_set_mac_addr,
+	.start_transmission = (_eth_start_transmission)_loopback_start_transmission,
+	.send_sg = (_ethd_send_sg)ethd_send_sg,
+	.send = (_ethd_send)ethd_send,
+	.poll = (_ethd_poll)ethd_poll,
+	.set_rx_callback = (_ethd_set_rx_callback)_loopback_set_rx_callback,
+	.set_tx_wakeup_callback = (_ethd_set_tx_wakeup_callback)ethd_set_tx_wakeup_callback,
+};
+#endif
+
+#ifdef CONFIG_HAVE_GMAC
+const struct _ethd_op _gmac_op = {
+	.configure = (_ethd_configure)_loopback_configure,
+	.setup_queue = (_ethd_setup_queue)_loopback_setup_queue,
+	.start = (_ethd_start)_loopback_start,
+	.reset = (_ethd_reset)_loopback_reset,
+	.set_mac_addr = (_eth_set_mac_addr)_loopback_set_mac_addr,
+	.start_transmission = (_eth_start_transmission)_loopback_start_transmission,
+	.send_sg = (_ethd_send_sg)ethd_send_sg,
+	.send = (_ethd_send)ethd_send,
+	.poll = (_ethd_poll)ethd_poll,
+	.set_rx_callback = (_ethd_set_rx_callback)_loopback_set_rx_callback,
+	.set_tx_wakeup_callback = (_ethd_set_tx_wakeup_callback)ethd_set_tx_wakeup_callback,
+	.set_rx_unit_size = (_ethd_set_rx_unit_size)_loopback_set_rx_unit_size,
+};
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+bool loopback_mac_receive(const void* frame, uint32_t size)
+{
+	struct _host_mac* mac = &host_mac0;
+	struct _ethd_queue* q = &mac->ethd->queues[0];
+	const uint8_t* data = frame;
+	uint32_t unit = q->rx_unit_size;
+	uint32_t units, i, len;
+	uint16_t idx;
+
+	assert(mac->started);
+	assert(size > 0 && size <= ETH_MAX_FRAME_LENGTH);
+
+	/* The whole frame must fit in descriptors owned by the MAC */
+	units = (size + unit - 1) / unit;
+	if (units > q->rx_size)
+		goto drop;
+	for (i = 0, idx = mac->rx_cur; i < units; i++) {
+		if (q->rx_desc[idx].addr & ETH_RX_ADDR_OWN)
+			goto drop;
+		idx = _rx_next(q, idx);
+	}
+
+	for (i = 0, idx = mac->rx_cur; i < units; i++) {
+		struct _eth_desc* desc = &q->rx_desc[idx];
+		uint32_t status = 0;
+
+		len = size - i * unit < unit ? size - i * unit : unit;
+		memcpy(_desc_buffer(desc), data + i * unit, len);
+		if (i == 0)
+			status |= ETH_RX_STATUS_SOF;
+		if (i == units - 1)
+			status |= ETH_RX_STATUS_EOF | size;
+		desc->status = status;
+		dsb();
+		desc->addr |= ETH_RX_ADDR_OWN;
+		idx = _rx_next(q, idx);
+	}
+	mac->rx_cur = idx;
+	mac->stats.rx_frames++;
+
+	if (q->rx_callback)
+		q->rx_callback(0, 0);
+	return true;
+
+drop:
+	mac->stats.rx_dropped++;
+	return false;
+}
+
+uint32_t loopback_mac_transmit(loopback_mac_sink_t sink, void* arg)
+{
+	struct _host_mac* mac = &host_mac0;
+	struct _ethd_queue* q = &mac->ethd->queues[0];
+	uint32_t frames = 0;
+
+	while ((q->tx_desc[mac->tx_cur].status & ETH_TX_STATUS_USED) == 0) {
+		struct _eth_desc* first = &q->tx_desc[mac->tx_cur];
+		struct _eth_desc* desc;
+		uint32_t size = 0, len;
+		uint16_t idx = mac->tx_cur;
+
+		/* Gather the buffers of the frame */
+		do {
+			desc = &q->tx_desc[idx];
+			assert((desc->status & ETH_TX_STATUS_USED) == 0);
+			len = desc->status & ETH_RX_STATUS_LENGTH_MASK;
+			assert(size + len <= sizeof(_tx_frame));
+			memcpy(_tx_frame + size, (void*)(uintptr_t)desc->addr, len);
+			size += len;
+			idx = _tx_next(q, idx);
+		} while ((desc->status & ETH_TX_STATUS_LASTBUF) == 0);
+		mac->tx_cur = idx;
+
+		/* Descriptor write-back: USED in the first buffer only */
+		first->status |= ETH_TX_STATUS_USED;
+		mac->stats.tx_frames++;
+		frames++;
+
+		if (sink)
+			sink(_tx_frame, size, arg);
+		else
+			loopback_mac_receive(_tx_frame, size);
+	}
+
+	_tx_complete(q);
+	return frames;
+}
+
+uint16_t loopback_mac_get_rx_unit_size(void)
+{
+	return host_mac0.ethd->queues[0].rx_unit_size;
+}
+
+void loopback_mac_get_stats(struct _loopback_mac_stats* stats)
+{
+	*stats = host_mac0.stats;
+}
@@ -0,0 +1,90 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Loopback MAC: a host model of the EMAC/GMAC DMA behind struct _ethd.
+ *
+ * It provides the _emac_op or _gmac_op operations used by ethd.c and walks
+ * the RX/TX descriptor rings the way the MAC does: received frames are split over
+ * buffers of rx_unit_size bytes with SOF/EOF/length in the descriptors and
+ * OWN set last, transmitted frames are read from their buffers only when
+ * loopback_mac_transmit() is called (the DMA may run long after
+ * ethd_send_sg() returned), then the USED bit is written back into the
+ * first descriptor and the TX completion callbacks are run as the gmacd
+ * interrupt handler does. Only queue 0 is modelled.
+ */
+
+#ifndef _LOOPBACK_MAC_H_
+#define _LOOPBACK_MAC_H_
+
+#include "chip.h"
+#include "peripherals/ethd.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Counters of the loopback MAC */
+struct _loopback_mac_stats {
+	uint32_t rx_frames;   /**< Frames written into the RX ring */
+	uint32_t rx_dropped;  /**< Frames dropped, no free RX descriptor */
+	uint32_t tx_frames;   /**< Frames read from the TX ring */
+};
+
+/** Receiver of the transmitted frames */
+typedef void (*loopback_mac_sink_t)(const uint8_t* frame, uint32_t size,
+		void* arg);
+
+/**
+ * \brief Receive a frame into queue 0 as the MAC would.
+ * \return false if the frame was dropped because the RX ring lacks free
+ * descriptors.
+ */
+extern bool loopback_mac_receive(const void* frame, uint32_t size);
+
+/**
+ * \brief Transmit the frames queued on queue 0 and complete them.
+ * \param sink Receiver of the frames, NULL to loop them back into the RX
+ * ring.
+ * \return Number of frames transmitted.
+ */
+extern uint32_t loopback_mac_transmit(loopback_mac_sink_t sink, void* arg);
+
+/**
+ * \brief Get the size of the buffers of the RX ring of queue 0.
+ */
+extern uint16_t loopback_mac_get_rx_unit_size(void);
+
+/**
+ * \brief Get the counters of the loopback MAC.
+ */
+extern void loopback_mac_get_stats(struct _loopback_mac_stats* stats);
+
+#endif /* _LOOPBACK_MAC_H_ */
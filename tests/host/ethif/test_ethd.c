@@ -0,0 +1,263 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * ethd.c driven through the loopback MAC: copy and zero-copy RX/TX paths,
+ * RX unit sizes, ring wrap-around and RX overflow.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "board.h"
+#include "host_test.h"
+
+#include "peripherals/ethd.h"
+
+#include "loopback_mac.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#define RX_DESCS 16
+#define TX_DESCS 8
+#define POOL_BUFFERS (2 * RX_DESCS)
+
+static struct _ethd ethd;
+
+ALIGNED(8) static struct _eth_desc rx_desc[RX_DESCS];
+ALIGNED(8) static struct _eth_desc tx_desc[TX_DESCS];
+static ethd_callback_t tx_callbacks[TX_DESCS];
+
+ALIGNED(32) static uint8_t rx_buffer[RX_DESCS * ETH_RX_UNITSIZE];
+ALIGNED(32) static uint8_t tx_buffer[TX_DESCS * ETH_TX_UNITSIZE];
+
+/* Zero-copy RX buffers, handed to the ring in turn */
+ALIGNED(32) static uint8_t pool[POOL_BUFFERS][ETH_MAX_FRAME_LENGTH];
+static uint32_t pool_next;
+
+ALIGNED(32) static uint8_t frame[ETH_MAX_FRAME_LENGTH];
+static uint8_t received[ETH_MAX_FRAME_LENGTH];
+
+static uint32_t tx_done;
+
+static const uint32_t sizes[] = { 60, 127, 128, 129, 191, 192, 600, 1514, 1536 };
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _tx_callback(uint8_t queue, uint32_t status)
+{
+	tx_done++;
+}
+
+static void _fill_frame(uint32_t size, uint32_t seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++)
+		frame[i] = (uint8_t)(seed * 31 + i * 7);
+}
+
+static void* _pool_get(void)
+{
+	void* buffer = pool[pool_next];
+	pool_next = (pool_next + 1) % POOL_BUFFERS;
+	return buffer;
+}
+
+static void _start(bool zero_copy, uint16_t rx_descs)
+{
+	CHECK(ethd_configure(&ethd, ETH_TYPE_GMAC, GMAC0_ADDR, 1, 0));
+	if (zero_copy)
+		CHECK_EQ(ethd_setup_queue(&ethd, 0, rx_descs, NULL, rx_desc,
+				TX_DESCS, NULL, tx_desc, tx_callbacks), ETH_OK);
+	else
+		CHECK_EQ(ethd_setup_queue(&ethd, 0, rx_descs, rx_buffer, rx_desc,
+				TX_DESCS, tx_buffer, tx_desc, tx_callbacks), ETH_OK);
+	CHECK_EQ(ethd_get_rx_unit_size(&ethd, 0), ETH_RX_UNITSIZE);
+	tx_done = 0;
+}
+
+static void _give_rx_buffers(uint16_t rx_descs)
+{
+	uint16_t i;
+
+	for (i = 0; i < rx_descs; i++)
+		ethd_set_rx_buffer(&ethd, 0, i, _pool_get());
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* Static RX/TX buffers, frames copied in and out by ethd_send/ethd_poll */
+static void test_copy(void)
+{
+	uint32_t round, i, recv_size;
+
+	_start(false, RX_DESCS);
+	/* Only queues set up without buffers can change their unit size */
+	CHECK_EQ(ethd_set_rx_unit_size(&ethd, 0, 256), ETH_PARAM);
+	ethd_start(&ethd);
+
+	for (round = 0; round < 5; round++) {
+		for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+			_fill_frame(sizes[i], round + i);
+			CHECK_EQ(ethd_send(&ethd, 0, frame, sizes[i], _tx_callback), ETH_OK);
+			CHECK_EQ(loopback_mac_transmit(NULL, NULL), 1);
+
+			memset(received, 0, sizeof(received));
+			CHECK_EQ(ethd_poll(&ethd, 0, received, sizeof(received), &recv_size), ETH_OK);
+			CHECK_EQ(recv_size, sizes[i]);
+			CHECK(memcmp(received, frame, sizes[i]) == 0);
+		}
+	}
+	CHECK_EQ(tx_done, 5 * ARRAY_SIZE(sizes));
+	CHECK_EQ(ethd_poll(&ethd, 0, received, sizeof(received), &recv_size), ETH_RX_NULL);
+}
+
+/* Caller's RX/TX buffers, frames handed over with ethd_poll_frame */
+static void test_zero_copy(uint16_t unit)
+{
+	struct _eth_sg sg[3];
+	struct _eth_sg_list sgl = { .size = 3, .entries = sg };
+	uint32_t round, i, recv_size, offset;
+	uint16_t first, count, idx, j;
+
+	_start(true, RX_DESCS);
+	CHECK_EQ(ethd_set_rx_unit_size(&ethd, 0, 100), ETH_PARAM);
+	CHECK_EQ(ethd_set_rx_unit_size(&ethd, 0, 0), ETH_PARAM);
+	CHECK_EQ(ethd_set_rx_unit_size(&ethd, 0, 256 * 64), ETH_PARAM);
+	CHECK_EQ(ethd_set_rx_unit_size(&ethd, 0, unit), ETH_OK);
+	CHECK_EQ(ethd_get_rx_unit_size(&ethd, 0), unit);
+	_give_rx_buffers(RX_DESCS);
+	ethd_start(&ethd);
+
+	for (round = 0; round < 5; round++) {
+		for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+			uint32_t units = (sizes[i] + unit - 1) / unit;
+
+			if (units >= RX_DESCS)
+				continue;
+
+			/* Three fragments, sent from the caller's buffer */
+			_fill_frame(sizes[i], round * 7 + i);
+			sg[0].buffer = frame;
+			sg[0].size = 14;
+			sg[1].buffer = frame + 14;
+			sg[1].size = (sizes[i] - 14) / 2;
+			sg[2].buffer = frame + 14 + sg[1].size;
+			sg[2].size = sizes[i] - 14 - sg[1].size;
+			sg[0].next = &sg[1];
+			sg[1].next = &sg[2];
+			sg[2].next = NULL;
+			CHECK_EQ(ethd_send_sg(&ethd, 0, &sgl, _tx_callback), ETH_OK);
+
+			/* The buffer is read by the DMA, not by ethd_send_sg */
+			frame[20] ^= 0xff;
+			CHECK_EQ(loopback_mac_transmit(NULL, NULL), 1);
+
+			CHECK_EQ(ethd_poll_frame(&ethd, 0, &first, &count, &recv_size), ETH_OK);
+			CHECK_EQ(recv_size, sizes[i]);
+			CHECK_EQ(count, units);
+
+			/* Reassemble, then give fresh buffers back */
+			for (j = 0, idx = first, offset = 0; j < count; j++) {
+				uint32_t len = recv_size - offset < unit ? recv_size - offset : unit;
+				memcpy(received + offset, ethd_get_rx_buffer(&ethd, 0, idx), len);
+				offset += len;
+				ethd_set_rx_buffer(&ethd, 0, idx, _pool_get());
+				idx = (idx + 1) % RX_DESCS;
+			}
+			CHECK(memcmp(received, frame, sizes[i]) == 0);
+		}
+	}
+	CHECK_EQ(ethd_poll_frame(&ethd, 0, &first, &count, &recv_size), ETH_RX_NULL);
+}
+
+/* Frames arriving while the ring is full are dropped by the MAC */
+static void test_rx_overflow(void)
+{
+	struct _loopback_mac_stats before, after;
+	uint32_t i, recv_size;
+	uint16_t first, count;
+
+	_start(true, 4);
+	CHECK_EQ(ethd_set_rx_unit_size(&ethd, 0, ETH_MAX_FRAME_LENGTH), ETH_OK);
+	_give_rx_buffers(4);
+	ethd_start(&ethd);
+
+	loopback_mac_get_stats(&before);
+	_fill_frame(1514, 3);
+	for (i = 0; i < 4; i++)
+		CHECK(loopback_mac_receive(frame, 1514));
+	CHECK(!loopback_mac_receive(frame, 1514));
+	loopback_mac_get_stats(&after);
+	CHECK_EQ(after.rx_dropped - before.rx_dropped, 1);
+
+	for (i = 0; i < 4; i++) {
+		CHECK_EQ(ethd_poll_frame(&ethd, 0, &first, &count, &recv_size), ETH_OK);
+		CHECK_EQ(first, i);
+		CHECK_EQ(count, 1);
+		CHECK_EQ(recv_size, 1514);
+		CHECK(memcmp(ethd_get_rx_buffer(&ethd, 0, first), frame, 1514) == 0);
+	}
+
+	/* Nothing can be received until the buffers are given back */
+	CHECK(!loopback_mac_receive(frame, 60));
+	for (i = 0; i < 4; i++)
+		ethd_set_rx_buffer(&ethd, 0, i, _pool_get());
+	CHECK(loopback_mac_receive(frame, 60));
+	CHECK_EQ(ethd_poll_frame(&ethd, 0, &first, &count, &recv_size), ETH_OK);
+	CHECK_EQ(first, 0);
+	CHECK_EQ(recv_size, 60);
+	ethd_set_rx_buffer(&ethd, 0, first, _pool_get());
+	CHECK_EQ(ethd_poll_frame(&ethd, 0, &first, &count, &recv_size), ETH_RX_NULL);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	RUN_TEST(test_copy);
+	RUN_TEST(test_zero_copy, 128);
+	RUN_TEST(test_zero_copy, 192);
+	RUN_TEST(test_zero_copy, 1536);
+	RUN_TEST(test_rx_overflow);
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,654 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * ethif.c and lwIP on top of ethd.c and the loopback MAC. The test plays
+ * the peer: it injects ARP and ICMP echo requests and TCP segments into
+ * the RX ring and checks the replies read from the TX ring, then that
+ * every pool pbuf has been given back. Built once per lwipopts.h profile and ETHIF_ZERO_COPY
+ * setting.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "host_test.h"
+
+#include "lwip/opt.h"
+#include "lwip/init.h"
+#include "lwip/ip.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcp.h"
+#include "netif/etharp.h"
+#include "ethif.h"
+
+#include "loopback_mac.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define MAX_CAPTURED 16
+
+struct _captured {
+	uint32_t count;
+	uint32_t size[MAX_CAPTURED];
+	uint8_t frame[MAX_CAPTURED][ETH_MAX_FRAME_LENGTH];
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t our_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+static const uint8_t peer_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+static const uint8_t our_ip[4] = { 192, 168, 1, 10 };
+static const uint8_t peer_ip[4] = { 192, 168, 1, 2 };
+
+static struct netif netif;
+
+static struct _captured captured;
+
+static uint8_t frame[ETH_MAX_FRAME_LENGTH];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _capture(const uint8_t* data, uint32_t size, void* arg)
+{
+	struct _captured* c = arg;
+
+	if (c->count < MAX_CAPTURED) {
+		memcpy(c->frame[c->count], data, size);
+		c->size[c->count] = size;
+	}
+	c->count++;
+}
+
+/* Send what the stack queued, the pbufs of the sent frames are released
+ * by the next ethif_poll() */
+static uint32_t _transmit(void)
+{
+	return loopback_mac_transmit(_capture, &captured);
+}
+
+
+static uint16_t _get16(const uint8_t* p)
+{
+	return (uint16_t)(p[0] << 8 | p[1]);
+}
+
+static void _put16(uint8_t* p, uint16_t v)
+{
+	p[0] = v >> 8;
+	p[1] = v & 0xff;
+}
+
+static uint16_t _chksum(const uint8_t* p, uint32_t len)
+{
+	uint32_t sum = 0, i;
+
+	for (i = 0; i + 1 < len; i += 2)
+		sum += _get16(p + i);
+	if (len & 1)
+		sum += p[len - 1] << 8;
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t)~sum;
+}
+
+static uint32_t _build_arp_request(uint8_t* f)
+{
+	memset(f, 0, 60);
+	memset(f, 0xff, 6);
+	memcpy(f + 6, peer_mac, 6);
+	_put16(f + 12, ETHTYPE_ARP);
+	_put16(f + 14, 1);          /* Ethernet */
+	_put16(f + 16, ETHTYPE_IP);
+	f[18] = 6;
+	f[19] = 4;
+	_put16(f + 20, 1);          /* request */
+	memcpy(f + 22, peer_mac, 6);
+	memcpy(f + 28, peer_ip, 4);
+	memcpy(f + 38, our_ip, 4);
+	return 60;
+}
+
+static uint32_t _build_ping(uint8_t* f, uint16_t seq, uint32_t payload)
+{
+	uint8_t* ip = f + 14;
+	uint8_t* icmp = ip + 20;
+	uint32_t i, size;
+
+	memcpy(f, our_mac, 6);
+	memcpy(f + 6, peer_mac, 6);
+	_put16(f + 12, ETHTYPE_IP);
+
+	memset(ip, 0, 20);
+	ip[0] = 0x45;
+	_put16(ip + 2, 20 + 8 + payload);
+	_put16(ip + 4, seq);
+	ip[8] = 64;
+	ip[9] = IP_PROTO_ICMP;
+	memcpy(ip + 12, peer_ip, 4);
+	memcpy(ip + 16, our_ip, 4);
+	_put16(ip + 10, _chksum(ip, 20));
+
+	memset(icmp, 0, 8);
+	icmp[0] = 8;                /* echo request */
+	_put16(icmp + 4, 0x1234);
+	_put16(icmp + 6, seq);
+	for (i = 0; i < payload; i++)
+		icmp[8 + i] = (uint8_t)(seq + i * 13);
+	_put16(icmp + 2, _chksum(icmp, 8 + payload));
+
+	size = 14 + 20 + 8 + payload;
+	if (size < 60) {
+		memset(f + size, 0, 60 - size);
+		size = 60;
+	}
+	return size;
+}
+
+static bool _is_ping_reply(const uint8_t* f, uint32_t size, uint16_t seq,
+		uint32_t payload)
+{
+	const uint8_t* ip = f + 14;
+	const uint8_t* icmp = ip + 20;
+	uint32_t i;
+
+	if (size < 14 + 20 + 8 + payload)
+		return false;
+	if (memcmp(f, peer_mac, 6) || memcmp(f + 6, our_mac, 6) ||
+	    _get16(f + 12) != ETHTYPE_IP)
+		return false;
+	if (ip[0] != 0x45 || _get16(ip + 2) != 20 + 8 + payload ||
+	    ip[9] != IP_PROTO_ICMP || _chksum(ip, 20) != 0 ||
+	    memcmp(ip + 12, our_ip, 4) || memcmp(ip + 16, peer_ip, 4))
+		return false;
+	if (icmp[0] != 0 || _get16(icmp + 6) != seq ||
+	    _chksum(icmp, 8 + payload) != 0)
+		return false;
+	for (i = 0; i < payload; i++)
+		if (icmp[8 + i] != (uint8_t)(seq + i * 13))
+			return false;
+	return true;
+}
+
+/* Number of pbufs left in PBUF_POOL */
+static uint32_t _pool_free(void)
+{
+	static struct pbuf* held[PBUF_POOL_SIZE];
+	uint32_t n = 0, i;
+
+	while (n < PBUF_POOL_SIZE &&
+	       (held[n] = pbuf_alloc(PBUF_RAW, 1, PBUF_POOL)) != NULL)
+		n++;
+	for (i = 0; i < n; i++)
+		pbuf_free(held[i]);
+	return n;
+}
+
+/* Release the pbufs of the sent frames, then count the free pool pbufs */
+static uint32_t _pool_free_after_poll(void)
+{
+	ethif_poll(&netif);
+	return _pool_free();
+}
+
+static uint32_t _pool_idle(void)
+{
+	/* In zero-copy mode the RX ring holds ETHIF_RX_BUFFERS pool pbufs */
+	return ETHIF_ZERO_COPY ? PBUF_POOL_SIZE - ETHIF_RX_BUFFERS : PBUF_POOL_SIZE;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+static void test_arp(void)
+{
+	const uint8_t* r;
+
+	captured.count = 0;
+	CHECK(loopback_mac_receive(frame, _build_arp_request(frame)));
+	ethif_poll(&netif);
+	CHECK_EQ(_transmit(), 1);
+	r = captured.frame[0];
+	CHECK(memcmp(r, peer_mac, 6) == 0);
+	CHECK(memcmp(r + 6, our_mac, 6) == 0);
+	CHECK_EQ(_get16(r + 12), ETHTYPE_ARP);
+	CHECK_EQ(_get16(r + 20), 2);
+	CHECK(memcmp(r + 22, our_mac, 6) == 0);
+	CHECK(memcmp(r + 28, our_ip, 4) == 0);
+	CHECK(memcmp(r + 32, peer_mac, 6) == 0);
+	CHECK(memcmp(r + 38, peer_ip, 4) == 0);
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+}
+
+/* The echo reply is built in the received pbufs and sent from them */
+static void test_ping(uint32_t payload)
+{
+	static uint16_t seq;
+
+	seq++;
+	captured.count = 0;
+	CHECK(loopback_mac_receive(frame, _build_ping(frame, seq, payload)));
+	ethif_poll(&netif);
+	CHECK_EQ(_transmit(), 1);
+	CHECK(_is_ping_reply(captured.frame[0], captured.size[0], seq, payload));
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+}
+
+/* Fill the RX ring, then answer every frame it accepted */
+static void test_ping_burst(void)
+{
+	struct _loopback_mac_stats before, after;
+	uint32_t unit = loopback_mac_get_rx_unit_size();
+	uint32_t accepted = 0, i;
+	uint16_t seq;
+
+	loopback_mac_get_stats(&before);
+	for (seq = 1000; seq < 1000 + 64; seq++) {
+		if (!loopback_mac_receive(frame, _build_ping(frame, seq, 1000)))
+			break;
+		accepted++;
+	}
+	loopback_mac_get_stats(&after);
+	/* 1042-byte frames */
+	CHECK_EQ(accepted, ETHIF_RX_BUFFERS / ((1042 + unit - 1) / unit));
+	CHECK_EQ(after.rx_dropped - before.rx_dropped, 1);
+
+	for (i = 0; i < accepted; i++) {
+		captured.count = 0;
+		ethif_poll(&netif);
+		CHECK_EQ(_transmit(), 1);
+		CHECK(_is_ping_reply(captured.frame[0], captured.size[0], 1000 + i, 1000));
+	}
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+	CHECK_EQ(_transmit(), 0);
+}
+
+/* A frame received while PBUF_POOL is empty is dropped, the ring keeps
+ * working once pbufs are freed */
+static void test_pool_exhausted(void)
+{
+	static struct pbuf* held[PBUF_POOL_SIZE];
+	uint32_t n = 0, i;
+
+	while (n < PBUF_POOL_SIZE &&
+	       (held[n] = pbuf_alloc(PBUF_RAW, 1, PBUF_POOL)) != NULL)
+		n++;
+	CHECK_EQ(n, _pool_idle());
+
+	captured.count = 0;
+	CHECK(loopback_mac_receive(frame, _build_ping(frame, 2000, 1472)));
+	ethif_poll(&netif);
+	CHECK_EQ(_transmit(), 0);
+
+	for (i = 0; i < n; i++)
+		pbuf_free(held[i]);
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+
+	CHECK(loopback_mac_receive(frame, _build_ping(frame, 2001, 1472)));
+	ethif_poll(&netif);
+	CHECK_EQ(_transmit(), 1);
+	CHECK(_is_ping_reply(captured.frame[0], captured.size[0], 2001, 1472));
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+}
+
+/*----------------------------------------------------------------------------
+ *        TCP
+ *----------------------------------------------------------------------------*/
+
+#define TCP_PORT_PEER 40000
+#define TCP_PORT_OURS 5001
+
+struct _tcp_info {
+	uint32_t seq;
+	uint32_t ack;
+	uint16_t wnd;
+	uint8_t flags;
+	uint32_t len;
+};
+
+/* Data received and held by the application */
+static struct {
+	struct tcp_pcb* pcb;
+	struct pbuf* held[TCP_WND / TCP_MSS + 4];
+	uint32_t count;
+	uint32_t bytes;
+} app;
+
+static uint8_t _tcp_data(uint32_t offset)
+{
+	return (uint8_t)(offset * 7 + (offset >> 8));
+}
+
+static uint32_t _build_tcp(uint8_t* f, uint32_t seq, uint32_t ack,
+		uint8_t flags, uint32_t offset, uint32_t payload)
+{
+	uint8_t* ip = f + 14;
+	uint8_t* tcp = ip + 20;
+	uint8_t pseudo[12];
+	uint32_t hlen = (flags & TCP_SYN) ? 24 : 20;
+	uint32_t sum, i, size;
+
+	memcpy(f, our_mac, 6);
+	memcpy(f + 6, peer_mac, 6);
+	_put16(f + 12, ETHTYPE_IP);
+
+	memset(ip, 0, 20);
+	ip[0] = 0x45;
+	_put16(ip + 2, 20 + hlen + payload);
+	ip[8] = 64;
+	ip[9] = IP_PROTO_TCP;
+	memcpy(ip + 12, peer_ip, 4);
+	memcpy(ip + 16, our_ip, 4);
+	_put16(ip + 10, _chksum(ip, 20));
+
+	memset(tcp, 0, hlen);
+	_put16(tcp, TCP_PORT_PEER);
+	_put16(tcp + 2, TCP_PORT_OURS);
+	_put16(tcp + 4, seq >> 16);
+	_put16(tcp + 6, seq);
+	_put16(tcp + 8, ack >> 16);
+	_put16(tcp + 10, ack);
+	tcp[12] = (hlen / 4) << 4;
+	tcp[13] = flags;
+	_put16(tcp + 14, 0xffff);
+	if (flags & TCP_SYN) {
+		tcp[20] = 2;            /* MSS option */
+		tcp[21] = 4;
+		_put16(tcp + 22, TCP_MSS);
+	}
+	for (i = 0; i < payload; i++)
+		tcp[hlen + i] = _tcp_data(offset + i);
+
+	/* Checksum over the pseudo header and the segment */
+	memcpy(pseudo, peer_ip, 4);
+	memcpy(pseudo + 4, our_ip, 4);
+	pseudo[8] = 0;
+	pseudo[9] = IP_PROTO_TCP;
+	_put16(pseudo + 10, hlen + payload);
+	sum = (uint16_t)~_chksum(pseudo, 12) + (uint16_t)~_chksum(tcp, hlen + payload);
+	sum = (sum & 0xffff) + (sum >> 16);
+	_put16(tcp + 16, (uint16_t)~sum);
+
+	size = 14 + 20 + hlen + payload;
+	if (size < 60) {
+		memset(f + size, 0, 60 - size);
+		size = 60;
+	}
+	return size;
+}
+
+static bool _parse_tcp(const uint8_t* f, uint32_t size, struct _tcp_info* info)
+{
+	const uint8_t* ip = f + 14;
+	const uint8_t* tcp = ip + 20;
+	uint32_t hlen;
+
+	if (size < 14 + 20 + 20 || _get16(f + 12) != ETHTYPE_IP ||
+	    ip[9] != IP_PROTO_TCP || memcmp(ip + 16, peer_ip, 4) ||
+	    _get16(tcp) != TCP_PORT_OURS || _get16(tcp + 2) != TCP_PORT_PEER)
+		return false;
+	hlen = (tcp[12] >> 4) * 4;
+	info->seq = (uint32_t)_get16(tcp + 4) << 16 | _get16(tcp + 6);
+	info->ack = (uint32_t)_get16(tcp + 8) << 16 | _get16(tcp + 10);
+	info->flags = tcp[13];
+	info->wnd = _get16(tcp + 14);
+	info->len = _get16(ip + 2) - 20 - hlen;
+	return true;
+}
+
+static err_t _app_recv(void* arg, struct tcp_pcb* pcb, struct pbuf* p, err_t err)
+{
+	if (p == NULL)
+		return ERR_OK;
+	CHECK(app.count < ARRAY_SIZE(app.held));
+	if (app.count < ARRAY_SIZE(app.held))
+		app.held[app.count++] = p;
+	app.bytes += p->tot_len;
+	return ERR_OK;
+}
+
+static err_t _app_accept(void* arg, struct tcp_pcb* pcb, err_t err)
+{
+	app.pcb = pcb;
+	tcp_recv(pcb, _app_recv);
+	return ERR_OK;
+}
+
+/* Inject the frames, process them and return the last TCP reply */
+static bool _tcp_exchange(const uint32_t* sizes, uint8_t (*frames)[ETH_MAX_FRAME_LENGTH],
+		uint32_t count, struct _tcp_info* last, uint32_t* replies)
+{
+	uint32_t i, sent;
+
+	captured.count = 0;
+	for (i = 0; i < count; i++)
+		CHECK(loopback_mac_receive(frames[i], sizes[i]));
+	for (i = 0; i < count; i++)
+		ethif_poll(&netif);
+	sent = _transmit();
+	if (replies)
+		*replies = sent;
+	if (sent == 0 || sent > MAX_CAPTURED)
+		return false;
+	return _parse_tcp(captured.frame[sent - 1], captured.size[sent - 1], last);
+}
+
+/* Open a connection from the peer, return the listening pcb */
+static struct tcp_pcb* _tcp_accept(uint32_t* peer_seq, uint32_t* our_seq)
+{
+	static uint8_t frames[1][ETH_MAX_FRAME_LENGTH];
+	uint32_t sizes[1];
+	struct tcp_pcb* listener;
+	struct _tcp_info info;
+
+	memset(&app, 0, sizeof(app));
+	listener = tcp_new();
+	CHECK(tcp_bind(listener, IP_ADDR_ANY, TCP_PORT_OURS) == ERR_OK);
+	listener = tcp_listen(listener);
+	tcp_accept(listener, _app_accept);
+
+	*peer_seq = 1000;
+	sizes[0] = _build_tcp(frames[0], *peer_seq, 0, TCP_SYN, 0, 0);
+	CHECK(_tcp_exchange(sizes, frames, 1, &info, NULL));
+	CHECK_EQ(info.flags, TCP_SYN | TCP_ACK);
+	CHECK_EQ(info.ack, *peer_seq + 1);
+	CHECK_EQ(info.wnd, TCP_WND);
+	(*peer_seq)++;
+	*our_seq = info.seq + 1;
+	sizes[0] = _build_tcp(frames[0], *peer_seq, *our_seq, TCP_ACK, 0, 0);
+	loopback_mac_receive(frames[0], sizes[0]);
+	ethif_poll(&netif);
+	CHECK(app.pcb != NULL);
+	return listener;
+}
+
+/* Reset the connection and check that every pbuf came back */
+static void _tcp_abort(struct tcp_pcb* listener)
+{
+	struct _tcp_info info;
+
+	captured.count = 0;
+	tcp_abort(app.pcb);
+	tcp_close(listener);
+	CHECK_EQ(_transmit(), 1);
+	CHECK(_parse_tcp(captured.frame[0], captured.size[0], &info));
+	CHECK(info.flags & TCP_RST);
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+}
+
+/* A segment retransmitted while its first transmission is still queued:
+ * lwIP rewrites the headers of the segment, each transmission must carry
+ * its own headers and the same payload. The data is copied into the
+ * segment, or referenced in a second pbuf. */
+static void test_tcp_retransmit(uint8_t apiflags)
+{
+	static uint8_t data[TCP_MSS];
+	struct tcp_pcb* listener;
+	struct _tcp_info info[2];
+	uint32_t peer_seq, our_seq, i, hlen;
+
+	listener = _tcp_accept(&peer_seq, &our_seq);
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = _tcp_data(i);
+	CHECK(tcp_write(app.pcb, data, sizeof(data), apiflags) == ERR_OK);
+	CHECK(tcp_output(app.pcb) == ERR_OK);
+	tcp_rexmit_rto(app.pcb);
+
+	captured.count = 0;
+	CHECK_EQ(_transmit(), 2);
+	for (i = 0; i < 2; i++) {
+		const uint8_t* ip = captured.frame[i] + 14;
+
+		CHECK(_parse_tcp(captured.frame[i], captured.size[i], &info[i]));
+		CHECK_EQ(info[i].seq, our_seq);
+		CHECK_EQ(info[i].len, sizeof(data));
+		CHECK_EQ(_chksum(ip, 20), 0);
+		hlen = (ip[32] >> 4) * 4;
+		CHECK(!memcmp(ip + 20 + hlen, data, sizeof(data)));
+	}
+	/* The IP identification of the retransmission is the next one */
+	CHECK_EQ(_get16(captured.frame[1] + 18),
+			(uint16_t)(_get16(captured.frame[0] + 18) + 1));
+
+	_tcp_abort(listener);
+}
+
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+/* The application holds a full receive window of zero-copy pbufs while the
+ * peer keeps probing: the RX ring must still be refilled and every probe
+ * answered. */
+static void test_tcp_window(void)
+{
+	static uint8_t frames[ETHIF_RX_FRAMES][ETH_MAX_FRAME_LENGTH];
+	uint32_t sizes[ETHIF_RX_FRAMES];
+	struct tcp_pcb* listener;
+	struct _tcp_info info;
+	uint32_t peer_seq, our_seq, offset, i, n, replies;
+	struct pbuf* q;
+
+	listener = _tcp_accept(&peer_seq, &our_seq);
+
+	/* Fill the window, the ring delivers ETHIF_RX_FRAMES segments at once */
+	for (offset = 0; offset < TCP_WND; offset += n * TCP_MSS) {
+		n = (TCP_WND - offset) / TCP_MSS;
+		if (n > ETHIF_RX_FRAMES)
+			n = ETHIF_RX_FRAMES;
+		for (i = 0; i < n; i++)
+			sizes[i] = _build_tcp(frames[i], peer_seq + offset + i * TCP_MSS,
+					our_seq, TCP_ACK, offset + i * TCP_MSS, TCP_MSS);
+		CHECK(_tcp_exchange(sizes, frames, n, &info, NULL));
+	}
+	CHECK_EQ(app.bytes, TCP_WND);
+	CHECK_EQ(info.ack, peer_seq + TCP_WND);
+	CHECK_EQ(info.wnd, 0);
+
+	/* Zero window probes, a full ring of them */
+	for (i = 0; i < ETHIF_RX_FRAMES; i++)
+		sizes[i] = _build_tcp(frames[i], peer_seq + TCP_WND, our_seq,
+				TCP_ACK, TCP_WND, 1);
+	CHECK(_tcp_exchange(sizes, frames, ETHIF_RX_FRAMES, &info, &replies));
+	CHECK_EQ(replies, ETHIF_RX_FRAMES);
+	CHECK_EQ(info.ack, peer_seq + TCP_WND);
+	CHECK_EQ(info.wnd, 0);
+
+	/* Check and release the data, the window opens again */
+	for (i = 0, offset = 0; i < app.count; i++) {
+		for (q = app.held[i]; q != NULL; q = q->next) {
+			uint32_t j;
+			for (j = 0; j < q->len; j++, offset++)
+				if (((uint8_t*)q->payload)[j] != _tcp_data(offset))
+					break;
+			CHECK_EQ(j, q->len);
+		}
+		pbuf_free(app.held[i]);
+	}
+	CHECK_EQ(offset, TCP_WND);
+	captured.count = 0;
+	tcp_recved(app.pcb, TCP_WND);
+	tcp_output(app.pcb);
+	CHECK_EQ(_transmit(), 1);
+	CHECK(_parse_tcp(captured.frame[0], captured.size[0], &info));
+	CHECK_EQ(info.wnd, TCP_WND);
+
+	_tcp_abort(listener);
+}
+#endif /* CONFIG_LIB_LWIP_THROUGHPUT */
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	struct ip_addr ipaddr, netmask, gw;
+
+	printf("ETHIF_ZERO_COPY=%d ETHIF_RX_BUFFERS=%d PBUF_POOL_SIZE=%d "
+	       "PBUF_POOL_BUFSIZE=%d ETH_PAD_SIZE=%d\n",
+	       ETHIF_ZERO_COPY, ETHIF_RX_BUFFERS, PBUF_POOL_SIZE,
+	       PBUF_POOL_BUFSIZE, ETH_PAD_SIZE);
+
+	lwip_init();
+	IP4_ADDR(&ipaddr, our_ip[0], our_ip[1], our_ip[2], our_ip[3]);
+	IP4_ADDR(&netmask, 255, 255, 255, 0);
+	IP4_ADDR(&gw, peer_ip[0], peer_ip[1], peer_ip[2], peer_ip[3]);
+	ethif_setmac(our_mac);
+	CHECK(netif_add(&netif, &ipaddr, &netmask, &gw, NULL, ethif_init, ip_input) != NULL);
+	netif_set_default(&netif);
+	netif_set_up(&netif);
+	CHECK_EQ(_pool_free_after_poll(), _pool_idle());
+	printf("RX unit size %u\n", loopback_mac_get_rx_unit_size());
+
+	RUN_TEST(test_arp);
+	RUN_TEST(test_ping, 0);
+	RUN_TEST(test_ping, 18);
+	RUN_TEST(test_ping, 100);
+	RUN_TEST(test_ping, 500);
+	RUN_TEST(test_ping, 1000);
+	RUN_TEST(test_ping, 1472);
+	RUN_TEST(test_ping_burst);
+	RUN_TEST(test_pool_exhausted);
+	RUN_TEST(test_tcp_retransmit, TCP_WRITE_FLAG_COPY);
+	RUN_TEST(test_tcp_retransmit, 0);
+#ifdef CONFIG_LIB_LWIP_THROUGHPUT
+	RUN_TEST(test_tcp_window);
+#endif
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,396 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * utils/hamming: codes bit-exact with the former bit-wise implementation
+ * for random, sparse and unaligned buffers, correction of every single-bit
+ * data error, detection of code and double-bit errors, and throughput
+ * against the former implementation.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "hamming.h"
+#include "trace.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest buffer, in 256-byte blocks */
+#define MAX_BLOCKS 8
+
+/** Random buffers per test */
+#define ROUNDS 2000
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/* Room for the largest buffer at any offset within a word */
+static uint8_t buffer[MAX_BLOCKS * 256 + 4];
+static uint8_t saved[MAX_BLOCKS * 256];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Former implementation, kept verbatim */
+
+static uint8_t _old_count_bits_in_byte(uint8_t byte)
+{
+	uint8_t count = 0;
+
+	while (byte > 0) {
+		if (byte & 1) {
+			count++;
+		}
+		byte >>= 1;
+	}
+
+	return count;
+}
+
+static void _old_compute256(const uint8_t *data, uint8_t *code)
+{
+	uint32_t i;
+	uint8_t column_sum = 0;
+	uint8_t even_line_code = 0;
+	uint8_t odd_line_code = 0;
+	uint8_t even_column_code = 0;
+	uint8_t odd_column_code = 0;
+
+	// Xor all bytes together to get the column sum;
+	// At the same time, calculate the even and odd line codes
+	for (i = 0; i < 256; i++) {
+		column_sum ^= data[i];
+
+		// If the xor sum of the byte is 0, then this byte has no incidence on
+		// the computed code; so check if the sum is 1.
+		if ((_old_count_bits_in_byte(data[i]) & 1) == 1) {
+			// Parity groups are formed by forcing a particular index bit to 0
+			// (even) or 1 (odd).
+			// Example on one byte:
+			//
+			// bits (dec)  7   6   5   4   3   2   1   0
+			//      (bin) 111 110 101 100 011 010 001 000
+			//                            '---'---'---'----------.
+			//                                                   |
+			// groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
+			//        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
+			//        P1' ooo eee ooo eee ooo eee ooo eee P1     |
+			//                                                   |
+			// We can see that:                                  |
+			//  - P4  -> bit 2 of index is 0 --------------------'
+			//  - P4' -> bit 2 of index is 1.
+			//  - P2  -> bit 1 of index if 0.
+			//  - etc...
+			// We deduce that a bit position has an impact on all even Px if
+			// the log2(x)nth bit of its index is 0
+			//     ex: log2(4) = 2, bit2 of the index must be 0 (-> 0 1 2 3)
+			// and on all odd Px' if the log2(x)nth bit of its index is 1
+			//     ex: log2(2) = 1, bit1 of the index must be 1 (-> 0 1 4 5)
+			//
+			// As such, we calculate all the possible Px and Px' values at the
+			// same time in two variables, even_line_code and odd_line_code, such as
+			//     even_line_code bits: P128  P64  P32  P16  P8  P4  P2  P1
+			//     odd_line_code  bits: P128' P64' P32' P16' P8' P4' P2' P1'
+			//
+			even_line_code ^= (255 - i);
+			odd_line_code ^= i;
+		}
+	}
+
+	// At this point, we have the line parities, and the column sum. First, We
+	// must caculate the parity group values on the column sum.
+	for (i = 0; i < 8; i++) {
+		if (column_sum & 1) {
+			even_column_code ^= (7 - i);
+			odd_column_code ^= i;
+		}
+		column_sum >>= 1;
+	}
+
+	// Now, we must interleave the parity values, to obtain the following layout:
+	// Code[0] = Line1
+	// Code[1] = Line2
+	// Code[2] = Column
+	// Line = Px' Px P(x-1)- P(x-1) ...
+	// Column = P4' P4 P2' P2 P1' P1 PadBit PadBit
+	code[0] = 0;
+	code[1] = 0;
+	code[2] = 0;
+
+	for (i = 0; i < 4; i++) {
+		code[0] <<= 2;
+		code[1] <<= 2;
+		code[2] <<= 2;
+
+		// Line 1
+		if ((odd_line_code & 0x80) != 0) {
+			code[0] |= 2;
+		}
+
+		if ((even_line_code & 0x80) != 0) {
+			code[0] |= 1;
+		}
+		// Line 2
+		if ((odd_line_code & 0x08) != 0) {
+			code[1] |= 2;
+		}
+
+		if ((even_line_code & 0x08) != 0) {
+			code[1] |= 1;
+		}
+		// Column
+		if ((odd_column_code & 0x04) != 0) {
+			code[2] |= 2;
+		}
+
+		if ((even_column_code & 0x04) != 0) {
+			code[2] |= 1;
+		}
+
+		odd_line_code <<= 1;
+		even_line_code <<= 1;
+		odd_column_code <<= 1;
+		even_column_code <<= 1;
+	}
+
+	// Invert codes (linux compatibility)
+	code[0] = ~code[0];
+	code[1] = ~code[1];
+	code[2] = ~code[2];
+
+	trace_debug("Computed code = %02x %02x %02x\n\r",
+			(unsigned)code[0],
+			(unsigned)code[1],
+			(unsigned)code[2]);
+}
+
+static void _old_compute_256x(const uint8_t *data, uint32_t size,
+		uint8_t *code)
+{
+	while (size > 0) {
+		_old_compute256(data, code);
+		data += 256;
+		code += 3;
+		size -= 256;
+	}
+}
+
+/** Fill a buffer with random bytes, or with a few bits set over zeros or
+ * ones */
+static void _fill(uint8_t *data, uint32_t size)
+{
+	uint32_t i, bits;
+
+	switch (rand() % 4) {
+	case 0:
+	case 1:
+		for (i = 0; i < size; i++)
+			data[i] = rand();
+		break;
+	default:
+		memset(data, (rand() & 1) ? 0xff : 0x00, size);
+		for (bits = rand() % 8; bits; bits--) {
+			i = rand() % (size * 8);
+			data[i / 8] ^= 1 << (i % 8);
+		}
+		break;
+	}
+}
+
+static double _elapsed(const struct timespec* start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+static void test_compat(void)
+{
+	uint8_t code[MAX_BLOCKS * 3], expected[MAX_BLOCKS * 3];
+	uint32_t round, size, offset;
+	uint8_t *data;
+
+	for (round = 0; round < ROUNDS; round++) {
+		size = 256 * (1 + rand() % MAX_BLOCKS);
+		offset = rand() % 4;
+		data = buffer + offset;
+		_fill(data, size);
+
+		_old_compute_256x(data, size, expected);
+		hamming_compute_256x(data, size, code);
+		CHECK_MEM(code, expected, size / 256 * 3, round);
+	}
+}
+
+static void test_single_bit(void)
+{
+	uint8_t code[MAX_BLOCKS * 3];
+	uint32_t round, size, bit;
+	uint8_t *data;
+
+	/* Every bit of a block */
+	data = buffer;
+	_fill(data, 256);
+	hamming_compute_256x(data, 256, code);
+	memcpy(saved, data, 256);
+	for (bit = 0; bit < 256 * 8; bit++) {
+		data[bit / 8] ^= 1 << (bit % 8);
+		CHECK_EQ(hamming_verify_256x(data, 256, code),
+				HAMMING_ERROR_SINGLEBIT);
+		CHECK_MEM(data, saved, 256, bit);
+	}
+
+	/* Random bit of a random block */
+	for (round = 0; round < ROUNDS; round++) {
+		size = 256 * (1 + rand() % MAX_BLOCKS);
+		data = buffer + rand() % 4;
+		_fill(data, size);
+		hamming_compute_256x(data, size, code);
+		memcpy(saved, data, size);
+
+		CHECK_EQ(hamming_verify_256x(data, size, code), 0);
+		bit = rand() % (size * 8);
+		data[bit / 8] ^= 1 << (bit % 8);
+		CHECK_EQ(hamming_verify_256x(data, size, code),
+				HAMMING_ERROR_SINGLEBIT);
+		CHECK_MEM(data, saved, size, round);
+	}
+}
+
+static void test_code_error(void)
+{
+	uint8_t code[3];
+	uint32_t bit;
+
+	_fill(buffer, 256);
+	hamming_compute_256x(buffer, 256, code);
+	memcpy(saved, buffer, 256);
+	for (bit = 0; bit < 24; bit++) {
+		code[bit / 8] ^= 1 << (bit % 8);
+		CHECK_EQ(hamming_verify_256x(buffer, 256, code),
+				HAMMING_ERROR_ECC);
+		CHECK_MEM(buffer, saved, 256, bit);
+		code[bit / 8] ^= 1 << (bit % 8);
+	}
+}
+
+static void test_double_bit(void)
+{
+	uint8_t code[MAX_BLOCKS * 3];
+	uint32_t round, size, block, bit1, bit2;
+	uint8_t *data;
+
+	for (round = 0; round < ROUNDS; round++) {
+		size = 256 * (1 + rand() % MAX_BLOCKS);
+		data = buffer + rand() % 4;
+		_fill(data, size);
+		hamming_compute_256x(data, size, code);
+
+		/* Two different bits of the same block */
+		block = rand() % (size / 256);
+		bit1 = rand() % (256 * 8);
+		do {
+			bit2 = rand() % (256 * 8);
+		} while (bit2 == bit1);
+		data[block * 256 + bit1 / 8] ^= 1 << (bit1 % 8);
+		data[block * 256 + bit2 / 8] ^= 1 << (bit2 % 8);
+		memcpy(saved, data, size);
+
+		CHECK_EQ(hamming_verify_256x(data, size, code),
+				HAMMING_ERROR_MULTIPLEBITS);
+		CHECK_MEM(data, saved, size, round);
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Benchmark
+ *----------------------------------------------------------------------------*/
+
+/* Throughput of the code computation over 64 MB, former and current */
+static void benchmark(void)
+{
+	static uint8_t data[1024 * 1024];
+	static uint8_t code[sizeof(data) / 256 * 3];
+	struct timespec start;
+	double old_mbs, mbs;
+	uint32_t i;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = rand();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 64; i++)
+		_old_compute_256x(data, sizeof(data), code);
+	old_mbs = 64 / _elapsed(&start);
+	printf("former compute: %.0f MB/s\n", old_mbs);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 64; i++)
+		hamming_compute_256x(data, sizeof(data), code);
+	mbs = 64 / _elapsed(&start);
+	printf("compute:        %.0f MB/s (%.1fx former)\n", mbs, mbs / old_mbs);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 64; i++)
+		CHECK_EQ(hamming_verify_256x(data, sizeof(data), code), 0);
+	printf("verify:         %.0f MB/s\n", 64 / _elapsed(&start));
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_compat);
+	RUN_TEST(test_single_bit);
+	RUN_TEST(test_code_error);
+	RUN_TEST(test_double_bit);
+	benchmark();
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,84 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Minimal check helpers shared by the host tests.
+ */
+
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include <stdio.h>
+#include <string.h>
+
+/** Number of failed checks of the test program */
+static int host_test_failures;
+
+/** Report a failed condition and keep going */
+#define CHECK(cond) do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #cond); \
+			host_test_failures++; \
+		} \
+	} while (0)
+
+/** Report a failed comparison of two unsigned values */
+#define CHECK_EQ(a, b) do { \
+		unsigned long long _a = (a), _b = (b); \
+		if (_a != _b) { \
+			fprintf(stderr, "%s:%d: check failed: %s == %s " \
+				"(0x%llx != 0x%llx)\n", __FILE__, __LINE__, \
+				#a, #b, _a, _b); \
+			host_test_failures++; \
+		} \
+	} while (0)
+
+/** Report a buffer differing from the expected one, with the failing case */
+#define CHECK_MEM(a, b, len, id) do { \
+		if (memcmp((a), (b), (len))) { \
+			fprintf(stderr, "%s:%d: check failed: %s == %s " \
+				"(case %u)\n", __FILE__, __LINE__, #a, #b, \
+				(unsigned)(id)); \
+			host_test_failures++; \
+		} \
+	} while (0)
+
+/** Run a test function and print its result */
+#define RUN_TEST(fn, ...) do { \
+		int _before = host_test_failures; \
+		fn(__VA_ARGS__); \
+		printf("%-40s %s\n", #fn "(" #__VA_ARGS__ ")", \
+		       host_test_failures == _before ? "ok" : "FAILED"); \
+	} while (0)
+
+/** Exit status of the test program */
+#define HOST_TEST_EXIT() (host_test_failures ? 1 : 0)
+
+#endif /* _HOST_TEST_H_ */
@@ -0,0 +1,559 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * utils/lz4: round trip of streams built by a reference encoder, hand-made
+ * blocks with overlapping matches and length extensions, the dst_size bound,
+ * truncated streams, and corrupted or malicious streams, which shall fail
+ * without reading or writing outside of the buffers (these are placed
+ * against inaccessible pages). Also reports the decompression throughput.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "compiler.h"
+#include "lz4.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest decompressed size */
+#define MAX_SIZE (96 * 1024)
+
+/** Largest compressed size: literals only, with their length extension */
+#define MAX_BLOCK (MAX_SIZE + MAX_SIZE / 255 + 16)
+
+/** Random streams per test */
+#define ROUNDS 300
+
+/** Entries of the hash table of the reference encoder */
+#define HASH_BITS 12
+
+/** Buffer placed between two inaccessible pages */
+struct guarded {
+	uint8_t *area;
+	size_t area_size;
+	uint8_t *data;  /* first page of the accessible part */
+	size_t size;    /* size of the accessible part */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t original[MAX_SIZE];
+static uint8_t block[MAX_BLOCK];
+static uint8_t output[MAX_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _guarded_alloc(struct guarded *g, size_t size)
+{
+	size_t page = sysconf(_SC_PAGESIZE);
+
+	g->size = (size + page - 1) / page * page;
+	g->area_size = g->size + 2 * page;
+	g->area = mmap(NULL, g->area_size, PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (g->area == MAP_FAILED)
+		abort();
+	g->data = g->area + page;
+	if (mprotect(g->data, g->size, PROT_READ | PROT_WRITE))
+		abort();
+}
+
+static void _guarded_free(struct guarded *g)
+{
+	munmap(g->area, g->area_size);
+}
+
+/**
+ * \brief Place len bytes against the page before (at_end false) or after
+ * (at_end true) the accessible part.
+ */
+static uint8_t *_guarded_place(struct guarded *g, uint32_t len, bool at_end)
+{
+	return at_end ? g->data + g->size - len : g->data;
+}
+
+static uint8_t *_put_length(uint8_t *op, uint32_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+	return op;
+}
+
+static uint8_t *_put_sequence(uint8_t *op, const uint8_t *lit,
+		uint32_t lit_len, uint32_t offset, uint32_t match_len)
+{
+	uint8_t *token = op++;
+
+	*token = (lit_len < 15 ? lit_len : 15) << 4;
+	if (lit_len >= 15)
+		op = _put_length(op, lit_len - 15);
+	memcpy(op, lit, lit_len);
+	op += lit_len;
+	if (!match_len)
+		return op;
+
+	*op++ = offset;
+	*op++ = offset >> 8;
+	match_len -= 4;
+	*token |= match_len < 15 ? match_len : 15;
+	if (match_len >= 15)
+		op = _put_length(op, match_len - 15);
+	return op;
+}
+
+static uint32_t _hash(const uint8_t *p)
+{
+	uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+
+	return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint32_t _match_len(const uint8_t *src, uint32_t cand, uint32_t pos,
+		uint32_t len)
+{
+	uint32_t n = 0;
+
+	/* the match may run into the bytes it produces */
+	while (pos + n < len && src[cand + n] == src[pos + n])
+		n++;
+	return n;
+}
+
+/**
+ * \brief Reference greedy encoder. Runs are always encoded as matches at
+ * offset 1, which overlap their own output.
+ * \return Size of the block.
+ */
+static uint32_t _compress(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+	static uint32_t table[1 << HASH_BITS];
+	uint8_t *op = dst;
+	uint32_t anchor = 0, pos = 0, cand, n, best, best_offset;
+
+	memset(table, 0xff, sizeof(table));
+	while (pos + 4 <= len) {
+		best = 0;
+		best_offset = 0;
+		if (pos > 0) {
+			n = _match_len(src, pos - 1, pos, len);
+			if (n > best) {
+				best = n;
+				best_offset = 1;
+			}
+		}
+		cand = table[_hash(src + pos)];
+		table[_hash(src + pos)] = pos;
+		if (cand != 0xffffffff && pos - cand <= 0xffff) {
+			n = _match_len(src, cand, pos, len);
+			if (n > best) {
+				best = n;
+				best_offset = pos - cand;
+			}
+		}
+		if (best < 4) {
+			pos++;
+			continue;
+		}
+		op = _put_sequence(op, src + anchor, pos - anchor,
+				best_offset, best);
+		pos += best;
+		anchor = pos;
+	}
+	op = _put_sequence(op, src + anchor, len - anchor, 0, 0);
+	return op - dst;
+}
+
+/** Random data made of literals, runs and copies of earlier data */
+static void _fill(uint8_t *data, uint32_t size)
+{
+	uint32_t pos = 0, n, from;
+
+	while (pos < size) {
+		n = 1 + rand() % 300;
+		if (n > size - pos)
+			n = size - pos;
+		switch (rand() % 3) {
+		case 0:
+			while (n--)
+				data[pos++] = rand();
+			break;
+		case 1:
+			memset(data + pos, rand(), n);
+			pos += n;
+			break;
+		case 2:
+			if (pos == 0)
+				break;
+			from = rand() % pos;
+			while (n--)
+				data[pos++] = data[from++];
+			break;
+		}
+	}
+}
+
+static uint32_t _random_size(void)
+{
+	switch (rand() % 4) {
+	case 0:
+		return rand() % 64;
+	case 1:
+		return rand() % 4096;
+	default:
+		return rand() % (MAX_SIZE + 1);
+	}
+}
+
+static double _elapsed(const struct timespec* start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* Hand-made blocks, each with its expected output */
+static void test_vectors(void)
+{
+	static const struct {
+		const uint8_t *block;
+		uint32_t block_len;
+		const char *expected;
+	} vectors[] = {
+		/* empty block and literals only */
+		{ (const uint8_t*)"", 0, "" },
+		{ (const uint8_t*)"\x00", 1, "" },
+		{ (const uint8_t*)"\x50hello", 6, "hello" },
+		/* match at offset 1, overlapping its own output */
+		{ (const uint8_t*)"\x1f" "a" "\x01\x00" "\x02", 5,
+		  "aaaaaaaaaaaaaaaaaaaaaa" },
+		/* match at offset 3 repeating a pattern, then literals */
+		{ (const uint8_t*)"\x35" "abc" "\x03\x00" "\x10" "!", 8,
+		  "abcabcabcabc!" },
+		/* match longer than its offset but not a run */
+		{ (const uint8_t*)"\x40" "abcd" "\x02\x00" "\x00", 8,
+		  "abcdcdcd" },
+		/* non-overlapping match */
+		{ (const uint8_t*)"\x84" "abcdefgh" "\x08\x00" "\x20" "xy", 14,
+		  "abcdefghabcdefghxy" },
+	};
+	uint32_t i, len;
+
+	for (i = 0; i < ARRAY_SIZE(vectors); i++) {
+		memset(output, 0x5a, sizeof(output));
+		len = 0xffffffff;
+		CHECK(lz4_decompress(vectors[i].block, vectors[i].block_len,
+				output, sizeof(output), &len));
+		CHECK_EQ(len, strlen(vectors[i].expected));
+		CHECK_MEM(output, vectors[i].expected, len, i);
+		CHECK_EQ(output[len], 0x5a);
+	}
+}
+
+/* Literal and match lengths with extension bytes, up to several of them */
+static void test_long_lengths(void)
+{
+	static const uint32_t lengths[] = {
+		14, 15, 16, 18, 19, 20, 268, 269, 270, 271, 523, 524, 525,
+		4000, 65535, 65536,
+	};
+	uint32_t i, j, n, len, block_len;
+
+	for (i = 0; i < ARRAY_SIZE(lengths); i++) {
+		for (j = 0; j < 2; j++) {
+			/* j = 0: literals, j = 1: run after one literal */
+			n = lengths[i];
+			if (j == 0) {
+				_fill(original, n);
+				block_len = _put_sequence(block, original, n,
+						0, 0) - block;
+			} else {
+				memset(original, 'z', n + 1);
+				block_len = _put_sequence(block, original, 1,
+						1, n) - block;
+				n++;
+			}
+			CHECK(lz4_decompress(block, block_len, output,
+					sizeof(output), &len));
+			CHECK_EQ(len, n);
+			CHECK_MEM(output, original, n, i * 2 + j);
+		}
+	}
+}
+
+/* Round trip of random data, with the output against a guard page */
+static void test_roundtrip(void)
+{
+	struct guarded dst;
+	uint32_t round, size, block_len, len;
+	uint8_t *out;
+
+	_guarded_alloc(&dst, MAX_SIZE);
+	for (round = 0; round < ROUNDS; round++) {
+		size = _random_size();
+		_fill(original, size);
+		block_len = _compress(original, size, block);
+		out = _guarded_place(&dst, size, round & 1);
+		len = 0xffffffff;
+		CHECK(lz4_decompress(block, block_len, out, size, &len));
+		CHECK_EQ(len, size);
+		CHECK_MEM(out, original, size, round);
+	}
+	_guarded_free(&dst);
+}
+
+/* The output buffer shall hold the whole output, one byte less fails */
+static void test_dst_size(void)
+{
+	struct guarded dst;
+	uint32_t round, size, block_len, len;
+	uint8_t *out;
+
+	_guarded_alloc(&dst, MAX_SIZE);
+	for (round = 0; round < ROUNDS; round++) {
+		size = 1 + _random_size() % MAX_SIZE;
+		_fill(original, size);
+		block_len = _compress(original, size, block);
+
+		out = _guarded_place(&dst, size, true);
+		CHECK(lz4_decompress(block, block_len, out, size, &len));
+		CHECK_EQ(len, size);
+
+		/* the last write would hit the guard page */
+		out = _guarded_place(&dst, size - 1, true);
+		CHECK(!lz4_decompress(block, block_len, out, size - 1, &len));
+	}
+	_guarded_free(&dst);
+}
+
+/*
+ * Every prefix of a block either fails or, when cut right after the literals
+ * of a sequence, gives a prefix of the output. The block is placed against a
+ * guard page to catch reads past its end.
+ */
+static void test_truncated(void)
+{
+	struct guarded src;
+	uint32_t round, size, block_len, cut, len;
+	uint8_t *in;
+
+	_guarded_alloc(&src, MAX_BLOCK);
+	for (round = 0; round < 40; round++) {
+		size = rand() % 2048;
+		_fill(original, size);
+		block_len = _compress(original, size, block);
+		for (cut = 0; cut < block_len; cut++) {
+			in = _guarded_place(&src, cut, true);
+			memcpy(in, block, cut);
+			if (!lz4_decompress(in, cut, output, size, &len))
+				continue;
+			CHECK(len <= size);
+			CHECK_MEM(output, original, len, cut);
+		}
+	}
+	_guarded_free(&src);
+}
+
+/* Hand-made blocks that shall be rejected */
+static void test_malicious(void)
+{
+	static uint8_t run[64 * 1024];
+	static const struct {
+		const uint8_t *block;
+		uint32_t block_len;
+	} vectors[] = {
+		/* offset 0 */
+		{ (const uint8_t*)"\x14" "a" "\x00\x00", 4 },
+		/* offset before the start of the output */
+		{ (const uint8_t*)"\x14" "a" "\x02\x00", 4 },
+		{ (const uint8_t*)"\x04" "\x01\x00", 3 },
+		{ (const uint8_t*)"\x14" "a" "\xff\xff", 4 },
+		/* match offset cut */
+		{ (const uint8_t*)"\x14" "a" "\x01", 3 },
+		/* literal length longer than the block */
+		{ (const uint8_t*)"\x50" "abcd", 5 },
+		{ (const uint8_t*)"\xf0" "\x05" "abcd", 6 },
+		/* literal and match length extensions cut */
+		{ (const uint8_t*)"\xf0", 1 },
+		{ (const uint8_t*)"\xf0" "\xff", 2 },
+		{ (const uint8_t*)"\x1f" "a" "\x01\x00", 4 },
+		{ (const uint8_t*)"\x1f" "a" "\x01\x00" "\xff", 5 },
+	};
+	uint32_t i, len;
+
+	for (i = 0; i < ARRAY_SIZE(vectors); i++)
+		CHECK(!lz4_decompress(vectors[i].block, vectors[i].block_len,
+				output, sizeof(output), &len));
+
+	/* long length extensions cut */
+	memset(run, 0xff, sizeof(run));
+	run[0] = 0xf0;
+	CHECK(!lz4_decompress(run, sizeof(run), output, sizeof(output), &len));
+	run[0] = 0x1f;
+	run[1] = 'a';
+	run[2] = 0x01;
+	run[3] = 0x00;
+	CHECK(!lz4_decompress(run, sizeof(run), output, sizeof(output), &len));
+}
+
+/*
+ * Length extensions wrapping around the 32-bit range to a small length,
+ * which would be accepted if the length were not bounded while read
+ */
+static void test_length_wrap(void)
+{
+	/* 15 + 255 * WRAP_BYTES = 2^32 + 14 */
+	const uint32_t WRAP_BYTES = 16843009;
+	uint8_t *data = malloc(WRAP_BYTES + 32);
+	uint8_t *p;
+	uint32_t len;
+
+	/* literal length */
+	p = data;
+	*p++ = 0xf0;
+	memset(p, 0xff, WRAP_BYTES);
+	p += WRAP_BYTES;
+	*p++ = 0;
+	memcpy(p, "fourteen bytes", 14);
+	p += 14;
+	CHECK(!lz4_decompress(data, p - data, output, sizeof(output), &len));
+
+	/* match length */
+	p = data;
+	*p++ = 0x1f;
+	*p++ = 'a';
+	*p++ = 0x01;
+	*p++ = 0x00;
+	memset(p, 0xff, WRAP_BYTES);
+	p += WRAP_BYTES;
+	*p++ = 0;
+	CHECK(!lz4_decompress(data, p - data, output, sizeof(output), &len));
+
+	free(data);
+}
+
+/*
+ * Random and mutated blocks, with the input and the output against guard
+ * pages: the decoder may fail or not, but shall stay in its buffers, and
+ * anything it outputs shall come from the block.
+ */
+static void test_fuzz(void)
+{
+	struct guarded src, dst;
+	uint32_t round, size, block_len, len, n;
+	uint8_t *in, *out;
+
+	_guarded_alloc(&src, MAX_BLOCK);
+	_guarded_alloc(&dst, MAX_SIZE);
+	for (round = 0; round < 20000; round++) {
+		if (round % 4 == 0) {
+			block_len = rand() % 256;
+			for (n = 0; n < block_len; n++)
+				block[n] = rand();
+		} else {
+			size = rand() % 4096;
+			_fill(original, size);
+			block_len = _compress(original, size, block);
+			for (n = 1 + rand() % 4; n && block_len; n--)
+				block[rand() % block_len] ^= 1 << (rand() % 8);
+		}
+		size = rand() % 8192;
+		in = _guarded_place(&src, block_len, true);
+		memcpy(in, block, block_len);
+		/* output against the page before to catch reads of the
+		 * history before dst, or after to catch writes past the end */
+		out = _guarded_place(&dst, size, round & 1);
+		if (lz4_decompress(in, block_len, out, size, &len))
+			CHECK(len <= size);
+	}
+	_guarded_free(&src);
+	_guarded_free(&dst);
+}
+
+/*----------------------------------------------------------------------------
+ *        Benchmark
+ *----------------------------------------------------------------------------*/
+
+/* Decompression throughput over 64 MB of output */
+static void benchmark(void)
+{
+	struct timespec start;
+	uint32_t i, block_len, len;
+
+	_fill(original, MAX_SIZE);
+	block_len = _compress(original, MAX_SIZE, block);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < 64 * 1024 * 1024 / MAX_SIZE; i++)
+		CHECK(lz4_decompress(block, block_len, output, MAX_SIZE, &len));
+	printf("decompress: %.0f MB/s (ratio %.2f)\n",
+	       64 / _elapsed(&start), (double)MAX_SIZE / block_len);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_vectors);
+	RUN_TEST(test_long_lengths);
+	RUN_TEST(test_roundtrip);
+	RUN_TEST(test_dst_size);
+	RUN_TEST(test_truncated);
+	RUN_TEST(test_malicious);
+	RUN_TEST(test_length_wrap);
+	RUN_TEST(test_fuzz);
+	benchmark();
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,240 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "nand_sim.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _ppn(const struct _nand_sim *sim, uint32_t block,
+		uint32_t page)
+{
+	return block * sim->pages_per_block + page;
+}
+
+/**
+ * \brief Count a program or erase, cutting the power when the count runs
+ * out.
+ * \return true if the power is cut during this operation
+ */
+static bool _power_cut(struct _nand_sim *sim)
+{
+	return sim->ops_before_cut > 0 && --sim->ops_before_cut == 0;
+}
+
+/* An interrupted program leaves some bits of the page programmed */
+static void _tear(uint8_t *dst, const uint8_t *src, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		dst[i] &= src[i] | (uint8_t)rand();
+}
+
+static uint8_t _read_data(void *dev, uint32_t block, uint32_t page,
+		void *data)
+{
+	struct _nand_sim *sim = (struct _nand_sim *)dev;
+	uint32_t ppn = _ppn(sim, block, page);
+
+	if (ppn == sim->unreadable_ppn)
+		return 1;
+	memcpy(data, sim->data + ppn * sim->page_size, sim->page_size);
+	return 0;
+}
+
+static uint8_t _read_tag(void *dev, uint32_t block, uint32_t page,
+		uint8_t *tag)
+{
+	struct _nand_sim *sim = (struct _nand_sim *)dev;
+
+	memcpy(tag, sim->tags + _ppn(sim, block, page) * NAND_FTL_TAG_SIZE,
+			NAND_FTL_TAG_SIZE);
+	return 0;
+}
+
+static uint8_t _write(void *dev, uint32_t block, uint32_t page,
+		const void *data, const uint8_t *tag)
+{
+	struct _nand_sim *sim = (struct _nand_sim *)dev;
+	uint32_t ppn = _ppn(sim, block, page);
+	uint8_t *d = sim->data + ppn * sim->page_size;
+	uint8_t *t = sim->tags + ppn * NAND_FTL_TAG_SIZE;
+
+	sim->writes++;
+	if (sim->bad[block])
+		sim->bad_accesses++;
+	if (sim->programs[ppn]++)
+		sim->reprograms++;
+
+	if (_power_cut(sim)) {
+		_tear(d, (const uint8_t *)data, sim->page_size);
+		_tear(t, tag, NAND_FTL_TAG_SIZE);
+		longjmp(*sim->cut, 1);
+	}
+
+	if (block == sim->fail_write_block) {
+		_tear(d, (const uint8_t *)data, sim->page_size);
+		_tear(t, tag, NAND_FTL_TAG_SIZE);
+		return 1;
+	}
+
+	memcpy(d, data, sim->page_size);
+	memcpy(t, tag, NAND_FTL_TAG_SIZE);
+	return 0;
+}
+
+static uint8_t _erase(void *dev, uint32_t block)
+{
+	struct _nand_sim *sim = (struct _nand_sim *)dev;
+	uint32_t first = _ppn(sim, block, 0);
+	uint32_t page, ppn;
+
+	sim->erases++;
+	if (sim->bad[block])
+		sim->bad_accesses++;
+
+	if (_power_cut(sim)) {
+		/* An interrupted erase leaves each page erased, intact or
+		 * corrupted */
+		for (page = 0; page < sim->pages_per_block; page++) {
+			ppn = first + page;
+			switch (rand() % 3) {
+			case 0:
+				memset(sim->data + ppn * sim->page_size, 0xff,
+						sim->page_size);
+				memset(sim->tags + ppn * NAND_FTL_TAG_SIZE,
+						0xff, NAND_FTL_TAG_SIZE);
+				break;
+			case 1:
+				sim->tags[ppn * NAND_FTL_TAG_SIZE +
+					rand() % NAND_FTL_TAG_SIZE] ^= 0x10;
+				break;
+			}
+			/* The pages may have to be erased again */
+			sim->programs[ppn] = 1;
+		}
+		longjmp(*sim->cut, 1);
+	}
+
+	if (block == sim->fail_erase_block)
+		return 1;
+
+	memset(sim->data + first * sim->page_size, 0xff,
+			sim->pages_per_block * sim->page_size);
+	memset(sim->tags + first * NAND_FTL_TAG_SIZE, 0xff,
+			sim->pages_per_block * NAND_FTL_TAG_SIZE);
+	memset(sim->programs + first, 0, sim->pages_per_block);
+	sim->erase_counts[block]++;
+	if (sim->fail_next_erased) {
+		sim->fail_write_block = block;
+		sim->fail_next_erased = false;
+	}
+	return 0;
+}
+
+static bool _is_bad(void *dev, uint32_t block)
+{
+	struct _nand_sim *sim = (struct _nand_sim *)dev;
+
+	return sim->bad[block];
+}
+
+static void _mark_bad(void *dev, uint32_t block)
+{
+	struct _nand_sim *sim = (struct _nand_sim *)dev;
+
+	sim->bad[block] = true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported symbols
+ *----------------------------------------------------------------------------*/
+
+const struct _nand_ftl_ops nand_sim_ops = {
+	.read_data = _read_data,
+	.read_tag = _read_tag,
+	.write = _write,
+	.erase = _erase,
+	.is_bad = _is_bad,
+	.mark_bad = _mark_bad,
+};
+
+void nand_sim_init(struct _nand_sim *sim, uint32_t num_blocks,
+		uint32_t pages_per_block, uint32_t page_size)
+{
+	uint32_t pages = num_blocks * pages_per_block;
+
+	memset(sim, 0, sizeof(*sim));
+	sim->num_blocks = num_blocks;
+	sim->pages_per_block = pages_per_block;
+	sim->page_size = page_size;
+	sim->data = malloc(pages * page_size);
+	sim->tags = malloc(pages * NAND_FTL_TAG_SIZE);
+	sim->programs = calloc(pages, 1);
+	sim->bad = calloc(num_blocks, sizeof(bool));
+	sim->erase_counts = calloc(num_blocks, sizeof(uint32_t));
+	memset(sim->data, 0xff, pages * page_size);
+	memset(sim->tags, 0xff, pages * NAND_FTL_TAG_SIZE);
+	sim->fail_write_block = NAND_FTL_NONE;
+	sim->fail_erase_block = NAND_FTL_NONE;
+	sim->unreadable_ppn = NAND_FTL_NONE;
+}
+
+void nand_sim_free(struct _nand_sim *sim)
+{
+	free(sim->data);
+	free(sim->tags);
+	free(sim->programs);
+	free(sim->bad);
+	free(sim->erase_counts);
+}
+
+uint32_t nand_sim_wear_spread(const struct _nand_sim *sim)
+{
+	uint32_t i, min = NAND_FTL_NONE, max = 0;
+
+	for (i = 0; i < sim->num_blocks; i++) {
+		if (sim->bad[i])
+			continue;
+		if (sim->erase_counts[i] < min)
+			min = sim->erase_counts[i];
+		if (sim->erase_counts[i] > max)
+			max = sim->erase_counts[i];
+	}
+	return max - min;
+}
@@ -0,0 +1,94 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Simulated NAND flash behind struct _nand_ftl_ops, with factory bad
+ * blocks, program and erase failures, uncorrectable pages and power cuts.
+ */
+
+#ifndef _NAND_SIM_H_
+#define _NAND_SIM_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "nand_ftl.h"
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _nand_sim {
+	uint32_t num_blocks;
+	uint32_t pages_per_block;
+	uint32_t page_size;
+
+	uint8_t *data;           /**< page data, num_blocks * ppb * page_size */
+	uint8_t *tags;           /**< page tags, NAND_FTL_TAG_SIZE per page */
+	uint8_t *programs;       /**< programs of each page since its erase */
+	bool *bad;               /**< bad block markers */
+	uint32_t *erase_counts;  /**< erases of each block */
+
+	/* Fault injection */
+	uint32_t fail_write_block;  /**< block whose programs fail */
+	uint32_t fail_erase_block;  /**< block whose erases fail */
+	bool fail_next_erased;      /**< make the next block erased the one
+	                                 whose programs fail */
+	uint32_t unreadable_ppn;    /**< page with uncorrectable data */
+	long ops_before_cut;        /**< programs and erases until the power
+	                                 cut, 0 for none */
+	jmp_buf *cut;               /**< jumped to on power cut */
+
+	/* Counters */
+	uint32_t writes;
+	uint32_t erases;
+	uint32_t reprograms;        /**< programs of a page not erased */
+	uint32_t bad_accesses;      /**< programs or erases of bad blocks */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported symbols
+ *----------------------------------------------------------------------------*/
+
+extern const struct _nand_ftl_ops nand_sim_ops;
+
+extern void nand_sim_init(struct _nand_sim *sim, uint32_t num_blocks,
+		uint32_t pages_per_block, uint32_t page_size);
+
+extern void nand_sim_free(struct _nand_sim *sim);
+
+/** Erase spread of the good blocks */
+extern uint32_t nand_sim_wear_spread(const struct _nand_sim *sim);
+
+#endif /* _NAND_SIM_H_ */
@@ -0,0 +1,587 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * nand_ftl.c on a simulated NAND flash: mount and replay, power cuts
+ * during programs and erases, factory and runtime bad blocks, and the
+ * wear leveling of static data and the write amplification of a few
+ * workloads.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "nand_ftl.h"
+#include "nand_sim.h"
+
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define NUM_BLOCKS       64
+#define PAGES_PER_BLOCK  16
+#define PAGE_SIZE        32
+#define RESERVED_BLOCKS  6
+
+#define NUM_PAGES NAND_FTL_NUM_PAGES(NUM_BLOCKS, PAGES_PER_BLOCK, \
+		RESERVED_BLOCKS)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _nand_sim sim;
+static struct _nand_ftl ftl;
+static uint32_t map[NUM_PAGES];
+static struct _nand_ftl_block blocks[NUM_BLOCKS];
+static uint8_t page_buf[PAGE_SIZE];
+
+/** Version last written to each logical page, 0 if never written */
+static uint32_t model[NUM_PAGES];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _setup(void)
+{
+	nand_sim_init(&sim, NUM_BLOCKS, PAGES_PER_BLOCK, PAGE_SIZE);
+	memset(model, 0, sizeof(model));
+}
+
+static uint8_t _mount(void)
+{
+	return nand_ftl_mount(&ftl, &nand_sim_ops, &sim, NUM_BLOCKS,
+			PAGES_PER_BLOCK, PAGE_SIZE, RESERVED_BLOCKS, map, blocks,
+			page_buf);
+}
+
+static void _fill(uint8_t *data, uint32_t lpn, uint32_t version)
+{
+	uint32_t i;
+
+	for (i = 0; i < PAGE_SIZE; i += 8) {
+		memcpy(data + i, &lpn, 4);
+		memcpy(data + i + 4, &version, 4);
+	}
+}
+
+static uint8_t _write(uint32_t lpn, uint32_t version)
+{
+	uint8_t data[PAGE_SIZE];
+
+	_fill(data, lpn, version);
+	return nand_ftl_write(&ftl, lpn, data);
+}
+
+/** Return the version read from a logical page, 0 if erased, NAND_FTL_NONE
+ * if the content is inconsistent */
+static uint32_t _read_version(uint32_t lpn)
+{
+	uint8_t data[PAGE_SIZE], expected[PAGE_SIZE];
+	uint32_t version;
+
+	if (nand_ftl_read(&ftl, lpn, data) != NAND_FTL_SUCCESS)
+		return NAND_FTL_NONE;
+	memset(expected, 0xff, PAGE_SIZE);
+	if (!memcmp(data, expected, PAGE_SIZE))
+		return 0;
+	memcpy(&version, data + 4, 4);
+	_fill(expected, lpn, version);
+	return memcmp(data, expected, PAGE_SIZE) ? NAND_FTL_NONE : version;
+}
+
+/** Number of logical pages not matching the model */
+static uint32_t _check_model(void)
+{
+	uint32_t lpn, errors = 0;
+
+	for (lpn = 0; lpn < NUM_PAGES; lpn++)
+		if (_read_version(lpn) != model[lpn])
+			errors++;
+	return errors;
+}
+
+/** Random logical page, a quarter of them taking 3/4 of the writes */
+static uint32_t _hot_cold_page(void)
+{
+	return (rand() % 4) ? rand() % (NUM_PAGES / 4) : rand() % NUM_PAGES;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+static void test_mount_blank(void)
+{
+	struct _nand_ftl_stats stats;
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(ftl.num_pages, NUM_PAGES);
+	CHECK_EQ(ftl.free_blocks, NUM_BLOCKS);
+	CHECK_EQ(_check_model(), 0);
+	CHECK_EQ(nand_ftl_read(&ftl, NUM_PAGES, page_buf), NAND_FTL_ERROR_RANGE);
+	CHECK_EQ(_write(NUM_PAGES, 1), NAND_FTL_ERROR_RANGE);
+
+	/* Mounting only reads */
+	CHECK_EQ(sim.writes + sim.erases, 0);
+	nand_ftl_get_stats(&ftl, &stats);
+	CHECK_EQ(stats.host_writes + stats.flash_writes + stats.erases, 0);
+
+	CHECK_EQ(nand_ftl_mount(&ftl, &nand_sim_ops, &sim, NUM_BLOCKS,
+			PAGES_PER_BLOCK, PAGE_SIZE, NAND_FTL_MIN_RESERVED - 1,
+			map, blocks, page_buf), NAND_FTL_ERROR_PARAM);
+	nand_sim_free(&sim);
+}
+
+/* Overwrite the pages several times, with garbage collection, and rebuild
+ * the map from the tags */
+static void test_replay(void)
+{
+	uint32_t i, lpn, version = 0;
+	uint32_t free_blocks, seq, valid[NUM_BLOCKS];
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	for (i = 0; i < 4 * NUM_PAGES; i++) {
+		lpn = _hot_cold_page();
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	CHECK_EQ(_check_model(), 0);
+
+	free_blocks = ftl.free_blocks;
+	seq = ftl.seq;
+	for (i = 0; i < NUM_BLOCKS; i++)
+		valid[i] = blocks[i].valid;
+	i = sim.writes + sim.erases;
+
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(sim.writes + sim.erases, i);
+	CHECK_EQ(_check_model(), 0);
+	CHECK_EQ(ftl.seq, seq);
+	/* The open block is counted as used until the next write */
+	CHECK(ftl.free_blocks == free_blocks || ftl.free_blocks == free_blocks + 1);
+	for (i = 0; i < NUM_BLOCKS; i++)
+		CHECK_EQ(blocks[i].valid, valid[i]);
+	for (i = 0; i < NUM_BLOCKS; i++)
+		CHECK_EQ(blocks[i].erase_count, sim.erase_counts[i]);
+
+	/* Keep writing after the remount */
+	for (i = 0; i < NUM_PAGES; i++) {
+		lpn = _hot_cold_page();
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(_check_model(), 0);
+	CHECK_EQ(sim.reprograms, 0);
+	nand_sim_free(&sim);
+}
+
+/* Cut the power at random points of programs and erases, then check that
+ * every logical page holds either its last version or, for the page being
+ * written, the previous one */
+static void test_power_cut(unsigned rounds)
+{
+	jmp_buf cut;
+	volatile uint32_t version = 0;
+	volatile unsigned round;
+	volatile uint32_t inflight, inflight_version;
+	volatile uint32_t errors = 0, torn = 0;
+	uint32_t lpn, v;
+
+	_setup();
+	sim.cut = &cut;
+	srand(1);
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+
+	for (round = 0; round < rounds; round++) {
+		inflight = NAND_FTL_NONE;
+		sim.ops_before_cut = 1 + rand() % (2 * NUM_BLOCKS * PAGES_PER_BLOCK);
+		if (!setjmp(cut)) {
+			for (;;) {
+				lpn = _hot_cold_page();
+				inflight = lpn;
+				inflight_version = version + 1;
+				if (_write(lpn, inflight_version) != NAND_FTL_SUCCESS) {
+					errors++;
+					break;
+				}
+				model[lpn] = ++version;
+				inflight = NAND_FTL_NONE;
+				if (rand() % 16 == 0)
+					nand_ftl_collect(&ftl);
+			}
+		}
+		sim.ops_before_cut = 0;
+
+		if (_mount() != NAND_FTL_SUCCESS) {
+			errors++;
+			break;
+		}
+		if (inflight != NAND_FTL_NONE) {
+			v = _read_version(inflight);
+			if (v == inflight_version) {
+				model[inflight] = inflight_version;
+				version = inflight_version;
+			} else {
+				torn++;
+			}
+		}
+		errors += _check_model();
+	}
+
+	CHECK_EQ(errors, 0);
+	CHECK_EQ(sim.reprograms, 0);
+	printf("    %u power cuts, %u interrupted writes lost, %u writes\n",
+			rounds, (unsigned)torn, (unsigned)version);
+	nand_sim_free(&sim);
+}
+
+/* Factory bad blocks are never programmed nor erased */
+static void test_factory_bad_blocks(void)
+{
+	uint32_t i, lpn, version = 0;
+
+	_setup();
+	sim.bad[0] = sim.bad[17] = sim.bad[NUM_BLOCKS - 1] = true;
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(ftl.good_blocks, NUM_BLOCKS - 3);
+	for (i = 0; i < 3 * NUM_PAGES; i++) {
+		lpn = rand() % NUM_PAGES;
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	CHECK_EQ(sim.bad_accesses, 0);
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(_check_model(), 0);
+
+	/* Too many bad blocks to export the logical pages */
+	for (i = 0; i < RESERVED_BLOCKS; i++)
+		sim.bad[1 + i] = true;
+	CHECK_EQ(_mount(), NAND_FTL_ERROR_FULL);
+	nand_sim_free(&sim);
+}
+
+/* A program failure in a block holding valid pages queues the block for
+ * retirement: its pages are moved before the block is marked bad */
+static void test_program_failure(void)
+{
+	struct _nand_ftl_stats stats;
+	uint32_t i, lpn, version = 0, block;
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	for (lpn = 0; lpn < PAGES_PER_BLOCK + PAGES_PER_BLOCK / 2; lpn++) {
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	block = ftl.open;
+	CHECK_EQ(blocks[block].valid, PAGES_PER_BLOCK / 2);
+
+	/* The write lands in another block, the failed one is retiring */
+	sim.fail_write_block = block;
+	CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+	model[lpn] = version;
+	CHECK(ftl.open != block);
+	CHECK_EQ(ftl.retiring, 1);
+	CHECK(!sim.bad[block]);
+	CHECK_EQ(_check_model(), 0);
+
+	/* The next write evacuates and retires it */
+	CHECK_EQ(_write(0, ++version), NAND_FTL_SUCCESS);
+	model[0] = version;
+	CHECK_EQ(ftl.retiring, 0);
+	CHECK(sim.bad[block]);
+	CHECK_EQ(blocks[block].valid, 0);
+	nand_ftl_get_stats(&ftl, &stats);
+	CHECK_EQ(stats.bad_blocks, 1);
+	CHECK(stats.gc_copies >= PAGES_PER_BLOCK / 2 - 1);
+	CHECK_EQ(_check_model(), 0);
+
+	/* The retired block stays out of use */
+	i = sim.bad_accesses;
+	for (lpn = 0; lpn < 2 * NUM_PAGES; lpn++) {
+		CHECK_EQ(_write(lpn % NUM_PAGES, ++version), NAND_FTL_SUCCESS);
+		model[lpn % NUM_PAGES] = version;
+	}
+	CHECK_EQ(sim.bad_accesses, i);
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(_check_model(), 0);
+	CHECK_EQ(ftl.good_blocks, NUM_BLOCKS - 1);
+	nand_sim_free(&sim);
+}
+
+/* Retirement through the background collection, and a program failure in
+ * a block without valid pages, retired at once */
+static void test_program_failure_collect(void)
+{
+	uint32_t lpn, version = 0, block;
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	for (lpn = 0; lpn < PAGES_PER_BLOCK / 2; lpn++) {
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	block = ftl.open;
+	sim.fail_write_block = block;
+	CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+	model[lpn] = version;
+	CHECK_EQ(ftl.retiring, 1);
+	CHECK(nand_ftl_collect(&ftl));
+	CHECK_EQ(ftl.retiring, 0);
+	CHECK(sim.bad[block]);
+	CHECK_EQ(_check_model(), 0);
+
+	/* Fail the first page of the next block: nothing to move */
+	sim.fail_write_block = NAND_FTL_NONE;
+	while (ftl.next_page != PAGES_PER_BLOCK) {
+		CHECK_EQ(_write(++lpn % NUM_PAGES, ++version), NAND_FTL_SUCCESS);
+		model[lpn % NUM_PAGES] = version;
+	}
+	block = ftl.open;
+	sim.fail_next_erased = true;
+	CHECK_EQ(_write(++lpn % NUM_PAGES, ++version), NAND_FTL_SUCCESS);
+	model[lpn % NUM_PAGES] = version;
+	CHECK(sim.fail_write_block != block);
+	CHECK(sim.bad[sim.fail_write_block]);
+	CHECK_EQ(ftl.retiring, 0);
+	CHECK_EQ(ftl.stats.bad_blocks, 2);
+	CHECK_EQ(_check_model(), 0);
+
+	/* Fail a page of a block holding valid data */
+	block = ftl.open;
+	CHECK_EQ(ftl.next_page, 1);
+	sim.fail_write_block = block;
+	CHECK_EQ(_write(++lpn % NUM_PAGES, ++version), NAND_FTL_SUCCESS);
+	model[lpn % NUM_PAGES] = version;
+	CHECK_EQ(ftl.retiring, 1);
+	sim.fail_write_block = NAND_FTL_NONE;
+	CHECK_EQ(_write(++lpn % NUM_PAGES, ++version), NAND_FTL_SUCCESS);
+	model[lpn % NUM_PAGES] = version;
+	CHECK(sim.bad[block]);
+	CHECK_EQ(_check_model(), 0);
+	nand_sim_free(&sim);
+}
+
+/* An erase failure retires the block and the next free block is used */
+static void test_erase_failure(void)
+{
+	uint32_t i, lpn, version = 0;
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	/* Blocks are opened by increasing erase count and index: block 1 is
+	 * the second one */
+	sim.fail_erase_block = 1;
+	for (i = 0; i < 4 * PAGES_PER_BLOCK; i++) {
+		lpn = i % NUM_PAGES;
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	CHECK(sim.bad[1]);
+	CHECK_EQ(ftl.good_blocks, NUM_BLOCKS - 1);
+	CHECK_EQ(ftl.stats.bad_blocks, 1);
+	CHECK_EQ(_check_model(), 0);
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	CHECK_EQ(_check_model(), 0);
+	nand_sim_free(&sim);
+}
+
+/* A page that cannot be read back while its block is evacuated is lost,
+ * the others are moved */
+static void test_uncorrectable_page(void)
+{
+	struct _nand_ftl_stats stats;
+	uint32_t lpn, version = 0, ppn;
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	for (lpn = 0; lpn < 2 * PAGES_PER_BLOCK; lpn++) {
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	ppn = map[3];
+	sim.unreadable_ppn = ppn;
+	CHECK_EQ(_read_version(3), NAND_FTL_NONE);
+
+	/* Make the first block the garbage collection victim */
+	CHECK_EQ(_write(0, ++version), NAND_FTL_SUCCESS);
+	model[0] = version;
+	ftl.gc_threshold = NUM_BLOCKS;
+	while (blocks[ppn / PAGES_PER_BLOCK].valid)
+		CHECK(nand_ftl_collect(&ftl));
+	model[3] = 0;
+
+	nand_ftl_get_stats(&ftl, &stats);
+	CHECK_EQ(stats.lost_pages, 1);
+	CHECK_EQ(map[3], NAND_FTL_NONE);
+	CHECK_EQ(_check_model(), 0);
+	nand_sim_free(&sim);
+}
+
+/** Rewrite a hot eighth of the logical space after filling it once, so
+ * that the blocks holding the cold pages are never reclaimed by garbage
+ * collection. Return the erase count spread of the simulated flash. */
+static uint32_t _static_data_spread(uint32_t wl_threshold,
+		uint32_t *wl_copies)
+{
+	struct _nand_ftl_stats stats;
+	uint32_t i, lpn, version = 0;
+	uint32_t spread;
+
+	_setup();
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+	ftl.wl_threshold = wl_threshold;
+
+	for (lpn = 0; lpn < NUM_PAGES; lpn++) {
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+		model[lpn] = version;
+	}
+	for (i = 0; i < 40 * NUM_PAGES; i++) {
+		lpn = rand() % (NUM_PAGES / 8);
+		if (_write(lpn, ++version) != NAND_FTL_SUCCESS)
+			break;
+		model[lpn] = version;
+	}
+	CHECK_EQ(i, 40 * NUM_PAGES);
+	CHECK_EQ(_check_model(), 0);
+
+	nand_ftl_get_stats(&ftl, &stats);
+	*wl_copies = stats.wl_copies;
+	spread = nand_sim_wear_spread(&sim);
+	nand_sim_free(&sim);
+	return spread;
+}
+
+static void test_wear_leveling(void)
+{
+	const uint32_t threshold = 8;
+	uint32_t spread, wl_copies;
+
+	/* Without wear leveling the cold blocks are left behind */
+	spread = _static_data_spread(NAND_FTL_NONE, &wl_copies);
+	CHECK_EQ(wl_copies, 0);
+	CHECK(spread > 10 * threshold);
+
+	/* Wear leveling is only triggered every threshold erases, allow
+	 * the hot blocks to run that far ahead once more */
+	spread = _static_data_spread(threshold, &wl_copies);
+	printf("    wl %u pages, erase spread %u\n", (unsigned)wl_copies,
+			(unsigned)spread);
+	CHECK(wl_copies > 0);
+	CHECK(spread <= 2 * threshold + 1);
+}
+
+/*----------------------------------------------------------------------------
+ *        Write amplification
+ *----------------------------------------------------------------------------*/
+
+enum _workload {
+	WORKLOAD_SEQUENTIAL,
+	WORKLOAD_UNIFORM,
+	WORKLOAD_HOT_COLD,
+};
+
+static void benchmark(enum _workload workload, const char *name,
+		double max_wa)
+{
+	static const char *names[] = { "sequential", "uniform", "hot/cold" };
+	struct _nand_ftl_stats stats;
+	uint32_t i, lpn = 0, version = 0;
+	double wa;
+
+	_setup();
+	srand(2);
+	CHECK_EQ(_mount(), NAND_FTL_SUCCESS);
+
+	/* Fill the logical space, then measure 20 drive writes */
+	for (lpn = 0; lpn < NUM_PAGES; lpn++)
+		CHECK_EQ(_write(lpn, ++version), NAND_FTL_SUCCESS);
+	nand_ftl_reset_stats(&ftl);
+
+	for (i = 0; i < 20 * NUM_PAGES; i++) {
+		switch (workload) {
+		case WORKLOAD_SEQUENTIAL:
+			lpn = i % NUM_PAGES;
+			break;
+		case WORKLOAD_UNIFORM:
+			lpn = rand() % NUM_PAGES;
+			break;
+		case WORKLOAD_HOT_COLD:
+			lpn = _hot_cold_page();
+			break;
+		}
+		if (_write(lpn, ++version) != NAND_FTL_SUCCESS)
+			break;
+		if (i % 8 == 0)
+			nand_ftl_collect(&ftl);
+	}
+	CHECK_EQ(i, 20 * NUM_PAGES);
+
+	nand_ftl_get_stats(&ftl, &stats);
+	wa = (double)stats.flash_writes / stats.host_writes;
+	printf("    %-10s WA %.2f (gc %u, wl %u pages), erase spread %u\n",
+			names[workload], wa, (unsigned)stats.gc_copies,
+			(unsigned)stats.wl_copies,
+			(unsigned)nand_sim_wear_spread(&sim));
+	CHECK(wa <= max_wa);
+	nand_sim_free(&sim);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	RUN_TEST(test_mount_blank);
+	RUN_TEST(test_replay);
+	RUN_TEST(test_power_cut, 500);
+	RUN_TEST(test_factory_bad_blocks);
+	RUN_TEST(test_program_failure);
+	RUN_TEST(test_program_failure_collect);
+	RUN_TEST(test_erase_failure);
+	RUN_TEST(test_uncorrectable_page);
+	RUN_TEST(test_wear_leveling);
+	RUN_TEST(benchmark, WORKLOAD_SEQUENTIAL, "sequential", 1.0);
+	RUN_TEST(benchmark, WORKLOAD_UNIFORM, "uniform", 6.5);
+	RUN_TEST(benchmark, WORKLOAD_HOT_COLD, "hot/cold", 6.5);
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,156 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * nand_model_find() against nand_flash_model_list: the binary search
+ * requires the list to be sorted by device ID, and must select the same
+ * model as a linear search for every device ID, including duplicated IDs
+ * and large block devices whose geometry comes from ID4.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "chip.h"
+
+#include "nand_flash_common.h"
+#include "nand_flash_model.h"
+#include "nand_flash_model_list.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/** Linear search for the first model with the device ID of chip_id, as
+ * nand_model_find() did before the list was sorted */
+static uint8_t _linear_find(uint32_t chip_id, struct _nand_flash_model *model)
+{
+	uint8_t id2 = (chip_id >> 8) & 0xff;
+	uint8_t id4 = (chip_id >> 24) & 0xff;
+	int i;
+
+	for (i = 0; i < nand_flash_model_list_size; i++) {
+		if (nand_flash_model_list[i].device_id != id2)
+			continue;
+		memcpy(model, &nand_flash_model_list[i], sizeof(*model));
+		if (model->block_size_in_kbytes == 0 ||
+		    model->page_size_in_bytes == 0) {
+			model->page_size_in_bytes = 1024 << (id4 & 0x03);
+			model->block_size_in_kbytes = 64 << ((id4 & 0x30) >> 4);
+		}
+		return nand_model_compute_geometry(model);
+	}
+	return NAND_ERROR_UNKNOWNMODEL;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+static void test_sorted(void)
+{
+	int i;
+
+	CHECK(nand_flash_model_list_size > 0);
+	for (i = 1; i < nand_flash_model_list_size; i++)
+		CHECK(nand_flash_model_list[i - 1].device_id <=
+				nand_flash_model_list[i].device_id);
+}
+
+static void test_find(void)
+{
+	static const uint8_t id4s[] = { 0x00, 0x15, 0x26, 0x33 };
+	struct _nand_flash_model model, expected;
+	uint32_t id2, i, chip_id;
+	uint8_t status;
+
+	for (id2 = 0; id2 < 256; id2++) {
+		for (i = 0; i < ARRAY_SIZE(id4s); i++) {
+			chip_id = 0x2c | (id2 << 8) | (0x90 << 16) |
+				((uint32_t)id4s[i] << 24);
+			memset(&model, 0, sizeof(model));
+			memset(&expected, 0, sizeof(expected));
+			status = _linear_find(chip_id, &expected);
+			CHECK_EQ(nand_model_find(nand_flash_model_list,
+					nand_flash_model_list_size, chip_id, &model),
+					status);
+			CHECK_EQ(nand_model_find(nand_flash_model_list,
+					nand_flash_model_list_size, chip_id, NULL),
+					status == NAND_ERROR_UNKNOWNMODEL ?
+					NAND_ERROR_UNKNOWNMODEL : 0);
+			if (status == 0)
+				CHECK_MEM(&model, &expected, sizeof(model), id2);
+		}
+	}
+}
+
+static void test_geometry(void)
+{
+	struct _nand_flash_model model;
+	uint32_t block_size;
+	int i;
+
+	for (i = 0; i < nand_flash_model_list_size; i++) {
+		memcpy(&model, &nand_flash_model_list[i], sizeof(model));
+		if (model.page_size_in_bytes == 0)
+			model.page_size_in_bytes = 2048;
+		if (model.block_size_in_kbytes == 0)
+			model.block_size_in_kbytes = 128;
+		CHECK_EQ(nand_model_compute_geometry(&model), 0);
+		block_size = model.block_size_in_kbytes * 1024;
+		CHECK_EQ(nand_model_get_page_data_size(&model),
+				model.page_size_in_bytes);
+		CHECK_EQ(nand_model_get_block_size_in_bytes(&model), block_size);
+		CHECK_EQ(nand_model_get_block_size_in_pages(&model),
+				block_size / model.page_size_in_bytes);
+		CHECK_EQ(nand_model_get_device_size_in_blocks(&model),
+				model.device_size_in_mega_bytes * 1024 /
+				model.block_size_in_kbytes);
+		CHECK_EQ(nand_model_get_device_size_in_mbytes(&model),
+				model.device_size_in_mega_bytes);
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	RUN_TEST(test_sorted);
+	RUN_TEST(test_find);
+	RUN_TEST(test_geometry);
+	return HOST_TEST_EXIT();
+}
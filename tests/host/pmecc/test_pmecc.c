@@ -0,0 +1,480 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * drivers/peripherals/pmecc_bch.c against a software BCH encoder, for
+ * 512-byte (GF(2^13)) and 1024-byte (GF(2^14)) sectors and every PMECC
+ * correcting capability from 2 to 24 errors.
+ *
+ * The encoder builds the generator polynomial from the minimal polynomials
+ * of alpha^1, alpha^3 ... alpha^(2t-1), appends the ECC after the sector so
+ * that the codeword is a multiple of it, and computes the remainders of the
+ * received word the way the PMECC does. Random data gets up to t random bit
+ * errors, which shall all be located and corrected, or t + 1 errors, which
+ * shall be reported as uncorrectable or turned into another codeword, never
+ * into a word that is not a codeword. A benchmark reports the corrections
+ * per second with t errors per sector.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "peripherals/pmecc_bch.h"
+#include "peripherals/pmecc_gf_512.h"
+#include "peripherals/pmecc_gf_1024.h"
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest sector, in bytes */
+#define MAX_SECTOR_SIZE 1024
+
+/** Largest ECC, in bits: 24 errors in GF(2^14) */
+#define MAX_ECC_BITS (24 * 14)
+
+/** Largest codeword, in bytes */
+#define MAX_CODEWORD_SIZE (MAX_SECTOR_SIZE + (MAX_ECC_BITS + 7) / 8)
+
+/** Polynomials over GF(2), as bit sets: bit n is the coefficient of x^n */
+#define POLY_WORDS ((MAX_ECC_BITS + 64) / 64)
+
+/** Random codewords per sector size and capability */
+#define CORRECT_ROUNDS 200
+#define UNCORRECTABLE_ROUNDS 100
+
+/** Sectors decoded per benchmark round */
+#define BENCH_SECTORS 32
+
+/** Encoder of a BCH code */
+struct _bch_code {
+	uint32_t sector_size;
+	uint32_t mm;
+	uint32_t tt;
+	int32_t nn;
+	const int16_t *alpha_to;
+	const int16_t *index_of;
+	/** Minimal polynomials of alpha^(2i+1), bit n is the coefficient of x^n */
+	uint32_t minimal[PMECC_BCH_MAX_ERRORS];
+	uint32_t minimal_degree[PMECC_BCH_MAX_ERRORS];
+	/** Generator polynomial */
+	uint64_t generator[POLY_WORDS];
+	uint32_t generator_degree;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _bch_code code;
+
+static uint8_t original[MAX_CODEWORD_SIZE];
+static uint8_t received[MAX_CODEWORD_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _get_bit(const uint8_t *buf, uint32_t bit)
+{
+	return (buf[bit >> 3] >> (bit & 7)) & 1;
+}
+
+static void _flip_bit(uint8_t *buf, uint32_t bit)
+{
+	buf[bit >> 3] ^= 1 << (bit & 7);
+}
+
+static int16_t _gf_mul(int16_t a, int16_t b)
+{
+	if (a == 0 || b == 0)
+		return 0;
+	return code.alpha_to[(code.index_of[a] + code.index_of[b]) % code.nn];
+}
+
+/* Product of (x + alpha^e) over the conjugates e of alpha^i */
+static uint32_t _minimal_polynomial(uint32_t i, uint32_t *degree)
+{
+	int16_t coef[16] = { 1 };
+	uint32_t deg = 0, e = i, k, poly = 0;
+
+	do {
+		int16_t root = code.alpha_to[e];
+
+		coef[deg + 1] = 0;
+		for (k = deg + 1; k > 0; k--)
+			coef[k] = coef[k - 1] ^ _gf_mul(coef[k], root);
+		coef[0] = _gf_mul(coef[0], root);
+		deg++;
+		e = (2 * e) % code.nn;
+	} while (e != i);
+
+	for (k = 0; k <= deg; k++) {
+		/* The coefficients of a minimal polynomial are in GF(2) */
+		CHECK(coef[k] == 0 || coef[k] == 1);
+		poly |= (uint32_t)coef[k] << k;
+	}
+	*degree = deg;
+	return poly;
+}
+
+static void _poly_mul(uint64_t *poly, uint32_t factor)
+{
+	uint64_t product[POLY_WORDS] = { 0 };
+	uint32_t b, w;
+
+	for (b = 0; b < 32; b++) {
+		if (!(factor & (1u << b)))
+			continue;
+		for (w = 0; w < POLY_WORDS; w++) {
+			product[w] ^= poly[w] << b;
+			if (b && w + 1 < POLY_WORDS)
+				product[w + 1] ^= poly[w] >> (64 - b);
+		}
+	}
+	memcpy(poly, product, sizeof(product));
+}
+
+static void _code_init(uint32_t sector_size, uint32_t tt)
+{
+	uint32_t i, j;
+
+	memset(&code, 0, sizeof(code));
+	code.sector_size = sector_size;
+	code.tt = tt;
+	if (sector_size == 512) {
+		code.mm = 13;
+		pmecc_get_gf_512_tables(&code.alpha_to, &code.index_of);
+	} else {
+		code.mm = 14;
+		pmecc_get_gf_1024_tables(&code.alpha_to, &code.index_of);
+	}
+	code.nn = (1 << code.mm) - 1;
+
+	/* Generator: least common multiple of the minimal polynomials, i.e.
+	 * product of the distinct ones */
+	code.generator[0] = 1;
+	for (i = 0; i < tt; i++) {
+		code.minimal[i] = _minimal_polynomial(2 * i + 1,
+				&code.minimal_degree[i]);
+		for (j = 0; j < i; j++)
+			if (code.minimal[j] == code.minimal[i])
+				break;
+		if (j < i)
+			continue;
+		_poly_mul(code.generator, code.minimal[i]);
+		code.generator_degree += code.minimal_degree[i];
+	}
+}
+
+/* Number of bits of the codeword, as the PMECC lays it out: the sector
+ * followed by tt * mm bits of ECC */
+static uint32_t _codeword_bits(void)
+{
+	return code.sector_size * 8 + code.tt * code.mm;
+}
+
+/* Random sector, followed by its ECC r(x) such that
+ * d(x) + x^(8 * sector_size) * r(x) is a multiple of the generator, i.e.
+ * r(x) = d(x) * x^-(8 * sector_size) mod g(x) */
+static void _encode(uint8_t *codeword)
+{
+	uint64_t acc[POLY_WORDS] = { 0 };
+	uint32_t bit, w;
+
+	memset(codeword, 0, MAX_CODEWORD_SIZE);
+	for (bit = 0; bit < code.sector_size; bit++)
+		codeword[bit] = rand();
+
+	for (bit = 0; bit < code.sector_size * 8; bit++) {
+		acc[0] ^= _get_bit(codeword, bit);
+		/* Multiply by x^-1 modulo g(x), g(0) being 1 */
+		if (acc[0] & 1) {
+			for (w = 0; w < POLY_WORDS; w++)
+				acc[w] ^= code.generator[w];
+		}
+		for (w = 0; w < POLY_WORDS; w++) {
+			acc[w] >>= 1;
+			if (w + 1 < POLY_WORDS)
+				acc[w] |= acc[w + 1] << 63;
+		}
+	}
+	for (bit = 0; bit < code.generator_degree; bit++)
+		if ((acc[bit / 64] >> (bit % 64)) & 1)
+			_flip_bit(codeword, code.sector_size * 8 + bit);
+}
+
+/* Remainders of the received word by the minimal polynomials, as computed
+ * by the PMECC */
+static void _remainders(const uint8_t *codeword, int16_t *rem)
+{
+	uint32_t i, bit, r, top;
+
+	for (i = 0; i < code.tt; i++) {
+		top = 1u << code.minimal_degree[i];
+		r = 0;
+		for (bit = _codeword_bits(); bit-- > 0;) {
+			r = (r << 1) | _get_bit(codeword, bit);
+			if (r & top)
+				r ^= code.minimal[i];
+		}
+		rem[i] = r;
+	}
+}
+
+static bool _is_codeword(const uint8_t *codeword)
+{
+	int16_t rem[PMECC_BCH_MAX_ERRORS];
+	uint32_t i;
+
+	_remainders(codeword, rem);
+	for (i = 0; i < code.tt; i++)
+		if (rem[i])
+			return false;
+	return true;
+}
+
+/* Flip count distinct random bits of the codeword, at least one in the
+ * sector, and return their positions numbered from 1, sorted */
+static void _inject(uint8_t *codeword, uint32_t count, uint32_t *positions)
+{
+	uint32_t i, j, bit;
+
+	for (i = 0; i < count; i++) {
+		do {
+			if (i == 0)
+				bit = rand() % (code.sector_size * 8);
+			else
+				bit = rand() % _codeword_bits();
+			for (j = 0; j < i; j++)
+				if (positions[j] == bit + 1)
+					break;
+		} while (j < i);
+		positions[i] = bit + 1;
+		_flip_bit(codeword, bit);
+	}
+}
+
+static int _compare_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static double _elapsed(const struct timespec *start)
+{
+	struct timespec end;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* The encoder produces codewords, the decoder finds no error in them */
+static void test_clean(uint32_t sector_size, uint32_t tt)
+{
+	struct _pmecc_bch bch;
+	int16_t rem[PMECC_BCH_MAX_ERRORS];
+
+	_code_init(sector_size, tt);
+	CHECK(code.generator_degree <= tt * code.mm);
+
+	_encode(original);
+	_remainders(original, rem);
+	CHECK(_is_codeword(original));
+
+	memcpy(received, original, sizeof(received));
+	pmecc_bch_init(&bch, code.mm, tt, code.alpha_to, code.index_of);
+	pmecc_bch_set_remainders(&bch, rem);
+	CHECK_EQ(pmecc_bch_decode(&bch, received, sector_size), 0);
+	CHECK_MEM(received, original, sector_size, 0);
+}
+
+/* Up to tt errors, in the sector or the ECC: all located and corrected */
+static void test_correct(uint32_t sector_size, uint32_t tt)
+{
+	struct _pmecc_bch bch;
+	int16_t rem[PMECC_BCH_MAX_ERRORS];
+	uint32_t injected[PMECC_BCH_MAX_ERRORS + 1];
+	uint32_t located[PMECC_BCH_MAX_ERRORS];
+	uint32_t round, count;
+	int32_t found;
+
+	_code_init(sector_size, tt);
+	for (round = 0; round < CORRECT_ROUNDS; round++) {
+		/* Every other round with the full capability */
+		count = (round & 1) ? tt : 1 + rand() % tt;
+
+		_encode(original);
+		memcpy(received, original, sizeof(received));
+		_inject(received, count, injected);
+		_remainders(received, rem);
+
+		pmecc_bch_init(&bch, code.mm, tt, code.alpha_to, code.index_of);
+		pmecc_bch_set_remainders(&bch, rem);
+		CHECK_EQ(pmecc_bch_compute_sigma(&bch), count);
+		found = pmecc_bch_find_errors(&bch, _codeword_bits(), located);
+		CHECK_EQ(found, (int32_t)count);
+		if (found != (int32_t)count)
+			continue;
+		qsort(injected, count, sizeof(injected[0]), _compare_u32);
+		qsort(located, count, sizeof(located[0]), _compare_u32);
+		CHECK_MEM(located, injected, count * sizeof(located[0]), round);
+
+		pmecc_bch_set_remainders(&bch, rem);
+		CHECK_EQ(pmecc_bch_decode(&bch, received, sector_size),
+			 (int32_t)count);
+		CHECK_MEM(received, original, sector_size, round);
+	}
+}
+
+/* tt + 1 errors: either reported, or corrected into another codeword at
+ * distance tt or less, as no decoder can do better */
+static void test_uncorrectable(uint32_t sector_size, uint32_t tt)
+{
+	struct _pmecc_bch bch;
+	int16_t rem[PMECC_BCH_MAX_ERRORS];
+	uint32_t injected[PMECC_BCH_MAX_ERRORS + 1];
+	uint32_t located[PMECC_BCH_MAX_ERRORS];
+	uint32_t round, reported = 0, i;
+	int32_t found;
+
+	_code_init(sector_size, tt);
+	for (round = 0; round < UNCORRECTABLE_ROUNDS; round++) {
+		_encode(original);
+		memcpy(received, original, sizeof(received));
+		_inject(received, tt + 1, injected);
+		_remainders(received, rem);
+
+		pmecc_bch_init(&bch, code.mm, tt, code.alpha_to, code.index_of);
+		pmecc_bch_set_remainders(&bch, rem);
+		pmecc_bch_compute_sigma(&bch);
+		found = pmecc_bch_find_errors(&bch, _codeword_bits(), located);
+		if (found < 0) {
+			reported++;
+			continue;
+		}
+		/* Miscorrection: the result shall be a codeword other than the
+		 * original one, which is at distance tt + 1 */
+		CHECK(found <= (int32_t)tt);
+		for (i = 0; i < (uint32_t)found; i++)
+			_flip_bit(received, located[i] - 1);
+		CHECK(_is_codeword(received));
+		CHECK(memcmp(received, original, sizeof(received)) != 0);
+	}
+	/* Miscorrections get frequent with a small tt, as most syndromes then
+	 * match some pattern of tt errors; they stay a minority */
+	CHECK(reported >= UNCORRECTABLE_ROUNDS / 2);
+}
+
+/*----------------------------------------------------------------------------
+ *        Benchmark
+ *----------------------------------------------------------------------------*/
+
+/* Sectors corrected per second, with tt errors each. The decode of a sector
+ * flips its errors, so that the sectors alternate between their received
+ * and corrected contents from a round to the next. */
+static void benchmark(uint32_t sector_size, uint32_t tt)
+{
+	static uint8_t sectors[BENCH_SECTORS][MAX_CODEWORD_SIZE];
+	static int16_t rems[BENCH_SECTORS][PMECC_BCH_MAX_ERRORS];
+	uint32_t injected[PMECC_BCH_MAX_ERRORS + 1];
+	struct _pmecc_bch bch;
+	struct timespec start;
+	uint32_t i, rounds = 0;
+	double seconds;
+
+	_code_init(sector_size, tt);
+	for (i = 0; i < BENCH_SECTORS; i++) {
+		_encode(sectors[i]);
+		_inject(sectors[i], tt, injected);
+		_remainders(sectors[i], rems[i]);
+	}
+
+	pmecc_bch_init(&bch, code.mm, tt, code.alpha_to, code.index_of);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	do {
+		for (i = 0; i < BENCH_SECTORS; i++) {
+			pmecc_bch_set_remainders(&bch, rems[i]);
+			CHECK_EQ(pmecc_bch_decode(&bch, sectors[i], sector_size),
+				 (int32_t)tt);
+		}
+		rounds++;
+		seconds = _elapsed(&start);
+	} while (seconds < 0.2);
+	printf("%4u-byte sectors, t=%-2u: %8.0f corrections/s\n",
+	       sector_size, tt, rounds * BENCH_SECTORS / seconds);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+/* All the tests for one sector size and capability */
+#define RUN_CODE(sector_size, tt) do { \
+		RUN_TEST(test_clean, sector_size, tt); \
+		RUN_TEST(test_correct, sector_size, tt); \
+		RUN_TEST(test_uncorrectable, sector_size, tt); \
+	} while (0)
+
+int main(void)
+{
+	static const uint32_t capabilities[] = { 2, 4, 8, 12, 24 };
+	uint32_t t;
+
+	srand(1);
+	RUN_CODE(512, 2);
+	RUN_CODE(512, 4);
+	RUN_CODE(512, 8);
+	RUN_CODE(512, 12);
+	RUN_CODE(512, 24);
+	RUN_CODE(1024, 2);
+	RUN_CODE(1024, 4);
+	RUN_CODE(1024, 8);
+	RUN_CODE(1024, 12);
+	RUN_CODE(1024, 24);
+
+	for (t = 0; t < sizeof(capabilities) / sizeof(capabilities[0]); t++)
+		benchmark(512, capabilities[t]);
+	for (t = 0; t < sizeof(capabilities) / sizeof(capabilities[0]); t++)
+		benchmark(1024, capabilities[t]);
+	return HOST_TEST_EXIT();
+}
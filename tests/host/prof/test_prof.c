@@ -0,0 +1,271 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * utils/prof.c built with its host backend (CONFIG_PROF_HOST), over a
+ * simulated monotonic clock: every read of the clock costs a given number of
+ * nanoseconds, and the test advances the clock to stand for the measured
+ * code. Covers the measure and subtraction of the probe overhead, the log2
+ * bucketing of the durations, the statistics, the registration of the
+ * probes, prof_reset() and prof_dump().
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "prof.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Nanoseconds taken by a read of the simulated clock, by default */
+#define CLOCK_READ_NS 37
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Simulated monotonic clock, in nanoseconds */
+static uint64_t sim_now = 1000000000ull;
+
+/** Nanoseconds taken by a read of the simulated clock */
+static uint32_t sim_read_ns = CLOCK_READ_NS;
+
+/** Number of reads of the simulated clock */
+static uint32_t sim_reads;
+
+/*----------------------------------------------------------------------------
+ *        Simulated clock
+ *----------------------------------------------------------------------------*/
+
+/* Replaces the C library function for the whole program, prof.c included */
+int clock_gettime(clockid_t clock, struct timespec *ts)
+{
+	sim_now += sim_read_ns;
+	sim_reads++;
+	ts->tv_sec = sim_now / 1000000000u;
+	ts->tv_nsec = sim_now % 1000000000u;
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* A section taking ns nanoseconds, measured by the probe "section" */
+static struct _prof_probe *_section(uint32_t ns)
+{
+	PROF_BEGIN(section);
+	sim_now += ns;
+	PROF_END(section);
+	return &_prof_probe_section;
+}
+
+/* Another probe, to check the registration of several probes */
+static struct _prof_probe *_other(uint32_t ns)
+{
+	PROF_BEGIN(other);
+	sim_now += ns;
+	PROF_END(other);
+	return &_prof_probe_other;
+}
+
+/* Run prof_dump() and return what it printed */
+static const char *_dump(void)
+{
+	static char output[4096];
+	FILE *file = tmpfile();
+	size_t size;
+	int saved;
+
+	fflush(stdout);
+	saved = dup(STDOUT_FILENO);
+	dup2(fileno(file), STDOUT_FILENO);
+	prof_dump();
+	fflush(stdout);
+	dup2(saved, STDOUT_FILENO);
+	close(saved);
+
+	rewind(file);
+	size = fread(output, 1, sizeof(output) - 1, file);
+	output[size] = '\0';
+	fclose(file);
+	return output;
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* The overhead measured by prof_init() is the cost of reading the clock once,
+ * and is removed from every duration */
+static void test_overhead(void)
+{
+	struct _prof_probe *probe;
+
+	sim_reads = 0;
+	prof_init();
+	CHECK_EQ(sim_reads, 32);
+
+	probe = _section(1000);
+	CHECK_EQ(probe->count, 1);
+	CHECK_EQ(probe->min, 1000);
+	CHECK_EQ(probe->max, 1000);
+	CHECK_EQ(probe->total, 1000);
+
+	/* An empty section lasts 0, not the overhead */
+	probe = _section(0);
+	CHECK_EQ(probe->count, 2);
+	CHECK_EQ(probe->min, 0);
+	CHECK_EQ(probe->hist[0], 1);
+
+	/* Nor less than 0 when the probe runs faster than measured */
+	sim_read_ns = CLOCK_READ_NS / 2;
+	probe = _section(0);
+	sim_read_ns = CLOCK_READ_NS;
+	CHECK_EQ(probe->count, 3);
+	CHECK_EQ(probe->max, 1000);
+	CHECK_EQ(probe->hist[0], 2);
+}
+
+/* Duration d goes to bucket n with 2^(n-1) <= d < 2^n, the last bucket takes
+ * all longer durations */
+static void test_buckets(void)
+{
+	static const struct {
+		uint32_t cycles;
+		uint32_t bucket;
+	} cases[] = {
+		{ 0, 0 }, { 1, 1 }, { 2, 2 }, { 3, 2 }, { 4, 3 }, { 7, 3 },
+		{ 8, 4 }, { 1000, 10 }, { 1023, 10 }, { 1024, 11 },
+		{ 1u << 29, 30 }, { (1u << 30) - 1, 30 }, { 1u << 30, 31 },
+		{ 1u << 31, 31 }, { UINT32_MAX, 31 },
+	};
+	/* Registered on its first run, the probe shall outlive the test */
+	static struct _prof_probe probe = { .name = "buckets" };
+	uint64_t total = 0;
+	uint32_t i, b, expected;
+
+	for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		prof_record(&probe, cases[i].cycles, NULL);
+		total += cases[i].cycles;
+	}
+
+	CHECK_EQ(probe.count, sizeof(cases) / sizeof(cases[0]));
+	CHECK_EQ(probe.min, 0);
+	CHECK_EQ(probe.max, UINT32_MAX);
+	CHECK(probe.total == total);
+	for (b = 0; b < PROF_HIST_BUCKETS; b++) {
+		expected = 0;
+		for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+			if (cases[i].bucket == b)
+				expected++;
+		CHECK_EQ(probe.hist[b], expected);
+	}
+}
+
+/* Event counts are accumulated per probe */
+static void test_events(void)
+{
+	static struct _prof_probe probe = { .name = "events" };
+	uint32_t events[PROF_EVENTS] = { 3, 1 };
+
+	prof_record(&probe, 10, events);
+	prof_record(&probe, 20, events);
+	prof_record(&probe, 30, NULL);
+	CHECK_EQ(probe.count, 3);
+	CHECK(probe.events[PROF_EVENT_DCACHE_MISS] == 6);
+	CHECK(probe.events[PROF_EVENT_DTLB_MISS] == 2);
+}
+
+/* prof_reset() clears the statistics, the probes stay registered and are
+ * dumped again once they run */
+static void test_reset(void)
+{
+	struct _prof_probe *section, *other;
+	const char *output;
+
+	prof_init();
+	section = _section(500);
+	other = _other(2000);
+	other = _other(4000);
+
+	output = _dump();
+	CHECK(strstr(output, "section") != NULL);
+	CHECK(strstr(output, "other") != NULL);
+	CHECK(strstr(output, "hist: <2^11:1 <2^12:1") != NULL);
+
+	prof_reset();
+	CHECK_EQ(section->count, 0);
+	CHECK_EQ(section->min, UINT32_MAX);
+	CHECK_EQ(section->max, 0);
+	CHECK(section->total == 0);
+	CHECK_EQ(other->count, 0);
+	CHECK_EQ(other->hist[11], 0);
+	CHECK_EQ(other->hist[12], 0);
+
+	/* Cleared probes are not printed */
+	output = _dump();
+	CHECK(strstr(output, "section") == NULL);
+	CHECK(strstr(output, "other") == NULL);
+
+	/* Still registered: the next run is accounted and printed, without
+	 * registering the probe twice */
+	section = _section(300);
+	CHECK_EQ(section->count, 1);
+	CHECK_EQ(section->min, 300);
+	output = _dump();
+	CHECK(strstr(output, "section") != NULL);
+	CHECK(strstr(strstr(output, "section") + 1, "section") == NULL);
+	CHECK(strstr(output, "other") == NULL);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_overhead);
+	RUN_TEST(test_buckets);
+	RUN_TEST(test_events);
+	RUN_TEST(test_reset);
+	return HOST_TEST_EXIT();
+}
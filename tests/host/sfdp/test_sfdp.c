@@ -0,0 +1,430 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * drivers/memories/sfdp.c against SFDP images of common serial NOR parts,
+ * and the decode expected from their datasheets.
+ *
+ * The images carry the parameters documented by each datasheet (read
+ * instructions and cycles, erase types, quad enable method, 4-byte address
+ * support) in the JESD216 revision the part implements. Fields the parser
+ * does not decode (erase and program times, reset and status register
+ * methods) are filler.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "memories/sfdp.h"
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        SFDP images
+ *----------------------------------------------------------------------------*/
+
+/* Micron MT25QL512: JESD216B, 16-DWORD BFPT at 30h and 4BAIT at 80h. All
+ * read protocols including DTR, 3- or 4-byte addressing, no QE bit. */
+static const uint8_t mt25ql512_sfdp[] = {
+	0x53, 0x46, 0x44, 0x50, 0x06, 0x01, 0x01, 0xff, 0x00, 0x06, 0x01, 0x10,
+	0x30, 0x00, 0x00, 0xff, 0x84, 0x00, 0x01, 0x02, 0x80, 0x00, 0x00, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xe5, 0x20, 0xfb, 0xff, 0xff, 0xff, 0xff, 0x1f, 0x29, 0xeb, 0x27, 0x6b,
+	0x27, 0x3b, 0x27, 0xbb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x27, 0xbb,
+	0xff, 0xff, 0x29, 0xeb, 0x0c, 0x20, 0x0f, 0x52, 0x10, 0xd8, 0x00, 0x00,
+	0x22, 0x36, 0xa2, 0x00, 0x82, 0xa3, 0x03, 0xcb, 0xac, 0xc1, 0x04, 0x2e,
+	0x7a, 0x75, 0x7a, 0x75, 0xfb, 0x00, 0x00, 0x80, 0x08, 0x0f, 0x82, 0xff,
+	0x81, 0xd0, 0xe8, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x00, 0x00,
+	0x21, 0x5c, 0xdc, 0xff,
+};
+
+/* Macronix MX25L25645G: JESD216B, 16-DWORD BFPT at 30h and 4BAIT at 80h.
+ * QPI but no 2-2-2, QE is SR1 bit 6, no 4-byte 1-1-4 page program. */
+static const uint8_t mx25l25645g_sfdp[] = {
+	0x53, 0x46, 0x44, 0x50, 0x06, 0x01, 0x01, 0xff, 0x00, 0x06, 0x01, 0x10,
+	0x30, 0x00, 0x00, 0xff, 0x84, 0x00, 0x01, 0x02, 0x80, 0x00, 0x00, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xe5, 0x20, 0xfb, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x44, 0xeb, 0x08, 0x6b,
+	0x08, 0x3b, 0x04, 0xbb, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00,
+	0xff, 0xff, 0x44, 0xeb, 0x0c, 0x20, 0x0f, 0x52, 0x10, 0xd8, 0x00, 0x00,
+	0x1b, 0x5a, 0xd6, 0x00, 0x89, 0xc4, 0xf6, 0x33, 0x44, 0x8f, 0xd8, 0x1c,
+	0x30, 0xb0, 0x30, 0xb0, 0x55, 0x9d, 0xa4, 0xf7, 0x00, 0x02, 0x21, 0x00,
+	0xf0, 0xd0, 0xc0, 0x25, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0x0f, 0x00, 0x00,
+	0x21, 0x5c, 0xdc, 0xff,
+};
+
+/* Spansion S25FL512S: JESD216 (rev 1.0), 9-DWORD BFPT at 30h. Uniform
+ * 256KB sectors, no 4K erase. The table has no page size DWORD: the parser
+ * falls back to 256 bytes although the part has 512-byte pages. */
+static const uint8_t s25fl512s_sfdp[] = {
+	0x53, 0x46, 0x44, 0x50, 0x00, 0x01, 0x00, 0xff, 0x00, 0x00, 0x01, 0x09,
+	0x30, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xe7, 0xff, 0xfb, 0xff, 0xff, 0xff, 0xff, 0x1f, 0x44, 0xeb, 0x08, 0x6b,
+	0x08, 0x3b, 0x80, 0xbb, 0xee, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0x12, 0xd8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+/* Winbond W25Q128JV: JESD216A, 16-DWORD BFPT at 80h, no 4BAIT. 3-byte
+ * addressing only, QE is SR2 bit 1. */
+static const uint8_t w25q128jv_sfdp[] = {
+	0x53, 0x46, 0x44, 0x50, 0x05, 0x01, 0x00, 0xff, 0x00, 0x05, 0x01, 0x10,
+	0x80, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xe5, 0x20, 0xf1, 0xff,
+	0xff, 0xff, 0xff, 0x07, 0x44, 0xeb, 0x08, 0x6b, 0x08, 0x3b, 0x42, 0xbb,
+	0xee, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0x0c, 0x20, 0x0f, 0x52, 0x10, 0xd8, 0x00, 0x00, 0x36, 0x25, 0xa6, 0x00,
+	0x82, 0xea, 0x14, 0xc4, 0x6c, 0xc0, 0x76, 0x33, 0x7a, 0x75, 0x7a, 0x75,
+	0xf7, 0xa2, 0xd5, 0x5c, 0x00, 0x02, 0x48, 0xff, 0xf8, 0x50, 0x3a, 0x00,
+};
+/*----------------------------------------------------------------------------
+ *        Expected decodes
+ *----------------------------------------------------------------------------*/
+
+#define ALL_PROTOS ((1u << SFDP_PROTO_COUNT) - 1)
+
+/* Protocols of a controller without 2-2-2 and 4-4-4 */
+#define SINGLE_INSTR_PROTOS (ALL_PROTOS & ~(1u << SFDP_PROTO_2_2_2) & \
+		~(1u << SFDP_PROTO_4_4_4))
+
+enum _part {
+	MT25QL512,
+	MX25L25645G,
+	S25FL512S,
+	W25Q128JV,
+};
+
+struct _sfdp_case {
+	const uint8_t *image;
+	uint32_t image_size;
+	uint32_t jedec_id;
+	struct _sfdp expected;
+	enum _sfdp_proto best;        /*< sfdp_select_read(ALL_PROTOS) */
+	enum _sfdp_proto best_single; /*< sfdp_select_read(SINGLE_INSTR_PROTOS) */
+	uint32_t desc_flags;
+};
+
+#define READ(op, mode, dummy) { .opcode = (op), .mode_cycles = (mode), \
+		.dummy_cycles = (dummy) }
+#define ERASE(sz, op, op4) { .size = (sz), .opcode = (op), .opcode_4b = (op4) }
+
+static const struct _sfdp_case cases[] = {
+	[MT25QL512] = {
+		.image = mt25ql512_sfdp,
+		.image_size = sizeof(mt25ql512_sfdp), .jedec_id = 0x0020ba20,
+		.expected = {
+			.major = 1, .minor = 6,
+			.size = 64 * 1024 * 1024, .page_size = 256,
+			.addr_bytes = SFDP_ADDR_3_OR_4,
+			.protocols = ALL_PROTOS,
+			.read = {
+				[SFDP_PROTO_1_1_1] = READ(0x0b, 0, 8),
+				[SFDP_PROTO_1_1_2] = READ(0x3b, 1, 7),
+				[SFDP_PROTO_1_2_2] = READ(0xbb, 1, 7),
+				[SFDP_PROTO_2_2_2] = READ(0xbb, 1, 7),
+				[SFDP_PROTO_1_1_4] = READ(0x6b, 1, 7),
+				[SFDP_PROTO_1_4_4] = READ(0xeb, 1, 9),
+				[SFDP_PROTO_4_4_4] = READ(0xeb, 1, 9),
+			},
+			.erase = {
+				ERASE(4 * 1024, 0x20, 0x21),
+				ERASE(32 * 1024, 0x52, 0x5c),
+				ERASE(64 * 1024, 0xd8, 0xdc),
+			},
+			.dtr = true, .continuous_read = false,
+			.quad_enable = SFDP_QER_NONE,
+			.enter_4b = SFDP_4B_B7 | SFDP_4B_WREN_B7 |
+				SFDP_4B_NVCR | SFDP_4B_INSTR,
+			.instr_4b = 0xfff,
+			.suspend = true,
+			.opcode_program_suspend = 0x75,
+			.opcode_program_resume = 0x7a,
+			.opcode_erase_suspend = 0x75,
+			.opcode_erase_resume = 0x7a,
+		},
+		.best = SFDP_PROTO_4_4_4,
+		.best_single = SFDP_PROTO_1_4_4,
+		/* dedicated 4-byte instructions, no need for 4-byte mode */
+		.desc_flags = SPINOR_FLAG_ERASE_4K | SPINOR_FLAG_ERASE_32K |
+			SPINOR_FLAG_ERASE_64K | SPINOR_FLAG_QUAD,
+	},
+	[MX25L25645G] = {
+		.image = mx25l25645g_sfdp,
+		.image_size = sizeof(mx25l25645g_sfdp), .jedec_id = 0x001920c2,
+		.expected = {
+			.major = 1, .minor = 6,
+			.size = 32 * 1024 * 1024, .page_size = 256,
+			.addr_bytes = SFDP_ADDR_3_OR_4,
+			.protocols = ALL_PROTOS & ~(1u << SFDP_PROTO_2_2_2),
+			.read = {
+				[SFDP_PROTO_1_1_1] = READ(0x0b, 0, 8),
+				[SFDP_PROTO_1_1_2] = READ(0x3b, 0, 8),
+				[SFDP_PROTO_1_2_2] = READ(0xbb, 0, 4),
+				[SFDP_PROTO_1_1_4] = READ(0x6b, 0, 8),
+				[SFDP_PROTO_1_4_4] = READ(0xeb, 2, 4),
+				[SFDP_PROTO_4_4_4] = READ(0xeb, 2, 4),
+			},
+			.erase = {
+				ERASE(4 * 1024, 0x20, 0x21),
+				ERASE(32 * 1024, 0x52, 0x5c),
+				ERASE(64 * 1024, 0xd8, 0xdc),
+			},
+			.dtr = true, .continuous_read = true,
+			.quad_enable = SFDP_QER_SR1_BIT6,
+			.enter_4b = SFDP_4B_B7 | SFDP_4B_EAR | SFDP_4B_INSTR,
+			.instr_4b = 0xf7f,
+			.suspend = true,
+			.opcode_program_suspend = 0xb0,
+			.opcode_program_resume = 0x30,
+			.opcode_erase_suspend = 0xb0,
+			.opcode_erase_resume = 0x30,
+		},
+		.best = SFDP_PROTO_4_4_4,
+		.best_single = SFDP_PROTO_1_4_4,
+		.desc_flags = SPINOR_FLAG_ERASE_4K | SPINOR_FLAG_ERASE_32K |
+			SPINOR_FLAG_ERASE_64K | SPINOR_FLAG_QUAD,
+	},
+	[S25FL512S] = {
+		.image = s25fl512s_sfdp,
+		.image_size = sizeof(s25fl512s_sfdp), .jedec_id = 0x00200201,
+		.expected = {
+			.major = 1, .minor = 0,
+			.size = 64 * 1024 * 1024, .page_size = 256,
+			.addr_bytes = SFDP_ADDR_3_OR_4,
+			.protocols = (1u << SFDP_PROTO_1_1_1) |
+				(1u << SFDP_PROTO_1_1_2) | (1u << SFDP_PROTO_1_2_2) |
+				(1u << SFDP_PROTO_1_1_4) | (1u << SFDP_PROTO_1_4_4),
+			.read = {
+				[SFDP_PROTO_1_1_1] = READ(0x0b, 0, 8),
+				[SFDP_PROTO_1_1_2] = READ(0x3b, 0, 8),
+				[SFDP_PROTO_1_2_2] = READ(0xbb, 4, 0),
+				[SFDP_PROTO_1_1_4] = READ(0x6b, 0, 8),
+				[SFDP_PROTO_1_4_4] = READ(0xeb, 2, 4),
+			},
+			.erase = {
+				ERASE(256 * 1024, 0xd8, 0),
+			},
+			.dtr = true,
+		},
+		.best = SFDP_PROTO_1_4_4,
+		.best_single = SFDP_PROTO_1_4_4,
+		/* no 4-byte mode entry described by a rev 1.0 table */
+		.desc_flags = SPINOR_FLAG_ERASE_256K | SPINOR_FLAG_QUAD,
+	},
+	[W25Q128JV] = {
+		.image = w25q128jv_sfdp,
+		.image_size = sizeof(w25q128jv_sfdp), .jedec_id = 0x001840ef,
+		.expected = {
+			.major = 1, .minor = 5,
+			.size = 16 * 1024 * 1024, .page_size = 256,
+			.addr_bytes = SFDP_ADDR_3,
+			.protocols = (1u << SFDP_PROTO_1_1_1) |
+				(1u << SFDP_PROTO_1_1_2) | (1u << SFDP_PROTO_1_2_2) |
+				(1u << SFDP_PROTO_1_1_4) | (1u << SFDP_PROTO_1_4_4),
+			.read = {
+				[SFDP_PROTO_1_1_1] = READ(0x0b, 0, 8),
+				[SFDP_PROTO_1_1_2] = READ(0x3b, 0, 8),
+				[SFDP_PROTO_1_2_2] = READ(0xbb, 2, 2),
+				[SFDP_PROTO_1_1_4] = READ(0x6b, 0, 8),
+				[SFDP_PROTO_1_4_4] = READ(0xeb, 2, 4),
+			},
+			.erase = {
+				ERASE(4 * 1024, 0x20, 0),
+				ERASE(32 * 1024, 0x52, 0),
+				ERASE(64 * 1024, 0xd8, 0),
+			},
+			.quad_enable = SFDP_QER_SR2_BIT1_NO_CLR,
+			.suspend = true,
+			.opcode_program_suspend = 0x75,
+			.opcode_program_resume = 0x7a,
+			.opcode_erase_suspend = 0x75,
+			.opcode_erase_resume = 0x7a,
+		},
+		.best = SFDP_PROTO_1_4_4,
+		.best_single = SFDP_PROTO_1_4_4,
+		.desc_flags = SPINOR_FLAG_ERASE_4K | SPINOR_FLAG_ERASE_32K |
+			SPINOR_FLAG_ERASE_64K | SPINOR_FLAG_QUAD,
+	},
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+struct _image {
+	const uint8_t *data;
+	uint32_t size;
+	uint32_t reads;
+};
+
+/* SFDP read callback, the space beyond the image reads as erased */
+static bool _read_image(void *arg, uint32_t addr, void *data, uint32_t length)
+{
+	struct _image *image = (struct _image *)arg;
+	uint8_t *out = (uint8_t *)data;
+	uint32_t i;
+
+	image->reads++;
+	for (i = 0; i < length; i++)
+		out[i] = addr + i < image->size ? image->data[addr + i] : 0xff;
+	return true;
+}
+
+static bool _read_fail(void *arg, uint32_t addr, void *data, uint32_t length)
+{
+	return false;
+}
+
+static void test_decode(enum _part part)
+{
+	const struct _sfdp_case *c = &cases[part];
+	const struct _sfdp *e = &c->expected;
+	struct _image image = { c->image, c->image_size, 0 };
+	struct _spi_nor_desc desc;
+	struct _sfdp s;
+	int i;
+
+	CHECK(sfdp_parse(&s, _read_image, &image));
+	CHECK_EQ(s.major, e->major);
+	CHECK_EQ(s.minor, e->minor);
+	CHECK_EQ(s.size, e->size);
+	CHECK_EQ(s.page_size, e->page_size);
+	CHECK_EQ(s.addr_bytes, e->addr_bytes);
+	CHECK_EQ(s.protocols, e->protocols);
+	for (i = 0; i < SFDP_PROTO_COUNT; i++) {
+		if (!(e->protocols & (1u << i)))
+			continue;
+		CHECK_EQ(s.read[i].opcode, e->read[i].opcode);
+		CHECK_EQ(s.read[i].mode_cycles, e->read[i].mode_cycles);
+		CHECK_EQ(s.read[i].dummy_cycles, e->read[i].dummy_cycles);
+	}
+	for (i = 0; i < SFDP_ERASE_TYPES; i++) {
+		CHECK_EQ(s.erase[i].size, e->erase[i].size);
+		CHECK_EQ(s.erase[i].opcode, e->erase[i].opcode);
+		CHECK_EQ(s.erase[i].opcode_4b, e->erase[i].opcode_4b);
+	}
+	CHECK_EQ(s.dtr, e->dtr);
+	CHECK_EQ(s.continuous_read, e->continuous_read);
+	CHECK_EQ(s.quad_enable, e->quad_enable);
+	CHECK_EQ(s.enter_4b, e->enter_4b);
+	CHECK_EQ(s.instr_4b, e->instr_4b);
+	CHECK_EQ(s.suspend, e->suspend);
+	CHECK_EQ(s.opcode_program_suspend, e->opcode_program_suspend);
+	CHECK_EQ(s.opcode_program_resume, e->opcode_program_resume);
+	CHECK_EQ(s.opcode_erase_suspend, e->opcode_erase_suspend);
+	CHECK_EQ(s.opcode_erase_resume, e->opcode_erase_resume);
+
+	CHECK_EQ(sfdp_select_read(&s, ALL_PROTOS), c->best);
+	CHECK_EQ(sfdp_select_read(&s, SINGLE_INSTR_PROTOS), c->best_single);
+	CHECK_EQ(sfdp_select_read(&s, 0), SFDP_PROTO_COUNT);
+
+	sfdp_get_spi_nor_desc(&s, c->jedec_id, &desc);
+	CHECK_EQ(desc.jedec_id, c->jedec_id);
+	CHECK_EQ(desc.size, e->size);
+	CHECK_EQ(desc.page_size, e->page_size);
+	CHECK_EQ(desc.flags, c->desc_flags);
+}
+
+/* The 4-byte mode entry is only requested for a large part without 4-byte
+ * instructions */
+static void test_enter_4b_mode(void)
+{
+	struct _image image = { mx25l25645g_sfdp, sizeof(mx25l25645g_sfdp), 0 };
+	struct _spi_nor_desc desc;
+	struct _sfdp s;
+
+	CHECK(sfdp_parse(&s, _read_image, &image));
+	s.instr_4b = 0;
+	s.enter_4b &= ~SFDP_4B_INSTR;
+	sfdp_get_spi_nor_desc(&s, 0x001920c2, &desc);
+	CHECK(desc.flags & SPINOR_FLAG_ENTER_4B_MODE);
+
+	s.size = 16 * 1024 * 1024;
+	sfdp_get_spi_nor_desc(&s, 0x001920c2, &desc);
+	CHECK(!(desc.flags & SPINOR_FLAG_ENTER_4B_MODE));
+}
+
+static void test_invalid(void)
+{
+	uint8_t copy[sizeof(w25q128jv_sfdp)];
+	struct _image image = { copy, sizeof(copy), 0 };
+	struct _sfdp s;
+
+	/* bad signature */
+	memcpy(copy, w25q128jv_sfdp, sizeof(copy));
+	copy[0] = 'X';
+	CHECK(!sfdp_parse(&s, _read_image, &image));
+
+	/* unsupported SFDP major revision */
+	memcpy(copy, w25q128jv_sfdp, sizeof(copy));
+	copy[5] = 2;
+	CHECK(!sfdp_parse(&s, _read_image, &image));
+
+	/* BFPT shorter than the 9 DWORDs of JESD216 */
+	memcpy(copy, w25q128jv_sfdp, sizeof(copy));
+	copy[11] = 8;
+	CHECK(!sfdp_parse(&s, _read_image, &image));
+
+	/* no SFDP at all: erased space */
+	image.size = 0;
+	CHECK(!sfdp_parse(&s, _read_image, &image));
+
+	CHECK(!sfdp_parse(&s, _read_fail, NULL));
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	RUN_TEST(test_decode, MT25QL512);
+	RUN_TEST(test_decode, MX25L25645G);
+	RUN_TEST(test_decode, S25FL512S);
+	RUN_TEST(test_decode, W25Q128JV);
+	RUN_TEST(test_enter_4b_mode);
+	RUN_TEST(test_invalid);
+	return HOST_TEST_EXIT();
+}
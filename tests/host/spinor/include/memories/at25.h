@@ -0,0 +1,57 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host replacement for memories/at25.h: the AT25 functions used by the
+ * serial NOR media, implemented by the simulated NOR flash.
+ */
+
+#ifndef _AT25_H_
+#define _AT25_H_
+
+#include "memories/spi-nor.h"
+
+#include <stdint.h>
+
+#define AT25_SUCCESS              0x0u
+#define AT25_ADDR_OOB             0xBu
+#define AT25_ERROR_PROGRAM        3
+
+struct _at25 {
+	const struct _spi_nor_desc *desc;
+};
+
+extern uint32_t at25_read(struct _at25 *at25, uint32_t addr, uint8_t *data,
+		uint32_t length);
+extern uint32_t at25_erase_block(struct _at25 *at25, uint32_t addr,
+		uint32_t length);
+extern uint32_t at25_write(struct _at25 *at25, uint32_t addr,
+		const uint8_t *data, uint32_t length);
+
+#endif /* _AT25_H_ */
@@ -0,0 +1,61 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Host replacement for memories/qspiflash.h: the QSPI flash functions used
+ * by the serial NOR media, implemented by the simulated NOR flash whose
+ * array stands for the memory-mapped window of the controller.
+ */
+
+#ifndef _QSPIFLASH_H_
+#define _QSPIFLASH_H_
+
+#include "memories/spi-nor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct _host_qspi Qspi;
+
+struct _qspiflash {
+	Qspi *qspi;
+	struct _spi_nor_desc desc;
+};
+
+/** Memory-mapped window of a QSPI controller, from the target chip.h */
+extern void *get_qspi_mem_from_addr(const Qspi *addr);
+
+extern bool qspiflash_read(const struct _qspiflash *flash, uint32_t addr,
+		void *data, uint32_t length);
+extern bool qspiflash_erase_block(const struct _qspiflash *flash,
+		uint32_t addr, uint32_t length);
+extern bool qspiflash_write(const struct _qspiflash *flash, uint32_t addr,
+		const void *data, uint32_t length);
+
+#endif /* _QSPIFLASH_H_ */
@@ -0,0 +1,190 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "nor_sim.h"
+
+#include "compiler.h"
+
+#include "memories/at25.h"
+#ifdef CONFIG_HAVE_QSPI
+#include "memories/qspiflash.h"
+#endif
+
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** The array, static so that its address fits the 32-bit media addresses,
+ * and aligned as the memory-mapped window of the QSPI controller */
+ALIGNED(NOR_SIM_SECTOR_SIZE) static uint8_t nor_mem[NOR_SIM_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _sector_base(uint32_t addr)
+{
+	return addr & ~(NOR_SIM_SECTOR_SIZE - 1);
+}
+
+static bool _read(uint32_t addr, void *data, uint32_t length)
+{
+	if (addr + length > NOR_SIM_SIZE)
+		return false;
+	nor_sim.reads++;
+	nor_sim.read_bytes += length;
+	memcpy(data, nor_sim.mem + addr, length);
+	return true;
+}
+
+static bool _program(uint32_t addr, const uint8_t *data, uint32_t length)
+{
+	uint32_t i;
+	bool invalid = false;
+
+	if (addr + length > NOR_SIM_SIZE)
+		return false;
+	nor_sim.programs++;
+	if (length && addr / NOR_SIM_PAGE_SIZE !=
+			(addr + length - 1) / NOR_SIM_PAGE_SIZE)
+		nor_sim.crossing_programs++;
+	if (_sector_base(addr) == nor_sim.fail_write_addr)
+		return false;
+
+	for (i = 0; i < length; i++) {
+		if (data[i] & ~nor_sim.mem[addr + i])
+			invalid = true;
+		nor_sim.mem[addr + i] &= data[i];
+	}
+	if (invalid)
+		nor_sim.invalid_programs++;
+	return true;
+}
+
+static bool _erase(uint32_t addr, uint32_t length)
+{
+	if (length != NOR_SIM_SECTOR_SIZE || (addr % length) ||
+	    addr + length > NOR_SIM_SIZE)
+		return false;
+	nor_sim.erases++;
+	if (addr == nor_sim.fail_erase_addr)
+		return false;
+
+	memset(nor_sim.mem + addr, 0xff, length);
+	nor_sim.sector_erases[addr / NOR_SIM_SECTOR_SIZE]++;
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported symbols
+ *----------------------------------------------------------------------------*/
+
+struct _nor_sim nor_sim;
+
+const struct _spi_nor_desc nor_sim_desc = {
+	.name = "NOR-SIM",
+	.jedec_id = 0x1840ef,
+	.page_size = NOR_SIM_PAGE_SIZE,
+	.size = NOR_SIM_SIZE,
+	.flags = SPINOR_FLAG_ERASE_4K | SPINOR_FLAG_ERASE_64K,
+};
+
+void nor_sim_reset(void)
+{
+	memset(&nor_sim, 0, sizeof(nor_sim));
+	memset(nor_mem, 0xff, sizeof(nor_mem));
+	nor_sim.mem = nor_mem;
+	nor_sim.fail_erase_addr = NOR_SIM_NONE;
+	nor_sim.fail_write_addr = NOR_SIM_NONE;
+}
+
+void nor_sim_clear_counters(void)
+{
+	nor_sim.reads = 0;
+	nor_sim.read_bytes = 0;
+	nor_sim.programs = 0;
+	nor_sim.erases = 0;
+	nor_sim.invalid_programs = 0;
+	nor_sim.crossing_programs = 0;
+	memset(nor_sim.sector_erases, 0, sizeof(nor_sim.sector_erases));
+}
+
+uint32_t at25_read(struct _at25 *at25, uint32_t addr, uint8_t *data,
+		uint32_t length)
+{
+	return _read(addr, data, length) ? AT25_SUCCESS : AT25_ADDR_OOB;
+}
+
+uint32_t at25_erase_block(struct _at25 *at25, uint32_t addr,
+		uint32_t length)
+{
+	return _erase(addr, length) ? AT25_SUCCESS : AT25_ERROR_PROGRAM;
+}
+
+uint32_t at25_write(struct _at25 *at25, uint32_t addr, const uint8_t *data,
+		uint32_t length)
+{
+	return _program(addr, data, length) ? AT25_SUCCESS : AT25_ERROR_PROGRAM;
+}
+
+#ifdef CONFIG_HAVE_QSPI
+
+void *get_qspi_mem_from_addr(const Qspi *addr)
+{
+	return nor_sim.mem;
+}
+
+bool qspiflash_read(const struct _qspiflash *flash, uint32_t addr,
+		void *data, uint32_t length)
+{
+	/* A read without data restores the memory-mapped mode */
+	if (!data)
+		return true;
+	return _read(addr, data, length);
+}
+
+bool qspiflash_erase_block(const struct _qspiflash *flash, uint32_t addr,
+		uint32_t length)
+{
+	return _erase(addr, length);
+}
+
+bool qspiflash_write(const struct _qspiflash *flash, uint32_t addr,
+		const void *data, uint32_t length)
+{
+	return _program(addr, (const uint8_t *)data, length);
+}
+
+#endif /* CONFIG_HAVE_QSPI */
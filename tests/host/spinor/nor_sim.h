@@ -0,0 +1,98 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Simulated serial NOR flash behind the AT25 and QSPI flash functions used
+ * by media_spinor.c.
+ *
+ * Programs may only clear bits, as on the real array: a program setting a
+ * bit that is cleared is counted as invalid and leaves the bit cleared.
+ * Erases set a whole sector to 0xff. Programs must not cross a page
+ * boundary. The array is a static buffer, the memory-mapped window of the
+ * QSPI variant.
+ */
+
+#ifndef _NOR_SIM_H_
+#define _NOR_SIM_H_
+
+#include "memories/spi-nor.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** Geometry of the simulated device */
+#define NOR_SIM_SIZE        (256 * 1024)
+#define NOR_SIM_PAGE_SIZE   256
+#define NOR_SIM_SECTOR_SIZE (4 * 1024)
+
+/** No failing sector */
+#define NOR_SIM_NONE        0xffffffffu
+
+/** Simulated NOR flash */
+struct _nor_sim {
+	uint8_t *mem;               /**< array, NOR_SIM_SIZE bytes */
+
+	/* Fault injection */
+	uint32_t fail_erase_addr;   /**< address of the sector whose erase
+	                                 fails */
+	uint32_t fail_write_addr;   /**< address of the sector whose programs
+	                                 fail */
+
+	/* Counters */
+	uint32_t reads;             /**< read operations */
+	uint32_t read_bytes;
+	uint32_t programs;          /**< program operations */
+	uint32_t erases;
+	uint32_t invalid_programs;  /**< programs setting cleared bits */
+	uint32_t crossing_programs; /**< programs crossing a page boundary */
+	uint32_t sector_erases[NOR_SIM_SIZE / NOR_SIM_SECTOR_SIZE];
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported symbols
+ *----------------------------------------------------------------------------*/
+
+extern struct _nor_sim nor_sim;
+
+/** Device descriptor: 4KB and 64KB erases */
+extern const struct _spi_nor_desc nor_sim_desc;
+
+/**
+ * \brief Erase the whole array and reset the counters and faults.
+ */
+extern void nor_sim_reset(void);
+
+/**
+ * \brief Reset the counters only.
+ */
+extern void nor_sim_clear_counters(void);
+
+#endif /* _NOR_SIM_H_ */
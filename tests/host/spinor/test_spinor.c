@@ -0,0 +1,416 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * media_spinor.c on a simulated NOR flash: erase skipping when the new
+ * content only clears bits, programming of the changed chunks only, merging
+ * of partial sector writes in the sector buffer and their write back. Built
+ * for the AT25 and the memory-mapped QSPI flash accesses.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "media.h"
+#include "media_private.h"
+#include "media_spinor.h"
+#include "nor_sim.h"
+
+#include "memories/at25.h"
+#ifdef CONFIG_HAVE_QSPI
+#include "memories/qspiflash.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Area exported by the media, in bytes */
+#define AREA_OFFSET   (4 * NOR_SIM_SECTOR_SIZE)
+#define AREA_SIZE     (32 * NOR_SIM_SECTOR_SIZE)
+
+#define BLOCK_SIZE    MEDIA_SPINOR_BLOCK_SIZE
+#define NUM_BLOCKS    (AREA_SIZE / BLOCK_SIZE)
+#define PER_SECTOR    (NOR_SIM_SECTOR_SIZE / BLOCK_SIZE)
+
+/** Granularity of the programs, CHUNK_SIZE in media_spinor.c */
+#define CHUNK_SIZE    256
+#define PER_SECTOR_CHUNKS (NOR_SIM_SECTOR_SIZE / CHUNK_SIZE)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _media media;
+static struct _media_spinor nor;
+#ifdef CONFIG_HAVE_QSPI
+static struct _qspiflash flash;
+#else
+static struct _at25 at25;
+#endif
+static uint8_t sector_buf[NOR_SIM_SECTOR_SIZE];
+
+/** Expected content of the area */
+static uint8_t model[AREA_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint8_t _init(uint32_t offset, uint32_t size, uint32_t buffer_size)
+{
+#ifdef CONFIG_HAVE_QSPI
+	memset(&flash, 0, sizeof(flash));
+	memcpy(&flash.desc, &nor_sim_desc, sizeof(flash.desc));
+	return media_spinor_init_qspiflash(&media, &nor, &flash, offset, size,
+			sector_buf, buffer_size);
+#else
+	at25.desc = &nor_sim_desc;
+	return media_spinor_init_at25(&media, &nor, &at25, offset, size,
+			sector_buf, buffer_size);
+#endif
+}
+
+static void _setup(void)
+{
+	nor_sim_reset();
+	memset(model, 0xff, sizeof(model));
+	CHECK_EQ(_init(AREA_OFFSET, AREA_SIZE, sizeof(sector_buf)), 1);
+}
+
+static void _random(uint8_t *data, uint32_t length)
+{
+	uint32_t i;
+
+	for (i = 0; i < length; i++)
+		data[i] = rand();
+}
+
+static uint8_t _write(uint32_t block, const uint8_t *data, uint32_t count)
+{
+	uint8_t status;
+
+	status = media_write(&media, block, (void *)data, count, NULL, NULL);
+	if (status == MEDIA_STATUS_SUCCESS)
+		memcpy(model + block * BLOCK_SIZE, data, count * BLOCK_SIZE);
+	return status;
+}
+
+static const uint8_t *_flash(uint32_t block)
+{
+	return nor_sim.mem + AREA_OFFSET + block * BLOCK_SIZE;
+}
+
+/** Whether the flash holds the expected content of some blocks */
+static bool _flash_matches(uint32_t block, uint32_t count)
+{
+	return !memcmp(_flash(block), model + block * BLOCK_SIZE,
+			count * BLOCK_SIZE);
+}
+
+/** Whether the media reads the expected content of some blocks */
+static bool _media_matches(uint32_t block, uint32_t count)
+{
+	static uint8_t data[AREA_SIZE];
+
+	if (media_read(&media, block, data, count, NULL, NULL) !=
+			MEDIA_STATUS_SUCCESS)
+		return false;
+	return !memcmp(data, model + block * BLOCK_SIZE, count * BLOCK_SIZE);
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+static void test_init(void)
+{
+	nor_sim_reset();
+
+	CHECK_EQ(_init(AREA_OFFSET, AREA_SIZE, sizeof(sector_buf) / 2), 0);
+	CHECK_EQ(_init(AREA_OFFSET + BLOCK_SIZE, AREA_SIZE,
+			sizeof(sector_buf)), 0);
+	CHECK_EQ(_init(AREA_OFFSET, AREA_SIZE + BLOCK_SIZE,
+			sizeof(sector_buf)), 0);
+	CHECK_EQ(_init(AREA_OFFSET, 0, sizeof(sector_buf)), 0);
+	CHECK_EQ(_init(AREA_OFFSET, NOR_SIM_SIZE, sizeof(sector_buf)), 0);
+
+	CHECK_EQ(_init(AREA_OFFSET, AREA_SIZE, sizeof(sector_buf)), 1);
+	CHECK_EQ(media_get_block_size(&media), BLOCK_SIZE);
+	CHECK_EQ(media_get_size(&media), NUM_BLOCKS);
+	CHECK_EQ(nor.sector_size, NOR_SIM_SECTOR_SIZE);
+#ifdef CONFIG_HAVE_QSPI
+	CHECK(media_is_mapped_read_supported(&media));
+	CHECK_EQ(media_get_mapped_address(&media, 1),
+			(uint32_t)(uintptr_t)_flash(1));
+#else
+	CHECK(!media_is_mapped_read_supported(&media));
+#endif
+	CHECK_EQ(nor_sim.programs + nor_sim.erases, 0);
+}
+
+/* Whole-sector writes: the sector is erased only when a bit has to be set,
+ * and only the chunks which changed, or are not blank after an erase, are
+ * programmed */
+static void test_erase_skip(void)
+{
+	struct _media_spinor_stats stats;
+	uint8_t data[NOR_SIM_SECTOR_SIZE];
+
+	_setup();
+	srand(1);
+	_random(data, sizeof(data));
+	memset(data + 1 * CHUNK_SIZE, 0xff, CHUNK_SIZE);
+	memset(data + 3 * CHUNK_SIZE, 0xff, CHUNK_SIZE);
+	data[5 * CHUNK_SIZE] = 0xa5;
+	data[2 * CHUNK_SIZE + 7] = 0x01;
+
+	/* Blank sector: no erase, the blank chunks are skipped */
+	CHECK_EQ(_write(0, data, PER_SECTOR), MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.write_backs, 1);
+	CHECK_EQ(stats.erases, 0);
+	CHECK_EQ(stats.erases_skipped, 1);
+	CHECK_EQ(stats.programs, PER_SECTOR_CHUNKS - 2);
+	CHECK_EQ(nor_sim.erases, 0);
+	CHECK_EQ(nor_sim.programs, PER_SECTOR_CHUNKS - 2);
+	CHECK(_flash_matches(0, PER_SECTOR));
+
+	/* Same content: nothing programmed */
+	media_spinor_reset_stats(&media);
+	nor_sim_clear_counters();
+	CHECK_EQ(_write(0, data, PER_SECTOR), MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.erases_skipped, 1);
+	CHECK_EQ(stats.programs, 0);
+	CHECK_EQ(nor_sim.programs + nor_sim.erases, 0);
+
+	/* Bits cleared in one chunk: only that chunk is programmed */
+	data[5 * CHUNK_SIZE] = 0x00;
+	media_spinor_reset_stats(&media);
+	nor_sim_clear_counters();
+	CHECK_EQ(_write(0, data, PER_SECTOR), MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.erases, 0);
+	CHECK_EQ(stats.erases_skipped, 1);
+	CHECK_EQ(stats.programs, 1);
+	CHECK_EQ(nor_sim.erases, 0);
+	CHECK_EQ(nor_sim.programs, 1);
+	CHECK(_flash_matches(0, PER_SECTOR));
+
+	/* One bit set: erase, then program all the chunks not blank */
+	data[2 * CHUNK_SIZE + 7] = 0x81;
+	memset(data + 4 * CHUNK_SIZE, 0xff, CHUNK_SIZE);
+	media_spinor_reset_stats(&media);
+	nor_sim_clear_counters();
+	CHECK_EQ(_write(0, data, PER_SECTOR), MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.erases, 1);
+	CHECK_EQ(stats.erases_skipped, 0);
+	CHECK_EQ(stats.programs, PER_SECTOR_CHUNKS - 3);
+	CHECK_EQ(nor_sim.sector_erases[AREA_OFFSET / NOR_SIM_SECTOR_SIZE], 1);
+	CHECK_EQ(nor_sim.programs, PER_SECTOR_CHUNKS - 3);
+	CHECK(_flash_matches(0, PER_SECTOR));
+
+	CHECK_EQ(nor_sim.invalid_programs, 0);
+	CHECK_EQ(nor_sim.crossing_programs, 0);
+}
+
+/* Partial sector writes are merged in the sector buffer and written back
+ * when another sector is buffered or on flush */
+static void test_merge(void)
+{
+	struct _media_spinor_stats stats;
+	uint8_t data[24 * BLOCK_SIZE];
+	uint32_t write_backs;
+
+	_setup();
+	srand(2);
+	_random(data, sizeof(data));
+
+	/* Nothing reaches the flash while the writes stay in one sector */
+	CHECK_EQ(_write(2 * PER_SECTOR + 1, data, 1), MEDIA_STATUS_SUCCESS);
+	CHECK_EQ(_write(2 * PER_SECTOR + 3, data + BLOCK_SIZE, 2),
+			MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.write_backs, 0);
+	CHECK_EQ(stats.merged, 2);
+	CHECK_EQ(nor_sim.programs + nor_sim.erases, 0);
+	CHECK(!media_is_mapped_read_supported(&media));
+	CHECK(!_flash_matches(2 * PER_SECTOR, PER_SECTOR));
+	CHECK(_media_matches(2 * PER_SECTOR, PER_SECTOR));
+
+	/* Buffering another sector writes the first one back */
+	CHECK_EQ(_write(3 * PER_SECTOR + 6, data + 3 * BLOCK_SIZE, 1),
+			MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.write_backs, 1);
+	CHECK_EQ(stats.erases, 0);
+	CHECK_EQ(stats.programs, 3 * BLOCK_SIZE / CHUNK_SIZE);
+	CHECK(_flash_matches(2 * PER_SECTOR, PER_SECTOR));
+	CHECK(!_flash_matches(3 * PER_SECTOR, PER_SECTOR));
+
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.write_backs, 2);
+	CHECK(_flash_matches(0, NUM_BLOCKS));
+#ifdef CONFIG_HAVE_QSPI
+	CHECK(media_is_mapped_read_supported(&media));
+#endif
+
+	/* A whole-sector write supersedes the buffered copy */
+	CHECK_EQ(_write(5 * PER_SECTOR + 2, data, 1), MEDIA_STATUS_SUCCESS);
+	CHECK_EQ(_write(5 * PER_SECTOR, data + BLOCK_SIZE, PER_SECTOR),
+			MEDIA_STATUS_SUCCESS);
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.write_backs, 3);
+	CHECK(_flash_matches(0, NUM_BLOCKS));
+
+	/* Head and tail buffered, whole sectors in between programmed */
+	write_backs = stats.write_backs;
+	CHECK_EQ(_write(7 * PER_SECTOR - 2, data, 2 * PER_SECTOR + 5),
+			MEDIA_STATUS_SUCCESS);
+	media_spinor_get_stats(&media, &stats);
+	CHECK_EQ(stats.write_backs, write_backs + 3);
+	CHECK(_flash_matches(6 * PER_SECTOR, 3 * PER_SECTOR));
+	CHECK(!_flash_matches(9 * PER_SECTOR, PER_SECTOR));
+	CHECK(_media_matches(0, NUM_BLOCKS));
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+	CHECK(_flash_matches(0, NUM_BLOCKS));
+
+	CHECK_EQ(nor_sim.invalid_programs, 0);
+	CHECK_EQ(nor_sim.crossing_programs, 0);
+}
+
+/* A failed write back drops the buffer, the flash content is read again */
+static void test_errors(void)
+{
+	uint8_t data[PER_SECTOR * BLOCK_SIZE], zero[BLOCK_SIZE];
+	uint32_t sector_addr = AREA_OFFSET + 10 * NOR_SIM_SECTOR_SIZE;
+
+	_setup();
+	srand(3);
+	_random(data, sizeof(data));
+	memset(zero, 0, sizeof(zero));
+
+	CHECK_EQ(_write(NUM_BLOCKS - 1, data, 2), MEDIA_STATUS_ERROR);
+	CHECK_EQ(_write(10 * PER_SECTOR, zero, 1), MEDIA_STATUS_SUCCESS);
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+
+	/* Setting bits requires an erase, which fails */
+	nor_sim.fail_erase_addr = sector_addr;
+	CHECK_EQ(media_write(&media, 10 * PER_SECTOR, data, 1, NULL, NULL),
+			MEDIA_STATUS_SUCCESS);
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_ERROR);
+	CHECK(_media_matches(10 * PER_SECTOR, PER_SECTOR));
+	CHECK_EQ(media_write(&media, 10 * PER_SECTOR, data, PER_SECTOR,
+			NULL, NULL), MEDIA_STATUS_ERROR);
+
+	/* Failed programs after the erase */
+	nor_sim.fail_erase_addr = NOR_SIM_NONE;
+	nor_sim.fail_write_addr = sector_addr;
+	CHECK_EQ(media_write(&media, 10 * PER_SECTOR, data, PER_SECTOR,
+			NULL, NULL), MEDIA_STATUS_ERROR);
+	memset(model + 10 * NOR_SIM_SECTOR_SIZE, 0xff, NOR_SIM_SECTOR_SIZE);
+	CHECK(_media_matches(10 * PER_SECTOR, PER_SECTOR));
+
+	nor_sim.fail_write_addr = NOR_SIM_NONE;
+	CHECK_EQ(_write(10 * PER_SECTOR, data, PER_SECTOR),
+			MEDIA_STATUS_SUCCESS);
+	CHECK(_flash_matches(0, NUM_BLOCKS));
+	CHECK_EQ(media.state, MEDIA_STATE_READY);
+}
+
+/* Random writes against a model of the area, half of them only clearing
+ * bits as file systems do when they fill allocation tables */
+static void test_random(unsigned operations)
+{
+	struct _media_spinor_stats stats;
+	uint8_t data[24 * BLOCK_SIZE];
+	uint32_t i, j, block, count;
+
+	_setup();
+	srand(4);
+	for (i = 0; i < operations; i++) {
+		block = rand() % NUM_BLOCKS;
+		count = 1 + rand() % 24;
+		if (block + count > NUM_BLOCKS)
+			count = NUM_BLOCKS - block;
+		if (rand() % 2) {
+			for (j = 0; j < count * BLOCK_SIZE; j++)
+				data[j] = model[block * BLOCK_SIZE + j] &
+					((uint8_t)rand() | (uint8_t)rand() |
+					 (uint8_t)rand());
+		} else {
+			_random(data, count * BLOCK_SIZE);
+		}
+		if (_write(block, data, count) != MEDIA_STATUS_SUCCESS)
+			break;
+		if (rand() % 10 == 0)
+			CHECK(_media_matches(0, NUM_BLOCKS));
+		if (rand() % 50 == 0)
+			CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+	}
+	CHECK_EQ(i, operations);
+	CHECK(_media_matches(0, NUM_BLOCKS));
+	CHECK_EQ(media_flush(&media), MEDIA_STATUS_SUCCESS);
+	CHECK(_flash_matches(0, NUM_BLOCKS));
+	CHECK_EQ(nor_sim.invalid_programs, 0);
+	CHECK_EQ(nor_sim.crossing_programs, 0);
+
+	media_spinor_get_stats(&media, &stats);
+	printf("    %u write backs, %u erased, %u chunks programmed of %u\n",
+			(unsigned)stats.write_backs, (unsigned)stats.erases,
+			(unsigned)stats.programs,
+			(unsigned)(stats.write_backs * PER_SECTOR_CHUNKS));
+	CHECK(stats.erases_skipped > 0);
+	CHECK_EQ(stats.erases + stats.erases_skipped, stats.write_backs);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	RUN_TEST(test_init);
+	RUN_TEST(test_erase_skip);
+	RUN_TEST(test_merge);
+	RUN_TEST(test_errors);
+	RUN_TEST(test_random, 2000);
+	return HOST_TEST_EXIT();
+}
@@ -0,0 +1,457 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * utils/swtimer.c built with CONFIG_SWTIMER_HOST over a simulated clock. The
+ * clock fires the alarm exactly at its deadline, or a given latency later,
+ * so that every callback can be checked to run at the expiry of its timer.
+ *
+ * Covers one-shot and periodic timers, delays beyond a revolution of the
+ * wheel, the wrap-around of the 32-bit clock, starting and stopping timers
+ * from the callbacks, the periods missed by a late alarm, the alarm being
+ * programmed to the earliest deadline and cancelled when no timer is left,
+ * and random operations checked against a model of the pending timers.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "host_test.h"
+
+#include "swtimer.h"
+
+#include <stdlib.h>
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Ticks of a revolution of the wheel */
+#define REVOLUTION (SWTIMER_WHEEL_SLOTS << SWTIMER_SLOT_SHIFT)
+
+/** Timers of the randomized test */
+#define RANDOM_TIMERS 40
+
+/** Operations of the randomized test */
+#define RANDOM_OPERATIONS 20000
+
+/** Alarms fired by a single run of the clock, beyond which the wheel is
+ * deemed to loop on a deadline it never clears */
+#define MAX_ALARMS_PER_RUN 100000
+
+/** Timer with its expected behavior */
+struct _test_timer {
+	struct _swtimer timer;
+	/** Expected time of the next expiry, valid if armed */
+	uint32_t expected;
+	/** Expected period, 0 for a one-shot timer */
+	uint32_t period;
+	bool armed;
+	/** Number of expiries */
+	uint32_t count;
+	/** Time of the last expiry */
+	uint32_t fired_at;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Simulated clock */
+static uint32_t sim_time;
+static uint32_t sim_alarm;
+static bool sim_alarm_set;
+
+/** Ticks between the alarm deadline and the call to swtimer_process() */
+static uint32_t sim_latency;
+
+/** Number of times the alarm has been programmed */
+static uint32_t sim_alarms;
+
+/** Errors seen by the callbacks */
+static uint32_t callback_errors;
+
+/*----------------------------------------------------------------------------
+ *        Simulated clock
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _sim_get_time(void)
+{
+	return sim_time;
+}
+
+static void _sim_set_alarm(uint32_t deadline)
+{
+	sim_alarm = deadline;
+	sim_alarm_set = true;
+	sim_alarms++;
+}
+
+static void _sim_cancel_alarm(void)
+{
+	sim_alarm_set = false;
+}
+
+static const struct _swtimer_clock sim_clock = {
+	.freq = 1000000,
+	.get_time = _sim_get_time,
+	.set_alarm = _sim_set_alarm,
+	.cancel_alarm = _sim_cancel_alarm,
+};
+
+static const struct _swtimer_clock sim_clock_32k = {
+	.freq = 32768,
+	.get_time = _sim_get_time,
+	.set_alarm = _sim_set_alarm,
+	.cancel_alarm = _sim_cancel_alarm,
+};
+
+static bool _before_eq(uint32_t a, uint32_t b)
+{
+	return (int32_t)(a - b) <= 0;
+}
+
+/* Let the time run until end, firing the alarm on the way */
+static void _run_until(uint32_t end)
+{
+	uint32_t fire, alarms = 0;
+
+	while (sim_alarm_set) {
+		if (++alarms > MAX_ALARMS_PER_RUN) {
+			fprintf(stderr, "alarm stuck at %u\n", (unsigned)sim_alarm);
+			callback_errors++;
+			sim_alarm_set = false;
+			break;
+		}
+		fire = sim_alarm + sim_latency;
+		/* A deadline already passed fires right away */
+		if (_before_eq(fire, sim_time))
+			fire = sim_time;
+		if (!_before_eq(fire, end))
+			break;
+		sim_time = fire;
+		sim_alarm_set = false;
+		swtimer_process();
+	}
+	sim_time = end;
+}
+
+static void _run(uint32_t ticks)
+{
+	_run_until(sim_time + ticks);
+}
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Check the expiry against the model, then apply the period */
+static void _check_callback(struct _swtimer *timer, void *arg)
+{
+	struct _test_timer *t = arg;
+
+	if (!t->armed || sim_time != t->expected + sim_latency) {
+		fprintf(stderr, "timer %p fired at %u, expected %u (armed %d)\n",
+			(void *)t, (unsigned)sim_time,
+			(unsigned)(t->expected + sim_latency), t->armed);
+		callback_errors++;
+	}
+	t->count++;
+	t->fired_at = sim_time;
+	if (t->period)
+		t->expected += t->period;
+	else
+		t->armed = false;
+	if (swtimer_is_pending(timer) != (t->period != 0))
+		callback_errors++;
+}
+
+static void _start(struct _test_timer *t, uint32_t delay, uint32_t period)
+{
+	t->expected = sim_time + delay;
+	t->period = period;
+	t->armed = true;
+	swtimer_start(&t->timer, delay, period);
+}
+
+static void _stop(struct _test_timer *t)
+{
+	t->armed = false;
+	swtimer_stop(&t->timer);
+}
+
+static void _setup(struct _test_timer *t)
+{
+	memset(t, 0, sizeof(*t));
+	swtimer_setup(&t->timer, _check_callback, t);
+}
+
+/* Start a test with the clock at a given time, and no timer pending */
+static void _reset(const struct _swtimer_clock *clock, uint32_t time)
+{
+	sim_time = time;
+	sim_alarm_set = false;
+	sim_latency = 0;
+	callback_errors = 0;
+	swtimer_init(clock);
+}
+
+/* The alarm is programmed no later than the earliest expected expiry, and
+ * cancelled when no timer is armed */
+static void _check_alarm(const struct _test_timer *timers, uint32_t count)
+{
+	bool any = false;
+	uint32_t earliest = 0, i;
+
+	for (i = 0; i < count; i++) {
+		if (!timers[i].armed)
+			continue;
+		if (!any || _before_eq(timers[i].expected, earliest))
+			earliest = timers[i].expected;
+		any = true;
+	}
+	if (any) {
+		CHECK(sim_alarm_set);
+		CHECK(_before_eq(sim_alarm, earliest));
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Tests
+ *----------------------------------------------------------------------------*/
+
+/* Microseconds are rounded up to whole clock ticks */
+static void test_us_to_ticks(void)
+{
+	_reset(&sim_clock, 0);
+	CHECK_EQ(swtimer_us_to_ticks(0), 0);
+	CHECK_EQ(swtimer_us_to_ticks(1), 1);
+	CHECK_EQ(swtimer_us_to_ticks(123456), 123456);
+
+	_reset(&sim_clock_32k, 0);
+	CHECK_EQ(swtimer_us_to_ticks(1), 1);
+	CHECK_EQ(swtimer_us_to_ticks(30), 1);
+	CHECK_EQ(swtimer_us_to_ticks(31), 2);
+	CHECK_EQ(swtimer_us_to_ticks(1000000), 32768);
+}
+
+/* One-shot timers fire once, at their expiry, in order; the alarm is
+ * cancelled once they all have */
+static void test_one_shot(uint32_t start)
+{
+	static const uint32_t delays[] = {
+		1, 5, 1023, 1024, 1025, 3000, REVOLUTION - 1, REVOLUTION,
+		REVOLUTION + 1, 3 * REVOLUTION + 17, 1000000,
+	};
+	struct _test_timer timers[sizeof(delays) / sizeof(delays[0])];
+	uint32_t i, n = sizeof(delays) / sizeof(delays[0]);
+
+	_reset(&sim_clock, start);
+	for (i = 0; i < n; i++) {
+		_setup(&timers[i]);
+		_start(&timers[i], delays[i], 0);
+		CHECK(swtimer_is_pending(&timers[i].timer));
+	}
+	_check_alarm(timers, n);
+	CHECK_EQ(sim_alarm, start + 1);
+
+	_run(2000000);
+	for (i = 0; i < n; i++) {
+		CHECK_EQ(timers[i].count, 1);
+		CHECK_EQ(timers[i].fired_at, start + delays[i]);
+		CHECK(!swtimer_is_pending(&timers[i].timer));
+	}
+	CHECK(!sim_alarm_set);
+	CHECK_EQ(callback_errors, 0);
+}
+
+/* Periodic timers fire at each period; a late alarm skips the periods
+ * missed instead of running the callback in a burst */
+static void test_periodic(void)
+{
+	struct _test_timer fast, slow;
+
+	_reset(&sim_clock, 0xfffff000);
+	_setup(&fast);
+	_setup(&slow);
+	_start(&fast, 100, 250);
+	_start(&slow, 70000, 70000);
+	_run(1000000);
+	CHECK_EQ(fast.count, 1 + (1000000 - 100) / 250);
+	CHECK_EQ(slow.count, 1000000 / 70000);
+	CHECK_EQ(callback_errors, 0);
+
+	/* Process 600 ticks late: the periods within are skipped, and the
+	 * next expiry is a period after the late run */
+	_stop(&slow);
+	sim_latency = 600;
+	fast.count = 0;
+	_run_until(fast.expected + 600 - 1);
+	CHECK_EQ(fast.count, 0);
+	_run(1);
+	CHECK_EQ(fast.count, 1);
+	CHECK_EQ(sim_alarm, sim_time + 250);
+	sim_latency = 0;
+	fast.expected = sim_time + 250;
+	_run(1000);
+	CHECK_EQ(fast.count, 5);
+	CHECK_EQ(callback_errors, 0);
+
+	_stop(&fast);
+	_run(1000);
+	CHECK_EQ(fast.count, 5);
+}
+
+static struct _test_timer chain[3];
+
+/* Stops its successor, restarts itself for 10 ticks once */
+static void _chain_callback(struct _swtimer *timer, void *arg)
+{
+	struct _test_timer *t = arg;
+
+	_check_callback(timer, arg);
+	if (t == &chain[0]) {
+		_stop(&chain[1]);
+		if (t->count == 1)
+			_start(t, 10, 0);
+	}
+}
+
+/* Timers started and stopped from callbacks, including a timer that expires
+ * in the same run */
+static void test_from_callback(void)
+{
+	uint32_t i;
+
+	_reset(&sim_clock, 5000);
+	for (i = 0; i < 3; i++) {
+		_setup(&chain[i]);
+		chain[i].timer.callback = _chain_callback;
+	}
+	_start(&chain[0], 100, 0);
+	/* Expires in the same run as chain[0], stopped before its callback */
+	_start(&chain[1], 100, 0);
+	_start(&chain[2], 105, 0);
+	_run(1000);
+	CHECK_EQ(chain[0].count, 2);
+	CHECK_EQ(chain[0].fired_at, 5110);
+	CHECK_EQ(chain[1].count, 0);
+	CHECK_EQ(chain[2].count, 1);
+	CHECK(!sim_alarm_set);
+	CHECK_EQ(callback_errors, 0);
+}
+
+/* A timer re-armed or stopped before it expires moves the alarm as needed */
+static void test_restart(void)
+{
+	struct _test_timer a, b;
+
+	_reset(&sim_clock, 0);
+	_setup(&a);
+	_setup(&b);
+	_start(&a, 5000, 0);
+	_start(&b, 8000, 0);
+	CHECK_EQ(sim_alarm, 5000);
+	_start(&a, 9000, 0);
+	_run(100);
+	_check_alarm(&a, 1);
+	_check_alarm(&b, 1);
+	_run(8000);
+	CHECK_EQ(a.count, 0);
+	CHECK_EQ(b.count, 1);
+	CHECK_EQ(b.fired_at, 8000);
+	CHECK_EQ(sim_alarm, 9000);
+	_stop(&a);
+	_run(100000);
+	CHECK_EQ(a.count, 0);
+	CHECK(!sim_alarm_set);
+	CHECK_EQ(callback_errors, 0);
+}
+
+/* Random starts, stops and runs against the model, across a wrap-around of
+ * the clock; every expiry is checked by the callbacks */
+static void test_random(void)
+{
+	struct _test_timer timers[RANDOM_TIMERS];
+	uint32_t op, i, delay, period, alarms;
+
+	_reset(&sim_clock, 0xff000000);
+	for (i = 0; i < RANDOM_TIMERS; i++)
+		_setup(&timers[i]);
+
+	alarms = sim_alarms;
+	for (op = 0; op < RANDOM_OPERATIONS; op++) {
+		i = rand() % RANDOM_TIMERS;
+		switch (rand() % 4) {
+		case 0:
+		case 1:
+			/* Mostly short delays, some beyond a revolution */
+			delay = rand() % 8 ? rand() % 20000 :
+				rand() % (8 * REVOLUTION);
+			period = rand() % 4 ? 0 : 1 + rand() % 30000;
+			_start(&timers[i], delay, period);
+			break;
+		case 2:
+			_stop(&timers[i]);
+			break;
+		default:
+			_run(rand() % 10000);
+			break;
+		}
+		_check_alarm(timers, RANDOM_TIMERS);
+		CHECK(swtimer_is_pending(&timers[i].timer) == timers[i].armed);
+	}
+	CHECK(sim_time < 0xff000000);
+
+	for (i = 0; i < RANDOM_TIMERS; i++)
+		_stop(&timers[i]);
+	_run(10 * REVOLUTION);
+	CHECK(!sim_alarm_set);
+	CHECK_EQ(callback_errors, 0);
+	printf("%u alarms programmed for %u operations\n",
+	       (unsigned)(sim_alarms - alarms), RANDOM_OPERATIONS);
+}
+
+/*----------------------------------------------------------------------------
+ *        Main
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	srand(1);
+	RUN_TEST(test_us_to_ticks);
+	RUN_TEST(test_one_shot, 0);
+	RUN_TEST(test_one_shot, 0xfff00000);
+	RUN_TEST(test_periodic);
+	RUN_TEST(test_from_callback);
+	RUN_TEST(test_restart);
+	RUN_TEST(test_random);
+	return HOST_TEST_EXIT();
+}
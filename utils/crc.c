@@ -31,62 +31,260 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
-#include "board.h"
-#include "chip.h"
-
 #include "crc.h"
+#include "crc_private.h"
 
 /*------------------------------------------------------------------------------
- *         Local variables
+ *         Local constants
  *----------------------------------------------------------------------------*/
 
-uint8_t Crc8;
+/** Bytes processed per iteration by the CRC-8: the 8-bit CRC only needs four
+ * tables to go word-at-a-time. */
+#if CRC_SLICES > 1
+#define CRC8_SLICES 4
+#else
+#define CRC8_SLICES 1
+#endif
 
-//------------------------------------------------------------------------------
-///        Local functions
-//------------------------------------------------------------------------------
+/** CRC-8/MAXIM lookup tables, poly 0x8C (reflected). Table [0] is the usual
+ * byte-wise table; table [n] gives the contribution of a byte followed by n
+ * other bytes. */
+static const uint8_t crc8_table[CRC8_SLICES][256] =
+{
+	{
+		  0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,
+		157,195, 33,127,252,162, 64, 30, 95,  1,227,189, 62, 96,130,220,
+		 35,125,159,193, 66, 28,254,160,225,191, 93,  3,128,222, 60, 98,
+		190,224,  2, 92,223,129, 99, 61,124, 34,192,158, 29, 67,161,255,
+		 70, 24,250,164, 39,121,155,197,132,218, 56,102,229,187, 89,  7,
+		219,133,103, 57,186,228,  6, 88, 25, 71,165,251,120, 38,196,154,
+		101, 59,217,135,  4, 90,184,230,167,249, 27, 69,198,152,122, 36,
+		248,166, 68, 26,153,199, 37,123, 58,100,134,216, 91,  5,231,185,
+		140,210, 48,110,237,179, 81, 15, 78, 16,242,172, 47,113,147,205,
+		 17, 79,173,243,112, 46,204,146,211,141,111, 49,178,236, 14, 80,
+		175,241, 19, 77,206,144,114, 44,109, 51,209,143, 12, 82,176,238,
+		 50,108,142,208, 83, 13,239,177,240,174, 76, 18,145,207, 45,115,
+		202,148,118, 40,171,245, 23, 73,  8, 86,180,234,105, 55,213,139,
+		 87,  9,235,181, 54,104,138,212,149,203, 41,119,244,170, 72, 22,
+		233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,
+		116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53
+	},
+#if CRC8_SLICES > 1
+	{
+		  0,196,145, 85, 59,255,170,110,118,178,231, 35, 77,137,220, 24,
+		236, 40,125,185,215, 19, 70,130,154, 94, 11,207,161,101, 48,244,
+		193,  5, 80,148,250, 62,107,175,183,115, 38,226,140, 72, 29,217,
+		 45,233,188,120, 22,210,135, 67, 91,159,202, 14, 96,164,241, 53,
+		155, 95, 10,206,160,100, 49,245,237, 41,124,184,214, 18, 71,131,
+		119,179,230, 34, 76,136,221, 25,  1,197,144, 84, 58,254,171,111,
+		 90,158,203, 15, 97,165,240, 52, 44,232,189,121, 23,211,134, 66,
+		182,114, 39,227,141, 73, 28,216,192,  4, 81,149,251, 63,106,174,
+		 47,235,190,122, 20,208,133, 65, 89,157,200, 12, 98,166,243, 55,
+		195,  7, 82,150,248, 60,105,173,181,113, 36,224,142, 74, 31,219,
+		238, 42,127,187,213, 17, 68,128,152, 92,  9,205,163,103, 50,246,
+		  2,198,147, 87, 57,253,168,108,116,176,229, 33, 79,139,222, 26,
+		180,112, 37,225,143, 75, 30,218,194,  6, 83,151,249, 61,104,172,
+		 88,156,201, 13, 99,167,242, 54, 46,234,191,123, 21,209,132, 64,
+		117,177,228, 32, 78,138,223, 27,  3,199,146, 86, 56,252,169,109,
+		153, 93,  8,204,162,102, 51,247,239, 43,126,186,212, 16, 69,129
+	},
+	{
+		  0,171, 79,228,158, 53,209,122, 37,142,106,193,187, 16,244, 95,
+		 74,225,  5,174,212,127,155, 48,111,196, 32,139,241, 90,190, 21,
+		148, 63,219,112, 10,161, 69,238,177, 26,254, 85, 47,132, 96,203,
+		222,117,145, 58, 64,235, 15,164,251, 80,180, 31,101,206, 42,129,
+		 49,154,126,213,175,  4,224, 75, 20,191, 91,240,138, 33,197,110,
+		123,208, 52,159,229, 78,170,  1, 94,245, 17,186,192,107,143, 36,
+		165, 14,234, 65, 59,144,116,223,128, 43,207,100, 30,181, 81,250,
+		239, 68,160, 11,113,218, 62,149,202, 97,133, 46, 84,255, 27,176,
+		 98,201, 45,134,252, 87,179, 24, 71,236,  8,163,217,114,150, 61,
+		 40,131,103,204,182, 29,249, 82, 13,166, 66,233,147, 56,220,119,
+		246, 93,185, 18,104,195, 39,140,211,120,156, 55, 77,230,  2,169,
+		188, 23,243, 88, 34,137,109,198,153, 50,214,125,  7,172, 72,227,
+		 83,248, 28,183,205,102,130, 41,118,221, 57,146,232, 67,167, 12,
+		 25,178, 86,253,135, 44,200, 99, 60,151,115,216,162,  9,237, 70,
+		199,108,136, 35, 89,242, 22,189,226, 73,173,  6,124,215, 51,152,
+		141, 38,194,105, 19,184, 92,247,168,  3,231, 76, 54,157,121,210
+	},
+	{
+		  0,143,  7,136, 14,129,  9,134, 28,147, 27,148, 18,157, 21,154,
+		 56,183, 63,176, 54,185, 49,190, 36,171, 35,172, 42,165, 45,162,
+		112,255,119,248,126,241,121,246,108,227,107,228, 98,237,101,234,
+		 72,199, 79,192, 70,201, 65,206, 84,219, 83,220, 90,213, 93,210,
+		224,111,231,104,238, 97,233,102,252,115,251,116,242,125,245,122,
+		216, 87,223, 80,214, 89,209, 94,196, 75,195, 76,202, 69,205, 66,
+		144, 31,151, 24,158, 17,153, 22,140,  3,139,  4,130, 13,133, 10,
+		168, 39,175, 32,166, 41,161, 46,180, 59,179, 60,186, 53,189, 50,
+		217, 86,222, 81,215, 88,208, 95,197, 74,194, 77,203, 68,204, 67,
+		225,110,230,105,239, 96,232,103,253,114,250,117,243,124,244,123,
+		169, 38,174, 33,167, 40,160, 47,181, 58,178, 61,187, 52,188, 51,
+		145, 30,150, 25,159, 16,152, 23,141,  2,138,  5,131, 12,132, 11,
+		 57,182, 62,177, 55,184, 48,191, 37,170, 34,173, 43,164, 44,163,
+		  1,142,  6,137, 15,128,  8,135, 29,146, 26,149, 19,156, 20,155,
+		 73,198, 78,193, 71,200, 64,207, 85,218, 82,221, 91,212, 92,211,
+		113,254,118,249,127,240,120,247,109,226,106,229, 99,236,100,235
+	},
+#endif
+};
 
-//------------------------------------------------------------------------------
-// Calculate the CRC8 of the byte value provided with the current
-// global 'crc8' value.
-// Returns current global crc8 value
-//------------------------------------------------------------------------------
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
 
-static const uint8_t dscrc_table[] =
+/**
+ * \brief Update a CRC-8/MAXIM, processing CRC8_SLICES bytes per iteration
+ * once the data pointer is word-aligned.
+ */
+static uint32_t _crc8_update(uint32_t crc, const uint8_t* data,
+		uint32_t length)
 {
-	0, 94,188,226, 97, 63,221,131,194,156,126, 32,163,253, 31, 65,
-	157,195, 33,127,252,162, 64, 30, 95,  1,227,189, 62, 96,130,220,
-	35,125,159,193, 66, 28,254,160,225,191, 93,  3,128,222, 60, 98,
-	190,224,  2, 92,223,129, 99, 61,124, 34,192,158, 29, 67,161,255,
-	70, 24,250,164, 39,121,155,197,132,218, 56,102,229,187, 89,  7,
-	219,133,103, 57,186,228,  6, 88, 25, 71,165,251,120, 38,196,154,
-	101, 59,217,135,  4, 90,184,230,167,249, 27, 69,198,152,122, 36,
-	248,166, 68, 26,153,199, 37,123, 58,100,134,216, 91,  5,231,185,
-	140,210, 48,110,237,179, 81, 15, 78, 16,242,172, 47,113,147,205,
-	17, 79,173,243,112, 46,204,146,211,141,111, 49,178,236, 14, 80,
-	175,241, 19, 77,206,144,114, 44,109, 51,209,143, 12, 82,176,238,
-	50,108,142,208, 83, 13,239,177,240,174, 76, 18,145,207, 45,115,
-	202,148,118, 40,171,245, 23, 73,  8, 86,180,234,105, 55,213,139,
-	87,  9,235,181, 54,104,138,212,149,203, 41,119,244,170, 72, 22,
-	233,183, 85, 11,136,214, 52,106, 43,117,151,201, 74, 20,246,168,
-	116, 42,200,150, 21, 75,169,247,182,232, 10, 84,215,137,107, 53};
-
-static uint8_t _do_crc8 (uint8_t value)
+#if CRC8_SLICES > 1
+	uint32_t word;
+
+	/* Head, up to the first word boundary */
+	while (length && ((uintptr_t)data & 3)) {
+		crc = crc8_table[0][crc ^ *data++];
+		length--;
+	}
+
+	/* Body, as aligned words (little-endian) */
+	while (length >= 4) {
+		word = *(const uint32_t*)data ^ crc;
+		crc = crc8_table[3][word & 0xff] ^
+		      crc8_table[2][(word >> 8) & 0xff] ^
+		      crc8_table[1][(word >> 16) & 0xff] ^
+		      crc8_table[0][word >> 24];
+		data += 4;
+		length -= 4;
+	}
+#endif
+
+	/* Tail (or all of it, byte-wise) */
+	while (length--)
+		crc = crc8_table[0][crc ^ *data++];
+	return crc;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Start an incremental CRC computation.
+ * Only the algorithms enabled in the build configuration are available.
+ * \param ctx  Pointer to the context to initialize
+ * \param type CRC algorithm
+ * \return true on success, false if the algorithm is not built in. In
+ * that case the context computes nothing and crc_final() returns 0.
+ */
+bool crc_init(struct _crc_ctx* ctx, enum _crc_type type)
 {
-	return dscrc_table[Crc8 ^ value];
+	ctx->type = type;
+	switch (type) {
+	case CRC_8_MAXIM:
+		ctx->crc = 0;
+		return true;
+#ifdef CONFIG_CRC_16
+	case CRC_16_CCITT:
+		ctx->crc = 0xffff;
+		return true;
+#endif
+#ifdef CONFIG_CRC_32
+	case CRC_32:
+#endif
+#ifdef CONFIG_CRC_32C
+	case CRC_32C:
+#endif
+#if defined(CONFIG_CRC_32) || defined(CONFIG_CRC_32C)
+		ctx->crc = 0xffffffff;
+		return true;
+#endif
+	default:
+		ctx->crc = 0;
+		return false;
+	}
 }
 
-//------------------------------------------------------------------------------
-//------------------------------------------------------------------------------
+/**
+ * \brief Add data to an incremental CRC computation.
+ * \param ctx    Pointer to a context initialized by crc_init()
+ * \param data   Pointer to the data
+ * \param length Length of the data, in bytes
+ */
+void crc_update(struct _crc_ctx* ctx, const void* data, uint32_t length)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint32_t crc = ctx->crc;
 
-uint8_t compute_crc8 (uint8_t* pData, uint8_t Length)
+	switch (ctx->type) {
+	case CRC_8_MAXIM:
+		crc = _crc8_update(crc, bytes, length);
+		break;
+#ifdef CONFIG_CRC_16
+	case CRC_16_CCITT:
+		crc = crc16_ccitt_update(crc, bytes, length);
+		break;
+#endif
+#ifdef CONFIG_CRC_32
+	case CRC_32:
+#endif
+#ifdef CONFIG_CRC_32C
+	case CRC_32C:
+#endif
+#if defined(CONFIG_CRC_32) || defined(CONFIG_CRC_32C)
+		crc = crc32_update(ctx->type, crc, bytes, length);
+		break;
+#endif
+	default:
+		break;
+	}
+	ctx->crc = crc;
+}
+
+/**
+ * \brief Return the CRC of the data processed so far. The context remains
+ * valid, and may be updated further.
+ * \param ctx Pointer to the context
+ */
+uint32_t crc_final(const struct _crc_ctx* ctx)
 {
-	Crc8 = 0x00;
-	while (Length)
-	{
-		Crc8 = _do_crc8( *pData);
-		pData ++;
-		Length--;
+	switch (ctx->type) {
+#ifdef CONFIG_CRC_32
+	case CRC_32:
+#endif
+#ifdef CONFIG_CRC_32C
+	case CRC_32C:
+#endif
+#if defined(CONFIG_CRC_32) || defined(CONFIG_CRC_32C)
+		return ctx->crc ^ 0xffffffff;
+#endif
+	default:
+		return ctx->crc;
 	}
-	return Crc8;
+}
+
+/**
+ * \brief Compute the CRC of a buffer in one call.
+ * \param type   CRC algorithm
+ * \param data   Pointer to the data
+ * \param length Length of the data, in bytes
+ * \return the CRC, or 0 if the algorithm is not built in (see crc_init())
+ */
+uint32_t crc_compute(enum _crc_type type, const void* data, uint32_t length)
+{
+	struct _crc_ctx ctx;
+
+	crc_init(&ctx, type);
+	crc_update(&ctx, data, length);
+	return crc_final(&ctx);
+}
+
+/**
+ * \brief Compute the CRC-8/MAXIM of a buffer.
+ * \param data   Pointer to the data
+ * \param length Length of the data, in bytes
+ */
+uint8_t compute_crc8(const uint8_t* data, uint32_t length)
+{
+	return (uint8_t)crc_compute(CRC_8_MAXIM, data, length);
 }
@@ -30,12 +30,71 @@
 #ifndef _CRC_H_
 #define _CRC_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 
-//------------------------------------------------------------------------------
-//------------------------------------------------------------------------------
+/*------------------------------------------------------------------------------
+ *         Defines
+ *------------------------------------------------------------------------------*/
 
-extern uint8_t compute_crc8 (uint8_t* pData, uint8_t Length);
+/*
+ * CRC-8 is always available, with CRC_SLICES > 1 it uses 1 KiB of constant
+ * tables, 256 bytes otherwise. The other algorithms live in their own objects
+ * and are built in when enabled in the application Makefile:
+ * - CONFIG_CRC_16 = y: CRC-16, 512 bytes of constant tables;
+ * - CONFIG_CRC_32 = y: CRC-32, CRC_SLICES KiB of constant tables;
+ * - CONFIG_CRC_32C = y: CRC-32C, CRC_SLICES KiB of constant tables.
+ * All three are enabled by default. The tables are const, and are placed with
+ * the read-only data of the application rather than built in RAM.
+ * crc_init() returns false for an algorithm that is not built in.
+ */
+
+/** Number of bytes processed per iteration by the CRC-32 and CRC-32C
+ * implementations: 1 (byte-wise), 4 or 8. The lookup tables occupy 1 KiB per
+ * byte processed per iteration, per algorithm. The CRC-8 goes word-at-a-time
+ * whenever CRC_SLICES > 1. Set with CONFIG_CRC_SLICES in the application
+ * Makefile. */
+#ifndef CRC_SLICES
+#define CRC_SLICES 8
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** CRC algorithms */
+enum _crc_type {
+	/** CRC-8/MAXIM (Dallas 1-Wire): poly 0x31 reflected, init 0x00 */
+	CRC_8_MAXIM,
+	/** CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF */
+	CRC_16_CCITT,
+	/** CRC-32 (Ethernet, zip): poly 0x04C11DB7 reflected, init and final
+	 * XOR 0xFFFFFFFF */
+	CRC_32,
+	/** CRC-32C (Castagnoli): poly 0x1EDC6F41 reflected, init and final
+	 * XOR 0xFFFFFFFF */
+	CRC_32C,
+};
+
+/** Context of an incremental CRC computation */
+struct _crc_ctx {
+	enum _crc_type type;
+	uint32_t crc;
+};
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+extern bool crc_init(struct _crc_ctx* ctx, enum _crc_type type);
+
+extern void crc_update(struct _crc_ctx* ctx, const void* data, uint32_t length);
+
+extern uint32_t crc_final(const struct _crc_ctx* ctx);
+
+extern uint32_t crc_compute(enum _crc_type type, const void* data,
+		uint32_t length);
 
+extern uint8_t compute_crc8(const uint8_t* data, uint32_t length);
 
-#endif // _CRC_H_
+#endif /* _CRC_H_ */
@@ -36,26 +36,40 @@
 #include "hamming.h"
 #include "trace.h"
 
+#include <stdbool.h>
+
 /*----------------------------------------------------------------------------
  *         Internal function
  *----------------------------------------------------------------------------*/
 
+/** Bits of a nibble moved to the even bit positions of a byte, to interleave
+ * the even and odd parity groups */
+static const uint8_t spread_nibble[16] = {
+	0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+	0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+};
+
 /**
- *  Counts and return the number of bits set to '1' in the given byte.
- *  \param byte  Byte to count.
+ *  Returns the parity of a 32-bit word.
+ *  \param value  Word to compute the parity of.
  */
-static uint8_t count_bits_in_byte(uint8_t byte)
+static inline uint32_t parity32(uint32_t value)
 {
-	uint8_t count = 0;
-
-	while (byte > 0) {
-		if (byte & 1) {
-			count++;
-		}
-		byte >>= 1;
-	}
+	value ^= value >> 16;
+	value ^= value >> 8;
+	value ^= value >> 4;
+	/* 0x6996 is the parity table of the 16 nibble values */
+	return (0x6996 >> (value & 0xf)) & 1;
+}
 
-	return count;
+/**
+ *  Loads a little-endian 32-bit word from a possibly unaligned address.
+ *  \param data  Address of the word.
+ */
+static inline uint32_t load32(const uint8_t *data)
+{
+	return data[0] | (data[1] << 8) | (data[2] << 16) |
+		((uint32_t)data[3] << 24);
 }
 
 /**
@@ -64,75 +78,89 @@ static uint8_t count_bits_in_byte(uint8_t byte)
  */
 static uint8_t count_bits_in_code256(uint8_t *code)
 {
-	return count_bits_in_byte(code[0]) +
-		count_bits_in_byte(code[1]) +
-		count_bits_in_byte(code[2]);
+	uint32_t value = code[0] | (code[1] << 8) | (code[2] << 16);
+	uint8_t count = 0;
+
+	while (value) {
+		value &= value - 1;
+		count++;
+	}
+	return count;
 }
 
 /**
  *  Calculates the 22-bit hamming code for a 256-bytes block of data.
+ *
+ *  The line parities P1..P128 (resp. P1'..P128') are the parities of the
+ *  bytes whose index has the corresponding bit cleared (resp. set). The data
+ *  is processed 32 bits at a time: bits 0 and 1 of the byte index select the
+ *  byte lane in a word, and bits 2 to 7 select the word. The words are thus
+ *  accumulated in the xor of all words and in the xor of the words whose
+ *  index has each bit set, their parities giving the odd line parities. As
+ *  each byte belongs to either Px or Px', the even parities are the odd ones
+ *  inverted when the whole block has an odd parity. The column parities are
+ *  derived the same way from the xor of all bytes.
+ *
  *  \param data Data buffer to calculate code for.
  *  \param code Pointer to a buffer where the code should be stored.
  */
 static void compute256(const uint8_t *data, uint8_t *code)
 {
-	uint32_t i;
-	uint8_t column_sum = 0;
-	uint8_t even_line_code = 0;
-	uint8_t odd_line_code = 0;
-	uint8_t even_column_code = 0;
-	uint8_t odd_column_code = 0;
-
-	// Xor all bytes together to get the column sum;
-	// At the same time, calculate the even and odd line codes
-	for (i = 0; i < 256; i++) {
-		column_sum ^= data[i];
-
-		// If the xor sum of the byte is 0, then this byte has no incidence on
-		// the computed code; so check if the sum is 1.
-		if ((count_bits_in_byte(data[i]) & 1) == 1) {
-			// Parity groups are formed by forcing a particular index bit to 0
-			// (even) or 1 (odd).
-			// Example on one byte:
-			//
-			// bits (dec)  7   6   5   4   3   2   1   0
-			//      (bin) 111 110 101 100 011 010 001 000
-			//                            '---'---'---'----------.
-			//                                                   |
-			// groups P4' ooooooooooooooo eeeeeeeeeeeeeee P4     |
-			//        P2' ooooooo eeeeeee ooooooo eeeeeee P2     |
-			//        P1' ooo eee ooo eee ooo eee ooo eee P1     |
-			//                                                   |
-			// We can see that:                                  |
-			//  - P4  -> bit 2 of index is 0 --------------------'
-			//  - P4' -> bit 2 of index is 1.
-			//  - P2  -> bit 1 of index if 0.
-			//  - etc...
-			// We deduce that a bit position has an impact on all even Px if
-			// the log2(x)nth bit of its index is 0
-			//     ex: log2(4) = 2, bit2 of the index must be 0 (-> 0 1 2 3)
-			// and on all odd Px' if the log2(x)nth bit of its index is 1
-			//     ex: log2(2) = 1, bit1 of the index must be 1 (-> 0 1 4 5)
-			//
-			// As such, we calculate all the possible Px and Px' values at the
-			// same time in two variables, even_line_code and odd_line_code, such as
-			//     even_line_code bits: P128  P64  P32  P16  P8  P4  P2  P1
-			//     odd_line_code  bits: P128' P64' P32' P16' P8' P4' P2' P1'
-			//
-			even_line_code ^= (255 - i);
-			odd_line_code ^= i;
+	uint32_t i, sum = 0, lane1 = 0, lane2 = 0;
+	uint32_t index_sum[4] = { 0, 0, 0, 0 };
+	uint32_t column_sum, parity;
+	uint8_t even_line_code, odd_line_code;
+	uint8_t even_column_code, odd_column_code;
+	bool aligned = ((uintptr_t)data & 3) == 0;
+
+	/* Process 16 groups of 4 words: the word index bits 0 and 1 are
+	 * handled within a group, bits 2 to 5 by the group index */
+	for (i = 0; i < 16; i++) {
+		uint32_t w0, w1, w2, w3, group;
+
+		if (aligned) {
+			const uint32_t *words = (const uint32_t *)data;
+			w0 = words[0];
+			w1 = words[1];
+			w2 = words[2];
+			w3 = words[3];
+		} else {
+			w0 = load32(data);
+			w1 = load32(data + 4);
+			w2 = load32(data + 8);
+			w3 = load32(data + 12);
 		}
+		data += 16;
+
+		lane1 ^= w1 ^ w3;
+		lane2 ^= w2 ^ w3;
+		group = w0 ^ w1 ^ w2 ^ w3;
+		sum ^= group;
+		index_sum[0] ^= group & -(i & 1);
+		index_sum[1] ^= group & -((i >> 1) & 1);
+		index_sum[2] ^= group & -((i >> 2) & 1);
+		index_sum[3] ^= group & -((i >> 3) & 1);
 	}
 
-	// At this point, we have the line parities, and the column sum. First, We
-	// must caculate the parity group values on the column sum.
-	for (i = 0; i < 8; i++) {
-		if (column_sum & 1) {
-			even_column_code ^= (7 - i);
-			odd_column_code ^= i;
-		}
-		column_sum >>= 1;
-	}
+	/* Odd line parities: byte lanes for index bits 0 and 1, words for
+	 * index bits 2 to 7 */
+	odd_line_code = parity32(sum & 0xff00ff00) |
+		(parity32(sum & 0xffff0000) << 1) |
+		(parity32(lane1) << 2) |
+		(parity32(lane2) << 3) |
+		(parity32(index_sum[0]) << 4) |
+		(parity32(index_sum[1]) << 5) |
+		(parity32(index_sum[2]) << 6) |
+		(parity32(index_sum[3]) << 7);
+
+	column_sum = (sum ^ (sum >> 8) ^ (sum >> 16) ^ (sum >> 24)) & 0xff;
+	odd_column_code = parity32(column_sum & 0xaa) |
+		(parity32(column_sum & 0xcc) << 1) |
+		(parity32(column_sum & 0xf0) << 2);
+
+	parity = parity32(column_sum);
+	even_line_code = odd_line_code ^ (parity ? 0xff : 0);
+	even_column_code = odd_column_code ^ (parity ? 0x07 : 0);
 
 	// Now, we must interleave the parity values, to obtain the following layout:
 	// Code[0] = Line1
@@ -140,50 +168,13 @@ static void compute256(const uint8_t *data, uint8_t *code)
 	// Code[2] = Column
 	// Line = Px' Px P(x-1)- P(x-1) ...
 	// Column = P4' P4 P2' P2 P1' P1 PadBit PadBit
-	code[0] = 0;
-	code[1] = 0;
-	code[2] = 0;
-
-	for (i = 0; i < 4; i++) {
-		code[0] <<= 2;
-		code[1] <<= 2;
-		code[2] <<= 2;
-
-		// Line 1
-		if ((odd_line_code & 0x80) != 0) {
-			code[0] |= 2;
-		}
-
-		if ((even_line_code & 0x80) != 0) {
-			code[0] |= 1;
-		}
-		// Line 2
-		if ((odd_line_code & 0x08) != 0) {
-			code[1] |= 2;
-		}
-
-		if ((even_line_code & 0x08) != 0) {
-			code[1] |= 1;
-		}
-		// Column
-		if ((odd_column_code & 0x04) != 0) {
-			code[2] |= 2;
-		}
-
-		if ((even_column_code & 0x04) != 0) {
-			code[2] |= 1;
-		}
-
-		odd_line_code <<= 1;
-		even_line_code <<= 1;
-		odd_column_code <<= 1;
-		even_column_code <<= 1;
-	}
-
-	// Invert codes (linux compatibility)
-	code[0] = ~code[0];
-	code[1] = ~code[1];
-	code[2] = ~code[2];
+	// Codes are inverted for linux compatibility
+	code[0] = ~((spread_nibble[odd_line_code >> 4] << 1) |
+			spread_nibble[even_line_code >> 4]);
+	code[1] = ~((spread_nibble[odd_line_code & 0xf] << 1) |
+			spread_nibble[even_line_code & 0xf]);
+	code[2] = ~(((spread_nibble[odd_column_code] << 1) |
+			spread_nibble[even_column_code]) << 2);
 
 	trace_debug("Computed code = %02x %02x %02x\n\r",
 			(unsigned)code[0],
@@ -242,7 +233,7 @@ static uint8_t verify256(uint8_t *data, const uint8_t *code)
 		bit |= (correction_code[2] >> 3) & 0x01;
 
 		/* Correct bit */
-		printf("Correcting byte #%d at bit %d\n\r", byte, bit);
+		trace_debug("Correcting byte #%d at bit %d\n\r", byte, bit);
 		data[byte] ^= (1 << bit);
 
 		return HAMMING_ERROR_SINGLEBIT;
@@ -0,0 +1,129 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "lz4.h"
+
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Local constants
+ *----------------------------------------------------------------------------*/
+
+/** Shortest match of the format, the match length field is biased by it */
+#define LZ4_MIN_MATCH 4
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Read the extension bytes of a literal or match length.
+ * \return false if the input ends or the length exceeds limit.
+ */
+static bool _read_length(const uint8_t **ip, const uint8_t *iend,
+		uint32_t *len, uint32_t limit)
+{
+	uint8_t byte;
+
+	do {
+		if (*ip >= iend)
+			return false;
+		byte = *(*ip)++;
+		*len += byte;
+		if (*len > limit)
+			return false;
+	} while (byte == 255);
+	return true;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+bool lz4_decompress(const void *src, uint32_t src_len,
+		void *dst, uint32_t dst_size, uint32_t *dst_len)
+{
+	const uint8_t *ip = (const uint8_t*)src;
+	const uint8_t *iend = ip + src_len;
+	uint8_t *op = (uint8_t*)dst;
+	uint8_t *oend = op + dst_size;
+	const uint8_t *match;
+	uint32_t len, offset;
+	uint8_t token;
+
+	while (ip < iend) {
+		token = *ip++;
+
+		/* Literals */
+		len = token >> 4;
+		if (len == 15 && !_read_length(&ip, iend, &len, src_len))
+			return false;
+		if (len > (uint32_t)(iend - ip) || len > (uint32_t)(oend - op))
+			return false;
+		memcpy(op, ip, len);
+		ip += len;
+		op += len;
+
+		/* The last sequence has no match */
+		if (ip == iend)
+			break;
+
+		/* Match */
+		if (iend - ip < 2)
+			return false;
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > (uint32_t)(op - (uint8_t*)dst))
+			return false;
+		len = token & 15;
+		if (len == 15 && !_read_length(&ip, iend, &len, dst_size))
+			return false;
+		len += LZ4_MIN_MATCH;
+		if (len > (uint32_t)(oend - op))
+			return false;
+
+		/* A match closer than its length overlaps its own output and
+		 * repeats a pattern, it is copied byte by byte */
+		match = op - offset;
+		if (offset >= len) {
+			memcpy(op, match, len);
+			op += len;
+		} else {
+			while (len--)
+				*op++ = *match++;
+		}
+	}
+
+	*dst_len = op - (uint8_t*)dst;
+	return true;
+}
@@ -0,0 +1,344 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Profiling probes.
+ *
+ * The aggregation below only depends on the C library, so that it can be
+ * built and exercised on a host computer with CONFIG_PROF_HOST; the counters
+ * are read through the small backend at the top of the file.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#ifndef CONFIG_PROF_HOST
+#include "chip.h"
+#include "core/arm_cp15_pmu.h"
+#include "misc/console.h"
+#else
+#include <time.h>
+#endif
+
+#include "compiler.h"
+#include "prof.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Registered probes, most recent first */
+static struct _prof_probe *prof_probes;
+
+/** Cost of an empty probe, subtracted from every duration */
+static uint32_t prof_overhead;
+
+#ifndef CONFIG_PROF_HOST
+/** Key that requests a dump from the console */
+static uint8_t prof_console_key;
+
+/** Set by the console handler, cleared by prof_poll() */
+static volatile bool prof_dump_requested;
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions: backend
+ *----------------------------------------------------------------------------*/
+
+#ifndef CONFIG_PROF_HOST
+
+#ifndef CONFIG_CORE_CORTEXA5
+#error "Profiling requires the Cortex-A5 performance monitor"
+#endif
+
+#define PROF_UNIT "cycles"
+
+static void _prof_counters_init(void)
+{
+	cp15_init_cycle_counter();
+	cp15_cycle_count_divider(CP15_CountDividerSingle);
+	cp15_init_perf_counter(L1_DC_FILL, CP15_Counter0);
+	cp15_init_perf_counter(L1_DTLB_FILL, CP15_Counter1);
+}
+
+static inline uint32_t _prof_cycles(void)
+{
+	return cp15_get_cycle_counter();
+}
+
+static inline void _prof_events(uint32_t *events)
+{
+	events[PROF_EVENT_DCACHE_MISS] = cp15_count_evt(CP15_Counter0);
+	events[PROF_EVENT_DTLB_MISS] = cp15_count_evt(CP15_Counter1);
+}
+
+static inline uint32_t _prof_lock(void)
+{
+	uint32_t cpsr = cpsr_get();
+	cpsr_set_bits(CPSR_MASK_IRQ);
+	return cpsr;
+}
+
+static inline void _prof_unlock(uint32_t cpsr)
+{
+	if (!(cpsr & CPSR_MASK_IRQ))
+		cpsr_clear_bits(CPSR_MASK_IRQ);
+}
+
+#else /* CONFIG_PROF_HOST */
+
+#define PROF_UNIT "ns"
+
+static void _prof_counters_init(void)
+{
+}
+
+static inline uint32_t _prof_cycles(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint32_t)ts.tv_sec * 1000000000u + (uint32_t)ts.tv_nsec;
+}
+
+static inline void _prof_events(uint32_t *events)
+{
+	memset(events, 0, PROF_EVENTS * sizeof(*events));
+}
+
+static inline uint32_t _prof_lock(void)
+{
+	return 0;
+}
+
+static inline void _prof_unlock(uint32_t state)
+{
+	(void)state;
+}
+
+#endif /* CONFIG_PROF_HOST */
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Index of the histogram bucket of a duration
+ */
+static uint32_t _prof_bucket(uint32_t cycles)
+{
+	uint32_t bucket;
+
+	if (!cycles)
+		return 0;
+	bucket = 32 - CLZ(cycles);
+	return bucket < PROF_HIST_BUCKETS ? bucket : PROF_HIST_BUCKETS - 1;
+}
+
+static void _prof_clear(struct _prof_probe *probe)
+{
+	probe->count = 0;
+	probe->min = UINT32_MAX;
+	probe->max = 0;
+	probe->total = 0;
+	memset(probe->events, 0, sizeof(probe->events));
+	memset(probe->hist, 0, sizeof(probe->hist));
+}
+
+/**
+ * \brief Print a number of events per run, with one decimal
+ */
+static void _prof_print_events(uint64_t events, uint32_t count)
+{
+	uint32_t tenths = (uint32_t)(events * 10 / count);
+	printf(" %7u.%u", (unsigned)(tenths / 10), (unsigned)(tenths % 10));
+}
+
+static void _prof_print_probe(const struct _prof_probe *probe)
+{
+	uint32_t i;
+
+	printf("%-20s %9u %9u %9u %9u", probe->name, (unsigned)probe->count,
+	       (unsigned)probe->min, (unsigned)(probe->total / probe->count),
+	       (unsigned)probe->max);
+	for (i = 0; i < PROF_EVENTS; i++)
+		_prof_print_events(probe->events[i], probe->count);
+	printf("\r\n");
+
+	printf("  hist:");
+	for (i = 0; i < PROF_HIST_BUCKETS; i++) {
+		if (!probe->hist[i])
+			continue;
+		if (i == PROF_HIST_BUCKETS - 1)
+			printf(" >=2^%u:%u", (unsigned)(i - 1),
+			       (unsigned)probe->hist[i]);
+		else
+			printf(" <2^%u:%u", (unsigned)i,
+			       (unsigned)probe->hist[i]);
+	}
+	printf("\r\n");
+}
+
+#ifndef CONFIG_PROF_HOST
+static void _prof_console_handler(uint8_t key)
+{
+	if (key == prof_console_key)
+		prof_dump_requested = true;
+}
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void prof_init(void)
+{
+	struct _prof_sample sample;
+	uint32_t i, cycles, best = UINT32_MAX;
+
+	_prof_counters_init();
+
+	prof_overhead = 0;
+	for (i = 0; i < 16; i++) {
+		prof_begin(&sample);
+		cycles = _prof_cycles() - sample.cycles;
+		if (cycles < best)
+			best = cycles;
+	}
+	prof_overhead = best;
+}
+
+void prof_begin(struct _prof_sample *sample)
+{
+	_prof_events(sample->events);
+	sample->cycles = _prof_cycles();
+}
+
+void prof_end(struct _prof_probe *probe, const struct _prof_sample *sample)
+{
+	uint32_t cycles = _prof_cycles() - sample->cycles;
+	uint32_t events[PROF_EVENTS];
+	uint32_t i;
+
+	_prof_events(events);
+	for (i = 0; i < PROF_EVENTS; i++)
+		events[i] -= sample->events[i];
+	cycles = cycles > prof_overhead ? cycles - prof_overhead : 0;
+
+	prof_record(probe, cycles, events);
+}
+
+void prof_record(struct _prof_probe *probe, uint32_t cycles,
+		const uint32_t *events)
+{
+	uint32_t state, i;
+
+	state = _prof_lock();
+
+	if (!probe->registered) {
+		_prof_clear(probe);
+		probe->next = prof_probes;
+		prof_probes = probe;
+		probe->registered = true;
+	}
+
+	probe->count++;
+	if (cycles < probe->min)
+		probe->min = cycles;
+	if (cycles > probe->max)
+		probe->max = cycles;
+	probe->total += cycles;
+	probe->hist[_prof_bucket(cycles)]++;
+	if (events) {
+		for (i = 0; i < PROF_EVENTS; i++)
+			probe->events[i] += events[i];
+	}
+
+	_prof_unlock(state);
+}
+
+void prof_reset(void)
+{
+	struct _prof_probe *probe;
+	uint32_t state;
+
+	state = _prof_lock();
+	for (probe = prof_probes; probe; probe = probe->next)
+		_prof_clear(probe);
+	_prof_unlock(state);
+}
+
+void prof_dump(void)
+{
+	struct _prof_probe *probe;
+	struct _prof_probe copy;
+	uint32_t state;
+
+	printf("%-20s %9s %9s %9s %9s %9s %9s\r\n", "probe (" PROF_UNIT ")",
+	       "count", "min", "avg", "max", "dc-miss", "dtlb-miss");
+
+	for (probe = prof_probes; probe; probe = probe->next) {
+		/* Print a consistent snapshot, without masking interrupts
+		 * while printing */
+		state = _prof_lock();
+		memcpy(&copy, probe, sizeof(copy));
+		_prof_unlock(state);
+
+		if (copy.count)
+			_prof_print_probe(&copy);
+	}
+}
+
+#ifndef CONFIG_PROF_HOST
+
+void prof_enable_console(uint8_t key)
+{
+	prof_console_key = key;
+	console_set_rx_handler(_prof_console_handler);
+	console_enable_rx_interrupt();
+}
+
+bool prof_poll(void)
+{
+	if (!prof_dump_requested)
+		return false;
+
+	prof_dump_requested = false;
+	prof_dump();
+	return true;
+}
+
+#endif /* !CONFIG_PROF_HOST */
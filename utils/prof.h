@@ -0,0 +1,182 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  \par Purpose
+ *
+ *  Cycle-accurate profiling of code sections with named probes.
+ *
+ *  \par Usage
+ *  -# Build with CONFIG_PROF=y and call prof_init() once at startup.
+ *  -# Surround the section to measure with PROF_BEGIN(id) and PROF_END(id),
+ *     in the same block. The id is a plain identifier, used as the name of
+ *     the probe in the dump; the probe is registered the first time the
+ *     section completes. Probes are re-entrant and may be used in interrupt
+ *     handlers.
+ *  -# For each probe, the number of runs, the min/avg/max duration, a log2
+ *     histogram of the durations and the average number of L1 data cache and
+ *     data TLB refills per run are collected. prof_dump() prints the table
+ *     and prof_reset() clears it.
+ *  -# prof_enable_console() installs a console handler that requests a dump
+ *     when a given key is received; the table is printed by prof_poll(),
+ *     which should be called from the idle loop.
+ *  -# Without CONFIG_PROF, PROF_BEGIN() and PROF_END() compile to nothing.
+ *
+ *  On target, durations are read from the Cortex-A5 PMU cycle counter, which
+ *  runs at the core clock, and events from the two PMU event counters. Built
+ *  with CONFIG_PROF_HOST, the same aggregation code runs on a host computer,
+ *  with durations in nanoseconds read from the monotonic clock and no event
+ *  counts.
+ */
+
+#ifndef _PROF_H_
+#define _PROF_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of buckets of the latency histograms */
+#define PROF_HIST_BUCKETS 32
+
+/** Events counted during each run of a probe */
+enum _prof_event {
+	PROF_EVENT_DCACHE_MISS,
+	PROF_EVENT_DTLB_MISS,
+	PROF_EVENTS,
+};
+
+/** Statistics of a probe */
+struct _prof_probe {
+	const char *name;
+	struct _prof_probe *next;
+	bool registered;
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t total;
+	uint64_t events[PROF_EVENTS];
+	/** hist[n] counts the durations d such that 2^(n-1) <= d < 2^n */
+	uint32_t hist[PROF_HIST_BUCKETS];
+};
+
+/** Counters sampled at the start of a run */
+struct _prof_sample {
+	uint32_t cycles;
+	uint32_t events[PROF_EVENTS];
+};
+
+#ifdef CONFIG_PROF
+
+#define PROF_BEGIN(id) \
+	static struct _prof_probe _prof_probe_##id = { .name = #id }; \
+	struct _prof_sample _prof_sample_##id; \
+	prof_begin(&_prof_sample_##id)
+
+#define PROF_END(id) \
+	prof_end(&_prof_probe_##id, &_prof_sample_##id)
+
+#else
+
+#define PROF_BEGIN(id) do { } while (0)
+#define PROF_END(id) do { } while (0)
+
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize the counters and measure the overhead of a probe, which
+ * is subtracted from every duration.
+ */
+extern void prof_init(void);
+
+/**
+ * \brief Sample the counters at the start of a run.
+ * \param sample  Storage for the counters, to be passed to prof_end()
+ */
+extern void prof_begin(struct _prof_sample *sample);
+
+/**
+ * \brief Sample the counters at the end of a run and account the run.
+ * \param probe  Probe to update
+ * \param sample  Counters sampled by prof_begin()
+ */
+extern void prof_end(struct _prof_probe *probe,
+		const struct _prof_sample *sample);
+
+/**
+ * \brief Account a run of a probe.
+ * \param probe  Probe to update, registered on its first run
+ * \param cycles  Duration of the run
+ * \param events  Number of events counted during the run, indexed by
+ * enum _prof_event, or NULL
+ */
+extern void prof_record(struct _prof_probe *probe, uint32_t cycles,
+		const uint32_t *events);
+
+/**
+ * \brief Clear the statistics of all probes.
+ */
+extern void prof_reset(void);
+
+/**
+ * \brief Print the statistics of all probes on the console.
+ */
+extern void prof_dump(void);
+
+#ifndef CONFIG_PROF_HOST
+
+/**
+ * \brief Request a dump whenever a key is received on the console.
+ * This replaces the console receive handler.
+ * \param key  Character that requests a dump
+ */
+extern void prof_enable_console(uint8_t key);
+
+/**
+ * \brief Print the statistics if a dump has been requested on the console.
+ * \return true if the statistics were printed
+ */
+extern bool prof_poll(void);
+
+#endif /* !CONFIG_PROF_HOST */
+
+#endif /* _PROF_H_ */
@@ -0,0 +1,390 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Hashed timer wheel.
+ *
+ * A pending timer is linked in the slot (expiry >> SWTIMER_SLOT_SHIFT)
+ * modulo SWTIMER_WHEEL_SLOTS, whatever the number of revolutions before it
+ * expires. All pending timers expire at or after wheel_time, the time up to
+ * which the wheel has been processed. When the alarm fires, the slots
+ * between wheel_time and now are scanned for expired timers. The next
+ * deadline is the earliest expiry of the first slot window, walking from
+ * wheel_time, that holds a timer of the current revolution.
+ *
+ * Times are 32-bit clock ticks compared by signed difference, so delays must
+ * stay below 2^31 ticks.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#ifndef CONFIG_SWTIMER_HOST
+#include "chip.h"
+#endif
+
+#include "swtimer.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SWTIMER_SLOT_MASK (SWTIMER_WHEEL_SLOTS - 1)
+
+#define SWTIMER_SLOT(time) (((time) >> SWTIMER_SLOT_SHIFT) & SWTIMER_SLOT_MASK)
+
+/** true if time a is before or equal to time b */
+#define SWTIMER_BEFORE_EQ(a, b) ((int32_t)((a) - (b)) <= 0)
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static const struct _swtimer_clock *swtimer_clock;
+
+static struct _swtimer *wheel[SWTIMER_WHEEL_SLOTS];
+
+/** Number of pending timers, in the wheel or about to run */
+static uint32_t wheel_count;
+
+/** Time up to which the wheel has been processed */
+static uint32_t wheel_time;
+
+/** Deadline the alarm is programmed to, valid if alarm_set */
+static uint32_t alarm_deadline;
+
+static bool alarm_set;
+
+/** Set while swtimer_process() runs, the alarm is programmed on exit */
+static bool processing;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+#ifndef CONFIG_SWTIMER_HOST
+
+static uint32_t _swtimer_lock(void)
+{
+	uint32_t cpsr = cpsr_get();
+	cpsr_set_bits(CPSR_MASK_IRQ);
+	return cpsr;
+}
+
+static void _swtimer_unlock(uint32_t cpsr)
+{
+	if (!(cpsr & CPSR_MASK_IRQ))
+		cpsr_clear_bits(CPSR_MASK_IRQ);
+}
+
+#else
+
+static uint32_t _swtimer_lock(void)
+{
+	return 0;
+}
+
+static void _swtimer_unlock(uint32_t state)
+{
+	(void)state;
+}
+
+#endif /* CONFIG_SWTIMER_HOST */
+
+static void _swtimer_link(struct _swtimer **head, struct _swtimer *timer)
+{
+	timer->next = *head;
+	if (timer->next)
+		timer->next->pprev = &timer->next;
+	timer->pprev = head;
+	*head = timer;
+}
+
+static void _swtimer_unlink(struct _swtimer *timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next)
+		timer->next->pprev = timer->pprev;
+	timer->next = NULL;
+	timer->pprev = NULL;
+}
+
+/**
+ * \brief Find the earliest deadline of the pending timers
+ * \return false if no timer is pending
+ */
+static bool _swtimer_next_deadline(uint32_t *deadline)
+{
+	struct _swtimer *timer;
+	uint32_t window, end, i;
+	bool found;
+
+	if (!wheel_count)
+		return false;
+
+	window = wheel_time >> SWTIMER_SLOT_SHIFT;
+	for (i = 0; i < SWTIMER_WHEEL_SLOTS; i++, window++) {
+		end = (window + 1) << SWTIMER_SLOT_SHIFT;
+		found = false;
+		for (timer = wheel[window & SWTIMER_SLOT_MASK]; timer;
+		     timer = timer->next) {
+			if (SWTIMER_BEFORE_EQ(end, timer->expiry))
+				continue;
+			if (!found || SWTIMER_BEFORE_EQ(timer->expiry, *deadline))
+				*deadline = timer->expiry;
+			found = true;
+		}
+		if (found)
+			return true;
+	}
+
+	/* All timers expire after a revolution of the wheel */
+	found = false;
+	for (i = 0; i < SWTIMER_WHEEL_SLOTS; i++) {
+		for (timer = wheel[i]; timer; timer = timer->next) {
+			if (!found || SWTIMER_BEFORE_EQ(timer->expiry, *deadline))
+				*deadline = timer->expiry;
+			found = true;
+		}
+	}
+	return found;
+}
+
+/**
+ * \brief Program the alarm to the earliest deadline
+ */
+static void _swtimer_update_alarm(void)
+{
+	uint32_t deadline = 0;
+
+	if (_swtimer_next_deadline(&deadline)) {
+		if (!alarm_set || alarm_deadline != deadline) {
+			alarm_deadline = deadline;
+			alarm_set = true;
+			swtimer_clock->set_alarm(deadline);
+		}
+	} else if (alarm_set) {
+		alarm_set = false;
+		swtimer_clock->cancel_alarm();
+	}
+}
+
+static void _swtimer_insert(struct _swtimer *timer)
+{
+	_swtimer_link(&wheel[SWTIMER_SLOT(timer->expiry)], timer);
+	wheel_count++;
+}
+
+static void _swtimer_remove(struct _swtimer *timer)
+{
+	_swtimer_unlink(timer);
+	wheel_count--;
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void swtimer_init(const struct _swtimer_clock *clock)
+{
+	uint32_t i;
+
+	assert(!wheel_count);
+
+	swtimer_clock = clock;
+	for (i = 0; i < SWTIMER_WHEEL_SLOTS; i++)
+		wheel[i] = NULL;
+	wheel_time = clock->get_time();
+	alarm_set = false;
+}
+
+void swtimer_setup(struct _swtimer *timer, swtimer_callback_t callback,
+		void *arg)
+{
+	timer->next = NULL;
+	timer->pprev = NULL;
+	timer->expiry = 0;
+	timer->period = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+}
+
+void swtimer_start(struct _swtimer *timer, uint32_t delay, uint32_t period)
+{
+	uint32_t state;
+	uint32_t now;
+
+	assert(swtimer_clock);
+
+	state = _swtimer_lock();
+
+	if (timer->pprev)
+		_swtimer_remove(timer);
+
+	now = swtimer_clock->get_time();
+	timer->expiry = now + swtimer_us_to_ticks(delay);
+	timer->period = swtimer_us_to_ticks(period);
+	_swtimer_insert(timer);
+
+	if (!processing) {
+		if (!alarm_set ||
+		    SWTIMER_BEFORE_EQ(timer->expiry, alarm_deadline)) {
+			/* New earliest deadline, no need to search the wheel */
+			alarm_deadline = timer->expiry;
+			alarm_set = true;
+			swtimer_clock->set_alarm(timer->expiry);
+		}
+	}
+
+	_swtimer_unlock(state);
+}
+
+void swtimer_stop(struct _swtimer *timer)
+{
+	uint32_t state;
+
+	state = _swtimer_lock();
+
+	/* The alarm is left as is: if it fires, swtimer_process() finds
+	 * nothing to do and programs the next deadline */
+	if (timer->pprev)
+		_swtimer_remove(timer);
+
+	_swtimer_unlock(state);
+}
+
+bool swtimer_is_pending(const struct _swtimer *timer)
+{
+	return timer->pprev != NULL;
+}
+
+uint32_t swtimer_get_time(void)
+{
+	return swtimer_clock->get_time();
+}
+
+uint32_t swtimer_us_to_ticks(uint32_t us)
+{
+	uint64_t ticks = ((uint64_t)us * swtimer_clock->freq + 999999) / 1000000;
+
+	assert(ticks < (1u << 31));
+	return (uint32_t)ticks;
+}
+
+void swtimer_process(void)
+{
+	struct _swtimer *expired = NULL;
+	struct _swtimer *timer, *next;
+	uint32_t state, now, slots, slot, i;
+
+	state = _swtimer_lock();
+
+	processing = true;
+	alarm_set = false;
+
+	now = swtimer_clock->get_time();
+
+	/* Collect the expired timers of the slots elapsed since the last run */
+	slots = (now >> SWTIMER_SLOT_SHIFT) - (wheel_time >> SWTIMER_SLOT_SHIFT);
+	slots = slots < SWTIMER_WHEEL_SLOTS ? slots + 1 : SWTIMER_WHEEL_SLOTS;
+	slot = SWTIMER_SLOT(wheel_time);
+	for (i = 0; i < slots; i++, slot = (slot + 1) & SWTIMER_SLOT_MASK) {
+		for (timer = wheel[slot]; timer; timer = next) {
+			next = timer->next;
+			if (SWTIMER_BEFORE_EQ(timer->expiry, now)) {
+				/* Still pending until its callback runs */
+				_swtimer_unlink(timer);
+				_swtimer_link(&expired, timer);
+			}
+		}
+	}
+	wheel_time = now;
+
+	/* Run the callbacks. A callback may start or stop any timer,
+	 * including those still in the expired list. */
+	while (expired) {
+		timer = expired;
+		_swtimer_remove(timer);
+
+		if (timer->period) {
+			timer->expiry += timer->period;
+			/* Skip the periods missed, if any */
+			if (SWTIMER_BEFORE_EQ(timer->expiry, now))
+				timer->expiry = now + timer->period;
+			_swtimer_insert(timer);
+		}
+
+		_swtimer_unlock(state);
+		timer->callback(timer, timer->arg);
+		state = _swtimer_lock();
+	}
+
+	processing = false;
+	_swtimer_update_alarm();
+
+	_swtimer_unlock(state);
+}
+
+#ifndef CONFIG_SWTIMER_HOST
+
+static void _swtimer_wait_callback(struct _swtimer *timer, void *arg)
+{
+	*(volatile bool *)arg = true;
+}
+
+void swtimer_wait(uint32_t delay)
+{
+	struct _swtimer timer;
+	volatile bool expired = false;
+	uint32_t state;
+
+	swtimer_setup(&timer, _swtimer_wait_callback, (void *)&expired);
+	swtimer_start(&timer, delay, 0);
+
+	/* Test the flag with interrupts masked, so that the alarm cannot fire
+	 * between the test and the wfi. The wfi still wakes up on the masked
+	 * interrupt, which is taken once unmasked. */
+	state = _swtimer_lock();
+	while (!expired) {
+		irq_wait();
+		_swtimer_unlock(state);
+		state = _swtimer_lock();
+	}
+	_swtimer_unlock(state);
+}
+
+#endif /* !CONFIG_SWTIMER_HOST */
@@ -0,0 +1,196 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ *  \file
+ *
+ *  \par Purpose
+ *
+ *  Software timers: one-shot and periodic callbacks with a resolution of a
+ *  few microseconds, driven by a single hardware alarm.
+ *
+ *  Pending timers are kept in a hashed timer wheel. The hardware alarm is
+ *  always programmed to the earliest deadline, so that no periodic tick is
+ *  needed and the core can sleep until the next deadline.
+ *
+ *  \par Usage
+ *
+ *  -# Build with CONFIG_SWTIMER = y in the application Makefile.
+ *  -# Configure the clock with swtimer_tc_configure(), which uses a TC
+ *     channel as free-running time base and its RA compare as alarm.
+ *  -# Initialize each timer once with swtimer_setup().
+ *  -# Arm a timer with swtimer_start() and disarm it with swtimer_stop().
+ *     Both may be called from the callbacks.
+ *  -# Callbacks are invoked from the interrupt handler of the clock and
+ *     should be short.
+ *  -# swtimer_wait() sleeps until a delay has elapsed.
+ *
+ *  Built with CONFIG_SWTIMER_HOST, the wheel does not depend on the chip and
+ *  can be driven on a host computer by a simulated clock given to
+ *  swtimer_init().
+ */
+
+#ifndef SWTIMER_H_
+#define SWTIMER_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#ifndef CONFIG_SWTIMER_HOST
+#include "chip.h"
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of slots of the timer wheel, must be a power of 2 */
+#ifndef SWTIMER_WHEEL_SLOTS
+#define SWTIMER_WHEEL_SLOTS 64
+#endif
+
+/** Each slot of the wheel spans 2^SWTIMER_SLOT_SHIFT clock ticks */
+#ifndef SWTIMER_SLOT_SHIFT
+#define SWTIMER_SLOT_SHIFT 10
+#endif
+
+struct _swtimer;
+
+typedef void (*swtimer_callback_t)(struct _swtimer *timer, void *arg);
+
+/** Software timer, owned by the caller */
+struct _swtimer {
+	struct _swtimer *next;
+	struct _swtimer **pprev;  /**< NULL when the timer is not pending */
+	uint32_t expiry;          /**< deadline, in clock ticks */
+	uint32_t period;          /**< in clock ticks, 0 for a one-shot timer */
+	swtimer_callback_t callback;
+	void *arg;
+};
+
+/** Hardware time base of the timers */
+struct _swtimer_clock {
+	/** Frequency of the clock, in Hz */
+	uint32_t freq;
+
+	/** Read the free-running 32-bit clock */
+	uint32_t (*get_time)(void);
+
+	/** Call swtimer_process() at or shortly after deadline, including
+	 * when deadline has already passed */
+	void (*set_alarm)(uint32_t deadline);
+
+	/** Cancel the alarm */
+	void (*cancel_alarm)(void);
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Select the clock of the timers. All timers must be stopped.
+ * \param clock  Time base, must stay valid while timers are used
+ */
+extern void swtimer_init(const struct _swtimer_clock *clock);
+
+/**
+ * \brief Initialize a timer
+ * \param timer  Timer to initialize
+ * \param callback  Function called when the timer expires
+ * \param arg  Argument passed to the callback
+ */
+extern void swtimer_setup(struct _swtimer *timer, swtimer_callback_t callback,
+		void *arg);
+
+/**
+ * \brief Arm a timer, or re-arm it if it is pending
+ * \param timer  Timer to arm
+ * \param delay  Delay before the first expiry, in microseconds
+ * \param period  Period of the next expiries in microseconds, or 0 for a
+ * one-shot timer
+ */
+extern void swtimer_start(struct _swtimer *timer, uint32_t delay,
+		uint32_t period);
+
+/**
+ * \brief Disarm a timer. Does nothing if the timer is not pending.
+ */
+extern void swtimer_stop(struct _swtimer *timer);
+
+/**
+ * \brief Tell if a timer is armed and has not expired yet
+ */
+extern bool swtimer_is_pending(const struct _swtimer *timer);
+
+/**
+ * \brief Read the clock of the timers
+ * \return Current time, in clock ticks
+ */
+extern uint32_t swtimer_get_time(void);
+
+/**
+ * \brief Convert microseconds to clock ticks
+ */
+extern uint32_t swtimer_us_to_ticks(uint32_t us);
+
+/**
+ * \brief Run the callbacks of the expired timers and program the alarm to
+ * the next deadline. Called by the clock when the alarm fires.
+ */
+extern void swtimer_process(void);
+
+#ifndef CONFIG_SWTIMER_HOST
+
+/**
+ * \brief Configure a TC channel as clock of the timers.
+ *
+ * The channel counts up freely at the lowest TC clock frequency above freq
+ * and its RA compare interrupt is used as alarm. The interrupt handler of
+ * the whole TC is replaced.
+ *
+ * \param tc  Timer Counter instance
+ * \param channel  Channel of the Timer Counter
+ * \param freq  Minimum clock frequency, in Hz
+ */
+extern void swtimer_tc_configure(Tc *tc, uint32_t channel, uint32_t freq);
+
+/**
+ * \brief Wait for a delay, putting the core to sleep until it has elapsed
+ * \param delay  Delay, in microseconds
+ */
+extern void swtimer_wait(uint32_t delay);
+
+#endif /* !CONFIG_SWTIMER_HOST */
+
+#endif /* SWTIMER_H_ */
@@ -0,0 +1,138 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Clock of the software timers, based on a TC channel.
+ *
+ * The channel runs in waveform mode, counting up freely over 32 bits. The
+ * alarm is the RA compare interrupt, reprogrammed to each new deadline.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "swtimer.h"
+
+#include "peripherals/aic.h"
+#include "peripherals/pmc.h"
+#include "peripherals/tc.h"
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static Tc *swtimer_tc;
+
+static uint32_t swtimer_tc_channel;
+
+static struct _swtimer_clock swtimer_tc_clock;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _swtimer_tc_handler(void)
+{
+	if (tc_get_status(swtimer_tc, swtimer_tc_channel) & TC_SR_CPAS)
+		swtimer_process();
+}
+
+static uint32_t _swtimer_tc_get_time(void)
+{
+	return tc_get_cv(swtimer_tc, swtimer_tc_channel);
+}
+
+static void _swtimer_tc_set_alarm(uint32_t deadline)
+{
+	uint32_t margin = 2;
+	uint32_t now, ra;
+
+	/* The compare only matches on equality: make sure RA is still ahead
+	 * of the counter once written, or the alarm would be delayed by a
+	 * whole wrap of the counter */
+	do {
+		now = tc_get_cv(swtimer_tc, swtimer_tc_channel);
+		if ((int32_t)(deadline - now) < (int32_t)margin)
+			ra = now + margin;
+		else
+			ra = deadline;
+		tc_set_ra_rb_rc(swtimer_tc, swtimer_tc_channel, &ra, NULL, NULL);
+		margin <<= 1;
+	} while ((int32_t)(ra - tc_get_cv(swtimer_tc, swtimer_tc_channel)) <= 0);
+
+	tc_enable_it(swtimer_tc, swtimer_tc_channel, TC_IER_CPAS);
+}
+
+static void _swtimer_tc_cancel_alarm(void)
+{
+	tc_disable_it(swtimer_tc, swtimer_tc_channel, TC_IDR_CPAS);
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void swtimer_tc_configure(Tc *tc, uint32_t channel, uint32_t freq)
+{
+	uint32_t id = get_tc_id_from_addr(tc);
+	uint32_t tcclks, clks;
+
+	swtimer_tc = tc;
+	swtimer_tc_channel = channel;
+
+	pmc_enable_peripheral(id);
+
+	/* Slowest MCK divider still at or above freq. TIMER_CLOCK1 is not
+	 * considered since it is a generated clock on some devices, and the
+	 * slow clock is too coarse. */
+	tcclks = TC_CMR_TCCLKS_TIMER_CLOCK2;
+	for (clks = TC_CMR_TCCLKS_TIMER_CLOCK3;
+	     clks <= TC_CMR_TCCLKS_TIMER_CLOCK4; clks++) {
+		if (tc_get_available_freq(tc, clks) >= freq)
+			tcclks = clks;
+	}
+	tc_configure(tc, channel, tcclks | TC_CMR_WAVE | TC_CMR_WAVSEL_UP);
+
+	swtimer_tc_clock.freq = tc_get_available_freq(tc, tcclks);
+	swtimer_tc_clock.get_time = _swtimer_tc_get_time;
+	swtimer_tc_clock.set_alarm = _swtimer_tc_set_alarm;
+	swtimer_tc_clock.cancel_alarm = _swtimer_tc_cancel_alarm;
+
+	aic_set_source_vector(id, _swtimer_tc_handler);
+	aic_enable(id);
+
+	tc_start(tc, channel);
+	swtimer_init(&swtimer_tc_clock);
+}
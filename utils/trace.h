@@ -45,6 +45,15 @@
  *  -# Trace disabling can be dynamic. The trace level can be modified in
  *  runtime but messages with a level higher that TRACE_LEVEL are compiled-out
  *  an will not be displayed regardless of the value of trace_level.
+ *  -# When CONFIG_TRACE_DEFERRED is defined, traces are not printed when
+ *  issued. The format pointer and the arguments are stored in a ring buffer,
+ *  and trace_drain() formats and outputs them later, typically from the idle
+ *  loop. Traces may be issued from interrupt handlers; when the ring is full
+ *  they are dropped and counted, see trace_get_dropped(). Arguments of %s
+ *  conversions are stored by reference and must stay valid until drained.
+ *  -# When CONFIG_TRACE_BINARY is also defined, trace_drain() outputs the raw
+ *  records, to be decoded on the host with scripts/trace_decode.py and the ELF
+ *  file of the application.
  *
  *  \par traceevels Trace level description
  *  -# trace_debug (5): Traces whose only purpose is for debugging the program,
@@ -86,6 +95,26 @@
 #define TRACE_LEVEL TRACE_LEVEL_INFO
 #endif
 
+#ifdef CONFIG_TRACE_DEFERRED
+
+/** Size of the deferred trace ring buffer, in 32-bit words */
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 1024
+#endif
+
+/** Maximum size of the arguments of a deferred trace, in 32-bit words */
+#define TRACE_MAX_ARGS 16
+
+#define _trace_output(level, ...) trace_log((level), __VA_ARGS__)
+#define _trace_flush() trace_drain()
+
+#else
+
+#define _trace_output(level, ...) printf(__VA_ARGS__)
+#define _trace_flush() do {} while (0)
+
+#endif /* CONFIG_TRACE_DEFERRED */
+
 /* ------------------------------------------------------------------------------
  *         Exported variables
  * ----------------------------------------------------------------------------*/
@@ -93,21 +122,61 @@
 /** Trace level is modifable at runtime */
 extern uint32_t trace_level;
 
+#ifdef CONFIG_TRACE_DEFERRED
+
+/* ------------------------------------------------------------------------------
+ *         Deferred traces
+ * ----------------------------------------------------------------------------*/
+
+/** Output function used by trace_drain() */
+typedef void (*trace_output_t)(const uint8_t *buffer, uint32_t size);
+
+/**
+ * \brief Store a trace in the ring buffer, to be output by trace_drain().
+ * \param level Trace level, used for the drop counters.
+ * \param format Format string, stored by reference.
+ */
+extern void trace_log(uint32_t level, const char *format, ...);
+
+/**
+ * \brief Format and output the traces stored in the ring buffer.
+ * \return Number of traces output.
+ */
+extern uint32_t trace_drain(void);
+
+/**
+ * \brief Set the function used by trace_drain() to output traces. The buffer
+ * is reused once the function returns. By default, traces are output on the
+ * console.
+ * \param output Output function.
+ */
+extern void trace_set_output(trace_output_t output);
+
+/**
+ * \brief Get the number of traces dropped because the ring buffer was full.
+ * \param level Trace level.
+ * \return Number of traces of the given level dropped since startup.
+ */
+extern uint32_t trace_get_dropped(uint32_t level);
+
+#endif /* CONFIG_TRACE_DEFERRED */
+
 /* ------------------------------------------------------------------------------
  *         Exported functions
  * ----------------------------------------------------------------------------*/
 
 /**
- *  Outputs a formatted string using 'printf' if the log level is high
- *  enough. Can be disabled by defining TRACE_LEVEL=0 during compilation.
+ *  Outputs a formatted string using 'printf', or stores it for trace_drain()
+ *  if CONFIG_TRACE_DEFERRED is defined, if the log level is high enough. Can
+ *  be disabled by defining TRACE_LEVEL=0 during compilation.
  *  \param ...  Additional parameters depending on formatted string.
  */
 
 #if (TRACE_LEVEL >= 1)
 #define trace_fatal(...) \
-	do { if (trace_level >= TRACE_LEVEL_FATAL) printf("-F- " __VA_ARGS__); while (1) ; } while (0)
+	do { if (trace_level >= TRACE_LEVEL_FATAL) _trace_output(TRACE_LEVEL_FATAL, "-F- " __VA_ARGS__); _trace_flush(); while (1) ; } while (0)
 #define trace_fatal_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_FATAL) printf(__VA_ARGS__); while (1) ; } while (0)
+	do { if (trace_level >= TRACE_LEVEL_FATAL) _trace_output(TRACE_LEVEL_FATAL, __VA_ARGS__); _trace_flush(); while (1) ; } while (0)
 #else
 #define trace_fatal(...) \
 	do {} while (1)
@@ -117,9 +186,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 2)
 #define trace_error(...) \
-	do { if (trace_level >= TRACE_LEVEL_ERROR) printf("-E- " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_ERROR) _trace_output(TRACE_LEVEL_ERROR, "-E- " __VA_ARGS__); } while (0)
 #define trace_error_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_ERROR) printf(__VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_ERROR) _trace_output(TRACE_LEVEL_ERROR, __VA_ARGS__); } while (0)
 #else
 #define trace_error(...) ((void)0)
 #define trace_error_wp(...) ((void)0)
@@ -127,9 +196,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 3)
 #define trace_warning(...) \
-	do { if (trace_level >= TRACE_LEVEL_WARNING) printf("-W- " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_WARNING) _trace_output(TRACE_LEVEL_WARNING, "-W- " __VA_ARGS__); } while (0)
 #define trace_warning_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_WARNING) printf(__VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_WARNING) _trace_output(TRACE_LEVEL_WARNING, __VA_ARGS__); } while (0)
 #else
 #define trace_warning(...) ((void)0)
 #define trace_warning_wp(...) ((void)0)
@@ -137,9 +206,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 4)
 #define trace_info(...) \
-	do { if (trace_level >= TRACE_LEVEL_INFO) printf("-I- " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_INFO) _trace_output(TRACE_LEVEL_INFO, "-I- " __VA_ARGS__); } while (0)
 #define trace_info_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_INFO) printf(__VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_INFO) _trace_output(TRACE_LEVEL_INFO, __VA_ARGS__); } while (0)
 #else
 #define trace_info(...) ((void)0)
 #define trace_info_wp(...) ((void)0)
@@ -147,9 +216,9 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 5)
 #define trace_debug(...) \
-	do { if (trace_level >= TRACE_LEVEL_DEBUG) printf("-D- " __FILE__ ":" STRINGIFY(__LINE__) " " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_DEBUG) _trace_output(TRACE_LEVEL_DEBUG, "-D- " __FILE__ ":" STRINGIFY(__LINE__) " " __VA_ARGS__); } while (0)
 #define trace_debug_wp(...) \
-	do { if (trace_level >= TRACE_LEVEL_DEBUG) printf(__VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_DEBUG) _trace_output(TRACE_LEVEL_DEBUG, __VA_ARGS__); } while (0)
 #else
 #define trace_debug(...) ((void)0)
 #define trace_debug_wp(...) ((void)0)
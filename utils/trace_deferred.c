@@ -0,0 +1,559 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Deferred trace backend.
+ *
+ * Traces are stored as records of 32-bit words in a ring buffer: a header
+ * (magic, level and size), the format pointer, the tick at which the trace
+ * was issued and the arguments, as read from the variable argument list
+ * according to the format. The space of a record is reserved with interrupts
+ * masked for a few instructions, then the record is filled and its header is
+ * written last to commit it. No lock is held while the record is filled nor
+ * while the ring is drained, so interrupt handlers are never delayed by a
+ * trace issued by the code they preempt.
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "trace.h"
+#include "ring.h"
+#include "timer.h"
+
+#include "misc/console.h"
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+/** Marker of a committed record header */
+#define TRACE_MAGIC 0xA5000000u
+
+#define TRACE_MAGIC_MASK 0xFF000000u
+
+#define TRACE_HEADER(level, size) \
+	(TRACE_MAGIC | (((level) & 0xFF) << 8) | ((size) & 0xFF))
+#define TRACE_HEADER_LEVEL(header) (((header) >> 8) & 0xFF)
+#define TRACE_HEADER_SIZE(header) ((header) & 0xFF)
+
+/** Header, format and tick */
+#define TRACE_RECORD_WORDS 3
+
+/** Maximum size of a record */
+#define TRACE_RECORD_MAX (TRACE_RECORD_WORDS + TRACE_MAX_ARGS)
+
+/** Size of the formatted trace buffer */
+#define TRACE_LINE_SIZE 256
+
+/** Number of trace levels, including TRACE_LEVEL_SILENT */
+#define TRACE_LEVELS (TRACE_LEVEL_DEBUG + 1)
+
+/** Argument classes of a conversion specification */
+enum _trace_arg {
+	TRACE_ARG_NONE,
+	TRACE_ARG_INT,
+	TRACE_ARG_LONG,
+	TRACE_ARG_LLONG,
+	TRACE_ARG_PTR,
+	TRACE_ARG_DOUBLE,
+};
+
+/** Conversion specification found in a format string */
+struct _trace_spec {
+	/** Start of the specification, on the '%' */
+	const char *start;
+
+	/** Length of the specification */
+	uint32_t length;
+
+	/** Number of '*' width or precision arguments */
+	uint32_t stars;
+
+	/** Class of the converted argument */
+	enum _trace_arg arg;
+};
+
+/*------------------------------------------------------------------------------
+ *         Local variables
+ *------------------------------------------------------------------------------*/
+
+/** Ring buffer of records */
+static volatile uint32_t trace_ring[TRACE_RING_SIZE];
+
+/** Index of the next record to reserve */
+static volatile uint32_t trace_head;
+
+/** Index of the next record to drain */
+static volatile uint32_t trace_tail;
+
+/** Number of traces dropped, per level */
+static volatile uint32_t trace_dropped[TRACE_LEVELS];
+
+/** Total of the drop counters at the last report */
+static uint32_t trace_dropped_reported;
+
+/** Output function */
+static trace_output_t trace_output;
+
+#ifndef CONFIG_TRACE_BINARY
+/** Formatted trace */
+static char trace_line[TRACE_LINE_SIZE];
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * \brief Default output function, writes on the console.
+ */
+static void _trace_console_output(const uint8_t *buffer, uint32_t size)
+{
+	while (size--)
+		console_put_char(*buffer++);
+}
+
+/**
+ * \brief Find the next conversion specification of a format string.
+ * \param format Format string.
+ * \param spec Specification found.
+ * \return Pointer after the specification, or NULL if there is none.
+ */
+static const char *_trace_next_spec(const char *format,
+		struct _trace_spec *spec)
+{
+	const char *p = strchr(format, '%');
+	uint32_t longs = 0;
+
+	if (!p)
+		return NULL;
+
+	spec->start = p++;
+	spec->stars = 0;
+
+	/* Flags, width and precision */
+	while (*p && strchr("-+ #0123456789.*", *p)) {
+		if (*p == '*')
+			spec->stars++;
+		p++;
+	}
+
+	/* Length modifier */
+	while (*p && strchr("hlzjtL", *p)) {
+		if (*p == 'l')
+			longs++;
+		p++;
+	}
+
+	switch (*p) {
+	case 'd':
+	case 'i':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'o':
+	case 'c':
+		if (longs >= 2)
+			spec->arg = TRACE_ARG_LLONG;
+		else if (longs == 1)
+			spec->arg = TRACE_ARG_LONG;
+		else
+			spec->arg = TRACE_ARG_INT;
+		break;
+	case 's':
+	case 'p':
+		spec->arg = TRACE_ARG_PTR;
+		break;
+	case 'f':
+	case 'F':
+	case 'e':
+	case 'E':
+	case 'g':
+	case 'G':
+		spec->arg = TRACE_ARG_DOUBLE;
+		break;
+	case '\0':
+		spec->arg = TRACE_ARG_NONE;
+		spec->length = p - spec->start;
+		return p;
+	default:
+		spec->arg = TRACE_ARG_NONE;
+		break;
+	}
+
+	p++;
+	spec->length = p - spec->start;
+	return p;
+}
+
+/**
+ * \brief Number of argument words used by a conversion specification.
+ */
+static uint32_t _trace_spec_words(const struct _trace_spec *spec)
+{
+	uint32_t words = spec->stars;
+
+	switch (spec->arg) {
+	case TRACE_ARG_INT:
+	case TRACE_ARG_LONG:
+	case TRACE_ARG_PTR:
+		words += 1;
+		break;
+	case TRACE_ARG_LLONG:
+	case TRACE_ARG_DOUBLE:
+		words += 2;
+		break;
+	default:
+		break;
+	}
+	return words;
+}
+
+/**
+ * \brief Reserve space for a record.
+ * \param size Size of the record in words.
+ * \param index Index of the record in the ring.
+ * \return true if the space was reserved, false if the ring is full.
+ */
+static bool _trace_reserve(uint32_t size, uint32_t *index)
+{
+	uint32_t cpsr = cpsr_get();
+	bool reserved = false;
+
+	cpsr_set_bits(CPSR_MASK_IRQ);
+	if (RING_SPACE(trace_head, trace_tail, TRACE_RING_SIZE) >= (int)size) {
+		*index = trace_head;
+		/* Header is not committed until the record is filled */
+		trace_ring[*index] = 0;
+		trace_head = (trace_head + size) % TRACE_RING_SIZE;
+		reserved = true;
+	}
+	if (!(cpsr & CPSR_MASK_IRQ))
+		cpsr_clear_bits(CPSR_MASK_IRQ);
+
+	return reserved;
+}
+
+/**
+ * \brief Copy a committed record out of the ring, and release its space.
+ * \param record Buffer receiving the record.
+ * \return Size of the record in words, 0 if there is no committed record.
+ */
+static uint32_t _trace_pop(uint32_t *record)
+{
+	uint32_t index = trace_tail;
+	uint32_t header, size, i;
+
+	if (RING_EMPTY(trace_head, index))
+		return 0;
+
+	header = trace_ring[index];
+	if ((header & TRACE_MAGIC_MASK) != TRACE_MAGIC)
+		return 0;
+
+	size = TRACE_HEADER_SIZE(header);
+	for (i = 0; i < size; i++) {
+		record[i] = trace_ring[index];
+		RING_INC(index, TRACE_RING_SIZE);
+	}
+	trace_tail = index;
+
+	return size;
+}
+
+#ifdef CONFIG_TRACE_BINARY
+
+/**
+ * \brief Output a record as is, for trace_decode.py.
+ */
+static void _trace_emit(const uint32_t *record, uint32_t size)
+{
+	trace_output((const uint8_t*)record, size * sizeof(uint32_t));
+}
+
+#else /* !CONFIG_TRACE_BINARY */
+
+/**
+ * \brief Format a record, as printf would have done.
+ * \return Length of the formatted trace.
+ */
+static uint32_t _trace_format(char *line, uint32_t line_size,
+		const char *format, const uint32_t *args)
+{
+	struct _trace_spec spec;
+	const char *next;
+	char conv[32];
+	uint32_t length = 0;
+	uint32_t i, n;
+	int star, value;
+	int written;
+
+	for (;;) {
+		next = _trace_next_spec(format, &spec);
+
+		/* Literal text */
+		n = next ? (uint32_t)(spec.start - format) : strlen(format);
+		if (n > line_size - 1 - length)
+			n = line_size - 1 - length;
+		memcpy(line + length, format, n);
+		length += n;
+		if (!next)
+			break;
+		format = next;
+
+		/* Skip specifications too long once '*' are substituted */
+		if (spec.length + spec.stars * 11 >= sizeof(conv)) {
+			args += _trace_spec_words(&spec);
+			continue;
+		}
+
+		/* Substitute '*' with the recorded values */
+		for (i = 0, n = 0; i < spec.length; i++) {
+			if (spec.start[i] == '*') {
+				star = (int)*args++;
+				n += sprintf(conv + n, "%d", star);
+			} else {
+				conv[n++] = spec.start[i];
+			}
+		}
+		conv[n] = '\0';
+
+		written = 0;
+		switch (spec.arg) {
+		case TRACE_ARG_NONE:
+			if (spec.start[spec.length - 1] == '%')
+				written = snprintf(line + length, line_size - length, "%%");
+			break;
+		case TRACE_ARG_INT:
+			value = (int)*args++;
+			written = snprintf(line + length, line_size - length, conv, value);
+			break;
+		case TRACE_ARG_LONG:
+			written = snprintf(line + length, line_size - length, conv,
+					(long)(int32_t)*args++);
+			break;
+		case TRACE_ARG_PTR:
+			written = snprintf(line + length, line_size - length, conv,
+					(void*)*args++);
+			break;
+		case TRACE_ARG_LLONG:
+		{
+			uint64_t v;
+			memcpy(&v, args, sizeof(v));
+			args += 2;
+			written = snprintf(line + length, line_size - length, conv,
+					(long long)v);
+			break;
+		}
+		case TRACE_ARG_DOUBLE:
+		{
+			double v;
+			memcpy(&v, args, sizeof(v));
+			args += 2;
+			written = snprintf(line + length, line_size - length, conv, v);
+			break;
+		}
+		}
+
+		if (written > 0)
+			length = min_u32(length + written, line_size - 1);
+	}
+
+	line[length] = '\0';
+	return length;
+}
+
+/**
+ * \brief Format and output a record.
+ */
+static void _trace_emit(const uint32_t *record, uint32_t size)
+{
+	uint32_t length;
+
+	(void)size;
+	length = _trace_format(trace_line, sizeof(trace_line),
+			(const char*)record[1], &record[TRACE_RECORD_WORDS]);
+	trace_output((const uint8_t*)trace_line, length);
+}
+
+#endif /* !CONFIG_TRACE_BINARY */
+
+/**
+ * \brief Output the drop counters if traces were dropped since the last
+ * report. In binary mode, the counters are sent as a record with a NULL
+ * format.
+ */
+static void _trace_report_drops(void)
+{
+	uint32_t record[TRACE_RECORD_WORDS + TRACE_LEVELS];
+	uint32_t total = 0;
+	uint32_t i;
+
+	for (i = 0; i < TRACE_LEVELS; i++) {
+		record[TRACE_RECORD_WORDS + i] = trace_dropped[i];
+		total += record[TRACE_RECORD_WORDS + i];
+	}
+	if (total == trace_dropped_reported)
+		return;
+	trace_dropped_reported = total;
+
+	record[0] = TRACE_HEADER(TRACE_LEVEL_WARNING, ARRAY_SIZE(record));
+	record[1] = 0;
+	record[2] = timer_get_tick();
+#ifdef CONFIG_TRACE_BINARY
+	_trace_emit(record, ARRAY_SIZE(record));
+#else
+	{
+		int length = snprintf(trace_line, sizeof(trace_line),
+			"-W- %u traces dropped (F%u E%u W%u I%u D%u)\r\n",
+			(unsigned)total,
+			(unsigned)record[TRACE_RECORD_WORDS + TRACE_LEVEL_FATAL],
+			(unsigned)record[TRACE_RECORD_WORDS + TRACE_LEVEL_ERROR],
+			(unsigned)record[TRACE_RECORD_WORDS + TRACE_LEVEL_WARNING],
+			(unsigned)record[TRACE_RECORD_WORDS + TRACE_LEVEL_INFO],
+			(unsigned)record[TRACE_RECORD_WORDS + TRACE_LEVEL_DEBUG]);
+		if (length > 0)
+			trace_output((const uint8_t*)trace_line,
+					min_u32(length, sizeof(trace_line) - 1));
+	}
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+void trace_log(uint32_t level, const char *format, ...)
+{
+	uint32_t args[TRACE_MAX_ARGS];
+	struct _trace_spec spec;
+	const char *p = format;
+	uint32_t count = 0;
+	uint32_t first, index, size, i;
+	va_list ap;
+
+	/* Collect the arguments as words, following the format */
+	va_start(ap, format);
+	while ((p = _trace_next_spec(p, &spec)) != NULL) {
+		if (count + _trace_spec_words(&spec) > TRACE_MAX_ARGS)
+			break;
+		for (i = 0; i < spec.stars; i++)
+			args[count++] = (uint32_t)va_arg(ap, int);
+		switch (spec.arg) {
+		case TRACE_ARG_INT:
+			args[count++] = (uint32_t)va_arg(ap, int);
+			break;
+		case TRACE_ARG_LONG:
+			args[count++] = (uint32_t)va_arg(ap, long);
+			break;
+		case TRACE_ARG_PTR:
+			args[count++] = (uint32_t)va_arg(ap, void*);
+			break;
+		case TRACE_ARG_LLONG:
+		{
+			uint64_t v = (uint64_t)va_arg(ap, long long);
+			memcpy(&args[count], &v, sizeof(v));
+			count += 2;
+			break;
+		}
+		case TRACE_ARG_DOUBLE:
+		{
+			double v = va_arg(ap, double);
+			memcpy(&args[count], &v, sizeof(v));
+			count += 2;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	va_end(ap);
+
+	size = TRACE_RECORD_WORDS + count;
+	if (level >= TRACE_LEVELS)
+		level = TRACE_LEVEL_DEBUG;
+	if (!_trace_reserve(size, &first)) {
+		trace_dropped[level]++;
+		return;
+	}
+
+	/* Fill the record, then commit it by writing its header */
+	index = first;
+	RING_INC(index, TRACE_RING_SIZE);
+	trace_ring[index] = (uint32_t)format;
+	RING_INC(index, TRACE_RING_SIZE);
+	trace_ring[index] = timer_get_tick();
+	for (i = 0; i < count; i++) {
+		RING_INC(index, TRACE_RING_SIZE);
+		trace_ring[index] = args[i];
+	}
+	dmb();
+	trace_ring[first] = TRACE_HEADER(level, size);
+}
+
+uint32_t trace_drain(void)
+{
+	uint32_t record[TRACE_RECORD_MAX];
+	uint32_t count = 0;
+	uint32_t size;
+
+	if (!trace_output)
+		trace_output = _trace_console_output;
+
+	while ((size = _trace_pop(record)) != 0) {
+		_trace_emit(record, size);
+		count++;
+	}
+	_trace_report_drops();
+
+	return count;
+}
+
+void trace_set_output(trace_output_t output)
+{
+	trace_output = output;
+}
+
+uint32_t trace_get_dropped(uint32_t level)
+{
+	if (level >= TRACE_LEVELS)
+		return 0;
+	return trace_dropped[level];
+}